@@ -0,0 +1,52 @@
+<?php
+    class SerializeBench
+    {
+        /**
+        * @var \NDArray
+        */
+        private $array;
+
+        /**
+        * @var string
+        */
+        private $serialized;
+
+        public function setUp(array $params): void
+        {
+            $this->array = \NumPower::ones($params['shape']);
+            $this->serialized = serialize($this->array);
+        }
+
+        /**
+        * @BeforeMethods("setUp")
+        * @Revs(10)
+        * @Iterations(5)
+        * @ParamProviders({
+        *     "provideShapes"
+        * })
+        */
+        public function benchSerialize($params): void
+        {
+            serialize($this->array);
+        }
+
+        /**
+        * @BeforeMethods("setUp")
+        * @Revs(10)
+        * @Iterations(5)
+        * @ParamProviders({
+        *     "provideShapes"
+        * })
+        */
+        public function benchUnserialize($params): void
+        {
+            unserialize($this->serialized);
+        }
+
+        public function provideShapes() {
+            yield ['shape' => [1000]];
+            yield ['shape' => [1000, 1000]];
+            yield ['shape' => [10000, 1000]];
+        }
+    }
+?>
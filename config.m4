@@ -105,6 +105,23 @@ PHP_CHECK_LIBRARY(mkl_rt,LAPACKE_sgesdd,
 ])
 
 
+PHP_CHECK_LIBRARY(rt, shm_open,
+    [
+      PHP_ADD_LIBRARY(rt,,NDARRAY_SHARED_LIBADD)
+      CFLAGS+=" -lrt "
+    ],[
+])
+
+PHP_CHECK_LIBRARY(gomp, omp_get_num_threads,
+    [
+      AC_DEFINE(HAVE_OPENMP,1,[ ])
+      PHP_ADD_LIBRARY(gomp,,NDARRAY_SHARED_LIBADD)
+      AC_MSG_RESULT([OpenMP detected ])
+      CFLAGS+=" -fopenmp "
+    ],[
+    AC_MSG_RESULT([OpenMP not found. Parallel loops will run on a single thread.])
+])
+
 PHP_CHECK_LIBRARY(cudnn, cudnnCreate,
     [
       AC_DEFINE(HAVE_CUDNN,1,[ ])
@@ -127,14 +144,22 @@ if test "$PHP_NDARRAY" != "no"; then
       src/logic.c \
       src/gpu_alloc.c \
       src/ndmath/linalg.c \
+      src/ndmath/quantization.c \
       src/manipulation.c \
       src/dnn.c \
       src/iterators.c \
+      src/lazy.c \
       src/indexing.c \
+      src/sparse.c \
       src/ndmath/arithmetics.c \
       src/ndmath/calculation.c \
       src/ndmath/statistics.c \
+      src/ndmath/sorting.c \
+      src/ndmath/solvers.c \
       src/ndmath/signal.c \
+      src/io.c \
+      src/shm.c \
+      src/persistent.c \
       src/types.c,
       $ext_shared)
 fi
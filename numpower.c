@@ -23,9 +23,17 @@
 #include "src/types.h"
 #include "src/indexing.h"
 #include "src/ndmath/statistics.h"
+#include "src/ndmath/sorting.h"
+#include "src/ndmath/solvers.h"
+#include "src/sparse.h"
 #include "src/ndmath/signal.h"
 #include "src/ndmath/calculation.h"
 #include "src/dnn.h"
+#include "src/io.h"
+#include "src/shm.h"
+#include "src/persistent.h"
+#include "src/ndmath/quantization.h"
+#include "src/lazy.h"
 
 #ifdef HAVE_CUBLAS
 #include <cuda_runtime.h>
@@ -48,6 +56,79 @@
 static zend_object_handlers ndarray_object_handlers;
 static zend_object_handlers numpower_object_handlers;
 static zend_object_handlers arithmetic_object_handlers;
+static zend_object_handlers ndarray_expression_object_handlers;
+static zend_object_handlers lu_factorization_object_handlers;
+static zend_object_handlers sparse_ndarray_object_handlers;
+
+typedef struct {
+    NDArrayExpr *expr;
+    zend_object std;
+} NDArrayExpressionObject;
+
+static inline NDArrayExpressionObject *ndarray_expression_from_obj(zend_object *obj) {
+    return (NDArrayExpressionObject *)((char *)(obj) - XtOffsetOf(NDArrayExpressionObject, std));
+}
+
+#define Z_NDARRAY_EXPRESSION_P(zv) ndarray_expression_from_obj(Z_OBJ_P(zv))
+
+typedef struct {
+    NDArrayLUFactor *factor;
+    zend_object std;
+} LUFactorizationObject;
+
+static inline LUFactorizationObject *lu_factorization_from_obj(zend_object *obj) {
+    return (LUFactorizationObject *)((char *)(obj) - XtOffsetOf(LUFactorizationObject, std));
+}
+
+#define Z_LU_FACTORIZATION_P(zv) lu_factorization_from_obj(Z_OBJ_P(zv))
+
+typedef struct {
+    NDArraySparse *sparse;
+    zend_object std;
+} SparseNDArrayObject;
+
+static inline SparseNDArrayObject *sparse_ndarray_from_obj(zend_object *obj) {
+    return (SparseNDArrayObject *)((char *)(obj) - XtOffsetOf(SparseNDArrayObject, std));
+}
+
+#define Z_SPARSE_NDARRAY_P(zv) sparse_ndarray_from_obj(Z_OBJ_P(zv))
+#define IS_SPARSE_NDARRAY_P(zv) (Z_TYPE_P(zv) == IS_OBJECT && Z_OBJCE_P(zv) == phpsci_ce_SparseNDArray)
+
+/**
+ * @param obj
+ * @return factorization held by an LUFactorization object, NULL if uninitialized
+ */
+static NDArrayLUFactor* lu_factorization_get(zval *obj) {
+    NDArrayLUFactor *factor = Z_LU_FACTORIZATION_P(obj)->factor;
+    if (factor == NULL) {
+        zend_throw_error(NULL, "LUFactorization must be created with NumPower::luFactor.");
+    }
+    return factor;
+}
+
+/**
+ * @param obj
+ * @return matrix held by a SparseNDArray object, NULL if uninitialized
+ */
+static NDArraySparse* sparse_ndarray_get(zval *obj) {
+    NDArraySparse *sparse = Z_SPARSE_NDARRAY_P(obj)->sparse;
+    if (sparse == NULL) {
+        zend_throw_error(NULL, "SparseNDArray must be created with SparseNDArray::fromTriplets or SparseNDArray::fromDense.");
+    }
+    return sparse;
+}
+
+/**
+ * @param obj
+ * @return expression held by an NDArrayExpression object, NULL if uninitialized
+ */
+static NDArrayExpr* ndarray_expression_get(zval *obj) {
+    NDArrayExpr *expr = Z_NDARRAY_EXPRESSION_P(obj)->expr;
+    if (expr == NULL) {
+        zend_throw_error(NULL, "NDArrayExpression must be created with NumPower::lazy.");
+    }
+    return expr;
+}
 
 int *
 zval_axis_argument(zval *arg, char *name, int *outsize)
@@ -82,6 +163,16 @@ zval_axis_argument(zval *arg, char *name, int *outsize)
     return result;
 }
 
+const char *
+ndarray_dtype_argument(const char *name)
+{
+    const char *type = NDArray_ParseType(name);
+    if (type == NULL) {
+        zend_throw_error(NULL, "Unsupported dtype `%s`.", name);
+    }
+    return type;
+}
+
 int
 get_object_uuid(zval* obj) {
     return Z_LVAL_P(OBJ_PROP_NUM(Z_OBJ_P(obj), 0));
@@ -106,6 +197,10 @@ NDArray* ZVAL_TO_NDARRAY(zval* obj) {
                 return buffer_get(get_object_uuid(obj));
             }
         }
+        if (ce == phpsci_ce_NDArrayExpression) {
+            NDArrayExpr *expr = ndarray_expression_get(obj);
+            return expr == NULL ? NULL : NDArrayExpr_Evaluate(expr);
+        }
 #ifdef HAVE_GD
         /* Check if the zend_object class name is "GdImage" */
         if (strcmp(ZSTR_VAL(class_name), "GdImage") == 0) {
@@ -124,6 +219,9 @@ void CHECK_INPUT_AND_FREE(zval *a, NDArray *nda) {
     if (Z_TYPE_P(a) == IS_ARRAY || Z_TYPE_P(a) == IS_DOUBLE || Z_TYPE_P(a) == IS_LONG) {
         NDArray_FREE(nda);
     }
+    if (Z_TYPE_P(a) == IS_OBJECT && Z_OBJCE_P(a) == phpsci_ce_NDArrayExpression) {
+        NDArray_FREE(nda);
+    }
 #ifdef HAVE_GD
     if (Z_TYPE_P(a) == IS_OBJECT) {
         /* Check if the zend_object class name is "GdImage" */
@@ -135,6 +233,55 @@ void CHECK_INPUT_AND_FREE(zval *a, NDArray *nda) {
 #endif
 }
 
+/**
+ * Return `out` when a result was written into it, or the new `array`
+ * when no output array was given
+ *
+ * @param array
+ * @param out
+ * @param return_value
+ */
+void RETURN_NDARRAY_OUT(NDArray* array, zval* out, zval* return_value) {
+    if (out == NULL) {
+        RETURN_NDARRAY(array, return_value);
+        return;
+    }
+    if (array == NULL) {
+        RETURN_THROWS();
+    }
+    RETURN_COPY(out);
+}
+
+/**
+ * Rebuild a PHP scalar or array operand with the dtype of the other
+ * operand, so PHP doubles keep their precision against float64 arrays.
+ *
+ * @param obj
+ * @param nda
+ * @param other
+ * @return
+ */
+NDArray* ndarray_operand_dtype(zval *obj, NDArray *nda, NDArray *other) {
+    NDArray *rtn;
+    if (Z_TYPE_P(obj) != IS_ARRAY && Z_TYPE_P(obj) != IS_DOUBLE && Z_TYPE_P(obj) != IS_LONG) {
+        return nda;
+    }
+    if (is_type(NDArray_TYPE(other), NDARRAY_TYPE_FLOAT32) || is_type(NDArray_TYPE(other), NDArray_TYPE(nda))) {
+        return nda;
+    }
+    if (Z_TYPE_P(obj) == IS_ARRAY) {
+        rtn = Create_NDArray_FromZvalType(obj, NDArray_TYPE(other));
+    } else {
+        rtn = NDArray_Empty(emalloc(sizeof(int)), 0, NDArray_TYPE(other), NDARRAY_DEVICE_CPU);
+        NDArray_TypeFuncs(NDArray_TYPE(other))->setitem(NDArray_DATA(rtn), zval_get_double(obj));
+    }
+    if (rtn == NULL) {
+        return nda;
+    }
+    NDArray_FREE(nda);
+    return rtn;
+}
+
 void RETURN_NDARRAY(NDArray* array, zval* return_value) {
     if (array == NULL) {
         RETURN_THROWS();
@@ -145,7 +292,11 @@ void RETURN_NDARRAY(NDArray* array, zval* return_value) {
         object_init_ex(return_value, phpsci_ce_NDArray);
         ZVAL_LONG(OBJ_PROP_NUM(Z_OBJ_P(return_value), 0), NDArray_UUID(array));
     } else {
-        ZVAL_DOUBLE(return_value, NDArray_GetFloatScalar(array));
+        if (NDArray_DEVICE(array) == NDARRAY_DEVICE_CPU) {
+            NDArray_ItemToZval(array, NDArray_DATA(array), return_value);
+        } else {
+            ZVAL_DOUBLE(return_value, NDArray_GetDoubleScalar(array));
+        }
         NDArray_FREE(array);
     }
 }
@@ -202,6 +353,8 @@ static int ndarray_do_operation_ex(zend_uchar opcode, zval *result, zval *op1, z
     if (nda == NULL | ndb == NULL) {
         return FAILURE;
     }
+    nda = ndarray_operand_dtype(op1, nda, ndb);
+    ndb = ndarray_operand_dtype(op2, ndb, nda);
     NDArray *rtn = NULL;
     switch(opcode) {
     case ZEND_ADD:
@@ -280,10 +433,182 @@ static int arithmetic_do_operation_ex(zend_uchar opcode, zval *result, zval *op1
     return SUCCESS;
 }
 
+/**
+ * Wrap an operand of a lazy expression as a new expression reference.
+ * PHP numbers become float64 scalars, so they keep their precision
+ * whatever the dtype of the arrays they are combined with.
+ *
+ * @param obj
+ * @return
+ */
+static NDArrayExpr* ndarray_expression_operand(zval *obj) {
+    NDArrayExpr *expr;
+    NDArray *nda;
+    if (Z_TYPE_P(obj) == IS_OBJECT && Z_OBJCE_P(obj) == phpsci_ce_NDArrayExpression) {
+        expr = ndarray_expression_get(obj);
+        if (expr != NULL) {
+            expr->refcount++;
+        }
+        return expr;
+    }
+    if (Z_TYPE_P(obj) == IS_LONG || Z_TYPE_P(obj) == IS_DOUBLE) {
+        nda = NDArray_Empty(emalloc(sizeof(int)), 0, NDARRAY_TYPE_DOUBLE64, NDARRAY_DEVICE_CPU);
+        NDArray_DDATA(nda)[0] = zval_get_double(obj);
+        expr = NDArrayExpr_Leaf(nda);
+        NDArray_FREE(nda);
+        return expr;
+    }
+    nda = ZVAL_TO_NDARRAY(obj);
+    if (nda == NULL) {
+        return NULL;
+    }
+    expr = NDArrayExpr_Leaf(nda);
+    CHECK_INPUT_AND_FREE(obj, nda);
+    return expr;
+}
+
+void RETURN_NDARRAY_EXPRESSION(NDArrayExpr *expr, zval *return_value) {
+    object_init_ex(return_value, phpsci_ce_NDArrayExpression);
+    Z_NDARRAY_EXPRESSION_P(return_value)->expr = expr;
+}
+
+static int ndarray_expression_do_operation_ex(zend_uchar opcode, zval *result, zval *op1, zval *op2) { /* {{{ */
+    NDArrayExpr *left, *right, *expr;
+    int op;
+    switch(opcode) {
+        case ZEND_ADD:
+            op = NDARRAY_EXPR_ADD;
+            break;
+        case ZEND_SUB:
+            op = NDARRAY_EXPR_SUBTRACT;
+            break;
+        case ZEND_MUL:
+            op = NDARRAY_EXPR_MULTIPLY;
+            break;
+        case ZEND_DIV:
+            op = NDARRAY_EXPR_DIVIDE;
+            break;
+        case ZEND_POW:
+            op = NDARRAY_EXPR_POW;
+            break;
+        case ZEND_MOD:
+            // Operators without a fused kernel evaluate the expression eagerly
+            return ndarray_do_operation_ex(opcode, result, op1, op2);
+        default:
+            return FAILURE;
+    }
+    left = ndarray_expression_operand(op1);
+    if (left == NULL) {
+        return FAILURE;
+    }
+    right = ndarray_expression_operand(op2);
+    if (right == NULL) {
+        NDArrayExpr_FREE(left);
+        return FAILURE;
+    }
+    expr = NDArrayExpr_Binary(op, left, right);
+    NDArrayExpr_FREE(left);
+    NDArrayExpr_FREE(right);
+    RETURN_NDARRAY_EXPRESSION(expr, result);
+    return SUCCESS;
+}
+
+static
+int ndarray_expression_do_operation(zend_uchar opcode, zval *result, zval *op1, zval *op2) { /* {{{ */
+    zval op1_copy;
+    int retval;
+    // Compound assignment writes into op1, keep it alive until the new node holds it
+    if (result == op1) {
+        ZVAL_COPY_VALUE(&op1_copy, op1);
+        op1 = &op1_copy;
+    }
+    retval = ndarray_expression_do_operation_ex(opcode, result, op1, op2);
+    if (op1 == &op1_copy) {
+        if (retval == SUCCESS) {
+            zval_ptr_dtor(op1);
+        } else {
+            ZVAL_COPY_VALUE(result, op1);
+        }
+    }
+    return retval;
+}
+
+/**
+ * Compute `$a op= $b` straight into $a. Only taken when the object is
+ * held by the assigned variable alone and its buffer isn't shared with
+ * views, lazy expressions, other processes or the persistent store,
+ * so nothing else can observe the write. Copy-on-write buffers are
+ * detached before the write.
+ *
+ * @return SUCCESS when the result was written into op1
+ */
+static int ndarray_assign_op_in_place(zend_uchar opcode, zval *op1, zval *op2) {
+    NDArray *nda, *ndb;
+    int op, retval = FAILURE;
+    switch(opcode) {
+        case ZEND_ADD:
+            op = NDARRAY_BINOP_ADD;
+            break;
+        case ZEND_SUB:
+            op = NDARRAY_BINOP_SUBTRACT;
+            break;
+        case ZEND_MUL:
+            op = NDARRAY_BINOP_MULTIPLY;
+            break;
+        case ZEND_DIV:
+            op = NDARRAY_BINOP_DIVIDE;
+            break;
+        default:
+            return FAILURE;
+    }
+    if (Z_TYPE_P(op1) != IS_OBJECT || Z_OBJCE_P(op1) != phpsci_ce_NDArray || Z_REFCOUNT_P(op1) != 1) {
+        return FAILURE;
+    }
+    if (Z_TYPE_P(op2) != IS_ARRAY && Z_TYPE_P(op2) != IS_LONG && Z_TYPE_P(op2) != IS_DOUBLE &&
+        !(Z_TYPE_P(op2) == IS_OBJECT && Z_OBJCE_P(op2) == phpsci_ce_NDArray)) {
+        return FAILURE;
+    }
+    nda = ZVAL_TO_NDARRAY(op1);
+    if (nda->refcount != 1 || (nda->base != NULL && !NDArray_CHKFLAGS(nda, NDARRAY_ARRAY_COPY_ON_WRITE)) ||
+        NDArray_CHKFLAGS(nda, NDARRAY_ARRAY_SHARED) || NDArray_CHKFLAGS(nda, NDARRAY_ARRAY_PERSISTENT)) {
+        return FAILURE;
+    }
+    ndb = ZVAL_TO_NDARRAY(op2);
+    if (ndb == NULL) {
+        return FAILURE;
+    }
+    ndb = ndarray_operand_dtype(op2, ndb, nda);
+    if (NDArray_BinaryOpFitsInto(nda, ndb, nda, op) && NDArray_BinaryOpInto(nda, ndb, nda, op) != NULL) {
+        retval = SUCCESS;
+    }
+    CHECK_INPUT_AND_FREE(op2, ndb);
+    return retval;
+}
+
 static
 int ndarray_do_operation(zend_uchar opcode, zval *result, zval *op1, zval *op2) { /* {{{ */
+    zval op1_copy;
     int retval;
+    if ((Z_TYPE_P(op1) == IS_OBJECT && Z_OBJCE_P(op1) == phpsci_ce_NDArrayExpression) ||
+        (Z_TYPE_P(op2) == IS_OBJECT && Z_OBJCE_P(op2) == phpsci_ce_NDArrayExpression)) {
+        return ndarray_expression_do_operation(opcode, result, op1, op2);
+    }
+    // Compound assignment writes into op1
+    if (result == op1) {
+        if (ndarray_assign_op_in_place(opcode, op1, op2) == SUCCESS) {
+            return SUCCESS;
+        }
+        ZVAL_COPY_VALUE(&op1_copy, op1);
+        op1 = &op1_copy;
+    }
     retval = ndarray_do_operation_ex(opcode, result, op1, op2);
+    if (op1 == &op1_copy) {
+        if (retval == SUCCESS) {
+            zval_ptr_dtor(op1);
+        } else {
+            ZVAL_COPY_VALUE(result, op1);
+        }
+    }
     return retval;
 }
 
@@ -318,6 +643,49 @@ static void arithmetic_objects_init(zend_class_entry *class_type) {
     arithmetic_object_handlers.do_operation = arithmetic_do_operation;
 }
 
+static void ndarray_expression_destructor(zend_object* object) {
+    NDArrayExpressionObject *intern = ndarray_expression_from_obj(object);
+    NDArrayExpr_FREE(intern->expr);
+    intern->expr = NULL;
+    zend_object_std_dtor(object);
+}
+
+static void ndarray_expression_objects_init(zend_class_entry *class_type) {
+    memcpy(&ndarray_expression_object_handlers, &std_object_handlers, sizeof(zend_object_handlers));
+    ndarray_expression_object_handlers.offset = XtOffsetOf(NDArrayExpressionObject, std);
+    ndarray_expression_object_handlers.do_operation = ndarray_expression_do_operation;
+    ndarray_expression_object_handlers.free_obj = ndarray_expression_destructor;
+    ndarray_expression_object_handlers.clone_obj = NULL;
+}
+
+static void lu_factorization_destructor(zend_object* object) {
+    LUFactorizationObject *intern = lu_factorization_from_obj(object);
+    NDArray_LUFactorFree(intern->factor);
+    intern->factor = NULL;
+    zend_object_std_dtor(object);
+}
+
+static void lu_factorization_objects_init(zend_class_entry *class_type) {
+    memcpy(&lu_factorization_object_handlers, &std_object_handlers, sizeof(zend_object_handlers));
+    lu_factorization_object_handlers.offset = XtOffsetOf(LUFactorizationObject, std);
+    lu_factorization_object_handlers.free_obj = lu_factorization_destructor;
+    lu_factorization_object_handlers.clone_obj = NULL;
+}
+
+static void sparse_ndarray_destructor(zend_object* object) {
+    SparseNDArrayObject *intern = sparse_ndarray_from_obj(object);
+    NDArray_SparseFree(intern->sparse);
+    intern->sparse = NULL;
+    zend_object_std_dtor(object);
+}
+
+static void sparse_ndarray_objects_init(zend_class_entry *class_type) {
+    memcpy(&sparse_ndarray_object_handlers, &std_object_handlers, sizeof(zend_object_handlers));
+    sparse_ndarray_object_handlers.offset = XtOffsetOf(SparseNDArrayObject, std);
+    sparse_ndarray_object_handlers.free_obj = sparse_ndarray_destructor;
+    sparse_ndarray_object_handlers.clone_obj = NULL;
+}
+
 static zend_object *ndarray_create_object(zend_class_entry *class_type) {
     NDArrayObject *intern = zend_object_alloc(sizeof(NDArrayObject), class_type);
 
@@ -344,6 +712,80 @@ static zend_object *arithmetic_create_object(zend_class_entry *class_type) {
     return &intern->std;
 }
 
+static zend_object *ndarray_expression_create_object(zend_class_entry *class_type) {
+    NDArrayExpressionObject *intern = zend_object_alloc(sizeof(NDArrayExpressionObject), class_type);
+    intern->expr = NULL;
+    zend_object_std_init(&intern->std, class_type);
+    object_properties_init(&intern->std, class_type);
+    intern->std.handlers = &ndarray_expression_object_handlers;
+    return &intern->std;
+}
+
+static zend_object *lu_factorization_create_object(zend_class_entry *class_type) {
+    LUFactorizationObject *intern = zend_object_alloc(sizeof(LUFactorizationObject), class_type);
+    intern->factor = NULL;
+    zend_object_std_init(&intern->std, class_type);
+    object_properties_init(&intern->std, class_type);
+    intern->std.handlers = &lu_factorization_object_handlers;
+    return &intern->std;
+}
+
+static zend_object *sparse_ndarray_create_object(zend_class_entry *class_type) {
+    SparseNDArrayObject *intern = zend_object_alloc(sizeof(SparseNDArrayObject), class_type);
+    intern->sparse = NULL;
+    zend_object_std_init(&intern->std, class_type);
+    object_properties_init(&intern->std, class_type);
+    intern->std.handlers = &sparse_ndarray_object_handlers;
+    return &intern->std;
+}
+
+/**
+ * Wrap `sparse` in a new SparseNDArray object
+ */
+static void RETURN_SPARSE_NDARRAY(NDArraySparse *sparse, zval *return_value) {
+    if (sparse == NULL) {
+        RETURN_THROWS();
+    }
+    object_init_ex(return_value, phpsci_ce_SparseNDArray);
+    Z_SPARSE_NDARRAY_P(return_value)->sparse = sparse;
+}
+
+/**
+ * Sparse branch of NumPower::matmul and NumPower::dot
+ *
+ * @return 0 when neither operand is a SparseNDArray, 1 once the product
+ * was written to return_value or an exception was thrown
+ */
+static int sparse_ndarray_product(zval *a, zval *b, zval *return_value) {
+    NDArraySparse *sparse;
+    NDArray *dense, *rtn;
+
+    if (!IS_SPARSE_NDARRAY_P(a) && !IS_SPARSE_NDARRAY_P(b)) {
+        return 0;
+    }
+    if (IS_SPARSE_NDARRAY_P(a) && IS_SPARSE_NDARRAY_P(b)) {
+        zend_throw_error(NULL, "Products of two sparse arrays are not supported, convert one of them with toDense().");
+        return 1;
+    }
+    sparse = sparse_ndarray_get(IS_SPARSE_NDARRAY_P(a) ? a : b);
+    if (sparse == NULL) {
+        return 1;
+    }
+    dense = ZVAL_TO_NDARRAY(IS_SPARSE_NDARRAY_P(a) ? b : a);
+    if (dense == NULL) {
+        return 1;
+    }
+    if (IS_SPARSE_NDARRAY_P(a)) {
+        rtn = NDArray_SparseMatmul(sparse, dense);
+        CHECK_INPUT_AND_FREE(b, dense);
+    } else {
+        rtn = NDArray_DenseSparseMatmul(dense, sparse);
+        CHECK_INPUT_AND_FREE(a, dense);
+    }
+    RETURN_NDARRAY(rtn, return_value);
+    return 1;
+}
+
 NDArray* ZVALUUID_TO_NDARRAY(zval* obj) {
     if (Z_TYPE_P(obj) == IS_LONG) {
         return buffer_get(Z_LVAL_P(obj));
@@ -475,46 +917,268 @@ PHP_METHOD(NDArray, fill) {
     NDArray_Fill(array, (float)value);
 }
 
-ZEND_BEGIN_ARG_INFO(arginfo_toArray, 0)
-ZEND_END_ARG_INFO();
-PHP_METHOD(NDArray, toArray) {
-    zval rtn;
+/**
+ * Shared body of NDArray::addInPlace, subInPlace, mulInPlace and divInPlace
+ */
+static void ndarray_binop_in_place(INTERNAL_FUNCTION_PARAMETERS, int op) {
+    zval *b;
     zval *obj_zval = getThis();
-    ZEND_PARSE_PARAMETERS_START(0, 0)
+    ZEND_PARSE_PARAMETERS_START(1, 1)
+    Z_PARAM_ZVAL(b)
     ZEND_PARSE_PARAMETERS_END();
-    NDArray* array = ZVAL_TO_NDARRAY(obj_zval);
-    if (array == NULL) {
+    NDArray *nda = ZVAL_TO_NDARRAY(obj_zval);
+    if (nda == NULL) {
         return;
     }
-    if (NDArray_DEVICE(array) == NDARRAY_DEVICE_GPU) {
-        zend_throw_error(NULL, "NDArray must be on CPU RAM before it can be converted to a PHP array.");
+    NDArray *ndb = ZVAL_TO_NDARRAY(b);
+    if (ndb == NULL) {
         return;
     }
-    if (NDArray_NDIM(array) == 0) {
-        RETURN_DOUBLE(NDArray_FDATA(array)[0]);
-        NDArray_FREE(array);
-        return;
+    ndb = ndarray_operand_dtype(b, ndb, nda);
+    NDArray *rtn = NDArray_BinaryOpInto(nda, ndb, nda, op);
+    CHECK_INPUT_AND_FREE(b, ndb);
+    if (rtn == NULL) {
+        RETURN_THROWS();
     }
+    RETURN_COPY(obj_zval);
+}
 
-    rtn = NDArray_ToPHPArray(array);
-    RETURN_ZVAL(&rtn, 0, 0);
+ZEND_BEGIN_ARG_INFO(arginfo_add_in_place, 1)
+ZEND_ARG_INFO(0, b)
+ZEND_END_ARG_INFO();
+PHP_METHOD(NDArray, addInPlace) {
+    ndarray_binop_in_place(INTERNAL_FUNCTION_PARAM_PASSTHRU, NDARRAY_BINOP_ADD);
 }
 
-ZEND_BEGIN_ARG_INFO(arginfo_toImage, 0)
+ZEND_BEGIN_ARG_INFO(arginfo_sub_in_place, 1)
+ZEND_ARG_INFO(0, b)
 ZEND_END_ARG_INFO();
-PHP_METHOD(NDArray, toImage) {
-    zval *alpha = NULL;
-    zval *obj_zval = getThis();
-    NDArray *n_alpha = NULL;
-    ZEND_PARSE_PARAMETERS_START(0, 1)
-    Z_PARAM_OPTIONAL
-    Z_PARAM_ZVAL(alpha)
+PHP_METHOD(NDArray, subInPlace) {
+    ndarray_binop_in_place(INTERNAL_FUNCTION_PARAM_PASSTHRU, NDARRAY_BINOP_SUBTRACT);
+}
+
+ZEND_BEGIN_ARG_INFO(arginfo_mul_in_place, 1)
+ZEND_ARG_INFO(0, b)
+ZEND_END_ARG_INFO();
+PHP_METHOD(NDArray, mulInPlace) {
+    ndarray_binop_in_place(INTERNAL_FUNCTION_PARAM_PASSTHRU, NDARRAY_BINOP_MULTIPLY);
+}
+
+ZEND_BEGIN_ARG_INFO(arginfo_div_in_place, 1)
+ZEND_ARG_INFO(0, b)
+ZEND_END_ARG_INFO();
+PHP_METHOD(NDArray, divInPlace) {
+    ndarray_binop_in_place(INTERNAL_FUNCTION_PARAM_PASSTHRU, NDARRAY_BINOP_DIVIDE);
+}
+
+/**
+ * NDArray::shared
+ */
+ZEND_BEGIN_ARG_INFO_EX(arginfo_shared, 0, 0, 2)
+ZEND_ARG_INFO(0, name)
+ZEND_ARG_INFO(0, shape)
+ZEND_ARG_INFO_WITH_DEFAULT_VALUE(0, dtype, "\"float32\"")
+ZEND_END_ARG_INFO();
+PHP_METHOD(NDArray, shared) {
+    NDArray *rtn;
+    zend_string *name;
+    zval *shape_zval;
+    char *dtype = "float32";
+    size_t dtype_len;
+    const char *type;
+    int *shape, ndim;
+    ZEND_PARSE_PARAMETERS_START(2, 3)
+        Z_PARAM_STR(name)
+        Z_PARAM_ZVAL(shape_zval)
+        Z_PARAM_OPTIONAL
+        Z_PARAM_STRING(dtype, dtype_len)
     ZEND_PARSE_PARAMETERS_END();
-    NDArray* array = ZVAL_TO_NDARRAY(obj_zval);
-    if (alpha != NULL) {
-        n_alpha = ZVAL_TO_NDARRAY(alpha);
+    type = ndarray_dtype_argument(dtype);
+    if (type == NULL) {
+        return;
     }
-    if (array == NULL) {
+    shape = zval_axis_argument(shape_zval, "shape", &ndim);
+    if (shape == NULL) {
+        return;
+    }
+    rtn = NDArray_SharedCreate(ZSTR_VAL(name), shape, ndim, type);
+    efree(shape);
+    RETURN_NDARRAY(rtn, return_value);
+}
+
+/**
+ * NDArray::attach
+ */
+ZEND_BEGIN_ARG_INFO(arginfo_attach, 0)
+ZEND_ARG_INFO(0, name)
+ZEND_END_ARG_INFO();
+PHP_METHOD(NDArray, attach) {
+    NDArray *rtn;
+    zend_string *name;
+    ZEND_PARSE_PARAMETERS_START(1, 1)
+        Z_PARAM_STR(name)
+    ZEND_PARSE_PARAMETERS_END();
+    rtn = NDArray_SharedAttach(ZSTR_VAL(name));
+    RETURN_NDARRAY(rtn, return_value);
+}
+
+/**
+ * NDArray::unlinkShared
+ */
+ZEND_BEGIN_ARG_INFO(arginfo_unlink_shared, 0)
+ZEND_ARG_INFO(0, name)
+ZEND_END_ARG_INFO();
+PHP_METHOD(NDArray, unlinkShared) {
+    zend_string *name;
+    ZEND_PARSE_PARAMETERS_START(1, 1)
+        Z_PARAM_STR(name)
+    ZEND_PARSE_PARAMETERS_END();
+    NDArray_SharedUnlink(ZSTR_VAL(name));
+}
+
+/**
+ * NDArray::persist
+ */
+ZEND_BEGIN_ARG_INFO(arginfo_persist, 0)
+ZEND_ARG_INFO(0, name)
+ZEND_END_ARG_INFO();
+PHP_METHOD(NDArray, persist) {
+    zend_string *name;
+    zval *obj_zval = getThis();
+    ZEND_PARSE_PARAMETERS_START(1, 1)
+        Z_PARAM_STR(name)
+    ZEND_PARSE_PARAMETERS_END();
+    NDArray* array = ZVAL_TO_NDARRAY(obj_zval);
+    if (array == NULL) {
+        return;
+    }
+    NDArray_Persist(array, ZSTR_VAL(name), ZSTR_LEN(name));
+}
+
+/**
+ * NDArray::persisted
+ */
+ZEND_BEGIN_ARG_INFO(arginfo_persisted, 0)
+ZEND_ARG_INFO(0, name)
+ZEND_END_ARG_INFO();
+PHP_METHOD(NDArray, persisted) {
+    NDArray *rtn;
+    zend_string *name;
+    ZEND_PARSE_PARAMETERS_START(1, 1)
+        Z_PARAM_STR(name)
+    ZEND_PARSE_PARAMETERS_END();
+    rtn = NDArray_PersistentFetch(ZSTR_VAL(name), ZSTR_LEN(name));
+    if (rtn == NULL) {
+        RETURN_NULL();
+    }
+    RETURN_NDARRAY(rtn, return_value);
+}
+
+/**
+ * NDArray::unpersist
+ */
+ZEND_BEGIN_ARG_INFO(arginfo_unpersist, 0)
+ZEND_ARG_INFO(0, name)
+ZEND_END_ARG_INFO();
+PHP_METHOD(NDArray, unpersist) {
+    zend_string *name;
+    ZEND_PARSE_PARAMETERS_START(1, 1)
+        Z_PARAM_STR(name)
+    ZEND_PARSE_PARAMETERS_END();
+    RETURN_BOOL(NDArray_PersistentRemove(ZSTR_VAL(name), ZSTR_LEN(name)) == 0);
+}
+
+/**
+ * NDArray::persistentStats
+ */
+ZEND_BEGIN_ARG_INFO(arginfo_persistent_stats, 0)
+ZEND_END_ARG_INFO();
+PHP_METHOD(NDArray, persistentStats) {
+    NDArrayPersistentStats stats;
+    ZEND_PARSE_PARAMETERS_START(0, 0)
+    ZEND_PARSE_PARAMETERS_END();
+    stats = NDArray_PersistentStats();
+    array_init_size(return_value, 5);
+    add_assoc_long(return_value, "count", stats.count);
+    add_assoc_long(return_value, "bytes", (zend_long)stats.bytes);
+    add_assoc_long(return_value, "limit", (zend_long)stats.limit);
+    add_assoc_long(return_value, "hits", stats.hits);
+    add_assoc_long(return_value, "misses", stats.misses);
+}
+
+ZEND_BEGIN_ARG_INFO(arginfo_dtype, 0)
+ZEND_END_ARG_INFO();
+PHP_METHOD(NDArray, dtype) {
+    ZEND_PARSE_PARAMETERS_START(0, 0)
+    ZEND_PARSE_PARAMETERS_END();
+    NDArray* array = ZVAL_TO_NDARRAY(getThis());
+    if (array == NULL) {
+        return;
+    }
+    RETURN_STRING(NDArray_TYPE(array));
+}
+
+ZEND_BEGIN_ARG_INFO(arginfo_astype, 1)
+ZEND_ARG_INFO(0, dtype)
+ZEND_END_ARG_INFO();
+PHP_METHOD(NDArray, astype) {
+    char *dtype;
+    size_t dtype_len;
+    const char *type;
+    ZEND_PARSE_PARAMETERS_START(1, 1)
+    Z_PARAM_STRING(dtype, dtype_len)
+    ZEND_PARSE_PARAMETERS_END();
+    type = ndarray_dtype_argument(dtype);
+    if (type == NULL) {
+        return;
+    }
+    NDArray* array = ZVAL_TO_NDARRAY(getThis());
+    if (array == NULL) {
+        return;
+    }
+    RETURN_NDARRAY(NDArray_AsType(array, type), return_value);
+}
+
+ZEND_BEGIN_ARG_INFO(arginfo_toArray, 0)
+ZEND_END_ARG_INFO();
+PHP_METHOD(NDArray, toArray) {
+    zval rtn;
+    zval *obj_zval = getThis();
+    ZEND_PARSE_PARAMETERS_START(0, 0)
+    ZEND_PARSE_PARAMETERS_END();
+    NDArray* array = ZVAL_TO_NDARRAY(obj_zval);
+    if (array == NULL) {
+        return;
+    }
+    if (NDArray_DEVICE(array) == NDARRAY_DEVICE_GPU) {
+        zend_throw_error(NULL, "NDArray must be on CPU RAM before it can be converted to a PHP array.");
+        return;
+    }
+    if (NDArray_NDIM(array) == 0) {
+        NDArray_ItemToZval(array, NDArray_DATA(array), return_value);
+        NDArray_FREE(array);
+        return;
+    }
+
+    rtn = NDArray_ToPHPArray(array);
+    RETURN_ZVAL(&rtn, 0, 0);
+}
+
+ZEND_BEGIN_ARG_INFO(arginfo_toImage, 0)
+ZEND_END_ARG_INFO();
+PHP_METHOD(NDArray, toImage) {
+    zval *alpha = NULL;
+    zval *obj_zval = getThis();
+    NDArray *n_alpha = NULL;
+    ZEND_PARSE_PARAMETERS_START(0, 1)
+    Z_PARAM_OPTIONAL
+    Z_PARAM_ZVAL(alpha)
+    ZEND_PARSE_PARAMETERS_END();
+    NDArray* array = ZVAL_TO_NDARRAY(obj_zval);
+    if (alpha != NULL) {
+        n_alpha = ZVAL_TO_NDARRAY(alpha);
+    }
+    if (array == NULL) {
         return;
     }
     if (NDArray_DEVICE(array) == NDARRAY_DEVICE_GPU) {
@@ -633,6 +1297,76 @@ PHP_METHOD(NumPower, save) {
     RETURN_NULL();
 }
 
+/**
+ * NumPower::loadtxt
+ */
+ZEND_BEGIN_ARG_INFO_EX(arginfo_loadtxt, 0, 0, 1)
+    ZEND_ARG_INFO(0, filename)
+    ZEND_ARG_INFO_WITH_DEFAULT_VALUE(0, delimiter, "\",\"")
+    ZEND_ARG_INFO_WITH_DEFAULT_VALUE(0, skiprows, "0")
+    ZEND_ARG_INFO_WITH_DEFAULT_VALUE(0, usecols, "null")
+    ZEND_ARG_INFO_WITH_DEFAULT_VALUE(0, chunk_size, "1048576")
+ZEND_END_ARG_INFO();
+PHP_METHOD(NumPower, loadtxt) {
+    NDArray *rtn;
+    zend_string *filename;
+    zend_string *delimiter = NULL;
+    zend_long skiprows = 0;
+    zend_long chunk_size = NDARRAY_IO_DEFAULT_CHUNK_SIZE;
+    zval *usecols = NULL;
+    int *cols = NULL, n_cols = 0;
+    ZEND_PARSE_PARAMETERS_START(1, 5)
+        Z_PARAM_STR(filename)
+        Z_PARAM_OPTIONAL
+        Z_PARAM_STR(delimiter)
+        Z_PARAM_LONG(skiprows)
+        Z_PARAM_ZVAL(usecols)
+        Z_PARAM_LONG(chunk_size)
+    ZEND_PARSE_PARAMETERS_END();
+    if (delimiter != NULL && ZSTR_LEN(delimiter) != 1) {
+        zend_throw_error(NULL, "`delimiter` must be a single character.");
+        return;
+    }
+    if (usecols != NULL && Z_TYPE_P(usecols) != IS_NULL) {
+        cols = zval_axis_argument(usecols, "usecols", &n_cols);
+        if (cols == NULL) {
+            return;
+        }
+    }
+    rtn = NDArray_LoadTxt(ZSTR_VAL(filename), (delimiter == NULL) ? ',' : ZSTR_VAL(delimiter)[0],
+                          (int)skiprows, cols, n_cols, (long)chunk_size);
+    if (cols != NULL) {
+        efree(cols);
+    }
+    RETURN_NDARRAY(rtn, return_value);
+}
+
+/**
+ * NumPower::fromfile
+ */
+ZEND_BEGIN_ARG_INFO_EX(arginfo_fromfile, 0, 0, 1)
+    ZEND_ARG_INFO(0, filename)
+    ZEND_ARG_INFO_WITH_DEFAULT_VALUE(0, count, "-1")
+    ZEND_ARG_INFO_WITH_DEFAULT_VALUE(0, offset, "0")
+    ZEND_ARG_INFO_WITH_DEFAULT_VALUE(0, chunk_size, "1048576")
+ZEND_END_ARG_INFO();
+PHP_METHOD(NumPower, fromfile) {
+    NDArray *rtn;
+    zend_string *filename;
+    zend_long count = -1;
+    zend_long offset = 0;
+    zend_long chunk_size = NDARRAY_IO_DEFAULT_CHUNK_SIZE;
+    ZEND_PARSE_PARAMETERS_START(1, 4)
+        Z_PARAM_STR(filename)
+        Z_PARAM_OPTIONAL
+        Z_PARAM_LONG(count)
+        Z_PARAM_LONG(offset)
+        Z_PARAM_LONG(chunk_size)
+    ZEND_PARSE_PARAMETERS_END();
+    rtn = NDArray_FromFile(ZSTR_VAL(filename), (long)count, (long)offset, (long)chunk_size);
+    RETURN_NDARRAY(rtn, return_value);
+}
+
 ZEND_BEGIN_ARG_INFO(arginfo_setdevice, 0)
 ZEND_ARG_INFO(0, deviceId)
 ZEND_END_ARG_INFO();
@@ -732,16 +1466,26 @@ PHP_FUNCTION(print_r_) {
  * @param execute_data
  * @param return_value
  */
-ZEND_BEGIN_ARG_INFO(arginfo_ndarray_zeros, 1)
+ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_zeros, 0, 0, 1)
 ZEND_ARG_INFO(0, shape_zval)
+ZEND_ARG_INFO(0, dtype)
 ZEND_END_ARG_INFO()
 PHP_METHOD(NumPower, zeros) {
     NDArray *rtn = NULL;
     int *shape;
     zval *shape_zval;
-    ZEND_PARSE_PARAMETERS_START(1, 1)
+    char *dtype = "float32";
+    size_t dtype_len;
+    const char *type;
+    ZEND_PARSE_PARAMETERS_START(1, 2)
     Z_PARAM_ZVAL(shape_zval)
+    Z_PARAM_OPTIONAL
+    Z_PARAM_STRING(dtype, dtype_len)
     ZEND_PARSE_PARAMETERS_END();
+    type = ndarray_dtype_argument(dtype);
+    if (type == NULL) {
+        return;
+    }
     NDArray *nda = ZVAL_TO_NDARRAY(shape_zval);
     if (nda == NULL) {
         return;
@@ -750,7 +1494,7 @@ PHP_METHOD(NumPower, zeros) {
     for (int i = 0; i < NDArray_NUMELEMENTS(nda); i++) {
         shape[i] = (int) NDArray_FDATA(nda)[i];
     }
-    rtn = NDArray_Zeros(shape, NDArray_NUMELEMENTS(nda), NDARRAY_TYPE_FLOAT32, NDARRAY_DEVICE_CPU);
+    rtn = NDArray_Zeros(shape, NDArray_NUMELEMENTS(nda), type, NDARRAY_DEVICE_CPU);
     NDArray_FREE(nda);
     RETURN_NDARRAY(rtn, return_value);
 }
@@ -1273,123 +2017,328 @@ PHP_METHOD(NumPower, diagonal) {
 }
 
 /**
- * NumPower::full
+ * NumPower::take
  *
  * @param execute_data
  * @param return_value
  */
-ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_full, 0, 0, 2)
-ZEND_ARG_INFO(0, shape)
-ZEND_ARG_INFO(0, fill_value)
+ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_take, 0, 0, 2)
+ZEND_ARG_INFO(0, a)
+ZEND_ARG_INFO(0, indices)
+ZEND_ARG_INFO(0, axis)
 ZEND_END_ARG_INFO()
-PHP_METHOD(NumPower, full) {
+PHP_METHOD(NumPower, take) {
     NDArray *rtn = NULL;
-    zval* shape;
-    HashTable *shape_ht;
-    double fill_value;
-    int *new_shape;
-    zend_string *key;
-    zend_ulong idx;
-    zval *val;
-    ZEND_PARSE_PARAMETERS_START(2, 2)
-        Z_PARAM_ARRAY(shape)
-        Z_PARAM_DOUBLE(fill_value)
+    zval *a, *indices;
+    zend_long axis = NDARRAY_MAX_DIMS;
+    bool axis_is_null = true;
+    ZEND_PARSE_PARAMETERS_START(2, 3)
+        Z_PARAM_ZVAL(a)
+        Z_PARAM_ZVAL(indices)
+        Z_PARAM_OPTIONAL
+        Z_PARAM_LONG_OR_NULL(axis, axis_is_null)
     ZEND_PARSE_PARAMETERS_END();
-    shape_ht = Z_ARRVAL_P(shape);
-
-    ZEND_HASH_FOREACH_KEY_VAL(shape_ht, idx, key, val) {
-        if (Z_TYPE_P(val) != IS_LONG) {
-            zend_throw_error(NULL, "Invalid parameter: Shape elements must be integers.");
-            return;
-        }
-    } ZEND_HASH_FOREACH_END();
-
-    NDArray *nd_shape = ZVAL_TO_NDARRAY(shape);
-
-    if (nd_shape == NULL) {
+    NDArray *nda = ZVAL_TO_NDARRAY(a);
+    if (nda == NULL) {
         return;
     }
-
-    if (NDArray_NUMELEMENTS(nd_shape) == 0) {
-        NDArray_FREE(nd_shape);
-        zend_throw_error(NULL, "Invalid parameter: Expected a non-empty array.");
+    NDArray *ndi = ZVAL_TO_NDARRAY(indices);
+    if (ndi == NULL) {
+        CHECK_INPUT_AND_FREE(a, nda);
         return;
     }
-
-    new_shape = NDArray_ToIntVector(nd_shape);
-    rtn = NDArray_Full(new_shape, NDArray_NUMELEMENTS(nd_shape), fill_value);
-
-    efree(new_shape);
-    NDArray_FREE(nd_shape);
+    rtn = NDArray_Take(nda, ndi, axis_is_null ? NDARRAY_MAX_DIMS : (int)axis);
+    CHECK_INPUT_AND_FREE(a, nda);
+    CHECK_INPUT_AND_FREE(indices, ndi);
     RETURN_NDARRAY(rtn, return_value);
 }
 
 /**
- * NumPower::ones
+ * NumPower::put
  *
  * @param execute_data
  * @param return_value
  */
-ZEND_BEGIN_ARG_INFO(arginfo_ndarray_ones, 1)
-ZEND_ARG_INFO(0, shape_zval)
+ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_put, 0, 0, 3)
+ZEND_ARG_OBJ_INFO(0, a, NDArray, 0)
+ZEND_ARG_INFO(0, indices)
+ZEND_ARG_INFO(0, values)
 ZEND_END_ARG_INFO()
-PHP_METHOD(NumPower, ones) {
-    double *ptr;
-    NDArray *rtn = NULL;
-    int *shape;
-    zval *shape_zval;
-    ZEND_PARSE_PARAMETERS_START(1, 1)
-    Z_PARAM_ZVAL(shape_zval)
+PHP_METHOD(NumPower, put) {
+    zval *a, *indices, *values;
+    ZEND_PARSE_PARAMETERS_START(3, 3)
+        Z_PARAM_OBJECT_OF_CLASS(a, phpsci_ce_NDArray)
+        Z_PARAM_ZVAL(indices)
+        Z_PARAM_ZVAL(values)
     ZEND_PARSE_PARAMETERS_END();
-    NDArray *nda = ZVAL_TO_NDARRAY(shape_zval);
+    NDArray *nda = ZVAL_TO_NDARRAY(a);
     if (nda == NULL) {
         return;
     }
-    shape = NDArray_ToIntVector(nda);
-    rtn = NDArray_Ones(shape, NDArray_NUMELEMENTS(nda), NDARRAY_TYPE_FLOAT32);
-    NDArray_FREE(nda);
-    RETURN_NDARRAY(rtn, return_value);
+    NDArray *ndi = ZVAL_TO_NDARRAY(indices);
+    if (ndi == NULL) {
+        return;
+    }
+    NDArray *ndv = ZVAL_TO_NDARRAY(values);
+    if (ndv == NULL) {
+        CHECK_INPUT_AND_FREE(indices, ndi);
+        return;
+    }
+    NDArray_Put(nda, ndi, ndv);
+    CHECK_INPUT_AND_FREE(indices, ndi);
+    CHECK_INPUT_AND_FREE(values, ndv);
 }
 
 /**
- * NumPower::arange
+ * NumPower::where
  *
  * @param execute_data
  * @param return_value
  */
-ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_arange, 0, 0, 1)
-ZEND_ARG_INFO(0, stop)
-ZEND_ARG_INFO(0, start)
-ZEND_ARG_INFO(0, step)
+ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_where, 0, 0, 3)
+ZEND_ARG_INFO(0, condition)
+ZEND_ARG_INFO(0, x)
+ZEND_ARG_INFO(0, y)
 ZEND_END_ARG_INFO()
-PHP_METHOD(NumPower, arange) {
+PHP_METHOD(NumPower, where) {
     NDArray *rtn = NULL;
-    double start, stop, step;
-    ZEND_PARSE_PARAMETERS_START(1, 3)
-    Z_PARAM_DOUBLE(stop)
-    Z_PARAM_OPTIONAL
-    Z_PARAM_DOUBLE(start)
-    Z_PARAM_DOUBLE(step)
+    zval *condition, *x, *y;
+    ZEND_PARSE_PARAMETERS_START(3, 3)
+        Z_PARAM_ZVAL(condition)
+        Z_PARAM_ZVAL(x)
+        Z_PARAM_ZVAL(y)
     ZEND_PARSE_PARAMETERS_END();
-    if (ZEND_NUM_ARGS() == 1) {
-        start = 0.0f;
-        step  = 1.0f;
+    NDArray *ndc = ZVAL_TO_NDARRAY(condition);
+    if (ndc == NULL) {
+        return;
     }
-    if (ZEND_NUM_ARGS() == 2) {
-        step  = 1.0f;
+    NDArray *ndx = ZVAL_TO_NDARRAY(x);
+    if (ndx == NULL) {
+        CHECK_INPUT_AND_FREE(condition, ndc);
+        return;
     }
-    rtn = NDArray_Arange(start, stop, step);
+    NDArray *ndy = ZVAL_TO_NDARRAY(y);
+    if (ndy == NULL) {
+        CHECK_INPUT_AND_FREE(condition, ndc);
+        CHECK_INPUT_AND_FREE(x, ndx);
+        return;
+    }
+    ndx = ndarray_operand_dtype(x, ndx, ndy);
+    ndy = ndarray_operand_dtype(y, ndy, ndx);
+    rtn = NDArray_Where(ndc, ndx, ndy);
+    CHECK_INPUT_AND_FREE(condition, ndc);
+    CHECK_INPUT_AND_FREE(x, ndx);
+    CHECK_INPUT_AND_FREE(y, ndy);
     RETURN_NDARRAY(rtn, return_value);
 }
 
 /**
- * NumPower::all
+ * NumPower::gather
  *
  * @param execute_data
  * @param return_value
  */
-ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_all, 0, 0, 1)
-ZEND_ARG_INFO(0, array)
+ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_gather, 0, 0, 3)
+ZEND_ARG_INFO(0, a)
+ZEND_ARG_INFO(0, axis)
+ZEND_ARG_INFO(0, indices)
+ZEND_END_ARG_INFO()
+PHP_METHOD(NumPower, gather) {
+    NDArray *rtn = NULL;
+    zval *a, *indices;
+    zend_long axis;
+    ZEND_PARSE_PARAMETERS_START(3, 3)
+        Z_PARAM_ZVAL(a)
+        Z_PARAM_LONG(axis)
+        Z_PARAM_ZVAL(indices)
+    ZEND_PARSE_PARAMETERS_END();
+    NDArray *nda = ZVAL_TO_NDARRAY(a);
+    if (nda == NULL) {
+        return;
+    }
+    NDArray *ndi = ZVAL_TO_NDARRAY(indices);
+    if (ndi == NULL) {
+        CHECK_INPUT_AND_FREE(a, nda);
+        return;
+    }
+    rtn = NDArray_Gather(nda, (int)axis, ndi);
+    CHECK_INPUT_AND_FREE(a, nda);
+    CHECK_INPUT_AND_FREE(indices, ndi);
+    RETURN_NDARRAY(rtn, return_value);
+}
+
+/**
+ * NumPower::scatterAdd
+ *
+ * @param execute_data
+ * @param return_value
+ */
+ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_scatter_add, 0, 0, 4)
+ZEND_ARG_INFO(0, a)
+ZEND_ARG_INFO(0, axis)
+ZEND_ARG_INFO(0, indices)
+ZEND_ARG_INFO(0, src)
+ZEND_END_ARG_INFO()
+PHP_METHOD(NumPower, scatterAdd) {
+    NDArray *rtn = NULL;
+    zval *a, *indices, *src;
+    zend_long axis;
+    ZEND_PARSE_PARAMETERS_START(4, 4)
+        Z_PARAM_ZVAL(a)
+        Z_PARAM_LONG(axis)
+        Z_PARAM_ZVAL(indices)
+        Z_PARAM_ZVAL(src)
+    ZEND_PARSE_PARAMETERS_END();
+    NDArray *nda = ZVAL_TO_NDARRAY(a);
+    if (nda == NULL) {
+        return;
+    }
+    NDArray *ndi = ZVAL_TO_NDARRAY(indices);
+    if (ndi == NULL) {
+        CHECK_INPUT_AND_FREE(a, nda);
+        return;
+    }
+    NDArray *nds = ZVAL_TO_NDARRAY(src);
+    if (nds == NULL) {
+        CHECK_INPUT_AND_FREE(a, nda);
+        CHECK_INPUT_AND_FREE(indices, ndi);
+        return;
+    }
+    rtn = NDArray_ScatterAdd(nda, (int)axis, ndi, nds);
+    CHECK_INPUT_AND_FREE(a, nda);
+    CHECK_INPUT_AND_FREE(indices, ndi);
+    CHECK_INPUT_AND_FREE(src, nds);
+    RETURN_NDARRAY(rtn, return_value);
+}
+
+/**
+ * NumPower::full
+ *
+ * @param execute_data
+ * @param return_value
+ */
+ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_full, 0, 0, 2)
+ZEND_ARG_INFO(0, shape)
+ZEND_ARG_INFO(0, fill_value)
+ZEND_END_ARG_INFO()
+PHP_METHOD(NumPower, full) {
+    NDArray *rtn = NULL;
+    zval* shape;
+    HashTable *shape_ht;
+    double fill_value;
+    int *new_shape;
+    zend_string *key;
+    zend_ulong idx;
+    zval *val;
+    ZEND_PARSE_PARAMETERS_START(2, 2)
+        Z_PARAM_ARRAY(shape)
+        Z_PARAM_DOUBLE(fill_value)
+    ZEND_PARSE_PARAMETERS_END();
+    shape_ht = Z_ARRVAL_P(shape);
+
+    ZEND_HASH_FOREACH_KEY_VAL(shape_ht, idx, key, val) {
+        if (Z_TYPE_P(val) != IS_LONG) {
+            zend_throw_error(NULL, "Invalid parameter: Shape elements must be integers.");
+            return;
+        }
+    } ZEND_HASH_FOREACH_END();
+
+    NDArray *nd_shape = ZVAL_TO_NDARRAY(shape);
+
+    if (nd_shape == NULL) {
+        return;
+    }
+
+    if (NDArray_NUMELEMENTS(nd_shape) == 0) {
+        NDArray_FREE(nd_shape);
+        zend_throw_error(NULL, "Invalid parameter: Expected a non-empty array.");
+        return;
+    }
+
+    new_shape = NDArray_ToIntVector(nd_shape);
+    rtn = NDArray_Full(new_shape, NDArray_NUMELEMENTS(nd_shape), fill_value);
+
+    efree(new_shape);
+    NDArray_FREE(nd_shape);
+    RETURN_NDARRAY(rtn, return_value);
+}
+
+/**
+ * NumPower::ones
+ *
+ * @param execute_data
+ * @param return_value
+ */
+ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_ones, 0, 0, 1)
+ZEND_ARG_INFO(0, shape_zval)
+ZEND_ARG_INFO(0, dtype)
+ZEND_END_ARG_INFO()
+PHP_METHOD(NumPower, ones) {
+    double *ptr;
+    NDArray *rtn = NULL;
+    int *shape;
+    zval *shape_zval;
+    char *dtype = "float32";
+    size_t dtype_len;
+    const char *type;
+    ZEND_PARSE_PARAMETERS_START(1, 2)
+    Z_PARAM_ZVAL(shape_zval)
+    Z_PARAM_OPTIONAL
+    Z_PARAM_STRING(dtype, dtype_len)
+    ZEND_PARSE_PARAMETERS_END();
+    type = ndarray_dtype_argument(dtype);
+    if (type == NULL) {
+        return;
+    }
+    NDArray *nda = ZVAL_TO_NDARRAY(shape_zval);
+    if (nda == NULL) {
+        return;
+    }
+    shape = NDArray_ToIntVector(nda);
+    rtn = NDArray_Ones(shape, NDArray_NUMELEMENTS(nda), type);
+    NDArray_FREE(nda);
+    RETURN_NDARRAY(rtn, return_value);
+}
+
+/**
+ * NumPower::arange
+ *
+ * @param execute_data
+ * @param return_value
+ */
+ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_arange, 0, 0, 1)
+ZEND_ARG_INFO(0, stop)
+ZEND_ARG_INFO(0, start)
+ZEND_ARG_INFO(0, step)
+ZEND_END_ARG_INFO()
+PHP_METHOD(NumPower, arange) {
+    NDArray *rtn = NULL;
+    double start, stop, step;
+    ZEND_PARSE_PARAMETERS_START(1, 3)
+    Z_PARAM_DOUBLE(stop)
+    Z_PARAM_OPTIONAL
+    Z_PARAM_DOUBLE(start)
+    Z_PARAM_DOUBLE(step)
+    ZEND_PARSE_PARAMETERS_END();
+    if (ZEND_NUM_ARGS() == 1) {
+        start = 0.0f;
+        step  = 1.0f;
+    }
+    if (ZEND_NUM_ARGS() == 2) {
+        step  = 1.0f;
+    }
+    rtn = NDArray_Arange(start, stop, step);
+    RETURN_NDARRAY(rtn, return_value);
+}
+
+/**
+ * NumPower::all
+ *
+ * @param execute_data
+ * @param return_value
+ */
+ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_all, 0, 0, 1)
+ZEND_ARG_INFO(0, array)
 ZEND_ARG_INFO(0, axis)
 ZEND_END_ARG_INFO()
 PHP_METHOD(NumPower, all) {
@@ -1424,6 +2373,35 @@ PHP_METHOD(NumPower, all) {
     }
 }
 
+/**
+ * NumPower::countNonzero
+ *
+ * @param execute_data
+ * @param return_value
+ */
+ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_count_nonzero, 0, 0, 1)
+ZEND_ARG_INFO(0, array)
+ZEND_END_ARG_INFO()
+PHP_METHOD(NumPower, countNonzero) {
+    zval *array;
+    long count;
+    ZEND_PARSE_PARAMETERS_START(1, 1)
+    Z_PARAM_ZVAL(array)
+    ZEND_PARSE_PARAMETERS_END();
+    NDArray *nda = ZVAL_TO_NDARRAY(array);
+    if (nda == NULL) {
+        return;
+    }
+    if (NDArray_DEVICE(nda) == NDARRAY_DEVICE_GPU) {
+        zend_throw_error(NULL, "countNonzero is only available for NDArrays on CPU RAM.");
+        CHECK_INPUT_AND_FREE(array, nda);
+        return;
+    }
+    count = NDArray_CountNonzero(nda);
+    CHECK_INPUT_AND_FREE(array, nda);
+    RETURN_LONG(count);
+}
+
 /**
  * NumPower::allClose
  *
@@ -1713,19 +2691,24 @@ PHP_METHOD(NumPower, abs) {
  */
 ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_sin, 0, 0, 1)
 ZEND_ARG_INFO(0, array)
+ZEND_ARG_INFO(0, out)
 ZEND_END_ARG_INFO()
 PHP_METHOD(NumPower, sin) {
     NDArray *rtn = NULL;
-    zval *array;
-    ZEND_PARSE_PARAMETERS_START(1, 1)
+    zval *array, *out = NULL;
+    ZEND_PARSE_PARAMETERS_START(1, 2)
     Z_PARAM_ZVAL(array)
+    Z_PARAM_OPTIONAL
+    Z_PARAM_OBJECT_OF_CLASS_OR_NULL(out, phpsci_ce_NDArray)
     ZEND_PARSE_PARAMETERS_END();
     NDArray *nda = ZVAL_TO_NDARRAY(array);
     if (nda == NULL) {
         return;
     }
 
-    if (NDArray_DEVICE(nda) == NDARRAY_DEVICE_CPU) {
+    if (out != NULL) {
+        rtn = NDArray_MapInto(nda, float_sin, ZVAL_TO_NDARRAY(out));
+    } else if (NDArray_DEVICE(nda) == NDARRAY_DEVICE_CPU) {
         rtn = NDArray_Map(nda, float_sin);
     } else {
 #ifdef HAVE_CUBLAS
@@ -1737,7 +2720,7 @@ PHP_METHOD(NumPower, sin) {
     if (Z_TYPE_P(array) == IS_ARRAY) {
         NDArray_FREE(nda);
     }
-    RETURN_NDARRAY(rtn, return_value);
+    RETURN_NDARRAY_OUT(rtn, out, return_value);
 }
 
 /**
@@ -1748,19 +2731,24 @@ PHP_METHOD(NumPower, sin) {
  */
 ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_cos, 0, 0, 1)
 ZEND_ARG_INFO(0, array)
+ZEND_ARG_INFO(0, out)
 ZEND_END_ARG_INFO()
 PHP_METHOD(NumPower, cos) {
     NDArray *rtn = NULL;
-    zval *array;
-    ZEND_PARSE_PARAMETERS_START(1, 1)
+    zval *array, *out = NULL;
+    ZEND_PARSE_PARAMETERS_START(1, 2)
     Z_PARAM_ZVAL(array)
+    Z_PARAM_OPTIONAL
+    Z_PARAM_OBJECT_OF_CLASS_OR_NULL(out, phpsci_ce_NDArray)
     ZEND_PARSE_PARAMETERS_END();
     NDArray *nda = ZVAL_TO_NDARRAY(array);
     if (nda == NULL) {
         return;
     }
 
-    if (NDArray_DEVICE(nda) == NDARRAY_DEVICE_CPU) {
+    if (out != NULL) {
+        rtn = NDArray_MapInto(nda, float_cos, ZVAL_TO_NDARRAY(out));
+    } else if (NDArray_DEVICE(nda) == NDARRAY_DEVICE_CPU) {
         rtn = NDArray_Map(nda, float_cos);
     } else {
 #ifdef HAVE_CUBLAS
@@ -1772,7 +2760,7 @@ PHP_METHOD(NumPower, cos) {
     if (Z_TYPE_P(array) == IS_ARRAY) {
         NDArray_FREE(nda);
     }
-    RETURN_NDARRAY(rtn, return_value);
+    RETURN_NDARRAY_OUT(rtn, out, return_value);
 }
 
 /**
@@ -1783,19 +2771,24 @@ PHP_METHOD(NumPower, cos) {
  */
 ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_tan, 0, 0, 1)
 ZEND_ARG_INFO(0, array)
+ZEND_ARG_INFO(0, out)
 ZEND_END_ARG_INFO()
 PHP_METHOD(NumPower, tan) {
     NDArray *rtn = NULL;
-    zval *array;
-    ZEND_PARSE_PARAMETERS_START(1, 1)
+    zval *array, *out = NULL;
+    ZEND_PARSE_PARAMETERS_START(1, 2)
     Z_PARAM_ZVAL(array)
+    Z_PARAM_OPTIONAL
+    Z_PARAM_OBJECT_OF_CLASS_OR_NULL(out, phpsci_ce_NDArray)
     ZEND_PARSE_PARAMETERS_END();
     NDArray *nda = ZVAL_TO_NDARRAY(array);
     if (nda == NULL) {
         return;
     }
 
-    if (NDArray_DEVICE(nda) == NDARRAY_DEVICE_CPU) {
+    if (out != NULL) {
+        rtn = NDArray_MapInto(nda, float_tan, ZVAL_TO_NDARRAY(out));
+    } else if (NDArray_DEVICE(nda) == NDARRAY_DEVICE_CPU) {
         rtn = NDArray_Map(nda, float_tan);
     } else {
 #ifdef HAVE_CUBLAS
@@ -1807,7 +2800,7 @@ PHP_METHOD(NumPower, tan) {
     if (Z_TYPE_P(array) == IS_ARRAY) {
         NDArray_FREE(nda);
     }
-    RETURN_NDARRAY(rtn, return_value);
+    RETURN_NDARRAY_OUT(rtn, out, return_value);
 }
 
 /**
@@ -1818,19 +2811,24 @@ PHP_METHOD(NumPower, tan) {
  */
 ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_arcsin, 0, 0, 1)
 ZEND_ARG_INFO(0, array)
+ZEND_ARG_INFO(0, out)
 ZEND_END_ARG_INFO()
 PHP_METHOD(NumPower, arcsin) {
     NDArray *rtn = NULL;
-    zval *array;
-    ZEND_PARSE_PARAMETERS_START(1, 1)
+    zval *array, *out = NULL;
+    ZEND_PARSE_PARAMETERS_START(1, 2)
     Z_PARAM_ZVAL(array)
+    Z_PARAM_OPTIONAL
+    Z_PARAM_OBJECT_OF_CLASS_OR_NULL(out, phpsci_ce_NDArray)
     ZEND_PARSE_PARAMETERS_END();
     NDArray *nda = ZVAL_TO_NDARRAY(array);
     if (nda == NULL) {
         return;
     }
 
-    if (NDArray_DEVICE(nda) == NDARRAY_DEVICE_CPU) {
+    if (out != NULL) {
+        rtn = NDArray_MapInto(nda, float_arcsin, ZVAL_TO_NDARRAY(out));
+    } else if (NDArray_DEVICE(nda) == NDARRAY_DEVICE_CPU) {
         rtn = NDArray_Map(nda, float_arcsin);
     } else {
 #ifdef HAVE_CUBLAS
@@ -1842,7 +2840,7 @@ PHP_METHOD(NumPower, arcsin) {
     if (Z_TYPE_P(array) == IS_ARRAY) {
         NDArray_FREE(nda);
     }
-    RETURN_NDARRAY(rtn, return_value);
+    RETURN_NDARRAY_OUT(rtn, out, return_value);
 }
 
 /**
@@ -1853,19 +2851,24 @@ PHP_METHOD(NumPower, arcsin) {
  */
 ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_rsqrt, 0, 0, 1)
                 ZEND_ARG_INFO(0, array)
+                ZEND_ARG_INFO(0, out)
 ZEND_END_ARG_INFO()
 PHP_METHOD(NumPower, rsqrt) {
     NDArray *rtn = NULL;
-    zval *array;
-    ZEND_PARSE_PARAMETERS_START(1, 1)
+    zval *array, *out = NULL;
+    ZEND_PARSE_PARAMETERS_START(1, 2)
             Z_PARAM_ZVAL(array)
+            Z_PARAM_OPTIONAL
+            Z_PARAM_OBJECT_OF_CLASS_OR_NULL(out, phpsci_ce_NDArray)
     ZEND_PARSE_PARAMETERS_END();
     NDArray *nda = ZVAL_TO_NDARRAY(array);
     if (nda == NULL) {
         return;
     }
 
-    if (NDArray_DEVICE(nda) == NDARRAY_DEVICE_CPU) {
+    if (out != NULL) {
+        rtn = NDArray_MapInto(nda, float_rsqrt, ZVAL_TO_NDARRAY(out));
+    } else if (NDArray_DEVICE(nda) == NDARRAY_DEVICE_CPU) {
         rtn = NDArray_Map(nda, float_rsqrt);
     } else {
 #ifdef HAVE_CUBLAS
@@ -1877,7 +2880,7 @@ PHP_METHOD(NumPower, rsqrt) {
     if (Z_TYPE_P(array) == IS_ARRAY) {
         NDArray_FREE(nda);
     }
-    RETURN_NDARRAY(rtn, return_value);
+    RETURN_NDARRAY_OUT(rtn, out, return_value);
 }
 
 /**
@@ -1888,19 +2891,24 @@ PHP_METHOD(NumPower, rsqrt) {
  */
 ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_arccos, 0, 0, 1)
 ZEND_ARG_INFO(0, array)
+ZEND_ARG_INFO(0, out)
 ZEND_END_ARG_INFO()
 PHP_METHOD(NumPower, arccos) {
     NDArray *rtn = NULL;
-    zval *array;
-    ZEND_PARSE_PARAMETERS_START(1, 1)
+    zval *array, *out = NULL;
+    ZEND_PARSE_PARAMETERS_START(1, 2)
     Z_PARAM_ZVAL(array)
+    Z_PARAM_OPTIONAL
+    Z_PARAM_OBJECT_OF_CLASS_OR_NULL(out, phpsci_ce_NDArray)
     ZEND_PARSE_PARAMETERS_END();
     NDArray *nda = ZVAL_TO_NDARRAY(array);
     if (nda == NULL) {
         return;
     }
 
-    if (NDArray_DEVICE(nda) == NDARRAY_DEVICE_CPU) {
+    if (out != NULL) {
+        rtn = NDArray_MapInto(nda, float_arccos, ZVAL_TO_NDARRAY(out));
+    } else if (NDArray_DEVICE(nda) == NDARRAY_DEVICE_CPU) {
         rtn = NDArray_Map(nda, float_arccos);
     } else {
 #ifdef HAVE_CUBLAS
@@ -1912,7 +2920,7 @@ PHP_METHOD(NumPower, arccos) {
     if (Z_TYPE_P(array) == IS_ARRAY) {
         NDArray_FREE(nda);
     }
-    RETURN_NDARRAY(rtn, return_value);
+    RETURN_NDARRAY_OUT(rtn, out, return_value);
 }
 
 /**
@@ -1923,19 +2931,24 @@ PHP_METHOD(NumPower, arccos) {
  */
 ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_arctan, 0, 0, 1)
 ZEND_ARG_INFO(0, array)
+ZEND_ARG_INFO(0, out)
 ZEND_END_ARG_INFO()
 PHP_METHOD(NumPower, arctan) {
     NDArray *rtn = NULL;
-    zval *array;
-    ZEND_PARSE_PARAMETERS_START(1, 1)
+    zval *array, *out = NULL;
+    ZEND_PARSE_PARAMETERS_START(1, 2)
     Z_PARAM_ZVAL(array)
+    Z_PARAM_OPTIONAL
+    Z_PARAM_OBJECT_OF_CLASS_OR_NULL(out, phpsci_ce_NDArray)
     ZEND_PARSE_PARAMETERS_END();
     NDArray *nda = ZVAL_TO_NDARRAY(array);
     if (nda == NULL) {
         return;
     }
 
-    if (NDArray_DEVICE(nda) == NDARRAY_DEVICE_CPU) {
+    if (out != NULL) {
+        rtn = NDArray_MapInto(nda, float_arctan, ZVAL_TO_NDARRAY(out));
+    } else if (NDArray_DEVICE(nda) == NDARRAY_DEVICE_CPU) {
         rtn = NDArray_Map(nda, float_arctan);
     } else {
 #ifdef HAVE_CUBLAS
@@ -1947,7 +2960,7 @@ PHP_METHOD(NumPower, arctan) {
     if (Z_TYPE_P(array) == IS_ARRAY) {
         NDArray_FREE(nda);
     }
-    RETURN_NDARRAY(rtn, return_value);
+    RETURN_NDARRAY_OUT(rtn, out, return_value);
 }
 
 /**
@@ -1995,19 +3008,24 @@ PHP_METHOD(NumPower, arctan2) {
  */
 ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_degrees, 0, 0, 1)
 ZEND_ARG_INFO(0, array)
+ZEND_ARG_INFO(0, out)
 ZEND_END_ARG_INFO()
 PHP_METHOD(NumPower, degrees) {
     NDArray *rtn = NULL;
-    zval *array;
-    ZEND_PARSE_PARAMETERS_START(1, 1)
+    zval *array, *out = NULL;
+    ZEND_PARSE_PARAMETERS_START(1, 2)
     Z_PARAM_ZVAL(array)
+    Z_PARAM_OPTIONAL
+    Z_PARAM_OBJECT_OF_CLASS_OR_NULL(out, phpsci_ce_NDArray)
     ZEND_PARSE_PARAMETERS_END();
     NDArray *nda = ZVAL_TO_NDARRAY(array);
     if (nda == NULL) {
         return;
     }
 
-    if (NDArray_DEVICE(nda) == NDARRAY_DEVICE_CPU) {
+    if (out != NULL) {
+        rtn = NDArray_MapInto(nda, float_degrees, ZVAL_TO_NDARRAY(out));
+    } else if (NDArray_DEVICE(nda) == NDARRAY_DEVICE_CPU) {
         rtn = NDArray_Map(nda, float_degrees);
     } else {
 #ifdef HAVE_CUBLAS
@@ -2019,7 +3037,7 @@ PHP_METHOD(NumPower, degrees) {
     if (Z_TYPE_P(array) == IS_ARRAY) {
         NDArray_FREE(nda);
     }
-    RETURN_NDARRAY(rtn, return_value);
+    RETURN_NDARRAY_OUT(rtn, out, return_value);
 }
 
 /**
@@ -2030,19 +3048,24 @@ PHP_METHOD(NumPower, degrees) {
  */
 ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_sinh, 0, 0, 1)
 ZEND_ARG_INFO(0, array)
+ZEND_ARG_INFO(0, out)
 ZEND_END_ARG_INFO()
 PHP_METHOD(NumPower, sinh) {
     NDArray *rtn = NULL;
-    zval *array;
-    ZEND_PARSE_PARAMETERS_START(1, 1)
+    zval *array, *out = NULL;
+    ZEND_PARSE_PARAMETERS_START(1, 2)
     Z_PARAM_ZVAL(array)
+    Z_PARAM_OPTIONAL
+    Z_PARAM_OBJECT_OF_CLASS_OR_NULL(out, phpsci_ce_NDArray)
     ZEND_PARSE_PARAMETERS_END();
     NDArray *nda = ZVAL_TO_NDARRAY(array);
     if (nda == NULL) {
         return;
     }
 
-    if (NDArray_DEVICE(nda) == NDARRAY_DEVICE_CPU) {
+    if (out != NULL) {
+        rtn = NDArray_MapInto(nda, float_sinh, ZVAL_TO_NDARRAY(out));
+    } else if (NDArray_DEVICE(nda) == NDARRAY_DEVICE_CPU) {
         rtn = NDArray_Map(nda, float_sinh);
     } else {
 #ifdef HAVE_CUBLAS
@@ -2054,7 +3077,7 @@ PHP_METHOD(NumPower, sinh) {
     if (Z_TYPE_P(array) == IS_ARRAY) {
         NDArray_FREE(nda);
     }
-    RETURN_NDARRAY(rtn, return_value);
+    RETURN_NDARRAY_OUT(rtn, out, return_value);
 }
 
 /**
@@ -2065,19 +3088,24 @@ PHP_METHOD(NumPower, sinh) {
  */
 ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_cosh, 0, 0, 1)
 ZEND_ARG_INFO(0, array)
+ZEND_ARG_INFO(0, out)
 ZEND_END_ARG_INFO()
 PHP_METHOD(NumPower, cosh) {
     NDArray *rtn = NULL;
-    zval *array;
-    ZEND_PARSE_PARAMETERS_START(1, 1)
+    zval *array, *out = NULL;
+    ZEND_PARSE_PARAMETERS_START(1, 2)
     Z_PARAM_ZVAL(array)
+    Z_PARAM_OPTIONAL
+    Z_PARAM_OBJECT_OF_CLASS_OR_NULL(out, phpsci_ce_NDArray)
     ZEND_PARSE_PARAMETERS_END();
     NDArray *nda = ZVAL_TO_NDARRAY(array);
     if (nda == NULL) {
         return;
     }
 
-    if (NDArray_DEVICE(nda) == NDARRAY_DEVICE_CPU) {
+    if (out != NULL) {
+        rtn = NDArray_MapInto(nda, float_cosh, ZVAL_TO_NDARRAY(out));
+    } else if (NDArray_DEVICE(nda) == NDARRAY_DEVICE_CPU) {
         rtn = NDArray_Map(nda, float_cosh);
     } else {
 #ifdef HAVE_CUBLAS
@@ -2089,7 +3117,7 @@ PHP_METHOD(NumPower, cosh) {
     if (Z_TYPE_P(array) == IS_ARRAY) {
         NDArray_FREE(nda);
     }
-    RETURN_NDARRAY(rtn, return_value);
+    RETURN_NDARRAY_OUT(rtn, out, return_value);
 }
 
 /**
@@ -2100,19 +3128,24 @@ PHP_METHOD(NumPower, cosh) {
  */
 ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_tanh, 0, 0, 1)
 ZEND_ARG_INFO(0, array)
+ZEND_ARG_INFO(0, out)
 ZEND_END_ARG_INFO()
 PHP_METHOD(NumPower, tanh) {
     NDArray *rtn = NULL;
-    zval *array;
-    ZEND_PARSE_PARAMETERS_START(1, 1)
+    zval *array, *out = NULL;
+    ZEND_PARSE_PARAMETERS_START(1, 2)
     Z_PARAM_ZVAL(array)
+    Z_PARAM_OPTIONAL
+    Z_PARAM_OBJECT_OF_CLASS_OR_NULL(out, phpsci_ce_NDArray)
     ZEND_PARSE_PARAMETERS_END();
     NDArray *nda = ZVAL_TO_NDARRAY(array);
     if (nda == NULL) {
         return;
     }
 
-    if (NDArray_DEVICE(nda) == NDARRAY_DEVICE_CPU) {
+    if (out != NULL) {
+        rtn = NDArray_MapInto(nda, float_tanh, ZVAL_TO_NDARRAY(out));
+    } else if (NDArray_DEVICE(nda) == NDARRAY_DEVICE_CPU) {
         rtn = NDArray_Map(nda, float_tanh);
     } else {
 #ifdef HAVE_CUBLAS
@@ -2124,7 +3157,7 @@ PHP_METHOD(NumPower, tanh) {
     if (Z_TYPE_P(array) == IS_ARRAY) {
         NDArray_FREE(nda);
     }
-    RETURN_NDARRAY(rtn, return_value);
+    RETURN_NDARRAY_OUT(rtn, out, return_value);
 }
 
 /**
@@ -2135,19 +3168,24 @@ PHP_METHOD(NumPower, tanh) {
  */
 ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_arcsinh, 0, 0, 1)
 ZEND_ARG_INFO(0, array)
+ZEND_ARG_INFO(0, out)
 ZEND_END_ARG_INFO()
 PHP_METHOD(NumPower, arcsinh) {
     NDArray *rtn = NULL;
-    zval *array;
-    ZEND_PARSE_PARAMETERS_START(1, 1)
+    zval *array, *out = NULL;
+    ZEND_PARSE_PARAMETERS_START(1, 2)
     Z_PARAM_ZVAL(array)
+    Z_PARAM_OPTIONAL
+    Z_PARAM_OBJECT_OF_CLASS_OR_NULL(out, phpsci_ce_NDArray)
     ZEND_PARSE_PARAMETERS_END();
     NDArray *nda = ZVAL_TO_NDARRAY(array);
     if (nda == NULL) {
         return;
     }
 
-    if (NDArray_DEVICE(nda) == NDARRAY_DEVICE_CPU) {
+    if (out != NULL) {
+        rtn = NDArray_MapInto(nda, float_arcsinh, ZVAL_TO_NDARRAY(out));
+    } else if (NDArray_DEVICE(nda) == NDARRAY_DEVICE_CPU) {
         rtn = NDArray_Map(nda, float_arcsinh);
     } else {
 #ifdef HAVE_CUBLAS
@@ -2159,7 +3197,7 @@ PHP_METHOD(NumPower, arcsinh) {
     if (Z_TYPE_P(array) == IS_ARRAY) {
         NDArray_FREE(nda);
     }
-    RETURN_NDARRAY(rtn, return_value);
+    RETURN_NDARRAY_OUT(rtn, out, return_value);
 }
 
 /**
@@ -2170,19 +3208,24 @@ PHP_METHOD(NumPower, arcsinh) {
  */
 ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_arccosh, 0, 0, 1)
 ZEND_ARG_INFO(0, array)
+ZEND_ARG_INFO(0, out)
 ZEND_END_ARG_INFO()
 PHP_METHOD(NumPower, arccosh) {
     NDArray *rtn = NULL;
-    zval *array;
-    ZEND_PARSE_PARAMETERS_START(1, 1)
+    zval *array, *out = NULL;
+    ZEND_PARSE_PARAMETERS_START(1, 2)
     Z_PARAM_ZVAL(array)
+    Z_PARAM_OPTIONAL
+    Z_PARAM_OBJECT_OF_CLASS_OR_NULL(out, phpsci_ce_NDArray)
     ZEND_PARSE_PARAMETERS_END();
     NDArray *nda = ZVAL_TO_NDARRAY(array);
     if (nda == NULL) {
         return;
     }
 
-    if (NDArray_DEVICE(nda) == NDARRAY_DEVICE_CPU) {
+    if (out != NULL) {
+        rtn = NDArray_MapInto(nda, float_arccosh, ZVAL_TO_NDARRAY(out));
+    } else if (NDArray_DEVICE(nda) == NDARRAY_DEVICE_CPU) {
         rtn = NDArray_Map(nda, float_arccosh);
     } else {
 #ifdef HAVE_CUBLAS
@@ -2194,7 +3237,7 @@ PHP_METHOD(NumPower, arccosh) {
     if (Z_TYPE_P(array) == IS_ARRAY) {
         NDArray_FREE(nda);
     }
-    RETURN_NDARRAY(rtn, return_value);
+    RETURN_NDARRAY_OUT(rtn, out, return_value);
 }
 
 /**
@@ -2228,19 +3271,24 @@ PHP_METHOD(NumPower, fromImage) {
  */
 ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_arctanh, 0, 0, 1)
 ZEND_ARG_INFO(0, array)
+ZEND_ARG_INFO(0, out)
 ZEND_END_ARG_INFO()
 PHP_METHOD(NumPower, arctanh) {
     NDArray *rtn = NULL;
-    zval *array;
-    ZEND_PARSE_PARAMETERS_START(1, 1)
+    zval *array, *out = NULL;
+    ZEND_PARSE_PARAMETERS_START(1, 2)
     Z_PARAM_ZVAL(array)
+    Z_PARAM_OPTIONAL
+    Z_PARAM_OBJECT_OF_CLASS_OR_NULL(out, phpsci_ce_NDArray)
     ZEND_PARSE_PARAMETERS_END();
     NDArray *nda = ZVAL_TO_NDARRAY(array);
     if (nda == NULL) {
         return;
     }
 
-    if (NDArray_DEVICE(nda) == NDARRAY_DEVICE_CPU) {
+    if (out != NULL) {
+        rtn = NDArray_MapInto(nda, float_arctanh, ZVAL_TO_NDARRAY(out));
+    } else if (NDArray_DEVICE(nda) == NDARRAY_DEVICE_CPU) {
         rtn = NDArray_Map(nda, float_arctanh);
     } else {
 #ifdef HAVE_CUBLAS
@@ -2252,7 +3300,7 @@ PHP_METHOD(NumPower, arctanh) {
     if (Z_TYPE_P(array) == IS_ARRAY) {
         NDArray_FREE(nda);
     }
-    RETURN_NDARRAY(rtn, return_value);
+    RETURN_NDARRAY_OUT(rtn, out, return_value);
 }
 
 /**
@@ -2263,19 +3311,24 @@ PHP_METHOD(NumPower, arctanh) {
  */
 ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_rint, 0, 0, 1)
 ZEND_ARG_INFO(0, array)
+ZEND_ARG_INFO(0, out)
 ZEND_END_ARG_INFO()
 PHP_METHOD(NumPower, rint) {
     NDArray *rtn = NULL;
-    zval *array;
-    ZEND_PARSE_PARAMETERS_START(1, 1)
+    zval *array, *out = NULL;
+    ZEND_PARSE_PARAMETERS_START(1, 2)
     Z_PARAM_ZVAL(array)
+    Z_PARAM_OPTIONAL
+    Z_PARAM_OBJECT_OF_CLASS_OR_NULL(out, phpsci_ce_NDArray)
     ZEND_PARSE_PARAMETERS_END();
     NDArray *nda = ZVAL_TO_NDARRAY(array);
     if (nda == NULL) {
         return;
     }
 
-    if (NDArray_DEVICE(nda) == NDARRAY_DEVICE_CPU) {
+    if (out != NULL) {
+        rtn = NDArray_MapInto(nda, float_rint, ZVAL_TO_NDARRAY(out));
+    } else if (NDArray_DEVICE(nda) == NDARRAY_DEVICE_CPU) {
         rtn = NDArray_Map(nda, float_rint);
     } else {
 #ifdef HAVE_CUBLAS
@@ -2287,7 +3340,7 @@ PHP_METHOD(NumPower, rint) {
     if (Z_TYPE_P(array) == IS_ARRAY) {
         NDArray_FREE(nda);
     }
-    RETURN_NDARRAY(rtn, return_value);
+    RETURN_NDARRAY_OUT(rtn, out, return_value);
 }
 
 /**
@@ -2298,19 +3351,24 @@ PHP_METHOD(NumPower, rint) {
  */
 ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_fix, 0, 0, 1)
 ZEND_ARG_INFO(0, array)
+ZEND_ARG_INFO(0, out)
 ZEND_END_ARG_INFO()
 PHP_METHOD(NumPower, fix) {
     NDArray *rtn = NULL;
-    zval *array;
-    ZEND_PARSE_PARAMETERS_START(1, 1)
+    zval *array, *out = NULL;
+    ZEND_PARSE_PARAMETERS_START(1, 2)
     Z_PARAM_ZVAL(array)
+    Z_PARAM_OPTIONAL
+    Z_PARAM_OBJECT_OF_CLASS_OR_NULL(out, phpsci_ce_NDArray)
     ZEND_PARSE_PARAMETERS_END();
     NDArray *nda = ZVAL_TO_NDARRAY(array);
     if (nda == NULL) {
         return;
     }
 
-    if (NDArray_DEVICE(nda) == NDARRAY_DEVICE_CPU) {
+    if (out != NULL) {
+        rtn = NDArray_MapInto(nda, float_fix, ZVAL_TO_NDARRAY(out));
+    } else if (NDArray_DEVICE(nda) == NDARRAY_DEVICE_CPU) {
         rtn = NDArray_Map(nda, float_fix);
     } else {
 #ifdef HAVE_CUBLAS
@@ -2322,7 +3380,7 @@ PHP_METHOD(NumPower, fix) {
     if (Z_TYPE_P(array) == IS_ARRAY) {
         NDArray_FREE(nda);
     }
-    RETURN_NDARRAY(rtn, return_value);
+    RETURN_NDARRAY_OUT(rtn, out, return_value);
 }
 
 /**
@@ -2333,19 +3391,24 @@ PHP_METHOD(NumPower, fix) {
  */
 ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_trunc, 0, 0, 1)
 ZEND_ARG_INFO(0, array)
+ZEND_ARG_INFO(0, out)
 ZEND_END_ARG_INFO()
 PHP_METHOD(NumPower, trunc) {
     NDArray *rtn = NULL;
-    zval *array;
-    ZEND_PARSE_PARAMETERS_START(1, 1)
+    zval *array, *out = NULL;
+    ZEND_PARSE_PARAMETERS_START(1, 2)
     Z_PARAM_ZVAL(array)
+    Z_PARAM_OPTIONAL
+    Z_PARAM_OBJECT_OF_CLASS_OR_NULL(out, phpsci_ce_NDArray)
     ZEND_PARSE_PARAMETERS_END();
     NDArray *nda = ZVAL_TO_NDARRAY(array);
     if (nda == NULL) {
         return;
     }
 
-    if (NDArray_DEVICE(nda) == NDARRAY_DEVICE_CPU) {
+    if (out != NULL) {
+        rtn = NDArray_MapInto(nda, float_trunc, ZVAL_TO_NDARRAY(out));
+    } else if (NDArray_DEVICE(nda) == NDARRAY_DEVICE_CPU) {
         rtn = NDArray_Map(nda, float_trunc);
     } else {
 #ifdef HAVE_CUBLAS
@@ -2357,7 +3420,7 @@ PHP_METHOD(NumPower, trunc) {
     if (Z_TYPE_P(array) == IS_ARRAY) {
         NDArray_FREE(nda);
     }
-    RETURN_NDARRAY(rtn, return_value);
+    RETURN_NDARRAY_OUT(rtn, out, return_value);
 }
 
 /**
@@ -2368,19 +3431,24 @@ PHP_METHOD(NumPower, trunc) {
  */
 ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_sinc, 0, 0, 1)
 ZEND_ARG_INFO(0, array)
+ZEND_ARG_INFO(0, out)
 ZEND_END_ARG_INFO()
 PHP_METHOD(NumPower, sinc) {
     NDArray *rtn = NULL;
-    zval *array;
-    ZEND_PARSE_PARAMETERS_START(1, 1)
+    zval *array, *out = NULL;
+    ZEND_PARSE_PARAMETERS_START(1, 2)
     Z_PARAM_ZVAL(array)
+    Z_PARAM_OPTIONAL
+    Z_PARAM_OBJECT_OF_CLASS_OR_NULL(out, phpsci_ce_NDArray)
     ZEND_PARSE_PARAMETERS_END();
     NDArray *nda = ZVAL_TO_NDARRAY(array);
     if (nda == NULL) {
         return;
     }
 
-    if (NDArray_DEVICE(nda) == NDARRAY_DEVICE_CPU) {
+    if (out != NULL) {
+        rtn = NDArray_MapInto(nda, float_sinc, ZVAL_TO_NDARRAY(out));
+    } else if (NDArray_DEVICE(nda) == NDARRAY_DEVICE_CPU) {
         rtn = NDArray_Map(nda, float_sinc);
     } else {
 #ifdef HAVE_CUBLAS
@@ -2392,7 +3460,7 @@ PHP_METHOD(NumPower, sinc) {
     if (Z_TYPE_P(array) == IS_ARRAY) {
         NDArray_FREE(nda);
     }
-    RETURN_NDARRAY(rtn, return_value);
+    RETURN_NDARRAY_OUT(rtn, out, return_value);
 }
 
 /**
@@ -2403,19 +3471,24 @@ PHP_METHOD(NumPower, sinc) {
  */
 ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_negative, 0, 0, 1)
 ZEND_ARG_INFO(0, array)
+ZEND_ARG_INFO(0, out)
 ZEND_END_ARG_INFO()
 PHP_METHOD(NumPower, negative) {
     NDArray *rtn = NULL;
-    zval *array;
-    ZEND_PARSE_PARAMETERS_START(1, 1)
+    zval *array, *out = NULL;
+    ZEND_PARSE_PARAMETERS_START(1, 2)
     Z_PARAM_ZVAL(array)
+    Z_PARAM_OPTIONAL
+    Z_PARAM_OBJECT_OF_CLASS_OR_NULL(out, phpsci_ce_NDArray)
     ZEND_PARSE_PARAMETERS_END();
     NDArray *nda = ZVAL_TO_NDARRAY(array);
     if (nda == NULL) {
         return;
     }
 
-    if (NDArray_DEVICE(nda) == NDARRAY_DEVICE_CPU) {
+    if (out != NULL) {
+        rtn = NDArray_MapInto(nda, float_negate, ZVAL_TO_NDARRAY(out));
+    } else if (NDArray_DEVICE(nda) == NDARRAY_DEVICE_CPU) {
         rtn = NDArray_Map(nda, float_negate);
     } else {
 #ifdef HAVE_CUBLAS
@@ -2427,7 +3500,7 @@ PHP_METHOD(NumPower, negative) {
     if (Z_TYPE_P(array) == IS_ARRAY) {
         NDArray_FREE(nda);
     }
-    RETURN_NDARRAY(rtn, return_value);
+    RETURN_NDARRAY_OUT(rtn, out, return_value);
 }
 
 /**
@@ -2438,19 +3511,24 @@ PHP_METHOD(NumPower, negative) {
  */
 ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_positive, 0, 0, 1)
     ZEND_ARG_INFO(0, array)
+    ZEND_ARG_INFO(0, out)
 ZEND_END_ARG_INFO()
 PHP_METHOD(NumPower, positive) {
     NDArray *rtn = NULL;
-    zval *array;
-    ZEND_PARSE_PARAMETERS_START(1, 1)
+    zval *array, *out = NULL;
+    ZEND_PARSE_PARAMETERS_START(1, 2)
         Z_PARAM_ZVAL(array)
+        Z_PARAM_OPTIONAL
+        Z_PARAM_OBJECT_OF_CLASS_OR_NULL(out, phpsci_ce_NDArray)
     ZEND_PARSE_PARAMETERS_END();
     NDArray *nda = ZVAL_TO_NDARRAY(array);
     if (nda == NULL) {
         return;
     }
 
-    if (NDArray_DEVICE(nda) == NDARRAY_DEVICE_CPU) {
+    if (out != NULL) {
+        rtn = NDArray_MapInto(nda, float_positive, ZVAL_TO_NDARRAY(out));
+    } else if (NDArray_DEVICE(nda) == NDARRAY_DEVICE_CPU) {
         rtn = NDArray_Map(nda, float_positive);
     } else {
 #ifdef HAVE_CUBLAS
@@ -2462,7 +3540,7 @@ PHP_METHOD(NumPower, positive) {
     if (Z_TYPE_P(array) == IS_ARRAY) {
         NDArray_FREE(nda);
     }
-    RETURN_NDARRAY(rtn, return_value);
+    RETURN_NDARRAY_OUT(rtn, out, return_value);
 }
 
 /**
@@ -2473,19 +3551,24 @@ PHP_METHOD(NumPower, positive) {
  */
 ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_reciprocal, 0, 0, 1)
     ZEND_ARG_INFO(0, array)
+    ZEND_ARG_INFO(0, out)
 ZEND_END_ARG_INFO()
 PHP_METHOD(NumPower, reciprocal) {
     NDArray *rtn = NULL;
-    zval *array;
-    ZEND_PARSE_PARAMETERS_START(1, 1)
+    zval *array, *out = NULL;
+    ZEND_PARSE_PARAMETERS_START(1, 2)
         Z_PARAM_ZVAL(array)
+        Z_PARAM_OPTIONAL
+        Z_PARAM_OBJECT_OF_CLASS_OR_NULL(out, phpsci_ce_NDArray)
     ZEND_PARSE_PARAMETERS_END();
     NDArray *nda = ZVAL_TO_NDARRAY(array);
     if (nda == NULL) {
         return;
     }
 
-    if (NDArray_DEVICE(nda) == NDARRAY_DEVICE_CPU) {
+    if (out != NULL) {
+        rtn = NDArray_MapInto(nda, float_reciprocal, ZVAL_TO_NDARRAY(out));
+    } else if (NDArray_DEVICE(nda) == NDARRAY_DEVICE_CPU) {
         rtn = NDArray_Map(nda, float_reciprocal);
     } else {
 #ifdef HAVE_CUBLAS
@@ -2497,7 +3580,7 @@ PHP_METHOD(NumPower, reciprocal) {
     if (Z_TYPE_P(array) == IS_ARRAY) {
         NDArray_FREE(nda);
     }
-    RETURN_NDARRAY(rtn, return_value);
+    RETURN_NDARRAY_OUT(rtn, out, return_value);
 }
 
 
@@ -2509,19 +3592,24 @@ PHP_METHOD(NumPower, reciprocal) {
  */
 ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_sign, 0, 0, 1)
 ZEND_ARG_INFO(0, array)
+ZEND_ARG_INFO(0, out)
 ZEND_END_ARG_INFO()
 PHP_METHOD(NumPower, sign) {
     NDArray *rtn = NULL;
-    zval *array;
-    ZEND_PARSE_PARAMETERS_START(1, 1)
+    zval *array, *out = NULL;
+    ZEND_PARSE_PARAMETERS_START(1, 2)
     Z_PARAM_ZVAL(array)
+    Z_PARAM_OPTIONAL
+    Z_PARAM_OBJECT_OF_CLASS_OR_NULL(out, phpsci_ce_NDArray)
     ZEND_PARSE_PARAMETERS_END();
     NDArray *nda = ZVAL_TO_NDARRAY(array);
     if (nda == NULL) {
         return;
     }
 
-    if (NDArray_DEVICE(nda) == NDARRAY_DEVICE_CPU) {
+    if (out != NULL) {
+        rtn = NDArray_MapInto(nda, float_sign, ZVAL_TO_NDARRAY(out));
+    } else if (NDArray_DEVICE(nda) == NDARRAY_DEVICE_CPU) {
         rtn = NDArray_Map(nda, float_sign);
     } else {
 #ifdef HAVE_CUBLAS
@@ -2533,7 +3621,7 @@ PHP_METHOD(NumPower, sign) {
     if (Z_TYPE_P(array) == IS_ARRAY) {
         NDArray_FREE(nda);
     }
-    RETURN_NDARRAY(rtn, return_value);
+    RETURN_NDARRAY_OUT(rtn, out, return_value);
 }
 
 /**
@@ -2710,6 +3798,125 @@ PHP_METHOD(NumPower, argmin) {
     RETURN_NDARRAY(rtn, return_value);
 }
 
+/**
+ * NumPower::cumsum
+ *
+ * @param execute_data
+ * @param return_value
+ */
+ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_cumsum, 0, 0, 1)
+    ZEND_ARG_INFO(0, a)
+    ZEND_ARG_INFO(0, axis)
+ZEND_END_ARG_INFO()
+PHP_METHOD(NumPower, cumsum) {
+    NDArray *rtn = NULL;
+    zval *a;
+    zend_long axis = NDARRAY_MAX_DIMS;
+    bool axis_is_null = true;
+    ZEND_PARSE_PARAMETERS_START(1, 2)
+        Z_PARAM_ZVAL(a)
+        Z_PARAM_OPTIONAL
+        Z_PARAM_LONG_OR_NULL(axis, axis_is_null)
+    ZEND_PARSE_PARAMETERS_END();
+    NDArray *nda = ZVAL_TO_NDARRAY(a);
+    if (nda == NULL) {
+        return;
+    }
+    rtn = NDArray_CumSum(nda, axis_is_null ? NDARRAY_MAX_DIMS : (int)axis);
+    CHECK_INPUT_AND_FREE(a, nda);
+    RETURN_NDARRAY(rtn, return_value);
+}
+
+/**
+ * NumPower::cumprod
+ *
+ * @param execute_data
+ * @param return_value
+ */
+ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_cumprod, 0, 0, 1)
+    ZEND_ARG_INFO(0, a)
+    ZEND_ARG_INFO(0, axis)
+ZEND_END_ARG_INFO()
+PHP_METHOD(NumPower, cumprod) {
+    NDArray *rtn = NULL;
+    zval *a;
+    zend_long axis = NDARRAY_MAX_DIMS;
+    bool axis_is_null = true;
+    ZEND_PARSE_PARAMETERS_START(1, 2)
+        Z_PARAM_ZVAL(a)
+        Z_PARAM_OPTIONAL
+        Z_PARAM_LONG_OR_NULL(axis, axis_is_null)
+    ZEND_PARSE_PARAMETERS_END();
+    NDArray *nda = ZVAL_TO_NDARRAY(a);
+    if (nda == NULL) {
+        return;
+    }
+    rtn = NDArray_CumProd(nda, axis_is_null ? NDARRAY_MAX_DIMS : (int)axis);
+    CHECK_INPUT_AND_FREE(a, nda);
+    RETURN_NDARRAY(rtn, return_value);
+}
+
+/**
+ * NumPower::cummax
+ *
+ * @param execute_data
+ * @param return_value
+ */
+ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_cummax, 0, 0, 1)
+    ZEND_ARG_INFO(0, a)
+    ZEND_ARG_INFO(0, axis)
+ZEND_END_ARG_INFO()
+PHP_METHOD(NumPower, cummax) {
+    NDArray *rtn = NULL;
+    zval *a;
+    zend_long axis = NDARRAY_MAX_DIMS;
+    bool axis_is_null = true;
+    ZEND_PARSE_PARAMETERS_START(1, 2)
+        Z_PARAM_ZVAL(a)
+        Z_PARAM_OPTIONAL
+        Z_PARAM_LONG_OR_NULL(axis, axis_is_null)
+    ZEND_PARSE_PARAMETERS_END();
+    NDArray *nda = ZVAL_TO_NDARRAY(a);
+    if (nda == NULL) {
+        return;
+    }
+    rtn = NDArray_CumMax(nda, axis_is_null ? NDARRAY_MAX_DIMS : (int)axis);
+    CHECK_INPUT_AND_FREE(a, nda);
+    RETURN_NDARRAY(rtn, return_value);
+}
+
+/**
+ * NumPower::diff
+ *
+ * @param execute_data
+ * @param return_value
+ */
+ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_diff, 0, 0, 1)
+    ZEND_ARG_INFO(0, a)
+    ZEND_ARG_INFO(0, n)
+    ZEND_ARG_INFO(0, axis)
+ZEND_END_ARG_INFO()
+PHP_METHOD(NumPower, diff) {
+    NDArray *rtn = NULL;
+    zval *a;
+    zend_long n = 1;
+    zend_long axis = -1;
+    bool axis_is_null = false;
+    ZEND_PARSE_PARAMETERS_START(1, 3)
+        Z_PARAM_ZVAL(a)
+        Z_PARAM_OPTIONAL
+        Z_PARAM_LONG(n)
+        Z_PARAM_LONG_OR_NULL(axis, axis_is_null)
+    ZEND_PARSE_PARAMETERS_END();
+    NDArray *nda = ZVAL_TO_NDARRAY(a);
+    if (nda == NULL) {
+        return;
+    }
+    rtn = NDArray_Diff(nda, (int)n, axis_is_null ? NDARRAY_MAX_DIMS : (int)axis);
+    CHECK_INPUT_AND_FREE(a, nda);
+    RETURN_NDARRAY(rtn, return_value);
+}
+
 /**
  * NumPower::mean
  *
@@ -2738,7 +3945,7 @@ PHP_METHOD(NumPower, mean) {
 
     if (NDArray_DEVICE(nda) == NDARRAY_DEVICE_CPU) {
         if (ZEND_NUM_ARGS() == 1) {
-            RETURN_DOUBLE((NDArray_Sum_Float(nda) / NDArray_NUMELEMENTS(nda)));
+            RETURN_DOUBLE((NDArray_Sum(nda) / NDArray_NUMELEMENTS(nda)));
         } else {
             NDArray *sum = reduce(nda, &i_axis, NDArray_Add_Float);
             if (sum == NULL) {
@@ -2892,6 +4099,132 @@ PHP_METHOD(NumPower, quantile) {
     RETURN_NDARRAY(rtn, return_value);
 }
 
+/**
+ * NumPower::sort
+ *
+ * @param execute_data
+ * @param return_value
+ */
+ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_sort, 0, 0, 1)
+ZEND_ARG_INFO(0, a)
+ZEND_ARG_INFO(0, axis)
+ZEND_END_ARG_INFO()
+PHP_METHOD(NumPower, sort) {
+    NDArray *rtn = NULL;
+    zval *a;
+    zend_long axis = -1;
+    bool axis_is_null = false;
+    ZEND_PARSE_PARAMETERS_START(1, 2)
+        Z_PARAM_ZVAL(a)
+        Z_PARAM_OPTIONAL
+        Z_PARAM_LONG_OR_NULL(axis, axis_is_null)
+    ZEND_PARSE_PARAMETERS_END();
+    NDArray *nda = ZVAL_TO_NDARRAY(a);
+    if (nda == NULL) {
+        return;
+    }
+    rtn = NDArray_Sort(nda, axis_is_null ? NDARRAY_MAX_DIMS : (int)axis);
+    CHECK_INPUT_AND_FREE(a, nda);
+    RETURN_NDARRAY(rtn, return_value);
+}
+
+/**
+ * NumPower::argsort
+ *
+ * @param execute_data
+ * @param return_value
+ */
+ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_argsort, 0, 0, 1)
+ZEND_ARG_INFO(0, a)
+ZEND_ARG_INFO(0, axis)
+ZEND_END_ARG_INFO()
+PHP_METHOD(NumPower, argsort) {
+    NDArray *rtn = NULL;
+    zval *a;
+    zend_long axis = -1;
+    bool axis_is_null = false;
+    ZEND_PARSE_PARAMETERS_START(1, 2)
+        Z_PARAM_ZVAL(a)
+        Z_PARAM_OPTIONAL
+        Z_PARAM_LONG_OR_NULL(axis, axis_is_null)
+    ZEND_PARSE_PARAMETERS_END();
+    NDArray *nda = ZVAL_TO_NDARRAY(a);
+    if (nda == NULL) {
+        return;
+    }
+    rtn = NDArray_ArgSort(nda, axis_is_null ? NDARRAY_MAX_DIMS : (int)axis);
+    CHECK_INPUT_AND_FREE(a, nda);
+    RETURN_NDARRAY(rtn, return_value);
+}
+
+/**
+ * NumPower::partition
+ *
+ * @param execute_data
+ * @param return_value
+ */
+ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_partition, 0, 0, 2)
+ZEND_ARG_INFO(0, a)
+ZEND_ARG_INFO(0, kth)
+ZEND_ARG_INFO(0, axis)
+ZEND_END_ARG_INFO()
+PHP_METHOD(NumPower, partition) {
+    NDArray *rtn = NULL;
+    zval *a;
+    zend_long kth;
+    zend_long axis = -1;
+    bool axis_is_null = false;
+    ZEND_PARSE_PARAMETERS_START(2, 3)
+        Z_PARAM_ZVAL(a)
+        Z_PARAM_LONG(kth)
+        Z_PARAM_OPTIONAL
+        Z_PARAM_LONG_OR_NULL(axis, axis_is_null)
+    ZEND_PARSE_PARAMETERS_END();
+    NDArray *nda = ZVAL_TO_NDARRAY(a);
+    if (nda == NULL) {
+        return;
+    }
+    rtn = NDArray_Partition(nda, (long)kth, axis_is_null ? NDARRAY_MAX_DIMS : (int)axis);
+    CHECK_INPUT_AND_FREE(a, nda);
+    RETURN_NDARRAY(rtn, return_value);
+}
+
+/**
+ * NumPower::topk
+ *
+ * @param execute_data
+ * @param return_value
+ */
+ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_topk, 0, 0, 2)
+ZEND_ARG_INFO(0, a)
+ZEND_ARG_INFO(0, k)
+ZEND_ARG_INFO(0, axis)
+ZEND_END_ARG_INFO()
+PHP_METHOD(NumPower, topk) {
+    NDArray **rtn = NULL;
+    zval *a;
+    zend_long k;
+    zend_long axis = -1;
+    bool axis_is_null = false;
+    ZEND_PARSE_PARAMETERS_START(2, 3)
+        Z_PARAM_ZVAL(a)
+        Z_PARAM_LONG(k)
+        Z_PARAM_OPTIONAL
+        Z_PARAM_LONG_OR_NULL(axis, axis_is_null)
+    ZEND_PARSE_PARAMETERS_END();
+    NDArray *nda = ZVAL_TO_NDARRAY(a);
+    if (nda == NULL) {
+        return;
+    }
+    rtn = NDArray_TopK(nda, (long)k, axis_is_null ? NDARRAY_MAX_DIMS : (int)axis);
+    CHECK_INPUT_AND_FREE(a, nda);
+    if (rtn == NULL) {
+        return;
+    }
+    RETURN_2NDARRAY(rtn[0], rtn[1], return_value);
+    efree(rtn);
+}
+
 /**
  * NumPower::std
  *
@@ -2983,19 +4316,24 @@ PHP_METHOD(NumPower, variance) {
  */
 ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_ceil, 0, 0, 1)
 ZEND_ARG_INFO(0, array)
+ZEND_ARG_INFO(0, out)
 ZEND_END_ARG_INFO()
 PHP_METHOD(NumPower, ceil) {
     NDArray *rtn = NULL;
-    zval *array;
-    ZEND_PARSE_PARAMETERS_START(1, 1)
+    zval *array, *out = NULL;
+    ZEND_PARSE_PARAMETERS_START(1, 2)
     Z_PARAM_ZVAL(array)
+    Z_PARAM_OPTIONAL
+    Z_PARAM_OBJECT_OF_CLASS_OR_NULL(out, phpsci_ce_NDArray)
     ZEND_PARSE_PARAMETERS_END();
     NDArray *nda = ZVAL_TO_NDARRAY(array);
     if (nda == NULL) {
         return;
     }
 
-    if (NDArray_DEVICE(nda) == NDARRAY_DEVICE_CPU) {
+    if (out != NULL) {
+        rtn = NDArray_MapInto(nda, float_ceil, ZVAL_TO_NDARRAY(out));
+    } else if (NDArray_DEVICE(nda) == NDARRAY_DEVICE_CPU) {
         rtn = NDArray_Map(nda, float_ceil);
     } else {
 #ifdef HAVE_CUBLAS
@@ -3007,7 +4345,7 @@ PHP_METHOD(NumPower, ceil) {
     if (Z_TYPE_P(array) == IS_ARRAY) {
         NDArray_FREE(nda);
     }
-    RETURN_NDARRAY(rtn, return_value);
+    RETURN_NDARRAY_OUT(rtn, out, return_value);
 }
 
 /**
@@ -3056,19 +4394,24 @@ PHP_METHOD(NumPower, round) {
  */
 ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_floor, 0, 0, 1)
 ZEND_ARG_INFO(0, array)
+ZEND_ARG_INFO(0, out)
 ZEND_END_ARG_INFO()
 PHP_METHOD(NumPower, floor) {
     NDArray *rtn = NULL;
-    zval *array;
-    ZEND_PARSE_PARAMETERS_START(1, 1)
+    zval *array, *out = NULL;
+    ZEND_PARSE_PARAMETERS_START(1, 2)
     Z_PARAM_ZVAL(array)
+    Z_PARAM_OPTIONAL
+    Z_PARAM_OBJECT_OF_CLASS_OR_NULL(out, phpsci_ce_NDArray)
     ZEND_PARSE_PARAMETERS_END();
     NDArray *nda = ZVAL_TO_NDARRAY(array);
     if (nda == NULL) {
         return;
     }
 
-    if (NDArray_DEVICE(nda) == NDARRAY_DEVICE_CPU) {
+    if (out != NULL) {
+        rtn = NDArray_MapInto(nda, float_floor, ZVAL_TO_NDARRAY(out));
+    } else if (NDArray_DEVICE(nda) == NDARRAY_DEVICE_CPU) {
         rtn = NDArray_Map(nda, float_floor);
     } else {
 #ifdef HAVE_CUBLAS
@@ -3080,7 +4423,7 @@ PHP_METHOD(NumPower, floor) {
     if (Z_TYPE_P(array) == IS_ARRAY) {
         NDArray_FREE(nda);
     }
-    RETURN_NDARRAY(rtn, return_value);
+    RETURN_NDARRAY_OUT(rtn, out, return_value);
 }
 
 /**
@@ -3091,19 +4434,24 @@ PHP_METHOD(NumPower, floor) {
  */
 ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_radians, 0, 0, 1)
 ZEND_ARG_INFO(0, array)
+ZEND_ARG_INFO(0, out)
 ZEND_END_ARG_INFO()
 PHP_METHOD(NumPower, radians) {
     NDArray *rtn = NULL;
-    zval *array;
-    ZEND_PARSE_PARAMETERS_START(1, 1)
+    zval *array, *out = NULL;
+    ZEND_PARSE_PARAMETERS_START(1, 2)
     Z_PARAM_ZVAL(array)
+    Z_PARAM_OPTIONAL
+    Z_PARAM_OBJECT_OF_CLASS_OR_NULL(out, phpsci_ce_NDArray)
     ZEND_PARSE_PARAMETERS_END();
     NDArray *nda = ZVAL_TO_NDARRAY(array);
     if (nda == NULL) {
         return;
     }
 
-    if (NDArray_DEVICE(nda) == NDARRAY_DEVICE_CPU) {
+    if (out != NULL) {
+        rtn = NDArray_MapInto(nda, float_radians, ZVAL_TO_NDARRAY(out));
+    } else if (NDArray_DEVICE(nda) == NDARRAY_DEVICE_CPU) {
         rtn = NDArray_Map(nda, float_radians);
     } else {
 #ifdef HAVE_CUBLAS
@@ -3115,7 +4463,7 @@ PHP_METHOD(NumPower, radians) {
     if (Z_TYPE_P(array) == IS_ARRAY) {
         NDArray_FREE(nda);
     }
-    RETURN_NDARRAY(rtn, return_value);
+    RETURN_NDARRAY_OUT(rtn, out, return_value);
 }
 
 /**
@@ -3126,18 +4474,23 @@ PHP_METHOD(NumPower, radians) {
  */
 ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_sqrt, 0, 0, 1)
 ZEND_ARG_INFO(0, array)
+ZEND_ARG_INFO(0, out)
 ZEND_END_ARG_INFO()
 PHP_METHOD(NumPower, sqrt) {
     NDArray *rtn = NULL;
-    zval *array;
-    ZEND_PARSE_PARAMETERS_START(1, 1)
+    zval *array, *out = NULL;
+    ZEND_PARSE_PARAMETERS_START(1, 2)
     Z_PARAM_ZVAL(array)
+    Z_PARAM_OPTIONAL
+    Z_PARAM_OBJECT_OF_CLASS_OR_NULL(out, phpsci_ce_NDArray)
     ZEND_PARSE_PARAMETERS_END();
     NDArray *nda = ZVAL_TO_NDARRAY(array);
     if (nda == NULL) {
         return;
     }
-    if (NDArray_DEVICE(nda) == NDARRAY_DEVICE_CPU) {
+    if (out != NULL) {
+        rtn = NDArray_MapInto(nda, float_sqrt, ZVAL_TO_NDARRAY(out));
+    } else if (NDArray_DEVICE(nda) == NDARRAY_DEVICE_CPU) {
         rtn = NDArray_Map(nda, float_sqrt);
     } else {
 #ifdef HAVE_CUBLAS
@@ -3149,7 +4502,7 @@ PHP_METHOD(NumPower, sqrt) {
     if (Z_TYPE_P(array) == IS_ARRAY) {
         NDArray_FREE(nda);
     }
-    RETURN_NDARRAY(rtn, return_value);
+    RETURN_NDARRAY_OUT(rtn, out, return_value);
 }
 
 /**
@@ -3186,18 +4539,23 @@ PHP_METHOD(NumPower, square) {
  */
 ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_exp, 0, 0, 1)
 ZEND_ARG_INFO(0, array)
+ZEND_ARG_INFO(0, out)
 ZEND_END_ARG_INFO()
 PHP_METHOD(NumPower, exp) {
     NDArray *rtn = NULL;
-    zval *array;
-    ZEND_PARSE_PARAMETERS_START(1, 1)
+    zval *array, *out = NULL;
+    ZEND_PARSE_PARAMETERS_START(1, 2)
     Z_PARAM_ZVAL(array)
+    Z_PARAM_OPTIONAL
+    Z_PARAM_OBJECT_OF_CLASS_OR_NULL(out, phpsci_ce_NDArray)
     ZEND_PARSE_PARAMETERS_END();
     NDArray *nda = ZVAL_TO_NDARRAY(array);
     if (nda == NULL) {
         return;
     }
-    if (NDArray_DEVICE(nda) == NDARRAY_DEVICE_CPU) {
+    if (out != NULL) {
+        rtn = NDArray_MapInto(nda, float_exp, ZVAL_TO_NDARRAY(out));
+    } else if (NDArray_DEVICE(nda) == NDARRAY_DEVICE_CPU) {
         rtn = NDArray_Map(nda, float_exp);
     } else {
 #ifdef HAVE_CUBLAS
@@ -3209,7 +4567,7 @@ PHP_METHOD(NumPower, exp) {
     if (Z_TYPE_P(array) == IS_ARRAY) {
         NDArray_FREE(nda);
     }
-    RETURN_NDARRAY(rtn, return_value);
+    RETURN_NDARRAY_OUT(rtn, out, return_value);
 }
 
 /**
@@ -3220,22 +4578,29 @@ PHP_METHOD(NumPower, exp) {
  */
 ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_exp2, 0, 0, 1)
 ZEND_ARG_INFO(0, array)
+ZEND_ARG_INFO(0, out)
 ZEND_END_ARG_INFO()
 PHP_METHOD(NumPower, exp2) {
     NDArray *rtn = NULL;
-    zval *array;
-    ZEND_PARSE_PARAMETERS_START(1, 1)
+    zval *array, *out = NULL;
+    ZEND_PARSE_PARAMETERS_START(1, 2)
     Z_PARAM_ZVAL(array)
+    Z_PARAM_OPTIONAL
+    Z_PARAM_OBJECT_OF_CLASS_OR_NULL(out, phpsci_ce_NDArray)
     ZEND_PARSE_PARAMETERS_END();
     NDArray *nda = ZVAL_TO_NDARRAY(array);
     if (nda == NULL) {
         return;
     }
-    rtn = NDArray_Map(nda, float_exp2);
+    if (out != NULL) {
+        rtn = NDArray_MapInto(nda, float_exp2, ZVAL_TO_NDARRAY(out));
+    } else {
+        rtn = NDArray_Map(nda, float_exp2);
+    }
     if (Z_TYPE_P(array) == IS_ARRAY) {
         NDArray_FREE(nda);
     }
-    RETURN_NDARRAY(rtn, return_value);
+    RETURN_NDARRAY_OUT(rtn, out, return_value);
 }
 
 /**
@@ -3246,19 +4611,24 @@ PHP_METHOD(NumPower, exp2) {
  */
 ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_expm1, 0, 0, 1)
 ZEND_ARG_INFO(0, array)
+ZEND_ARG_INFO(0, out)
 ZEND_END_ARG_INFO()
 PHP_METHOD(NumPower, expm1) {
     NDArray *rtn = NULL;
-    zval *array;
-    ZEND_PARSE_PARAMETERS_START(1, 1)
+    zval *array, *out = NULL;
+    ZEND_PARSE_PARAMETERS_START(1, 2)
     Z_PARAM_ZVAL(array)
+    Z_PARAM_OPTIONAL
+    Z_PARAM_OBJECT_OF_CLASS_OR_NULL(out, phpsci_ce_NDArray)
     ZEND_PARSE_PARAMETERS_END();
     NDArray *nda = ZVAL_TO_NDARRAY(array);
     if (nda == NULL) {
         return;
     }
 
-    if (NDArray_DEVICE(nda) == NDARRAY_DEVICE_CPU) {
+    if (out != NULL) {
+        rtn = NDArray_MapInto(nda, float_expm1, ZVAL_TO_NDARRAY(out));
+    } else if (NDArray_DEVICE(nda) == NDARRAY_DEVICE_CPU) {
         rtn = NDArray_Map(nda, float_expm1);
     } else {
 #ifdef HAVE_CUBLAS
@@ -3270,7 +4640,7 @@ PHP_METHOD(NumPower, expm1) {
     if (Z_TYPE_P(array) == IS_ARRAY) {
         NDArray_FREE(nda);
     }
-    RETURN_NDARRAY(rtn, return_value);
+    RETURN_NDARRAY_OUT(rtn, out, return_value);
 }
 
 /**
@@ -3281,18 +4651,23 @@ PHP_METHOD(NumPower, expm1) {
  */
 ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_log, 0, 0, 1)
 ZEND_ARG_INFO(0, array)
+ZEND_ARG_INFO(0, out)
 ZEND_END_ARG_INFO()
 PHP_METHOD(NumPower, log) {
     NDArray *rtn = NULL;
-    zval *array;
-    ZEND_PARSE_PARAMETERS_START(1, 1)
+    zval *array, *out = NULL;
+    ZEND_PARSE_PARAMETERS_START(1, 2)
     Z_PARAM_ZVAL(array)
+    Z_PARAM_OPTIONAL
+    Z_PARAM_OBJECT_OF_CLASS_OR_NULL(out, phpsci_ce_NDArray)
     ZEND_PARSE_PARAMETERS_END();
     NDArray *nda = ZVAL_TO_NDARRAY(array);
     if (nda == NULL) {
         return;
     }
-    if (NDArray_DEVICE(nda) == NDARRAY_DEVICE_CPU) {
+    if (out != NULL) {
+        rtn = NDArray_MapInto(nda, float_log, ZVAL_TO_NDARRAY(out));
+    } else if (NDArray_DEVICE(nda) == NDARRAY_DEVICE_CPU) {
         rtn = NDArray_Map(nda, float_log);
     } else {
 #ifdef HAVE_CUBLAS
@@ -3304,7 +4679,7 @@ PHP_METHOD(NumPower, log) {
     if (Z_TYPE_P(array) == IS_ARRAY) {
         NDArray_FREE(nda);
     }
-    RETURN_NDARRAY(rtn, return_value);
+    RETURN_NDARRAY_OUT(rtn, out, return_value);
 }
 
 /**
@@ -3315,18 +4690,23 @@ PHP_METHOD(NumPower, log) {
  */
 ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_logb, 0, 0, 1)
 ZEND_ARG_INFO(0, array)
+ZEND_ARG_INFO(0, out)
 ZEND_END_ARG_INFO()
 PHP_METHOD(NumPower, logb) {
     NDArray *rtn = NULL;
-    zval *array;
-    ZEND_PARSE_PARAMETERS_START(1, 1)
+    zval *array, *out = NULL;
+    ZEND_PARSE_PARAMETERS_START(1, 2)
     Z_PARAM_ZVAL(array)
+    Z_PARAM_OPTIONAL
+    Z_PARAM_OBJECT_OF_CLASS_OR_NULL(out, phpsci_ce_NDArray)
     ZEND_PARSE_PARAMETERS_END();
     NDArray *nda = ZVAL_TO_NDARRAY(array);
     if (nda == NULL) {
         return;
     }
-    if (NDArray_DEVICE(nda) == NDARRAY_DEVICE_CPU) {
+    if (out != NULL) {
+        rtn = NDArray_MapInto(nda, float_logb, ZVAL_TO_NDARRAY(out));
+    } else if (NDArray_DEVICE(nda) == NDARRAY_DEVICE_CPU) {
         rtn = NDArray_Map(nda, float_logb);
     } else {
 #ifdef HAVE_CUBLAS
@@ -3336,7 +4716,7 @@ PHP_METHOD(NumPower, logb) {
 #endif
     }
     CHECK_INPUT_AND_FREE(array, nda);
-    RETURN_NDARRAY(rtn, return_value);
+    RETURN_NDARRAY_OUT(rtn, out, return_value);
 }
 
 /**
@@ -3347,18 +4727,23 @@ PHP_METHOD(NumPower, logb) {
  */
 ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_log10, 0, 0, 1)
 ZEND_ARG_INFO(0, array)
+ZEND_ARG_INFO(0, out)
 ZEND_END_ARG_INFO()
 PHP_METHOD(NumPower, log10) {
     NDArray *rtn = NULL;
-    zval *array;
-    ZEND_PARSE_PARAMETERS_START(1, 1)
+    zval *array, *out = NULL;
+    ZEND_PARSE_PARAMETERS_START(1, 2)
     Z_PARAM_ZVAL(array)
+    Z_PARAM_OPTIONAL
+    Z_PARAM_OBJECT_OF_CLASS_OR_NULL(out, phpsci_ce_NDArray)
     ZEND_PARSE_PARAMETERS_END();
     NDArray *nda = ZVAL_TO_NDARRAY(array);
     if (nda == NULL) {
         return;
     }
-    if (NDArray_DEVICE(nda) == NDARRAY_DEVICE_CPU) {
+    if (out != NULL) {
+        rtn = NDArray_MapInto(nda, float_log10, ZVAL_TO_NDARRAY(out));
+    } else if (NDArray_DEVICE(nda) == NDARRAY_DEVICE_CPU) {
         rtn = NDArray_Map(nda, float_log10);
     } else {
 #ifdef HAVE_CUBLAS
@@ -3368,7 +4753,7 @@ PHP_METHOD(NumPower, log10) {
 #endif
     }
     CHECK_INPUT_AND_FREE(array, nda);
-    RETURN_NDARRAY(rtn, return_value);
+    RETURN_NDARRAY_OUT(rtn, out, return_value);
 }
 
 /**
@@ -3379,18 +4764,23 @@ PHP_METHOD(NumPower, log10) {
  */
 ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_log1p, 0, 0, 1)
 ZEND_ARG_INFO(0, array)
+ZEND_ARG_INFO(0, out)
 ZEND_END_ARG_INFO()
 PHP_METHOD(NumPower, log1p) {
     NDArray *rtn = NULL;
-    zval *array;
-    ZEND_PARSE_PARAMETERS_START(1, 1)
+    zval *array, *out = NULL;
+    ZEND_PARSE_PARAMETERS_START(1, 2)
     Z_PARAM_ZVAL(array)
+    Z_PARAM_OPTIONAL
+    Z_PARAM_OBJECT_OF_CLASS_OR_NULL(out, phpsci_ce_NDArray)
     ZEND_PARSE_PARAMETERS_END();
     NDArray *nda = ZVAL_TO_NDARRAY(array);
     if (nda == NULL) {
         return;
     }
-    if (NDArray_DEVICE(nda) == NDARRAY_DEVICE_CPU) {
+    if (out != NULL) {
+        rtn = NDArray_MapInto(nda, float_log1p, ZVAL_TO_NDARRAY(out));
+    } else if (NDArray_DEVICE(nda) == NDARRAY_DEVICE_CPU) {
         rtn = NDArray_Map(nda, float_log1p);
     } else {
 #ifdef HAVE_CUBLAS
@@ -3400,7 +4790,7 @@ PHP_METHOD(NumPower, log1p) {
 #endif
     }
     CHECK_INPUT_AND_FREE(array, nda);
-    RETURN_NDARRAY(rtn, return_value);
+    RETURN_NDARRAY_OUT(rtn, out, return_value);
 }
 
 /**
@@ -3411,18 +4801,23 @@ PHP_METHOD(NumPower, log1p) {
  */
 ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_log2, 0, 0, 1)
 ZEND_ARG_INFO(0, array)
+ZEND_ARG_INFO(0, out)
 ZEND_END_ARG_INFO()
 PHP_METHOD(NumPower, log2) {
     NDArray *rtn = NULL;
-    zval *array;
-    ZEND_PARSE_PARAMETERS_START(1, 1)
+    zval *array, *out = NULL;
+    ZEND_PARSE_PARAMETERS_START(1, 2)
     Z_PARAM_ZVAL(array)
+    Z_PARAM_OPTIONAL
+    Z_PARAM_OBJECT_OF_CLASS_OR_NULL(out, phpsci_ce_NDArray)
     ZEND_PARSE_PARAMETERS_END();
     NDArray *nda = ZVAL_TO_NDARRAY(array);
     if (nda == NULL) {
         return;
     }
-    if (NDArray_DEVICE(nda) == NDARRAY_DEVICE_CPU) {
+    if (out != NULL) {
+        rtn = NDArray_MapInto(nda, float_log2, ZVAL_TO_NDARRAY(out));
+    } else if (NDArray_DEVICE(nda) == NDARRAY_DEVICE_CPU) {
         rtn = NDArray_Map(nda, float_log2);
     } else {
 #ifdef HAVE_CUBLAS
@@ -3432,7 +4827,7 @@ PHP_METHOD(NumPower, log2) {
 #endif
     }
     CHECK_INPUT_AND_FREE(array, nda);
-    RETURN_NDARRAY(rtn, return_value);
+    RETURN_NDARRAY_OUT(rtn, out, return_value);
 }
 
 /**
@@ -3441,14 +4836,17 @@ PHP_METHOD(NumPower, log2) {
 ZEND_BEGIN_ARG_INFO(arginfo_ndarray_subtract, 0)
 ZEND_ARG_INFO(0, a)
 ZEND_ARG_INFO(0, b)
+ZEND_ARG_INFO(0, out)
 ZEND_END_ARG_INFO()
 PHP_METHOD(NumPower, subtract) {
     NDArray *rtn = NULL;
-    zval *a, *b;
+    zval *a, *b, *out = NULL;
     long axis;
-    ZEND_PARSE_PARAMETERS_START(2, 2)
+    ZEND_PARSE_PARAMETERS_START(2, 3)
     Z_PARAM_ZVAL(a)
     Z_PARAM_ZVAL(b)
+    Z_PARAM_OPTIONAL
+    Z_PARAM_OBJECT_OF_CLASS_OR_NULL(out, phpsci_ce_NDArray)
     ZEND_PARSE_PARAMETERS_END();
     NDArray *nda = ZVAL_TO_NDARRAY(a);
     NDArray *ndb = ZVAL_TO_NDARRAY(b);
@@ -3459,13 +4857,41 @@ PHP_METHOD(NumPower, subtract) {
         CHECK_INPUT_AND_FREE(a, nda);
         return;
     }
+    nda = ndarray_operand_dtype(a, nda, ndb);
+    ndb = ndarray_operand_dtype(b, ndb, nda);
     if (!NDArray_IsBroadcastable(nda, ndb)) {
         zend_throw_error(NULL, "Can´t broadcast array.");
     }
-    rtn = NDArray_Subtract_Float(nda, ndb);
+    if (out != NULL) {
+        rtn = NDArray_BinaryOpInto(nda, ndb, ZVAL_TO_NDARRAY(out), NDARRAY_BINOP_SUBTRACT);
+    } else {
+        rtn = NDArray_Subtract_Float(nda, ndb);
+    }
     CHECK_INPUT_AND_FREE(a, nda);
     CHECK_INPUT_AND_FREE(b, ndb);
-    RETURN_NDARRAY(rtn, return_value);
+    RETURN_NDARRAY_OUT(rtn, out, return_value);
+}
+
+/**
+ * NumPower::lazy
+ */
+ZEND_BEGIN_ARG_INFO(arginfo_ndarray_lazy, 0)
+ZEND_ARG_INFO(0, a)
+ZEND_END_ARG_INFO()
+PHP_METHOD(NumPower, lazy) {
+    NDArrayExpr *expr;
+    zval *a;
+    ZEND_PARSE_PARAMETERS_START(1, 1)
+    Z_PARAM_ZVAL(a)
+    ZEND_PARSE_PARAMETERS_END();
+    if (Z_TYPE_P(a) == IS_OBJECT && Z_OBJCE_P(a) == phpsci_ce_NDArrayExpression) {
+        RETURN_COPY(a);
+    }
+    expr = ndarray_expression_operand(a);
+    if (expr == NULL) {
+        return;
+    }
+    RETURN_NDARRAY_EXPRESSION(expr, return_value);
 }
 
 /**
@@ -3541,14 +4967,17 @@ PHP_METHOD(NumPower, pow) {
 ZEND_BEGIN_ARG_INFO(arginfo_ndarray_multiply, 0)
 ZEND_ARG_INFO(0, a)
 ZEND_ARG_INFO(0, b)
+ZEND_ARG_INFO(0, out)
 ZEND_END_ARG_INFO()
 PHP_METHOD(NumPower, multiply) {
     NDArray *rtn = NULL;
-    zval *a, *b;
+    zval *a, *b, *out = NULL;
     long axis;
-    ZEND_PARSE_PARAMETERS_START(2, 2)
+    ZEND_PARSE_PARAMETERS_START(2, 3)
     Z_PARAM_ZVAL(a)
     Z_PARAM_ZVAL(b)
+    Z_PARAM_OPTIONAL
+    Z_PARAM_OBJECT_OF_CLASS_OR_NULL(out, phpsci_ce_NDArray)
     ZEND_PARSE_PARAMETERS_END();
     NDArray *nda = ZVAL_TO_NDARRAY(a);
     NDArray *ndb = ZVAL_TO_NDARRAY(b);
@@ -3559,14 +4988,20 @@ PHP_METHOD(NumPower, multiply) {
         CHECK_INPUT_AND_FREE(a, nda);
         return;
     }
+    nda = ndarray_operand_dtype(a, nda, ndb);
+    ndb = ndarray_operand_dtype(b, ndb, nda);
     if (!NDArray_IsBroadcastable(nda, ndb)) {
         zend_throw_error(NULL, "Can´t broadcast array.");
     }
-    rtn = NDArray_Multiply_Float(nda, ndb);
+    if (out != NULL) {
+        rtn = NDArray_BinaryOpInto(nda, ndb, ZVAL_TO_NDARRAY(out), NDARRAY_BINOP_MULTIPLY);
+    } else {
+        rtn = NDArray_Multiply_Float(nda, ndb);
+    }
 
     CHECK_INPUT_AND_FREE(a, nda);
     CHECK_INPUT_AND_FREE(b, ndb);
-    RETURN_NDARRAY(rtn, return_value);
+    RETURN_NDARRAY_OUT(rtn, out, return_value);
 }
 
 /**
@@ -3575,14 +5010,17 @@ PHP_METHOD(NumPower, multiply) {
 ZEND_BEGIN_ARG_INFO(arginfo_ndarray_divide, 0)
 ZEND_ARG_INFO(0, a)
 ZEND_ARG_INFO(0, b)
+ZEND_ARG_INFO(0, out)
 ZEND_END_ARG_INFO()
 PHP_METHOD(NumPower, divide) {
     NDArray *rtn = NULL;
-    zval *a, *b;
+    zval *a, *b, *out = NULL;
     long axis;
-    ZEND_PARSE_PARAMETERS_START(2, 2)
+    ZEND_PARSE_PARAMETERS_START(2, 3)
     Z_PARAM_ZVAL(a)
     Z_PARAM_ZVAL(b)
+    Z_PARAM_OPTIONAL
+    Z_PARAM_OBJECT_OF_CLASS_OR_NULL(out, phpsci_ce_NDArray)
     ZEND_PARSE_PARAMETERS_END();
     NDArray *nda = ZVAL_TO_NDARRAY(a);
     NDArray *ndb = ZVAL_TO_NDARRAY(b);
@@ -3592,13 +5030,19 @@ PHP_METHOD(NumPower, divide) {
     if (ndb == NULL) {
         return;
     }
+    nda = ndarray_operand_dtype(a, nda, ndb);
+    ndb = ndarray_operand_dtype(b, ndb, nda);
     if (!NDArray_IsBroadcastable(nda, ndb)) {
         zend_throw_error(NULL, "Can´t broadcast array.");
     }
-    rtn = NDArray_Divide_Float(nda, ndb);
+    if (out != NULL) {
+        rtn = NDArray_BinaryOpInto(nda, ndb, ZVAL_TO_NDARRAY(out), NDARRAY_BINOP_DIVIDE);
+    } else {
+        rtn = NDArray_Divide_Float(nda, ndb);
+    }
     CHECK_INPUT_AND_FREE(a, nda);
     CHECK_INPUT_AND_FREE(b, ndb);
-    RETURN_NDARRAY(rtn, return_value);
+    RETURN_NDARRAY_OUT(rtn, out, return_value);
 }
 
 /**
@@ -3607,14 +5051,17 @@ PHP_METHOD(NumPower, divide) {
 ZEND_BEGIN_ARG_INFO(arginfo_ndarray_add, 0)
 ZEND_ARG_INFO(0, a)
 ZEND_ARG_INFO(0, b)
+ZEND_ARG_INFO(0, out)
 ZEND_END_ARG_INFO()
 PHP_METHOD(NumPower, add) {
     NDArray *rtn = NULL;
-    zval *a, *b;
+    zval *a, *b, *out = NULL;
     long axis;
-    ZEND_PARSE_PARAMETERS_START(2, 2)
+    ZEND_PARSE_PARAMETERS_START(2, 3)
     Z_PARAM_ZVAL(a)
     Z_PARAM_ZVAL(b)
+    Z_PARAM_OPTIONAL
+    Z_PARAM_OBJECT_OF_CLASS_OR_NULL(out, phpsci_ce_NDArray)
     ZEND_PARSE_PARAMETERS_END();
     NDArray *nda = ZVAL_TO_NDARRAY(a);
     NDArray *ndb = ZVAL_TO_NDARRAY(b);
@@ -3625,13 +5072,19 @@ PHP_METHOD(NumPower, add) {
         CHECK_INPUT_AND_FREE(a, nda);
         return;
     }
+    nda = ndarray_operand_dtype(a, nda, ndb);
+    ndb = ndarray_operand_dtype(b, ndb, nda);
     if (!NDArray_IsBroadcastable(nda, ndb)) {
         zend_throw_error(NULL, "Can´t broadcast array.");
     }
-    rtn = NDArray_Add_Float(nda, ndb);
+    if (out != NULL) {
+        rtn = NDArray_BinaryOpInto(nda, ndb, ZVAL_TO_NDARRAY(out), NDARRAY_BINOP_ADD);
+    } else {
+        rtn = NDArray_Add_Float(nda, ndb);
+    }
     CHECK_INPUT_AND_FREE(a, nda);
     CHECK_INPUT_AND_FREE(b, ndb);
-    RETURN_NDARRAY(rtn, return_value);
+    RETURN_NDARRAY_OUT(rtn, out, return_value);
 }
 
 /**
@@ -4029,6 +5482,9 @@ PHP_METHOD(NumPower, matmul) {
     Z_PARAM_ZVAL(a)
     Z_PARAM_ZVAL(b)
     ZEND_PARSE_PARAMETERS_END();
+    if (sparse_ndarray_product(a, b, return_value)) {
+        return;
+    }
     NDArray *nda = ZVAL_TO_NDARRAY(a);
     NDArray *ndb = ZVAL_TO_NDARRAY(b);
     if (nda == NULL) {
@@ -4047,6 +5503,110 @@ PHP_METHOD(NumPower, matmul) {
     RETURN_NDARRAY(rtn, return_value);
 }
 
+/**
+ * NumPower::quantize
+ */
+ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_quantize, 0, 0, 2)
+ZEND_ARG_INFO(0, a)
+ZEND_ARG_INFO(0, scale)
+ZEND_ARG_INFO(0, zeroPoint)
+ZEND_END_ARG_INFO()
+PHP_METHOD(NumPower, quantize) {
+    NDArray *rtn = NULL;
+    zval *a, *scale;
+    zend_long zero_point = 0;
+    ZEND_PARSE_PARAMETERS_START(2, 3)
+    Z_PARAM_ZVAL(a)
+    Z_PARAM_ZVAL(scale)
+    Z_PARAM_OPTIONAL
+    Z_PARAM_LONG(zero_point)
+    ZEND_PARSE_PARAMETERS_END();
+    NDArray *nda = ZVAL_TO_NDARRAY(a);
+    if (nda == NULL) {
+        return;
+    }
+    NDArray *nd_scale = ZVAL_TO_NDARRAY(scale);
+    if (nd_scale == NULL) {
+        CHECK_INPUT_AND_FREE(a, nda);
+        return;
+    }
+    rtn = NDArray_Quantize(nda, nd_scale, (int)zero_point);
+    CHECK_INPUT_AND_FREE(a, nda);
+    CHECK_INPUT_AND_FREE(scale, nd_scale);
+    RETURN_NDARRAY(rtn, return_value);
+}
+
+/**
+ * NumPower::dequantize
+ */
+ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_dequantize, 0, 0, 2)
+ZEND_ARG_INFO(0, q)
+ZEND_ARG_INFO(0, scale)
+ZEND_ARG_INFO(0, zeroPoint)
+ZEND_END_ARG_INFO()
+PHP_METHOD(NumPower, dequantize) {
+    NDArray *rtn = NULL;
+    zval *q, *scale;
+    zend_long zero_point = 0;
+    ZEND_PARSE_PARAMETERS_START(2, 3)
+    Z_PARAM_ZVAL(q)
+    Z_PARAM_ZVAL(scale)
+    Z_PARAM_OPTIONAL
+    Z_PARAM_LONG(zero_point)
+    ZEND_PARSE_PARAMETERS_END();
+    NDArray *ndq = ZVAL_TO_NDARRAY(q);
+    if (ndq == NULL) {
+        return;
+    }
+    NDArray *nd_scale = ZVAL_TO_NDARRAY(scale);
+    if (nd_scale == NULL) {
+        CHECK_INPUT_AND_FREE(q, ndq);
+        return;
+    }
+    rtn = NDArray_Dequantize(ndq, nd_scale, (int)zero_point);
+    CHECK_INPUT_AND_FREE(q, ndq);
+    CHECK_INPUT_AND_FREE(scale, nd_scale);
+    RETURN_NDARRAY(rtn, return_value);
+}
+
+/**
+ * NumPower::quantizedMatmul
+ */
+ZEND_BEGIN_ARG_INFO(arginfo_ndarray_quantized_matmul, 0)
+ZEND_ARG_INFO(0, a)
+ZEND_ARG_INFO(0, weights)
+ZEND_ARG_INFO(0, scale)
+ZEND_END_ARG_INFO()
+PHP_METHOD(NumPower, quantizedMatmul) {
+    NDArray *rtn = NULL;
+    zval *a, *weights, *scale;
+    ZEND_PARSE_PARAMETERS_START(3, 3)
+    Z_PARAM_ZVAL(a)
+    Z_PARAM_ZVAL(weights)
+    Z_PARAM_ZVAL(scale)
+    ZEND_PARSE_PARAMETERS_END();
+    NDArray *nda = ZVAL_TO_NDARRAY(a);
+    if (nda == NULL) {
+        return;
+    }
+    NDArray *ndw = ZVAL_TO_NDARRAY(weights);
+    if (ndw == NULL) {
+        CHECK_INPUT_AND_FREE(a, nda);
+        return;
+    }
+    NDArray *nd_scale = ZVAL_TO_NDARRAY(scale);
+    if (nd_scale == NULL) {
+        CHECK_INPUT_AND_FREE(a, nda);
+        CHECK_INPUT_AND_FREE(weights, ndw);
+        return;
+    }
+    rtn = NDArray_QuantizedMatmul(nda, ndw, nd_scale);
+    CHECK_INPUT_AND_FREE(a, nda);
+    CHECK_INPUT_AND_FREE(weights, ndw);
+    CHECK_INPUT_AND_FREE(scale, nd_scale);
+    RETURN_NDARRAY(rtn, return_value);
+}
+
 /**
  * NumPower::inner
  */
@@ -4124,6 +5684,9 @@ PHP_METHOD(NumPower, dot) {
     Z_PARAM_ZVAL(a)
     Z_PARAM_ZVAL(b)
     ZEND_PARSE_PARAMETERS_END();
+    if (sparse_ndarray_product(a, b, return_value)) {
+        return;
+    }
     NDArray *nda = ZVAL_TO_NDARRAY(a);
     NDArray *ndb = ZVAL_TO_NDARRAY(b);
     if (nda == NULL) {
@@ -4167,22 +5730,26 @@ PHP_METHOD(NumPower, trace) {
 /**
  * NumPower::eig
  */
-ZEND_BEGIN_ARG_INFO(arginfo_ndarray_eig, 0)
+ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_eig, 0, 0, 1)
 ZEND_ARG_INFO(0, a)
+ZEND_ARG_INFO_WITH_DEFAULT_VALUE(0, symmetric, "false")
 ZEND_END_ARG_INFO()
 PHP_METHOD(NumPower, eig) {
     NDArray **rtn = NULL;
     zval *a, *b;
     long axis;
-    ZEND_PARSE_PARAMETERS_START(1, 1)
+    bool symmetric = false;
+    ZEND_PARSE_PARAMETERS_START(1, 2)
     Z_PARAM_ZVAL(a)
+    Z_PARAM_OPTIONAL
+    Z_PARAM_BOOL(symmetric)
     ZEND_PARSE_PARAMETERS_END();
     NDArray *nda = ZVAL_TO_NDARRAY(a);
     if (nda == NULL) {
         return;
     }
 
-    rtn = NDArray_Eig(nda);
+    rtn = NDArray_Eig(nda, symmetric);
     if (rtn == NULL) {
         return;
     }
@@ -4191,6 +5758,78 @@ PHP_METHOD(NumPower, eig) {
     efree(rtn);
 }
 
+/**
+ * Shared body of NumPower::eigh and NumPower::eigvalsh. `subset` is an
+ * optional [first, last] pair of ascending eigenvalue indices.
+ */
+static void
+ndarray_eigh(zval *return_value, zval *a, zval *subset, bool with_vectors) {
+    NDArray *nda, *w, *v = NULL;
+    zval *index;
+    int bounds[2] = {0, -1}, i = 0;
+
+    if (subset != NULL) {
+        if (zend_hash_num_elements(Z_ARRVAL_P(subset)) != 2) {
+            zend_throw_error(NULL, "subset must be an array with the first and last eigenvalue index.");
+            return;
+        }
+        ZEND_HASH_FOREACH_VAL(Z_ARRVAL_P(subset), index) {
+            bounds[i++] = (int) zval_get_long(index);
+        } ZEND_HASH_FOREACH_END();
+    }
+    nda = ZVAL_TO_NDARRAY(a);
+    if (nda == NULL) {
+        return;
+    }
+    if (subset == NULL && NDArray_NDIM(nda) == 2) {
+        bounds[1] = NDArray_SHAPE(nda)[0] - 1;
+    }
+    w = NDArray_Eigh(nda, bounds[0], bounds[1], with_vectors ? &v : NULL);
+    CHECK_INPUT_AND_FREE(a, nda);
+    if (w == NULL) {
+        return;
+    }
+    if (with_vectors) {
+        RETURN_2NDARRAY(w, v, return_value);
+        return;
+    }
+    RETURN_NDARRAY(w, return_value);
+}
+
+/**
+ * NumPower::eigh
+ */
+ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_eigh, 0, 0, 1)
+ZEND_ARG_INFO(0, a)
+ZEND_ARG_INFO(0, subset)
+ZEND_END_ARG_INFO()
+PHP_METHOD(NumPower, eigh) {
+    zval *a, *subset = NULL;
+    ZEND_PARSE_PARAMETERS_START(1, 2)
+    Z_PARAM_ZVAL(a)
+    Z_PARAM_OPTIONAL
+    Z_PARAM_ARRAY_OR_NULL(subset)
+    ZEND_PARSE_PARAMETERS_END();
+    ndarray_eigh(return_value, a, subset, true);
+}
+
+/**
+ * NumPower::eigvalsh
+ */
+ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_eigvalsh, 0, 0, 1)
+ZEND_ARG_INFO(0, a)
+ZEND_ARG_INFO(0, subset)
+ZEND_END_ARG_INFO()
+PHP_METHOD(NumPower, eigvalsh) {
+    zval *a, *subset = NULL;
+    ZEND_PARSE_PARAMETERS_START(1, 2)
+    Z_PARAM_ZVAL(a)
+    Z_PARAM_OPTIONAL
+    Z_PARAM_ARRAY_OR_NULL(subset)
+    ZEND_PARSE_PARAMETERS_END();
+    ndarray_eigh(return_value, a, subset, false);
+}
+
 /**
  * NumPower::cholesky
  */
@@ -4280,57 +5919,391 @@ PHP_METHOD(NumPower, lstsq) {
 }
 
 /**
- * NumPower::qr
+ * PHP callable used as the operator of an iterative solver. It is called
+ * with a float64 vector x and must return A @ x.
  */
-ZEND_BEGIN_ARG_INFO(arginfo_ndarray_qr, 0)
-ZEND_ARG_INFO(0, a)
-ZEND_END_ARG_INFO()
-PHP_METHOD(NumPower, qr) {
-    NDArray **rtns;
-    zval *a, *b;
-    long axis;
-    ZEND_PARSE_PARAMETERS_START(1, 1)
-    Z_PARAM_ZVAL(a)
-    ZEND_PARSE_PARAMETERS_END();
-    NDArray *nda = ZVAL_TO_NDARRAY(a);
-    if (nda == NULL) {
-        return;
+typedef struct {
+    zend_fcall_info fci;
+    zend_fcall_info_cache fcc;
+} ndarray_callable_operator;
+
+static int
+ndarray_callable_matvec(NDArrayOperator *op, const double *x, double *y) {
+    ndarray_callable_operator *callable = op->data;
+    int *shape = emalloc(sizeof(int));
+    NDArray *in, *out, *cast;
+    zval arg, retval;
+    int status = -1;
+
+    shape[0] = op->n;
+    in = NDArray_Empty(shape, 1, NDARRAY_TYPE_DOUBLE64, NDARRAY_DEVICE_CPU);
+    memcpy(NDArray_DDATA(in), x, sizeof(double) * op->n);
+    RETURN_NDARRAY(in, &arg);
+    ZVAL_UNDEF(&retval);
+    callable->fci.retval = &retval;
+    callable->fci.params = &arg;
+    callable->fci.param_count = 1;
+    if (zend_call_function(&callable->fci, &callable->fcc) == SUCCESS && !EG(exception) && Z_TYPE(retval) != IS_UNDEF) {
+        out = ZVAL_TO_NDARRAY(&retval);
+        if (out != NULL) {
+            if (NDArray_NUMELEMENTS(out) != op->n) {
+                zend_throw_error(NULL, "The operator must return a vector of %d elements.", op->n);
+            } else if ((cast = NDArray_AsType(out, NDARRAY_TYPE_DOUBLE64)) != NULL) {
+                memcpy(y, NDArray_DDATA(cast), sizeof(double) * op->n);
+                NDArray_FREE(cast);
+                status = 0;
+            }
+            CHECK_INPUT_AND_FREE(&retval, out);
+        }
     }
-    rtns = NDArray_Qr(nda);
+    if (status != 0 && !EG(exception)) {
+        zend_throw_error(NULL, "The operator call failed.");
+    }
+    zval_ptr_dtor(&arg);
+    zval_ptr_dtor(&retval);
+    return status;
+}
 
-    CHECK_INPUT_AND_FREE(a, nda);
-    RETURN_2NDARRAY(rtns[0], rtns[1], return_value);
-    efree(rtns);
+static void
+ndarray_callable_release(NDArrayOperator *op) {
+    efree(op->data);
 }
 
 /**
- * NumPower::lu
+ * Replace the diagonal of `op` by the vector `diagonal`
+ *
+ * @return 0 on success, -1 with an exception thrown otherwise
  */
-ZEND_BEGIN_ARG_INFO(arginfo_ndarray_lu, 0)
-ZEND_ARG_INFO(0, a)
-ZEND_END_ARG_INFO()
-PHP_METHOD(NumPower, lu) {
-    NDArray **rtns;
-    zval *a, *b;
-    long axis;
-    ZEND_PARSE_PARAMETERS_START(1, 1)
-    Z_PARAM_ZVAL(a)
-    ZEND_PARSE_PARAMETERS_END();
-    NDArray *nda = ZVAL_TO_NDARRAY(a);
-    if (nda == NULL) {
-        return;
-    }
+static int
+ndarray_operator_diagonal(NDArrayOperator *op, zval *diagonal) {
+    NDArray *nd = ZVAL_TO_NDARRAY(diagonal), *cast;
 
-    rtns = NDArray_LU(nda);
-    if (rtns == NULL) {
-        return;
+    if (nd == NULL) {
+        return -1;
+    }
+    if (NDArray_NUMELEMENTS(nd) != op->n) {
+        zend_throw_error(NULL, "diagonal must be a vector of %d elements.", op->n);
+        CHECK_INPUT_AND_FREE(diagonal, nd);
+        return -1;
     }
+    cast = NDArray_AsType(nd, NDARRAY_TYPE_DOUBLE64);
+    CHECK_INPUT_AND_FREE(diagonal, nd);
+    if (cast == NULL) {
+        return -1;
+    }
+    if (op->diagonal == NULL) {
+        op->diagonal = emalloc(sizeof(double) * (op->n > 0 ? op->n : 1));
+    }
+    memcpy(op->diagonal, NDArray_DDATA(cast), sizeof(double) * op->n);
+    NDArray_FREE(cast);
+    return 0;
+}
 
-    CHECK_INPUT_AND_FREE(a, nda);
+/**
+ * Operator behind `a`: a SparseNDArray, a callable of size `n` or a
+ * square dense matrix, returned in `dense` so the caller can release it
+ *
+ * @return 0 on success, -1 with an exception thrown otherwise
+ */
+static int
+ndarray_zval_operator(zval *a, zend_long n, NDArrayOperator *op, NDArray **dense) {
+    ndarray_callable_operator *callable;
+    NDArraySparse *sparse;
+
+    *dense = NULL;
+    if (IS_SPARSE_NDARRAY_P(a)) {
+        sparse = sparse_ndarray_get(a);
+        return sparse == NULL ? -1 : NDArray_SparseOperator(op, sparse);
+    }
+    if (Z_TYPE_P(a) != IS_ARRAY && !(Z_TYPE_P(a) == IS_OBJECT && (Z_OBJCE_P(a) == phpsci_ce_NDArray ||
+            Z_OBJCE_P(a) == phpsci_ce_NDArrayExpression)) && zend_is_callable(a, 0, NULL)) {
+        if (n < 0) {
+            zend_throw_error(NULL, "The size of a callable operator must be given.");
+            return -1;
+        }
+        callable = emalloc(sizeof(ndarray_callable_operator));
+        zend_fcall_info_init(a, 0, &callable->fci, &callable->fcc, NULL, NULL);
+        op->n = (int) n;
+        op->is_double = 1;
+        op->matvec = ndarray_callable_matvec;
+        op->release = ndarray_callable_release;
+        op->data = callable;
+        return 0;
+    }
+    *dense = ZVAL_TO_NDARRAY(a);
+    if (*dense == NULL) {
+        return -1;
+    }
+    if (NDArray_DenseOperator(op, *dense) != 0) {
+        CHECK_INPUT_AND_FREE(a, *dense);
+        *dense = NULL;
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * Shared body of NumPower::cg and NumPower::gmres. `a` is a square dense
+ * or sparse matrix or a callable operator; the result is an array with
+ * the solution `x` and the convergence report.
+ */
+static void
+ndarray_iterative_solve(zval *return_value, int gmres, zval *a, zval *b, zval *x0, zval *diagonal, double tol,
+                        zend_long max_iter, bool max_iter_is_null, zend_long restart, int jacobi) {
+    NDArrayOperator op = {0};
+    NDArraySolverInfo info;
+    NDArray *nda = NULL, *ndb, *ndx0 = NULL, *rtn = NULL;
+    zval x;
+
+    ndb = ZVAL_TO_NDARRAY(b);
+    if (ndb == NULL) {
+        return;
+    }
+    if (ndarray_zval_operator(a, NDArray_NUMELEMENTS(ndb), &op, &nda) != 0) {
+        CHECK_INPUT_AND_FREE(b, ndb);
+        return;
+    }
+    if (diagonal != NULL && ndarray_operator_diagonal(&op, diagonal) != 0) {
+        goto cleanup;
+    }
+    if (x0 != NULL && (ndx0 = ZVAL_TO_NDARRAY(x0)) == NULL) {
+        goto cleanup;
+    }
+    if (max_iter_is_null) {
+        max_iter = 10 * (zend_long) op.n;
+    }
+    if (max_iter < 0 || restart < 0) {
+        zend_throw_error(NULL, "max_iter and restart must be non-negative.");
+        goto cleanup;
+    }
+    if (gmres) {
+        rtn = NDArray_GMRES(&op, ndb, ndx0, tol, (int) restart, (int) max_iter, jacobi, &info);
+    } else {
+        rtn = NDArray_CG(&op, ndb, ndx0, tol, (int) max_iter, jacobi, &info);
+    }
+    if (rtn != NULL) {
+        RETURN_NDARRAY(rtn, &x);
+        array_init(return_value);
+        add_assoc_zval(return_value, "x", &x);
+        add_assoc_long(return_value, "iterations", info.iterations);
+        add_assoc_double(return_value, "residual", info.residual);
+        add_assoc_bool(return_value, "converged", info.converged);
+    }
+cleanup:
+    NDArray_OperatorFree(&op);
+    if (nda != NULL) {
+        CHECK_INPUT_AND_FREE(a, nda);
+    }
+    CHECK_INPUT_AND_FREE(x0, ndx0);
+    CHECK_INPUT_AND_FREE(b, ndb);
+}
+
+/**
+ * NumPower::cg
+ */
+ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_cg, 0, 0, 2)
+ZEND_ARG_INFO(0, a)
+ZEND_ARG_INFO(0, b)
+ZEND_ARG_INFO_WITH_DEFAULT_VALUE(0, tol, "1.0E-5")
+ZEND_ARG_INFO_WITH_DEFAULT_VALUE(0, max_iter, "null")
+ZEND_ARG_INFO_WITH_DEFAULT_VALUE(0, x0, "null")
+ZEND_ARG_INFO_WITH_DEFAULT_VALUE(0, jacobi, "null")
+ZEND_ARG_INFO_WITH_DEFAULT_VALUE(0, diagonal, "null")
+ZEND_END_ARG_INFO()
+PHP_METHOD(NumPower, cg) {
+    zval *a, *b, *x0 = NULL, *diagonal = NULL;
+    double tol = 1e-5;
+    zend_long max_iter = 0;
+    bool max_iter_is_null = true, jacobi = false, jacobi_is_null = true;
+    ZEND_PARSE_PARAMETERS_START(2, 7)
+    Z_PARAM_ZVAL(a)
+    Z_PARAM_ZVAL(b)
+    Z_PARAM_OPTIONAL
+    Z_PARAM_DOUBLE(tol)
+    Z_PARAM_LONG_OR_NULL(max_iter, max_iter_is_null)
+    Z_PARAM_ZVAL_OR_NULL(x0)
+    Z_PARAM_BOOL_OR_NULL(jacobi, jacobi_is_null)
+    Z_PARAM_ZVAL_OR_NULL(diagonal)
+    ZEND_PARSE_PARAMETERS_END();
+    ndarray_iterative_solve(return_value, 0, a, b, x0, diagonal, tol, max_iter, max_iter_is_null, 0,
+                            jacobi_is_null ? NDARRAY_JACOBI_AUTO : (jacobi ? NDARRAY_JACOBI_ON : NDARRAY_JACOBI_OFF));
+}
+
+/**
+ * NumPower::gmres
+ */
+ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_gmres, 0, 0, 2)
+ZEND_ARG_INFO(0, a)
+ZEND_ARG_INFO(0, b)
+ZEND_ARG_INFO_WITH_DEFAULT_VALUE(0, tol, "1.0E-5")
+ZEND_ARG_INFO_WITH_DEFAULT_VALUE(0, max_iter, "null")
+ZEND_ARG_INFO_WITH_DEFAULT_VALUE(0, restart, "30")
+ZEND_ARG_INFO_WITH_DEFAULT_VALUE(0, x0, "null")
+ZEND_ARG_INFO_WITH_DEFAULT_VALUE(0, jacobi, "null")
+ZEND_ARG_INFO_WITH_DEFAULT_VALUE(0, diagonal, "null")
+ZEND_END_ARG_INFO()
+PHP_METHOD(NumPower, gmres) {
+    zval *a, *b, *x0 = NULL, *diagonal = NULL;
+    double tol = 1e-5;
+    zend_long max_iter = 0, restart = 30;
+    bool max_iter_is_null = true, jacobi = false, jacobi_is_null = true;
+    ZEND_PARSE_PARAMETERS_START(2, 8)
+    Z_PARAM_ZVAL(a)
+    Z_PARAM_ZVAL(b)
+    Z_PARAM_OPTIONAL
+    Z_PARAM_DOUBLE(tol)
+    Z_PARAM_LONG_OR_NULL(max_iter, max_iter_is_null)
+    Z_PARAM_LONG(restart)
+    Z_PARAM_ZVAL_OR_NULL(x0)
+    Z_PARAM_BOOL_OR_NULL(jacobi, jacobi_is_null)
+    Z_PARAM_ZVAL_OR_NULL(diagonal)
+    ZEND_PARSE_PARAMETERS_END();
+    ndarray_iterative_solve(return_value, 1, a, b, x0, diagonal, tol, max_iter, max_iter_is_null, restart,
+                            jacobi_is_null ? NDARRAY_JACOBI_AUTO : (jacobi ? NDARRAY_JACOBI_ON : NDARRAY_JACOBI_OFF));
+}
+
+/**
+ * NumPower::lanczos
+ */
+ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_lanczos, 0, 0, 1)
+ZEND_ARG_INFO(0, a)
+ZEND_ARG_INFO_WITH_DEFAULT_VALUE(0, k, "6")
+ZEND_ARG_INFO_WITH_DEFAULT_VALUE(0, which, "\"largest\"")
+ZEND_ARG_INFO_WITH_DEFAULT_VALUE(0, tol, "1.0E-8")
+ZEND_ARG_INFO_WITH_DEFAULT_VALUE(0, max_dim, "null")
+ZEND_ARG_INFO_WITH_DEFAULT_VALUE(0, n, "null")
+ZEND_END_ARG_INFO()
+PHP_METHOD(NumPower, lanczos) {
+    zval *a, vectors, values;
+    zend_string *which = NULL;
+    zend_long k = 6, max_dim = 0, n = -1;
+    bool max_dim_is_null = true, n_is_null = true;
+    double tol = 1e-8;
+    int largest = 1;
+    NDArrayOperator op = {0};
+    NDArraySolverInfo info;
+    NDArray *nda = NULL, *w, *v;
+    ZEND_PARSE_PARAMETERS_START(1, 6)
+    Z_PARAM_ZVAL(a)
+    Z_PARAM_OPTIONAL
+    Z_PARAM_LONG(k)
+    Z_PARAM_STR(which)
+    Z_PARAM_DOUBLE(tol)
+    Z_PARAM_LONG_OR_NULL(max_dim, max_dim_is_null)
+    Z_PARAM_LONG_OR_NULL(n, n_is_null)
+    ZEND_PARSE_PARAMETERS_END();
+    if (which != NULL) {
+        if (zend_string_equals_literal_ci(which, "smallest")) {
+            largest = 0;
+        } else if (!zend_string_equals_literal_ci(which, "largest")) {
+            zend_throw_error(NULL, "Unknown value '%s' for which, expected 'largest' or 'smallest'.", ZSTR_VAL(which));
+            return;
+        }
+    }
+    if (ndarray_zval_operator(a, n_is_null ? -1 : n, &op, &nda) != 0) {
+        return;
+    }
+    if (max_dim_is_null) {
+        // Enough room for the wanted pairs to converge on clustered spectra
+        max_dim = 8 * k > 256 ? 8 * k : 256;
+        max_dim = max_dim < op.n ? max_dim : op.n;
+    }
+    w = NDArray_Lanczos(&op, (int) k, largest, tol, (int) max_dim, &v, &info);
+    if (w != NULL) {
+        RETURN_NDARRAY(w, &values);
+        RETURN_NDARRAY(v, &vectors);
+        array_init(return_value);
+        add_assoc_zval(return_value, "values", &values);
+        add_assoc_zval(return_value, "vectors", &vectors);
+        add_assoc_long(return_value, "iterations", info.iterations);
+        add_assoc_double(return_value, "residual", info.residual);
+        add_assoc_bool(return_value, "converged", info.converged);
+    }
+    NDArray_OperatorFree(&op);
+    if (nda != NULL) {
+        CHECK_INPUT_AND_FREE(a, nda);
+    }
+}
+
+/**
+ * NumPower::qr
+ */
+ZEND_BEGIN_ARG_INFO(arginfo_ndarray_qr, 0)
+ZEND_ARG_INFO(0, a)
+ZEND_END_ARG_INFO()
+PHP_METHOD(NumPower, qr) {
+    NDArray **rtns;
+    zval *a, *b;
+    long axis;
+    ZEND_PARSE_PARAMETERS_START(1, 1)
+    Z_PARAM_ZVAL(a)
+    ZEND_PARSE_PARAMETERS_END();
+    NDArray *nda = ZVAL_TO_NDARRAY(a);
+    if (nda == NULL) {
+        return;
+    }
+    rtns = NDArray_Qr(nda);
+
+    CHECK_INPUT_AND_FREE(a, nda);
+    RETURN_2NDARRAY(rtns[0], rtns[1], return_value);
+    efree(rtns);
+}
+
+/**
+ * NumPower::lu
+ */
+ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_lu, 0, 0, 1)
+ZEND_ARG_INFO(0, a)
+ZEND_ARG_INFO(0, permutation_matrix)
+ZEND_END_ARG_INFO()
+PHP_METHOD(NumPower, lu) {
+    NDArray **rtns;
+    zval *a;
+    bool permutation_matrix = false;
+    ZEND_PARSE_PARAMETERS_START(1, 2)
+    Z_PARAM_ZVAL(a)
+    Z_PARAM_OPTIONAL
+    Z_PARAM_BOOL(permutation_matrix)
+    ZEND_PARSE_PARAMETERS_END();
+    NDArray *nda = ZVAL_TO_NDARRAY(a);
+    if (nda == NULL) {
+        return;
+    }
+
+    rtns = NDArray_LU(nda, permutation_matrix);
+    CHECK_INPUT_AND_FREE(a, nda);
+    if (rtns == NULL) {
+        return;
+    }
     RETURN_3NDARRAY(rtns[0], rtns[1], rtns[2], return_value);
     efree(rtns);
 }
 
+/**
+ * NumPower::luFactor
+ */
+ZEND_BEGIN_ARG_INFO(arginfo_ndarray_lu_factor, 0)
+ZEND_ARG_INFO(0, a)
+ZEND_END_ARG_INFO()
+PHP_METHOD(NumPower, luFactor) {
+    NDArrayLUFactor *factor;
+    zval *a;
+    ZEND_PARSE_PARAMETERS_START(1, 1)
+    Z_PARAM_ZVAL(a)
+    ZEND_PARSE_PARAMETERS_END();
+    NDArray *nda = ZVAL_TO_NDARRAY(a);
+    if (nda == NULL) {
+        return;
+    }
+    factor = NDArray_LUFactor(nda);
+    CHECK_INPUT_AND_FREE(a, nda);
+    if (factor == NULL) {
+        return;
+    }
+    object_init_ex(return_value, phpsci_ce_LUFactorization);
+    Z_LU_FACTORIZATION_P(return_value)->factor = factor;
+}
+
 /**
  * NumPower::matrixRank
  */
@@ -4447,6 +6420,683 @@ PHP_METHOD(NumPower, dnnConv2dBackward) {
     efree(rtn);
 }
 
+/**
+ * @param activation "relu", "tanh", "sigmoid", "gelu" or NULL
+ * @return activation code of NDArrayDNN_Linear or -1 with an exception thrown
+ */
+static int
+ndarray_linear_activation(zend_string *activation) {
+    if (activation == NULL) {
+        return 0;
+    }
+    if (zend_string_equals_literal_ci(activation, "relu")) {
+        return 'r';
+    }
+    if (zend_string_equals_literal_ci(activation, "tanh")) {
+        return 't';
+    }
+    if (zend_string_equals_literal_ci(activation, "sigmoid")) {
+        return 's';
+    }
+    if (zend_string_equals_literal_ci(activation, "gelu")) {
+        return 'g';
+    }
+    zend_throw_error(NULL, "Unknown activation '%s', expected 'relu', 'tanh', 'sigmoid' or 'gelu'.",
+                     ZSTR_VAL(activation));
+    return -1;
+}
+
+/**
+ * NumPower::linear
+ */
+ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_linear, 0, 0, 2)
+ZEND_ARG_INFO(0, x)
+ZEND_ARG_INFO(0, w)
+ZEND_ARG_INFO_WITH_DEFAULT_VALUE(0, b, "null")
+ZEND_ARG_INFO_WITH_DEFAULT_VALUE(0, activation, "null")
+ZEND_END_ARG_INFO()
+PHP_METHOD(NumPower, linear) {
+    NDArray *rtn = NULL, *ndx, *ndw = NULL, *ndb = NULL;
+    zval *x, *w, *b = NULL;
+    zend_string *activation = NULL;
+    int act;
+    ZEND_PARSE_PARAMETERS_START(2, 4)
+    Z_PARAM_ZVAL(x)
+    Z_PARAM_ZVAL(w)
+    Z_PARAM_OPTIONAL
+    Z_PARAM_ZVAL_OR_NULL(b)
+    Z_PARAM_STR_OR_NULL(activation)
+    ZEND_PARSE_PARAMETERS_END();
+    if ((act = ndarray_linear_activation(activation)) < 0) {
+        return;
+    }
+    ndx = ZVAL_TO_NDARRAY(x);
+    if (ndx != NULL) {
+        ndw = ZVAL_TO_NDARRAY(w);
+    }
+    if (ndw != NULL && (b == NULL || (ndb = ZVAL_TO_NDARRAY(b)) != NULL)) {
+        rtn = NDArrayDNN_Linear(ndx, ndw, ndb, (char) act);
+    }
+    CHECK_INPUT_AND_FREE(x, ndx);
+    CHECK_INPUT_AND_FREE(w, ndw);
+    CHECK_INPUT_AND_FREE(b, ndb);
+    if (rtn == NULL) {
+        return;
+    }
+    RETURN_NDARRAY(rtn, return_value);
+}
+
+/**
+ * NumPower::linearBackward
+ */
+ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_linear_backward, 0, 0, 3)
+ZEND_ARG_INFO(0, grad)
+ZEND_ARG_INFO(0, x)
+ZEND_ARG_INFO(0, w)
+ZEND_ARG_INFO_WITH_DEFAULT_VALUE(0, b, "null")
+ZEND_ARG_INFO_WITH_DEFAULT_VALUE(0, y, "null")
+ZEND_ARG_INFO_WITH_DEFAULT_VALUE(0, activation, "null")
+ZEND_END_ARG_INFO()
+PHP_METHOD(NumPower, linearBackward) {
+    NDArray **rtn = NULL, *ndgrad, *ndx = NULL, *ndw = NULL, *ndb = NULL, *ndy = NULL;
+    zval *grad, *x, *w, *b = NULL, *y = NULL;
+    zend_string *activation = NULL;
+    int act;
+    ZEND_PARSE_PARAMETERS_START(3, 6)
+    Z_PARAM_ZVAL(grad)
+    Z_PARAM_ZVAL(x)
+    Z_PARAM_ZVAL(w)
+    Z_PARAM_OPTIONAL
+    Z_PARAM_ZVAL_OR_NULL(b)
+    Z_PARAM_ZVAL_OR_NULL(y)
+    Z_PARAM_STR_OR_NULL(activation)
+    ZEND_PARSE_PARAMETERS_END();
+    if ((act = ndarray_linear_activation(activation)) < 0) {
+        return;
+    }
+    ndgrad = ZVAL_TO_NDARRAY(grad);
+    if (ndgrad != NULL) {
+        ndx = ZVAL_TO_NDARRAY(x);
+    }
+    if (ndx != NULL) {
+        ndw = ZVAL_TO_NDARRAY(w);
+    }
+    if (ndw != NULL && (b == NULL || (ndb = ZVAL_TO_NDARRAY(b)) != NULL)
+            && (y == NULL || (ndy = ZVAL_TO_NDARRAY(y)) != NULL)) {
+        rtn = NDArrayDNN_Linear_Backward(ndgrad, ndx, ndw, ndb, ndy, (char) act);
+    }
+    CHECK_INPUT_AND_FREE(grad, ndgrad);
+    CHECK_INPUT_AND_FREE(x, ndx);
+    CHECK_INPUT_AND_FREE(w, ndw);
+    CHECK_INPUT_AND_FREE(b, ndb);
+    CHECK_INPUT_AND_FREE(y, ndy);
+    if (rtn == NULL) {
+        return;
+    }
+    RETURN_3NDARRAY(rtn[0], rtn[1], rtn[2], return_value);
+    efree(rtn);
+}
+
+/**
+ * Convert the non-NULL `inputs`, freeing the converted ones on failure
+ *
+ * @return 0 on success, -1 with an exception thrown otherwise
+ */
+static int
+ndarray_dnn_inputs(zval **inputs, NDArray **nds, int count) {
+    int i;
+
+    for (i = 0; i < count; i++) {
+        nds[i] = NULL;
+        if (inputs[i] != NULL && (nds[i] = ZVAL_TO_NDARRAY(inputs[i])) == NULL) {
+            while (i-- > 0) {
+                CHECK_INPUT_AND_FREE(inputs[i], nds[i]);
+            }
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static void
+ndarray_dnn_free_inputs(zval **inputs, NDArray **nds, int count) {
+    int i;
+
+    for (i = 0; i < count; i++) {
+        CHECK_INPUT_AND_FREE(inputs[i], nds[i]);
+    }
+}
+
+/**
+ * Shared body of NumPower::softmax and NumPower::logSoftmax
+ */
+static void
+ndarray_softmax(zval *return_value, zval *a, int logarithmic) {
+    NDArray *nda = ZVAL_TO_NDARRAY(a), *rtn;
+
+    if (nda == NULL) {
+        return;
+    }
+    rtn = NDArrayDNN_Softmax(nda, logarithmic);
+    CHECK_INPUT_AND_FREE(a, nda);
+    if (rtn == NULL) {
+        return;
+    }
+    RETURN_NDARRAY(rtn, return_value);
+}
+
+/**
+ * NumPower::softmax
+ */
+ZEND_BEGIN_ARG_INFO(arginfo_ndarray_softmax, 0)
+ZEND_ARG_INFO(0, a)
+ZEND_END_ARG_INFO()
+PHP_METHOD(NumPower, softmax) {
+    zval *a;
+    ZEND_PARSE_PARAMETERS_START(1, 1)
+    Z_PARAM_ZVAL(a)
+    ZEND_PARSE_PARAMETERS_END();
+    ndarray_softmax(return_value, a, 0);
+}
+
+/**
+ * NumPower::logSoftmax
+ */
+ZEND_BEGIN_ARG_INFO(arginfo_ndarray_log_softmax, 0)
+ZEND_ARG_INFO(0, a)
+ZEND_END_ARG_INFO()
+PHP_METHOD(NumPower, logSoftmax) {
+    zval *a;
+    ZEND_PARSE_PARAMETERS_START(1, 1)
+    Z_PARAM_ZVAL(a)
+    ZEND_PARSE_PARAMETERS_END();
+    ndarray_softmax(return_value, a, 1);
+}
+
+/**
+ * NumPower::layerNorm
+ */
+ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_layer_norm, 0, 0, 1)
+ZEND_ARG_INFO(0, x)
+ZEND_ARG_INFO_WITH_DEFAULT_VALUE(0, gamma, "null")
+ZEND_ARG_INFO_WITH_DEFAULT_VALUE(0, beta, "null")
+ZEND_ARG_INFO_WITH_DEFAULT_VALUE(0, eps, "1.0E-5")
+ZEND_END_ARG_INFO()
+PHP_METHOD(NumPower, layerNorm) {
+    zval *inputs[3] = {NULL, NULL, NULL};
+    NDArray *nds[3], *rtn;
+    double eps = 1e-5;
+    ZEND_PARSE_PARAMETERS_START(1, 4)
+    Z_PARAM_ZVAL(inputs[0])
+    Z_PARAM_OPTIONAL
+    Z_PARAM_ZVAL_OR_NULL(inputs[1])
+    Z_PARAM_ZVAL_OR_NULL(inputs[2])
+    Z_PARAM_DOUBLE(eps)
+    ZEND_PARSE_PARAMETERS_END();
+    if (ndarray_dnn_inputs(inputs, nds, 3) != 0) {
+        return;
+    }
+    rtn = NDArrayDNN_LayerNorm(nds[0], nds[1], nds[2], eps);
+    ndarray_dnn_free_inputs(inputs, nds, 3);
+    if (rtn == NULL) {
+        return;
+    }
+    RETURN_NDARRAY(rtn, return_value);
+}
+
+/**
+ * NumPower::layerNormBackward
+ */
+ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_layer_norm_backward, 0, 0, 2)
+ZEND_ARG_INFO(0, grad)
+ZEND_ARG_INFO(0, x)
+ZEND_ARG_INFO_WITH_DEFAULT_VALUE(0, gamma, "null")
+ZEND_ARG_INFO_WITH_DEFAULT_VALUE(0, eps, "1.0E-5")
+ZEND_END_ARG_INFO()
+PHP_METHOD(NumPower, layerNormBackward) {
+    zval *inputs[3] = {NULL, NULL, NULL};
+    NDArray *nds[3], **rtn;
+    double eps = 1e-5;
+    ZEND_PARSE_PARAMETERS_START(2, 4)
+    Z_PARAM_ZVAL(inputs[0])
+    Z_PARAM_ZVAL(inputs[1])
+    Z_PARAM_OPTIONAL
+    Z_PARAM_ZVAL_OR_NULL(inputs[2])
+    Z_PARAM_DOUBLE(eps)
+    ZEND_PARSE_PARAMETERS_END();
+    if (ndarray_dnn_inputs(inputs, nds, 3) != 0) {
+        return;
+    }
+    rtn = NDArrayDNN_LayerNorm_Backward(nds[0], nds[1], nds[2], eps);
+    ndarray_dnn_free_inputs(inputs, nds, 3);
+    if (rtn == NULL) {
+        return;
+    }
+    RETURN_3NDARRAY(rtn[0], rtn[1], rtn[2], return_value);
+    efree(rtn);
+}
+
+/**
+ * NumPower::batchNorm
+ */
+ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_batch_norm, 0, 0, 1)
+ZEND_ARG_INFO(0, x)
+ZEND_ARG_INFO_WITH_DEFAULT_VALUE(0, gamma, "null")
+ZEND_ARG_INFO_WITH_DEFAULT_VALUE(0, beta, "null")
+ZEND_ARG_INFO_WITH_DEFAULT_VALUE(0, eps, "1.0E-5")
+ZEND_ARG_INFO_WITH_DEFAULT_VALUE(0, mean, "null")
+ZEND_ARG_INFO_WITH_DEFAULT_VALUE(0, var, "null")
+ZEND_END_ARG_INFO()
+PHP_METHOD(NumPower, batchNorm) {
+    zval *inputs[5] = {NULL, NULL, NULL, NULL, NULL};
+    NDArray *nds[5], **rtn;
+    double eps = 1e-5;
+    ZEND_PARSE_PARAMETERS_START(1, 6)
+    Z_PARAM_ZVAL(inputs[0])
+    Z_PARAM_OPTIONAL
+    Z_PARAM_ZVAL_OR_NULL(inputs[1])
+    Z_PARAM_ZVAL_OR_NULL(inputs[2])
+    Z_PARAM_DOUBLE(eps)
+    Z_PARAM_ZVAL_OR_NULL(inputs[3])
+    Z_PARAM_ZVAL_OR_NULL(inputs[4])
+    ZEND_PARSE_PARAMETERS_END();
+    if (ndarray_dnn_inputs(inputs, nds, 5) != 0) {
+        return;
+    }
+    rtn = NDArrayDNN_BatchNorm(nds[0], nds[1], nds[2], nds[3], nds[4], eps);
+    ndarray_dnn_free_inputs(inputs, nds, 5);
+    if (rtn == NULL) {
+        return;
+    }
+    RETURN_3NDARRAY(rtn[0], rtn[1], rtn[2], return_value);
+    efree(rtn);
+}
+
+/**
+ * NumPower::batchNormBackward
+ */
+ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_batch_norm_backward, 0, 0, 2)
+ZEND_ARG_INFO(0, grad)
+ZEND_ARG_INFO(0, x)
+ZEND_ARG_INFO_WITH_DEFAULT_VALUE(0, gamma, "null")
+ZEND_ARG_INFO_WITH_DEFAULT_VALUE(0, eps, "1.0E-5")
+ZEND_END_ARG_INFO()
+PHP_METHOD(NumPower, batchNormBackward) {
+    zval *inputs[3] = {NULL, NULL, NULL};
+    NDArray *nds[3], **rtn;
+    double eps = 1e-5;
+    ZEND_PARSE_PARAMETERS_START(2, 4)
+    Z_PARAM_ZVAL(inputs[0])
+    Z_PARAM_ZVAL(inputs[1])
+    Z_PARAM_OPTIONAL
+    Z_PARAM_ZVAL_OR_NULL(inputs[2])
+    Z_PARAM_DOUBLE(eps)
+    ZEND_PARSE_PARAMETERS_END();
+    if (ndarray_dnn_inputs(inputs, nds, 3) != 0) {
+        return;
+    }
+    rtn = NDArrayDNN_BatchNorm_Backward(nds[0], nds[1], nds[2], eps);
+    ndarray_dnn_free_inputs(inputs, nds, 3);
+    if (rtn == NULL) {
+        return;
+    }
+    RETURN_3NDARRAY(rtn[0], rtn[1], rtn[2], return_value);
+    efree(rtn);
+}
+
+/**
+ * Shared body of NumPower::crossEntropyWithLogits and its backward
+ */
+static void
+ndarray_cross_entropy(zval *return_value, zval *logits, zval *labels, int backward) {
+    zval *inputs[2] = {logits, labels};
+    NDArray *nds[2], *rtn = NULL;
+    int status;
+
+    if (ndarray_dnn_inputs(inputs, nds, 2) != 0) {
+        return;
+    }
+    status = NDArrayDNN_CrossEntropyWithLogits(nds[0], nds[1], backward ? NULL : &rtn, backward ? &rtn : NULL);
+    ndarray_dnn_free_inputs(inputs, nds, 2);
+    if (status != 0) {
+        return;
+    }
+    RETURN_NDARRAY(rtn, return_value);
+}
+
+/**
+ * NumPower::crossEntropyWithLogits
+ */
+ZEND_BEGIN_ARG_INFO(arginfo_ndarray_cross_entropy_with_logits, 0)
+ZEND_ARG_INFO(0, logits)
+ZEND_ARG_INFO(0, labels)
+ZEND_END_ARG_INFO()
+PHP_METHOD(NumPower, crossEntropyWithLogits) {
+    zval *logits, *labels;
+    ZEND_PARSE_PARAMETERS_START(2, 2)
+    Z_PARAM_ZVAL(logits)
+    Z_PARAM_ZVAL(labels)
+    ZEND_PARSE_PARAMETERS_END();
+    ndarray_cross_entropy(return_value, logits, labels, 0);
+}
+
+/**
+ * NumPower::crossEntropyWithLogitsBackward
+ */
+ZEND_BEGIN_ARG_INFO(arginfo_ndarray_cross_entropy_with_logits_backward, 0)
+ZEND_ARG_INFO(0, logits)
+ZEND_ARG_INFO(0, labels)
+ZEND_END_ARG_INFO()
+PHP_METHOD(NumPower, crossEntropyWithLogitsBackward) {
+    zval *logits, *labels;
+    ZEND_PARSE_PARAMETERS_START(2, 2)
+    Z_PARAM_ZVAL(logits)
+    Z_PARAM_ZVAL(labels)
+    ZEND_PARSE_PARAMETERS_END();
+    ndarray_cross_entropy(return_value, logits, labels, 1);
+}
+
+/**
+ * (height, width) pair of a pooling argument given as an integer or an
+ * array of `spatial` integers; 1-D pooling fills the width only
+ *
+ * @return 0 on success, -1 with an exception thrown otherwise
+ */
+static int
+ndarray_pool_pair(zval *arg, char *name, int spatial, int *pair) {
+    int size, *values = zval_axis_argument(arg, name, &size);
+
+    if (values == NULL) {
+        return -1;
+    }
+    if (size != 1 && size != spatial) {
+        zend_throw_error(NULL, "`%s` must be an integer or an array of %d integers.", name, spatial);
+        efree(values);
+        return -1;
+    }
+    pair[0] = values[0];
+    pair[1] = values[size - 1];
+    efree(values);
+    return 0;
+}
+
+/**
+ * Window and layout of a pooling call, `stride` defaults to the kernel
+ *
+ * @return 0 on success, -1 with an exception thrown otherwise
+ */
+static int
+ndarray_pool_arguments(NDArrayPool2D *pool, int spatial, zval *kernel, zval *stride, zval *padding,
+                       zend_string *layout) {
+    int first, last;
+
+    if (ndarray_pool_pair(kernel, "kernel", spatial, pool->kernel) != 0
+            || (stride != NULL && ndarray_pool_pair(stride, "stride", spatial, pool->stride) != 0)
+            || (padding != NULL && ndarray_pool_pair(padding, "padding", spatial, pool->padding) != 0)) {
+        return -1;
+    }
+    if (stride == NULL) {
+        memcpy(pool->stride, pool->kernel, sizeof(pool->stride));
+    }
+    if (padding == NULL) {
+        memset(pool->padding, 0, sizeof(pool->padding));
+    }
+    pool->channels_last = 0;
+    if (layout == NULL) {
+        return 0;
+    }
+    first = spatial == 2 ? zend_string_equals_literal_ci(layout, "NCHW") : zend_string_equals_literal_ci(layout, "NCW");
+    last = spatial == 2 ? zend_string_equals_literal_ci(layout, "NHWC") : zend_string_equals_literal_ci(layout, "NWC");
+    if (!first && !last) {
+        zend_throw_error(NULL, "Unknown layout '%s', expected '%s' or '%s'.", ZSTR_VAL(layout),
+                         spatial == 2 ? "NCHW" : "NCW", spatial == 2 ? "NHWC" : "NWC");
+        return -1;
+    }
+    pool->channels_last = last;
+    return 0;
+}
+
+/**
+ * Shared body of the max and average pooling forward methods
+ */
+static void
+ndarray_pool_forward(zval *return_value, int spatial, int max, zval *x, zval *kernel, zval *stride, zval *padding,
+                     zend_string *layout) {
+    NDArrayPool2D pool;
+    NDArray *ndx, *rtn, *argmax = NULL;
+
+    if (ndarray_pool_arguments(&pool, spatial, kernel, stride, padding, layout) != 0) {
+        return;
+    }
+    ndx = ZVAL_TO_NDARRAY(x);
+    if (ndx == NULL) {
+        return;
+    }
+    rtn = NDArrayDNN_Pool_Forward(ndx, &pool, spatial, max, max ? &argmax : NULL);
+    CHECK_INPUT_AND_FREE(x, ndx);
+    if (rtn == NULL) {
+        return;
+    }
+    if (max) {
+        RETURN_2NDARRAY(rtn, argmax, return_value);
+        return;
+    }
+    RETURN_NDARRAY(rtn, return_value);
+}
+
+/**
+ * Shared body of the average pooling backward methods
+ */
+static void
+ndarray_avg_pool_backward(zval *return_value, int spatial, zval *grad, zval *shape, zval *kernel, zval *stride,
+                          zval *padding, zend_string *layout) {
+    NDArrayPool2D pool;
+    NDArray *ndgrad, *rtn;
+    int ndim, *dims;
+
+    if (ndarray_pool_arguments(&pool, spatial, kernel, stride, padding, layout) != 0) {
+        return;
+    }
+    dims = zval_axis_argument(shape, "shape", &ndim);
+    if (dims == NULL) {
+        return;
+    }
+    ndgrad = ZVAL_TO_NDARRAY(grad);
+    if (ndgrad == NULL) {
+        efree(dims);
+        return;
+    }
+    rtn = NDArrayDNN_AvgPool_Backward(ndgrad, dims, ndim, &pool, spatial);
+    CHECK_INPUT_AND_FREE(grad, ndgrad);
+    efree(dims);
+    if (rtn == NULL) {
+        return;
+    }
+    RETURN_NDARRAY(rtn, return_value);
+}
+
+/**
+ * NumPower::maxPool1d
+ */
+ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_max_pool1d, 0, 0, 2)
+ZEND_ARG_INFO(0, x)
+ZEND_ARG_INFO(0, kernel)
+ZEND_ARG_INFO_WITH_DEFAULT_VALUE(0, stride, "null")
+ZEND_ARG_INFO_WITH_DEFAULT_VALUE(0, padding, "null")
+ZEND_ARG_INFO_WITH_DEFAULT_VALUE(0, layout, "\"NCW\"")
+ZEND_END_ARG_INFO()
+PHP_METHOD(NumPower, maxPool1d) {
+    zval *x, *kernel, *stride = NULL, *padding = NULL;
+    zend_string *layout = NULL;
+    ZEND_PARSE_PARAMETERS_START(2, 5)
+    Z_PARAM_ZVAL(x)
+    Z_PARAM_ZVAL(kernel)
+    Z_PARAM_OPTIONAL
+    Z_PARAM_ZVAL_OR_NULL(stride)
+    Z_PARAM_ZVAL_OR_NULL(padding)
+    Z_PARAM_STR_OR_NULL(layout)
+    ZEND_PARSE_PARAMETERS_END();
+    ndarray_pool_forward(return_value, 1, 1, x, kernel, stride, padding, layout);
+}
+
+/**
+ * NumPower::maxPool2d
+ */
+ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_max_pool2d, 0, 0, 2)
+ZEND_ARG_INFO(0, x)
+ZEND_ARG_INFO(0, kernel)
+ZEND_ARG_INFO_WITH_DEFAULT_VALUE(0, stride, "null")
+ZEND_ARG_INFO_WITH_DEFAULT_VALUE(0, padding, "null")
+ZEND_ARG_INFO_WITH_DEFAULT_VALUE(0, layout, "\"NCHW\"")
+ZEND_END_ARG_INFO()
+PHP_METHOD(NumPower, maxPool2d) {
+    zval *x, *kernel, *stride = NULL, *padding = NULL;
+    zend_string *layout = NULL;
+    ZEND_PARSE_PARAMETERS_START(2, 5)
+    Z_PARAM_ZVAL(x)
+    Z_PARAM_ZVAL(kernel)
+    Z_PARAM_OPTIONAL
+    Z_PARAM_ZVAL_OR_NULL(stride)
+    Z_PARAM_ZVAL_OR_NULL(padding)
+    Z_PARAM_STR_OR_NULL(layout)
+    ZEND_PARSE_PARAMETERS_END();
+    ndarray_pool_forward(return_value, 2, 1, x, kernel, stride, padding, layout);
+}
+
+/**
+ * NumPower::avgPool1d
+ */
+ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_avg_pool1d, 0, 0, 2)
+ZEND_ARG_INFO(0, x)
+ZEND_ARG_INFO(0, kernel)
+ZEND_ARG_INFO_WITH_DEFAULT_VALUE(0, stride, "null")
+ZEND_ARG_INFO_WITH_DEFAULT_VALUE(0, padding, "null")
+ZEND_ARG_INFO_WITH_DEFAULT_VALUE(0, layout, "\"NCW\"")
+ZEND_END_ARG_INFO()
+PHP_METHOD(NumPower, avgPool1d) {
+    zval *x, *kernel, *stride = NULL, *padding = NULL;
+    zend_string *layout = NULL;
+    ZEND_PARSE_PARAMETERS_START(2, 5)
+    Z_PARAM_ZVAL(x)
+    Z_PARAM_ZVAL(kernel)
+    Z_PARAM_OPTIONAL
+    Z_PARAM_ZVAL_OR_NULL(stride)
+    Z_PARAM_ZVAL_OR_NULL(padding)
+    Z_PARAM_STR_OR_NULL(layout)
+    ZEND_PARSE_PARAMETERS_END();
+    ndarray_pool_forward(return_value, 1, 0, x, kernel, stride, padding, layout);
+}
+
+/**
+ * NumPower::avgPool2d
+ */
+ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_avg_pool2d, 0, 0, 2)
+ZEND_ARG_INFO(0, x)
+ZEND_ARG_INFO(0, kernel)
+ZEND_ARG_INFO_WITH_DEFAULT_VALUE(0, stride, "null")
+ZEND_ARG_INFO_WITH_DEFAULT_VALUE(0, padding, "null")
+ZEND_ARG_INFO_WITH_DEFAULT_VALUE(0, layout, "\"NCHW\"")
+ZEND_END_ARG_INFO()
+PHP_METHOD(NumPower, avgPool2d) {
+    zval *x, *kernel, *stride = NULL, *padding = NULL;
+    zend_string *layout = NULL;
+    ZEND_PARSE_PARAMETERS_START(2, 5)
+    Z_PARAM_ZVAL(x)
+    Z_PARAM_ZVAL(kernel)
+    Z_PARAM_OPTIONAL
+    Z_PARAM_ZVAL_OR_NULL(stride)
+    Z_PARAM_ZVAL_OR_NULL(padding)
+    Z_PARAM_STR_OR_NULL(layout)
+    ZEND_PARSE_PARAMETERS_END();
+    ndarray_pool_forward(return_value, 2, 0, x, kernel, stride, padding, layout);
+}
+
+/**
+ * NumPower::maxPoolBackward
+ */
+ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_max_pool_backward, 0, 0, 3)
+ZEND_ARG_INFO(0, grad)
+ZEND_ARG_INFO(0, argmax)
+ZEND_ARG_INFO(0, shape)
+ZEND_END_ARG_INFO()
+PHP_METHOD(NumPower, maxPoolBackward) {
+    zval *inputs[2] = {NULL, NULL}, *shape;
+    NDArray *nds[2], *rtn;
+    int ndim, *dims;
+    ZEND_PARSE_PARAMETERS_START(3, 3)
+    Z_PARAM_ZVAL(inputs[0])
+    Z_PARAM_ZVAL(inputs[1])
+    Z_PARAM_ARRAY(shape)
+    ZEND_PARSE_PARAMETERS_END();
+    dims = zval_axis_argument(shape, "shape", &ndim);
+    if (dims == NULL) {
+        return;
+    }
+    if (ndarray_dnn_inputs(inputs, nds, 2) != 0) {
+        efree(dims);
+        return;
+    }
+    rtn = NDArrayDNN_MaxPool_Backward(nds[0], nds[1], dims, ndim);
+    ndarray_dnn_free_inputs(inputs, nds, 2);
+    efree(dims);
+    if (rtn == NULL) {
+        return;
+    }
+    RETURN_NDARRAY(rtn, return_value);
+}
+
+/**
+ * NumPower::avgPool1dBackward
+ */
+ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_avg_pool1d_backward, 0, 0, 3)
+ZEND_ARG_INFO(0, grad)
+ZEND_ARG_INFO(0, shape)
+ZEND_ARG_INFO(0, kernel)
+ZEND_ARG_INFO_WITH_DEFAULT_VALUE(0, stride, "null")
+ZEND_ARG_INFO_WITH_DEFAULT_VALUE(0, padding, "null")
+ZEND_ARG_INFO_WITH_DEFAULT_VALUE(0, layout, "\"NCW\"")
+ZEND_END_ARG_INFO()
+PHP_METHOD(NumPower, avgPool1dBackward) {
+    zval *grad, *shape, *kernel, *stride = NULL, *padding = NULL;
+    zend_string *layout = NULL;
+    ZEND_PARSE_PARAMETERS_START(3, 6)
+    Z_PARAM_ZVAL(grad)
+    Z_PARAM_ARRAY(shape)
+    Z_PARAM_ZVAL(kernel)
+    Z_PARAM_OPTIONAL
+    Z_PARAM_ZVAL_OR_NULL(stride)
+    Z_PARAM_ZVAL_OR_NULL(padding)
+    Z_PARAM_STR_OR_NULL(layout)
+    ZEND_PARSE_PARAMETERS_END();
+    ndarray_avg_pool_backward(return_value, 1, grad, shape, kernel, stride, padding, layout);
+}
+
+/**
+ * NumPower::avgPool2dBackward
+ */
+ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_avg_pool2d_backward, 0, 0, 3)
+ZEND_ARG_INFO(0, grad)
+ZEND_ARG_INFO(0, shape)
+ZEND_ARG_INFO(0, kernel)
+ZEND_ARG_INFO_WITH_DEFAULT_VALUE(0, stride, "null")
+ZEND_ARG_INFO_WITH_DEFAULT_VALUE(0, padding, "null")
+ZEND_ARG_INFO_WITH_DEFAULT_VALUE(0, layout, "\"NCHW\"")
+ZEND_END_ARG_INFO()
+PHP_METHOD(NumPower, avgPool2dBackward) {
+    zval *grad, *shape, *kernel, *stride = NULL, *padding = NULL;
+    zend_string *layout = NULL;
+    ZEND_PARSE_PARAMETERS_START(3, 6)
+    Z_PARAM_ZVAL(grad)
+    Z_PARAM_ARRAY(shape)
+    Z_PARAM_ZVAL(kernel)
+    Z_PARAM_OPTIONAL
+    Z_PARAM_ZVAL_OR_NULL(stride)
+    Z_PARAM_ZVAL_OR_NULL(padding)
+    Z_PARAM_STR_OR_NULL(layout)
+    ZEND_PARSE_PARAMETERS_END();
+    ndarray_avg_pool_backward(return_value, 2, grad, shape, kernel, stride, padding, layout);
+}
+
 /**
  * NumPower::convolve2d
  */
@@ -4572,25 +7222,48 @@ PHP_METHOD(NumPower, correlate2d) {
 /**
  * NumPower::norm
  */
-ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_norm, 2, 0, 1)
+ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_norm, 0, 0, 1)
 ZEND_ARG_INFO(0, a)
 ZEND_ARG_INFO(0, order)
+ZEND_ARG_INFO(0, axis)
 ZEND_END_ARG_INFO()
 PHP_METHOD(NumPower, norm) {
     NDArray *rtn;
-    zval *a;
-    long order = 2;
-    ZEND_PARSE_PARAMETERS_START(1, 2)
+    zval *a, *order = NULL;
+    zend_long axis = NDARRAY_MAX_DIMS;
+    bool axis_is_null = true;
+    double ord = 2;
+    int frobenius = 0, nuclear = 0;
+    ZEND_PARSE_PARAMETERS_START(1, 3)
     Z_PARAM_ZVAL(a)
     Z_PARAM_OPTIONAL
-    Z_PARAM_LONG(order)
-    ZEND_PARSE_PARAMETERS_END();
+    Z_PARAM_ZVAL(order)
+    Z_PARAM_LONG_OR_NULL(axis, axis_is_null)
+    ZEND_PARSE_PARAMETERS_END();
+    if (order != NULL) {
+        if (Z_TYPE_P(order) == IS_LONG || Z_TYPE_P(order) == IS_DOUBLE) {
+            ord = zval_get_double(order);
+        } else if (Z_TYPE_P(order) == IS_STRING && zend_string_equals_literal(Z_STR_P(order), "fro") && axis_is_null) {
+            frobenius = 1;
+        } else if (Z_TYPE_P(order) == IS_STRING && zend_string_equals_literal(Z_STR_P(order), "nuc") && axis_is_null) {
+            nuclear = 1;
+        } else {
+            zend_throw_error(NULL, "Invalid norm order.");
+            return;
+        }
+    }
     NDArray *nda = ZVAL_TO_NDARRAY(a);
     if (nda == NULL) {
         return;
     }
 
-    rtn = NDArray_Norm(nda, (int)order);
+    if (frobenius) {
+        rtn = NDArray_FrobeniusNorm(nda);
+    } else if (nuclear) {
+        rtn = NDArray_NuclearNorm(nda);
+    } else {
+        rtn = NDArray_Norm(nda, ord, axis_is_null ? NDARRAY_MAX_DIMS : (int)axis);
+    }
 
     CHECK_INPUT_AND_FREE(a, nda);
     RETURN_NDARRAY(rtn, return_value);
@@ -4647,25 +7320,56 @@ PHP_METHOD(NumPower, inv) {
 /**
  * NumPower::svd
  */
-ZEND_BEGIN_ARG_INFO(arginfo_ndarray_svd, 0)
+ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_svd, 0, 0, 1)
 ZEND_ARG_INFO(0, a)
+ZEND_ARG_INFO_WITH_DEFAULT_VALUE(0, compute_uv, "true")
+ZEND_ARG_INFO_WITH_DEFAULT_VALUE(0, k, "null")
+ZEND_ARG_INFO_WITH_DEFAULT_VALUE(0, oversamples, "10")
+ZEND_ARG_INFO_WITH_DEFAULT_VALUE(0, power_iterations, "2")
 ZEND_END_ARG_INFO()
 PHP_METHOD(NumPower, svd) {
-    NDArray **rtns;
-    zval *a, *b;
-    long axis;
-    ZEND_PARSE_PARAMETERS_START(1, 1)
+    NDArray **rtns, *rtn;
+    zval *a;
+    bool compute_uv = true;
+    zend_long k = 0, oversamples = 10, power_iterations = 2;
+    bool k_is_null = true;
+    ZEND_PARSE_PARAMETERS_START(1, 5)
     Z_PARAM_ZVAL(a)
+    Z_PARAM_OPTIONAL
+    Z_PARAM_BOOL(compute_uv)
+    Z_PARAM_LONG_OR_NULL(k, k_is_null)
+    Z_PARAM_LONG(oversamples)
+    Z_PARAM_LONG(power_iterations)
     ZEND_PARSE_PARAMETERS_END();
     NDArray *nda = ZVAL_TO_NDARRAY(a);
     if (nda == NULL) {
         return;
     }
-    rtns = NDArray_SVD(nda);
-    if (rtns == NULL) {
+    if (!k_is_null) {
+        rtns = NDArray_RandomizedSVD(nda, (int)k, (int)oversamples, (int)power_iterations);
+    } else if (!compute_uv) {
+        rtn = NDArray_SingularValues(nda);
+        CHECK_INPUT_AND_FREE(a, nda);
+        if (rtn == NULL) {
+            return;
+        }
+        RETURN_NDARRAY(rtn, return_value);
         return;
+    } else {
+        rtns = NDArray_SVD(nda);
     }
     CHECK_INPUT_AND_FREE(a, nda);
+    if (rtns == NULL) {
+        return;
+    }
+    if (!compute_uv) {
+        NDArray_FREE(rtns[0]);
+        NDArray_FREE(rtns[2]);
+        rtn = rtns[1];
+        efree(rtns);
+        RETURN_NDARRAY(rtn, return_value);
+        return;
+    }
     RETURN_3NDARRAY(rtns[0], rtns[1], rtns[2], return_value);
     efree(rtns);
 }
@@ -4716,7 +7420,7 @@ PHP_METHOD(NumPower, sum) {
     if (ZEND_NUM_ARGS() == 2) {
         rtn = reduce(nda, &axis_i, NDArray_Add_Float);
     } else {
-        double value = NDArray_Sum_Float(nda);
+        double value = NDArray_Sum(nda);
         CHECK_INPUT_AND_FREE(a, nda);
         RETURN_DOUBLE(value);
         return;
@@ -4751,7 +7455,7 @@ PHP_METHOD(NumPower, min) {
         axis_i = (int)axis;
         rtn = single_reduce(nda, &axis_i, NDArray_Min);
     } else {
-        value = NDArray_Min(nda);
+        value = NDArray_AMin(nda);
         CHECK_INPUT_AND_FREE(a, nda);
         RETURN_DOUBLE(value);
         return;
@@ -4790,7 +7494,7 @@ PHP_METHOD(NumPower, max) {
         axis_i = (int)axis;
         rtn = NDArray_MaxAxis(nda, axis_i);
     } else {
-        value = NDArray_Max(nda);
+        value = NDArray_AMax(nda);
         CHECK_INPUT_AND_FREE(a, nda);
         RETURN_DOUBLE(value);
         return;
@@ -4808,7 +7512,7 @@ PHP_METHOD(NumPower, prod) {
     zval *a;
     long axis;
     int axis_i;
-    float value;
+    double value;
     ZEND_PARSE_PARAMETERS_START(1, 2)
     Z_PARAM_ZVAL(a)
     Z_PARAM_OPTIONAL
@@ -4822,7 +7526,7 @@ PHP_METHOD(NumPower, prod) {
     if (ZEND_NUM_ARGS() == 2) {
         rtn = reduce(nda, &axis_i, NDArray_Multiply_Float);
     } else {
-        value = NDArray_Float_Prod(nda);
+        value = NDArray_Prod(nda);
         CHECK_INPUT_AND_FREE(a, nda);
         RETURN_DOUBLE(value);
         return;
@@ -4831,20 +7535,40 @@ PHP_METHOD(NumPower, prod) {
     RETURN_NDARRAY(rtn, return_value);
 }
 
-ZEND_BEGIN_ARG_INFO(arginfo_ndarray_array, 0)
+ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_array, 0, 0, 1)
 ZEND_ARG_INFO(0, a)
+ZEND_ARG_INFO(0, dtype)
 ZEND_END_ARG_INFO()
 PHP_METHOD(NumPower, array) {
     NDArray *rtn = NULL;
     zval *a;
     long axis;
-    ZEND_PARSE_PARAMETERS_START(1, 1)
+    char *dtype = "float32";
+    size_t dtype_len;
+    const char *type;
+    ZEND_PARSE_PARAMETERS_START(1, 2)
         Z_PARAM_ZVAL(a)
+        Z_PARAM_OPTIONAL
+        Z_PARAM_STRING(dtype, dtype_len)
     ZEND_PARSE_PARAMETERS_END();
+    type = ndarray_dtype_argument(dtype);
+    if (type == NULL) {
+        return;
+    }
+    if (Z_TYPE_P(a) == IS_ARRAY) {
+        RETURN_NDARRAY(Create_NDArray_FromZvalType(a, type), return_value);
+        return;
+    }
     NDArray *nda = ZVAL_TO_NDARRAY(a);
     if (nda == NULL) {
         return;
     }
+    if (!is_type(NDArray_TYPE(nda), type)) {
+        rtn = NDArray_AsType(nda, type);
+        CHECK_INPUT_AND_FREE(a, nda);
+        RETURN_NDARRAY(rtn, return_value);
+        return;
+    }
     RETURN_NDARRAY(nda, return_value);
 }
 
@@ -4920,15 +7644,50 @@ PHP_METHOD(NDArray, count) {
     RETURN_LONG(NDArray_SHAPE(ndarray)[0]);
 }
 
+/**
+ * Validate `index` against the first axis of `array`, negative
+ * indexes count from the end.
+ *
+ * @return 0 on success, -1 if the index is out of bounds
+ */
+static int
+ndarray_normalize_index(NDArray *array, zend_long *index)
+{
+    if (NDArray_NDIM(array) == 0) {
+        zend_throw_error(NULL, "Cannot index a 0-dimensional array");
+        return -1;
+    }
+    if (*index < 0) {
+        *index += NDArray_SHAPE(array)[0];
+    }
+    if (*index < 0 || *index >= NDArray_SHAPE(array)[0]) {
+        zend_throw_error(NULL, "Index out of bounds");
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * Return the element or row `index` of `array`. Elements of 1-D CPU
+ * arrays are read in place, everything else is returned as a row view.
+ */
+static void
+ndarray_get_index(NDArray *array, zend_long index, zval *return_value)
+{
+    if (NDArray_NDIM(array) == 1 && NDArray_DEVICE(array) == NDARRAY_DEVICE_CPU) {
+        NDArray_ItemToZval(array, NDArray_DATA(array) + (index * NDArray_STRIDES(array)[0]), return_value);
+        return;
+    }
+    RETURN_NDARRAY(NDArrayIterator_ROW(array, (int)index), return_value);
+}
+
 PHP_METHOD(NDArray, current) {
     zend_object *obj = Z_OBJ_P(ZEND_THIS);
     ZEND_PARSE_PARAMETERS_START(0, 0)
     ZEND_PARSE_PARAMETERS_END();
     zval *obj_uuid = OBJ_PROP_NUM(obj, 0);
     NDArray* ndarray = ZVALUUID_TO_NDARRAY(obj_uuid);
-    NDArray* result  = NDArrayIteratorPHP_GET(ndarray);
-    add_to_buffer(result);
-    RETURN_NDARRAY(result, return_value);
+    ndarray_get_index(ndarray, ndarray->php_iterator->current_index, return_value);
 }
 
 PHP_METHOD(NDArray, key) {
@@ -4980,25 +7739,26 @@ PHP_METHOD(NDArray, offsetExists) {
 PHP_METHOD(NDArray, offsetGet) {
     zend_object *obj = Z_OBJ_P(ZEND_THIS);
     zval *offset;
+    zend_long index;
     ZEND_PARSE_PARAMETERS_START(1, 1)
     Z_PARAM_ZVAL(offset)
     ZEND_PARSE_PARAMETERS_END();
     zval *obj_uuid = OBJ_PROP_NUM(obj, 0);
     NDArray* ndarray = ZVALUUID_TO_NDARRAY(obj_uuid);
     if (Z_TYPE_P(offset) == IS_LONG) {
-        if (Z_LVAL_P(offset) < 0) {
-            zend_throw_error(NULL, "Negative indexes are not implemented.");
+        index = Z_LVAL_P(offset);
+        if (ndarray_normalize_index(ndarray, &index) < 0) {
             return;
         }
-
-        if (Z_LVAL_P(offset) > NDArray_SHAPE(ndarray)[0] - 1) {
-            zend_throw_error(NULL, "Index out of bounds");
+        ndarray_get_index(ndarray, index, return_value);
+        return;
+    }
+    if (Z_TYPE_P(offset) == IS_OBJECT && Z_OBJCE_P(offset) == phpsci_ce_NDArray) {
+        NDArray *mask = ZVAL_TO_NDARRAY(offset);
+        if (mask == NULL) {
             return;
         }
-        ndarray->iterator->current_index = (int) Z_LVAL_P(offset);
-        NDArray *rtn = NDArrayIterator_GET(ndarray);
-        NDArrayIterator_REWIND(ndarray);
-        RETURN_NDARRAY(rtn, return_value);
+        RETURN_NDARRAY(NDArray_MaskSelect(ndarray, mask), return_value);
         return;
     }
     zend_throw_error(NULL, "Invalid offset");
@@ -5009,6 +7769,7 @@ PHP_METHOD(NDArray, offsetSet) {
     zend_object *obj = Z_OBJ_P(ZEND_THIS);
     zval *offset;
     zval *value;
+    zend_long index;
     ZEND_PARSE_PARAMETERS_START(2, 2)
     Z_PARAM_ZVAL(offset)
     Z_PARAM_ZVAL(value)
@@ -5016,25 +7777,40 @@ PHP_METHOD(NDArray, offsetSet) {
     zval *obj_uuid = OBJ_PROP_NUM(obj, 0);
     NDArray* ndarray = ZVALUUID_TO_NDARRAY(obj_uuid);
     if (Z_TYPE_P(offset) == IS_LONG || Z_TYPE_P(offset) == IS_DOUBLE) {
-        if (zval_get_long(offset) < 0) {
-            zend_throw_error(NULL, "Negative indexes are not implemented.");
+        index = zval_get_long(offset);
+        if (ndarray_normalize_index(ndarray, &index) < 0) {
             return;
         }
-        if (zval_get_long(offset) > NDArray_SHAPE(ndarray)[0] - 1) {
-            zend_throw_error(NULL, "Index out of bounds");
+        if (NDArray_NDIM(ndarray) == 1 && NDArray_DEVICE(ndarray) == NDARRAY_DEVICE_CPU &&
+            (Z_TYPE_P(value) == IS_LONG || Z_TYPE_P(value) == IS_DOUBLE)) {
+            NDArray_EnsureWritable(ndarray);
+            NDArray_TypeFuncs(NDArray_TYPE(ndarray))->setitem(
+                    NDArray_DATA(ndarray) + (index * NDArray_STRIDES(ndarray)[0]), zval_get_double(value));
             return;
         }
         NDArray* nd_value = ZVAL_TO_NDARRAY(value);
-        ndarray->iterator->current_index = (int)zval_get_long(offset);
-        NDArray *rtn = NDArrayIterator_GET(ndarray);
-        NDArrayIterator_REWIND(ndarray);
+        if (nd_value == NULL) {
+            return;
+        }
+        // Rows of copy-on-write arrays would copy themselves, detach the parent first
+        NDArray_EnsureWritable(ndarray);
+        NDArray *rtn = NDArrayIterator_ROW(ndarray, (int)index);
         NDArray_Overwrite(rtn, nd_value);
         NDArray_FREE(rtn);
         CHECK_INPUT_AND_FREE(value, nd_value);
+        return;
     }
-    if (Z_TYPE_P(offset) == IS_OBJECT && (Z_TYPE_P(value) == IS_LONG || Z_TYPE_P(value) == IS_OBJECT)) {
-
+    if (Z_TYPE_P(offset) == IS_OBJECT && Z_OBJCE_P(offset) == phpsci_ce_NDArray) {
+        NDArray *mask = ZVAL_TO_NDARRAY(offset);
+        NDArray *nd_value = ZVAL_TO_NDARRAY(value);
+        if (mask == NULL || nd_value == NULL) {
+            return;
+        }
+        NDArray_MaskAssign(ndarray, mask, nd_value);
+        CHECK_INPUT_AND_FREE(value, nd_value);
+        return;
     }
+    zend_throw_error(NULL, "Invalid offset");
 }
 
 PHP_METHOD(NDArray, __serialize) {
@@ -5046,16 +7822,9 @@ PHP_METHOD(NDArray, __serialize) {
     if (array == NULL) {
         return;
     }
-    if (NDArray_DEVICE(array) == NDARRAY_DEVICE_GPU) {
-        zend_throw_error(NULL, "NDArray must be on CPU RAM before it can be converted to a PHP array.");
-        return;
-    }
-    if (NDArray_NDIM(array) == 0) {
-        RETURN_DOUBLE(NDArray_FDATA(array)[0]);
-        NDArray_FREE(array);
+    if (NDArray_Serialize(array, &rtn) < 0) {
         return;
     }
-    rtn = NDArray_ToPHPArray(array);
     RETURN_ZVAL(&rtn, 0, 0);
 }
 
@@ -5066,7 +7835,16 @@ PHP_METHOD(NDArray, __unserialize) {
     ZEND_PARSE_PARAMETERS_START(1, 1)
         Z_PARAM_ZVAL(data)
     ZEND_PARSE_PARAMETERS_END();
-    NDArray *nda = ZVAL_TO_NDARRAY(data);
+    NDArray *nda;
+    if (NDArray_IsSerialized(data)) {
+        nda = NDArray_Unserialize(data);
+    } else {
+        // Legacy format: nested PHP array
+        nda = ZVAL_TO_NDARRAY(data);
+    }
+    if (nda == NULL) {
+        return;
+    }
     add_to_buffer(nda);
     ZVAL_LONG(OBJ_PROP_NUM(obj, 0), NDArray_UUID(nda));
 }
@@ -5107,6 +7885,348 @@ PHP_METHOD(NDArray, __toString) {
     RETVAL_STRING(result);
     efree(result);
 }
+/**
+ * NDArrayExpression::eval
+ */
+ZEND_BEGIN_ARG_INFO(arginfo_ndarray_expression_eval, 0)
+ZEND_END_ARG_INFO()
+PHP_METHOD(NDArrayExpression, eval) {
+    ZEND_PARSE_PARAMETERS_NONE();
+    NDArrayExpr *expr = ndarray_expression_get(ZEND_THIS);
+    if (expr == NULL) {
+        return;
+    }
+    RETURN_NDARRAY(NDArrayExpr_Evaluate(expr), return_value);
+}
+
+static const zend_function_entry class_NDArrayExpression_methods[] = {
+    ZEND_ME(NDArrayExpression, eval, arginfo_ndarray_expression_eval, ZEND_ACC_PUBLIC)
+    PHP_FE_END
+};
+
+/**
+ * LUFactorization::solve
+ */
+ZEND_BEGIN_ARG_INFO(arginfo_lu_factorization_solve, 0)
+ZEND_ARG_INFO(0, b)
+ZEND_END_ARG_INFO()
+PHP_METHOD(LUFactorization, solve) {
+    NDArray *rtn;
+    zval *b;
+    ZEND_PARSE_PARAMETERS_START(1, 1)
+    Z_PARAM_ZVAL(b)
+    ZEND_PARSE_PARAMETERS_END();
+    NDArrayLUFactor *factor = lu_factorization_get(ZEND_THIS);
+    if (factor == NULL) {
+        return;
+    }
+    NDArray *ndb = ZVAL_TO_NDARRAY(b);
+    if (ndb == NULL) {
+        return;
+    }
+    rtn = NDArray_LUFactorSolve(factor, ndb);
+    CHECK_INPUT_AND_FREE(b, ndb);
+    RETURN_NDARRAY(rtn, return_value);
+}
+
+/**
+ * LUFactorization::permutation
+ */
+ZEND_BEGIN_ARG_INFO(arginfo_lu_factorization_permutation, 0)
+ZEND_END_ARG_INFO()
+PHP_METHOD(LUFactorization, permutation) {
+    ZEND_PARSE_PARAMETERS_NONE();
+    NDArrayLUFactor *factor = lu_factorization_get(ZEND_THIS);
+    if (factor == NULL) {
+        return;
+    }
+    RETURN_NDARRAY(NDArray_LUFactorPermutation(factor), return_value);
+}
+
+/**
+ * LUFactorization::lower
+ */
+ZEND_BEGIN_ARG_INFO(arginfo_lu_factorization_lower, 0)
+ZEND_END_ARG_INFO()
+PHP_METHOD(LUFactorization, lower) {
+    ZEND_PARSE_PARAMETERS_NONE();
+    NDArrayLUFactor *factor = lu_factorization_get(ZEND_THIS);
+    if (factor == NULL) {
+        return;
+    }
+    RETURN_NDARRAY(NDArray_LUFactorLower(factor), return_value);
+}
+
+/**
+ * LUFactorization::upper
+ */
+ZEND_BEGIN_ARG_INFO(arginfo_lu_factorization_upper, 0)
+ZEND_END_ARG_INFO()
+PHP_METHOD(LUFactorization, upper) {
+    ZEND_PARSE_PARAMETERS_NONE();
+    NDArrayLUFactor *factor = lu_factorization_get(ZEND_THIS);
+    if (factor == NULL) {
+        return;
+    }
+    RETURN_NDARRAY(NDArray_LUFactorUpper(factor), return_value);
+}
+
+static const zend_function_entry class_LUFactorization_methods[] = {
+    ZEND_ME(LUFactorization, solve, arginfo_lu_factorization_solve, ZEND_ACC_PUBLIC)
+    ZEND_ME(LUFactorization, permutation, arginfo_lu_factorization_permutation, ZEND_ACC_PUBLIC)
+    ZEND_ME(LUFactorization, lower, arginfo_lu_factorization_lower, ZEND_ACC_PUBLIC)
+    ZEND_ME(LUFactorization, upper, arginfo_lu_factorization_upper, ZEND_ACC_PUBLIC)
+    PHP_FE_END
+};
+
+/**
+ * @param format "csr" or "coo"
+ * @return NDARRAY_SPARSE_CSR, NDARRAY_SPARSE_COO or -1 with an exception thrown
+ */
+static int sparse_ndarray_format(zend_string *format) {
+    if (zend_string_equals_literal_ci(format, "csr")) {
+        return NDARRAY_SPARSE_CSR;
+    }
+    if (zend_string_equals_literal_ci(format, "coo")) {
+        return NDARRAY_SPARSE_COO;
+    }
+    zend_throw_error(NULL, "Unknown sparse format '%s', expected 'csr' or 'coo'.", ZSTR_VAL(format));
+    return -1;
+}
+
+/**
+ * SparseNDArray::fromTriplets
+ */
+ZEND_BEGIN_ARG_INFO_EX(arginfo_sparse_ndarray_from_triplets, 0, 0, 4)
+ZEND_ARG_INFO(0, rows)
+ZEND_ARG_INFO(0, cols)
+ZEND_ARG_INFO(0, values)
+ZEND_ARG_INFO(0, shape)
+ZEND_ARG_INFO(0, format)
+ZEND_END_ARG_INFO()
+PHP_METHOD(SparseNDArray, fromTriplets) {
+    zval *rows, *cols, *values, *shape, *dim;
+    zend_string *format = NULL;
+    NDArray *ndr, *ndc = NULL, *ndv = NULL;
+    NDArraySparse *sparse = NULL;
+    int fmt = NDARRAY_SPARSE_CSR, dims[2], i = 0;
+    ZEND_PARSE_PARAMETERS_START(4, 5)
+    Z_PARAM_ZVAL(rows)
+    Z_PARAM_ZVAL(cols)
+    Z_PARAM_ZVAL(values)
+    Z_PARAM_ARRAY(shape)
+    Z_PARAM_OPTIONAL
+    Z_PARAM_STR(format)
+    ZEND_PARSE_PARAMETERS_END();
+    if (format != NULL && (fmt = sparse_ndarray_format(format)) < 0) {
+        return;
+    }
+    if (zend_hash_num_elements(Z_ARRVAL_P(shape)) != 2) {
+        zend_throw_error(NULL, "shape must have two dimensions.");
+        return;
+    }
+    ZEND_HASH_FOREACH_VAL(Z_ARRVAL_P(shape), dim) {
+        dims[i++] = (int) zval_get_long(dim);
+    } ZEND_HASH_FOREACH_END();
+    ndr = ZVAL_TO_NDARRAY(rows);
+    if (ndr != NULL) {
+        ndc = ZVAL_TO_NDARRAY(cols);
+    }
+    if (ndc != NULL) {
+        ndv = ZVAL_TO_NDARRAY(values);
+    }
+    if (ndv != NULL) {
+        sparse = NDArray_SparseFromTriplets(ndr, ndc, ndv, dims[0], dims[1], fmt);
+    }
+    CHECK_INPUT_AND_FREE(rows, ndr);
+    CHECK_INPUT_AND_FREE(cols, ndc);
+    CHECK_INPUT_AND_FREE(values, ndv);
+    RETURN_SPARSE_NDARRAY(sparse, return_value);
+}
+
+/**
+ * SparseNDArray::fromDense
+ */
+ZEND_BEGIN_ARG_INFO_EX(arginfo_sparse_ndarray_from_dense, 0, 0, 1)
+ZEND_ARG_INFO(0, a)
+ZEND_ARG_INFO(0, format)
+ZEND_END_ARG_INFO()
+PHP_METHOD(SparseNDArray, fromDense) {
+    zval *a;
+    zend_string *format = NULL;
+    NDArraySparse *sparse;
+    int fmt = NDARRAY_SPARSE_CSR;
+    ZEND_PARSE_PARAMETERS_START(1, 2)
+    Z_PARAM_ZVAL(a)
+    Z_PARAM_OPTIONAL
+    Z_PARAM_STR(format)
+    ZEND_PARSE_PARAMETERS_END();
+    if (format != NULL && (fmt = sparse_ndarray_format(format)) < 0) {
+        return;
+    }
+    NDArray *nda = ZVAL_TO_NDARRAY(a);
+    if (nda == NULL) {
+        return;
+    }
+    sparse = NDArray_SparseFromDense(nda, fmt);
+    CHECK_INPUT_AND_FREE(a, nda);
+    RETURN_SPARSE_NDARRAY(sparse, return_value);
+}
+
+/**
+ * SparseNDArray::toDense
+ */
+ZEND_BEGIN_ARG_INFO(arginfo_sparse_ndarray_to_dense, 0)
+ZEND_END_ARG_INFO()
+PHP_METHOD(SparseNDArray, toDense) {
+    ZEND_PARSE_PARAMETERS_NONE();
+    NDArraySparse *sparse = sparse_ndarray_get(ZEND_THIS);
+    if (sparse == NULL) {
+        return;
+    }
+    RETURN_NDARRAY(NDArray_SparseToDense(sparse), return_value);
+}
+
+/**
+ * SparseNDArray::toCSR
+ */
+ZEND_BEGIN_ARG_INFO(arginfo_sparse_ndarray_to_csr, 0)
+ZEND_END_ARG_INFO()
+PHP_METHOD(SparseNDArray, toCSR) {
+    ZEND_PARSE_PARAMETERS_NONE();
+    NDArraySparse *sparse = sparse_ndarray_get(ZEND_THIS);
+    if (sparse == NULL) {
+        return;
+    }
+    RETURN_SPARSE_NDARRAY(NDArray_SparseAsFormat(sparse, NDARRAY_SPARSE_CSR), return_value);
+}
+
+/**
+ * SparseNDArray::toCOO
+ */
+ZEND_BEGIN_ARG_INFO(arginfo_sparse_ndarray_to_coo, 0)
+ZEND_END_ARG_INFO()
+PHP_METHOD(SparseNDArray, toCOO) {
+    ZEND_PARSE_PARAMETERS_NONE();
+    NDArraySparse *sparse = sparse_ndarray_get(ZEND_THIS);
+    if (sparse == NULL) {
+        return;
+    }
+    RETURN_SPARSE_NDARRAY(NDArray_SparseAsFormat(sparse, NDARRAY_SPARSE_COO), return_value);
+}
+
+/**
+ * SparseNDArray::transpose
+ */
+ZEND_BEGIN_ARG_INFO(arginfo_sparse_ndarray_transpose, 0)
+ZEND_END_ARG_INFO()
+PHP_METHOD(SparseNDArray, transpose) {
+    ZEND_PARSE_PARAMETERS_NONE();
+    NDArraySparse *sparse = sparse_ndarray_get(ZEND_THIS);
+    if (sparse == NULL) {
+        return;
+    }
+    RETURN_SPARSE_NDARRAY(NDArray_SparseTranspose(sparse), return_value);
+}
+
+/**
+ * SparseNDArray::rows
+ */
+ZEND_BEGIN_ARG_INFO_EX(arginfo_sparse_ndarray_rows, 0, 0, 1)
+ZEND_ARG_INFO(0, start)
+ZEND_ARG_INFO(0, stop)
+ZEND_END_ARG_INFO()
+PHP_METHOD(SparseNDArray, rows) {
+    zend_long start, stop = 0;
+    bool stop_is_null = true;
+    ZEND_PARSE_PARAMETERS_START(1, 2)
+    Z_PARAM_LONG(start)
+    Z_PARAM_OPTIONAL
+    Z_PARAM_LONG_OR_NULL(stop, stop_is_null)
+    ZEND_PARSE_PARAMETERS_END();
+    NDArraySparse *sparse = sparse_ndarray_get(ZEND_THIS);
+    if (sparse == NULL) {
+        return;
+    }
+    if (stop_is_null) {
+        stop = sparse->shape[0];
+    }
+    RETURN_SPARSE_NDARRAY(NDArray_SparseRows(sparse, (int) start, (int) stop), return_value);
+}
+
+/**
+ * SparseNDArray::matmul
+ */
+ZEND_BEGIN_ARG_INFO(arginfo_sparse_ndarray_matmul, 0)
+ZEND_ARG_INFO(0, b)
+ZEND_END_ARG_INFO()
+PHP_METHOD(SparseNDArray, matmul) {
+    zval *b;
+    ZEND_PARSE_PARAMETERS_START(1, 1)
+    Z_PARAM_ZVAL(b)
+    ZEND_PARSE_PARAMETERS_END();
+    sparse_ndarray_product(ZEND_THIS, b, return_value);
+}
+
+/**
+ * SparseNDArray::shape
+ */
+ZEND_BEGIN_ARG_INFO(arginfo_sparse_ndarray_shape, 0)
+ZEND_END_ARG_INFO()
+PHP_METHOD(SparseNDArray, shape) {
+    ZEND_PARSE_PARAMETERS_NONE();
+    NDArraySparse *sparse = sparse_ndarray_get(ZEND_THIS);
+    if (sparse == NULL) {
+        return;
+    }
+    array_init_size(return_value, 2);
+    add_next_index_long(return_value, sparse->shape[0]);
+    add_next_index_long(return_value, sparse->shape[1]);
+}
+
+/**
+ * SparseNDArray::nnz
+ */
+ZEND_BEGIN_ARG_INFO(arginfo_sparse_ndarray_nnz, 0)
+ZEND_END_ARG_INFO()
+PHP_METHOD(SparseNDArray, nnz) {
+    ZEND_PARSE_PARAMETERS_NONE();
+    NDArraySparse *sparse = sparse_ndarray_get(ZEND_THIS);
+    if (sparse == NULL) {
+        return;
+    }
+    RETURN_LONG(sparse->nnz);
+}
+
+/**
+ * SparseNDArray::format
+ */
+ZEND_BEGIN_ARG_INFO(arginfo_sparse_ndarray_format, 0)
+ZEND_END_ARG_INFO()
+PHP_METHOD(SparseNDArray, format) {
+    ZEND_PARSE_PARAMETERS_NONE();
+    NDArraySparse *sparse = sparse_ndarray_get(ZEND_THIS);
+    if (sparse == NULL) {
+        return;
+    }
+    RETURN_STRING(sparse->format == NDARRAY_SPARSE_CSR ? "csr" : "coo");
+}
+
+static const zend_function_entry class_SparseNDArray_methods[] = {
+    ZEND_ME(SparseNDArray, fromTriplets, arginfo_sparse_ndarray_from_triplets, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
+    ZEND_ME(SparseNDArray, fromDense, arginfo_sparse_ndarray_from_dense, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
+    ZEND_ME(SparseNDArray, toDense, arginfo_sparse_ndarray_to_dense, ZEND_ACC_PUBLIC)
+    ZEND_ME(SparseNDArray, toCSR, arginfo_sparse_ndarray_to_csr, ZEND_ACC_PUBLIC)
+    ZEND_ME(SparseNDArray, toCOO, arginfo_sparse_ndarray_to_coo, ZEND_ACC_PUBLIC)
+    ZEND_ME(SparseNDArray, transpose, arginfo_sparse_ndarray_transpose, ZEND_ACC_PUBLIC)
+    ZEND_ME(SparseNDArray, rows, arginfo_sparse_ndarray_rows, ZEND_ACC_PUBLIC)
+    ZEND_ME(SparseNDArray, matmul, arginfo_sparse_ndarray_matmul, ZEND_ACC_PUBLIC)
+    ZEND_ME(SparseNDArray, shape, arginfo_sparse_ndarray_shape, ZEND_ACC_PUBLIC)
+    ZEND_ME(SparseNDArray, nnz, arginfo_sparse_ndarray_nnz, ZEND_ACC_PUBLIC)
+    ZEND_ME(SparseNDArray, format, arginfo_sparse_ndarray_format, ZEND_ACC_PUBLIC)
+    PHP_FE_END
+};
+
 static const zend_function_entry class_arithmetic_methods[] = {
     ZEND_ME(ArithmeticOperand, __construct, arginfo_ArithmeticOperand_construct, ZEND_ACC_PUBLIC)
     PHP_FE_END
@@ -5123,6 +8243,12 @@ static const zend_function_entry class_NumPower_methods[] = {
     ZEND_ME(NumPower, argmax, arginfo_ndarray_argmax, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
     ZEND_ME(NumPower, argmin, arginfo_ndarray_argmin, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
 
+    // SCANS
+    ZEND_ME(NumPower, cumsum, arginfo_ndarray_cumsum, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
+    ZEND_ME(NumPower, cumprod, arginfo_ndarray_cumprod, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
+    ZEND_ME(NumPower, cummax, arginfo_ndarray_cummax, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
+    ZEND_ME(NumPower, diff, arginfo_ndarray_diff, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
+
     // MANIPULATION
     ZEND_ME(NumPower, copy, arginfo_ndarray_copy, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
     ZEND_ME(NumPower, flatten, arginfo_ndarray_flat, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
@@ -5145,6 +8271,11 @@ static const zend_function_entry class_NumPower_methods[] = {
 
     // INDEXING
     ZEND_ME(NumPower, diagonal, arginfo_ndarray_diagonal, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
+    ZEND_ME(NumPower, take, arginfo_ndarray_take, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
+    ZEND_ME(NumPower, put, arginfo_ndarray_put, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
+    ZEND_ME(NumPower, where, arginfo_ndarray_where, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
+    ZEND_ME(NumPower, gather, arginfo_ndarray_gather, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
+    ZEND_ME(NumPower, scatterAdd, arginfo_ndarray_scatter_add, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
 
     // INITIALIZERS
     ZEND_ME(NumPower, zeros, arginfo_ndarray_zeros, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
@@ -5166,6 +8297,9 @@ static const zend_function_entry class_NumPower_methods[] = {
 
     // LINALG
     ZEND_ME(NumPower, matmul, arginfo_ndarray_matmul, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
+    ZEND_ME(NumPower, quantize, arginfo_ndarray_quantize, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
+    ZEND_ME(NumPower, dequantize, arginfo_ndarray_dequantize, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
+    ZEND_ME(NumPower, quantizedMatmul, arginfo_ndarray_quantized_matmul, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
     ZEND_ME(NumPower, svd, arginfo_ndarray_svd, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
     ZEND_ME(NumPower, det, arginfo_ndarray_det, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
     ZEND_ME(NumPower, dot, arginfo_ndarray_dot, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
@@ -5174,13 +8308,19 @@ static const zend_function_entry class_NumPower_methods[] = {
     ZEND_ME(NumPower, cholesky, arginfo_ndarray_cholesky, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
     ZEND_ME(NumPower, qr, arginfo_ndarray_qr, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
     ZEND_ME(NumPower, eig, arginfo_ndarray_eig, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
+    ZEND_ME(NumPower, eigh, arginfo_ndarray_eigh, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
+    ZEND_ME(NumPower, eigvalsh, arginfo_ndarray_eigvalsh, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
     ZEND_ME(NumPower, cond, arginfo_ndarray_cond, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
     ZEND_ME(NumPower, norm, arginfo_ndarray_norm, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
     ZEND_ME(NumPower, trace, arginfo_ndarray_trace, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
     ZEND_ME(NumPower, solve, arginfo_ndarray_solve, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
     ZEND_ME(NumPower, inv, arginfo_ndarray_inv, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
     ZEND_ME(NumPower, lstsq, arginfo_ndarray_lstsq, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
+    ZEND_ME(NumPower, cg, arginfo_ndarray_cg, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
+    ZEND_ME(NumPower, gmres, arginfo_ndarray_gmres, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
+    ZEND_ME(NumPower, lanczos, arginfo_ndarray_lanczos, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
     ZEND_ME(NumPower, lu, arginfo_ndarray_lu, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
+    ZEND_ME(NumPower, luFactor, arginfo_ndarray_lu_factor, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
     ZEND_ME(NumPower, matrixRank, arginfo_ndarray_matrix_rank, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
     ZEND_ME(NumPower, convolve2d, arginfo_ndarray_convolve2d, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
     ZEND_ME(NumPower, correlate2d, arginfo_ndarray_correlate2d, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
@@ -5189,10 +8329,28 @@ static const zend_function_entry class_NumPower_methods[] = {
     ZEND_ME(NumPower, dnnConv2dForward, arginfo_ndarray_dnn_conv2d_forward, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
     ZEND_ME(NumPower, dnnConv2dBackward, arginfo_ndarray_dnn_conv2d_backward, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
     ZEND_ME(NumPower, dnnConv1dForward, arginfo_ndarray_dnn_conv1d_forward, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
+    ZEND_ME(NumPower, linear, arginfo_ndarray_linear, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
+    ZEND_ME(NumPower, linearBackward, arginfo_ndarray_linear_backward, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
+    ZEND_ME(NumPower, softmax, arginfo_ndarray_softmax, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
+    ZEND_ME(NumPower, logSoftmax, arginfo_ndarray_log_softmax, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
+    ZEND_ME(NumPower, layerNorm, arginfo_ndarray_layer_norm, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
+    ZEND_ME(NumPower, layerNormBackward, arginfo_ndarray_layer_norm_backward, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
+    ZEND_ME(NumPower, batchNorm, arginfo_ndarray_batch_norm, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
+    ZEND_ME(NumPower, batchNormBackward, arginfo_ndarray_batch_norm_backward, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
+    ZEND_ME(NumPower, crossEntropyWithLogits, arginfo_ndarray_cross_entropy_with_logits, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
+    ZEND_ME(NumPower, crossEntropyWithLogitsBackward, arginfo_ndarray_cross_entropy_with_logits_backward, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
+    ZEND_ME(NumPower, maxPool1d, arginfo_ndarray_max_pool1d, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
+    ZEND_ME(NumPower, maxPool2d, arginfo_ndarray_max_pool2d, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
+    ZEND_ME(NumPower, avgPool1d, arginfo_ndarray_avg_pool1d, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
+    ZEND_ME(NumPower, avgPool2d, arginfo_ndarray_avg_pool2d, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
+    ZEND_ME(NumPower, maxPoolBackward, arginfo_ndarray_max_pool_backward, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
+    ZEND_ME(NumPower, avgPool1dBackward, arginfo_ndarray_avg_pool1d_backward, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
+    ZEND_ME(NumPower, avgPool2dBackward, arginfo_ndarray_avg_pool2d_backward, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
 
     // LOGIC
     ZEND_ME(NumPower, all, arginfo_ndarray_all, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
     ZEND_ME(NumPower, allClose, arginfo_ndarray_allclose, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
+    ZEND_ME(NumPower, countNonzero, arginfo_ndarray_count_nonzero, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
     ZEND_ME(NumPower, equal, arginfo_ndarray_equal, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
     ZEND_ME(NumPower, greater, arginfo_ndarray_greater, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
     ZEND_ME(NumPower, greaterEqual, arginfo_ndarray_greaterequal, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
@@ -5249,6 +8407,12 @@ static const zend_function_entry class_NumPower_methods[] = {
     ZEND_ME(NumPower, std, arginfo_ndarray_std, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
     ZEND_ME(NumPower, quantile, arginfo_ndarray_quantile, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
 
+    // SORTING
+    ZEND_ME(NumPower, sort, arginfo_ndarray_sort, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
+    ZEND_ME(NumPower, argsort, arginfo_ndarray_argsort, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
+    ZEND_ME(NumPower, partition, arginfo_ndarray_partition, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
+    ZEND_ME(NumPower, topk, arginfo_ndarray_topk, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
+
     // ARITHMETICS
     ZEND_ME(NumPower, add, arginfo_ndarray_add, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
     ZEND_ME(NumPower, subtract, arginfo_ndarray_subtract, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
@@ -5258,10 +8422,13 @@ static const zend_function_entry class_NumPower_methods[] = {
     ZEND_ME(NumPower, sum, arginfo_ndarray_sum, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
     ZEND_ME(NumPower, prod, arginfo_ndarray_prod, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
     ZEND_ME(NumPower, mod, arginfo_ndarray_mod, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
+    ZEND_ME(NumPower, lazy, arginfo_ndarray_lazy, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
     ZEND_ME(NumPower, dumpDevices, arginfo_dump_devices, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
     ZEND_ME(NumPower, setDevice, arginfo_setdevice, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
     ZEND_ME(NumPower, load, arginfo_load, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
     ZEND_ME(NumPower, save, arginfo_save, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
+    ZEND_ME(NumPower, loadtxt, arginfo_loadtxt, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
+    ZEND_ME(NumPower, fromfile, arginfo_fromfile, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
     PHP_FE_END
 };
 
@@ -5289,10 +8456,23 @@ static const zend_function_entry class_NDArray_methods[] = {
 
     ZEND_ME(NDArray, reshape, arginfo_reshape, ZEND_ACC_PUBLIC)
     ZEND_ME(NDArray, toArray, arginfo_toArray, ZEND_ACC_PUBLIC)
+    ZEND_ME(NDArray, dtype, arginfo_dtype, ZEND_ACC_PUBLIC)
+    ZEND_ME(NDArray, astype, arginfo_astype, ZEND_ACC_PUBLIC)
     ZEND_ME(NDArray, toImage, arginfo_toImage, ZEND_ACC_PUBLIC)
     ZEND_ME(NDArray, slice, arginfo_slice, ZEND_ACC_PUBLIC)
     ZEND_ME(NDArray, shape, arginfo_ndarray_shape, ZEND_ACC_PUBLIC)
     ZEND_ME(NDArray, fill, arginfo_fill, ZEND_ACC_PUBLIC)
+    ZEND_ME(NDArray, addInPlace, arginfo_add_in_place, ZEND_ACC_PUBLIC)
+    ZEND_ME(NDArray, subInPlace, arginfo_sub_in_place, ZEND_ACC_PUBLIC)
+    ZEND_ME(NDArray, mulInPlace, arginfo_mul_in_place, ZEND_ACC_PUBLIC)
+    ZEND_ME(NDArray, divInPlace, arginfo_div_in_place, ZEND_ACC_PUBLIC)
+    ZEND_ME(NDArray, shared, arginfo_shared, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
+    ZEND_ME(NDArray, attach, arginfo_attach, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
+    ZEND_ME(NDArray, unlinkShared, arginfo_unlink_shared, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
+    ZEND_ME(NDArray, persist, arginfo_persist, ZEND_ACC_PUBLIC)
+    ZEND_ME(NDArray, persisted, arginfo_persisted, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
+    ZEND_ME(NDArray, unpersist, arginfo_unpersist, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
+    ZEND_ME(NDArray, persistentStats, arginfo_persistent_stats, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
     ZEND_FE_END
 };
 
@@ -5339,6 +8519,36 @@ static zend_class_entry *register_class_ArithmeticOperand(zend_class_entry *clas
     return class_entry;
 }
 
+static zend_class_entry *register_class_NDArrayExpression(void) {
+    zend_class_entry ce, *class_entry;
+    INIT_CLASS_ENTRY(ce, "NDArrayExpression", class_NDArrayExpression_methods);
+    ndarray_expression_objects_init(&ce);
+    ce.create_object = ndarray_expression_create_object;
+    class_entry = zend_register_internal_class(&ce);
+    class_entry->ce_flags |= ZEND_ACC_FINAL;
+    return class_entry;
+}
+
+static zend_class_entry *register_class_LUFactorization(void) {
+    zend_class_entry ce, *class_entry;
+    INIT_CLASS_ENTRY(ce, "LUFactorization", class_LUFactorization_methods);
+    lu_factorization_objects_init(&ce);
+    ce.create_object = lu_factorization_create_object;
+    class_entry = zend_register_internal_class(&ce);
+    class_entry->ce_flags |= ZEND_ACC_FINAL;
+    return class_entry;
+}
+
+static zend_class_entry *register_class_SparseNDArray(void) {
+    zend_class_entry ce, *class_entry;
+    INIT_CLASS_ENTRY(ce, "SparseNDArray", class_SparseNDArray_methods);
+    sparse_ndarray_objects_init(&ce);
+    ce.create_object = sparse_ndarray_create_object;
+    class_entry = zend_register_internal_class(&ce);
+    class_entry->ce_flags |= ZEND_ACC_FINAL;
+    return class_entry;
+}
+
 /**
  * MINIT
  */
@@ -5346,8 +8556,12 @@ PHP_MINIT_FUNCTION(ndarray) {
     phpsci_ce_NDArray = register_class_NDArray(zend_ce_iterator, zend_ce_countable, zend_ce_arrayaccess);
     phpsci_ce_ArithmeticOperand = register_class_ArithmeticOperand(zend_ce_iterator, zend_ce_countable, zend_ce_arrayaccess);
     phpsci_ce_NumPower = register_class_NumPower(zend_ce_iterator, zend_ce_countable, zend_ce_arrayaccess);
+    phpsci_ce_NDArrayExpression = register_class_NDArrayExpression();
+    phpsci_ce_LUFactorization = register_class_LUFactorization();
+    phpsci_ce_SparseNDArray = register_class_SparseNDArray();
     REGISTER_LONG_CONSTANT("NUMPOWER_CPU", 0, CONST_CS | CONST_PERSISTENT);
     REGISTER_LONG_CONSTANT("NUMPOWER_CUDA", 1, CONST_CS | CONST_PERSISTENT);
+    persistent_init();
     return SUCCESS;
 }
 
@@ -5369,12 +8583,14 @@ PHP_MINFO_FUNCTION(ndarray) {
 }
 
 PHP_MSHUTDOWN_FUNCTION(ndarray) {
+    persistent_shutdown();
     return SUCCESS;
 }
 
 PHP_RSHUTDOWN_FUNCTION(ndarray) {
     char *envvar = "NDARRAY_BUFFERLEAK";
     char *envvar_vcheck = "NDARRAY_VCHECK";
+    NDArrayExpr_ClearCache();
     if(!getenv(envvar)) {
         buffer_free();
     }
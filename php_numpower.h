@@ -64,6 +64,9 @@ ZEND_FUNCTION(print_r_);
 PHPAPI zend_class_entry *phpsci_ce_NDArray;
 PHPAPI zend_class_entry *phpsci_ce_NumPower;
 PHPAPI zend_class_entry *phpsci_ce_ArithmeticOperand;
+PHPAPI zend_class_entry *phpsci_ce_NDArrayExpression;
+PHPAPI zend_class_entry *phpsci_ce_LUFactorization;
+PHPAPI zend_class_entry *phpsci_ce_SparseNDArray;
 
 # define PHP_NDARRAY_VERSION "0.7.0"
 
@@ -214,6 +214,51 @@ print_matrix_float(float* buffer, int ndims, int* shape, int* strides, int num_e
     return rtn;
 }
 
+/**
+ * Print matrix of type float64
+ *
+ * @param buffer
+ * @param ndims
+ * @param shape
+ * @param strides
+ */
+char*
+print_matrix(double* buffer, int ndims, int* shape, int* strides, int num_elements, int device) {
+    double *tmp_buffer = buffer;
+    float *float_buffer;
+    int *float_strides = emalloc((ndims > 0 ? ndims : 1) * sizeof(int));
+    long span = 1;
+    long i;
+    char *rtn;
+
+    if (num_elements == 0) {
+        efree(float_strides);
+        return print_matrix_float(NULL, ndims, shape, strides, 0, NDARRAY_DEVICE_CPU);
+    }
+    for (i = 0; i < ndims; i++) {
+        span += (long)(shape[i] - 1) * (strides[i] / (int)sizeof(double));
+        float_strides[i] = (strides[i] / (int)sizeof(double)) * (int)sizeof(float);
+    }
+    if (device == NDARRAY_DEVICE_GPU) {
+#ifdef HAVE_CUBLAS
+        tmp_buffer = emalloc(span * sizeof(double));
+        cudaMemcpy(tmp_buffer, buffer, span * sizeof(double), cudaMemcpyDeviceToHost);
+#endif
+    }
+    // %g output never shows more than float precision, so print through the float32 path
+    float_buffer = emalloc(span * sizeof(float));
+    for (i = 0; i < span; i++) {
+        float_buffer[i] = (float)tmp_buffer[i];
+    }
+    rtn = print_matrix_float(float_buffer, ndims, shape, float_strides, num_elements, NDARRAY_DEVICE_CPU);
+    efree(float_buffer);
+    efree(float_strides);
+    if (tmp_buffer != buffer) {
+        efree(tmp_buffer);
+    }
+    return rtn;
+}
+
 void
 NDArray_DumpDevices() {
 #ifdef HAVE_CUBLAS
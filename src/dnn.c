@@ -1,9 +1,11 @@
 #include <Zend/zend.h>
+#include <math.h>
 #include "ndarray.h"
 #include "initializers.h"
 #include "dnn.h"
 #include "../config.h"
 #include "manipulation.h"
+#include "types.h"
 
 #ifdef HAVE_CUDNN
 #include "ndmath/cuda/cuda_dnn.cuh"
@@ -461,4 +463,1380 @@ NDArray_DNN_Conv1D(NDArray *a, NDArray *kernel)
     NDArray *output = NDArray_Zeros(out_shape, 2, NDArray_TYPE(a), NDArray_DEVICE(a));
     conv1d_optimized(NDArray_FDATA(a), NDArray_FDATA(output), NDArray_FDATA(kernel), 3, 2, 2, 3, 1, NULL, 1, 0, 'z');
     return output;
-}
\ No newline at end of file
+}
+
+/**
+ * Bytes of linear layer output produced per GEMM call, so the tile is
+ * still cache resident when the bias and activation are applied
+ */
+#define NDARRAY_LINEAR_TILE_BYTES 262144
+
+/**
+ * Lower bound on the rows of a tile, smaller GEMMs lose BLAS efficiency
+ */
+#define NDARRAY_LINEAR_TILE_MIN_ROWS 16
+
+/**
+ * Tiles with at least this many elements apply the epilogue in parallel
+ */
+#define NDARRAY_LINEAR_PARALLEL_MIN 32768
+
+/**
+ * Forward and backward kernels of NDArrayDNN_Linear for one float type.
+ * `activation` is 0 (identity), 'r' (relu), 't' (tanh), 's' (sigmoid) or
+ * 'g' (gelu, erf form).
+ */
+#define NDARRAY_LINEAR_KERNELS(T, tname, blas, EXP, TANH, ERF)                                     \
+static inline T                                                                                    \
+tname##_linear_activate(T z, char activation) {                                                    \
+    switch (activation) {                                                                          \
+        case 'r':                                                                                  \
+            return z > 0 ? z : 0;                                                                  \
+        case 't':                                                                                  \
+            return TANH(z);                                                                        \
+        case 's':                                                                                  \
+            return z >= 0 ? 1 / (1 + EXP(-z)) : EXP(z) / (1 + EXP(z));                             \
+        case 'g':                                                                                  \
+            return (T)0.5 * z * (1 + ERF(z * (T)M_SQRT1_2));                                       \
+    }                                                                                              \
+    return z;                                                                                      \
+}                                                                                                  \
+                                                                                                   \
+/* y = activation(x w + bias) for rows of x, one tile per GEMM call */                             \
+static void                                                                                        \
+tname##_linear_forward(const T *x, const T *w, const T *bias, T *y, int m, int n, int k,          \
+                       char activation) {                                                          \
+    int tile = NDARRAY_LINEAR_TILE_BYTES / (int)sizeof(T) / (n > 0 ? n : 1);                       \
+    int r0, rows, i, parallel;                                                                     \
+                                                                                                   \
+    tile = tile > NDARRAY_LINEAR_TILE_MIN_ROWS ? tile : NDARRAY_LINEAR_TILE_MIN_ROWS;              \
+    for (r0 = 0; r0 < m; r0 += rows) {                                                             \
+        T *c = y + (long)r0 * n;                                                                   \
+        rows = m - r0 < tile ? m - r0 : tile;                                                      \
+        cblas_##blas##gemm(CblasRowMajor, CblasNoTrans, CblasNoTrans, rows, n, k, 1, x + (long)r0 * k,\
+                           k, w, n, 0, c, n);                                                      \
+        if (bias == NULL && activation == 0) {                                                     \
+            continue;                                                                              \
+        }                                                                                          \
+        parallel = (long)rows * n >= NDARRAY_LINEAR_PARALLEL_MIN;                                  \
+        _Pragma("omp parallel for if (parallel)")                                                  \
+        for (i = 0; i < rows; i++) {                                                               \
+            T *row = c + (long)i * n;                                                              \
+            int j;                                                                                 \
+            if (bias != NULL) {                                                                    \
+                _Pragma("omp simd")                                                                \
+                for (j = 0; j < n; j++) {                                                          \
+                    row[j] += bias[j];                                                             \
+                }                                                                                  \
+            }                                                                                      \
+            for (j = 0; j < n; j++) {                                                              \
+                row[j] = tname##_linear_activate(row[j], activation);                              \
+            }                                                                                      \
+        }                                                                                          \
+    }                                                                                              \
+}                                                                                                  \
+                                                                                                   \
+/* dz = grad * activation'(z) and db = column sums of dz. relu, tanh and                           \
+ * sigmoid read their derivative off the output `y`, gelu reads the                                \
+ * pre-activation already stored in `dz` */                                                        \
+static void                                                                                        \
+tname##_linear_delta(const T *grad, const T *y, T *dz, T *db, int m, int n, char activation) {    \
+    int parallel = (long)m * n >= NDARRAY_LINEAR_PARALLEL_MIN;                                     \
+    int i, j;                                                                                      \
+                                                                                                   \
+    _Pragma("omp parallel for if (parallel)")                                                      \
+    for (i = 0; i < m; i++) {                                                                      \
+        const T *g = grad + (long)i * n, *o = y + (long)i * n;                                     \
+        T *d = dz + (long)i * n;                                                                   \
+        int c;                                                                                     \
+        switch (activation) {                                                                      \
+            case 'r':                                                                              \
+                for (c = 0; c < n; c++) {                                                          \
+                    d[c] = o[c] > 0 ? g[c] : 0;                                                    \
+                }                                                                                  \
+                break;                                                                             \
+            case 't':                                                                              \
+                _Pragma("omp simd")                                                                \
+                for (c = 0; c < n; c++) {                                                          \
+                    d[c] = g[c] * (1 - o[c] * o[c]);                                               \
+                }                                                                                  \
+                break;                                                                             \
+            case 's':                                                                              \
+                _Pragma("omp simd")                                                                \
+                for (c = 0; c < n; c++) {                                                          \
+                    d[c] = g[c] * o[c] * (1 - o[c]);                                               \
+                }                                                                                  \
+                break;                                                                             \
+            case 'g':                                                                              \
+                for (c = 0; c < n; c++) {                                                          \
+                    T z = d[c];                                                                    \
+                    d[c] = g[c] * ((T)0.5 * (1 + ERF(z * (T)M_SQRT1_2))                            \
+                                   + z * EXP((T)-0.5 * z * z) * (T)(0.5 * M_2_SQRTPI * M_SQRT1_2));\
+                }                                                                                  \
+                break;                                                                             \
+            default:                                                                               \
+                memcpy(d, g, sizeof(T) * n);                                                       \
+        }                                                                                          \
+    }                                                                                              \
+    memset(db, 0, sizeof(T) * n);                                                                  \
+    for (i = 0; i < m; i++) {                                                                      \
+        const T *d = dz + (long)i * n;                                                             \
+        _Pragma("omp simd")                                                                        \
+        for (j = 0; j < n; j++) {                                                                  \
+            db[j] += d[j];                                                                         \
+        }                                                                                          \
+    }                                                                                              \
+}                                                                                                  \
+                                                                                                   \
+/* dx = dz w^T and dw = x^T dz */                                                                  \
+static void                                                                                        \
+tname##_linear_backward(const T *dz, const T *x, const T *w, T *dx, T *dw, int m, int n, int k) { \
+    cblas_##blas##gemm(CblasRowMajor, CblasNoTrans, CblasTrans, m, k, n, 1, dz, n, w, n, 0, dx, k);\
+    cblas_##blas##gemm(CblasRowMajor, CblasTrans, CblasNoTrans, k, n, m, 1, x, k, dz, n, 0, dw, n);\
+}
+
+NDARRAY_LINEAR_KERNELS(float, float32, s, expf, tanhf, erff)
+NDARRAY_LINEAR_KERNELS(double, float64, d, exp, tanh, erf)
+
+/**
+ * `a` as a contiguous array of `type`, borrowed when it already is one
+ */
+static NDArray*
+ndarray_dnn_operand(NDArray *a, const char *type) {
+    if (is_type(NDArray_TYPE(a), type) && NDArray_IsContiguous(a)) {
+        return a;
+    }
+    return NDArray_AsType(a, type);
+}
+
+static void
+ndarray_dnn_release(NDArray **operands, NDArray **inputs, int count) {
+    int i;
+
+    for (i = 0; i < count; i++) {
+        if (operands[i] != NULL && operands[i] != inputs[i]) {
+            NDArray_FREE(operands[i]);
+        }
+    }
+}
+
+/**
+ * Convert the non-NULL `inputs` of the DNN operation `name` to contiguous
+ * CPU arrays of `type`
+ *
+ * @return 0 on success, -1 with an exception thrown otherwise
+ */
+static int
+ndarray_dnn_operands(const char *name, NDArray **inputs, NDArray **operands, int count, const char *type) {
+    int i;
+
+    for (i = 0; i < count; i++) {
+        operands[i] = NULL;
+        if (inputs[i] != NULL && NDArray_DEVICE(inputs[i]) == NDARRAY_DEVICE_GPU) {
+            zend_throw_error(NULL, "%s is only available for NDArrays on CPU RAM.", name);
+            return -1;
+        }
+    }
+    for (i = 0; i < count; i++) {
+        if (inputs[i] != NULL && (operands[i] = ndarray_dnn_operand(inputs[i], type)) == NULL) {
+            ndarray_dnn_release(operands, inputs, i);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * Validate the operands of a linear layer and convert them to its compute
+ * type, float64 when `x` or `w` is float64 and float32 otherwise
+ *
+ * @return 0 on success, -1 with an exception thrown otherwise
+ */
+static int
+ndarray_linear_prepare(NDArray **inputs, NDArray **operands, int count, int *m, int *n, int *k,
+                       const char **type) {
+    NDArray *x = inputs[0], *w = inputs[1], *b = inputs[2];
+    int i;
+
+    if ((NDArray_NDIM(x) != 1 && NDArray_NDIM(x) != 2) || NDArray_NDIM(w) != 2) {
+        zend_throw_error(NULL, "linear expects a 1-D or 2-D input and 2-D weights.");
+        return -1;
+    }
+    *k = NDArray_SHAPE(x)[NDArray_NDIM(x) - 1];
+    *m = NDArray_NDIM(x) == 2 ? NDArray_SHAPE(x)[0] : 1;
+    *n = NDArray_SHAPE(w)[1];
+    if (*k != NDArray_SHAPE(w)[0]) {
+        zend_throw_error(NULL, "Shape mismatch for linear. cols(x) != rows(w)");
+        return -1;
+    }
+    if (b != NULL && NDArray_NUMELEMENTS(b) != *n) {
+        zend_throw_error(NULL, "bias must have %d elements.", *n);
+        return -1;
+    }
+    for (i = 3; i < count; i++) {
+        if (inputs[i] != NULL && NDArray_NUMELEMENTS(inputs[i]) != (long)*m * *n) {
+            zend_throw_error(NULL, "Gradient and output must have the shape of the linear output.");
+            return -1;
+        }
+    }
+    *type = is_type(NDArray_TYPE(x), NDARRAY_TYPE_DOUBLE64) || is_type(NDArray_TYPE(w), NDARRAY_TYPE_DOUBLE64)
+            ? NDARRAY_TYPE_DOUBLE64 : NDARRAY_TYPE_FLOAT32;
+    return ndarray_dnn_operands("linear", inputs, operands, count, *type);
+}
+
+/**
+ * Dense layer activation(x w + b) with the bias and activation applied
+ * to each output tile right after its GEMM, instead of separate passes
+ *
+ * @param x input, (m, k) or (k)
+ * @param w weights, (k, n)
+ * @param b bias of n elements or NULL
+ * @param activation 0, 'r' (relu), 't' (tanh), 's' (sigmoid) or 'g' (gelu)
+ * @return (m, n), or (n) for a 1-D input
+ */
+NDArray*
+NDArrayDNN_Linear(NDArray *x, NDArray *w, NDArray *b, char activation) {
+    NDArray *inputs[3] = {x, w, b}, *operands[3];
+    NDArray *rtn;
+    const char *type;
+    int m, n, k, *shape;
+
+    if (ndarray_linear_prepare(inputs, operands, 3, &m, &n, &k, &type) != 0) {
+        return NULL;
+    }
+    shape = emalloc(sizeof(int) * 2);
+    shape[0] = m;
+    shape[NDArray_NDIM(x) - 1] = n;
+    rtn = NDArray_Empty(shape, NDArray_NDIM(x), type, NDARRAY_DEVICE_CPU);
+    if (is_type(type, NDARRAY_TYPE_DOUBLE64)) {
+        float64_linear_forward(NDArray_DDATA(operands[0]), NDArray_DDATA(operands[1]),
+                               b != NULL ? NDArray_DDATA(operands[2]) : NULL, NDArray_DDATA(rtn), m, n, k, activation);
+    } else {
+        float32_linear_forward(NDArray_FDATA(operands[0]), NDArray_FDATA(operands[1]),
+                               b != NULL ? NDArray_FDATA(operands[2]) : NULL, NDArray_FDATA(rtn), m, n, k, activation);
+    }
+    ndarray_dnn_release(operands, inputs, 3);
+    return rtn;
+}
+
+/**
+ * Gradients of NDArrayDNN_Linear with respect to x, w and b
+ *
+ * relu, tanh and sigmoid take their derivative from the forward output
+ * `y`; gelu recomputes the pre-activation from x, w and b instead.
+ *
+ * @param grad gradient of the loss with respect to the layer output
+ * @param x
+ * @param w
+ * @param b bias or NULL, only read by gelu
+ * @param y forward output, required by relu, tanh and sigmoid
+ * @param activation
+ * @return [dx, dw, db]
+ */
+NDArray**
+NDArrayDNN_Linear_Backward(NDArray *grad, NDArray *x, NDArray *w, NDArray *b, NDArray *y, char activation) {
+    NDArray *inputs[5] = {x, w, b, grad, y}, *operands[5];
+    NDArray **rtn, *dz;
+    const char *type;
+    int m, n, k, *shape;
+
+    if ((activation == 'r' || activation == 't' || activation == 's') && y == NULL) {
+        zend_throw_error(NULL, "The forward output is required for the backward of this activation.");
+        return NULL;
+    }
+    if (activation != 'r' && activation != 't' && activation != 's') {
+        inputs[4] = NULL;
+    }
+    if (activation != 'g') {
+        inputs[2] = NULL;
+    }
+    if (ndarray_linear_prepare(inputs, operands, 5, &m, &n, &k, &type) != 0) {
+        return NULL;
+    }
+    rtn = emalloc(sizeof(NDArray*) * 3);
+    shape = emalloc(sizeof(int) * 2);
+    shape[0] = m;
+    shape[1] = n;
+    dz = NDArray_Empty(shape, 2, type, NDARRAY_DEVICE_CPU);
+    shape = emalloc(sizeof(int) * 2);
+    shape[0] = m;
+    shape[NDArray_NDIM(x) - 1] = k;
+    rtn[0] = NDArray_Empty(shape, NDArray_NDIM(x), type, NDARRAY_DEVICE_CPU);
+    shape = emalloc(sizeof(int) * 2);
+    shape[0] = k;
+    shape[1] = n;
+    rtn[1] = NDArray_Empty(shape, 2, type, NDARRAY_DEVICE_CPU);
+    shape = emalloc(sizeof(int));
+    shape[0] = n;
+    rtn[2] = NDArray_Empty(shape, 1, type, NDARRAY_DEVICE_CPU);
+    if (is_type(type, NDARRAY_TYPE_DOUBLE64)) {
+        if (activation == 'g') {
+            float64_linear_forward(NDArray_DDATA(operands[0]), NDArray_DDATA(operands[1]),
+                                   inputs[2] != NULL ? NDArray_DDATA(operands[2]) : NULL, NDArray_DDATA(dz), m, n, k, 0);
+        }
+        float64_linear_delta(NDArray_DDATA(operands[3]), inputs[4] != NULL ? NDArray_DDATA(operands[4]) : NULL,
+                             NDArray_DDATA(dz), NDArray_DDATA(rtn[2]), m, n, activation);
+        float64_linear_backward(NDArray_DDATA(dz), NDArray_DDATA(operands[0]), NDArray_DDATA(operands[1]),
+                                NDArray_DDATA(rtn[0]), NDArray_DDATA(rtn[1]), m, n, k);
+    } else {
+        if (activation == 'g') {
+            float32_linear_forward(NDArray_FDATA(operands[0]), NDArray_FDATA(operands[1]),
+                                   inputs[2] != NULL ? NDArray_FDATA(operands[2]) : NULL, NDArray_FDATA(dz), m, n, k, 0);
+        }
+        float32_linear_delta(NDArray_FDATA(operands[3]), inputs[4] != NULL ? NDArray_FDATA(operands[4]) : NULL,
+                             NDArray_FDATA(dz), NDArray_FDATA(rtn[2]), m, n, activation);
+        float32_linear_backward(NDArray_FDATA(dz), NDArray_FDATA(operands[0]), NDArray_FDATA(operands[1]),
+                                NDArray_FDATA(rtn[0]), NDArray_FDATA(rtn[1]), m, n, k);
+    }
+    NDArray_FREE(dz);
+    ndarray_dnn_release(operands, inputs, 5);
+    return rtn;
+}
+
+/**
+ * Rows (or batch norm channels) times their length from which the
+ * normalization kernels run in parallel
+ */
+#define NDARRAY_NORM_PARALLEL_MIN 32768
+
+/**
+ * Row-wise softmax, layer norm, batch norm and cross-entropy kernels for
+ * one float type. Statistics are accumulated in double.
+ */
+#define NDARRAY_NORM_KERNELS(T, tname, EXP, LOG)                                                   \
+/* y = softmax(x) or log(softmax(x)) over rows of n, shifted by the row max */                     \
+static void                                                                                        \
+tname##_softmax_rows(const T *x, T *y, long rows, int n, int logarithmic) {                        \
+    int parallel = rows * n >= NDARRAY_NORM_PARALLEL_MIN;                                          \
+    long i;                                                                                        \
+                                                                                                   \
+    _Pragma("omp parallel for if (parallel)")                                                      \
+    for (i = 0; i < rows; i++) {                                                                   \
+        const T *in = x + i * n;                                                                   \
+        T *out = y + i * n, max = in[0], sum = 0;                                                  \
+        int j;                                                                                     \
+        for (j = 1; j < n; j++) {                                                                  \
+            max = in[j] > max ? in[j] : max;                                                       \
+        }                                                                                          \
+        _Pragma("omp simd reduction(+:sum)")                                                       \
+        for (j = 0; j < n; j++) {                                                                  \
+            out[j] = EXP(in[j] - max);                                                             \
+            sum += out[j];                                                                         \
+        }                                                                                          \
+        if (logarithmic) {                                                                         \
+            T shift = max + LOG(sum);                                                              \
+            _Pragma("omp simd")                                                                    \
+            for (j = 0; j < n; j++) {                                                              \
+                out[j] = in[j] - shift;                                                            \
+            }                                                                                      \
+        } else {                                                                                   \
+            T inv = 1 / sum;                                                                       \
+            _Pragma("omp simd")                                                                    \
+            for (j = 0; j < n; j++) {                                                              \
+                out[j] *= inv;                                                                     \
+            }                                                                                      \
+        }                                                                                          \
+    }                                                                                              \
+}                                                                                                  \
+                                                                                                   \
+/* Mean and reciprocal standard deviation of `count` values `stride` apart */                      \
+static inline void                                                                                 \
+tname##_norm_stats(const T *x, long count, long stride, double eps, double *mean, double *rstd) {  \
+    double sum = 0, sq = 0;                                                                        \
+    long i;                                                                                        \
+                                                                                                   \
+    for (i = 0; i < count; i++) {                                                                  \
+        sum += x[i * stride];                                                                      \
+    }                                                                                              \
+    *mean = count > 0 ? sum / count : 0;                                                           \
+    for (i = 0; i < count; i++) {                                                                  \
+        double d = x[i * stride] - *mean;                                                          \
+        sq += d * d;                                                                               \
+    }                                                                                              \
+    *rstd = 1 / sqrt((count > 0 ? sq / count : 0) + eps);                                          \
+}                                                                                                  \
+                                                                                                   \
+/* y = (x - mean) * rstd * gamma + beta over rows of n */                                          \
+static void                                                                                        \
+tname##_layernorm_rows(const T *x, const T *gamma, const T *beta, T *y, long rows, int n,          \
+                       double eps) {                                                               \
+    int parallel = rows * n >= NDARRAY_NORM_PARALLEL_MIN;                                          \
+    long i;                                                                                        \
+                                                                                                   \
+    _Pragma("omp parallel for if (parallel)")                                                      \
+    for (i = 0; i < rows; i++) {                                                                   \
+        const T *in = x + i * n;                                                                   \
+        T *out = y + i * n, mu, rs;                                                                \
+        double mean, rstd;                                                                         \
+        int j;                                                                                     \
+        tname##_norm_stats(in, n, 1, eps, &mean, &rstd);                                           \
+        mu = (T) mean;                                                                             \
+        rs = (T) rstd;                                                                             \
+        _Pragma("omp simd")                                                                        \
+        for (j = 0; j < n; j++) {                                                                  \
+            out[j] = (in[j] - mu) * rs * (gamma != NULL ? gamma[j] : 1) + (beta != NULL ? beta[j] : 0);\
+        }                                                                                          \
+    }                                                                                              \
+}                                                                                                  \
+                                                                                                   \
+/* dx, dgamma and dbeta of tname##_layernorm_rows */                                               \
+static void                                                                                        \
+tname##_layernorm_backward_rows(const T *grad, const T *x, const T *gamma, T *dx, T *dgamma,       \
+                                T *dbeta, long rows, int n, double eps) {                          \
+    int parallel = rows * n >= NDARRAY_NORM_PARALLEL_MIN;                                          \
+    double *stats = emalloc(sizeof(double) * 2 * (rows > 0 ? rows : 1));                           \
+    long i;                                                                                        \
+    int j;                                                                                         \
+                                                                                                   \
+    _Pragma("omp parallel for if (parallel)")                                                      \
+    for (i = 0; i < rows; i++) {                                                                   \
+        const T *in = x + i * n, *g = grad + i * n;                                                \
+        T *out = dx + i * n, mu, rs, sum_dy = 0, sum_dy_xhat = 0;                                  \
+        int c;                                                                                     \
+        tname##_norm_stats(in, n, 1, eps, &stats[2 * i], &stats[2 * i + 1]);                       \
+        mu = (T) stats[2 * i];                                                                     \
+        rs = (T) stats[2 * i + 1];                                                                 \
+        _Pragma("omp simd reduction(+:sum_dy, sum_dy_xhat)")                                       \
+        for (c = 0; c < n; c++) {                                                                  \
+            T dy = g[c] * (gamma != NULL ? gamma[c] : 1);                                          \
+            sum_dy += dy;                                                                          \
+            sum_dy_xhat += dy * (in[c] - mu) * rs;                                                 \
+        }                                                                                          \
+        sum_dy /= n;                                                                               \
+        sum_dy_xhat /= n;                                                                          \
+        _Pragma("omp simd")                                                                        \
+        for (c = 0; c < n; c++) {                                                                  \
+            T dy = g[c] * (gamma != NULL ? gamma[c] : 1);                                          \
+            out[c] = rs * (dy - sum_dy - (in[c] - mu) * rs * sum_dy_xhat);                         \
+        }                                                                                          \
+    }                                                                                              \
+    memset(dgamma, 0, sizeof(T) * n);                                                              \
+    memset(dbeta, 0, sizeof(T) * n);                                                               \
+    for (i = 0; i < rows; i++) {                                                                   \
+        const T *in = x + i * n, *g = grad + i * n, mu = (T) stats[2 * i], rs = (T) stats[2 * i + 1];\
+        _Pragma("omp simd")                                                                        \
+        for (j = 0; j < n; j++) {                                                                  \
+            dgamma[j] += g[j] * (in[j] - mu) * rs;                                                 \
+            dbeta[j] += g[j];                                                                      \
+        }                                                                                          \
+    }                                                                                              \
+    efree(stats);                                                                                  \
+}                                                                                                  \
+                                                                                                   \
+/* Batch norm of x laid out as (batch, channels, inner) per channel. The                           \
+ * statistics are computed into mean/var unless `given` */                                         \
+static void                                                                                        \
+tname##_batchnorm(const T *x, const T *gamma, const T *beta, T *mean, T *var, int given, T *y,     \
+                  long batch, int channels, long inner, double eps) {                              \
+    int parallel = batch * channels * inner >= NDARRAY_NORM_PARALLEL_MIN;                          \
+    int c;                                                                                         \
+                                                                                                   \
+    _Pragma("omp parallel for if (parallel)")                                                      \
+    for (c = 0; c < channels; c++) {                                                               \
+        double mu, rstd;                                                                           \
+        T scale, shift;                                                                            \
+        long b, s;                                                                                 \
+        if (given) {                                                                               \
+            mu = mean[c];                                                                          \
+            rstd = 1 / sqrt((double) var[c] + eps);                                                \
+        } else {                                                                                   \
+            double sum = 0, sq = 0;                                                                \
+            for (b = 0; b < batch; b++) {                                                          \
+                const T *in = x + (b * channels + c) * inner;                                      \
+                for (s = 0; s < inner; s++) {                                                      \
+                    sum += in[s];                                                                  \
+                }                                                                                  \
+            }                                                                                      \
+            mu = batch * inner > 0 ? sum / (batch * inner) : 0;                                    \
+            for (b = 0; b < batch; b++) {                                                          \
+                const T *in = x + (b * channels + c) * inner;                                      \
+                for (s = 0; s < inner; s++) {                                                      \
+                    sq += (in[s] - mu) * (in[s] - mu);                                             \
+                }                                                                                  \
+            }                                                                                      \
+            mean[c] = (T) mu;                                                                      \
+            var[c] = (T) (batch * inner > 0 ? sq / (batch * inner) : 0);                           \
+            rstd = 1 / sqrt(var[c] + eps);                                                         \
+        }                                                                                          \
+        scale = (T) (rstd * (gamma != NULL ? gamma[c] : 1));                                       \
+        shift = (T) ((beta != NULL ? beta[c] : 0) - mu * scale);                                   \
+        for (b = 0; b < batch; b++) {                                                              \
+            const T *in = x + (b * channels + c) * inner;                                          \
+            T *out = y + (b * channels + c) * inner;                                               \
+            _Pragma("omp simd")                                                                    \
+            for (s = 0; s < inner; s++) {                                                          \
+                out[s] = in[s] * scale + shift;                                                    \
+            }                                                                                      \
+        }                                                                                          \
+    }                                                                                              \
+}                                                                                                  \
+                                                                                                   \
+/* dx, dgamma and dbeta of tname##_batchnorm with batch statistics */                              \
+static void                                                                                        \
+tname##_batchnorm_backward(const T *grad, const T *x, const T *gamma, T *dx, T *dgamma, T *dbeta,  \
+                           long batch, int channels, long inner, double eps) {                     \
+    int parallel = batch * channels * inner >= NDARRAY_NORM_PARALLEL_MIN;                          \
+    int c;                                                                                         \
+                                                                                                   \
+    _Pragma("omp parallel for if (parallel)")                                                      \
+    for (c = 0; c < channels; c++) {                                                               \
+        double mu = 0, rstd = 0, sum = 0, sq = 0, sum_g = 0, sum_g_xhat = 0;                       \
+        long b, s, count = batch * inner;                                                          \
+        T k1, k2, k3;                                                                              \
+        for (b = 0; b < batch; b++) {                                                              \
+            const T *in = x + (b * channels + c) * inner;                                          \
+            for (s = 0; s < inner; s++) {                                                          \
+                sum += in[s];                                                                      \
+            }                                                                                      \
+        }                                                                                          \
+        mu = count > 0 ? sum / count : 0;                                                          \
+        for (b = 0; b < batch; b++) {                                                              \
+            const T *in = x + (b * channels + c) * inner, *g = grad + (b * channels + c) * inner;  \
+            for (s = 0; s < inner; s++) {                                                          \
+                sq += (in[s] - mu) * (in[s] - mu);                                                 \
+                sum_g += g[s];                                                                     \
+                sum_g_xhat += g[s] * (in[s] - mu);                                                 \
+            }                                                                                      \
+        }                                                                                          \
+        rstd = 1 / sqrt((count > 0 ? sq / count : 0) + eps);                                       \
+        sum_g_xhat *= rstd;                                                                        \
+        dbeta[c] = (T) sum_g;                                                                      \
+        dgamma[c] = (T) sum_g_xhat;                                                                \
+        /* dx = gamma * rstd * (g - mean(g) - xhat * mean(g * xhat)) */                            \
+        k1 = (T) ((gamma != NULL ? gamma[c] : 1) * rstd);                                          \
+        k2 = (T) (count > 0 ? sum_g / count : 0);                                                  \
+        k3 = (T) (count > 0 ? sum_g_xhat / count * rstd : 0);                                     \
+        for (b = 0; b < batch; b++) {                                                              \
+            const T *in = x + (b * channels + c) * inner, *g = grad + (b * channels + c) * inner;  \
+            T *out = dx + (b * channels + c) * inner;                                              \
+            _Pragma("omp simd")                                                                    \
+            for (s = 0; s < inner; s++) {                                                          \
+                out[s] = k1 * (g[s] - k2 - (in[s] - (T) mu) * k3);                                 \
+            }                                                                                      \
+        }                                                                                          \
+    }                                                                                              \
+}                                                                                                  \
+                                                                                                   \
+/* loss[i] = logsumexp(z_i) - sum_j t_ij z_ij and grad = softmax(z) - t, where                    \
+ * t is the row of `targets` or the one-hot row of `labels`. Either output                         \
+ * may be NULL. Returns the first out of bounds label or -1 */                                     \
+static long                                                                                        \
+tname##_cross_entropy(const T *z, const T *targets, const long *labels, T *loss, T *grad,          \
+                      long rows, int n) {                                                          \
+    int parallel = rows * n >= NDARRAY_NORM_PARALLEL_MIN;                                          \
+    long i;                                                                                        \
+                                                                                                   \
+    for (i = 0; labels != NULL && i < rows; i++) {                                                 \
+        if (labels[i] < 0 || labels[i] >= n) {                                                     \
+            return i;                                                                              \
+        }                                                                                          \
+    }                                                                                              \
+    _Pragma("omp parallel for if (parallel)")                                                      \
+    for (i = 0; i < rows; i++) {                                                                   \
+        const T *in = z + i * n, *t = targets != NULL ? targets + i * n : NULL;                    \
+        T max = in[0], sum = 0, lse, dot = 0, tsum = 0;                                            \
+        int j;                                                                                     \
+        for (j = 1; j < n; j++) {                                                                  \
+            max = in[j] > max ? in[j] : max;                                                       \
+        }                                                                                          \
+        _Pragma("omp simd reduction(+:sum)")                                                       \
+        for (j = 0; j < n; j++) {                                                                  \
+            sum += EXP(in[j] - max);                                                               \
+        }                                                                                          \
+        lse = max + LOG(sum);                                                                      \
+        if (t != NULL) {                                                                           \
+            _Pragma("omp simd reduction(+:dot, tsum)")                                             \
+            for (j = 0; j < n; j++) {                                                              \
+                dot += t[j] * in[j];                                                               \
+                tsum += t[j];                                                                      \
+            }                                                                                      \
+        } else {                                                                                   \
+            dot = in[labels[i]];                                                                   \
+            tsum = 1;                                                                              \
+        }                                                                                          \
+        if (loss != NULL) {                                                                        \
+            loss[i] = tsum * lse - dot;                                                            \
+        }                                                                                          \
+        if (grad != NULL) {                                                                        \
+            T *out = grad + i * n;                                                                 \
+            _Pragma("omp simd")                                                                    \
+            for (j = 0; j < n; j++) {                                                              \
+                out[j] = EXP(in[j] - lse) * tsum - (t != NULL ? t[j] : 0);                         \
+            }                                                                                      \
+            if (t == NULL) {                                                                       \
+                out[labels[i]] -= 1;                                                               \
+            }                                                                                      \
+        }                                                                                          \
+    }                                                                                              \
+    return -1;                                                                                     \
+}
+
+NDARRAY_NORM_KERNELS(float, float32, expf, logf)
+NDARRAY_NORM_KERNELS(double, float64, exp, log)
+
+/**
+ * Compute type of the normalization operations on `x`
+ */
+static const char*
+ndarray_norm_type(NDArray *x) {
+    return is_type(NDArray_TYPE(x), NDARRAY_TYPE_DOUBLE64) ? NDARRAY_TYPE_DOUBLE64 : NDARRAY_TYPE_FLOAT32;
+}
+
+/**
+ * Empty CPU array of `type` with the shape of `a`
+ */
+static NDArray*
+ndarray_norm_like(NDArray *a, const char *type) {
+    int *shape = emalloc(sizeof(int) * (NDArray_NDIM(a) > 0 ? NDArray_NDIM(a) : 1));
+
+    memcpy(shape, NDArray_SHAPE(a), sizeof(int) * NDArray_NDIM(a));
+    return NDArray_Empty(shape, NDArray_NDIM(a), type, NDARRAY_DEVICE_CPU);
+}
+
+static NDArray*
+ndarray_norm_vector(int n, const char *type) {
+    int *shape = emalloc(sizeof(int));
+
+    shape[0] = n;
+    return NDArray_Empty(shape, 1, type, NDARRAY_DEVICE_CPU);
+}
+
+/**
+ * @return 0 when every non-NULL parameter has `n` elements, -1 with an exception thrown otherwise
+ */
+static int
+ndarray_norm_check_params(NDArray **params, int count, int n) {
+    int i;
+
+    for (i = 0; i < count; i++) {
+        if (params[i] != NULL && NDArray_NUMELEMENTS(params[i]) != n) {
+            zend_throw_error(NULL, "Normalization parameters must have %d elements.", n);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * Softmax, or log-softmax, over the last axis of `x`
+ *
+ * @param x
+ * @param logarithmic 1 for log-softmax
+ * @return
+ */
+NDArray*
+NDArrayDNN_Softmax(NDArray *x, int logarithmic) {
+    NDArray *operand, *rtn;
+    const char *type = ndarray_norm_type(x);
+    int n;
+
+    if (NDArray_NDIM(x) < 1) {
+        zend_throw_error(NULL, "softmax expects an input of at least one dimension.");
+        return NULL;
+    }
+    if (ndarray_dnn_operands("softmax", &x, &operand, 1, type) != 0) {
+        return NULL;
+    }
+    n = NDArray_SHAPE(x)[NDArray_NDIM(x) - 1];
+    rtn = ndarray_norm_like(x, type);
+    if (n > 0) {
+        if (is_type(type, NDARRAY_TYPE_DOUBLE64)) {
+            float64_softmax_rows(NDArray_DDATA(operand), NDArray_DDATA(rtn), NDArray_NUMELEMENTS(x) / n, n, logarithmic);
+        } else {
+            float32_softmax_rows(NDArray_FDATA(operand), NDArray_FDATA(rtn), NDArray_NUMELEMENTS(x) / n, n, logarithmic);
+        }
+    }
+    ndarray_dnn_release(&operand, &x, 1);
+    return rtn;
+}
+
+/**
+ * Layer normalization over the last axis of `x`
+ *
+ * @param x
+ * @param gamma scale of the last axis, or NULL
+ * @param beta shift of the last axis, or NULL
+ * @param eps
+ * @return
+ */
+NDArray*
+NDArrayDNN_LayerNorm(NDArray *x, NDArray *gamma, NDArray *beta, double eps) {
+    NDArray *inputs[3] = {x, gamma, beta}, *operands[3], *rtn;
+    const char *type = ndarray_norm_type(x);
+    int n;
+
+    if (NDArray_NDIM(x) < 1) {
+        zend_throw_error(NULL, "layerNorm expects an input of at least one dimension.");
+        return NULL;
+    }
+    n = NDArray_SHAPE(x)[NDArray_NDIM(x) - 1];
+    if (ndarray_norm_check_params(inputs + 1, 2, n) != 0
+            || ndarray_dnn_operands("layerNorm", inputs, operands, 3, type) != 0) {
+        return NULL;
+    }
+    rtn = ndarray_norm_like(x, type);
+    if (n > 0) {
+        if (is_type(type, NDARRAY_TYPE_DOUBLE64)) {
+            float64_layernorm_rows(NDArray_DDATA(operands[0]), gamma != NULL ? NDArray_DDATA(operands[1]) : NULL,
+                                   beta != NULL ? NDArray_DDATA(operands[2]) : NULL, NDArray_DDATA(rtn),
+                                   NDArray_NUMELEMENTS(x) / n, n, eps);
+        } else {
+            float32_layernorm_rows(NDArray_FDATA(operands[0]), gamma != NULL ? NDArray_FDATA(operands[1]) : NULL,
+                                   beta != NULL ? NDArray_FDATA(operands[2]) : NULL, NDArray_FDATA(rtn),
+                                   NDArray_NUMELEMENTS(x) / n, n, eps);
+        }
+    }
+    ndarray_dnn_release(operands, inputs, 3);
+    return rtn;
+}
+
+/**
+ * Gradients of NDArrayDNN_LayerNorm. The row statistics are recomputed
+ * from `x`.
+ *
+ * @param grad gradient of the loss with respect to the output
+ * @param x
+ * @param gamma
+ * @param eps
+ * @return [dx, dgamma, dbeta]
+ */
+NDArray**
+NDArrayDNN_LayerNorm_Backward(NDArray *grad, NDArray *x, NDArray *gamma, double eps) {
+    NDArray *inputs[3] = {grad, x, gamma}, *operands[3], **rtn;
+    const char *type = ndarray_norm_type(x);
+    long rows;
+    int n;
+
+    if (NDArray_NDIM(x) < 1) {
+        zend_throw_error(NULL, "layerNorm expects an input of at least one dimension.");
+        return NULL;
+    }
+    if (NDArray_NUMELEMENTS(grad) != NDArray_NUMELEMENTS(x)) {
+        zend_throw_error(NULL, "The gradient must have the shape of the input.");
+        return NULL;
+    }
+    n = NDArray_SHAPE(x)[NDArray_NDIM(x) - 1];
+    if (ndarray_norm_check_params(inputs + 2, 1, n) != 0
+            || ndarray_dnn_operands("layerNorm", inputs, operands, 3, type) != 0) {
+        return NULL;
+    }
+    rows = n > 0 ? NDArray_NUMELEMENTS(x) / n : 0;
+    rtn = emalloc(sizeof(NDArray*) * 3);
+    rtn[0] = ndarray_norm_like(x, type);
+    rtn[1] = ndarray_norm_vector(n, type);
+    rtn[2] = ndarray_norm_vector(n, type);
+    if (is_type(type, NDARRAY_TYPE_DOUBLE64)) {
+        float64_layernorm_backward_rows(NDArray_DDATA(operands[0]), NDArray_DDATA(operands[1]),
+                                        gamma != NULL ? NDArray_DDATA(operands[2]) : NULL, NDArray_DDATA(rtn[0]),
+                                        NDArray_DDATA(rtn[1]), NDArray_DDATA(rtn[2]), rows, n, eps);
+    } else {
+        float32_layernorm_backward_rows(NDArray_FDATA(operands[0]), NDArray_FDATA(operands[1]),
+                                        gamma != NULL ? NDArray_FDATA(operands[2]) : NULL, NDArray_FDATA(rtn[0]),
+                                        NDArray_FDATA(rtn[1]), NDArray_FDATA(rtn[2]), rows, n, eps);
+    }
+    ndarray_dnn_release(operands, inputs, 3);
+    return rtn;
+}
+
+/**
+ * Layout of a batch norm input: axis 0 is the batch, axis 1 the channels
+ * and the remaining axes are reduced together with the batch
+ *
+ * @return 0 on success, -1 with an exception thrown otherwise
+ */
+static int
+ndarray_batchnorm_layout(NDArray *x, long *batch, int *channels, long *inner) {
+    int i;
+
+    if (NDArray_NDIM(x) < 2) {
+        zend_throw_error(NULL, "batchNorm expects an input of at least two dimensions.");
+        return -1;
+    }
+    *batch = NDArray_SHAPE(x)[0];
+    *channels = NDArray_SHAPE(x)[1];
+    *inner = 1;
+    for (i = 2; i < NDArray_NDIM(x); i++) {
+        *inner *= NDArray_SHAPE(x)[i];
+    }
+    return 0;
+}
+
+/**
+ * Batch normalization per channel (axis 1) of `x`
+ *
+ * Without `mean` and `var` the biased batch statistics are used and
+ * returned; with them (inference) they are applied and returned as is.
+ *
+ * @param x (batch, channels, ...)
+ * @param gamma
+ * @param beta
+ * @param mean running mean or NULL
+ * @param var running variance or NULL
+ * @param eps
+ * @return [y, mean, var]
+ */
+NDArray**
+NDArrayDNN_BatchNorm(NDArray *x, NDArray *gamma, NDArray *beta, NDArray *mean, NDArray *var, double eps) {
+    NDArray *inputs[5] = {x, gamma, beta, mean, var}, *operands[5], **rtn;
+    const char *type = ndarray_norm_type(x);
+    long batch, inner;
+    int channels, given = mean != NULL;
+
+    if (ndarray_batchnorm_layout(x, &batch, &channels, &inner) != 0) {
+        return NULL;
+    }
+    if ((mean == NULL) != (var == NULL)) {
+        zend_throw_error(NULL, "mean and var must be given together.");
+        return NULL;
+    }
+    if (ndarray_norm_check_params(inputs + 1, 4, channels) != 0
+            || ndarray_dnn_operands("batchNorm", inputs, operands, 5, type) != 0) {
+        return NULL;
+    }
+    rtn = emalloc(sizeof(NDArray*) * 3);
+    rtn[0] = ndarray_norm_like(x, type);
+    rtn[1] = ndarray_norm_vector(channels, type);
+    rtn[2] = ndarray_norm_vector(channels, type);
+    if (given) {
+        memcpy(NDArray_DATA(rtn[1]), NDArray_DATA(operands[3]), NDArray_ELSIZE(rtn[1]) * channels);
+        memcpy(NDArray_DATA(rtn[2]), NDArray_DATA(operands[4]), NDArray_ELSIZE(rtn[2]) * channels);
+    }
+    if (is_type(type, NDARRAY_TYPE_DOUBLE64)) {
+        float64_batchnorm(NDArray_DDATA(operands[0]), gamma != NULL ? NDArray_DDATA(operands[1]) : NULL,
+                          beta != NULL ? NDArray_DDATA(operands[2]) : NULL, NDArray_DDATA(rtn[1]),
+                          NDArray_DDATA(rtn[2]), given, NDArray_DDATA(rtn[0]), batch, channels, inner, eps);
+    } else {
+        float32_batchnorm(NDArray_FDATA(operands[0]), gamma != NULL ? NDArray_FDATA(operands[1]) : NULL,
+                          beta != NULL ? NDArray_FDATA(operands[2]) : NULL, NDArray_FDATA(rtn[1]),
+                          NDArray_FDATA(rtn[2]), given, NDArray_FDATA(rtn[0]), batch, channels, inner, eps);
+    }
+    ndarray_dnn_release(operands, inputs, 5);
+    return rtn;
+}
+
+/**
+ * Gradients of NDArrayDNN_BatchNorm computed with batch statistics
+ *
+ * @param grad gradient of the loss with respect to the output
+ * @param x
+ * @param gamma
+ * @param eps
+ * @return [dx, dgamma, dbeta]
+ */
+NDArray**
+NDArrayDNN_BatchNorm_Backward(NDArray *grad, NDArray *x, NDArray *gamma, double eps) {
+    NDArray *inputs[3] = {grad, x, gamma}, *operands[3], **rtn;
+    const char *type = ndarray_norm_type(x);
+    long batch, inner;
+    int channels;
+
+    if (ndarray_batchnorm_layout(x, &batch, &channels, &inner) != 0) {
+        return NULL;
+    }
+    if (NDArray_NUMELEMENTS(grad) != NDArray_NUMELEMENTS(x)) {
+        zend_throw_error(NULL, "The gradient must have the shape of the input.");
+        return NULL;
+    }
+    if (ndarray_norm_check_params(inputs + 2, 1, channels) != 0
+            || ndarray_dnn_operands("batchNorm", inputs, operands, 3, type) != 0) {
+        return NULL;
+    }
+    rtn = emalloc(sizeof(NDArray*) * 3);
+    rtn[0] = ndarray_norm_like(x, type);
+    rtn[1] = ndarray_norm_vector(channels, type);
+    rtn[2] = ndarray_norm_vector(channels, type);
+    if (is_type(type, NDARRAY_TYPE_DOUBLE64)) {
+        float64_batchnorm_backward(NDArray_DDATA(operands[0]), NDArray_DDATA(operands[1]),
+                                   gamma != NULL ? NDArray_DDATA(operands[2]) : NULL, NDArray_DDATA(rtn[0]),
+                                   NDArray_DDATA(rtn[1]), NDArray_DDATA(rtn[2]), batch, channels, inner, eps);
+    } else {
+        float32_batchnorm_backward(NDArray_FDATA(operands[0]), NDArray_FDATA(operands[1]),
+                                   gamma != NULL ? NDArray_FDATA(operands[2]) : NULL, NDArray_FDATA(rtn[0]),
+                                   NDArray_FDATA(rtn[1]), NDArray_FDATA(rtn[2]), batch, channels, inner, eps);
+    }
+    ndarray_dnn_release(operands, inputs, 3);
+    return rtn;
+}
+
+/**
+ * Softmax cross-entropy of the rows of `logits`
+ *
+ * `labels` is either a vector of class indices, one per row, or an array
+ * of target distributions with the shape of `logits`.
+ *
+ * @param logits (rows, classes)
+ * @param labels
+ * @param loss per row loss, computed when not NULL
+ * @param grad gradient with respect to the logits, computed when not NULL
+ * @return 0 on success, -1 with an exception thrown otherwise
+ */
+int
+NDArrayDNN_CrossEntropyWithLogits(NDArray *logits, NDArray *labels, NDArray **loss, NDArray **grad) {
+    NDArray *inputs[2] = {logits, NULL}, *operands[2];
+    const char *type = ndarray_norm_type(logits);
+    long *indices = NULL, bad, i;
+    int rows, n;
+    double index;
+
+    if (NDArray_NDIM(logits) != 2) {
+        zend_throw_error(NULL, "logits must be two-dimensional.");
+        return -1;
+    }
+    rows = NDArray_SHAPE(logits)[0];
+    n = NDArray_SHAPE(logits)[1];
+    if (NDArray_NDIM(labels) == 1 && NDArray_NUMELEMENTS(labels) == rows) {
+        if (NDArray_DEVICE(labels) == NDARRAY_DEVICE_GPU) {
+            zend_throw_error(NULL, "crossEntropyWithLogits is only available for NDArrays on CPU RAM.");
+            return -1;
+        }
+        if ((operands[1] = ndarray_dnn_operand(labels, NDARRAY_TYPE_DOUBLE64)) == NULL) {
+            return -1;
+        }
+        indices = emalloc(sizeof(long) * (rows > 0 ? rows : 1));
+        for (i = 0; i < rows; i++) {
+            index = NDArray_DDATA(operands[1])[i];
+            indices[i] = index == (long) index ? (long) index : -1;
+        }
+        if (operands[1] != labels) {
+            NDArray_FREE(operands[1]);
+        }
+    } else if (NDArray_NDIM(labels) == 2 && NDArray_SHAPE(labels)[0] == rows && NDArray_SHAPE(labels)[1] == n) {
+        inputs[1] = labels;
+    } else {
+        zend_throw_error(NULL, "labels must be %d class indices or a (%d, %d) array of targets.", rows, rows, n);
+        return -1;
+    }
+    if (ndarray_dnn_operands("crossEntropyWithLogits", inputs, operands, 2, type) != 0) {
+        if (indices != NULL) {
+            efree(indices);
+        }
+        return -1;
+    }
+    if (loss != NULL) {
+        *loss = ndarray_norm_vector(rows, type);
+    }
+    if (grad != NULL) {
+        *grad = ndarray_norm_like(logits, type);
+    }
+    bad = -1;
+    if (n > 0 && is_type(type, NDARRAY_TYPE_DOUBLE64)) {
+        bad = float64_cross_entropy(NDArray_DDATA(operands[0]), inputs[1] != NULL ? NDArray_DDATA(operands[1]) : NULL,
+                                    indices, loss != NULL ? NDArray_DDATA(*loss) : NULL,
+                                    grad != NULL ? NDArray_DDATA(*grad) : NULL, rows, n);
+    } else if (n > 0) {
+        bad = float32_cross_entropy(NDArray_FDATA(operands[0]), inputs[1] != NULL ? NDArray_FDATA(operands[1]) : NULL,
+                                    indices, loss != NULL ? NDArray_FDATA(*loss) : NULL,
+                                    grad != NULL ? NDArray_FDATA(*grad) : NULL, rows, n);
+    }
+    ndarray_dnn_release(operands, inputs, 2);
+    if (indices != NULL) {
+        efree(indices);
+    }
+    if (bad >= 0 || (n == 0 && rows > 0)) {
+        zend_throw_error(NULL, "The label of row %ld is not a class index below %d.", bad >= 0 ? bad : 0, n);
+        if (loss != NULL) {
+            NDArray_FREE(*loss);
+        }
+        if (grad != NULL) {
+            NDArray_FREE(*grad);
+        }
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * Output elements times window size from which pooling runs in parallel
+ */
+#define NDARRAY_POOL_PARALLEL_MIN 32768
+
+/**
+ * Pooling problem with a 1-D input mapped onto a window of height 1
+ */
+typedef struct ndarray_pool_geometry {
+    long batch;
+    int channels, height, width, out_height, out_width;
+    NDArrayPool2D pool;
+} ndarray_pool_geometry;
+
+/**
+ * Max (with the flat input index of every maximum in `argmax`, when not
+ * NULL) or average pooling forward and backward for one float type.
+ * Windows are clipped to the input, so averages only count real elements.
+ */
+#define NDARRAY_POOL_KERNELS(T, tname)                                                             \
+static void                                                                                        \
+tname##_pool_nchw(const T *x, T *y, int64_t *argmax, const ndarray_pool_geometry *g, int max) {    \
+    const NDArrayPool2D *p = &g->pool;                                                             \
+    long planes = g->batch * g->channels, plane;                                                   \
+    long in_size = (long)g->height * g->width, out_size = (long)g->out_height * g->out_width;       \
+    int parallel = planes * out_size * p->kernel[0] * p->kernel[1] >= NDARRAY_POOL_PARALLEL_MIN;   \
+                                                                                                   \
+    _Pragma("omp parallel for if (parallel)")                                                      \
+    for (plane = 0; plane < planes; plane++) {                                                     \
+        const T *in = x + plane * in_size;                                                         \
+        T *out = y + plane * out_size;                                                             \
+        int oh, ow, ih, iw;                                                                        \
+        for (oh = 0; oh < g->out_height; oh++) {                                                   \
+            int h0 = oh * p->stride[0] - p->padding[0];                                            \
+            int hs = h0 > 0 ? h0 : 0, he = h0 + p->kernel[0] < g->height ? h0 + p->kernel[0] : g->height;\
+            for (ow = 0; ow < g->out_width; ow++) {                                                \
+                int w0 = ow * p->stride[1] - p->padding[1];                                        \
+                int ws = w0 > 0 ? w0 : 0, we = w0 + p->kernel[1] < g->width ? w0 + p->kernel[1] : g->width;\
+                long o = (long)oh * g->out_width + ow, best = (long)hs * g->width + ws;            \
+                T acc = max ? in[best] : 0;                                                        \
+                for (ih = hs; ih < he; ih++) {                                                     \
+                    const T *row = in + (long)ih * g->width;                                       \
+                    for (iw = ws; iw < we; iw++) {                                                 \
+                        if (!max) {                                                                \
+                            acc += row[iw];                                                        \
+                        } else if (row[iw] > acc) {                                                \
+                            acc = row[iw];                                                         \
+                            best = (long)ih * g->width + iw;                                       \
+                        }                                                                          \
+                    }                                                                              \
+                }                                                                                  \
+                out[o] = max ? acc : acc / ((he - hs) * (we - ws));                                \
+                if (argmax != NULL) {                                                              \
+                    argmax[plane * out_size + o] = plane * in_size + best;                         \
+                }                                                                                  \
+            }                                                                                      \
+        }                                                                                          \
+    }                                                                                              \
+}                                                                                                  \
+                                                                                                   \
+/* Channels last: every window position updates all channels at once */                            \
+static void                                                                                        \
+tname##_pool_nhwc(const T *x, T *y, int64_t *argmax, const ndarray_pool_geometry *g, int max) {    \
+    const NDArrayPool2D *p = &g->pool;                                                             \
+    long rows = g->batch * g->out_height, r;                                                       \
+    int C = g->channels;                                                                           \
+    int parallel = rows * g->out_width * C * p->kernel[0] * p->kernel[1] >= NDARRAY_POOL_PARALLEL_MIN;\
+                                                                                                   \
+    _Pragma("omp parallel for if (parallel)")                                                      \
+    for (r = 0; r < rows; r++) {                                                                   \
+        long n = r / g->out_height;                                                                \
+        int oh = (int)(r % g->out_height), ow, ih, iw, c;                                          \
+        int h0 = oh * p->stride[0] - p->padding[0];                                                \
+        int hs = h0 > 0 ? h0 : 0, he = h0 + p->kernel[0] < g->height ? h0 + p->kernel[0] : g->height;\
+        for (ow = 0; ow < g->out_width; ow++) {                                                    \
+            int w0 = ow * p->stride[1] - p->padding[1];                                            \
+            int ws = w0 > 0 ? w0 : 0, we = w0 + p->kernel[1] < g->width ? w0 + p->kernel[1] : g->width;\
+            T *out = y + (r * g->out_width + ow) * C;                                              \
+            int64_t *idx = argmax != NULL ? argmax + (r * g->out_width + ow) * C : NULL;           \
+            long first = ((n * g->height + hs) * g->width + ws) * C;                               \
+            T scale;                                                                               \
+            for (c = 0; c < C; c++) {                                                              \
+                out[c] = max ? x[first + c] : 0;                                                   \
+                if (idx != NULL) {                                                                 \
+                    idx[c] = first + c;                                                            \
+                }                                                                                  \
+            }                                                                                      \
+            for (ih = hs; ih < he; ih++) {                                                         \
+                for (iw = ws; iw < we; iw++) {                                                     \
+                    long offset = ((n * g->height + ih) * g->width + iw) * C;                      \
+                    const T *in = x + offset;                                                      \
+                    if (!max) {                                                                    \
+                        _Pragma("omp simd")                                                        \
+                        for (c = 0; c < C; c++) {                                                  \
+                            out[c] += in[c];                                                       \
+                        }                                                                          \
+                    } else if (idx != NULL) {                                                      \
+                        _Pragma("omp simd")                                                        \
+                        for (c = 0; c < C; c++) {                                                  \
+                            if (in[c] > out[c]) {                                                  \
+                                out[c] = in[c];                                                    \
+                                idx[c] = offset + c;                                               \
+                            }                                                                      \
+                        }                                                                          \
+                    } else {                                                                       \
+                        _Pragma("omp simd")                                                        \
+                        for (c = 0; c < C; c++) {                                                  \
+                            out[c] = in[c] > out[c] ? in[c] : out[c];                              \
+                        }                                                                          \
+                    }                                                                              \
+                }                                                                                  \
+            }                                                                                      \
+            if (!max) {                                                                            \
+                scale = (T) 1 / ((he - hs) * (we - ws));                                           \
+                _Pragma("omp simd")                                                                \
+                for (c = 0; c < C; c++) {                                                          \
+                    out[c] *= scale;                                                               \
+                }                                                                                  \
+            }                                                                                      \
+        }                                                                                          \
+    }                                                                                              \
+}                                                                                                  \
+                                                                                                   \
+/* dx[argmax[i]] += grad[i]; every batch item only scatters into its own                           \
+ * part of dx. Returns 0, or -1 for an index outside of its batch item */                          \
+static int                                                                                         \
+tname##_max_pool_backward(const T *grad, const int64_t *argmax, T *dx, long batch, long out_item,  \
+                          long in_item) {                                                          \
+    int parallel = batch * out_item >= NDARRAY_POOL_PARALLEL_MIN, bad = 0;                         \
+    long n;                                                                                        \
+                                                                                                   \
+    memset(dx, 0, sizeof(T) * batch * in_item);                                                    \
+    _Pragma("omp parallel for reduction(|:bad) if (parallel)")                                     \
+    for (n = 0; n < batch; n++) {                                                                  \
+        long i;                                                                                    \
+        for (i = n * out_item; i < (n + 1) * out_item; i++) {                                      \
+            if (argmax[i] < n * in_item || argmax[i] >= (n + 1) * in_item) {                       \
+                bad = 1;                                                                           \
+                continue;                                                                          \
+            }                                                                                      \
+            dx[argmax[i]] += grad[i];                                                              \
+        }                                                                                          \
+    }                                                                                              \
+    return bad ? -1 : 0;                                                                           \
+}                                                                                                  \
+                                                                                                   \
+/* Spread every output gradient evenly over its clipped window */                                  \
+static void                                                                                        \
+tname##_avg_pool_backward(const T *grad, T *dx, const ndarray_pool_geometry *g) {                  \
+    const NDArrayPool2D *p = &g->pool;                                                             \
+    int C = p->channels_last ? g->channels : 1;                                                    \
+    long units = p->channels_last ? g->batch : g->batch * g->channels, u;                          \
+    long in_size = (long)g->height * g->width * C, out_size = (long)g->out_height * g->out_width * C;\
+    int parallel = units * out_size * p->kernel[0] * p->kernel[1] >= NDARRAY_POOL_PARALLEL_MIN;    \
+                                                                                                   \
+    memset(dx, 0, sizeof(T) * units * in_size);                                                    \
+    _Pragma("omp parallel for if (parallel)")                                                      \
+    for (u = 0; u < units; u++) {                                                                  \
+        const T *gr = grad + u * out_size;                                                         \
+        T *out = dx + u * in_size;                                                                 \
+        int oh, ow, ih, iw, c;                                                                     \
+        for (oh = 0; oh < g->out_height; oh++) {                                                   \
+            int h0 = oh * p->stride[0] - p->padding[0];                                            \
+            int hs = h0 > 0 ? h0 : 0, he = h0 + p->kernel[0] < g->height ? h0 + p->kernel[0] : g->height;\
+            for (ow = 0; ow < g->out_width; ow++) {                                                \
+                int w0 = ow * p->stride[1] - p->padding[1];                                        \
+                int ws = w0 > 0 ? w0 : 0, we = w0 + p->kernel[1] < g->width ? w0 + p->kernel[1] : g->width;\
+                const T *src = gr + ((long)oh * g->out_width + ow) * C;                            \
+                T scale = (T) 1 / ((he - hs) * (we - ws));                                         \
+                for (ih = hs; ih < he; ih++) {                                                     \
+                    for (iw = ws; iw < we; iw++) {                                                 \
+                        T *dst = out + ((long)ih * g->width + iw) * C;                             \
+                        _Pragma("omp simd")                                                        \
+                        for (c = 0; c < C; c++) {                                                  \
+                            dst[c] += src[c] * scale;                                              \
+                        }                                                                          \
+                    }                                                                              \
+                }                                                                                  \
+            }                                                                                      \
+        }                                                                                          \
+    }                                                                                              \
+}
+
+NDARRAY_POOL_KERNELS(float, float32)
+NDARRAY_POOL_KERNELS(double, float64)
+
+/**
+ * Pooling problem of an input of shape `shape`, with `spatial` (1 or 2)
+ * pooled axes after the batch axis and around the channel axis
+ *
+ * @return 0 on success, -1 with an exception thrown otherwise
+ */
+static int
+ndarray_pool_geometry_init(ndarray_pool_geometry *g, const int *shape, int ndim, int spatial,
+                           const NDArrayPool2D *pool) {
+    int i;
+
+    if (ndim != spatial + 2) {
+        zend_throw_error(NULL, "%d-D pooling expects an input of %d dimensions.", spatial, spatial + 2);
+        return -1;
+    }
+    g->pool = *pool;
+    if (spatial == 1) {
+        g->pool.kernel[0] = 1;
+        g->pool.stride[0] = 1;
+        g->pool.padding[0] = 0;
+    }
+    g->batch = shape[0];
+    g->channels = pool->channels_last ? shape[ndim - 1] : shape[1];
+    g->height = spatial == 2 ? shape[pool->channels_last ? 1 : 2] : 1;
+    g->width = shape[pool->channels_last ? ndim - 2 : ndim - 1];
+    for (i = 0; i < 2; i++) {
+        if (g->pool.kernel[i] < 1 || g->pool.stride[i] < 1) {
+            zend_throw_error(NULL, "Pooling kernel and stride must be positive.");
+            return -1;
+        }
+        if (g->pool.padding[i] < 0 || g->pool.padding[i] >= g->pool.kernel[i]) {
+            zend_throw_error(NULL, "Pooling padding must be non-negative and smaller than the kernel.");
+            return -1;
+        }
+    }
+    if (g->height < 1 || g->width < 1 || g->height + 2 * g->pool.padding[0] < g->pool.kernel[0]
+            || g->width + 2 * g->pool.padding[1] < g->pool.kernel[1]) {
+        zend_throw_error(NULL, "Pooling window does not fit the input.");
+        return -1;
+    }
+    g->out_height = (g->height + 2 * g->pool.padding[0] - g->pool.kernel[0]) / g->pool.stride[0] + 1;
+    g->out_width = (g->width + 2 * g->pool.padding[1] - g->pool.kernel[1]) / g->pool.stride[1] + 1;
+    return 0;
+}
+
+/**
+ * Output shape of a pooling problem in the layout of its input
+ */
+static int*
+ndarray_pool_output_shape(const ndarray_pool_geometry *g, int spatial) {
+    int *shape = emalloc(sizeof(int) * (spatial + 2)), i = 1;
+
+    shape[0] = (int) g->batch;
+    if (!g->pool.channels_last) {
+        shape[i++] = g->channels;
+    }
+    if (spatial == 2) {
+        shape[i++] = g->out_height;
+    }
+    shape[i++] = g->out_width;
+    if (g->pool.channels_last) {
+        shape[i] = g->channels;
+    }
+    return shape;
+}
+
+/**
+ * Max or average pooling over the `spatial` trailing (NCHW, NCW) or
+ * inner (NHWC, NWC) axes of `x`
+ *
+ * @param x
+ * @param pool window, for 1-D pooling only index 1 is read
+ * @param spatial 1 or 2
+ * @param max 1 for max pooling, 0 for average pooling
+ * @param argmax when not NULL, receives the int64 flat index into `x` of every maximum
+ * @return
+ */
+NDArray*
+NDArrayDNN_Pool_Forward(NDArray *x, NDArrayPool2D *pool, int spatial, int max, NDArray **argmax) {
+    ndarray_pool_geometry g;
+    const char *type = ndarray_norm_type(x);
+    NDArray *operand, *rtn;
+    int64_t *indices = NULL;
+
+    if (ndarray_pool_geometry_init(&g, NDArray_SHAPE(x), NDArray_NDIM(x), spatial, pool) != 0
+            || ndarray_dnn_operands("Pooling", &x, &operand, 1, type) != 0) {
+        return NULL;
+    }
+    rtn = NDArray_Empty(ndarray_pool_output_shape(&g, spatial), spatial + 2, type, NDARRAY_DEVICE_CPU);
+    if (argmax != NULL) {
+        *argmax = NDArray_Empty(ndarray_pool_output_shape(&g, spatial), spatial + 2, NDARRAY_TYPE_INT64,
+                                NDARRAY_DEVICE_CPU);
+        indices = (int64_t *) NDArray_DATA(*argmax);
+    }
+    if (is_type(type, NDARRAY_TYPE_DOUBLE64)) {
+        if (pool->channels_last) {
+            float64_pool_nhwc(NDArray_DDATA(operand), NDArray_DDATA(rtn), indices, &g, max);
+        } else {
+            float64_pool_nchw(NDArray_DDATA(operand), NDArray_DDATA(rtn), indices, &g, max);
+        }
+    } else {
+        if (pool->channels_last) {
+            float32_pool_nhwc(NDArray_FDATA(operand), NDArray_FDATA(rtn), indices, &g, max);
+        } else {
+            float32_pool_nchw(NDArray_FDATA(operand), NDArray_FDATA(rtn), indices, &g, max);
+        }
+    }
+    ndarray_dnn_release(&operand, &x, 1);
+    return rtn;
+}
+
+/**
+ * Gradient of max pooling, scattered through the argmax indices cached
+ * by NDArrayDNN_Pool_Forward
+ *
+ * @param grad gradient with respect to the pooled output
+ * @param argmax
+ * @param shape shape of the pooled input
+ * @param ndim
+ * @return
+ */
+NDArray*
+NDArrayDNN_MaxPool_Backward(NDArray *grad, NDArray *argmax, int *shape, int ndim) {
+    NDArray *inputs[2] = {grad, argmax}, *operands[2], *rtn;
+    const char *type = ndarray_norm_type(grad);
+    int *dx_shape, i, status;
+    long in_item = 1, batch;
+
+    if (ndim < 3 || NDArray_NDIM(grad) != ndim || NDArray_NUMELEMENTS(grad) != NDArray_NUMELEMENTS(argmax)
+            || NDArray_SHAPE(grad)[0] != shape[0]) {
+        zend_throw_error(NULL, "The gradient, argmax and input shape do not belong to the same pooling.");
+        return NULL;
+    }
+    // float argmax (e.g. from a PHP array) can't hold every index above 2^24
+    if (NDArray_TypeFuncs(NDArray_TYPE(argmax))->kind != NDARRAY_KIND_INT
+            && NDArray_TypeFuncs(NDArray_TYPE(argmax))->kind != NDARRAY_KIND_UINT) {
+        zend_throw_error(NULL, "argmax must be an integer NDArray, like the int64 one returned by the forward pass.");
+        return NULL;
+    }
+    if (ndarray_dnn_operands("Pooling", inputs, operands, 1, type) != 0) {
+        return NULL;
+    }
+    if ((operands[1] = ndarray_dnn_operand(argmax, NDARRAY_TYPE_INT64)) == NULL) {
+        ndarray_dnn_release(operands, inputs, 1);
+        return NULL;
+    }
+    for (i = 1; i < ndim; i++) {
+        in_item *= shape[i];
+    }
+    batch = shape[0];
+    dx_shape = emalloc(sizeof(int) * ndim);
+    memcpy(dx_shape, shape, sizeof(int) * ndim);
+    rtn = NDArray_Empty(dx_shape, ndim, type, NDARRAY_DEVICE_CPU);
+    if (is_type(type, NDARRAY_TYPE_DOUBLE64)) {
+        status = float64_max_pool_backward(NDArray_DDATA(operands[0]), (int64_t *) NDArray_DATA(operands[1]),
+                                           NDArray_DDATA(rtn), batch, batch > 0 ? NDArray_NUMELEMENTS(grad) / batch : 0,
+                                           in_item);
+    } else {
+        status = float32_max_pool_backward(NDArray_FDATA(operands[0]), (int64_t *) NDArray_DATA(operands[1]),
+                                           NDArray_FDATA(rtn), batch, batch > 0 ? NDArray_NUMELEMENTS(grad) / batch : 0,
+                                           in_item);
+    }
+    ndarray_dnn_release(operands, inputs, 2);
+    if (status != 0) {
+        zend_throw_error(NULL, "argmax index outside of its batch item.");
+        NDArray_FREE(rtn);
+        return NULL;
+    }
+    return rtn;
+}
+
+/**
+ * Gradient of average pooling
+ *
+ * @param grad gradient with respect to the pooled output
+ * @param shape shape of the pooled input
+ * @param ndim
+ * @param pool window used in the forward pass
+ * @param spatial 1 or 2
+ * @return
+ */
+NDArray*
+NDArrayDNN_AvgPool_Backward(NDArray *grad, int *shape, int ndim, NDArrayPool2D *pool, int spatial) {
+    ndarray_pool_geometry g;
+    const char *type = ndarray_norm_type(grad);
+    NDArray *operand, *rtn;
+    int *dx_shape;
+
+    if (ndarray_pool_geometry_init(&g, shape, ndim, spatial, pool) != 0) {
+        return NULL;
+    }
+    if (NDArray_NUMELEMENTS(grad) != g.batch * g.channels * g.out_height * g.out_width) {
+        zend_throw_error(NULL, "The gradient does not match the pooled output of the input shape.");
+        return NULL;
+    }
+    if (ndarray_dnn_operands("Pooling", &grad, &operand, 1, type) != 0) {
+        return NULL;
+    }
+    dx_shape = emalloc(sizeof(int) * ndim);
+    memcpy(dx_shape, shape, sizeof(int) * ndim);
+    rtn = NDArray_Empty(dx_shape, ndim, type, NDARRAY_DEVICE_CPU);
+    if (is_type(type, NDARRAY_TYPE_DOUBLE64)) {
+        float64_avg_pool_backward(NDArray_DDATA(operand), NDArray_DDATA(rtn), &g);
+    } else {
+        float32_avg_pool_backward(NDArray_FDATA(operand), NDArray_FDATA(rtn), &g);
+    }
+    ndarray_dnn_release(&operand, &grad, 1);
+    return rtn;
+}
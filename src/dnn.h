@@ -4,7 +4,29 @@
 #include "ndarray.h"
 #include "../config.h"
 
+/**
+ * Window of a pooling layer as (height, width) pairs. 1-D pooling only
+ * uses the width entries.
+ */
+typedef struct NDArrayPool2D {
+    int kernel[2];
+    int stride[2];
+    int padding[2];
+    int channels_last;
+} NDArrayPool2D;
+
 NDArray* NDArrayDNN_Conv2D_Forward(NDArray *x, NDArray *filters, int *kernel_size, char activation, int use_bias);
 NDArray** NDArrayDNN_Conv2D_Backward(NDArray *input, NDArray *y, NDArray *filters, int kernel_size, char activation, int use_bias);
 NDArray * NDArray_DNN_Conv1D(NDArray *a, NDArray *kernel);
+NDArray* NDArrayDNN_Linear(NDArray *x, NDArray *w, NDArray *b, char activation);
+NDArray** NDArrayDNN_Linear_Backward(NDArray *grad, NDArray *x, NDArray *w, NDArray *b, NDArray *y, char activation);
+NDArray* NDArrayDNN_Softmax(NDArray *x, int logarithmic);
+NDArray* NDArrayDNN_LayerNorm(NDArray *x, NDArray *gamma, NDArray *beta, double eps);
+NDArray** NDArrayDNN_LayerNorm_Backward(NDArray *grad, NDArray *x, NDArray *gamma, double eps);
+NDArray** NDArrayDNN_BatchNorm(NDArray *x, NDArray *gamma, NDArray *beta, NDArray *mean, NDArray *var, double eps);
+NDArray** NDArrayDNN_BatchNorm_Backward(NDArray *grad, NDArray *x, NDArray *gamma, double eps);
+int NDArrayDNN_CrossEntropyWithLogits(NDArray *logits, NDArray *labels, NDArray **loss, NDArray **grad);
+NDArray* NDArrayDNN_Pool_Forward(NDArray *x, NDArrayPool2D *pool, int spatial, int max, NDArray **argmax);
+NDArray* NDArrayDNN_MaxPool_Backward(NDArray *grad, NDArray *argmax, int *shape, int ndim);
+NDArray* NDArrayDNN_AvgPool_Backward(NDArray *grad, int *shape, int ndim, NDArrayPool2D *pool, int spatial);
 #endif //NUMPOWER_DNN_H
\ No newline at end of file
@@ -3,13 +3,18 @@
 #include "ndarray.h"
 #include "initializers.h"
 #include "types.h"
+#include "manipulation.h"
 #include "../config.h"
+#include <string.h>
 
 
 #ifdef HAVE_CUBLAS
 #include "src/gpu_alloc.h"
 #endif
 
+/* Bytes moved below which gather loops stay on one thread */
+#define NDARRAY_INDEX_PARALLEL_MIN 262144
+
 /**
  * NDArray diagonal
  *
@@ -29,9 +34,11 @@ NDArray_Diagonal(NDArray *target, int offset) {
     if (NDArray_DEVICE(target) == NDARRAY_DEVICE_CPU) {
         int *new_shape = emalloc(sizeof(int));
         new_shape[0] = NDArray_SHAPE(target)[NDArray_NDIM(target) - 1];
-        rtn = NDArray_Empty(new_shape, 1, NDARRAY_TYPE_FLOAT32, NDARRAY_DEVICE_CPU);
+        rtn = NDArray_Empty(new_shape, 1, NDArray_TYPE(target), NDARRAY_DEVICE_CPU);
         for (i = 0; i < NDArray_SHAPE(target)[NDArray_NDIM(target) - 1]; i++) {
-            NDArray_FDATA(rtn)[i] = ((float*)(NDArray_DATA(target) + (i * NDArray_STRIDES(target)[NDArray_NDIM(target) - 2]) + (i * NDArray_STRIDES(target)[NDArray_NDIM(target) - 1])))[0];
+            memcpy(rtn->data + (long)i * NDArray_ELSIZE(rtn),
+                   target->data + (i * NDArray_STRIDES(target)[NDArray_NDIM(target) - 2]) + (i * NDArray_STRIDES(target)[NDArray_NDIM(target) - 1]),
+                   NDArray_ELSIZE(rtn));
         }
     }
 #ifdef HAVE_CUBLAS
@@ -105,3 +112,634 @@ Slice_GetIndices(SliceObject *r, int length, int *start, int *stop, int *step, i
 
     return 0;
 }
+
+/**
+ * Copy one element of `elsize` bytes
+ */
+static inline void
+ndarray_copy_item(char *dst, const char *src, int elsize) {
+    switch (elsize) {
+        case 1:
+            *dst = *src;
+            break;
+        case 2:
+            *(uint16_t *) dst = *(const uint16_t *) src;
+            break;
+        case 4:
+            *(uint32_t *) dst = *(const uint32_t *) src;
+            break;
+        case 8:
+            *(uint64_t *) dst = *(const uint64_t *) src;
+            break;
+        default:
+            memcpy(dst, src, elsize);
+    }
+}
+
+/**
+ * Normalize axis against ndim, negative axes count from the end
+ *
+ * @return 0 on success, -1 with an exception thrown otherwise
+ */
+static int
+ndarray_normalize_axis(int *axis, int ndim) {
+    if (*axis < -ndim || *axis >= ndim) {
+        zend_throw_error(NULL, "Axis is out of bounds for array dimension");
+        return -1;
+    }
+    if (*axis < 0) {
+        *axis += ndim;
+    }
+    return 0;
+}
+
+/**
+ * Read an array of indices as int64 offsets into a dimension of size
+ * `length`. Negative indices count from the end.
+ *
+ * @param indices
+ * @param length
+ * @param axis Reported in the out of bounds error
+ * @return emalloc'd vector with NDArray_NUMELEMENTS(indices) entries, NULL on error
+ */
+static long*
+ndarray_index_vector(NDArray *indices, long length, int axis) {
+    NDArray *idx = indices;
+    const NDArrayTypeFuncs *funcs = NDArray_TypeFuncs(NDArray_TYPE(indices));
+    long i, n = NDArray_NUMELEMENTS(indices);
+    long *rtn;
+
+    if (NDArray_DEVICE(indices) == NDARRAY_DEVICE_GPU) {
+        zend_throw_error(NULL, "Index arrays are only available on CPU RAM.");
+        return NULL;
+    }
+    if (!NDArray_IsContiguous(indices)) {
+        idx = NDArray_ToContiguous(indices);
+    }
+    rtn = emalloc(sizeof(long) * (n > 0 ? n : 1));
+    for (i = 0; i < n; i++) {
+        rtn[i] = funcs->getlong(NDArray_DATA(idx) + i * funcs->elsize);
+        if (rtn[i] < 0) {
+            rtn[i] += length;
+        }
+        if (rtn[i] < 0 || rtn[i] >= length) {
+            zend_throw_error(NULL, "Index %ld is out of bounds for axis %d with size %ld.",
+                             funcs->getlong(NDArray_DATA(idx) + i * funcs->elsize), axis, length);
+            efree(rtn);
+            rtn = NULL;
+            break;
+        }
+    }
+    if (idx != indices) {
+        NDArray_FREE(idx);
+    }
+    return rtn;
+}
+
+/**
+ * Byte offsets of every position of `shape` walked in C order
+ *
+ * @param shape
+ * @param strides Byte strides of the addressed array
+ * @param ndim
+ * @return emalloc'd vector with prod(shape) entries
+ */
+static long*
+ndarray_dim_offsets(const int *shape, const int *strides, int ndim) {
+    long i, n = 1;
+    int d, coords[NDARRAY_MAX_DIMS] = {0};
+    long *rtn;
+
+    for (d = 0; d < ndim; d++) {
+        n *= shape[d];
+    }
+    rtn = emalloc(sizeof(long) * (n > 0 ? n : 1));
+    rtn[0] = 0;
+    for (i = 1; i < n; i++) {
+        rtn[i] = rtn[i - 1];
+        for (d = ndim - 1; d >= 0; d--) {
+            if (++coords[d] < shape[d]) {
+                rtn[i] += strides[d];
+                break;
+            }
+            rtn[i] -= (long) strides[d] * (shape[d] - 1);
+            coords[d] = 0;
+        }
+    }
+    return rtn;
+}
+
+/**
+ * Contiguous bool copy of `mask` after checking it matches `target`
+ *
+ * @return mask itself when already usable, NULL on error
+ */
+static NDArray*
+ndarray_mask_bytes(NDArray *target, NDArray *mask) {
+    if (NDArray_DEVICE(target) == NDARRAY_DEVICE_GPU || NDArray_DEVICE(mask) == NDARRAY_DEVICE_GPU) {
+        zend_throw_error(NULL, "Boolean masks are only available for NDArrays on CPU RAM.");
+        return NULL;
+    }
+    if (NDArray_NDIM(target) != NDArray_NDIM(mask) ||
+        !NDArray_CompareLists(NDArray_SHAPE(target), NDArray_SHAPE(mask), NDArray_NDIM(target))) {
+        zend_throw_error(NULL, "Boolean mask shape must match the indexed array.");
+        return NULL;
+    }
+    if (!is_type(NDArray_TYPE(mask), NDARRAY_TYPE_BOOL)) {
+        return NDArray_AsType(mask, NDARRAY_TYPE_BOOL);
+    }
+    if (!NDArray_IsContiguous(mask)) {
+        return NDArray_ToContiguous(mask);
+    }
+    return mask;
+}
+
+/**
+ * Take elements of `target` at `indices` along `axis`
+ *
+ * @param target
+ * @param indices Integer positions, negative ones count from the end
+ * @param axis NDARRAY_MAX_DIMS to index the flattened array
+ * @return Array of shape target.shape[:axis] + indices.shape + target.shape[axis+1:]
+ */
+NDArray*
+NDArray_Take(NDArray *target, NDArray *indices, int axis) {
+    NDArray *a = target, *rtn;
+    long *idx, outer = 1, length, block, nidx = NDArray_NUMELEMENTS(indices), t;
+    int *shape, ndim, i, j = 0;
+
+    if (NDArray_DEVICE(target) == NDARRAY_DEVICE_GPU) {
+        zend_throw_error(NULL, "take is only available for NDArrays on CPU RAM.");
+        return NULL;
+    }
+    if (axis == NDARRAY_MAX_DIMS) {
+        length = NDArray_NUMELEMENTS(target);
+        block = NDArray_ELSIZE(target);
+        ndim = NDArray_NDIM(indices);
+        shape = emalloc(sizeof(int) * (ndim > 0 ? ndim : 1));
+        memcpy(shape, NDArray_SHAPE(indices), sizeof(int) * ndim);
+        axis = 0;
+    } else {
+        if (ndarray_normalize_axis(&axis, NDArray_NDIM(target)) < 0) {
+            return NULL;
+        }
+        length = NDArray_SHAPE(target)[axis];
+        block = NDArray_ELSIZE(target);
+        ndim = NDArray_NDIM(target) - 1 + NDArray_NDIM(indices);
+        shape = emalloc(sizeof(int) * (ndim > 0 ? ndim : 1));
+        for (i = 0; i < axis; i++) {
+            outer *= NDArray_SHAPE(target)[i];
+            shape[j++] = NDArray_SHAPE(target)[i];
+        }
+        for (i = 0; i < NDArray_NDIM(indices); i++) {
+            shape[j++] = NDArray_SHAPE(indices)[i];
+        }
+        for (i = axis + 1; i < NDArray_NDIM(target); i++) {
+            block *= NDArray_SHAPE(target)[i];
+            shape[j++] = NDArray_SHAPE(target)[i];
+        }
+    }
+
+    idx = ndarray_index_vector(indices, length, axis);
+    if (idx == NULL) {
+        efree(shape);
+        return NULL;
+    }
+    if (!NDArray_IsContiguous(target)) {
+        a = NDArray_ToContiguous(target);
+    }
+    rtn = NDArray_Empty(shape, ndim, NDArray_TYPE(target), NDARRAY_DEVICE_CPU);
+
+    char *src = NDArray_DATA(a), *dst = NDArray_DATA(rtn);
+#pragma omp parallel for if (outer * nidx * block > NDARRAY_INDEX_PARALLEL_MIN)
+    for (t = 0; t < outer * nidx; t++) {
+        long o = t / nidx, k = t % nidx;
+        if (block == NDArray_ELSIZE(target)) {
+            ndarray_copy_item(dst + t * block, src + (o * length + idx[k]) * block, (int) block);
+        } else {
+            memcpy(dst + t * block, src + (o * length + idx[k]) * block, block);
+        }
+    }
+
+    efree(idx);
+    if (a != target) {
+        NDArray_FREE(a);
+    }
+    return rtn;
+}
+
+/**
+ * Write `values` into the flattened `target` at `indices`, in place.
+ * `values` is repeated when it is shorter than `indices`; with
+ * repeated indices the last write wins.
+ *
+ * @param target Contiguous array written in place
+ * @param indices Integer positions into the flattened array
+ * @param values Converted to the dtype of `target`
+ * @return 1 on success, 0 with an exception thrown otherwise
+ */
+int
+NDArray_Put(NDArray *target, NDArray *indices, NDArray *values) {
+    NDArray *v = values;
+    long *idx, k, nidx = NDArray_NUMELEMENTS(indices), nval = NDArray_NUMELEMENTS(values);
+    int elsize = NDArray_ELSIZE(target);
+
+    if (NDArray_DEVICE(target) == NDARRAY_DEVICE_GPU || NDArray_DEVICE(values) == NDARRAY_DEVICE_GPU) {
+        zend_throw_error(NULL, "put is only available for NDArrays on CPU RAM.");
+        return 0;
+    }
+    if (!NDArray_IsContiguous(target)) {
+        zend_throw_error(NULL, "put requires a contiguous array.");
+        return 0;
+    }
+    if (nval == 0 && nidx > 0) {
+        zend_throw_error(NULL, "Cannot put values from an empty array.");
+        return 0;
+    }
+    idx = ndarray_index_vector(indices, NDArray_NUMELEMENTS(target), 0);
+    if (idx == NULL) {
+        return 0;
+    }
+    if (!is_type(NDArray_TYPE(values), NDArray_TYPE(target))) {
+        v = NDArray_AsType(values, NDArray_TYPE(target));
+    } else if (!NDArray_IsContiguous(values)) {
+        v = NDArray_ToContiguous(values);
+    }
+
+    NDArray_EnsureWritable(target);
+    for (k = 0; k < nidx; k++) {
+        ndarray_copy_item(NDArray_DATA(target) + idx[k] * elsize, NDArray_DATA(v) + (k % nval) * elsize, elsize);
+    }
+
+    efree(idx);
+    if (v != values) {
+        NDArray_FREE(v);
+    }
+    return 1;
+}
+
+/**
+ * Write `values` into the elements of `target` where `mask` is true,
+ * in C order, in place
+ *
+ * @param target Contiguous array written in place
+ * @param mask Array with the same shape as `target`
+ * @param values One value, or one per selected element
+ * @return 1 on success, 0 with an exception thrown otherwise
+ */
+int
+NDArray_MaskAssign(NDArray *target, NDArray *mask, NDArray *values) {
+    NDArray *m, *v = values;
+    const unsigned char *flags;
+    long i, j = 0, count = 0, nval = NDArray_NUMELEMENTS(values);
+    int elsize = NDArray_ELSIZE(target);
+
+    if (!NDArray_IsContiguous(target)) {
+        zend_throw_error(NULL, "Boolean mask assignment requires a contiguous array.");
+        return 0;
+    }
+    m = ndarray_mask_bytes(target, mask);
+    if (m == NULL) {
+        return 0;
+    }
+    flags = (const unsigned char *) NDArray_DATA(m);
+    for (i = 0; i < NDArray_NUMELEMENTS(m); i++) {
+        count += (flags[i] != 0);
+    }
+    if (nval != 1 && nval != count) {
+        zend_throw_error(NULL, "Cannot assign %ld values to the %ld elements selected by the mask.", nval, count);
+        if (m != mask) {
+            NDArray_FREE(m);
+        }
+        return 0;
+    }
+    if (!is_type(NDArray_TYPE(values), NDArray_TYPE(target))) {
+        v = NDArray_AsType(values, NDArray_TYPE(target));
+    } else if (!NDArray_IsContiguous(values)) {
+        v = NDArray_ToContiguous(values);
+    }
+
+    NDArray_EnsureWritable(target);
+    for (i = 0; i < NDArray_NUMELEMENTS(m); i++) {
+        if (flags[i]) {
+            ndarray_copy_item(NDArray_DATA(target) + i * elsize, NDArray_DATA(v) + (nval == 1 ? 0 : j) * elsize, elsize);
+            j++;
+        }
+    }
+
+    if (v != values) {
+        NDArray_FREE(v);
+    }
+    if (m != mask) {
+        NDArray_FREE(m);
+    }
+    return 1;
+}
+
+/**
+ * Element-wise select from `x` where `condition` is true and from `y`
+ * elsewhere. The three arrays are broadcast together.
+ *
+ * @param condition Non-bool conditions are tested for non-zero
+ * @param x
+ * @param y
+ * @return Array with the promoted dtype of `x` and `y`
+ */
+NDArray*
+NDArray_Where(NDArray *condition, NDArray *x, NDArray *y) {
+    NDArray *ops[3] = {condition, x, y}, *cast[3], *rtn;
+    const char *type;
+    long *offsets[3], i, n;
+    int *shape, ndim = 0, d, k, elsize;
+    int unit[3][NDARRAY_MAX_DIMS];
+
+    for (k = 0; k < 3; k++) {
+        if (NDArray_DEVICE(ops[k]) == NDARRAY_DEVICE_GPU) {
+            zend_throw_error(NULL, "where is only available for NDArrays on CPU RAM.");
+            return NULL;
+        }
+        if (NDArray_NDIM(ops[k]) > ndim) {
+            ndim = NDArray_NDIM(ops[k]);
+        }
+    }
+    shape = emalloc(sizeof(int) * (ndim > 0 ? ndim : 1));
+    for (d = 0; d < ndim; d++) {
+        shape[d] = 1;
+        for (k = 0; k < 3; k++) {
+            int kd = d - (ndim - NDArray_NDIM(ops[k]));
+            int size = kd < 0 ? 1 : NDArray_SHAPE(ops[k])[kd];
+            if (size != 1 && shape[d] != 1 && size != shape[d]) {
+                zend_throw_error(NULL, "Broadcast shape mismatch.");
+                efree(shape);
+                return NULL;
+            }
+            if (size != 1) {
+                shape[d] = size;
+            }
+        }
+    }
+
+    type = NDArray_PromoteTypes(NDArray_TYPE(x), NDArray_TYPE(y));
+    cast[0] = is_type(NDArray_TYPE(condition), NDARRAY_TYPE_BOOL) ? condition : NDArray_AsType(condition, NDARRAY_TYPE_BOOL);
+    cast[1] = is_type(NDArray_TYPE(x), type) ? x : NDArray_AsType(x, type);
+    cast[2] = is_type(NDArray_TYPE(y), type) ? y : NDArray_AsType(y, type);
+    elsize = get_type_size(type);
+    rtn = NDArray_Empty(shape, ndim, type, NDARRAY_DEVICE_CPU);
+    n = NDArray_NUMELEMENTS(rtn);
+
+    // Broadcast dimensions are walked with a zero stride
+    for (k = 0; k < 3; k++) {
+        for (d = 0; d < ndim; d++) {
+            int kd = d - (ndim - NDArray_NDIM(cast[k]));
+            unit[k][d] = (kd < 0 || NDArray_SHAPE(cast[k])[kd] == 1) ? 0 : NDArray_STRIDES(cast[k])[kd];
+        }
+        offsets[k] = ndarray_dim_offsets(NDArray_SHAPE(rtn), unit[k], ndim);
+    }
+
+    const char *c = NDArray_DATA(cast[0]), *px = NDArray_DATA(cast[1]), *py = NDArray_DATA(cast[2]);
+    char *out = NDArray_DATA(rtn);
+#pragma omp parallel for if (n * elsize > NDARRAY_INDEX_PARALLEL_MIN)
+    for (i = 0; i < n; i++) {
+        const char *src = c[offsets[0][i]] ? px + offsets[1][i] : py + offsets[2][i];
+        ndarray_copy_item(out + i * elsize, src, elsize);
+    }
+
+    for (k = 0; k < 3; k++) {
+        efree(offsets[k]);
+        if (cast[k] != ops[k]) {
+            NDArray_FREE(cast[k]);
+        }
+    }
+    return rtn;
+}
+
+/**
+ * Check the shape rules shared by gather and scatterAdd: `index` has
+ * the rank of `target` and is no larger outside of `axis`
+ *
+ * @return 0 on success, -1 with an exception thrown otherwise
+ */
+static int
+ndarray_check_gather_shape(NDArray *target, NDArray *index, int *axis) {
+    int d;
+    if (NDArray_DEVICE(target) == NDARRAY_DEVICE_GPU || NDArray_DEVICE(index) == NDARRAY_DEVICE_GPU) {
+        zend_throw_error(NULL, "gather and scatterAdd are only available for NDArrays on CPU RAM.");
+        return -1;
+    }
+    if (NDArray_NDIM(index) != NDArray_NDIM(target)) {
+        zend_throw_error(NULL, "Index array must have the same number of dimensions as the input.");
+        return -1;
+    }
+    if (ndarray_normalize_axis(axis, NDArray_NDIM(target)) < 0) {
+        return -1;
+    }
+    for (d = 0; d < NDArray_NDIM(target); d++) {
+        if (d != *axis && NDArray_SHAPE(index)[d] > NDArray_SHAPE(target)[d]) {
+            zend_throw_error(NULL, "Index array is larger than the input in dimension %d.", d);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * out[i][j][k] = target[index[i][j][k]][j][k] for axis 0, and likewise
+ * for other axes
+ *
+ * @param target
+ * @param axis
+ * @param index Integer array with the rank of `target`
+ * @return Array with the shape of `index` and the dtype of `target`
+ */
+NDArray*
+NDArray_Gather(NDArray *target, int axis, NDArray *index) {
+    NDArray *rtn;
+    long *idx, *pre, *post, npre = 1, npost = 1, nk, p;
+    int *shape, ndim = NDArray_NDIM(target), elsize = NDArray_ELSIZE(target), d;
+
+    if (ndarray_check_gather_shape(target, index, &axis) < 0) {
+        return NULL;
+    }
+    idx = ndarray_index_vector(index, NDArray_SHAPE(target)[axis], axis);
+    if (idx == NULL) {
+        return NULL;
+    }
+    for (d = 0; d < axis; d++) {
+        npre *= NDArray_SHAPE(index)[d];
+    }
+    for (d = axis + 1; d < ndim; d++) {
+        npost *= NDArray_SHAPE(index)[d];
+    }
+    nk = NDArray_SHAPE(index)[axis];
+    pre = ndarray_dim_offsets(NDArray_SHAPE(index), NDArray_STRIDES(target), axis);
+    post = ndarray_dim_offsets(NDArray_SHAPE(index) + axis + 1, NDArray_STRIDES(target) + axis + 1, ndim - axis - 1);
+
+    shape = emalloc(sizeof(int) * ndim);
+    memcpy(shape, NDArray_SHAPE(index), sizeof(int) * ndim);
+    rtn = NDArray_Empty(shape, ndim, NDArray_TYPE(target), NDARRAY_DEVICE_CPU);
+
+    const char *src = NDArray_DATA(target);
+    char *dst = NDArray_DATA(rtn);
+    long axis_stride = NDArray_STRIDES(target)[axis];
+#pragma omp parallel for if (npre * nk * npost * elsize > NDARRAY_INDEX_PARALLEL_MIN)
+    for (p = 0; p < npre * nk; p++) {
+        long q, t = p * npost;
+        const char *row = src + pre[p / nk];
+        for (q = 0; q < npost; q++, t++) {
+            ndarray_copy_item(dst + t * elsize, row + idx[t] * axis_stride + post[q], elsize);
+        }
+    }
+
+    efree(idx);
+    efree(pre);
+    efree(post);
+    return rtn;
+}
+
+/**
+ * Copy of `target` with out[index[i][j][k]][j][k] += src[i][j][k] for
+ * axis 0, and likewise for other axes. Repeated indices accumulate.
+ *
+ * @param target
+ * @param axis
+ * @param index Integer array with the rank of `target`
+ * @param src Values to add, at least as large as `index`
+ * @return Array with the shape and dtype of `target`
+ */
+NDArray*
+NDArray_ScatterAdd(NDArray *target, int axis, NDArray *index, NDArray *src) {
+    NDArray *s = src, *rtn;
+    const NDArrayTypeFuncs *funcs = NDArray_TypeFuncs(NDArray_TYPE(target));
+    long *idx, *pre_src, *pre_out, *post_src, *post_out, npre = 1, npost = 1, nk, p, q, t = 0;
+    int ndim = NDArray_NDIM(target), d;
+
+    if (ndarray_check_gather_shape(target, index, &axis) < 0) {
+        return NULL;
+    }
+    if (NDArray_DEVICE(src) == NDARRAY_DEVICE_GPU || NDArray_NDIM(src) != ndim) {
+        zend_throw_error(NULL, "Source array must be on CPU RAM and have the same number of dimensions as the input.");
+        return NULL;
+    }
+    for (d = 0; d < ndim; d++) {
+        if (NDArray_SHAPE(index)[d] > NDArray_SHAPE(src)[d]) {
+            zend_throw_error(NULL, "Index array is larger than the source in dimension %d.", d);
+            return NULL;
+        }
+    }
+    if (funcs->add == NULL) {
+        zend_throw_error(NULL, "Operation not supported for dtype %s.", NDArray_TYPE(target));
+        return NULL;
+    }
+    idx = ndarray_index_vector(index, NDArray_SHAPE(target)[axis], axis);
+    if (idx == NULL) {
+        return NULL;
+    }
+    if (!is_type(NDArray_TYPE(src), NDArray_TYPE(target))) {
+        s = NDArray_AsType(src, NDArray_TYPE(target));
+    }
+    rtn = NDArray_IsContiguous(target) ? NDArray_Copy(target, NDARRAY_DEVICE_CPU) : NDArray_ToContiguous(target);
+
+    for (d = 0; d < axis; d++) {
+        npre *= NDArray_SHAPE(index)[d];
+    }
+    for (d = axis + 1; d < ndim; d++) {
+        npost *= NDArray_SHAPE(index)[d];
+    }
+    nk = NDArray_SHAPE(index)[axis];
+    pre_src = ndarray_dim_offsets(NDArray_SHAPE(index), NDArray_STRIDES(s), axis);
+    pre_out = ndarray_dim_offsets(NDArray_SHAPE(index), NDArray_STRIDES(rtn), axis);
+    post_src = ndarray_dim_offsets(NDArray_SHAPE(index) + axis + 1, NDArray_STRIDES(s) + axis + 1, ndim - axis - 1);
+    post_out = ndarray_dim_offsets(NDArray_SHAPE(index) + axis + 1, NDArray_STRIDES(rtn) + axis + 1, ndim - axis - 1);
+
+    // Sequential, repeated indices would race
+    for (p = 0; p < npre * nk; p++) {
+        const char *src_row = NDArray_DATA(s) + pre_src[p / nk] + (p % nk) * NDArray_STRIDES(s)[axis];
+        char *out_row = NDArray_DATA(rtn) + pre_out[p / nk];
+        for (q = 0; q < npost; q++, t++) {
+            char *out = out_row + idx[t] * NDArray_STRIDES(rtn)[axis] + post_out[q];
+            funcs->add(out, 0, src_row + post_src[q], 0, out, 0, 1);
+        }
+    }
+
+    efree(idx);
+    efree(pre_src);
+    efree(pre_out);
+    efree(post_src);
+    efree(post_out);
+    if (s != src) {
+        NDArray_FREE(s);
+    }
+    return rtn;
+}
+
+/**
+ * Select the elements of `target` where `mask` is true, in C order
+ *
+ * @param target
+ * @param mask Array with the same shape as `target`; non-bool masks are tested for non-zero
+ * @return 1-D array with the dtype of `target`
+ */
+NDArray*
+NDArray_MaskSelect(NDArray *target, NDArray *mask) {
+    NDArray *a = target, *m, *rtn;
+    const unsigned char *flags;
+    char *src, *dst;
+    int *shape;
+    long i, j = 0, count = 0, last = -1;
+    int elsize = NDArray_ELSIZE(target);
+
+    m = ndarray_mask_bytes(target, mask);
+    if (m == NULL) {
+        return NULL;
+    }
+    if (!NDArray_IsContiguous(target)) {
+        a = NDArray_ToContiguous(target);
+    }
+
+    // Bool buffers filled from raw bytes may hold values other than 1
+    flags = (const unsigned char *) NDArray_DATA(m);
+    for (i = 0; i < NDArray_NUMELEMENTS(m); i++) {
+        count += (flags[i] != 0);
+        if (flags[i]) {
+            last = i;
+        }
+    }
+    shape = emalloc(sizeof(int));
+    shape[0] = (int) count;
+    rtn = NDArray_Empty(shape, 1, NDArray_TYPE(target), NDARRAY_DEVICE_CPU);
+
+    // Branchless compress: every element is stored and the cursor only
+    // advances on selected ones. Up to the last selected element the
+    // cursor stays inside the output.
+    src = NDArray_DATA(a);
+    dst = NDArray_DATA(rtn);
+    switch (elsize) {
+        case 4:
+            for (i = 0; i <= last; i++) {
+                ((uint32_t *) dst)[j] = ((const uint32_t *) src)[i];
+                j += (flags[i] != 0);
+            }
+            break;
+        case 8:
+            for (i = 0; i <= last; i++) {
+                ((uint64_t *) dst)[j] = ((const uint64_t *) src)[i];
+                j += (flags[i] != 0);
+            }
+            break;
+        default:
+            for (i = 0; i <= last; i++) {
+                if (flags[i]) {
+                    ndarray_copy_item(dst + j * elsize, src + i * elsize, elsize);
+                    j++;
+                }
+            }
+    }
+
+    if (m != mask) {
+        NDArray_FREE(m);
+    }
+    if (a != target) {
+        NDArray_FREE(a);
+    }
+    return rtn;
+}
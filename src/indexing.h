@@ -10,5 +10,12 @@ typedef struct {
 } SliceObject;
 
 NDArray* NDArray_Diagonal(NDArray *target, int offset);
+NDArray* NDArray_MaskSelect(NDArray *target, NDArray *mask);
 int Slice_GetIndices(SliceObject *r, int length, int *start, int *stop, int *step, int *slicelength);
+NDArray* NDArray_Take(NDArray *target, NDArray *indices, int axis);
+int NDArray_Put(NDArray *target, NDArray *indices, NDArray *values);
+int NDArray_MaskAssign(NDArray *target, NDArray *mask, NDArray *values);
+NDArray* NDArray_Where(NDArray *condition, NDArray *x, NDArray *y);
+NDArray* NDArray_Gather(NDArray *target, int axis, NDArray *index);
+NDArray* NDArray_ScatterAdd(NDArray *target, int axis, NDArray *index, NDArray *src);
 #endif //PHPSCI_NDARRAY_INDEXING_H
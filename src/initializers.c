@@ -157,42 +157,33 @@ int iteration = 0;
 void
 NDArray_CopyFromZendArray(NDArray* target, zend_array* target_zval, int * first_index) {
     zval * element;
-    float * data_double;
+    double value;
+    const NDArrayTypeFuncs *funcs = NDArray_TypeFuncs(NDArray_TYPE(target));
 
     ZEND_HASH_FOREACH_VAL(target_zval, element) {
         ZVAL_DEREF(element);
         switch (Z_TYPE_P(element)) {
             case IS_ARRAY:
                 NDArray_CopyFromZendArray(target, Z_ARRVAL_P(element), first_index);
-                break;
+                continue;
             case IS_LONG:
-                convert_to_long(element);
-                data_double = NDArray_FDATA(target);
-                data_double[*first_index] = (float) zval_get_long(element);
-                *first_index = *first_index + 1;
+                value = (double) zval_get_long(element);
                 break;
             case IS_TRUE:
-                convert_to_long(element);
-                data_double = NDArray_FDATA(target);
-                data_double[*first_index] = (float) 1.0;
-                *first_index = *first_index + 1;
+                value = 1.0;
                 break;
             case IS_FALSE:
-                convert_to_long(element);
-                data_double = NDArray_FDATA(target);
-                data_double[*first_index] = (float) 0.0;
-                *first_index = *first_index + 1;
+                value = 0.0;
                 break;
             case IS_DOUBLE:
-                convert_to_double(element);
-                data_double = NDArray_FDATA(target);
-                data_double[*first_index] = (float) zval_get_double(element);
-                *first_index = *first_index + 1;
+                value = zval_get_double(element);
                 break;
             default:
                 zend_throw_error(NULL, "an element with an invalid type was used at initialization");
                 return;
         }
+        funcs->setitem(NDArray_DATA(target) + ((long)*first_index * funcs->elsize), value);
+        *first_index = *first_index + 1;
     }
     ZEND_HASH_FOREACH_END();
 }
@@ -203,9 +194,10 @@ NDArray_CopyFromZendArray(NDArray* target, zend_array* target_zval, int * first_
  *
  * @param ht
  * @param ndim
+ * @param type
  * @return
  */
-NDArray* Create_NDArray_FromZendArray(zend_array* ht, int ndim) {
+NDArray* Create_NDArray_FromZendArray(zend_array* ht, int ndim, const char *type) {
     int last_index = 0;
     int *shape;
     if (ndim != 0) {
@@ -223,9 +215,9 @@ NDArray* Create_NDArray_FromZendArray(zend_array* ht, int ndim) {
     for (int i = 1; i < ndim; i++) {
         total_num_elements = total_num_elements * shape[i];
     }
-    NDArray* array = Create_NDArray(shape, ndim, NDARRAY_TYPE_FLOAT32, NDARRAY_DEVICE_CPU);
+    NDArray* array = Create_NDArray(shape, ndim, type, NDARRAY_DEVICE_CPU);
     if (ndim != 0) {
-        NDArray_CreateBuffer(array, total_num_elements, get_type_size(NDARRAY_TYPE_FLOAT32));
+        NDArray_CreateBuffer(array, total_num_elements, get_type_size(type));
         NDArray_CopyFromZendArray(array, ht, &last_index);
     } else {
         array->data = NULL;
@@ -241,9 +233,20 @@ NDArray* Create_NDArray_FromZendArray(zend_array* ht, int ndim) {
  * @return
  */
 NDArray* Create_NDArray_FromZval(zval* php_object) {
+    return Create_NDArray_FromZvalType(php_object, NDARRAY_TYPE_FLOAT32);
+}
+
+/**
+ * Create NDArray of a given dtype from PHP Object (zval)
+ *
+ * @param php_object
+ * @param type
+ * @return
+ */
+NDArray* Create_NDArray_FromZvalType(zval* php_object, const char *type) {
     NDArray* new_array = NULL;
     if (Z_TYPE_P(php_object) == IS_ARRAY) {
-        new_array = Create_NDArray_FromZendArray(Z_ARRVAL_P(php_object), get_num_dims_from_zval(php_object));
+        new_array = Create_NDArray_FromZendArray(Z_ARRVAL_P(php_object), get_num_dims_from_zval(php_object), type);
     }
     return new_array;
 }
@@ -287,6 +290,25 @@ Create_NDArray(int* shape, int ndim, const char* type, const int device) {
     return rtn;
 }
 
+/**
+ * Point view at the array it reads through. Views of copy-on-write
+ * arrays reference the buffer's holder and are copy-on-write themselves,
+ * so reading them never copies and writing them only copies the view.
+ *
+ * @param view
+ * @param target
+ */
+void
+NDArray_SetViewBase(NDArray *view, NDArray *target) {
+    view->flags = 0;
+    view->base = target;
+    if (NDArray_CHKFLAGS(target, NDARRAY_ARRAY_COPY_ON_WRITE)) {
+        view->flags = NDARRAY_ARRAY_COPY_ON_WRITE;
+        view->base = target->base;
+    }
+    NDArray_ADDREF(view->base);
+}
+
 /**
  * Create an NDArray View from another NDArray with
  * a custom data pointer
@@ -310,15 +332,91 @@ NDArray_FromNDArrayBase(NDArray *target, char *data_ptr, int* shape, int* stride
         total_num_elements = total_num_elements * NDArray_SHAPE(rtn)[i];
     }
 
-    rtn->flags = 0;
     rtn->data = data_ptr;
-    rtn->base = target;
+    NDArray_SetViewBase(rtn, target);
     rtn->ndim = ndim;
     rtn->refcount = 1;
     rtn->device = NDArray_DEVICE(target);
-    rtn->descriptor = Create_Descriptor(total_num_elements, sizeof(float), NDARRAY_TYPE_FLOAT32);
+    rtn->descriptor = Create_Descriptor(total_num_elements, NDArray_ELSIZE(target), NDArray_TYPE(target));
     NDArrayIterator_INIT(rtn);
-    NDArray_ADDREF(target);
+    return rtn;
+}
+
+/**
+ * Whether target can hand its buffer over to copy-on-write views
+ *
+ * @param target
+ * @return
+ */
+static int
+ndarray_can_share(NDArray *target) {
+    if (target->refcount != 1 || NDArray_DEVICE(target) != NDARRAY_DEVICE_CPU) {
+        return 0;
+    }
+    if (NDArray_CHKFLAGS(target, NDARRAY_ARRAY_SHARED) || NDArray_CHKFLAGS(target, NDARRAY_ARRAY_PERSISTENT)) {
+        return 0;
+    }
+    return target->base == NULL || NDArray_CHKFLAGS(target, NDARRAY_ARRAY_COPY_ON_WRITE);
+}
+
+/**
+ * Move the buffer of a CPU NDArray into a holder array and make it
+ * copy-on-write. Views created from it share the holder.
+ *
+ * @param source
+ * @return the holder
+ */
+NDArray*
+NDArray_CopyOnWriteHolder(NDArray *source) {
+    NDArray *holder = emalloc(sizeof(NDArray));
+    holder->uuid = 0;
+    holder->strides = NULL;
+    holder->dimensions = NULL;
+    holder->ndim = 0;
+    holder->data = source->data;
+    holder->base = NULL;
+    holder->flags = 0;
+    holder->descriptor = Create_Descriptor(NDArray_NUMELEMENTS(source), NDArray_ELSIZE(source), NDArray_TYPE(source));
+    holder->iterator = NULL;
+    holder->php_iterator = NULL;
+    holder->refcount = 1;
+    holder->device = NDARRAY_DEVICE_CPU;
+    source->base = holder;
+    NDArray_ENABLEFLAGS(source, NDARRAY_ARRAY_COPY_ON_WRITE);
+    return holder;
+}
+
+/**
+ * Create a copy-on-write view of a contiguous CPU NDArray. The view
+ * and target read the same buffer until one of them is written, see
+ * NDArray_EnsureWritable. Targets that can't share their buffer, like
+ * views or shared memory, are copied first.
+ *
+ * @param target
+ * @param data_ptr
+ * @param shape
+ * @param strides
+ * @param ndim
+ * @return
+ */
+NDArray*
+NDArray_CopyOnWriteView(NDArray *target, char *data_ptr, int* shape, int* strides, const int ndim) {
+    NDArray *source = target, *rtn;
+
+    if (!ndarray_can_share(target)) {
+        source = NDArray_Copy(target, NDARRAY_DEVICE_CPU);
+        data_ptr = source->data + (data_ptr - target->data);
+    }
+
+    // The first view moves the buffer into a holder both sides point to
+    if (source->base == NULL) {
+        NDArray_CopyOnWriteHolder(source);
+    }
+
+    rtn = NDArray_FromNDArrayBase(source, data_ptr, shape, strides, ndim);
+    if (source != target) {
+        NDArray_FREE(source);
+    }
     return rtn;
 }
 
@@ -359,15 +457,13 @@ NDArray_FromNDArray(NDArray *target, int buffer_offset, int* shape, int* strides
         total_num_elements = total_num_elements * NDArray_SHAPE(rtn)[i];
     }
 
-    rtn->flags = 0;
     rtn->data = target->data + buffer_offset;
-    rtn->base = target;
+    NDArray_SetViewBase(rtn, target);
     rtn->ndim = out_ndim;
     rtn->refcount = 1;
     rtn->device = NDArray_DEVICE(target);
-    rtn->descriptor = Create_Descriptor(total_num_elements, sizeof(float), NDARRAY_TYPE_FLOAT32);
+    rtn->descriptor = Create_Descriptor(total_num_elements, NDArray_ELSIZE(target), NDArray_TYPE(target));
     NDArrayIterator_INIT(rtn);
-    NDArray_ADDREF(target);
     return rtn;
 }
 
@@ -386,16 +482,14 @@ NDArray_Empty(int *shape, int ndim, const char *type, int device) {
         return rtn;
     }
 
-    if (is_type(type, NDARRAY_TYPE_FLOAT32)) {
-        if (device == NDARRAY_DEVICE_CPU) {
-            rtn->device = NDARRAY_DEVICE_CPU;
-            rtn->data = emalloc(NDArray_NUMELEMENTS(rtn) * sizeof(float));
-        } else {
+    if (device == NDARRAY_DEVICE_CPU) {
+        rtn->device = NDARRAY_DEVICE_CPU;
+        rtn->data = emalloc(NDArray_NUMELEMENTS(rtn) * NDArray_ELSIZE(rtn));
+    } else {
 #ifdef HAVE_CUBLAS
-            rtn->device = NDARRAY_DEVICE_GPU;
-            vmalloc((void **) &rtn->data, NDArray_NUMELEMENTS(rtn) * sizeof(float));
+        rtn->device = NDARRAY_DEVICE_GPU;
+        vmalloc((void **) &rtn->data, NDArray_NUMELEMENTS(rtn) * NDArray_ELSIZE(rtn));
 #endif
-        }
     }
     return rtn;
 }
@@ -427,23 +521,12 @@ NDArray_Zeros(int *shape, int ndim, const char *type, const int device) {
     }
 
     if (device == NDARRAY_DEVICE_CPU) {
-        if (is_type(type, NDARRAY_TYPE_DOUBLE64)) {
-            rtn->data = ecalloc(rtn->descriptor->numElements, sizeof(double));
-        }
-        if (is_type(type, NDARRAY_TYPE_FLOAT32)) {
-            rtn->data = ecalloc(rtn->descriptor->numElements, sizeof(float));
-        }
+        rtn->data = ecalloc(rtn->descriptor->numElements, NDArray_ELSIZE(rtn));
     }
 #ifdef HAVE_CUBLAS
     if (device == NDARRAY_DEVICE_GPU) {
-        if (is_type(type, NDARRAY_TYPE_DOUBLE64)) {
-            vmalloc((void**)(&rtn->data), rtn->descriptor->numElements * sizeof(double));
-            cudaMemset(rtn->data, 0, rtn->descriptor->numElements * sizeof(double));
-        }
-        if (is_type(type, NDARRAY_TYPE_FLOAT32)) {
-            vmalloc((void**)(&rtn->data), rtn->descriptor->numElements * sizeof(float));
-            cudaMemset(rtn->data, 0, rtn->descriptor->numElements * sizeof(float));
-        }
+        vmalloc((void**)(&rtn->data), rtn->descriptor->numElements * NDArray_ELSIZE(rtn));
+        cudaMemset(rtn->data, 0, rtn->descriptor->numElements * NDArray_ELSIZE(rtn));
     }
 #endif
     return rtn;
@@ -464,9 +547,10 @@ NDArray_Ones(int *shape, int ndim, const char *type) {
     }
 
     long i;
-    rtn->data = emalloc(sizeof(float) * NDArray_NUMELEMENTS(rtn));
+    const NDArrayTypeFuncs *funcs = NDArray_TypeFuncs(type);
+    rtn->data = emalloc(NDArray_ELSIZE(rtn) * NDArray_NUMELEMENTS(rtn));
     for (i = 0; i < NDArray_NUMELEMENTS(rtn); i++) {
-        NDArray_FDATA(rtn)[i] = (float)1.0;
+        funcs->setitem(rtn->data + i * NDArray_ELSIZE(rtn), 1.0);
     }
     return rtn;
 }
@@ -712,15 +796,22 @@ NDArray*
 NDArray_Fill(NDArray *a, float fill_value) {
     int i;
 
+    NDArray_EnsureWritable(a);
+
     if (NDArray_DEVICE(a) == NDARRAY_DEVICE_GPU) {
 #ifdef HAVE_CUBLAS
         cuda_fill_float(NDArray_FDATA(a), fill_value, NDArray_NUMELEMENTS(a));
         return a;
 #endif
-    } else {
+    } else if (is_type(NDArray_TYPE(a), NDARRAY_TYPE_FLOAT32)) {
         for (i = 0; i < NDArray_NUMELEMENTS(a); i++) {
             NDArray_FDATA(a)[i] = fill_value;
         }
+    } else {
+        const NDArrayTypeFuncs *funcs = NDArray_TypeFuncs(NDArray_TYPE(a));
+        for (i = 0; i < NDArray_NUMELEMENTS(a); i++) {
+            funcs->setitem(a->data + (long)i * funcs->elsize, fill_value);
+        }
     }
     return a;
 }
@@ -756,6 +847,7 @@ NDArray_CreateFromDoubleScalar(double scalar) {
     rtn->dimensions = emalloc(sizeof(int));
     rtn->iterator = NULL;
     rtn->base = NULL;
+    rtn->flags = 0;
     rtn->refcount = 1;
     ((float*)rtn->data)[0] = (float)scalar;
 
@@ -781,6 +873,7 @@ NDArray_CreateFromFloatScalar(float scalar) {
     rtn->dimensions = emalloc(sizeof(int));
     rtn->iterator = NULL;
     rtn->base = NULL;
+    rtn->flags = 0;
     rtn->refcount = 1;
     ((float *)rtn->data)[0] = scalar;
 
@@ -806,6 +899,7 @@ NDArray_CreateFromLongScalar(long scalar) {
     rtn->dimensions = emalloc(sizeof(int));
     rtn->iterator = NULL;
     rtn->base = NULL;
+    rtn->flags = 0;
     rtn->refcount = 1;
     ((float*)rtn->data)[0] = (float)scalar;
 
@@ -832,8 +926,8 @@ NDArray_Copy(NDArray *a, int device) {
         rtn->flags = 0;
         rtn->base = NULL;
         rtn->ndim = NDArray_NDIM(a);
-        vmalloc((void **) &rtn->data, NDArray_NUMELEMENTS(a) * sizeof(float));
-        cudaMemcpy(NDArray_FDATA(rtn), NDArray_FDATA(a), NDArray_NUMELEMENTS(a) * sizeof(float), cudaMemcpyDeviceToDevice);
+        vmalloc((void **) &rtn->data, NDArray_NUMELEMENTS(a) * NDArray_ELSIZE(a));
+        cudaMemcpy(NDArray_DATA(rtn), NDArray_DATA(a), NDArray_NUMELEMENTS(a) * NDArray_ELSIZE(a), cudaMemcpyDeviceToDevice);
         rtn->descriptor = emalloc(sizeof(NDArrayDescriptor));
         rtn->descriptor->numElements = NDArray_NUMELEMENTS(a);
         rtn->descriptor->elsize = NDArray_ELSIZE(a);
@@ -859,8 +953,8 @@ NDArray_Copy(NDArray *a, int device) {
         rtn->flags = 0;
         rtn->ndim = NDArray_NDIM(a);
         rtn->base = NULL;
-        rtn->data = emalloc(NDArray_NUMELEMENTS(a) * sizeof(float));
-        memcpy(NDArray_DATA(rtn), NDArray_DATA(a), NDArray_NUMELEMENTS(a) * sizeof(float));
+        rtn->data = emalloc(NDArray_NUMELEMENTS(a) * NDArray_ELSIZE(a));
+        memcpy(NDArray_DATA(rtn), NDArray_DATA(a), NDArray_NUMELEMENTS(a) * NDArray_ELSIZE(a));
         rtn->descriptor = Create_Descriptor(NDArray_NUMELEMENTS(a), NDArray_ELSIZE(a), NDArray_TYPE(a));
         NDArrayIterator_INIT(rtn);
         return rtn;
@@ -6,6 +6,7 @@
 
 NDArray* Create_NDArray(int* shape, int ndim, const char* type, int device);
 NDArray* Create_NDArray_FromZval(zval* php_object);
+NDArray* Create_NDArray_FromZvalType(zval* php_object, const char *type);
 NDArray* NDArray_FromNDArray(NDArray *target, int buffer_offset, int* shape, int* strides, const int* ndim);
 NDArray* NDArray_Zeros(int *shape, int ndim, const char *type, int device);
 NDArray* NDArray_Ones(int *shape, int ndim, const char *type);
@@ -27,6 +28,9 @@ NDArray* NDArray_Arange(double start, double stop, double step);
 NDArray* NDArray_Binomial(int *shape, int ndim, int n, float p);
 NDArray* NDArray_EmptyLike(NDArray *a);
 NDArray* NDArray_FromNDArrayBase(NDArray *target, char *data_ptr, int* shape, int* strides, const int ndim);
+NDArray* NDArray_CopyOnWriteView(NDArray *target, char *data_ptr, int* shape, int* strides, const int ndim);
+NDArray* NDArray_CopyOnWriteHolder(NDArray *source);
+void NDArray_SetViewBase(NDArray *view, NDArray *target);
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -0,0 +1,490 @@
+#include <Zend/zend.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "io.h"
+#include "ndarray.h"
+#include "initializers.h"
+#include "types.h"
+#include "../config.h"
+
+static const double io_pow10[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+/**
+ * Parse a float starting at `p`. Plain decimal numbers are converted inline,
+ * everything else (inf, nan, very large exponents) falls back to strtod, which
+ * is safe because chunks are always NUL terminated.
+ *
+ * @param p
+ * @param end
+ * @param out
+ * @return Pointer to the first character after the number, NULL on error
+ */
+static const char *
+io_parse_float(const char *p, const char *end, float *out)
+{
+    const char *start, *q;
+    uint64_t mantissa = 0;
+    int exponent = 0, digits = 0, negative = 0, any = 0, e, eneg;
+    double value;
+    char *next;
+
+    while (p < end && (*p == ' ' || *p == '\t')) {
+        p++;
+    }
+    start = p;
+    if (p < end && (*p == '-' || *p == '+')) {
+        negative = (*p == '-');
+        p++;
+    }
+    while (p < end && *p >= '0' && *p <= '9') {
+        if (digits < 19) {
+            mantissa = mantissa * 10 + (*p - '0');
+            if (mantissa != 0) {
+                digits++;
+            }
+        } else {
+            exponent++;
+        }
+        any = 1;
+        p++;
+    }
+    if (p < end && *p == '.') {
+        p++;
+        while (p < end && *p >= '0' && *p <= '9') {
+            if (digits < 19) {
+                mantissa = mantissa * 10 + (*p - '0');
+                if (mantissa != 0) {
+                    digits++;
+                }
+                exponent--;
+            }
+            any = 1;
+            p++;
+        }
+    }
+    if (!any) {
+        goto fallback;
+    }
+    if (p < end && (*p == 'e' || *p == 'E')) {
+        e = 0;
+        eneg = 0;
+        q = p + 1;
+        if (q < end && (*q == '-' || *q == '+')) {
+            eneg = (*q == '-');
+            q++;
+        }
+        if (q >= end || *q < '0' || *q > '9') {
+            goto fallback;
+        }
+        while (q < end && *q >= '0' && *q <= '9') {
+            if (e < 10000) {
+                e = e * 10 + (*q - '0');
+            }
+            q++;
+        }
+        exponent += eneg ? -e : e;
+        p = q;
+    }
+    if (exponent < -22 || exponent > 22) {
+        goto fallback;
+    }
+    value = (double)mantissa;
+    value = (exponent < 0) ? value / io_pow10[-exponent] : value * io_pow10[exponent];
+    *out = (float)(negative ? -value : value);
+    return p;
+fallback:
+    value = strtod(start, &next);
+    if (next == start || next > end) {
+        return NULL;
+    }
+    *out = (float)value;
+    return next;
+}
+
+/**
+ * Number of fields in a line. Blank delimiters collapse consecutive runs,
+ * as in whitespace separated files.
+ *
+ * @param p
+ * @param end
+ * @param delimiter
+ * @return
+ */
+static int
+io_count_fields(const char *p, const char *end, char delimiter)
+{
+    int n_fields = 1;
+    int blank_delimiter = (delimiter == ' ' || delimiter == '\t');
+
+    if (blank_delimiter) {
+        while (p < end && *p == delimiter) {
+            p++;
+        }
+        while (end > p && end[-1] == delimiter) {
+            end--;
+        }
+    }
+    for (; p < end; p++) {
+        if (*p == delimiter) {
+            n_fields++;
+            while (blank_delimiter && p + 1 < end && p[1] == delimiter) {
+                p++;
+            }
+        }
+    }
+    return n_fields;
+}
+
+/**
+ * Parse one line into `out`. `col_map` maps each field to its output column,
+ * or -1 when the field was not selected by `usecols`.
+ *
+ * @return 0 on success, -1 if the line is malformed
+ */
+static int
+io_parse_line(const char *p, const char *end, char delimiter, const int *col_map, int n_fields, float *out)
+{
+    int field;
+    float value;
+    int blank_delimiter = (delimiter == ' ' || delimiter == '\t');
+
+    if (blank_delimiter) {
+        while (p < end && *p == delimiter) {
+            p++;
+        }
+        while (end > p && end[-1] == delimiter) {
+            end--;
+        }
+    }
+    for (field = 0; field < n_fields; field++) {
+        if (col_map[field] >= 0) {
+            p = io_parse_float(p, end, &value);
+            if (p == NULL) {
+                return -1;
+            }
+            out[col_map[field]] = value;
+            while (p < end && *p != delimiter && (*p == ' ' || *p == '\t')) {
+                p++;
+            }
+        } else {
+            while (p < end && *p != delimiter) {
+                p++;
+            }
+        }
+        if (field + 1 < n_fields) {
+            if (p >= end || *p != delimiter) {
+                return -1;
+            }
+            p++;
+            while (blank_delimiter && p < end && *p == delimiter) {
+                p++;
+            }
+        }
+    }
+    return (p == end) ? 0 : -1;
+}
+
+/**
+ * Build the field -> output column map from `usecols`.
+ *
+ * @return Number of output columns, -1 on error
+ */
+static int
+io_build_col_map(int *col_map, int n_fields, int *usecols, int n_usecols)
+{
+    int i, col;
+
+    if (usecols == NULL) {
+        for (i = 0; i < n_fields; i++) {
+            col_map[i] = i;
+        }
+        return n_fields;
+    }
+    for (i = 0; i < n_fields; i++) {
+        col_map[i] = -1;
+    }
+    for (i = 0; i < n_usecols; i++) {
+        col = usecols[i];
+        if (col < 0) {
+            col += n_fields;
+        }
+        if (col < 0 || col >= n_fields) {
+            zend_throw_error(NULL, "loadtxt: column %d is out of bounds for a file with %d columns", usecols[i], n_fields);
+            return -1;
+        }
+        if (col_map[col] >= 0) {
+            zend_throw_error(NULL, "loadtxt: column %d was selected more than once", usecols[i]);
+            return -1;
+        }
+        col_map[col] = i;
+    }
+    return n_usecols;
+}
+
+/**
+ * Load a delimited text file into a 2-D float32 NDArray.
+ *
+ * The file is read `chunk_size` bytes at a time. Complete lines of each chunk
+ * are located first and then parsed in parallel straight into the output
+ * buffer, which is reserved from the file size and the first chunk's line
+ * density so large files are not copied while they grow.
+ *
+ * @param filename
+ * @param delimiter
+ * @param skiprows Number of leading lines to ignore
+ * @param usecols Columns to keep, NULL keeps all of them
+ * @param n_usecols
+ * @param chunk_size Bytes read per chunk
+ * @return
+ */
+NDArray*
+NDArray_LoadTxt(const char *filename, char delimiter, int skiprows, int *usecols, int n_usecols, long chunk_size)
+{
+    FILE *file;
+    NDArray *rtn;
+    char *chunk, *p, *line_end, *chunk_end;
+    float *data = NULL;
+    long capacity, length = 0, consumed, file_size;
+    long rows = 0, reserved_rows = 0, line_number = 0, error_line = -1;
+    long n_lines, lines_capacity = 0, estimate, i;
+    const char **starts = NULL, **ends = NULL;
+    long *numbers = NULL;
+    int n_fields = -1, n_cols = 0, *col_map = NULL, *shape;
+    int eof = 0;
+
+    if (chunk_size <= 0) {
+        chunk_size = NDARRAY_IO_DEFAULT_CHUNK_SIZE;
+    }
+
+    file = fopen(filename, "rb");
+    if (file == NULL) {
+        zend_throw_error(NULL, "Error opening file %s", filename);
+        return NULL;
+    }
+    fseek(file, 0, SEEK_END);
+    file_size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    capacity = chunk_size;
+    chunk = emalloc(capacity + 1);
+
+    while (!eof) {
+        length += (long)fread(chunk + length, 1, capacity - length, file);
+        eof = feof(file) || ferror(file);
+        chunk[length] = '\0';
+
+        // Only complete lines are parsed, the tail is carried to the next chunk
+        consumed = length;
+        if (!eof) {
+            while (consumed > 0 && chunk[consumed - 1] != '\n') {
+                consumed--;
+            }
+            if (consumed == 0) {
+                // A single line is larger than the chunk
+                if (length == capacity) {
+                    capacity *= 2;
+                    chunk = erealloc(chunk, capacity + 1);
+                }
+                continue;
+            }
+        }
+
+        n_lines = 0;
+        p = chunk;
+        chunk_end = chunk + consumed;
+        while (p < chunk_end) {
+            line_end = memchr(p, '\n', chunk_end - p);
+            if (line_end == NULL) {
+                line_end = chunk_end;
+            }
+            line_number++;
+            if (line_number > skiprows) {
+                char *s = p, *e = line_end;
+                while (s < e && (*s == ' ' || *s == '\t')) {
+                    s++;
+                }
+                while (e > s && (e[-1] == '\r' || e[-1] == ' ' || e[-1] == '\t')) {
+                    e--;
+                }
+                if (s < e && *s != '#') {
+                    if (n_fields < 0) {
+                        n_fields = io_count_fields(s, e, delimiter);
+                        col_map = emalloc(sizeof(int) * n_fields);
+                        n_cols = io_build_col_map(col_map, n_fields, usecols, n_usecols);
+                        if (n_cols < 0) {
+                            goto failure;
+                        }
+                    }
+                    if (n_lines == lines_capacity) {
+                        lines_capacity = (lines_capacity == 0) ? 1024 : lines_capacity * 2;
+                        starts = erealloc(starts, sizeof(char*) * lines_capacity);
+                        ends = erealloc(ends, sizeof(char*) * lines_capacity);
+                        numbers = erealloc(numbers, sizeof(long) * lines_capacity);
+                    }
+                    starts[n_lines] = s;
+                    ends[n_lines] = e;
+                    numbers[n_lines] = line_number;
+                    n_lines++;
+                }
+            }
+            p = line_end + 1;
+        }
+
+        if (n_lines > 0) {
+            if (rows + n_lines > reserved_rows) {
+                estimate = reserved_rows * 2;
+                if (reserved_rows == 0 && file_size > 0 && consumed > 0) {
+                    // Extrapolate the row count from the density of the first chunk
+                    estimate = (long)(((double)file_size / (double)consumed) * (double)n_lines * 1.05) + 1;
+                }
+                reserved_rows = (estimate > rows + n_lines) ? estimate : rows + n_lines;
+                data = erealloc(data, sizeof(float) * n_cols * reserved_rows);
+            }
+#pragma omp parallel for
+            for (i = 0; i < n_lines; i++) {
+                if (io_parse_line(starts[i], ends[i], delimiter, col_map, n_fields, data + (rows + i) * n_cols) < 0) {
+#pragma omp critical
+                    {
+                        if (error_line < 0 || numbers[i] < error_line) {
+                            error_line = numbers[i];
+                        }
+                    }
+                }
+            }
+            if (error_line >= 0) {
+                zend_throw_error(NULL, "loadtxt: could not parse line %ld of %s", error_line, filename);
+                goto failure;
+            }
+            rows += n_lines;
+        }
+
+        memmove(chunk, chunk + consumed, length - consumed);
+        length -= consumed;
+    }
+
+    fclose(file);
+    efree(chunk);
+    if (starts != NULL) {
+        efree(starts);
+        efree(ends);
+        efree(numbers);
+    }
+    if (col_map != NULL) {
+        efree(col_map);
+    }
+
+    if (rows == 0) {
+        if (data != NULL) {
+            efree(data);
+        }
+        zend_throw_error(NULL, "loadtxt: %s does not contain any data", filename);
+        return NULL;
+    }
+    if (reserved_rows > rows) {
+        data = erealloc(data, sizeof(float) * n_cols * rows);
+    }
+
+    shape = emalloc(sizeof(int) * 2);
+    shape[0] = (int)rows;
+    shape[1] = n_cols;
+    rtn = Create_NDArray(shape, 2, NDARRAY_TYPE_FLOAT32, NDARRAY_DEVICE_CPU);
+    rtn->data = (char*)data;
+    return rtn;
+failure:
+    fclose(file);
+    efree(chunk);
+    if (starts != NULL) {
+        efree(starts);
+        efree(ends);
+        efree(numbers);
+    }
+    if (col_map != NULL) {
+        efree(col_map);
+    }
+    if (data != NULL) {
+        efree(data);
+    }
+    return NULL;
+}
+
+/**
+ * Read raw float32 values from a binary file into a 1-D NDArray.
+ *
+ * The output is allocated once from the file size and filled with
+ * reads of at most `chunk_size` bytes.
+ *
+ * @param filename
+ * @param count Number of items to read, -1 reads until the end of the file
+ * @param offset Offset in bytes from the start of the file
+ * @param chunk_size
+ * @return
+ */
+NDArray*
+NDArray_FromFile(const char *filename, long count, long offset, long chunk_size)
+{
+    FILE *file;
+    NDArray *rtn;
+    long file_size, available, total_bytes, done = 0, to_read;
+    size_t nread;
+    char *data;
+    int *shape;
+
+    if (chunk_size <= 0) {
+        chunk_size = NDARRAY_IO_DEFAULT_CHUNK_SIZE;
+    }
+
+    file = fopen(filename, "rb");
+    if (file == NULL) {
+        zend_throw_error(NULL, "Error opening file %s", filename);
+        return NULL;
+    }
+    fseek(file, 0, SEEK_END);
+    file_size = ftell(file);
+    if (offset < 0 || offset > file_size) {
+        fclose(file);
+        zend_throw_error(NULL, "fromfile: offset %ld is out of bounds for %s", offset, filename);
+        return NULL;
+    }
+
+    available = (file_size - offset) / (long)sizeof(float);
+    if (count < 0) {
+        count = available;
+    }
+    if (count > available) {
+        fclose(file);
+        zend_throw_error(NULL, "fromfile: requested %ld items but %s only contains %ld", count, filename, available);
+        return NULL;
+    }
+    if (count == 0) {
+        fclose(file);
+        zend_throw_error(NULL, "fromfile: %s does not contain any data", filename);
+        return NULL;
+    }
+
+    fseek(file, offset, SEEK_SET);
+    total_bytes = count * (long)sizeof(float);
+    data = emalloc(total_bytes);
+    while (done < total_bytes) {
+        to_read = (total_bytes - done < chunk_size) ? total_bytes - done : chunk_size;
+        nread = fread(data + done, 1, to_read, file);
+        if (nread == 0) {
+            fclose(file);
+            efree(data);
+            zend_throw_error(NULL, "fromfile: unexpected end of file %s", filename);
+            return NULL;
+        }
+        done += (long)nread;
+    }
+    fclose(file);
+
+    shape = emalloc(sizeof(int));
+    shape[0] = (int)count;
+    rtn = Create_NDArray(shape, 1, NDARRAY_TYPE_FLOAT32, NDARRAY_DEVICE_CPU);
+    rtn->data = data;
+    return rtn;
+}
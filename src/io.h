@@ -0,0 +1,11 @@
+#ifndef NUMPOWER_IO_H
+#define NUMPOWER_IO_H
+
+#include "ndarray.h"
+
+#define NDARRAY_IO_DEFAULT_CHUNK_SIZE 1048576
+
+NDArray* NDArray_LoadTxt(const char *filename, char delimiter, int skiprows, int *usecols, int n_usecols, long chunk_size);
+NDArray* NDArray_FromFile(const char *filename, long count, long offset, long chunk_size);
+
+#endif //NUMPOWER_IO_H
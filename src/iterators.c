@@ -64,15 +64,7 @@ NDArrayIteratorPHP_REWIND(NDArray* array) {
  */
 NDArray*
 NDArrayIteratorPHP_GET(NDArray* array) {
-    NDArray_ADDREF(array);
-    int output_ndim = array->ndim - 1;
-    int* output_shape = emalloc(sizeof(int) * output_ndim);
-    memcpy(output_shape, NDArray_SHAPE(array) + 1, sizeof(int) * output_ndim);
-    NDArray* rtn = Create_NDArray(output_shape, output_ndim, NDArray_TYPE(array), NDArray_DEVICE(array));
-    rtn->device = NDArray_DEVICE(array);
-    rtn->data = array->data + (array->php_iterator->current_index * NDArray_STRIDES(array)[0]);
-    rtn->base = array;
-    return rtn;
+    return NDArrayIterator_ROW(array, array->php_iterator->current_index);
 }
 
 /**
@@ -93,20 +85,45 @@ NDArrayIterator_INIT(NDArray* array) {
  */
 NDArray*
 NDArrayIterator_GET(NDArray* array) {
-    NDArray_ADDREF(array);
-    int output_ndim = array->ndim - 1;
-    int* output_shape;
+    return NDArrayIterator_ROW(array, array->iterator->current_index);
+}
 
-    if (output_ndim >= 1) {
-         output_shape = emalloc(sizeof(int) * output_ndim);
+/**
+ * View of the row `index` along the first axis.
+ *
+ * The view points into the parent's shape and strides instead of
+ * allocating its own, the reference it holds on the parent keeps
+ * them alive. Rows of copy-on-write arrays reference the buffer's
+ * holder instead of the parent, so they get their own copies.
+ *
+ * @param array
+ * @param index
+ * @return
+ */
+NDArray*
+NDArrayIterator_ROW(NDArray* array, int index) {
+    NDArray *rtn = emalloc(sizeof(NDArray));
+    rtn->descriptor = emalloc(sizeof(NDArrayDescriptor));
+    rtn->descriptor->type = NDArray_TYPE(array);
+    rtn->descriptor->elsize = NDArray_ELSIZE(array);
+    rtn->descriptor->numElements = NDArray_NUMELEMENTS(array) / NDArray_SHAPE(array)[0];
+    rtn->ndim = NDArray_NDIM(array) - 1;
+    rtn->refcount = 1;
+    rtn->device = NDArray_DEVICE(array);
+    rtn->data = NDArray_DATA(array) + ((long)index * NDArray_STRIDES(array)[0]);
+    NDArray_SetViewBase(rtn, array);
+    if (NDArray_CHKFLAGS(rtn, NDARRAY_ARRAY_COPY_ON_WRITE)) {
+        rtn->dimensions = emalloc(sizeof(int) * rtn->ndim);
+        rtn->strides = emalloc(sizeof(int) * rtn->ndim);
+        memcpy(rtn->dimensions, NDArray_SHAPE(array) + 1, sizeof(int) * rtn->ndim);
+        memcpy(rtn->strides, NDArray_STRIDES(array) + 1, sizeof(int) * rtn->ndim);
     } else {
-        output_shape = emalloc(sizeof(int));
+        rtn->dimensions = NDArray_SHAPE(array) + 1;
+        rtn->strides = NDArray_STRIDES(array) + 1;
+        NDArray_ENABLEFLAGS(rtn, NDARRAY_ARRAY_BORROWED_SHAPE);
     }
-    memcpy(output_shape, NDArray_SHAPE(array) + 1, sizeof(int) * output_ndim);
-    NDArray* rtn = Create_NDArray(output_shape, output_ndim, NDArray_TYPE(array), NDArray_DEVICE(array));
-    rtn->device = NDArray_DEVICE(array);
-    rtn->data = array->data + (array->iterator->current_index * NDArray_STRIDES(array)[0]);
-    rtn->base = array;
+    NDArray_ENABLEFLAGS(rtn, array->flags & NDARRAY_ARRAY_F_CONTIGUOUS);
+    NDArrayIterator_INIT(rtn);
     return rtn;
 }
 
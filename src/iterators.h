@@ -20,6 +20,7 @@ typedef struct NDArrayIter {
 } NDArrayIter;
 
 NDArray* NDArrayIterator_GET(NDArray* array);
+NDArray* NDArrayIterator_ROW(NDArray* array, int index);
 void NDArrayIterator_INIT(NDArray* array);
 void NDArrayIterator_REWIND(NDArray* array);
 int NDArrayIterator_ISDONE(NDArray* array);
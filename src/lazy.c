@@ -0,0 +1,538 @@
+#include <Zend/zend.h>
+#include <math.h>
+#include <string.h>
+#include "lazy.h"
+#include "ndarray.h"
+#include "initializers.h"
+#include "types.h"
+#include "../config.h"
+
+/* Elements of every operand converted and processed at a time */
+#define NDARRAY_EXPR_TILE 256
+
+#define NDARRAY_EXPR_MODE_FLOAT  0
+#define NDARRAY_EXPR_MODE_DOUBLE 1
+
+/* Plans kept by NDArrayExpr_Evaluate, dropped at the end of the request */
+#define NDARRAY_EXPR_CACHE_SIZE 32
+
+/* Returned by ndarray_expr_flatten when the expression is too large */
+#define NDARRAY_EXPR_OVERFLOW (-NDARRAY_EXPR_MAX_NODES - 1)
+
+typedef struct NDArrayExprInstr {
+    unsigned char op;
+    unsigned char dst;
+    unsigned char a;
+    unsigned char b;
+} NDArrayExprInstr;
+
+/**
+ * Compiled fused kernel: a register program over tile buffers. Leaves
+ * are loaded into registers 0..n_leaves-1 at the start of every tile.
+ */
+typedef struct NDArrayExprPlan {
+    char key[3 + NDARRAY_EXPR_MAX_NODES * 3];
+    int key_len;
+    int n_leaves;
+    int n_instr;
+    int n_regs;
+    int result;
+    NDArrayExprInstr instr[NDARRAY_EXPR_MAX_NODES];
+} NDArrayExprPlan;
+
+static NDArrayExprPlan *expr_plan_cache[NDARRAY_EXPR_CACHE_SIZE];
+static int expr_plan_cache_next = 0;
+
+/**
+ * Flattened view of an expression: distinct leaves plus the instructions
+ * in post-order, with one virtual register per distinct node.
+ */
+typedef struct NDArrayExprFlat {
+    NDArrayExpr *nodes[NDARRAY_EXPR_MAX_NODES];
+    int vregs[NDARRAY_EXPR_MAX_NODES];
+    int n_nodes;
+    NDArray *leaves[NDARRAY_EXPR_MAX_NODES];
+    int n_leaves;
+    NDArrayExprInstr instr[NDARRAY_EXPR_MAX_NODES];
+    int n_instr;
+} NDArrayExprFlat;
+
+/**
+ * Create a leaf node holding a reference to `a`
+ *
+ * @param a
+ * @return
+ */
+NDArrayExpr*
+NDArrayExpr_Leaf(NDArray *a) {
+    NDArrayExpr *expr = emalloc(sizeof(NDArrayExpr));
+    expr->op = NDARRAY_EXPR_LEAF;
+    expr->refcount = 1;
+    expr->leaf = a;
+    expr->left = NULL;
+    expr->right = NULL;
+    NDArray_ADDREF(a);
+    return expr;
+}
+
+/**
+ * Create a binary node holding a reference to both children
+ *
+ * @param op NDARRAY_EXPR_*
+ * @param left
+ * @param right
+ * @return
+ */
+NDArrayExpr*
+NDArrayExpr_Binary(int op, NDArrayExpr *left, NDArrayExpr *right) {
+    NDArrayExpr *expr = emalloc(sizeof(NDArrayExpr));
+    expr->op = op;
+    expr->refcount = 1;
+    expr->leaf = NULL;
+    expr->left = left;
+    expr->right = right;
+    left->refcount++;
+    right->refcount++;
+    return expr;
+}
+
+/**
+ * Release a reference to `expr`, freeing the node and its children
+ * once unreferenced
+ *
+ * @param expr
+ */
+void
+NDArrayExpr_FREE(NDArrayExpr *expr) {
+    if (expr == NULL || --expr->refcount > 0) {
+        return;
+    }
+    if (expr->op == NDARRAY_EXPR_LEAF) {
+        NDArray_FREE(expr->leaf);
+    } else {
+        NDArrayExpr_FREE(expr->left);
+        NDArrayExpr_FREE(expr->right);
+    }
+    efree(expr);
+}
+
+/**
+ * Assign virtual registers in post-order. Shared nodes and repeated
+ * arrays are visited once, so a DAG compiles without duplicated work.
+ *
+ * @return reference to `expr`, negative for leaves, NDARRAY_EXPR_OVERFLOW
+ *         if the expression is too large
+ */
+static int
+ndarray_expr_flatten(NDArrayExpr *expr, NDArrayExprFlat *flat) {
+    int i, a, b;
+
+    for (i = 0; i < flat->n_nodes; i++) {
+        if (flat->nodes[i] == expr) {
+            return flat->vregs[i];
+        }
+    }
+    if (flat->n_nodes >= NDARRAY_EXPR_MAX_NODES) {
+        return NDARRAY_EXPR_OVERFLOW;
+    }
+    if (expr->op == NDARRAY_EXPR_LEAF) {
+        for (i = 0; i < flat->n_leaves; i++) {
+            if (flat->leaves[i] == expr->leaf) {
+                break;
+            }
+        }
+        if (i == flat->n_leaves) {
+            flat->leaves[flat->n_leaves++] = expr->leaf;
+        }
+        // Leaves are numbered after the instructions are known, keep them negative for now
+        flat->nodes[flat->n_nodes] = expr;
+        flat->vregs[flat->n_nodes++] = -(i + 1);
+        return -(i + 1);
+    }
+    a = ndarray_expr_flatten(expr->left, flat);
+    if (a == NDARRAY_EXPR_OVERFLOW) {
+        return a;
+    }
+    b = ndarray_expr_flatten(expr->right, flat);
+    if (b == NDARRAY_EXPR_OVERFLOW || flat->n_nodes >= NDARRAY_EXPR_MAX_NODES) {
+        return NDARRAY_EXPR_OVERFLOW;
+    }
+    flat->instr[flat->n_instr].op = (unsigned char) expr->op;
+    flat->instr[flat->n_instr].a = (unsigned char) a;
+    flat->instr[flat->n_instr].b = (unsigned char) b;
+    flat->nodes[flat->n_nodes] = expr;
+    flat->vregs[flat->n_nodes++] = flat->n_instr;
+    return flat->n_instr++;
+}
+
+/**
+ * Encode a virtual register: leaves first, then one per instruction
+ */
+static int
+ndarray_expr_vreg(int ref, int n_leaves) {
+    return ref < 0 ? -ref - 1 : n_leaves + ref;
+}
+
+/**
+ * Build the cache key of a flattened expression. Two expressions with
+ * the same operators, the same wiring and the same compute mode share
+ * a plan regardless of the arrays bound to their leaves.
+ */
+static int
+ndarray_expr_key(const NDArrayExprFlat *flat, int mode, char *key) {
+    int i, len = 0;
+    key[len++] = (char) mode;
+    key[len++] = (char) flat->n_leaves;
+    key[len++] = (char) flat->n_instr;
+    for (i = 0; i < flat->n_instr; i++) {
+        key[len++] = (char) flat->instr[i].op;
+        key[len++] = (char) ndarray_expr_vreg((signed char) flat->instr[i].a, flat->n_leaves);
+        key[len++] = (char) ndarray_expr_vreg((signed char) flat->instr[i].b, flat->n_leaves);
+    }
+    return len;
+}
+
+/**
+ * Compile a flattened expression into a plan, reusing tile registers
+ * once their value is dead
+ */
+static NDArrayExprPlan*
+ndarray_expr_compile(const NDArrayExprFlat *flat, int root, const char *key, int key_len) {
+    int last_use[2 * NDARRAY_EXPR_MAX_NODES];
+    int phys[2 * NDARRAY_EXPR_MAX_NODES];
+    int free_regs[2 * NDARRAY_EXPR_MAX_NODES];
+    int n_free = 0, n_regs, i, v, a, b, n_vregs;
+    NDArrayExprPlan *plan = emalloc(sizeof(NDArrayExprPlan));
+
+    memcpy(plan->key, key, key_len);
+    plan->key_len = key_len;
+    plan->n_leaves = flat->n_leaves;
+    plan->n_instr = flat->n_instr;
+    n_vregs = flat->n_leaves + flat->n_instr;
+
+    for (v = 0; v < n_vregs; v++) {
+        last_use[v] = -1;
+    }
+    for (i = 0; i < flat->n_instr; i++) {
+        last_use[ndarray_expr_vreg((signed char) flat->instr[i].a, flat->n_leaves)] = i;
+        last_use[ndarray_expr_vreg((signed char) flat->instr[i].b, flat->n_leaves)] = i;
+    }
+    last_use[ndarray_expr_vreg(root, flat->n_leaves)] = flat->n_instr;
+
+    for (v = 0; v < flat->n_leaves; v++) {
+        phys[v] = v;
+    }
+    n_regs = flat->n_leaves;
+    for (i = 0; i < flat->n_instr; i++) {
+        a = ndarray_expr_vreg((signed char) flat->instr[i].a, flat->n_leaves);
+        b = ndarray_expr_vreg((signed char) flat->instr[i].b, flat->n_leaves);
+        if (last_use[a] == i) {
+            free_regs[n_free++] = phys[a];
+        }
+        if (last_use[b] == i && b != a) {
+            free_regs[n_free++] = phys[b];
+        }
+        v = flat->n_leaves + i;
+        phys[v] = n_free > 0 ? free_regs[--n_free] : n_regs++;
+        plan->instr[i].op = flat->instr[i].op;
+        plan->instr[i].a = (unsigned char) phys[a];
+        plan->instr[i].b = (unsigned char) phys[b];
+        plan->instr[i].dst = (unsigned char) phys[v];
+    }
+    plan->n_regs = n_regs;
+    plan->result = phys[ndarray_expr_vreg(root, flat->n_leaves)];
+    return plan;
+}
+
+/**
+ * Look up the plan of `flat`, compiling and caching it on a miss
+ */
+static NDArrayExprPlan*
+ndarray_expr_plan(const NDArrayExprFlat *flat, int root, int mode) {
+    char key[3 + NDARRAY_EXPR_MAX_NODES * 3];
+    int key_len = ndarray_expr_key(flat, mode, key), i;
+    NDArrayExprPlan *plan;
+
+    for (i = 0; i < NDARRAY_EXPR_CACHE_SIZE; i++) {
+        plan = expr_plan_cache[i];
+        // The root is always the last instruction, so the key identifies the whole plan
+        if (plan != NULL && plan->key_len == key_len && !memcmp(plan->key, key, key_len)) {
+            return plan;
+        }
+    }
+    plan = ndarray_expr_compile(flat, root, key, key_len);
+    if (expr_plan_cache[expr_plan_cache_next] != NULL) {
+        efree(expr_plan_cache[expr_plan_cache_next]);
+    }
+    expr_plan_cache[expr_plan_cache_next] = plan;
+    expr_plan_cache_next = (expr_plan_cache_next + 1) % NDARRAY_EXPR_CACHE_SIZE;
+    return plan;
+}
+
+/**
+ * Drop every cached plan
+ */
+void
+NDArrayExpr_ClearCache(void) {
+    int i;
+    for (i = 0; i < NDARRAY_EXPR_CACHE_SIZE; i++) {
+        if (expr_plan_cache[i] != NULL) {
+            efree(expr_plan_cache[i]);
+            expr_plan_cache[i] = NULL;
+        }
+    }
+    expr_plan_cache_next = 0;
+}
+
+/**
+ * @return number of cached plans
+ */
+int
+NDArrayExpr_CacheSize(void) {
+    int i, count = 0;
+    for (i = 0; i < NDARRAY_EXPR_CACHE_SIZE; i++) {
+        count += expr_plan_cache[i] != NULL;
+    }
+    return count;
+}
+
+#define NDARRAY_EXPR_RUN(name, ctype, powfn)                                            \
+static void                                                                             \
+name(const NDArrayExprPlan *plan, ctype *regs, long len) {                              \
+    int s;                                                                              \
+    long j;                                                                             \
+    for (s = 0; s < plan->n_instr; s++) {                                               \
+        const NDArrayExprInstr *in = &plan->instr[s];                                   \
+        ctype *d = regs + in->dst * NDARRAY_EXPR_TILE;                                  \
+        const ctype *x = regs + in->a * NDARRAY_EXPR_TILE;                              \
+        const ctype *y = regs + in->b * NDARRAY_EXPR_TILE;                              \
+        switch (in->op) {                                                               \
+            case NDARRAY_EXPR_ADD:                                                      \
+                for (j = 0; j < len; j++) d[j] = x[j] + y[j];                           \
+                break;                                                                  \
+            case NDARRAY_EXPR_SUBTRACT:                                                 \
+                for (j = 0; j < len; j++) d[j] = x[j] - y[j];                           \
+                break;                                                                  \
+            case NDARRAY_EXPR_MULTIPLY:                                                 \
+                for (j = 0; j < len; j++) d[j] = x[j] * y[j];                           \
+                break;                                                                  \
+            case NDARRAY_EXPR_DIVIDE:                                                   \
+                for (j = 0; j < len; j++) d[j] = x[j] / y[j];                           \
+                break;                                                                  \
+            case NDARRAY_EXPR_POW:                                                      \
+                for (j = 0; j < len; j++) d[j] = powfn(x[j], y[j]);                     \
+                break;                                                                  \
+        }                                                                               \
+    }                                                                                   \
+}
+
+NDARRAY_EXPR_RUN(ndarray_expr_run_float, float, powf)
+NDARRAY_EXPR_RUN(ndarray_expr_run_double, double, pow)
+
+/**
+ * Load `len` elements of a leaf into a float64 register
+ */
+static void
+ndarray_expr_load_double(NDArray *leaf, const char *ptr, long stride, double *dst, long len) {
+    const NDArrayTypeFuncs *funcs = NDArray_TypeFuncs(NDArray_TYPE(leaf));
+    long j;
+    if (stride == sizeof(double) && is_type(NDArray_TYPE(leaf), NDARRAY_TYPE_DOUBLE64)) {
+        memcpy(dst, ptr, len * sizeof(double));
+        return;
+    }
+    for (j = 0; j < len; j++) {
+        dst[j] = funcs->getitem(ptr + j * stride);
+    }
+}
+
+/**
+ * Result dtype of an expression. 0-d leaves come from PHP scalars in
+ * most expressions, so like the eager operators they adopt the dtype of
+ * the arrays. Integer results are computed and returned as float64.
+ */
+static const char*
+ndarray_expr_result_type(const NDArrayExprFlat *flat) {
+    const char *type = NULL;
+    int i, all_scalars = 1;
+
+    for (i = 0; i < flat->n_leaves; i++) {
+        if (NDArray_NDIM(flat->leaves[i]) > 0) {
+            all_scalars = 0;
+        }
+    }
+    for (i = 0; i < flat->n_leaves; i++) {
+        if (!all_scalars && NDArray_NDIM(flat->leaves[i]) == 0) {
+            continue;
+        }
+        type = type == NULL ? NDArray_TYPE(flat->leaves[i]) :
+               NDArray_PromoteTypes(type, NDArray_TYPE(flat->leaves[i]));
+    }
+    if (NDArray_TypeFuncs(type)->kind != NDARRAY_KIND_FLOAT) {
+        return NDARRAY_TYPE_DOUBLE64;
+    }
+    return type;
+}
+
+/**
+ * Evaluate an expression with a single fused loop. Every tile of the
+ * output reads each distinct array once and is written once, no matter
+ * how many operators the expression has.
+ *
+ * @param expr
+ * @return
+ */
+NDArray*
+NDArrayExpr_Evaluate(NDArrayExpr *expr) {
+    NDArrayExprFlat *flat;
+    NDArrayExprPlan *plan;
+    NDArray *rtn;
+    const char *type;
+    const NDArrayTypeFuncs *out_funcs;
+    int shape[NDARRAY_MAX_DIMS], index[NDARRAY_MAX_DIMS];
+    long (*strides)[NDARRAY_MAX_DIMS];
+    char **ptrs;
+    void *regs;
+    int ndim = 0, root, mode, d, l, k;
+    long outer, inner, o, t, len, total;
+    char *out;
+
+    if (expr->op == NDARRAY_EXPR_LEAF) {
+        NDArray_ADDREF(expr->leaf);
+        return expr->leaf;
+    }
+    flat = ecalloc(1, sizeof(NDArrayExprFlat));
+    root = ndarray_expr_flatten(expr, flat);
+    if (root == NDARRAY_EXPR_OVERFLOW) {
+        efree(flat);
+        zend_throw_error(NULL, "Expression exceeds %d fused nodes, evaluate part of it first.", NDARRAY_EXPR_MAX_NODES);
+        return NULL;
+    }
+
+    // Broadcast every leaf against the output shape
+    for (l = 0; l < flat->n_leaves; l++) {
+        if (NDArray_DEVICE(flat->leaves[l]) == NDARRAY_DEVICE_GPU) {
+            efree(flat);
+            zend_throw_error(NULL, "Lazy expressions are only available for NDArrays on CPU RAM.");
+            return NULL;
+        }
+        if (NDArray_NDIM(flat->leaves[l]) > ndim) {
+            ndim = NDArray_NDIM(flat->leaves[l]);
+        }
+    }
+    for (d = 0; d < ndim; d++) {
+        shape[d] = 1;
+    }
+    strides = emalloc(sizeof(*strides) * flat->n_leaves);
+    for (l = 0; l < flat->n_leaves; l++) {
+        NDArray *leaf = flat->leaves[l];
+        int offset = ndim - NDArray_NDIM(leaf);
+        for (d = 0; d < ndim; d++) {
+            int dim = d >= offset ? NDArray_SHAPE(leaf)[d - offset] : 1;
+            if (dim != 1) {
+                if (shape[d] != 1 && shape[d] != dim) {
+                    efree(strides);
+                    efree(flat);
+                    zend_throw_error(NULL, "Broadcast shape mismatch.");
+                    return NULL;
+                }
+                shape[d] = dim;
+            }
+        }
+    }
+    for (l = 0; l < flat->n_leaves; l++) {
+        NDArray *leaf = flat->leaves[l];
+        int offset = ndim - NDArray_NDIM(leaf);
+        for (d = 0; d < ndim; d++) {
+            strides[l][d] = (d >= offset && NDArray_SHAPE(leaf)[d - offset] != 1) ?
+                            NDArray_STRIDES(leaf)[d - offset] : 0;
+        }
+    }
+
+    type = ndarray_expr_result_type(flat);
+    out_funcs = NDArray_TypeFuncs(type);
+    mode = is_type(type, NDARRAY_TYPE_DOUBLE64) ? NDARRAY_EXPR_MODE_DOUBLE : NDARRAY_EXPR_MODE_FLOAT;
+    plan = ndarray_expr_plan(flat, root, mode);
+
+    int *rtn_shape = emalloc(sizeof(int) * (ndim > 0 ? ndim : 1));
+    memcpy(rtn_shape, shape, sizeof(int) * ndim);
+    rtn = NDArray_Empty(rtn_shape, ndim, type, NDARRAY_DEVICE_CPU);
+    out = NDArray_DATA(rtn);
+    total = NDArray_NUMELEMENTS(rtn);
+
+    // Merge dimensions that every leaf walks contiguously, so the inner loop is as long as possible
+    for (d = ndim - 1; d > 0; d--) {
+        int mergeable = 1;
+        for (l = 0; l < flat->n_leaves; l++) {
+            if (strides[l][d - 1] != strides[l][d] * shape[d]) {
+                mergeable = 0;
+                break;
+            }
+        }
+        if (mergeable) {
+            for (l = 0; l < flat->n_leaves; l++) {
+                strides[l][d - 1] = strides[l][d];
+            }
+            shape[d - 1] *= shape[d];
+            for (k = d; k < ndim - 1; k++) {
+                shape[k] = shape[k + 1];
+                for (l = 0; l < flat->n_leaves; l++) {
+                    strides[l][k] = strides[l][k + 1];
+                }
+            }
+            ndim--;
+        }
+    }
+
+    inner = ndim > 0 ? shape[ndim - 1] : 1;
+    outer = inner > 0 ? total / inner : 0;
+    ptrs = emalloc(sizeof(char *) * flat->n_leaves);
+    regs = emalloc((mode == NDARRAY_EXPR_MODE_DOUBLE ? sizeof(double) : sizeof(float)) *
+                   NDARRAY_EXPR_TILE * (plan->n_regs > 0 ? plan->n_regs : 1));
+    for (d = 0; d < ndim; d++) {
+        index[d] = 0;
+    }
+
+    for (o = 0; o < outer; o++) {
+        for (l = 0; l < flat->n_leaves; l++) {
+            ptrs[l] = NDArray_DATA(flat->leaves[l]);
+            for (d = 0; d < ndim - 1; d++) {
+                ptrs[l] += index[d] * strides[l][d];
+            }
+        }
+        for (t = 0; t < inner; t += len) {
+            len = inner - t < NDARRAY_EXPR_TILE ? inner - t : NDARRAY_EXPR_TILE;
+            if (mode == NDARRAY_EXPR_MODE_DOUBLE) {
+                double *dregs = (double *) regs;
+                for (l = 0; l < flat->n_leaves; l++) {
+                    long stride = ndim > 0 ? strides[l][ndim - 1] : 0;
+                    ndarray_expr_load_double(flat->leaves[l], ptrs[l] + t * stride, stride,
+                                             dregs + l * NDARRAY_EXPR_TILE, len);
+                }
+                ndarray_expr_run_double(plan, dregs, len);
+                memcpy(out, dregs + plan->result * NDARRAY_EXPR_TILE, len * sizeof(double));
+            } else {
+                float *fregs = (float *) regs;
+                for (l = 0; l < flat->n_leaves; l++) {
+                    long stride = ndim > 0 ? strides[l][ndim - 1] : 0;
+                    NDArray_TypeFuncs(NDArray_TYPE(flat->leaves[l]))->to_float32(
+                            ptrs[l] + t * stride, stride, fregs + l * NDARRAY_EXPR_TILE, len);
+                }
+                ndarray_expr_run_float(plan, fregs, len);
+                out_funcs->from_float32(fregs + plan->result * NDARRAY_EXPR_TILE, out, out_funcs->elsize, len);
+            }
+            out += len * out_funcs->elsize;
+        }
+        for (d = ndim - 2; d >= 0; d--) {
+            if (++index[d] < shape[d]) {
+                break;
+            }
+            index[d] = 0;
+        }
+    }
+
+    efree(regs);
+    efree(ptrs);
+    efree(strides);
+    efree(flat);
+    return rtn;
+}
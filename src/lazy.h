@@ -0,0 +1,35 @@
+#ifndef NUMPOWER_LAZY_H
+#define NUMPOWER_LAZY_H
+
+#include "ndarray.h"
+
+#define NDARRAY_EXPR_LEAF     0
+#define NDARRAY_EXPR_ADD      1
+#define NDARRAY_EXPR_SUBTRACT 2
+#define NDARRAY_EXPR_MULTIPLY 3
+#define NDARRAY_EXPR_DIVIDE   4
+#define NDARRAY_EXPR_POW      5
+
+/* Largest number of distinct nodes fused into one kernel */
+#define NDARRAY_EXPR_MAX_NODES 64
+
+/**
+ * Node of a lazy element-wise expression DAG. Nodes are reference
+ * counted and can be shared by several parent expressions.
+ */
+typedef struct NDArrayExpr {
+    int op;
+    int refcount;
+    NDArray *leaf;
+    struct NDArrayExpr *left;
+    struct NDArrayExpr *right;
+} NDArrayExpr;
+
+NDArrayExpr* NDArrayExpr_Leaf(NDArray *a);
+NDArrayExpr* NDArrayExpr_Binary(int op, NDArrayExpr *left, NDArrayExpr *right);
+void NDArrayExpr_FREE(NDArrayExpr *expr);
+NDArray* NDArrayExpr_Evaluate(NDArrayExpr *expr);
+void NDArrayExpr_ClearCache(void);
+int NDArrayExpr_CacheSize(void);
+
+#endif //NUMPOWER_LAZY_H
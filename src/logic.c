@@ -3,6 +3,7 @@
 #include "../config.h"
 #include "initializers.h"
 #include "manipulation.h"
+#include "types.h"
 #include <Zend/zend.h>
 #include <php.h>
 
@@ -26,6 +27,9 @@ float
 NDArray_All(NDArray *a) {
     int i;
     float *array = NDArray_FDATA(a);
+    if (!is_type(NDArray_TYPE(a), NDARRAY_TYPE_FLOAT32)) {
+        return NDArray_CountNonzero(a) == NDArray_NUMELEMENTS(a);
+    }
 #ifdef HAVE_AVX2
     __m256 zero = _mm256_set1_ps(0.0f);
     for (i = 0; i < NDArray_NUMELEMENTS(a) - 7; i += 8) {
@@ -57,6 +61,103 @@ NDArray_All(NDArray *a) {
 #endif
 }
 
+/**
+ * Element-wise comparison on CPU through the dtype kernel table
+ *
+ * Operands are promoted to a common dtype and broadcast with zero
+ * strides. The result is a bool mask with one byte per element.
+ *
+ * @param nda
+ * @param ndb
+ * @param op NDARRAY_CMP_*
+ * @return
+ */
+NDArray*
+NDArray_Compare(NDArray* nda, NDArray* ndb, int op) {
+    const char *type = NDArray_PromoteTypes(NDArray_TYPE(nda), NDArray_TYPE(ndb));
+    const NDArrayTypeFuncs *funcs = NDArray_TypeFuncs(type);
+    NDArray_BinaryLoop loop = NULL;
+    NDArray *a_cast = nda, *b_cast = ndb, *rtn = NULL;
+    long a_strides[NDARRAY_MAX_DIMS], b_strides[NDARRAY_MAX_DIMS];
+    int ndim, *shape;
+
+    switch (op) {
+        case NDARRAY_CMP_GREATER:
+            loop = funcs->greater;
+            break;
+        case NDARRAY_CMP_GREATER_EQUAL:
+            loop = funcs->greater_equal;
+            break;
+        case NDARRAY_CMP_LESS:
+            loop = funcs->less;
+            break;
+        case NDARRAY_CMP_LESS_EQUAL:
+            loop = funcs->less_equal;
+            break;
+        case NDARRAY_CMP_EQUAL:
+            loop = funcs->equal;
+            break;
+        case NDARRAY_CMP_NOT_EQUAL:
+            loop = funcs->not_equal;
+            break;
+    }
+    if (loop == NULL) {
+        zend_throw_error(NULL, "Invalid comparison.");
+        return NULL;
+    }
+
+    if (!is_type(NDArray_TYPE(nda), type)) {
+        a_cast = NDArray_AsType(nda, type);
+    }
+    if (!is_type(NDArray_TYPE(ndb), type)) {
+        b_cast = NDArray_AsType(ndb, type);
+    }
+    ndim = NDArray_NDIM(nda) > NDArray_NDIM(ndb) ? NDArray_NDIM(nda) : NDArray_NDIM(ndb);
+    shape = emalloc(sizeof(int) * (ndim > 0 ? ndim : 1));
+    ndim = NDArray_BroadcastStrides(a_cast, b_cast, shape, a_strides, b_strides);
+    if (ndim < 0) {
+        efree(shape);
+        zend_throw_error(NULL, "Can't broadcast arrays.");
+    } else {
+        rtn = NDArray_Empty(shape, ndim, NDARRAY_TYPE_BOOL, NDARRAY_DEVICE_CPU);
+        NDArray_BroadcastLoop(NDArray_DATA(a_cast), a_strides, NDArray_DATA(b_cast), b_strides,
+                              NDArray_DATA(rtn), 1, shape, ndim, loop);
+    }
+
+    if (a_cast != nda) {
+        NDArray_FREE(a_cast);
+    }
+    if (b_cast != ndb) {
+        NDArray_FREE(b_cast);
+    }
+    return rtn;
+}
+
+/**
+ * Number of non-zero (true) elements
+ *
+ * @param a
+ * @return
+ */
+long
+NDArray_CountNonzero(NDArray *a) {
+    NDArray *contiguous = a;
+    long count;
+
+    if (NDArray_DEVICE(a) == NDARRAY_DEVICE_GPU) {
+        zend_throw_error(NULL, "NDArray must be on CPU RAM.");
+        return -1;
+    }
+    if (!NDArray_IsContiguous(a)) {
+        contiguous = NDArray_ToContiguous(a);
+    }
+    count = NDArray_TypeFuncs(NDArray_TYPE(a))->count_nonzero(NDArray_DATA(contiguous), NDArray_NUMELEMENTS(a));
+    if (contiguous != a) {
+        NDArray_FREE(contiguous);
+    }
+    return count;
+}
+
 /**
  * Return if NDArray is equal element-wise
  *
@@ -66,6 +167,9 @@ NDArray_All(NDArray *a) {
  */
 NDArray*
 NDArray_Greater(NDArray* nda, NDArray* ndb) {
+    if (NDArray_DEVICE(nda) == NDARRAY_DEVICE_CPU && NDArray_DEVICE(ndb) == NDARRAY_DEVICE_CPU) {
+        return NDArray_Compare(nda, ndb, NDARRAY_CMP_GREATER);
+    }
     NDArray *a_temp = NULL, *b_temp = NULL;
     if ((NDArray_DEVICE(nda) != NDArray_DEVICE(ndb)) && NDArray_NDIM(nda) != 0 && NDArray_NDIM(ndb) != 0) {
         zend_throw_error(NULL, "Devices mismatch in `equal` function");
@@ -170,6 +274,9 @@ NDArray_Greater(NDArray* nda, NDArray* ndb) {
  */
 NDArray*
 NDArray_Less(NDArray* nda, NDArray* ndb) {
+    if (NDArray_DEVICE(nda) == NDARRAY_DEVICE_CPU && NDArray_DEVICE(ndb) == NDARRAY_DEVICE_CPU) {
+        return NDArray_Compare(nda, ndb, NDARRAY_CMP_LESS);
+    }
     NDArray *a_temp = NULL, *b_temp = NULL;
     if ((NDArray_DEVICE(nda) != NDArray_DEVICE(ndb)) && NDArray_NDIM(nda) != 0 && NDArray_NDIM(ndb) != 0) {
         zend_throw_error(NULL, "Devices mismatch in `equal` function");
@@ -270,6 +377,9 @@ NDArray_Less(NDArray* nda, NDArray* ndb) {
  */
 NDArray*
 NDArray_LessEqual(NDArray* nda, NDArray* ndb) {
+    if (NDArray_DEVICE(nda) == NDARRAY_DEVICE_CPU && NDArray_DEVICE(ndb) == NDARRAY_DEVICE_CPU) {
+        return NDArray_Compare(nda, ndb, NDARRAY_CMP_LESS_EQUAL);
+    }
     NDArray *a_temp = NULL, *b_temp = NULL;
     if ((NDArray_DEVICE(nda) != NDArray_DEVICE(ndb)) && NDArray_NDIM(nda) != 0 && NDArray_NDIM(ndb) != 0) {
         zend_throw_error(NULL, "Devices mismatch in `equal` function");
@@ -376,6 +486,9 @@ NDArray_LessEqual(NDArray* nda, NDArray* ndb) {
  */
 NDArray*
 NDArray_GreaterEqual(NDArray* nda, NDArray* ndb) {
+    if (NDArray_DEVICE(nda) == NDARRAY_DEVICE_CPU && NDArray_DEVICE(ndb) == NDARRAY_DEVICE_CPU) {
+        return NDArray_Compare(nda, ndb, NDARRAY_CMP_GREATER_EQUAL);
+    }
     NDArray *a_temp = NULL, *b_temp = NULL;
     if ((NDArray_DEVICE(nda) != NDArray_DEVICE(ndb)) && NDArray_NDIM(nda) != 0 && NDArray_NDIM(ndb) != 0) {
         zend_throw_error(NULL, "Devices mismatch in `equal` function");
@@ -477,6 +590,9 @@ NDArray_GreaterEqual(NDArray* nda, NDArray* ndb) {
  */
 NDArray*
 NDArray_Equal(NDArray* nda, NDArray* ndb) {
+    if (NDArray_DEVICE(nda) == NDARRAY_DEVICE_CPU && NDArray_DEVICE(ndb) == NDARRAY_DEVICE_CPU) {
+        return NDArray_Compare(nda, ndb, NDARRAY_CMP_EQUAL);
+    }
     NDArray *a_temp = NULL, *b_temp = NULL;
     if ((NDArray_DEVICE(nda) != NDArray_DEVICE(ndb)) && NDArray_NDIM(nda) != 0 && NDArray_NDIM(ndb) != 0) {
         zend_throw_error(NULL, "Devices mismatch in `equal` function");
@@ -578,6 +694,9 @@ NDArray_Equal(NDArray* nda, NDArray* ndb) {
  */
 NDArray*
 NDArray_NotEqual(NDArray* nda, NDArray* ndb) {
+    if (NDArray_DEVICE(nda) == NDARRAY_DEVICE_CPU && NDArray_DEVICE(ndb) == NDARRAY_DEVICE_CPU) {
+        return NDArray_Compare(nda, ndb, NDARRAY_CMP_NOT_EQUAL);
+    }
     NDArray *a_temp = NULL, *b_temp = NULL;
     if ((NDArray_DEVICE(nda) != NDArray_DEVICE(ndb)) && NDArray_NDIM(nda) != 0 && NDArray_NDIM(ndb) != 0) {
         zend_throw_error(NULL, "Devices mismatch in `equal` function");
@@ -3,6 +3,13 @@
 
 #include "ndarray.h"
 
+#define NDARRAY_CMP_GREATER       0
+#define NDARRAY_CMP_GREATER_EQUAL 1
+#define NDARRAY_CMP_LESS          2
+#define NDARRAY_CMP_LESS_EQUAL    3
+#define NDARRAY_CMP_EQUAL         4
+#define NDARRAY_CMP_NOT_EQUAL     5
+
 float NDArray_All(NDArray *a);
 int NDArray_ArrayEqual(NDArray *a, NDArray *b);
 NDArray* NDArray_Equal(NDArray* nda, NDArray* ndb);
@@ -12,4 +19,6 @@ NDArray* NDArray_GreaterEqual(NDArray* nda, NDArray* ndb);
 NDArray* NDArray_LessEqual(NDArray* nda, NDArray* ndb);
 NDArray* NDArray_Less(NDArray* nda, NDArray* ndb);
 NDArray* NDArray_NotEqual(NDArray* nda, NDArray* ndb);
+NDArray* NDArray_Compare(NDArray* nda, NDArray* ndb, int op);
+long NDArray_CountNonzero(NDArray *a);
 #endif //PHPSCI_NDARRAY_LOGIC_H
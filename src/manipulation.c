@@ -127,6 +127,29 @@ NDArray_Transpose(NDArray *a, NDArray_Dims *permute) {
     }
 }
 
+/**
+ * Copy-on-write view of the elements of target in C order, copying
+ * them first when target isn't contiguous
+ *
+ * @param target
+ * @param shape
+ * @param strides
+ * @param ndim
+ * @return
+ */
+static NDArray*
+ndarray_contiguous_view(NDArray *target, int *shape, int *strides, int ndim) {
+    NDArray *contiguous, *rtn;
+
+    if (NDArray_IsContiguous(target)) {
+        return NDArray_CopyOnWriteView(target, NDArray_DATA(target), shape, strides, ndim);
+    }
+    contiguous = NDArray_ToContiguous(target);
+    rtn = NDArray_CopyOnWriteView(contiguous, NDArray_DATA(contiguous), shape, strides, ndim);
+    NDArray_FREE(contiguous);
+    return rtn;
+}
+
 /**
  * Reshape NDArray
  *
@@ -151,14 +174,11 @@ NDArray_Reshape(NDArray *target, int *new_shape, int ndim) {
         zend_throw_error(NULL, "incompatible shape in reshape call.");
         return NULL;
     }
-    NDArray *rtn = NDArray_Empty(new_shape, ndim, NDARRAY_TYPE_FLOAT32, NDArray_DEVICE(target));
-    rtn->ndim = ndim;
-    rtn->device = NDArray_DEVICE(target);
-    NDArray_FREEDATA(rtn);
-    rtn->data = target->data;
-    rtn->base = target;
-    NDArray_ADDREF(target);
-    return rtn;
+    int *strides = Generate_Strides(new_shape, ndim, NDArray_ELSIZE(target));
+    if (NDArray_DEVICE(target) != NDARRAY_DEVICE_CPU) {
+        return NDArray_FromNDArrayBase(target, NDArray_DATA(target), new_shape, strides, ndim);
+    }
+    return ndarray_contiguous_view(target, new_shape, strides, ndim);
 }
 
 /**
@@ -167,6 +187,13 @@ NDArray_Reshape(NDArray *target, int *new_shape, int ndim) {
  */
 NDArray*
 NDArray_Flatten(NDArray *target) {
+    if (NDArray_DEVICE(target) == NDARRAY_DEVICE_CPU) {
+        int *shape = emalloc(sizeof(int));
+        int *strides = emalloc(sizeof(int));
+        shape[0] = (int)NDArray_NUMELEMENTS(target);
+        strides[0] = NDArray_ELSIZE(target);
+        return ndarray_contiguous_view(target, shape, strides, 1);
+    }
     NDArray *rtn = NDArray_Copy(target, NDArray_DEVICE(target));
     rtn->ndim = 1;
     if (NDArray_NDIM(target) == 0) {
@@ -182,6 +209,27 @@ NDArray_Flatten(NDArray *target) {
     return rtn;
 }
 
+/**
+ * Whether shape and strides describe a C contiguous block
+ *
+ * @param shape
+ * @param strides
+ * @param ndim
+ * @param elsize
+ * @return
+ */
+static int
+ndarray_is_c_contiguous(const int *shape, const int *strides, int ndim, int elsize) {
+    int i, expected = elsize;
+    for (i = ndim - 1; i >= 0; i--) {
+        if (shape[i] != 1 && strides[i] != expected) {
+            return 0;
+        }
+        expected *= shape[i];
+    }
+    return 1;
+}
+
 /**
  * @param array
  * @param indexes
@@ -250,22 +298,25 @@ NDArray_Slice(NDArray* array, NDArray** indexes, int num_indices) {
         }
     }
 
-    int *strides_ptr = emalloc(sizeof(int) * new_dim);
-    memcpy(strides_ptr, NDArray_STRIDES(array), sizeof(int) * NDArray_NDIM(array));
-    for (i = 0; i < new_dim; i++) {
-        strides_ptr[i] = new_strides[i];
-    }
-    int *shape_ptr = emalloc(sizeof(int) * new_dim);
-    memcpy(shape_ptr, NDArray_SHAPE(array), sizeof(int) * NDArray_NDIM(array));
-    for (i = 0; i < new_dim; i++) {
-        shape_ptr[i] = new_shape[i];
+    // Dimensions past the last index are kept whole
+    for (i = orig_dim; i < NDArray_NDIM(array); i++) {
+        new_strides[new_dim_step] = NDArray_STRIDES(array)[i];
+        new_shape[new_dim_step] = NDArray_SHAPE(array)[i];
+        new_dim_step++;
     }
+    new_dim = new_dim_step;
 
-    if (num_indices < NDArray_NDIM(array)) {
-        new_dim = NDArray_NDIM(array);
-    }
+    int *strides_ptr = emalloc(sizeof(int) * (new_dim > 0 ? new_dim : 1));
+    int *shape_ptr = emalloc(sizeof(int) * (new_dim > 0 ? new_dim : 1));
+    memcpy(strides_ptr, new_strides, sizeof(int) * new_dim);
+    memcpy(shape_ptr, new_shape, sizeof(int) * new_dim);
 
     NDArray *ret = NULL;
+    if (num_indices > 1 && NDArray_DEVICE(array) == NDARRAY_DEVICE_CPU &&
+        NDArray_IsContiguous(array) && ndarray_is_c_contiguous(shape_ptr, strides_ptr, new_dim, NDArray_ELSIZE(array))) {
+        return NDArray_CopyOnWriteView(array, data_ptr, shape_ptr, strides_ptr, new_dim);
+    }
+
     NDArray *fret = NDArray_FromNDArrayBase(array, data_ptr, shape_ptr, strides_ptr, new_dim);
 
     if (num_indices > 1) {
@@ -592,7 +643,7 @@ NDArray*
 NDArray_AtLeast3D(NDArray *a) {
     NDArray *output = NULL;
     if (NDArray_NDIM(a) < 3) {
-        int *new_shape = emalloc(sizeof(int) * 2);
+        int *new_shape = emalloc(sizeof(int) * 3);
         new_shape[0] = 1;
         if (NDArray_NDIM(a) < 2) {
             new_shape[0] = 1;
@@ -1,9 +1,13 @@
 #include <stdio.h>
+#include <limits.h>
 #include "ndarray.h"
 #include "debug.h"
 #include "iterators.h"
 #include "initializers.h"
 #include "types.h"
+#include "manipulation.h"
+#include "shm.h"
+#include "persistent.h"
 #include <php.h>
 #include "../config.h"
 #include "Zend/zend_alloc.h"
@@ -358,10 +362,10 @@ broadcast_error: {
 void apply_reduce(NDArray *result, NDArray *target, NDArray *(*operation)(NDArray *, NDArray *)) {
     NDArray *temp = operation(result, target);
     if (NDArray_DEVICE(target) == NDARRAY_DEVICE_CPU) {
-        memcpy(result->data, temp->data, result->descriptor->numElements * sizeof(float));
+        memcpy(result->data, temp->data, result->descriptor->numElements * NDArray_ELSIZE(result));
     } else {
 #ifdef HAVE_CUBLAS
-        vmemcpyd2d(NDArray_DATA(temp), NDArray_DATA(result), result->descriptor->numElements * sizeof(float));
+        vmemcpyd2d(NDArray_DATA(temp), NDArray_DATA(result), result->descriptor->numElements * NDArray_ELSIZE(result));
 #endif
     }
     NDArray_FREE(temp);
@@ -410,7 +414,7 @@ void _reduce(int current_axis, int rtn_init, int *axis, NDArray *target, NDArray
         if (rtn_init == 0) {
             rtn_init = 1;
             if (NDArray_DEVICE(rtn) == NDARRAY_DEVICE_CPU) {
-                memcpy(rtn->data, slice->data, rtn->descriptor->numElements * sizeof(float));
+                memcpy(rtn->data, slice->data, rtn->descriptor->numElements * NDArray_ELSIZE(rtn));
             }
 #ifdef HAVE_CUBLAS
             if (NDArray_DEVICE(rtn) == NDARRAY_DEVICE_GPU) {
@@ -566,7 +570,7 @@ reduce(NDArray *array, int *axis, NDArray *(*operation)(NDArray *, NDArray *)) {
     }
 
     // Allocate memory for the reduced buffer
-    NDArray *rtn = NDArray_Zeros(out_shape, out_ndim, NDARRAY_TYPE_FLOAT32, NDArray_DEVICE(array));
+    NDArray *rtn = NDArray_Zeros(out_shape, out_ndim, NDArray_TYPE(array), NDArray_DEVICE(array));
     _reduce(0, 0, axis, array, rtn, operation);
 
     if (null_axis == 1) {
@@ -601,16 +605,23 @@ NDArray_FREE(NDArray *array) {
             NDArrayIterator_FREE(array);
         }
 
-        if (array->strides != NULL) {
-            efree(array->strides);
-        }
+        // Row views point into the shape and strides of their base
+        if (!NDArray_CHKFLAGS(array, NDARRAY_ARRAY_BORROWED_SHAPE)) {
+            if (array->strides != NULL) {
+                efree(array->strides);
+            }
 
-        if (array->dimensions != NULL) {
-            efree(array->dimensions);
+            if (array->dimensions != NULL) {
+                efree(array->dimensions);
+            }
         }
 
         if (array->data != NULL && array->base == NULL && array->descriptor->numElements > 0) {
-            if (NDArray_DEVICE(array) == NDARRAY_DEVICE_CPU) {
+            if (NDArray_CHKFLAGS(array, NDARRAY_ARRAY_SHARED)) {
+                NDArray_SharedRelease(array);
+            } else if (NDArray_CHKFLAGS(array, NDARRAY_ARRAY_PERSISTENT)) {
+                NDArray_PersistentRelease(array);
+            } else if (NDArray_DEVICE(array) == NDARRAY_DEVICE_CPU) {
                 efree(array->data);
             } else {
 #ifdef HAVE_CUBLAS
@@ -650,6 +661,50 @@ NDArray_FREEDATA(NDArray *target) {
     target->data = NULL;
 }
 
+/**
+ * Give a copy-on-write array a private buffer before it is written.
+ * The shared buffer is copied only while other arrays still read it,
+ * otherwise the array adopts it. Other arrays are left untouched.
+ * Buffers of the persistent registry are read by every request, they
+ * are always copied.
+ *
+ * @param a
+ */
+void
+NDArray_EnsureWritable(NDArray *a) {
+    NDArray *holder, *contiguous;
+    char *data;
+    size_t nbytes;
+
+    if (a == NULL || !NDArray_CHKFLAGS(a, NDARRAY_ARRAY_COPY_ON_WRITE)) {
+        return;
+    }
+
+    holder = a->base;
+    if (holder->refcount == 1 && !NDArray_CHKFLAGS(holder, NDARRAY_ARRAY_PERSISTENT)) {
+        // Nobody else reads the buffer, a partial view can write in place
+        if (a->data != holder->data || NDArray_NUMELEMENTS(a) != NDArray_NUMELEMENTS(holder)) {
+            return;
+        }
+        holder->data = NULL;
+    } else if (NDArray_IsContiguous(a)) {
+        nbytes = (size_t)NDArray_NUMELEMENTS(a) * NDArray_ELSIZE(a);
+        data = emalloc(nbytes);
+        memcpy(data, a->data, nbytes);
+        a->data = data;
+    } else {
+        // Views of copy-on-write arrays can be strided, copy them in C order
+        contiguous = NDArray_ToContiguous(a);
+        memcpy(NDArray_STRIDES(a), NDArray_STRIDES(contiguous), sizeof(int) * NDArray_NDIM(a));
+        a->data = contiguous->data;
+        contiguous->data = NULL;
+        NDArray_FREE(contiguous);
+    }
+    a->base = NULL;
+    NDArray_CLEARFLAGS(a, NDARRAY_ARRAY_COPY_ON_WRITE);
+    NDArray_FREE(holder);
+}
+
 /**
  * Print NDArray or return the print string
  *
@@ -668,6 +723,11 @@ NDArray_Print(NDArray *array, int do_return) {
     if (is_type(NDArray_TYPE(array), NDARRAY_TYPE_FLOAT32)) {
         str = print_matrix_float(NDArray_FDATA(array), NDArray_NDIM(array), NDArray_SHAPE(array),
                                  NDArray_STRIDES(array), NDArray_NUMELEMENTS(array), NDArray_DEVICE(array));
+    } else if (!is_type(NDArray_TYPE(array), NDARRAY_TYPE_DOUBLE64)) {
+        NDArray *tmp = NDArray_AsType(array, NDARRAY_TYPE_DOUBLE64);
+        str = print_matrix(NDArray_DDATA(tmp), NDArray_NDIM(tmp), NDArray_SHAPE(tmp),
+                           NDArray_STRIDES(tmp), NDArray_NUMELEMENTS(tmp), NDArray_DEVICE(tmp));
+        NDArray_FREE(tmp);
     }
     if (do_return == 0) {
         printf("%s", str);
@@ -683,6 +743,15 @@ NDArray *
 NDArray_Map(NDArray *array, ElementWiseDoubleOperation op) {
     NDArray *rtn;
     int i;
+    if (!is_type(NDArray_TYPE(array), NDARRAY_TYPE_FLOAT32)) {
+        NDArray *tmp = NDArray_AsType(array, NDARRAY_TYPE_FLOAT32);
+        if (tmp == NULL) {
+            return NULL;
+        }
+        rtn = NDArray_Map(tmp, op);
+        NDArray_FREE(tmp);
+        return rtn;
+    }
     int *new_shape = emalloc(sizeof(int) * NDArray_NDIM(array));
     memcpy(new_shape, NDArray_SHAPE(array), sizeof(int) * NDArray_NDIM(array));
     rtn = NDArray_Zeros(new_shape, NDArray_NDIM(array), NDARRAY_TYPE_FLOAT32, NDArray_DEVICE(array));
@@ -692,6 +761,55 @@ NDArray_Map(NDArray *array, ElementWiseDoubleOperation op) {
     return rtn;
 }
 
+/**
+ * Apply `op` element-wise writing into `out`, a float32 C-contiguous
+ * CPU array with the shape of `array`. `out` may be `array` itself.
+ *
+ * @param array
+ * @param op
+ * @param out
+ * @return out, NULL on error
+ */
+NDArray *
+NDArray_MapInto(NDArray *array, ElementWiseDoubleOperation op, NDArray *out) {
+    NDArray *tmp = array;
+    int i;
+    if (NDArray_DEVICE(array) == NDARRAY_DEVICE_GPU || NDArray_DEVICE(out) == NDARRAY_DEVICE_GPU) {
+        zend_throw_error(NULL, "Output arrays are only available for NDArrays on CPU RAM.");
+        return NULL;
+    }
+    if (!is_type(NDArray_TYPE(out), NDARRAY_TYPE_FLOAT32)) {
+        zend_throw_error(NULL, "Result of dtype float32 can't be written into an output of dtype %s.", NDArray_TYPE(out));
+        return NULL;
+    }
+    if (!NDArray_IsContiguous(out)) {
+        zend_throw_error(NULL, "Output array must be contiguous.");
+        return NULL;
+    }
+    if (NDArray_NDIM(array) != NDArray_NDIM(out) ||
+        memcmp(NDArray_SHAPE(array), NDArray_SHAPE(out), sizeof(int) * NDArray_NDIM(out)) != 0) {
+        zend_throw_error(NULL, "Output array shape doesn't match the input shape.");
+        return NULL;
+    }
+    NDArray_EnsureWritable(out);
+    if (!is_type(NDArray_TYPE(array), NDARRAY_TYPE_FLOAT32)) {
+        tmp = NDArray_AsType(array, NDARRAY_TYPE_FLOAT32);
+        if (tmp == NULL) {
+            return NULL;
+        }
+    } else if (!NDArray_IsContiguous(array)) {
+        // Views are read in the output's linear order
+        tmp = NDArray_ToContiguous(array);
+    }
+    for (i = 0; i < NDArray_NUMELEMENTS(out); i++) {
+        NDArray_FDATA(out)[i] = op(NDArray_FDATA(tmp)[i]);
+    }
+    if (tmp != array) {
+        NDArray_FREE(tmp);
+    }
+    return out;
+}
+
 /**
  * @param array
  */
@@ -699,6 +817,15 @@ NDArray *
 NDArray_Map1F(NDArray *array, ElementWiseFloatOperation1F op, float val1) {
     NDArray *rtn;
     int i;
+    if (!is_type(NDArray_TYPE(array), NDARRAY_TYPE_FLOAT32)) {
+        NDArray *tmp = NDArray_AsType(array, NDARRAY_TYPE_FLOAT32);
+        if (tmp == NULL) {
+            return NULL;
+        }
+        rtn = NDArray_Map1F(tmp, op, val1);
+        NDArray_FREE(tmp);
+        return rtn;
+    }
     int *new_shape = emalloc(sizeof(int) * NDArray_NDIM(array));
     memcpy(new_shape, NDArray_SHAPE(array), sizeof(int) * NDArray_NDIM(array));
     rtn = NDArray_Zeros(new_shape, NDArray_NDIM(array), NDARRAY_TYPE_FLOAT32, NDArray_DEVICE(array));
@@ -733,6 +860,15 @@ NDArray *
 NDArray_Map2F(NDArray *array, ElementWiseFloatOperation2F op, float val1, float val2) {
     NDArray *rtn;
     int i;
+    if (!is_type(NDArray_TYPE(array), NDARRAY_TYPE_FLOAT32)) {
+        NDArray *tmp = NDArray_AsType(array, NDARRAY_TYPE_FLOAT32);
+        if (tmp == NULL) {
+            return NULL;
+        }
+        rtn = NDArray_Map2F(tmp, op, val1, val2);
+        NDArray_FREE(tmp);
+        return rtn;
+    }
     int *new_shape = emalloc(sizeof(int) * NDArray_NDIM(array));
     memcpy(new_shape, NDArray_SHAPE(array), sizeof(int) * NDArray_NDIM(array));
     rtn = NDArray_Zeros(new_shape, NDArray_NDIM(array), NDARRAY_TYPE_FLOAT32, NDArray_DEVICE(array));
@@ -968,7 +1104,7 @@ NDArray_Max(NDArray *target) {
  * @return
  */
 zval
-convertToStridedArrayToPHPArray(float *data, int *strides, int *dimensions, int ndim, int elsize) {
+convertToStridedArrayToPHPArray(char *data, int *strides, int *dimensions, int ndim, const NDArrayTypeFuncs *funcs) {
     zval phpArray;
     int i;
 
@@ -976,18 +1112,21 @@ convertToStridedArrayToPHPArray(float *data, int *strides, int *dimensions, int
 
     for (i = 0; i < dimensions[0]; i++) {
         if (ndim > 1) {
-            int j;
             zval subArray;
 
-            float *subData = data + (i * (strides[0] / elsize));
+            char *subData = data + ((long)i * strides[0]);
             int *subStrides = strides + 1;
             int *subDimensions = dimensions + 1;
 
-            subArray = convertToStridedArrayToPHPArray(subData, subStrides, subDimensions, ndim - 1, elsize);
+            subArray = convertToStridedArrayToPHPArray(subData, subStrides, subDimensions, ndim - 1, funcs);
 
             add_index_zval(&phpArray, i, &subArray);
         } else {
-            add_index_double(&phpArray, i, *(data + (i * (*strides / elsize))));
+            if (funcs->kind == NDARRAY_KIND_FLOAT) {
+                add_index_double(&phpArray, i, funcs->getitem(data + ((long)i * strides[0])));
+            } else {
+                add_index_long(&phpArray, i, funcs->getlong(data + ((long)i * strides[0])));
+            }
         }
     }
     return phpArray;
@@ -1002,8 +1141,9 @@ convertToStridedArrayToPHPArray(float *data, int *strides, int *dimensions, int
 zval
 NDArray_ToPHPArray(NDArray *target) {
     zval phpArray;
-    phpArray = convertToStridedArrayToPHPArray(NDArray_FDATA(target), NDArray_STRIDES(target),
-                                               NDArray_SHAPE(target), NDArray_NDIM(target), NDArray_ELSIZE(target));
+    phpArray = convertToStridedArrayToPHPArray(NDArray_DATA(target), NDArray_STRIDES(target),
+                                               NDArray_SHAPE(target), NDArray_NDIM(target),
+                                               NDArray_TypeFuncs(NDArray_TYPE(target)));
     return phpArray;
 }
 
@@ -1045,6 +1185,18 @@ NDArray_ToGPU(NDArray *target) {
         return NDArray_Copy(target, NDARRAY_DEVICE_GPU);
     }
 
+    // GPU kernels are float32 only, other dtypes are uploaded as float32
+    if (!is_type(NDArray_TYPE(target), NDARRAY_TYPE_FLOAT32)) {
+        NDArray *tmp = NDArray_AsType(target, NDARRAY_TYPE_FLOAT32);
+        NDArray *converted;
+        if (tmp == NULL) {
+            return NULL;
+        }
+        converted = NDArray_ToGPU(tmp);
+        NDArray_FREE(tmp);
+        return converted;
+    }
+
     new_shape = emalloc(sizeof(int) * NDArray_NDIM(target));
     memcpy(new_shape, NDArray_SHAPE(target), sizeof(int) * NDArray_NDIM(target));
 
@@ -1309,6 +1461,168 @@ NDArray_GetFloatScalar(NDArray *a) {
 #endif
 }
 
+/**
+ * Get the scalar value of a NDArray of any dtype at full precision
+ *
+ * @param a
+ * @return
+ */
+double
+NDArray_GetDoubleScalar(NDArray *a) {
+    if (NDArray_DEVICE(a) == NDARRAY_DEVICE_CPU) {
+        return NDArray_TypeFuncs(NDArray_TYPE(a))->getitem(NDArray_DATA(a));
+    }
+    return (double)NDArray_GetFloatScalar(a);
+}
+
+/**
+ * Broadcast the shapes of `a` and `b` against each other
+ *
+ * Writes the output shape and the byte strides that walk each operand
+ * over it, using 0 strides on broadcast axes so nothing is copied.
+ *
+ * @param a
+ * @param b
+ * @param shape
+ * @param a_strides
+ * @param b_strides
+ * @return output ndim, -1 if the shapes are not compatible
+ */
+int
+NDArray_BroadcastStrides(NDArray *a, NDArray *b, int *shape, long *a_strides, long *b_strides) {
+    int i, ia, ib, da, db;
+    int ndim = NDArray_NDIM(a) > NDArray_NDIM(b) ? NDArray_NDIM(a) : NDArray_NDIM(b);
+
+    for (i = 0; i < ndim; i++) {
+        ia = i - (ndim - NDArray_NDIM(a));
+        ib = i - (ndim - NDArray_NDIM(b));
+        da = ia >= 0 ? NDArray_SHAPE(a)[ia] : 1;
+        db = ib >= 0 ? NDArray_SHAPE(b)[ib] : 1;
+        if (da != db && da != 1 && db != 1) {
+            return -1;
+        }
+        shape[i] = da == 1 ? db : da;
+        a_strides[i] = (ia >= 0 && da != 1) ? NDArray_STRIDES(a)[ia] : 0;
+        b_strides[i] = (ib >= 0 && db != 1) ? NDArray_STRIDES(b)[ib] : 0;
+    }
+    return ndim;
+}
+
+/**
+ * Run a strided binary loop over two broadcast operands, writing a
+ * C-contiguous output of `out_elsize` bytes per element
+ *
+ * @param pa
+ * @param a_strides
+ * @param pb
+ * @param b_strides
+ * @param out
+ * @param out_elsize
+ * @param shape
+ * @param ndim
+ * @param loop
+ */
+void
+NDArray_BroadcastLoop(char *pa, const long *a_strides, char *pb, const long *b_strides, char *out, int out_elsize,
+                      const int *shape, int ndim,
+                      void (*loop)(const char *, long, const char *, long, char *, long, long)) {
+    int index[NDARRAY_MAX_DIMS];
+    long o, outer, inner, total = 1;
+    int i, k;
+
+    if (ndim == 0) {
+        loop(pa, 0, pb, 0, out, 0, 1);
+        return;
+    }
+    for (i = 0; i < ndim; i++) {
+        index[i] = 0;
+        total *= shape[i];
+    }
+    inner = shape[ndim - 1];
+    outer = inner > 0 ? total / inner : 0;
+    for (o = 0; o < outer; o++) {
+        loop(pa, a_strides[ndim - 1], pb, b_strides[ndim - 1], out, out_elsize, inner);
+        out += inner * out_elsize;
+        for (k = ndim - 2; k >= 0; k--) {
+            index[k]++;
+            pa += a_strides[k];
+            pb += b_strides[k];
+            if (index[k] < shape[k]) {
+                break;
+            }
+            pa -= a_strides[k] * shape[k];
+            pb -= b_strides[k] * shape[k];
+            index[k] = 0;
+        }
+    }
+}
+
+/**
+ * Write one element of `a` at `ptr` into a PHP zval. Integer and bool
+ * dtypes become PHP integers, floating point dtypes PHP floats.
+ *
+ * @param a
+ * @param ptr
+ * @param rtn
+ */
+void
+NDArray_ItemToZval(NDArray *a, const char *ptr, zval *rtn) {
+    const NDArrayTypeFuncs *funcs = NDArray_TypeFuncs(NDArray_TYPE(a));
+    if (funcs->kind == NDARRAY_KIND_FLOAT) {
+        ZVAL_DOUBLE(rtn, funcs->getitem(ptr));
+    } else {
+        ZVAL_LONG(rtn, funcs->getlong(ptr));
+    }
+}
+
+/**
+ * Copy an NDArray into a new C-contiguous CPU array of another dtype
+ *
+ * @param a
+ * @param type
+ * @return
+ */
+NDArray*
+NDArray_AsType(NDArray *a, const char *type) {
+    const NDArrayTypeFuncs *src_funcs = NDArray_TypeFuncs(NDArray_TYPE(a));
+    const NDArrayTypeFuncs *dst_funcs = NDArray_TypeFuncs(type);
+    NDArray *contiguous = a, *rtn;
+    int *new_shape;
+    long i;
+
+    if (src_funcs == NULL || dst_funcs == NULL) {
+        zend_throw_error(NULL, "Unsupported dtype conversion.");
+        return NULL;
+    }
+    if (NDArray_DEVICE(a) == NDARRAY_DEVICE_GPU) {
+        if (is_type(NDArray_TYPE(a), type)) {
+            return NDArray_Copy(a, NDARRAY_DEVICE_GPU);
+        }
+        zend_throw_error(NULL, "dtype conversion is only available for NDArrays on CPU RAM.");
+        return NULL;
+    }
+    if (!NDArray_IsContiguous(a)) {
+        contiguous = NDArray_ToContiguous(a);
+    }
+
+    new_shape = emalloc(sizeof(int) * (NDArray_NDIM(a) > 0 ? NDArray_NDIM(a) : 1));
+    memcpy(new_shape, NDArray_SHAPE(a), sizeof(int) * NDArray_NDIM(a));
+    rtn = NDArray_Empty(new_shape, NDArray_NDIM(a), type, NDARRAY_DEVICE_CPU);
+    if (src_funcs == dst_funcs) {
+        memcpy(NDArray_DATA(rtn), NDArray_DATA(contiguous), NDArray_NUMELEMENTS(a) * dst_funcs->elsize);
+    } else {
+        for (i = 0; i < NDArray_NUMELEMENTS(a); i++) {
+            dst_funcs->setitem(rtn->data + i * dst_funcs->elsize,
+                               src_funcs->getitem(contiguous->data + i * src_funcs->elsize));
+        }
+    }
+
+    if (contiguous != a) {
+        NDArray_FREE(contiguous);
+    }
+    return rtn;
+}
+
 /**
  * Overwrite the values of one NDArray with the values
  * of another.
@@ -1318,9 +1632,21 @@ NDArray_GetFloatScalar(NDArray *a) {
  */
 int
 NDArray_Overwrite(NDArray *target, NDArray *values) {
+    NDArray *v = values;
+    int i;
+
+    NDArray_EnsureWritable(target);
 
     if (NDArray_NDIM(values) == 0) {
-        NDArray_Fill(target, NDArray_GetFloatScalar(values));
+        if (NDArray_DEVICE(target) == NDARRAY_DEVICE_GPU || is_type(NDArray_TYPE(target), NDARRAY_TYPE_FLOAT32)) {
+            NDArray_Fill(target, NDArray_GetFloatScalar(values));
+        } else {
+            const NDArrayTypeFuncs *funcs = NDArray_TypeFuncs(NDArray_TYPE(target));
+            double fill_value = NDArray_GetDoubleScalar(values);
+            for (i = 0; i < NDArray_NUMELEMENTS(target); i++) {
+                funcs->setitem(target->data + (long)i * funcs->elsize, fill_value);
+            }
+        }
         return 1;
     }
 
@@ -1335,14 +1661,21 @@ NDArray_Overwrite(NDArray *target, NDArray *values) {
     }
 
     if (NDArray_DEVICE(target) == NDARRAY_DEVICE_CPU) {
-        memcpy(NDArray_FDATA(target), NDArray_FDATA(values),
-               sizeof(NDArray_ELSIZE(values)) * NDArray_NUMELEMENTS(values));
+        if (!is_type(NDArray_TYPE(values), NDArray_TYPE(target))) {
+            v = NDArray_AsType(values, NDArray_TYPE(target));
+        } else if (!NDArray_IsContiguous(values)) {
+            v = NDArray_ToContiguous(values);
+        }
+        memcpy(target->data, v->data, (size_t)NDArray_ELSIZE(target) * NDArray_NUMELEMENTS(target));
+        if (v != values) {
+            NDArray_FREE(v);
+        }
         return 1;
     }
 #ifdef HAVE_CUBLAS
     if (NDArray_DEVICE(target) == NDARRAY_DEVICE_GPU) {
         vmemcpyd2d(values->data, target->data,
-                            sizeof(NDArray_ELSIZE(values)) * NDArray_NUMELEMENTS(values));
+                   (size_t)NDArray_ELSIZE(target) * NDArray_NUMELEMENTS(target));
         return 1;
     }
 #endif
@@ -1403,6 +1736,154 @@ NDArray_Load(char * filename)
     return out;
 }
 
+/**
+ * Check if the strides of `a` describe a C-contiguous buffer
+ *
+ * @param a
+ * @return
+ */
+int
+NDArray_IsContiguous(NDArray *a)
+{
+    int i, expected = NDArray_ELSIZE(a);
+    for (i = NDArray_NDIM(a) - 1; i >= 0; i--) {
+        if (NDArray_SHAPE(a)[i] != 1 && NDArray_STRIDES(a)[i] != expected) {
+            return 0;
+        }
+        expected *= NDArray_SHAPE(a)[i];
+    }
+    return 1;
+}
+
+/**
+ * Serialize an NDArray into a PHP array holding its dtype, shape
+ * and the raw data buffer as a binary string.
+ *
+ * @param a
+ * @param rtn
+ * @return
+ */
+int
+NDArray_Serialize(NDArray *a, zval *rtn)
+{
+    zval shape;
+    NDArray *contiguous = a;
+    int i;
+
+    if (NDArray_DEVICE(a) == NDARRAY_DEVICE_GPU) {
+        zend_throw_error(NULL, "NDArray must be on CPU RAM before it can be serialized.");
+        return -1;
+    }
+    if (!NDArray_IsContiguous(a)) {
+        contiguous = NDArray_ToContiguous(a);
+    }
+
+    array_init_size(&shape, NDArray_NDIM(a));
+    for (i = 0; i < NDArray_NDIM(a); i++) {
+        add_next_index_long(&shape, NDArray_SHAPE(a)[i]);
+    }
+    array_init_size(rtn, 3);
+    add_assoc_string(rtn, "dtype", (char*)NDArray_TYPE(a));
+    add_assoc_zval(rtn, "shape", &shape);
+    add_assoc_stringl(rtn, "data", NDArray_DATA(contiguous), (size_t)NDArray_NUMELEMENTS(a) * NDArray_ELSIZE(a));
+
+    if (contiguous != a) {
+        NDArray_FREE(contiguous);
+    }
+    return 0;
+}
+
+/**
+ * Check if `data` was produced by NDArray_Serialize
+ *
+ * @param data
+ * @return
+ */
+int
+NDArray_IsSerialized(zval *data)
+{
+    if (Z_TYPE_P(data) != IS_ARRAY) {
+        return 0;
+    }
+    return zend_hash_str_exists(Z_ARRVAL_P(data), "data", sizeof("data") - 1) &&
+           zend_hash_str_exists(Z_ARRVAL_P(data), "shape", sizeof("shape") - 1) &&
+           zend_hash_str_exists(Z_ARRVAL_P(data), "dtype", sizeof("dtype") - 1);
+}
+
+/**
+ * Rebuild an NDArray from the output of NDArray_Serialize
+ *
+ * @param data
+ * @return
+ */
+NDArray*
+NDArray_Unserialize(zval *data)
+{
+    zval *dtype, *shape, *buffer, *dim;
+    const char *type;
+    NDArray *rtn;
+    int *new_shape, ndim, i = 0;
+    long num_elements = 1, j;
+    unsigned char *flags;
+
+    dtype = zend_hash_str_find(Z_ARRVAL_P(data), "dtype", sizeof("dtype") - 1);
+    shape = zend_hash_str_find(Z_ARRVAL_P(data), "shape", sizeof("shape") - 1);
+    buffer = zend_hash_str_find(Z_ARRVAL_P(data), "data", sizeof("data") - 1);
+    if (Z_TYPE_P(dtype) != IS_STRING || Z_TYPE_P(shape) != IS_ARRAY || Z_TYPE_P(buffer) != IS_STRING) {
+        zend_throw_error(NULL, "Invalid serialized NDArray.");
+        return NULL;
+    }
+    type = NDArray_ParseType(Z_STRVAL_P(dtype));
+    if (type == NULL) {
+        zend_throw_error(NULL, "Unsupported serialized dtype %s.", Z_STRVAL_P(dtype));
+        return NULL;
+    }
+
+    ndim = zend_array_count(Z_ARRVAL_P(shape));
+    if (ndim > NDARRAY_MAX_DIMS) {
+        zend_throw_error(NULL, "Invalid serialized NDArray.");
+        return NULL;
+    }
+    new_shape = emalloc(sizeof(int) * (ndim > 0 ? ndim : 1));
+    ZEND_HASH_FOREACH_VAL(Z_ARRVAL_P(shape), dim) {
+        if (Z_TYPE_P(dim) != IS_LONG || Z_LVAL_P(dim) < 0 || Z_LVAL_P(dim) > INT_MAX) {
+            efree(new_shape);
+            zend_throw_error(NULL, "Invalid serialized NDArray.");
+            return NULL;
+        }
+        new_shape[i] = (int)Z_LVAL_P(dim);
+        // NDArray sizes are int, reject counts that would wrap
+        if (new_shape[i] > 0 && num_elements > INT_MAX / new_shape[i]) {
+            efree(new_shape);
+            zend_throw_error(NULL, "Serialized NDArray shape is too large.");
+            return NULL;
+        }
+        num_elements *= new_shape[i];
+        i++;
+    } ZEND_HASH_FOREACH_END();
+
+    if (Z_STRLEN_P(buffer) != (size_t)num_elements * get_type_size(type)) {
+        efree(new_shape);
+        zend_throw_error(NULL, "Serialized NDArray data does not match its shape.");
+        return NULL;
+    }
+
+    if (ndim == 0 && is_type(type, NDARRAY_TYPE_FLOAT32)) {
+        efree(new_shape);
+        return NDArray_CreateFromFloatScalar(((float*)Z_STRVAL_P(buffer))[0]);
+    }
+    rtn = NDArray_Empty(new_shape, ndim, type, NDARRAY_DEVICE_CPU);
+    memcpy(NDArray_DATA(rtn), Z_STRVAL_P(buffer), Z_STRLEN_P(buffer));
+    if (is_type(type, NDARRAY_TYPE_BOOL)) {
+        // Bytes other than 0 and 1 are not valid bools
+        flags = (unsigned char*)NDArray_DATA(rtn);
+        for (j = 0; j < num_elements; j++) {
+            flags[j] = flags[j] != 0;
+        }
+    }
+    return rtn;
+}
+
 NDArray*
 NDArray_AssignRawScalar(NDArray *dst, NDArray *src)
 {
@@ -12,6 +12,10 @@ extern "C" {
 #define NDARRAY_MAX_DIMS 128
 #define NDARRAY_ARRAY_C_CONTIGUOUS    0x0001
 #define NDARRAY_ARRAY_F_CONTIGUOUS    0x0002
+#define NDARRAY_ARRAY_SHARED          0x0004
+#define NDARRAY_ARRAY_PERSISTENT      0x0008
+#define NDARRAY_ARRAY_BORROWED_SHAPE  0x0010
+#define NDARRAY_ARRAY_COPY_ON_WRITE   0x0020
 
 #define NDARRAY_UNLIKELY(x) (x)
 #define NDArray_DATA(a) ((void *)((a)->data))
@@ -117,12 +121,24 @@ int NDArray_ShapeCompare(NDArray *a, NDArray *b);
 NDArray* NDArray_Broadcast(NDArray *a, NDArray *b);
 int NDArray_IsBroadcastable(const NDArray *arr1, const NDArray *arr2);
 float NDArray_GetFloatScalar(NDArray *a);
+double NDArray_GetDoubleScalar(NDArray *a);
+NDArray* NDArray_AsType(NDArray *a, const char *type);
+int NDArray_BroadcastStrides(NDArray *a, NDArray *b, int *shape, long *a_strides, long *b_strides);
+void NDArray_BroadcastLoop(char *pa, const long *a_strides, char *pb, const long *b_strides, char *out, int out_elsize,
+                           const int *shape, int ndim,
+                           void (*loop)(const char *, long, const char *, long, char *, long, long));
+void NDArray_ItemToZval(NDArray *a, const char *ptr, zval *rtn);
 void NDArray_FREEDATA(NDArray *target);
+void NDArray_EnsureWritable(NDArray *a);
 int NDArray_Overwrite(NDArray *target, NDArray *values);
 NDArray* NDArray_FromGD(zval *a, bool channel_last);
 void NDArray_ToGD(NDArray *a, NDArray *n_alpha, zval *output);
 void NDArray_Save(NDArray *a, char * filename, int length);
 NDArray* NDArray_Load(char * filename);
+int NDArray_IsContiguous(NDArray *a);
+int NDArray_Serialize(NDArray *a, zval *rtn);
+int NDArray_IsSerialized(zval *data);
+NDArray* NDArray_Unserialize(zval *data);
 NDArray* NDArray_AssignRawScalar(NDArray *dst, NDArray *src);
 int NDArray_AssignArray(NDArray *dst, NDArray *src);
 int NDArray_CompareLists(int const *l1, int const *l2, int n);
@@ -137,6 +153,7 @@ typedef float (*ElementWiseDoubleOperation)(float);
 typedef float (*ElementWiseFloatOperation2F)(float, float, float);
 typedef float (*ElementWiseFloatOperation1F)(float, float);
 NDArray* NDArray_Map(NDArray *array, ElementWiseDoubleOperation op);
+NDArray* NDArray_MapInto(NDArray *array, ElementWiseDoubleOperation op, NDArray *out);
 NDArray* NDArray_Map_Zval(NDArray *array, zval *callback);
 NDArray* NDArray_Map2F(NDArray *array, ElementWiseFloatOperation2F op, float val1, float val2);
 NDArray* NDArray_Map1F(NDArray *array, ElementWiseFloatOperation1F op, float val1);
@@ -157,8 +157,311 @@ NDArray_Median_Float(NDArray* a) {
     }
 }
 
+/**
+ * Run a whole-array reduction kernel from the dtype table
+ *
+ * @param a
+ * @param kernel
+ * @return
+ */
+static double
+NDArray_TypeReduce(NDArray *a, double (*kernel)(const char *, long)) {
+    NDArray *contiguous = a;
+    double value;
+
+    if (NDArray_DEVICE(a) == NDARRAY_DEVICE_GPU) {
+        zend_throw_error(NULL, "%s reductions are only available for NDArrays on CPU RAM.", NDArray_TYPE(a));
+        return 0;
+    }
+    if (!NDArray_IsContiguous(a)) {
+        contiguous = NDArray_ToContiguous(a);
+    }
+    value = kernel(NDArray_DATA(contiguous), NDArray_NUMELEMENTS(contiguous));
+    if (contiguous != a) {
+        NDArray_FREE(contiguous);
+    }
+    return value;
+}
+
+/**
+ * Sum of all elements, accumulated in the array dtype
+ *
+ * @param a
+ * @return
+ */
+double
+NDArray_Sum(NDArray* a) {
+    if (is_type(NDArray_TYPE(a), NDARRAY_TYPE_FLOAT32)) {
+        return NDArray_Sum_Float(a);
+    }
+    return NDArray_TypeReduce(a, NDArray_TypeFuncs(NDArray_TYPE(a))->sum);
+}
+
+/**
+ * Product of all elements, accumulated in the array dtype
+ *
+ * @param a
+ * @return
+ */
+double
+NDArray_Prod(NDArray* a) {
+    if (is_type(NDArray_TYPE(a), NDARRAY_TYPE_FLOAT32)) {
+        return NDArray_Float_Prod(a);
+    }
+    return NDArray_TypeReduce(a, NDArray_TypeFuncs(NDArray_TYPE(a))->prod);
+}
+
+/**
+ * Minimum of all elements
+ *
+ * @param a
+ * @return
+ */
+double
+NDArray_AMin(NDArray* a) {
+    if (is_type(NDArray_TYPE(a), NDARRAY_TYPE_FLOAT32)) {
+        return NDArray_Min(a);
+    }
+    return NDArray_TypeReduce(a, NDArray_TypeFuncs(NDArray_TYPE(a))->min);
+}
+
+/**
+ * Maximum of all elements
+ *
+ * @param a
+ * @return
+ */
+double
+NDArray_AMax(NDArray* a) {
+    if (is_type(NDArray_TYPE(a), NDARRAY_TYPE_FLOAT32)) {
+        return NDArray_Max(a);
+    }
+    return NDArray_TypeReduce(a, NDArray_TypeFuncs(NDArray_TYPE(a))->max);
+}
+
+/**
+ * Result dtype of an element-wise binary operation. Integer division
+ * and bool arithmetic promote to float64 and int64.
+ *
+ * @param a
+ * @param b
+ * @param op NDARRAY_BINOP_*
+ * @return
+ */
+static const char*
+ndarray_binop_type(NDArray* a, NDArray* b, int op) {
+    const char *type = NDArray_PromoteTypes(NDArray_TYPE(a), NDArray_TYPE(b));
+    if (op == NDARRAY_BINOP_DIVIDE && NDArray_TypeFuncs(type)->kind != NDARRAY_KIND_FLOAT) {
+        return NDARRAY_TYPE_DOUBLE64;
+    }
+    if (NDArray_TypeFuncs(type)->kind == NDARRAY_KIND_BOOL) {
+        return NDARRAY_TYPE_INT64;
+    }
+    return type;
+}
+
+/**
+ * Whether `x`, read with the broadcast strides `x_strides`, shares
+ * memory with `out` in any other way than element for element
+ */
+static int
+ndarray_binop_overlaps(NDArray *x, const long *x_strides, NDArray *out, int ndim) {
+    long extent = NDArray_ELSIZE(x), expected = NDArray_ELSIZE(out);
+    int i;
+    for (i = 0; i < NDArray_NDIM(x); i++) {
+        extent += (long)(NDArray_SHAPE(x)[i] - 1) * labs(NDArray_STRIDES(x)[i]);
+    }
+    if (NDArray_DATA(x) >= NDArray_DATA(out) + (long)NDArray_NUMELEMENTS(out) * NDArray_ELSIZE(out) ||
+        NDArray_DATA(out) >= NDArray_DATA(x) + extent) {
+        return 0;
+    }
+    if (NDArray_DATA(x) != NDArray_DATA(out) || NDArray_ELSIZE(x) != NDArray_ELSIZE(out)) {
+        return 1;
+    }
+    for (i = ndim - 1; i >= 0; i--) {
+        if (NDArray_SHAPE(out)[i] != 1 && x_strides[i] != expected) {
+            return 1;
+        }
+        expected *= NDArray_SHAPE(out)[i];
+    }
+    return 0;
+}
+
+/**
+ * Whether NDArray_BinaryOpInto can write `a op b` into `out` without
+ * changing its dtype or shape
+ *
+ * @param a
+ * @param b
+ * @param out
+ * @param op NDARRAY_BINOP_*
+ * @return
+ */
+int
+NDArray_BinaryOpFitsInto(NDArray* a, NDArray* b, NDArray* out, int op) {
+    long a_strides[NDARRAY_MAX_DIMS], b_strides[NDARRAY_MAX_DIMS];
+    int shape[NDARRAY_MAX_DIMS], ndim, i;
+
+    if (NDArray_DEVICE(a) == NDARRAY_DEVICE_GPU || NDArray_DEVICE(b) == NDARRAY_DEVICE_GPU ||
+        NDArray_DEVICE(out) == NDARRAY_DEVICE_GPU || !NDArray_IsContiguous(out)) {
+        return 0;
+    }
+    if (!is_type(ndarray_binop_type(a, b, op), NDArray_TYPE(out))) {
+        return 0;
+    }
+    if (NDArray_NDIM(a) > NDARRAY_MAX_DIMS || NDArray_NDIM(b) > NDARRAY_MAX_DIMS) {
+        return 0;
+    }
+    ndim = NDArray_BroadcastStrides(a, b, shape, a_strides, b_strides);
+    if (ndim != NDArray_NDIM(out)) {
+        return 0;
+    }
+    for (i = 0; i < ndim; i++) {
+        if (shape[i] != NDArray_SHAPE(out)[i]) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/**
+ * Element-wise binary operation through the dtype kernel table.
+ *
+ * Operands are promoted to a common dtype and broadcast against each
+ * other using zero strides, so no broadcast copy is materialized.
+ * Integer division and bool arithmetic promote to float64 and int64.
+ *
+ * @param a
+ * @param b
+ * @param op NDARRAY_BINOP_*
+ * @return
+ */
+NDArray*
+NDArray_BinaryOp(NDArray* a, NDArray* b, int op) {
+    return NDArray_BinaryOpInto(a, b, NULL, op);
+}
+
+/**
+ * Element-wise binary operation written into `out`, which must be a
+ * C-contiguous CPU array with the broadcast shape and the result dtype.
+ * `out` may be one of the operands. When `out` is NULL a new array
+ * is allocated.
+ *
+ * @param a
+ * @param b
+ * @param out
+ * @param op NDARRAY_BINOP_*
+ * @return the result, NULL on error
+ */
+NDArray*
+NDArray_BinaryOpInto(NDArray* a, NDArray* b, NDArray* out, int op) {
+    const char *type = ndarray_binop_type(a, b, op);
+    const NDArrayTypeFuncs *funcs;
+    NDArray_BinaryLoop loop = NULL;
+    NDArray *a_cast = a, *b_cast = b, *rtn = NULL, *tmp;
+    long a_strides[NDARRAY_MAX_DIMS], b_strides[NDARRAY_MAX_DIMS];
+    int ndim, *shape, i;
+
+    if (NDArray_DEVICE(a) == NDARRAY_DEVICE_GPU || NDArray_DEVICE(b) == NDARRAY_DEVICE_GPU ||
+        (out != NULL && NDArray_DEVICE(out) == NDARRAY_DEVICE_GPU)) {
+        zend_throw_error(NULL, "%s operations are only available for NDArrays on CPU RAM.", type);
+        return NULL;
+    }
+    funcs = NDArray_TypeFuncs(type);
+    switch (op) {
+        case NDARRAY_BINOP_ADD:
+            loop = funcs->add;
+            break;
+        case NDARRAY_BINOP_SUBTRACT:
+            loop = funcs->subtract;
+            break;
+        case NDARRAY_BINOP_MULTIPLY:
+            loop = funcs->multiply;
+            break;
+        case NDARRAY_BINOP_DIVIDE:
+            loop = funcs->divide;
+            break;
+    }
+    if (loop == NULL) {
+        zend_throw_error(NULL, "Operation not supported for dtype %s.", type);
+        return NULL;
+    }
+    if (out != NULL && !is_type(NDArray_TYPE(out), type)) {
+        zend_throw_error(NULL, "Result of dtype %s can't be written into an output of dtype %s.", type, NDArray_TYPE(out));
+        return NULL;
+    }
+    if (out != NULL && !NDArray_IsContiguous(out)) {
+        zend_throw_error(NULL, "Output array must be contiguous.");
+        return NULL;
+    }
+
+    if (!is_type(NDArray_TYPE(a), type)) {
+        a_cast = NDArray_AsType(a, type);
+    }
+    if (!is_type(NDArray_TYPE(b), type)) {
+        b_cast = NDArray_AsType(b, type);
+    }
+    ndim = NDArray_NDIM(a) > NDArray_NDIM(b) ? NDArray_NDIM(a) : NDArray_NDIM(b);
+    shape = emalloc(sizeof(int) * (ndim > 0 ? ndim : 1));
+    ndim = NDArray_BroadcastStrides(a_cast, b_cast, shape, a_strides, b_strides);
+    if (ndim < 0) {
+        efree(shape);
+        zend_throw_error(NULL, "Broadcast shape mismatch.");
+    } else if (out == NULL) {
+        rtn = NDArray_Empty(shape, ndim, type, NDARRAY_DEVICE_CPU);
+        NDArray_BroadcastLoop(NDArray_DATA(a_cast), a_strides, NDArray_DATA(b_cast), b_strides,
+                              NDArray_DATA(rtn), funcs->elsize, shape, ndim, loop);
+    } else {
+        rtn = out;
+        if (ndim != NDArray_NDIM(out)) {
+            rtn = NULL;
+        }
+        for (i = 0; rtn != NULL && i < ndim; i++) {
+            if (shape[i] != NDArray_SHAPE(out)[i]) {
+                rtn = NULL;
+            }
+        }
+        if (rtn == NULL) {
+            zend_throw_error(NULL, "Output array shape doesn't match the broadcast shape.");
+        } else {
+            NDArray_EnsureWritable(out);
+            // Operands read through other strides than `out` would see partially written results
+            if (ndarray_binop_overlaps(a_cast, a_strides, out, ndim)) {
+                tmp = NDArray_ToContiguous(a_cast);
+                if (a_cast != a) {
+                    NDArray_FREE(a_cast);
+                }
+                a_cast = tmp;
+                NDArray_BroadcastStrides(a_cast, b_cast, shape, a_strides, b_strides);
+            }
+            if (ndarray_binop_overlaps(b_cast, b_strides, out, ndim)) {
+                tmp = NDArray_ToContiguous(b_cast);
+                if (b_cast != b) {
+                    NDArray_FREE(b_cast);
+                }
+                b_cast = tmp;
+                NDArray_BroadcastStrides(a_cast, b_cast, shape, a_strides, b_strides);
+            }
+            NDArray_BroadcastLoop(NDArray_DATA(a_cast), a_strides, NDArray_DATA(b_cast), b_strides,
+                                  NDArray_DATA(out), funcs->elsize, shape, ndim, loop);
+        }
+        efree(shape);
+    }
+
+    if (a_cast != a) {
+        NDArray_FREE(a_cast);
+    }
+    if (b_cast != b) {
+        NDArray_FREE(b_cast);
+    }
+    return rtn;
+}
+
 NDArray*
 NDArray_Add_Float(NDArray* a, NDArray* b) {
+    if (!is_type(NDArray_TYPE(a), NDARRAY_TYPE_FLOAT32) || !is_type(NDArray_TYPE(b), NDARRAY_TYPE_FLOAT32)) {
+        return NDArray_BinaryOp(a, b, NDARRAY_BINOP_ADD);
+    }
     NDArray *a_temp = NULL, *b_temp = NULL;
     if (NDArray_DEVICE(a) != NDArray_DEVICE(b) && NDArray_NDIM(a) != 0 && NDArray_NDIM(b) != 0) {
         zend_throw_error(NULL, "Device mismatch, both NDArray MUST be in the same device.");
@@ -292,6 +595,9 @@ __m256 fix_negative_zero(__m256 vec) {
  */
 NDArray*
 NDArray_Multiply_Float(NDArray* a, NDArray* b) {
+    if (!is_type(NDArray_TYPE(a), NDARRAY_TYPE_FLOAT32) || !is_type(NDArray_TYPE(b), NDARRAY_TYPE_FLOAT32)) {
+        return NDArray_BinaryOp(a, b, NDARRAY_BINOP_MULTIPLY);
+    }
     NDArray *broadcasted = NULL;
     NDArray *a_temp = NULL, *b_temp = NULL;
     if (NDArray_DEVICE(a) != NDArray_DEVICE(b) && NDArray_NDIM(a) != 0 && NDArray_NDIM(b) != 0) {
@@ -438,6 +744,9 @@ NDArray_Multiply_Float(NDArray* a, NDArray* b) {
  */
 NDArray*
 NDArray_Subtract_Float(NDArray* a, NDArray* b) {
+    if (!is_type(NDArray_TYPE(a), NDARRAY_TYPE_FLOAT32) || !is_type(NDArray_TYPE(b), NDARRAY_TYPE_FLOAT32)) {
+        return NDArray_BinaryOp(a, b, NDARRAY_BINOP_SUBTRACT);
+    }
     NDArray *a_temp = NULL, *b_temp = NULL;
     if (NDArray_DEVICE(a) != NDArray_DEVICE(b) && NDArray_NDIM(a) != 0 && NDArray_NDIM(b) != 0) {
         zend_throw_error(NULL, "Device mismatch, both NDArray MUST be in the same device.");
@@ -565,6 +874,9 @@ NDArray_Subtract_Float(NDArray* a, NDArray* b) {
  */
 NDArray*
 NDArray_Divide_Float(NDArray* a, NDArray* b) {
+    if (!is_type(NDArray_TYPE(a), NDARRAY_TYPE_FLOAT32) || !is_type(NDArray_TYPE(b), NDARRAY_TYPE_FLOAT32)) {
+        return NDArray_BinaryOp(a, b, NDARRAY_BINOP_DIVIDE);
+    }
     NDArray *a_temp = NULL, *b_temp = NULL;
 
     if (NDArray_DEVICE(a) != NDArray_DEVICE(b) && NDArray_NDIM(a) != 0 && NDArray_NDIM(b) != 0) {
@@ -3,6 +3,11 @@
 
 #include "../ndarray.h"
 
+#define NDARRAY_BINOP_ADD      0
+#define NDARRAY_BINOP_SUBTRACT 1
+#define NDARRAY_BINOP_MULTIPLY 2
+#define NDARRAY_BINOP_DIVIDE   3
+
 NDArray* NDArray_Subtract_Float(NDArray* a, NDArray* b);
 NDArray* NDArray_Add_Float(NDArray* a, NDArray* b);
 NDArray* NDArray_Multiply_Float(NDArray* a, NDArray* b);
@@ -14,5 +19,12 @@ float NDArray_Float_Prod(NDArray* a);
 float NDArray_Mean_Float(NDArray* a);
 float NDArray_Mean_Float_Axis(NDArray* a, NDArray *b);
 NDArray* NDArray_Abs(NDArray *nda);
+NDArray* NDArray_BinaryOp(NDArray* a, NDArray* b, int op);
+NDArray* NDArray_BinaryOpInto(NDArray* a, NDArray* b, NDArray* out, int op);
+int NDArray_BinaryOpFitsInto(NDArray* a, NDArray* b, NDArray* out, int op);
+double NDArray_Sum(NDArray* a);
+double NDArray_Prod(NDArray* a);
+double NDArray_AMin(NDArray* a);
+double NDArray_AMax(NDArray* a);
 float NDArray_Median_Float(NDArray* a);
 #endif //PHPSCI_NDARRAY_ARITHMETICS_H
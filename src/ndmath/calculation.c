@@ -5,58 +5,17 @@
 #include <Zend/zend.h>
 #include "../../config.h"
 #include "../ndarray.h"
+#include "../types.h"
+#include <stdint.h>
 
-static int
-float_argmax(float *ip, int n, float *max_ind)
-{
-    int i;
-    float mp = *ip;
-    *max_ind = 0;
-    if (isnanf(mp)) {
-        /* nan encountered; it's maximal */
-        return 0;
-    }
-    for (i = 1; i < n; i++) {
-        ip++;
-        /*
-        * Propagate nans, similarly as max() and min()
-        */
-        if (*ip > mp) {  /* negated, for correct nan handling */
-            mp = *ip;
-            *max_ind = (float)i;
-            if (isnanf(mp)) {
-                /* nan encountered, it's maximal */
-                break;
-            }
-        }
-    }
-    return 0;
-}
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
-static int
-float_argmin(float *ip, int n, float *min_ind)
-{
-    int i;
-    float mp = *ip;
-    *min_ind = 0;
-    if (isnanf(mp)) {
-        /* nan encountered; it's minimal */
-        return 0;
-    }
-
-    for (i = 1; i < n; i++) {
-        ip++;
-
-        if (!_LESS_THAN_OR_EQUAL(mp, *ip)) {
-            mp = *ip;
-            *min_ind = (float)i;
-            if (isnanf(mp)) {
-                break;
-            }
-        }
-    }
-    return 0;
-}
+/* Element count from which scans are spread over threads */
+#define NDARRAY_SCAN_PARALLEL_MIN 65536
+/* Columns handled together when a scan runs along an outer axis */
+#define NDARRAY_SCAN_BLOCK 4096
 
 /**
  * ArgMin and ArgMax common function
@@ -80,7 +39,7 @@ NDArray_ArgMinMaxCommon(NDArray *op, int axis, bool keepdims, bool is_argmax) {
     NDArray *ap = NULL, *rp = NULL;
     NDArray_ArgFunc* arg_func = NULL;
     char *ip, *func_name;
-    float *rptr;
+    int64_t *rptr;
     int i, n, m;
     int elsize;
     // Keep a copy because axis changes via call to NDArray_CheckAxis
@@ -127,7 +86,7 @@ NDArray_ArgMinMaxCommon(NDArray *op, int axis, bool keepdims, bool is_argmax) {
         return NULL;
     }
 
-    ap = NDArray_FromNDArray(op, 0, NULL, NULL, NULL);
+    ap = NDArray_ToContiguous(op);
 
     NDArray_FREE(op);
     if (ap == NULL) {
@@ -155,15 +114,11 @@ NDArray_ArgMinMaxCommon(NDArray *op, int axis, bool keepdims, bool is_argmax) {
 
     if (is_argmax) {
         func_name = "argmax";
-        if (NDArray_DEVICE(op) == NDARRAY_DEVICE_CPU) {
-            arg_func = float_argmax;
-        }
+        arg_func = NDArray_TypeFuncs(NDArray_TYPE(ap))->argmax;
     }
     else {
         func_name = "argmin";
-        if (NDArray_DEVICE(op) == NDARRAY_DEVICE_CPU) {
-            arg_func = float_argmin;
-        }
+        arg_func = NDArray_TypeFuncs(NDArray_TYPE(ap))->argmin;
     }
 
     elsize = NDArray_ELSIZE(ap);
@@ -173,16 +128,16 @@ NDArray_ArgMinMaxCommon(NDArray *op, int axis, bool keepdims, bool is_argmax) {
         goto fail;
     }
 
-    rp = NDArray_Zeros(out_shape, out_ndim, NDArray_TYPE(ap), NDArray_DEVICE(ap));
+    rp = NDArray_Zeros(out_shape, out_ndim, NDARRAY_TYPE_INT64, NDArray_DEVICE(ap));
 
     if (rp == NULL) {
         goto fail;
     }
 
     n = NDArray_NUMELEMENTS(ap)/m;
-    rptr = (float*)NDArray_DATA(rp);
+    rptr = (int64_t*)NDArray_DATA(rp);
     for (ip = NDArray_DATA(ap), i = 0; i < n; i++, ip += elsize*m) {
-        arg_func((float*)ip, m, rptr);
+        *rptr = arg_func(ip, m);
         rptr += 1;
     }
 
@@ -192,3 +147,486 @@ fail:
     zend_throw_error(NULL, "%s fatal error", func_name);
     return NULL;
 }
+
+typedef enum {
+    NDARRAY_SCAN_SUM,
+    NDARRAY_SCAN_PROD,
+    NDARRAY_SCAN_MAX
+} ndarray_scan_op;
+
+/**
+ * Accumulator used by a scan. Sums and products of integer and bool
+ * inputs accumulate in int64, half precision types go through double.
+ */
+typedef enum {
+    NDARRAY_SCAN_FLOAT32,
+    NDARRAY_SCAN_FLOAT64,
+    NDARRAY_SCAN_INT64,
+    NDARRAY_SCAN_GENERIC
+} ndarray_scan_mode;
+
+typedef struct {
+    ndarray_scan_op op;
+    ndarray_scan_mode mode;
+    const NDArrayTypeFuncs *in;
+    const NDArrayTypeFuncs *out;
+} ndarray_scan;
+
+/**
+ * Lanes of `a` along `axis`. The array is viewed as outer x length x
+ * inner, lane r starts at `offsets[r]` bytes and advances `stride` bytes
+ * per step. `offsets` is only filled for arrays that aren't C contiguous.
+ */
+typedef struct {
+    NDArray *source;
+    long outer;
+    long length;
+    long inner;
+    long stride;
+    long *offsets;
+} ndarray_lanes;
+
+/**
+ * @return 0 on success, -1 with an exception thrown otherwise
+ */
+static int
+ndarray_lanes_init(NDArray *a, int axis, ndarray_lanes *lanes) {
+    int d, coords[NDARRAY_MAX_DIMS] = {0}, ndim = NDArray_NDIM(a);
+    long r, nlanes;
+
+    if (NDArray_DEVICE(a) == NDARRAY_DEVICE_GPU) {
+        zend_throw_error(NULL, "GPU not supported.");
+        return -1;
+    }
+    lanes->source = a;
+    lanes->offsets = NULL;
+    if (axis == NDARRAY_MAX_DIMS || ndim == 0) {
+        if (!NDArray_IsContiguous(a)) {
+            lanes->source = NDArray_ToContiguous(a);
+        }
+        lanes->outer = 1;
+        lanes->inner = 1;
+        lanes->length = NDArray_NUMELEMENTS(a);
+        lanes->stride = NDArray_ELSIZE(a);
+        return 0;
+    }
+    if (axis < -ndim || axis >= ndim) {
+        zend_throw_error(NULL, "Axis is out of bounds for array dimension");
+        return -1;
+    }
+    if (axis < 0) {
+        axis += ndim;
+    }
+    lanes->outer = 1;
+    lanes->inner = 1;
+    for (d = 0; d < ndim; d++) {
+        if (d < axis) {
+            lanes->outer *= NDArray_SHAPE(a)[d];
+        } else if (d > axis) {
+            lanes->inner *= NDArray_SHAPE(a)[d];
+        }
+    }
+    lanes->length = NDArray_SHAPE(a)[axis];
+    lanes->stride = NDArray_STRIDES(a)[axis];
+    if (NDArray_IsContiguous(a)) {
+        return 0;
+    }
+    // Follow the strides of every other dimension in C order
+    nlanes = lanes->outer * lanes->inner;
+    lanes->offsets = emalloc(sizeof(long) * (nlanes > 0 ? nlanes : 1));
+    for (r = 0; r < nlanes; r++) {
+        long offset = 0;
+        for (d = 0; d < ndim; d++) {
+            offset += (long) coords[d] * NDArray_STRIDES(a)[d];
+        }
+        lanes->offsets[r] = offset;
+        for (d = ndim - 1; d >= 0; d--) {
+            if (d == axis) {
+                continue;
+            }
+            if (++coords[d] < NDArray_SHAPE(a)[d]) {
+                break;
+            }
+            coords[d] = 0;
+        }
+    }
+    return 0;
+}
+
+static void
+ndarray_lanes_free(NDArray *a, ndarray_lanes *lanes) {
+    if (lanes->offsets != NULL) {
+        efree(lanes->offsets);
+    }
+    if (lanes->source != a) {
+        NDArray_FREE(lanes->source);
+    }
+}
+
+/**
+ * Byte offset of the first element of lane r in the source
+ */
+static inline long
+ndarray_lane_offset(const ndarray_lanes *lanes, long r) {
+    if (lanes->offsets != NULL) {
+        return lanes->offsets[r];
+    }
+    return ((r / lanes->inner) * lanes->length * lanes->inner + r % lanes->inner) * NDArray_ELSIZE(lanes->source);
+}
+
+/**
+ * C contiguous output shaped like `a` with `length` elements along `axis`
+ */
+static NDArray*
+ndarray_lanes_output(NDArray *a, int axis, const char *type, long length) {
+    int *shape, ndim = NDArray_NDIM(a), i;
+    if (axis == NDARRAY_MAX_DIMS || ndim == 0) {
+        shape = emalloc(sizeof(int));
+        shape[0] = (int) length;
+        return NDArray_Empty(shape, 1, type, NDARRAY_DEVICE_CPU);
+    }
+    if (axis < 0) {
+        axis += ndim;
+    }
+    shape = emalloc(sizeof(int) * ndim);
+    for (i = 0; i < ndim; i++) {
+        shape[i] = i == axis ? (int) length : NDArray_SHAPE(a)[i];
+    }
+    return NDArray_Empty(shape, ndim, type, NDARRAY_DEVICE_CPU);
+}
+
+static inline void
+ndarray_scan_first(const ndarray_scan *s, const char *in, char *out) {
+    if (s->op == NDARRAY_SCAN_MAX || s->mode == NDARRAY_SCAN_FLOAT32 || s->mode == NDARRAY_SCAN_FLOAT64) {
+        memcpy(out, in, s->out->elsize);
+    } else if (s->mode == NDARRAY_SCAN_INT64) {
+        *(int64_t *) out = s->in->getlong(in);
+    } else {
+        s->out->setitem(out, s->in->getitem(in));
+    }
+}
+
+/**
+ * out = op(prev, in), where prev and out have the output type and `in`
+ * is read with `in_funcs`
+ */
+static inline void
+ndarray_scan_step(const ndarray_scan *s, const NDArrayTypeFuncs *in_funcs, const char *prev, const char *in, char *out) {
+    if (s->op == NDARRAY_SCAN_MAX) {
+        int take_in;
+        if (in_funcs->kind == NDARRAY_KIND_FLOAT) {
+            double p = s->out->getitem(prev), v = in_funcs->getitem(in);
+            // NaN propagates to the rest of the lane
+            take_in = p == p && (v != v || v > p);
+        } else {
+            take_in = in_funcs->getlong(in) > s->out->getlong(prev);
+        }
+        memmove(out, take_in ? in : prev, s->out->elsize);
+        return;
+    }
+    switch (s->mode) {
+        case NDARRAY_SCAN_FLOAT32: {
+            float p = *(const float *) prev, v = *(const float *) in;
+            *(float *) out = s->op == NDARRAY_SCAN_SUM ? p + v : p * v;
+            break;
+        }
+        case NDARRAY_SCAN_FLOAT64: {
+            double p = *(const double *) prev, v = *(const double *) in;
+            *(double *) out = s->op == NDARRAY_SCAN_SUM ? p + v : p * v;
+            break;
+        }
+        case NDARRAY_SCAN_INT64: {
+            // Unsigned arithmetic wraps on overflow instead of being undefined
+            uint64_t p = (uint64_t) *(const int64_t *) prev, v = (uint64_t) in_funcs->getlong(in);
+            *(int64_t *) out = (int64_t) (s->op == NDARRAY_SCAN_SUM ? p + v : p * v);
+            break;
+        }
+        default: {
+            double p = s->out->getitem(prev), v = in_funcs->getitem(in);
+            s->out->setitem(out, s->op == NDARRAY_SCAN_SUM ? p + v : p * v);
+        }
+    }
+}
+
+/**
+ * Sequential scan of one strided lane. Float sums and products keep the
+ * running value in a register.
+ */
+static void
+ndarray_scan_lane(const ndarray_scan *s, const char *in, long in_stride, char *out, long out_stride, long n) {
+    long i;
+    if (n <= 0) {
+        return;
+    }
+    if (s->op != NDARRAY_SCAN_MAX && s->mode == NDARRAY_SCAN_FLOAT32) {
+        float acc = *(const float *) in;
+        *(float *) out = acc;
+        for (i = 1; i < n; i++) {
+            float v = *(const float *) (in + i * in_stride);
+            acc = s->op == NDARRAY_SCAN_SUM ? acc + v : acc * v;
+            *(float *) (out + i * out_stride) = acc;
+        }
+        return;
+    }
+    if (s->op != NDARRAY_SCAN_MAX && s->mode == NDARRAY_SCAN_FLOAT64) {
+        double acc = *(const double *) in;
+        *(double *) out = acc;
+        for (i = 1; i < n; i++) {
+            double v = *(const double *) (in + i * in_stride);
+            acc = s->op == NDARRAY_SCAN_SUM ? acc + v : acc * v;
+            *(double *) (out + i * out_stride) = acc;
+        }
+        return;
+    }
+    ndarray_scan_first(s, in, out);
+    for (i = 1; i < n; i++) {
+        ndarray_scan_step(s, s->in, out + (i - 1) * out_stride, in + i * in_stride, out + i * out_stride);
+    }
+}
+
+/**
+ * Blocked two pass scan of one long contiguous output lane: every
+ * thread scans its own block, then the carried value of the preceding
+ * blocks is folded into each block in parallel.
+ */
+static void
+ndarray_scan_lane_parallel(const ndarray_scan *s, const char *in, long in_stride, char *out, long n) {
+#ifdef _OPENMP
+    int nblocks = omp_get_max_threads(), b;
+    long width, elsize = s->out->elsize;
+    char *carry;
+
+    if (nblocks < 2 || n < NDARRAY_SCAN_PARALLEL_MIN) {
+        ndarray_scan_lane(s, in, in_stride, out, elsize, n);
+        return;
+    }
+    width = (n + nblocks - 1) / nblocks;
+    nblocks = (int) ((n + width - 1) / width);
+    carry = emalloc(elsize * nblocks);
+#pragma omp parallel for
+    for (b = 0; b < nblocks; b++) {
+        long start = b * width, end = start + width < n ? start + width : n;
+        ndarray_scan_lane(s, in + start * in_stride, in_stride, out + start * elsize, elsize, end - start);
+    }
+    // carry[b] is the scan value just before block b
+    memcpy(carry + elsize, out + (width - 1) * elsize, elsize);
+    for (b = 2; b < nblocks; b++) {
+        ndarray_scan_step(s, s->out, carry + (b - 1) * elsize, out + (b * width - 1) * elsize, carry + b * elsize);
+    }
+#pragma omp parallel for
+    for (b = 1; b < nblocks; b++) {
+        long i, start = b * width, end = start + width < n ? start + width : n;
+        for (i = start; i < end; i++) {
+            ndarray_scan_step(s, s->out, carry + b * elsize, out + i * elsize, out + i * elsize);
+        }
+    }
+    efree(carry);
+#else
+    ndarray_scan_lane(s, in, in_stride, out, s->out->elsize, n);
+#endif
+}
+
+/**
+ * Shared body of the cumulative operations
+ */
+static NDArray*
+ndarray_scan_common(NDArray *a, int axis, ndarray_scan_op op) {
+    ndarray_lanes lanes;
+    ndarray_scan s;
+    NDArray *rtn;
+    NDArray_BinaryLoop loop = NULL;
+    const char *out_type = NDArray_TYPE(a);
+    long r, nlanes, elsize;
+
+    s.op = op;
+    s.in = NDArray_TypeFuncs(NDArray_TYPE(a));
+    if (s.in == NULL) {
+        zend_throw_error(NULL, "Cumulative operations not supported for dtype %s.", NDArray_TYPE(a));
+        return NULL;
+    }
+    if (op != NDARRAY_SCAN_MAX && s.in->kind != NDARRAY_KIND_FLOAT) {
+        out_type = NDARRAY_TYPE_INT64;
+    }
+    s.out = NDArray_TypeFuncs(out_type);
+    if (is_type(out_type, NDARRAY_TYPE_FLOAT32)) {
+        s.mode = NDARRAY_SCAN_FLOAT32;
+    } else if (is_type(out_type, NDARRAY_TYPE_DOUBLE64)) {
+        s.mode = NDARRAY_SCAN_FLOAT64;
+    } else if (is_type(out_type, NDARRAY_TYPE_INT64)) {
+        s.mode = NDARRAY_SCAN_INT64;
+    } else {
+        s.mode = NDARRAY_SCAN_GENERIC;
+    }
+    if (ndarray_lanes_init(a, axis, &lanes) < 0) {
+        return NULL;
+    }
+    rtn = ndarray_lanes_output(a, axis, out_type, lanes.length);
+    nlanes = lanes.outer * lanes.inner;
+    elsize = s.out->elsize;
+
+    if (lanes.offsets == NULL && lanes.inner > 1) {
+        // Scan along an outer axis: whole rows of `inner` elements are
+        // combined at once, with the dtype loop when input and output match
+        long nblocks = (lanes.inner + NDARRAY_SCAN_BLOCK - 1) / NDARRAY_SCAN_BLOCK, t;
+        long row = lanes.inner * s.in->elsize, out_row = lanes.inner * elsize;
+        if (op != NDARRAY_SCAN_MAX && is_type(out_type, NDArray_TYPE(a))) {
+            loop = op == NDARRAY_SCAN_SUM ? s.out->add : s.out->multiply;
+        }
+#pragma omp parallel for if (lanes.outer * nblocks > 1 && nlanes * lanes.length >= NDARRAY_SCAN_PARALLEL_MIN)
+        for (t = 0; t < lanes.outer * nblocks; t++) {
+            long o = t / nblocks, j0 = (t % nblocks) * NDARRAY_SCAN_BLOCK, j, k;
+            long m = lanes.inner - j0 < NDARRAY_SCAN_BLOCK ? lanes.inner - j0 : NDARRAY_SCAN_BLOCK;
+            const char *in = NDArray_DATA(lanes.source) + o * lanes.length * row + j0 * s.in->elsize;
+            char *out = NDArray_DATA(rtn) + o * lanes.length * out_row + j0 * elsize;
+            for (j = 0; j < m && lanes.length > 0; j++) {
+                ndarray_scan_first(&s, in + j * s.in->elsize, out + j * elsize);
+            }
+            for (k = 1; k < lanes.length; k++) {
+                const char *in_k = in + k * row;
+                char *prev = out + (k - 1) * out_row, *out_k = out + k * out_row;
+                if (loop != NULL) {
+                    loop(prev, elsize, in_k, elsize, out_k, elsize, m);
+                    continue;
+                }
+                for (j = 0; j < m; j++) {
+                    ndarray_scan_step(&s, s.in, prev + j * elsize, in_k + j * s.in->elsize, out_k + j * elsize);
+                }
+            }
+        }
+    } else if (nlanes == 1) {
+        ndarray_scan_lane_parallel(&s, NDArray_DATA(lanes.source) + ndarray_lane_offset(&lanes, 0),
+                                   lanes.stride, NDArray_DATA(rtn), lanes.length);
+    } else {
+        long out_stride = lanes.inner * elsize;
+#pragma omp parallel for if (nlanes * lanes.length >= NDARRAY_SCAN_PARALLEL_MIN)
+        for (r = 0; r < nlanes; r++) {
+            long out_offset = ((r / lanes.inner) * lanes.length * lanes.inner + r % lanes.inner) * elsize;
+            ndarray_scan_lane(&s, NDArray_DATA(lanes.source) + ndarray_lane_offset(&lanes, r), lanes.stride,
+                              NDArray_DATA(rtn) + out_offset, out_stride, lanes.length);
+        }
+    }
+
+    ndarray_lanes_free(a, &lanes);
+    return rtn;
+}
+
+/**
+ * Cumulative sum along `axis`. Integer and bool inputs produce int64.
+ *
+ * @param a
+ * @param axis NDARRAY_MAX_DIMS scans the flattened array
+ * @return
+ */
+NDArray*
+NDArray_CumSum(NDArray *a, int axis) {
+    return ndarray_scan_common(a, axis, NDARRAY_SCAN_SUM);
+}
+
+/**
+ * Cumulative product along `axis`. Integer and bool inputs produce int64.
+ *
+ * @param a
+ * @param axis NDARRAY_MAX_DIMS scans the flattened array
+ * @return
+ */
+NDArray*
+NDArray_CumProd(NDArray *a, int axis) {
+    return ndarray_scan_common(a, axis, NDARRAY_SCAN_PROD);
+}
+
+/**
+ * Running maximum along `axis`, NaN propagates
+ *
+ * @param a
+ * @param axis NDARRAY_MAX_DIMS scans the flattened array
+ * @return
+ */
+NDArray*
+NDArray_CumMax(NDArray *a, int axis) {
+    return ndarray_scan_common(a, axis, NDARRAY_SCAN_MAX);
+}
+
+/**
+ * One first order difference along `axis`
+ */
+static NDArray*
+ndarray_diff_once(NDArray *a, int axis) {
+    ndarray_lanes lanes;
+    NDArray *rtn;
+    NDArray_BinaryLoop loop;
+    const NDArrayTypeFuncs *funcs = NDArray_TypeFuncs(NDArray_TYPE(a));
+    long r, nlanes, elsize, n;
+
+    if (funcs == NULL) {
+        zend_throw_error(NULL, "diff not supported for dtype %s.", NDArray_TYPE(a));
+        return NULL;
+    }
+    // Booleans differ where neighbours are not equal
+    loop = funcs->kind == NDARRAY_KIND_BOOL ? funcs->not_equal : funcs->subtract;
+    if (ndarray_lanes_init(a, axis, &lanes) < 0) {
+        return NULL;
+    }
+    n = lanes.length > 0 ? lanes.length - 1 : 0;
+    rtn = ndarray_lanes_output(a, axis, NDArray_TYPE(a), n);
+    nlanes = lanes.outer * lanes.inner;
+    elsize = funcs->elsize;
+
+    if (lanes.offsets == NULL && lanes.inner > 1) {
+        // Subtract whole contiguous rows of `inner` elements
+        long row = lanes.inner * elsize, t;
+#pragma omp parallel for if (lanes.outer * n * lanes.inner >= NDARRAY_SCAN_PARALLEL_MIN)
+        for (t = 0; t < lanes.outer * n; t++) {
+            long o = t / n, k = t % n;
+            const char *in = NDArray_DATA(lanes.source) + (o * lanes.length + k) * row;
+            loop(in + row, elsize, in, elsize, NDArray_DATA(rtn) + (o * n + k) * row, elsize, lanes.inner);
+        }
+    } else {
+        long out_stride = lanes.inner * elsize;
+#pragma omp parallel for if (nlanes > 1 && nlanes * n >= NDARRAY_SCAN_PARALLEL_MIN)
+        for (r = 0; r < nlanes; r++) {
+            const char *in = NDArray_DATA(lanes.source) + ndarray_lane_offset(&lanes, r);
+            long out_offset = ((r / lanes.inner) * n * lanes.inner + r % lanes.inner) * elsize;
+            loop(in + lanes.stride, lanes.stride, in, lanes.stride, NDArray_DATA(rtn) + out_offset, out_stride, n);
+        }
+    }
+
+    ndarray_lanes_free(a, &lanes);
+    return rtn;
+}
+
+/**
+ * n-th discrete difference along `axis`, out[i] = a[i + 1] - a[i]
+ * applied `n` times. The axis shrinks by one per order.
+ *
+ * @param a
+ * @param n
+ * @param axis NDARRAY_MAX_DIMS differences the flattened array
+ * @return
+ */
+NDArray*
+NDArray_Diff(NDArray *a, int n, int axis) {
+    NDArray *current = a, *next;
+    int i;
+    if (n < 0) {
+        zend_throw_error(NULL, "order must be non-negative but got %d", n);
+        return NULL;
+    }
+    if (n == 0) {
+        return NDArray_Copy(a, NDArray_DEVICE(a));
+    }
+    for (i = 0; i < n; i++) {
+        next = ndarray_diff_once(current, axis);
+        if (current != a) {
+            NDArray_FREE(current);
+        }
+        if (next == NULL) {
+            return NULL;
+        }
+        current = next;
+        // Later orders run on the 1-D result of a flattened difference
+        if (axis == NDARRAY_MAX_DIMS) {
+            axis = 0;
+        }
+    }
+    return current;
+}
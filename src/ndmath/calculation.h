@@ -3,10 +3,14 @@
 
 #include "../ndarray.h"
 
-typedef int (NDArray_ArgFunc)(float*, int, float *);
+typedef long (NDArray_ArgFunc)(const char*, long);
 
 #define _LESS_THAN_OR_EQUAL(a,b) ((a) <= (b))
 
 NDArray * NDArray_ArgMinMaxCommon(NDArray *op, int axis, bool keepdims, bool is_argmax);
+NDArray * NDArray_CumSum(NDArray *a, int axis);
+NDArray * NDArray_CumProd(NDArray *a, int axis);
+NDArray * NDArray_CumMax(NDArray *a, int axis);
+NDArray * NDArray_Diff(NDArray *a, int n, int axis);
 
 #endif //NUMPOWER_CALCULATION_H
@@ -172,62 +172,6 @@ __global__ void transposeCoalesced(const float* matIn, int height, int width, fl
 }
 
 
-// CUDA kernel for LU decomposition
-__global__ void luFloatDecompositionKernel(float *matrix, float *L, float *U, float *P, int size) {
-    int i, k, maxIndex;
-    float maxVal, tempVal;
-
-    int row = blockIdx.y * blockDim.y + threadIdx.y;
-    int col = blockIdx.x * blockDim.x + threadIdx.x;
-
-    if (row < size && col < size) {
-        // Initialize L, U, and P matrices
-        if (row == col) {
-            L[row * size + col] = 1.0f;
-            U[row * size + col] = matrix[row * size + col];
-        } else {
-            L[row * size + col] = 0.0f;
-            U[row * size + col] = matrix[row * size + col];
-        }
-        P[row * size + col] = (row == col) ? 1.0f : 0.0f;
-
-        // Perform LU decomposition with partial pivoting
-        for (k = 0; k < size - 1; k++) {
-            maxIndex = k;
-            maxVal = U[k * size + k];
-
-            // Find the row with the maximum value in the current column
-            for (i = k + 1; i < size; i++) {
-                if (U[i * size + k] > maxVal) {
-                    maxIndex = i;
-                    maxVal = U[i * size + k];
-                }
-            }
-
-            // Swap rows in U matrix
-            if (maxIndex != k) {
-                tempVal = U[k * size + col];
-                U[k * size + col] = U[maxIndex * size + col];
-                U[maxIndex * size + col] = tempVal;
-
-                tempVal = P[k * size + col];
-                P[k * size + col] = P[maxIndex * size + col];
-                P[maxIndex * size + col] = tempVal;
-            }
-
-            __syncthreads();
-
-            // Perform elimination in U matrix and store multipliers in L matrix
-            if (row > k && col >= k) {
-                L[row * size + k] = U[row * size + k] / U[k * size + k];
-                U[row * size + col] -= L[row * size + k] * U[k * size + col];
-            }
-
-            __syncthreads();
-        }
-    }
-}
-
 __global__ void roundToDecimalsFloatKernel(float* numbers, int decimals, int size) {
     int tid = blockIdx.x * blockDim.x + threadIdx.x;
 
@@ -1581,15 +1525,6 @@ extern "C" {
         return rtn;
     }
 
-    void
-    cuda_float_lu(float *matrix, float *L, float *U, float *P, int size) {
-        int BLOCK_SIZE = 16;
-        dim3 gridSize((size + BLOCK_SIZE - 1) / BLOCK_SIZE, (size + BLOCK_SIZE - 1) / BLOCK_SIZE);
-        dim3 blockSize(BLOCK_SIZE, BLOCK_SIZE);
-
-        luFloatDecompositionKernel<<<gridSize, blockSize>>>(matrix, L, U, P, size);
-    }
-
     void
     cuda_matrix_float_l1norm(float *target, float *rtn, int rows, int cols) {
         int threadsPerBlock = 256;
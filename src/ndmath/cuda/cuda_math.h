@@ -62,7 +62,6 @@ void cuda_float_clip(int nblocks, float *d_array, float minVal, float maxVal);
 void cuda_float_multiply_matrix_vector(int nblocks, float *a_array, float *b_array, float *result, int rows, int cols);
 void cuda_float_compare_equal(int nblocks, float *a_array, float *b_array, float *result, int n);
 void cuda_matrix_float_inverse(float* matrix, int n);
-void cuda_float_lu(float *matrix, float *L, float *U, float *P, int size);
 void cuda_prod_float(int nblocks, float *a, float *rtn, int nelements);
 void cuda_float_round(int nblocks, float *d_array, float decimals);
 void cuda_calculate_outer_product(int m, int n, float *a_array, float *b_array, float *r_array);
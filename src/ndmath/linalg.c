@@ -1,4 +1,6 @@
 #include <php.h>
+#include <math.h>
+#include <float.h>
 #include "Zend/zend_alloc.h"
 #include "Zend/zend_API.h"
 #include "linalg.h"
@@ -30,12 +32,43 @@
 #include "../gpu_alloc.h"
 #endif
 
-#ifdef HAVE_AVX2
-#include <immintrin.h>
+#ifdef _OPENMP
+#include <omp.h>
 #endif
 
 /**
- * Double type (float64) matmul
+ * Contiguous CPU operand of a LAPACK/BLAS kernel: `a` itself when it
+ * already is a contiguous float64 (is_double) or float32 array, a
+ * converted copy otherwise
+ */
+static NDArray*
+ndarray_linalg_operand(NDArray *a, int is_double) {
+    const char *type = is_double ? NDARRAY_TYPE_DOUBLE64 : NDARRAY_TYPE_FLOAT32;
+
+    if (is_type(NDArray_TYPE(a), type) && NDArray_IsContiguous(a)) {
+        return a;
+    }
+    return NDArray_AsType(a, type);
+}
+
+static void
+ndarray_linalg_release(NDArray *operand, NDArray *a) {
+    if (operand != NULL && operand != a) {
+        NDArray_FREE(operand);
+    }
+}
+
+/**
+ * @return 1 when any operand is float64, the kernels then run in double
+ */
+static inline int
+ndarray_linalg_is_double(NDArray *a, NDArray *b) {
+    return is_type(NDArray_TYPE(a), NDARRAY_TYPE_DOUBLE64) ||
+           (b != NULL && is_type(NDArray_TYPE(b), NDARRAY_TYPE_DOUBLE64));
+}
+
+/**
+ * Float type (float32) matmul, other CPU dtypes are converted first
  *
  * @param a
  * @param b
@@ -72,30 +105,164 @@ NDArray_FMatmul(NDArray *a, NDArray *b) {
 #endif
     } else {
         // Perform CPU matrix multiplication
+        NDArray *a_op = ndarray_linalg_operand(a, 0), *b_op = ndarray_linalg_operand(b, 0);
+        if (a_op == NULL || b_op == NULL) {
+            ndarray_linalg_release(a_op, a);
+            ndarray_linalg_release(b_op, b);
+            NDArray_FREE(result);
+            return NULL;
+        }
         cblas_sgemm(CblasRowMajor, CblasNoTrans, CblasNoTrans,
                     NDArray_SHAPE(a)[0], NDArray_SHAPE(b)[1], NDArray_SHAPE(a)[1],
-                    1.0f, NDArray_FDATA(a), NDArray_SHAPE(a)[1],
-                    NDArray_FDATA(b), NDArray_SHAPE(b)[1],
+                    1.0f, NDArray_FDATA(a_op), NDArray_SHAPE(a)[1],
+                    NDArray_FDATA(b_op), NDArray_SHAPE(b)[1],
                     0.0f, NDArray_FDATA(result), NDArray_SHAPE(b)[1]);
+        ndarray_linalg_release(a_op, a);
+        ndarray_linalg_release(b_op, b);
     }
     return result;
 }
 
-void
-computeSVDFloat(float* A, int m, int n, float* U, float* S, float* V) {
-    int lda = n;
-    int ldu = m;
-    int ldvt = n;
+/**
+ * Double type (float64) matmul
+ *
+ * @param a
+ * @param b
+ * @return
+ */
+NDArray*
+NDArray_DMatmul(NDArray *a, NDArray *b) {
+    NDArray *a_cast = NDArray_AsType(a, NDARRAY_TYPE_DOUBLE64);
+    NDArray *b_cast = NDArray_AsType(b, NDARRAY_TYPE_DOUBLE64);
+    NDArray *result;
+    int *output_shape;
+
+    if (a_cast == NULL || b_cast == NULL) {
+        NDArray_FREE(a_cast);
+        NDArray_FREE(b_cast);
+        return NULL;
+    }
+    output_shape = emalloc(sizeof(int) * 2);
+    output_shape[0] = NDArray_SHAPE(a)[0];
+    output_shape[1] = NDArray_SHAPE(b)[1];
+    result = NDArray_Zeros(output_shape, 2, NDARRAY_TYPE_DOUBLE64, NDARRAY_DEVICE_CPU);
+
+    cblas_dgemm(CblasRowMajor, CblasNoTrans, CblasNoTrans,
+                NDArray_SHAPE(a)[0], NDArray_SHAPE(b)[1], NDArray_SHAPE(a)[1],
+                1.0, NDArray_DDATA(a_cast), NDArray_SHAPE(a)[1],
+                NDArray_DDATA(b_cast), NDArray_SHAPE(b)[1],
+                0.0, NDArray_DDATA(result), NDArray_SHAPE(b)[1]);
+    NDArray_FREE(a_cast);
+    NDArray_FREE(b_cast);
+    return result;
+}
 
-    int info;
+/**
+ * Columns of `a` (rows of `b`) converted to float32 per panel in
+ * ndarray_tiled_sgemm
+ */
+#define NDARRAY_GEMM_PANEL 256
 
-    info = LAPACKE_sgesdd(LAPACK_ROW_MAJOR, 'S', m, n, A, lda, S, U, ldu, V, ldvt);
+/**
+ * Rows and columns of the output computed per tile in ndarray_tiled_sgemm
+ */
+#define NDARRAY_GEMM_TILE 128
 
-    if (info > 0) {
-        printf("SVD computation failed.\n");
-        return;
+/**
+ * @param type
+ * @return 1 if `type` is a half precision storage type
+ */
+static int
+ndarray_is_half(const char *type) {
+    return is_type(type, NDARRAY_TYPE_FLOAT16) || is_type(type, NDARRAY_TYPE_BFLOAT16);
+}
+
+/**
+ * c = a * b for row-major contiguous `a` (m x k), `b` (k x n) and `c` (m x n)
+ * of any dtype
+ *
+ * `c` is computed one NDARRAY_GEMM_TILE square tile at a time. Panels of
+ * NDARRAY_GEMM_PANEL columns of `a` and rows of `b` are converted to float32
+ * and accumulated into the tile with sgemm, then the tile is converted to the
+ * dtype of `c`. The float32 scratch doesn't grow with the operands, so half
+ * precision inputs never need a float32 copy.
+ */
+static void
+ndarray_tiled_sgemm(const char *a, const NDArrayTypeFuncs *a_funcs, const char *b, const NDArrayTypeFuncs *b_funcs,
+                    char *c, const NDArrayTypeFuncs *c_funcs, int m, int n, int k) {
+    int m0, n0, k0, mc, nc, kc, i;
+    float *a_panel = emalloc(sizeof(float) * NDARRAY_GEMM_TILE * NDARRAY_GEMM_PANEL);
+    float *b_panel = emalloc(sizeof(float) * NDARRAY_GEMM_PANEL * NDARRAY_GEMM_TILE);
+    float *c_tile = emalloc(sizeof(float) * NDARRAY_GEMM_TILE * NDARRAY_GEMM_TILE);
+
+    for (m0 = 0; m0 < m; m0 += mc) {
+        mc = m - m0 < NDARRAY_GEMM_TILE ? m - m0 : NDARRAY_GEMM_TILE;
+        for (n0 = 0; n0 < n; n0 += nc) {
+            nc = n - n0 < NDARRAY_GEMM_TILE ? n - n0 : NDARRAY_GEMM_TILE;
+            memset(c_tile, 0, sizeof(float) * mc * nc);
+            for (k0 = 0; k0 < k; k0 += kc) {
+                kc = k - k0 < NDARRAY_GEMM_PANEL ? k - k0 : NDARRAY_GEMM_PANEL;
+                for (i = 0; i < mc; i++) {
+                    a_funcs->to_float32(a + ((size_t)(m0 + i) * k + k0) * a_funcs->elsize, a_funcs->elsize,
+                                        a_panel + (size_t)i * kc, kc);
+                }
+                for (i = 0; i < kc; i++) {
+                    b_funcs->to_float32(b + ((size_t)(k0 + i) * n + n0) * b_funcs->elsize, b_funcs->elsize,
+                                        b_panel + (size_t)i * nc, nc);
+                }
+                cblas_sgemm(CblasRowMajor, CblasNoTrans, CblasNoTrans, mc, nc, kc,
+                            1.0f, a_panel, kc, b_panel, nc, 1.0f, c_tile, nc);
+            }
+            for (i = 0; i < mc; i++) {
+                c_funcs->from_float32(c_tile + (size_t)i * nc, c + ((size_t)(m0 + i) * n + n0) * c_funcs->elsize,
+                                      c_funcs->elsize, nc);
+            }
+        }
     }
+    efree(a_panel);
+    efree(b_panel);
+    efree(c_tile);
+}
+
+/**
+ * Matrix product with half precision operands, computed in float32
+ *
+ * @param a
+ * @param b
+ * @param rtn_shape shape of the result, `ndim` entries
+ * @param ndim
+ * @param m
+ * @param n
+ * @param k
+ * @return
+ */
+static NDArray*
+NDArray_HalfGemm(NDArray *a, NDArray *b, int *rtn_shape, int ndim, int m, int n, int k) {
+    const char *type = NDArray_PromoteTypes(NDArray_TYPE(a), NDArray_TYPE(b));
+    NDArray *a_cont = a, *b_cont = b, *rtn;
 
+    if (NDArray_DEVICE(a) == NDARRAY_DEVICE_GPU) {
+        efree(rtn_shape);
+        zend_throw_error(NULL, "%s matmul is only available for NDArrays on CPU RAM.", type);
+        return NULL;
+    }
+    if (!NDArray_IsContiguous(a)) {
+        a_cont = NDArray_ToContiguous(a);
+    }
+    if (!NDArray_IsContiguous(b)) {
+        b_cont = NDArray_ToContiguous(b);
+    }
+    rtn = NDArray_Empty(rtn_shape, ndim, type, NDARRAY_DEVICE_CPU);
+    ndarray_tiled_sgemm(NDArray_DATA(a_cont), NDArray_TypeFuncs(NDArray_TYPE(a_cont)),
+                        NDArray_DATA(b_cont), NDArray_TypeFuncs(NDArray_TYPE(b_cont)),
+                        NDArray_DATA(rtn), NDArray_TypeFuncs(type), m, n, k);
+    if (a_cont != a) {
+        NDArray_FREE(a_cont);
+    }
+    if (b_cont != b) {
+        NDArray_FREE(b_cont);
+    }
+    return rtn;
 }
 
 #ifdef HAVE_CUBLAS
@@ -105,25 +272,85 @@ computeSVDFloatGPU(float* A, int m, int n, float* U, float* S, float* V) {
 }
 #endif
 
+/**
+ * Full SVD of a two-dimensional CPU array through gesdd: U is (m, m),
+ * S holds the min(m, n) singular values and V is (n, n). float64 inputs
+ * use dgesdd, every other dtype is computed in float32.
+ */
+static NDArray**
+ndarray_svd_cpu(NDArray *target) {
+    int is_double = ndarray_linalg_is_double(target, NULL), m, n, info;
+    const char *type = is_double ? NDARRAY_TYPE_DOUBLE64 : NDARRAY_TYPE_FLOAT32;
+    NDArray **rtns, *work;
+    int *u_shape, *s_shape, *v_shape;
+
+    if (NDArray_NDIM(target) != 2) {
+        zend_throw_error(NULL, "Array must be two-dimensional");
+        return NULL;
+    }
+    m = NDArray_SHAPE(target)[0];
+    n = NDArray_SHAPE(target)[1];
+    // gesdd overwrites its input
+    work = NDArray_AsType(target, type);
+    if (work == NULL) {
+        return NULL;
+    }
+    u_shape = emalloc(sizeof(int) * 2);
+    s_shape = emalloc(sizeof(int));
+    v_shape = emalloc(sizeof(int) * 2);
+    u_shape[0] = u_shape[1] = m;
+    s_shape[0] = m < n ? m : n;
+    v_shape[0] = v_shape[1] = n;
+    rtns = emalloc(sizeof(NDArray*) * 3);
+    rtns[0] = NDArray_Empty(u_shape, 2, type, NDARRAY_DEVICE_CPU);
+    rtns[1] = NDArray_Empty(s_shape, 1, type, NDARRAY_DEVICE_CPU);
+    rtns[2] = NDArray_Empty(v_shape, 2, type, NDARRAY_DEVICE_CPU);
+    if (is_double) {
+        info = LAPACKE_dgesdd(LAPACK_ROW_MAJOR, 'A', m, n, NDArray_DDATA(work), n > 1 ? n : 1,
+                              NDArray_DDATA(rtns[1]), NDArray_DDATA(rtns[0]), m > 1 ? m : 1,
+                              NDArray_DDATA(rtns[2]), n > 1 ? n : 1);
+    } else {
+        info = LAPACKE_sgesdd(LAPACK_ROW_MAJOR, 'A', m, n, NDArray_FDATA(work), n > 1 ? n : 1,
+                              NDArray_FDATA(rtns[1]), NDArray_FDATA(rtns[0]), m > 1 ? m : 1,
+                              NDArray_FDATA(rtns[2]), n > 1 ? n : 1);
+    }
+    NDArray_FREE(work);
+    if (info != 0) {
+        NDArray_FREE(rtns[0]);
+        NDArray_FREE(rtns[1]);
+        NDArray_FREE(rtns[2]);
+        efree(rtns);
+        zend_throw_error(NULL, "SVD computation did not converge.");
+        return NULL;
+    }
+    return rtns;
+}
+
 /**
  * @return
  */
 NDArray**
 NDArray_SVD(NDArray *target) {
+    if (NDArray_NDIM(target) == 1) {
+        zend_throw_error(NULL, "Array must be at least two-dimensional");
+        return NULL;
+    }
+    if (NDArray_DEVICE(target) == NDARRAY_DEVICE_CPU) {
+        return ndarray_svd_cpu(target);
+    }
+    if (!is_type(NDArray_TYPE(target), NDARRAY_TYPE_FLOAT32)) {
+        zend_throw_error(NULL, "svd is only available for float32 NDArrays on the GPU.");
+        return NULL;
+    }
+#ifdef HAVE_CUBLAS
     NDArray **rtns;
     NDArray *target_ptr = target;
     NDArray *rtn_s, *rtn_u, *rtn_v;
-    double *U, *S, *V;
     float *output_data;
     float  *Uf, *Sf, *Vf;
     int *U_shape, *S_shape, *V_shape;
     int smallest_dim = -1;
 
-    if (NDArray_NDIM(target) == 1) {
-        zend_throw_error(NULL, "Array must be at least two-dimensional");
-        return NULL;
-    }
-
     rtns = emalloc(sizeof(NDArray*) * 3);
 
     for (int i = 0; i < NDArray_NDIM(target_ptr); i++) {
@@ -135,39 +362,15 @@ NDArray_SVD(NDArray *target) {
             smallest_dim = NDArray_SHAPE(target_ptr)[i];
         }
     }
-    if(NDArray_DEVICE(target_ptr) == NDARRAY_DEVICE_GPU) {
-#ifdef HAVE_CUBLAS
-        target_ptr = NDArray_Transpose(target, NULL);
-        vmalloc((void**)&Sf, sizeof(float) * smallest_dim);
-        vmalloc((void**)&Uf, sizeof(float) * NDArray_SHAPE(target)[0] * NDArray_SHAPE(target)[0]);
-        vmalloc((void**)&Vf, sizeof(float) * NDArray_SHAPE(target)[1] * NDArray_SHAPE(target)[1]);
-        vmalloc((void**)&output_data, sizeof(float) * NDArray_NUMELEMENTS(target));
-        cudaMemcpy(output_data, NDArray_FDATA(target_ptr), sizeof(float) * NDArray_NUMELEMENTS(target), cudaMemcpyDeviceToDevice);
-        cudaDeviceSynchronize();
-#else
-        return NULL;
-#endif
-    } else {
-        Sf = (float *) emalloc(sizeof(float) * smallest_dim);
-        Uf = (float *) emalloc(sizeof(float) * NDArray_SHAPE(target_ptr)[0] * NDArray_SHAPE(target_ptr)[0]);
-        Vf = (float *) emalloc(sizeof(float) * NDArray_SHAPE(target_ptr)[1] * NDArray_SHAPE(target_ptr)[1]);
-        output_data = emalloc(sizeof(float) * NDArray_NUMELEMENTS(target_ptr));
-        memcpy(output_data, NDArray_FDATA(target_ptr), sizeof(float) * NDArray_NUMELEMENTS(target_ptr));
-    }
-
-    if(NDArray_DEVICE(target_ptr) == NDARRAY_DEVICE_GPU) {
-#ifdef HAVE_CUBLAS
-        computeSVDFloatGPU(output_data, NDArray_SHAPE(target)[0], NDArray_SHAPE(target)[1], Uf, Sf, Vf);
-#else
-        return NULL;
-#endif
-    } else {
-        computeSVDFloat((float *) output_data, NDArray_SHAPE(target_ptr)[0], NDArray_SHAPE(target_ptr)[1], Uf, Sf, Vf);
-    }
+    target_ptr = NDArray_Transpose(target, NULL);
+    vmalloc((void**)&Sf, sizeof(float) * smallest_dim);
+    vmalloc((void**)&Uf, sizeof(float) * NDArray_SHAPE(target)[0] * NDArray_SHAPE(target)[0]);
+    vmalloc((void**)&Vf, sizeof(float) * NDArray_SHAPE(target)[1] * NDArray_SHAPE(target)[1]);
+    vmalloc((void**)&output_data, sizeof(float) * NDArray_NUMELEMENTS(target));
+    cudaMemcpy(output_data, NDArray_FDATA(target_ptr), sizeof(float) * NDArray_NUMELEMENTS(target), cudaMemcpyDeviceToDevice);
+    cudaDeviceSynchronize();
+    computeSVDFloatGPU(output_data, NDArray_SHAPE(target)[0], NDArray_SHAPE(target)[1], Uf, Sf, Vf);
 
-    if(NDArray_DEVICE(target_ptr) == NDARRAY_DEVICE_CPU) {
-        efree(output_data);
-    }
     U_shape = emalloc(sizeof(int) * NDArray_NDIM(target_ptr));
     V_shape = emalloc(sizeof(int) * NDArray_NDIM(target_ptr));
     S_shape = emalloc(sizeof(int));
@@ -182,30 +385,23 @@ NDArray_SVD(NDArray *target) {
     rtn_u = Create_NDArray(U_shape, NDArray_NDIM(target_ptr), NDArray_TYPE(target_ptr), NDArray_DEVICE(target_ptr));
     rtn_s = Create_NDArray(S_shape, 1, NDArray_TYPE(target_ptr), NDArray_DEVICE(target_ptr));
     rtn_v = Create_NDArray(V_shape, NDArray_NDIM(target_ptr), NDArray_TYPE(target_ptr), NDArray_DEVICE(target_ptr));
-
-    if(is_type(NDArray_TYPE(target_ptr), NDARRAY_TYPE_DOUBLE64)) {
-        rtn_u->data = (char *) U;
-        rtn_s->data = (char *) S;
-        rtn_v->data = (char *) V;
-    } else {
-        rtn_u->data = (char *) Uf;
-        rtn_s->data = (char *) Sf;
-        rtn_v->data = (char *) Vf;
-    }
+    rtn_u->data = (char *) Uf;
+    rtn_s->data = (char *) Sf;
+    rtn_v->data = (char *) Vf;
 
     rtns[0] = rtn_u;
     rtns[1] = rtn_s;
     rtns[2] = rtn_v;
 
-    if (NDArray_DEVICE(target_ptr) == NDARRAY_DEVICE_GPU) {
-        rtn_u->device = NDARRAY_DEVICE_GPU;
-        rtn_s->device = NDARRAY_DEVICE_GPU;
-        rtn_v->device = NDARRAY_DEVICE_GPU;
-        vfree(output_data);
-        NDArray_FREE(target_ptr);
-    }
-
+    rtn_u->device = NDARRAY_DEVICE_GPU;
+    rtn_s->device = NDARRAY_DEVICE_GPU;
+    rtn_v->device = NDARRAY_DEVICE_GPU;
+    vfree(output_data);
+    NDArray_FREE(target_ptr);
     return rtns;
+#else
+    return NULL;
+#endif
 }
 
 /**
@@ -241,65 +437,338 @@ NDArray_Matmul(NDArray *a, NDArray *b) {
         zend_throw_error(NULL, "Stack of matrices not allowed");
         return NULL;
     }
+    const char *type = NDArray_PromoteTypes(NDArray_TYPE(a), NDArray_TYPE(b));
+    if (ndarray_is_half(type)) {
+        int *output_shape = emalloc(sizeof(int) * 2);
+        output_shape[0] = NDArray_SHAPE(a)[0];
+        output_shape[1] = NDArray_SHAPE(b)[1];
+        return NDArray_HalfGemm(a, b, output_shape, 2, NDArray_SHAPE(a)[0], NDArray_SHAPE(b)[1], NDArray_SHAPE(a)[1]);
+    }
+    if (!is_type(type, NDARRAY_TYPE_FLOAT32)) {
+        return NDArray_DMatmul(a, b);
+    }
     return NDArray_FMatmul(a, b);
 }
 
+/**
+ * Square matrices up to this order use the closed-form kernels of the
+ * batched routines, larger ones go through LAPACK
+ */
+#define NDARRAY_BATCH_CLOSED_MAX 4
+
+/**
+ * Stacks with at least this many n^3 operations are spread across threads
+ */
+#define NDARRAY_BATCH_PARALLEL_MIN 32768
+
+/**
+ * getri workspace per column, LAPACK's usual block size
+ */
+#define NDARRAY_BATCH_GETRI_BLOCK 64
+
+/**
+ * Stack of `count` square n x n matrices, the trailing two dimensions of
+ * an NDArray, copied into a contiguous CPU buffer of float64 or float32
+ */
+typedef struct ndarray_batch {
+    NDArray *work;
+    long count;
+    int n;
+    int is_double;
+} ndarray_batch;
+
+static inline int
+ndarray_batch_threads(void) {
+#ifdef _OPENMP
+    return omp_get_max_threads();
+#else
+    return 1;
+#endif
+}
+
+static inline int
+ndarray_batch_thread_id(void) {
+#ifdef _OPENMP
+    return omp_get_thread_num();
+#else
+    return 0;
+#endif
+}
+
+/**
+ * @return 0 on success, -1 with an exception thrown otherwise
+ */
+static int
+ndarray_batch_init(ndarray_batch *batch, NDArray *a, int is_double) {
+    NDArray *input = a;
+    int ndim = NDArray_NDIM(a), d;
+
+    if (ndim < 2) {
+        zend_throw_error(NULL, "Array must be at least two-dimensional");
+        return -1;
+    }
+    if (NDArray_SHAPE(a)[ndim - 1] != NDArray_SHAPE(a)[ndim - 2]) {
+        zend_throw_error(NULL, "Array must be square");
+        return -1;
+    }
+    batch->n = NDArray_SHAPE(a)[ndim - 1];
+    batch->count = 1;
+    for (d = 0; d < ndim - 2; d++) {
+        batch->count *= NDArray_SHAPE(a)[d];
+    }
+    batch->is_double = is_double;
+    if (NDArray_DEVICE(a) == NDARRAY_DEVICE_GPU) {
+        input = NDArray_ToCPU(a);
+    }
+    batch->work = NDArray_AsType(input, is_double ? NDARRAY_TYPE_DOUBLE64 : NDARRAY_TYPE_FLOAT32);
+    if (input != a) {
+        NDArray_FREE(input);
+    }
+    return batch->work == NULL ? -1 : 0;
+}
+
+static inline int
+ndarray_batch_parallel(const ndarray_batch *batch) {
+    return batch->count > 1 && (double)batch->count * batch->n * batch->n * batch->n >= NDARRAY_BATCH_PARALLEL_MIN;
+}
+
+/**
+ * Pointer to element `offset` of a float32 or float64 buffer
+ */
+static inline char*
+ndarray_batch_at(const ndarray_batch *batch, void *data, long offset) {
+    return (char *) data + offset * (batch->is_double ? sizeof(double) : sizeof(float));
+}
+
+static inline void
+ndarray_batch_load(const ndarray_batch *batch, const void *src, double *dst, long count) {
+    long i;
+    if (batch->is_double) {
+        memcpy(dst, src, sizeof(double) * count);
+    } else {
+        for (i = 0; i < count; i++) {
+            dst[i] = ((const float *) src)[i];
+        }
+    }
+}
+
+static inline void
+ndarray_batch_store(const ndarray_batch *batch, void *dst, const double *src, long count) {
+    long i;
+    if (batch->is_double) {
+        memcpy(dst, src, sizeof(double) * count);
+    } else {
+        for (i = 0; i < count; i++) {
+            ((float *) dst)[i] = (float) src[i];
+        }
+    }
+}
+
+/**
+ * Results computed on CPU for a GPU input are moved back to the GPU
+ */
+static NDArray*
+ndarray_batch_output(NDArray *target, NDArray *rtn) {
+    if (rtn != NULL && NDArray_DEVICE(target) == NDARRAY_DEVICE_GPU) {
+        NDArray *gpu = NDArray_ToGPU(rtn);
+        NDArray_FREE(rtn);
+        return gpu;
+    }
+    return rtn;
+}
+
+/**
+ * Closed-form determinant and, when `inv` is given and the matrix is
+ * not singular, inverse of a row-major matrix of order 0 to 4 through
+ * its cofactors
+ *
+ * @return the determinant
+ */
+static double
+ndarray_small_inverse(const double *m, int n, double *inv) {
+    double det, s[6], c[6];
+    int i;
+
+    switch (n) {
+        case 0:
+            return 1;
+        case 1:
+            if (inv != NULL && m[0] != 0) {
+                inv[0] = 1 / m[0];
+            }
+            return m[0];
+        case 2:
+            det = m[0] * m[3] - m[1] * m[2];
+            if (inv != NULL && det != 0) {
+                inv[0] = m[3] / det;
+                inv[1] = -m[1] / det;
+                inv[2] = -m[2] / det;
+                inv[3] = m[0] / det;
+            }
+            return det;
+        case 3:
+            c[0] = m[4] * m[8] - m[5] * m[7];
+            c[1] = m[5] * m[6] - m[3] * m[8];
+            c[2] = m[3] * m[7] - m[4] * m[6];
+            det = m[0] * c[0] + m[1] * c[1] + m[2] * c[2];
+            if (inv != NULL && det != 0) {
+                inv[0] = c[0];
+                inv[1] = m[2] * m[7] - m[1] * m[8];
+                inv[2] = m[1] * m[5] - m[2] * m[4];
+                inv[3] = c[1];
+                inv[4] = m[0] * m[8] - m[2] * m[6];
+                inv[5] = m[2] * m[3] - m[0] * m[5];
+                inv[6] = c[2];
+                inv[7] = m[1] * m[6] - m[0] * m[7];
+                inv[8] = m[0] * m[4] - m[1] * m[3];
+                for (i = 0; i < 9; i++) {
+                    inv[i] /= det;
+                }
+            }
+            return det;
+        default:
+            // 2 x 2 minors of the top (s) and bottom (c) row pairs
+            s[0] = m[0] * m[5] - m[4] * m[1];
+            s[1] = m[0] * m[6] - m[4] * m[2];
+            s[2] = m[0] * m[7] - m[4] * m[3];
+            s[3] = m[1] * m[6] - m[5] * m[2];
+            s[4] = m[1] * m[7] - m[5] * m[3];
+            s[5] = m[2] * m[7] - m[6] * m[3];
+            c[0] = m[8] * m[13] - m[12] * m[9];
+            c[1] = m[8] * m[14] - m[12] * m[10];
+            c[2] = m[8] * m[15] - m[12] * m[11];
+            c[3] = m[9] * m[14] - m[13] * m[10];
+            c[4] = m[9] * m[15] - m[13] * m[11];
+            c[5] = m[10] * m[15] - m[14] * m[11];
+            det = s[0] * c[5] - s[1] * c[4] + s[2] * c[3] + s[3] * c[2] - s[4] * c[1] + s[5] * c[0];
+            if (inv != NULL && det != 0) {
+                inv[0] = m[5] * c[5] - m[6] * c[4] + m[7] * c[3];
+                inv[1] = -m[1] * c[5] + m[2] * c[4] - m[3] * c[3];
+                inv[2] = m[13] * s[5] - m[14] * s[4] + m[15] * s[3];
+                inv[3] = -m[9] * s[5] + m[10] * s[4] - m[11] * s[3];
+                inv[4] = -m[4] * c[5] + m[6] * c[2] - m[7] * c[1];
+                inv[5] = m[0] * c[5] - m[2] * c[2] + m[3] * c[1];
+                inv[6] = -m[12] * s[5] + m[14] * s[2] - m[15] * s[1];
+                inv[7] = m[8] * s[5] - m[10] * s[2] + m[11] * s[1];
+                inv[8] = m[4] * c[4] - m[5] * c[2] + m[7] * c[0];
+                inv[9] = -m[0] * c[4] + m[1] * c[2] - m[3] * c[0];
+                inv[10] = m[12] * s[4] - m[13] * s[2] + m[15] * s[0];
+                inv[11] = -m[8] * s[4] + m[9] * s[2] - m[11] * s[0];
+                inv[12] = -m[4] * c[3] + m[5] * c[1] - m[6] * c[0];
+                inv[13] = m[0] * c[3] - m[1] * c[1] + m[2] * c[0];
+                inv[14] = -m[12] * s[3] + m[13] * s[1] - m[14] * s[0];
+                inv[15] = m[8] * s[3] - m[9] * s[1] + m[10] * s[0];
+                for (i = 0; i < 16; i++) {
+                    inv[i] /= det;
+                }
+            }
+            return det;
+    }
+}
+
+/**
+ * Whether a closed-form determinant is too small to invert with, measured
+ * against the product of the row norms that bounds it (Hadamard), so
+ * near-singular matrices whose determinant is rounding noise are caught
+ *
+ * @param eps machine epsilon of the dtype the matrix came from
+ */
+static int
+ndarray_small_singular(const double *m, int n, double det, double eps) {
+    double bound = 1, norm;
+    int i, j;
+
+    for (i = 0; i < n; i++) {
+        norm = 0;
+        for (j = 0; j < n; j++) {
+            norm += m[i * n + j] * m[i * n + j];
+        }
+        bound *= sqrt(norm);
+    }
+    return fabs(det) <= n * eps * bound;
+}
+
+/**
+ * In-place getrf of one matrix of the stack. The row-major data is
+ * factored as its column-major transpose, which has the same
+ * determinant, inverse transpose and solves with trans = 'T'.
+ *
+ * @return getrf info, > 0 for a singular matrix
+ */
+static int
+ndarray_batch_getrf(const ndarray_batch *batch, void *matrix, int *ipiv) {
+    int n = batch->n, info;
+    if (batch->is_double) {
+        dgetrf_(&n, &n, (double *) matrix, &n, ipiv, &info);
+    } else {
+        sgetrf_(&n, &n, (float *) matrix, &n, ipiv, &info);
+    }
+    return info;
+}
+
 /**
  * NDArray determinant
  *
- * @param a
- * @return
+ * @param a square matrix or stack of square matrices (..., n, n)
+ * @return determinants with shape (...), float64 for float64 inputs and
+ *         float32 otherwise
  */
 NDArray*
 NDArray_Det(NDArray *a) {
-    int *new_shape = emalloc(sizeof(int));
-    NDArray *rtn = Create_NDArray(new_shape, 0, NDARRAY_TYPE_FLOAT32, NDArray_DEVICE(a));
-    if (NDArray_DEVICE(a) == NDARRAY_DEVICE_GPU) {
+    ndarray_batch batch;
+    NDArray *rtn;
+    int *shape, *ipiv, ndim = NDArray_NDIM(a), n;
+    long i, size;
+
+    if (NDArray_DEVICE(a) == NDARRAY_DEVICE_GPU && ndim == 2 && is_type(NDArray_TYPE(a), NDARRAY_TYPE_FLOAT32)) {
 #ifdef HAVE_CUBLAS
+        rtn = Create_NDArray(emalloc(sizeof(int)), 0, NDARRAY_TYPE_FLOAT32, NDARRAY_DEVICE_GPU);
         rtn->device = NDARRAY_DEVICE_GPU;
         vmalloc((void **)&rtn->data, sizeof(float));
         cuda_det_float(NDArray_FDATA(a), NDArray_FDATA(rtn), NDArray_SHAPE(a)[0]);
+        return rtn;
 #endif
+    }
+    if (ndarray_batch_init(&batch, a, is_type(NDArray_TYPE(a), NDARRAY_TYPE_DOUBLE64)) < 0) {
+        return NULL;
+    }
+    n = batch.n;
+    size = (long)n * n;
+    shape = emalloc(sizeof(int) * (ndim > 2 ? ndim - 2 : 1));
+    memcpy(shape, NDArray_SHAPE(a), sizeof(int) * (ndim - 2));
+    rtn = NDArray_Empty(shape, ndim - 2, batch.is_double ? NDARRAY_TYPE_DOUBLE64 : NDARRAY_TYPE_FLOAT32, NDARRAY_DEVICE_CPU);
+
+    if (n <= NDARRAY_BATCH_CLOSED_MAX) {
+#pragma omp parallel for if (ndarray_batch_parallel(&batch))
+        for (i = 0; i < batch.count; i++) {
+            double m[16], det;
+            ndarray_batch_load(&batch, ndarray_batch_at(&batch, NDArray_DATA(batch.work), i * size), m, size);
+            det = ndarray_small_inverse(m, n, NULL);
+            ndarray_batch_store(&batch, ndarray_batch_at(&batch, NDArray_DATA(rtn), i), &det, 1);
+        }
     } else {
-        int info;
-        int N = NDArray_SHAPE(a)[0];
-        int* ipiv = (int*) emalloc(N * sizeof(int));
-        float *matrix = emalloc(sizeof(float) * NDArray_NUMELEMENTS(a));
-        rtn->data = emalloc(sizeof(float));
-        memcpy(matrix, NDArray_FDATA(a), sizeof(float) * NDArray_NUMELEMENTS(a));
-        // LU Decomposition using LAPACKE interface
-        sgetrf_(&N, &N, matrix, &N, ipiv, &info);
-
-        if (info != 0) {
-            if (info > 0) {
-                NDArray_FDATA(rtn)[0] = 0.f;
-                efree(ipiv);
-                efree(matrix);
-                return rtn;
+        ipiv = emalloc(sizeof(int) * n * ndarray_batch_threads());
+#pragma omp parallel for if (ndarray_batch_parallel(&batch))
+        for (i = 0; i < batch.count; i++) {
+            int *piv = ipiv + (long)n * ndarray_batch_thread_id(), j;
+            char *matrix = ndarray_batch_at(&batch, NDArray_DATA(batch.work), i * size);
+            double det = 1, value;
+
+            if (ndarray_batch_getrf(&batch, matrix, piv) > 0) {
+                det = 0;
+            } else {
+                for (j = 0; j < n; j++) {
+                    ndarray_batch_load(&batch, ndarray_batch_at(&batch, matrix, (long)j * n + j), &value, 1);
+                    // Every row interchange flips the sign
+                    det *= piv[j] != j + 1 ? -value : value;
+                }
             }
-            printf("Error in LU decomposition. Code: %d\n", info);
-            efree(ipiv);
-            exit(1);
-        }
-
-        // Calculate determinant as product of diagonal elements
-        float det = 1;
-        for (int i = 0; i < N; i++) {
-            det *= matrix[i* N + i];
-        }
-
-        // Account for the parity of the permutation
-        int num_perm = 0;
-        for (int i = 0; i < N; i++) {
-            if (i + 1 != ipiv[i]) num_perm++;
+            ndarray_batch_store(&batch, ndarray_batch_at(&batch, NDArray_DATA(rtn), i), &det, 1);
         }
-        if (num_perm % 2 != 0) det = -det;
-
         efree(ipiv);
-        efree(matrix);
-        NDArray_FDATA(rtn)[0] = det;
     }
-    return rtn;
+    NDArray_FREE(batch.work);
+    return ndarray_batch_output(a, rtn);
 }
 
 /**
@@ -329,8 +798,20 @@ NDArray_Inner(NDArray *nda, NDArray *ndb) {
         return NULL;
     }
 
+    if (NDArray_NDIM(nda) == 1 && NDArray_NDIM(ndb) == 1 &&
+        ndarray_is_half(NDArray_PromoteTypes(NDArray_TYPE(nda), NDArray_TYPE(ndb)))) {
+        return NDArray_HalfGemm(nda, ndb, emalloc(sizeof(int)), 0, 1, 1, last_dim_a);
+    }
+
     NDArray *mul = NDArray_Multiply_Float(nda, ndb);
-    rtn = NDArray_CreateFromFloatScalar(NDArray_Sum_Float(mul));
+    if (mul == NULL) {
+        return NULL;
+    }
+    if (is_type(NDArray_TYPE(mul), NDARRAY_TYPE_FLOAT32)) {
+        rtn = NDArray_CreateFromFloatScalar(NDArray_Sum_Float(mul));
+    } else {
+        rtn = NDArray_CreateFromDoubleScalar(NDArray_Sum(mul));
+    }
     NDArray_FREE(mul);
     if (NDArray_NDIM(nda) > 1) {
         rtn->ndim = NDArray_NDIM(nda);
@@ -364,8 +845,25 @@ NDArray_Dot(NDArray *nda, NDArray *ndb) {
         return NDArray_Matmul(nda, ndb);
     } else if (NDArray_NDIM(nda) == 0 || NDArray_NDIM(ndb) == 0) {
         return NDArray_Multiply_Float(nda, ndb);
+    } else if (NDArray_NDIM(nda) == 2 && NDArray_NDIM(ndb) == 1 &&
+               ndarray_is_half(NDArray_PromoteTypes(NDArray_TYPE(nda), NDArray_TYPE(ndb)))) {
+        if (NDArray_SHAPE(nda)[1] != NDArray_SHAPE(ndb)[0]) {
+            zend_throw_error(NULL, "Shape mismatch for dot. cols(a) != rows(b)");
+            return NULL;
+        }
+        int *rtn_shape = emalloc(sizeof(int));
+        rtn_shape[0] = NDArray_SHAPE(nda)[0];
+        return NDArray_HalfGemm(nda, ndb, rtn_shape, 1, NDArray_SHAPE(nda)[0], 1, NDArray_SHAPE(nda)[1]);
     } else if (NDArray_NDIM(nda) > 0 && NDArray_NDIM(ndb) == 1) {
+        if (NDArray_SHAPE(nda)[NDArray_NDIM(nda) - 1] != NDArray_SHAPE(ndb)[0]) {
+            zend_throw_error(NULL, "Shape mismatch for dot. cols(a) != rows(b)");
+            return NULL;
+        }
         if (NDArray_DEVICE(nda) == NDARRAY_DEVICE_GPU) {
+            if (!is_type(NDArray_TYPE(nda), NDARRAY_TYPE_FLOAT32) || !is_type(NDArray_TYPE(ndb), NDARRAY_TYPE_FLOAT32)) {
+                zend_throw_error(NULL, "dot is only available for float32 NDArrays on the GPU.");
+                return NULL;
+            }
 #ifdef HAVE_CUBLAS
             int *rtn_shape = emalloc(sizeof(int) * (NDArray_NDIM(nda) - 1));
             copy(NDArray_SHAPE(nda), rtn_shape, NDArray_NDIM(nda) -1);
@@ -376,11 +874,31 @@ NDArray_Dot(NDArray *nda, NDArray *ndb) {
 #endif
         } else {
 #ifdef HAVE_CBLAS
-            int *rtn_shape = emalloc(sizeof(int) * (NDArray_NDIM(nda) - 1));
-            copy(NDArray_SHAPE(nda), rtn_shape, NDArray_NDIM(nda) -1);
-            NDArray *rtn = NDArray_Empty(rtn_shape, NDArray_NDIM(nda) - 1, NDARRAY_TYPE_FLOAT32, NDARRAY_DEVICE_CPU);
-            cblas_sgemv(CblasRowMajor, CblasNoTrans, NDArray_SHAPE(nda)[NDArray_NDIM(nda) - 2], NDArray_SHAPE(nda)[NDArray_NDIM(nda) - 1], 1.0f, NDArray_FDATA(nda), NDArray_SHAPE(nda)[NDArray_NDIM(nda) - 1],
-                        NDArray_FDATA(ndb), 1, 0.0f, NDArray_FDATA(rtn), 1);
+            // Leading dimensions of `nda` are rows of a single gemv
+            int is_double = ndarray_linalg_is_double(nda, ndb);
+            int cols = NDArray_SHAPE(nda)[NDArray_NDIM(nda) - 1], rows = 1, i;
+            NDArray *a_op = ndarray_linalg_operand(nda, is_double), *b_op = ndarray_linalg_operand(ndb, is_double);
+            NDArray *rtn = NULL;
+            int *rtn_shape;
+
+            if (a_op != NULL && b_op != NULL) {
+                rtn_shape = emalloc(sizeof(int) * (NDArray_NDIM(nda) > 1 ? NDArray_NDIM(nda) - 1 : 1));
+                for (i = 0; i < NDArray_NDIM(nda) - 1; i++) {
+                    rtn_shape[i] = NDArray_SHAPE(nda)[i];
+                    rows *= rtn_shape[i];
+                }
+                rtn = NDArray_Empty(rtn_shape, NDArray_NDIM(nda) - 1,
+                                    is_double ? NDARRAY_TYPE_DOUBLE64 : NDARRAY_TYPE_FLOAT32, NDARRAY_DEVICE_CPU);
+                if (is_double) {
+                    cblas_dgemv(CblasRowMajor, CblasNoTrans, rows, cols, 1.0, NDArray_DDATA(a_op), cols > 1 ? cols : 1,
+                                NDArray_DDATA(b_op), 1, 0.0, NDArray_DDATA(rtn), 1);
+                } else {
+                    cblas_sgemv(CblasRowMajor, CblasNoTrans, rows, cols, 1.0f, NDArray_FDATA(a_op), cols > 1 ? cols : 1,
+                                NDArray_FDATA(b_op), 1, 0.0f, NDArray_FDATA(rtn), 1);
+                }
+            }
+            ndarray_linalg_release(a_op, nda);
+            ndarray_linalg_release(b_op, ndb);
             return rtn;
 #endif
         }
@@ -392,268 +910,1099 @@ NDArray_Dot(NDArray *nda, NDArray *ndb) {
     return NULL;
 }
 
-/**
- * L2 NORM
- *
- * @param target
- * @return
- */
-NDArray*
-NDArray_L2Norm(NDArray* target) {
-    NDArray *rtn = NULL;
-    NDArray **svd = NDArray_SVD(target);
-    if (svd == NULL) {
-        return NULL;
-    }
-    float max_svd = NDArray_Max(svd[1]);
-    rtn = NDArray_CreateFromFloatScalar(max_svd);
-    NDArray_FREE(svd[0]);
-    NDArray_FREE(svd[1]);
-    NDArray_FREE(svd[2]);
-    efree(svd);
-    return rtn;
-}
+/* Elements summed in float32 lanes before the partial sum moves to double */
+#define NDARRAY_NORM_BLOCK 1024
 
 /**
- * L1 NORM
- *
- * @param target
- * @return
+ * Sum of squares of a contiguous float32 vector. Eight independent
+ * accumulators let the compiler vectorize the loop, every block is
+ * folded into a double so long vectors keep their precision.
  */
-NDArray*
-NDArray_L1Norm(NDArray* target) {
-    NDArray *rtn = NULL;
-    float max_value = FLT_MIN;
-    float *results = emalloc(sizeof(float) * NDArray_SHAPE(target)[NDArray_NDIM(target) - 2]);
-    NDArray *transposed = NDArray_Transpose(target, NULL);
-    NDArray *ab = NDArray_Abs(transposed);
-    NDArray_FREE(transposed);
-    NDArray *slice;
-    while(!NDArrayIterator_ISDONE(ab)) {
-        slice = NDArrayIterator_GET(ab);
-        results[ab->iterator->current_index] = NDArray_Sum_Float(slice);
-        NDArray_FREE(slice);
-        NDArrayIterator_NEXT(ab);
-    }
-    for (int i = 0; i < NDArray_SHAPE(target)[NDArray_NDIM(target) - 2]; i++) {
-        if (max_value < results[i]) {
-            max_value = results[i];
+static double
+ndarray_sumsq_float(const float *x, long n) {
+    double total = 0;
+    long i = 0, j;
+    while (i < n) {
+        float acc[8] = {0};
+        long end = i + NDARRAY_NORM_BLOCK < n ? i + NDARRAY_NORM_BLOCK : n;
+        for (; i + 8 <= end; i += 8) {
+            for (j = 0; j < 8; j++) {
+                acc[j] += x[i + j] * x[i + j];
+            }
         }
+        for (; i < end; i++) {
+            acc[0] += x[i] * x[i];
+        }
+        total += ((acc[0] + acc[4]) + (acc[1] + acc[5])) + ((acc[2] + acc[6]) + (acc[3] + acc[7]));
     }
-    efree(results);
-    NDArray_FREE(ab);
-    rtn = NDArray_CreateFromFloatScalar(max_value);
-    return rtn;
+    return total;
+}
+
+static double
+ndarray_abssum_float(const float *x, long n) {
+    double total = 0;
+    long i = 0, j;
+    while (i < n) {
+        float acc[8] = {0};
+        long end = i + NDARRAY_NORM_BLOCK < n ? i + NDARRAY_NORM_BLOCK : n;
+        for (; i + 8 <= end; i += 8) {
+            for (j = 0; j < 8; j++) {
+                acc[j] += fabsf(x[i + j]);
+            }
+        }
+        for (; i < end; i++) {
+            acc[0] += fabsf(x[i]);
+        }
+        total += ((acc[0] + acc[4]) + (acc[1] + acc[5])) + ((acc[2] + acc[6]) + (acc[3] + acc[7]));
+    }
+    return total;
+}
+
+static double
+ndarray_sumsq_double(const double *x, long n) {
+    double acc[4] = {0};
+    long i = 0, j;
+    for (; i + 4 <= n; i += 4) {
+        for (j = 0; j < 4; j++) {
+            acc[j] += x[i + j] * x[i + j];
+        }
+    }
+    for (; i < n; i++) {
+        acc[0] += x[i] * x[i];
+    }
+    return (acc[0] + acc[2]) + (acc[1] + acc[3]);
+}
+
+static inline double
+ndarray_norm_load(const char *p, const NDArrayTypeFuncs *funcs) {
+    if (funcs->kind == NDARRAY_KIND_FLOAT && funcs->elsize == 4) {
+        return *(const float *) p;
+    }
+    if (funcs->kind == NDARRAY_KIND_FLOAT && funcs->elsize == 8) {
+        return *(const double *) p;
+    }
+    return funcs->getitem(p);
+}
+
+static inline double
+ndarray_norm_init(double ord) {
+    return ord == -INFINITY ? INFINITY : 0;
+}
+
+static inline double
+ndarray_norm_accumulate(double acc, double v, double ord) {
+    v = fabs(v);
+    if (ord == INFINITY) {
+        return v > acc ? v : acc;
+    }
+    if (ord == -INFINITY) {
+        return v < acc ? v : acc;
+    }
+    if (ord == 0) {
+        return acc + (v != 0);
+    }
+    if (ord == 1) {
+        return acc + v;
+    }
+    if (ord == 2) {
+        return acc + v * v;
+    }
+    return acc + pow(v, ord);
+}
+
+static inline double
+ndarray_norm_finalize(double acc, double ord) {
+    if (ord == 2) {
+        return sqrt(acc);
+    }
+    if (ord == 0 || ord == 1 || ord == INFINITY || ord == -INFINITY) {
+        return acc;
+    }
+    return pow(acc, 1.0 / ord);
+}
+
+/**
+ * Vector norm of one strided lane in a single pass
+ */
+static double
+ndarray_vector_norm(const char *data, long stride, long n, const NDArrayTypeFuncs *funcs, double ord) {
+    double acc;
+    long i;
+    if (stride == funcs->elsize && funcs->kind == NDARRAY_KIND_FLOAT) {
+        if (funcs->elsize == 4 && ord == 2) {
+            return sqrt(ndarray_sumsq_float((const float *) data, n));
+        }
+        if (funcs->elsize == 4 && ord == 1) {
+            return ndarray_abssum_float((const float *) data, n);
+        }
+        if (funcs->elsize == 8 && ord == 2) {
+            return sqrt(ndarray_sumsq_double((const double *) data, n));
+        }
+    }
+    acc = ndarray_norm_init(ord);
+    for (i = 0; i < n; i++) {
+        acc = ndarray_norm_accumulate(acc, ndarray_norm_load(data + i * stride, funcs), ord);
+    }
+    return ndarray_norm_finalize(acc, ord);
+}
+
+/**
+ * Vector norms of every lane of a C contiguous array along `axis`
+ *
+ * @return emalloc'd norms in C order of the remaining dimensions
+ */
+static double*
+ndarray_norm_along_axis(NDArray *a, int axis, double ord) {
+    const NDArrayTypeFuncs *funcs = NDArray_TypeFuncs(NDArray_TYPE(a));
+    long outer = 1, inner = 1, length = NDArray_SHAPE(a)[axis], r, o, k, j;
+    long elsize = funcs->elsize;
+    double *norms;
+    int d;
+
+    for (d = 0; d < NDArray_NDIM(a); d++) {
+        if (d < axis) {
+            outer *= NDArray_SHAPE(a)[d];
+        } else if (d > axis) {
+            inner *= NDArray_SHAPE(a)[d];
+        }
+    }
+    norms = emalloc(sizeof(double) * (outer * inner > 0 ? outer * inner : 1));
+    if (inner == 1) {
+        // Rows are contiguous, e.g. the norm of every embedding in a batch
+#pragma omp parallel for if (outer > 1 && outer * length >= 65536)
+        for (r = 0; r < outer; r++) {
+            norms[r] = ndarray_vector_norm(NDArray_DATA(a) + r * length * elsize, elsize, length, funcs, ord);
+        }
+        return norms;
+    }
+    // Walk the array once row by row, keeping one accumulator per lane
+    for (r = 0; r < outer * inner; r++) {
+        norms[r] = ndarray_norm_init(ord);
+    }
+    for (o = 0; o < outer; o++) {
+        for (k = 0; k < length; k++) {
+            const char *row = NDArray_DATA(a) + (o * length + k) * inner * elsize;
+            double *acc = norms + o * inner;
+            for (j = 0; j < inner; j++) {
+                acc[j] = ndarray_norm_accumulate(acc[j], ndarray_norm_load(row + j * elsize, funcs), ord);
+            }
+        }
+    }
+    for (r = 0; r < outer * inner; r++) {
+        norms[r] = ndarray_norm_finalize(norms[r], ord);
+    }
+    return norms;
+}
+
+/**
+ * Singular values of a C contiguous matrix through gesdd without
+ * computing U and V. The row-major data is read as the column-major
+ * transpose, which has the same singular values.
+ *
+ * @return emalloc'd min(m, n) values in descending order, NULL on failure
+ */
+static double*
+ndarray_singular_values(NDArray *a) {
+    int m = NDArray_SHAPE(a)[0], n = NDArray_SHAPE(a)[1], k = m < n ? m : n, i, info;
+    double *values = emalloc(sizeof(double) * (k > 0 ? k : 1));
+
+    if (k == 0) {
+        return values;
+    }
+    if (is_type(NDArray_TYPE(a), NDARRAY_TYPE_DOUBLE64)) {
+        double *work = emalloc(sizeof(double) * m * n);
+        memcpy(work, NDArray_DDATA(a), sizeof(double) * m * n);
+        info = LAPACKE_dgesdd(LAPACK_COL_MAJOR, 'N', n, m, work, n, values, NULL, 1, NULL, 1);
+        efree(work);
+    } else {
+        float *work = emalloc(sizeof(float) * m * n), *s = emalloc(sizeof(float) * k);
+        NDArray_TypeFuncs(NDArray_TYPE(a))->to_float32(NDArray_DATA(a), NDArray_ELSIZE(a), work, (long)m * n);
+        info = LAPACKE_sgesdd(LAPACK_COL_MAJOR, 'N', n, m, work, n, s, NULL, 1, NULL, 1);
+        for (i = 0; i < k; i++) {
+            values[i] = s[i];
+        }
+        efree(s);
+        efree(work);
+    }
+    if (info != 0) {
+        zend_throw_error(NULL, "SVD computation did not converge.");
+        efree(values);
+        return NULL;
+    }
+    return values;
+}
+
+/**
+ * Matrix norm of a C contiguous 2-D array
+ *
+ * @return 0 on success, -1 with an exception thrown otherwise
+ */
+static int
+ndarray_matrix_norm(NDArray *a, double ord, double *result) {
+    double *values;
+    long i, count;
+    int axis;
+
+    if (ord == 2 || ord == -2) {
+        values = ndarray_singular_values(a);
+        if (values == NULL) {
+            return -1;
+        }
+        count = NDArray_SHAPE(a)[0] < NDArray_SHAPE(a)[1] ? NDArray_SHAPE(a)[0] : NDArray_SHAPE(a)[1];
+        *result = count == 0 ? 0 : (ord == 2 ? values[0] : values[count - 1]);
+        efree(values);
+        return 0;
+    }
+    if (ord != 1 && ord != -1 && ord != INFINITY && ord != -INFINITY) {
+        zend_throw_error(NULL, "Invalid norm order for matrices.");
+        return -1;
+    }
+    // 1 and -1 reduce column sums, inf and -inf reduce row sums
+    axis = (ord == 1 || ord == -1) ? 0 : 1;
+    values = ndarray_norm_along_axis(a, axis, 1);
+    count = NDArray_SHAPE(a)[1 - axis];
+    *result = count == 0 ? 0 : values[0];
+    for (i = 1; i < count; i++) {
+        if (ord > 0 ? values[i] > *result : values[i] < *result) {
+            *result = values[i];
+        }
+    }
+    efree(values);
+    return 0;
+}
+
+/**
+ * Contiguous CPU copy of `target` when it needs one
+ */
+static NDArray*
+ndarray_norm_input(NDArray *target) {
+    if (NDArray_DEVICE(target) == NDARRAY_DEVICE_GPU) {
+        return NDArray_ToCPU(target);
+    }
+    if (!NDArray_IsContiguous(target)) {
+        return NDArray_ToContiguous(target);
+    }
+    return target;
+}
+
+/**
+ * 0-d result holding `value`, on the device of `target`
+ */
+static NDArray*
+ndarray_norm_scalar(NDArray *target, double value) {
+    NDArray *rtn, *gpu;
+    if (is_type(NDArray_TYPE(target), NDARRAY_TYPE_DOUBLE64)) {
+        rtn = NDArray_CreateFromDoubleScalar(value);
+    } else {
+        rtn = NDArray_CreateFromFloatScalar((float) value);
+    }
+    if (NDArray_DEVICE(target) == NDARRAY_DEVICE_GPU) {
+        gpu = NDArray_ToGPU(rtn);
+        NDArray_FREE(rtn);
+        rtn = gpu;
+    }
+    return rtn;
+}
+
+/**
+ * Spectral norm, the largest singular value
+ *
+ * @param target
+ * @return
+ */
+NDArray*
+NDArray_L2Norm(NDArray* target) {
+    return NDArray_Norm(target, 2, NDARRAY_MAX_DIMS);
+}
+
+/**
+ * Matrix 1-norm, the largest absolute column sum
+ *
+ * @param target
+ * @return
+ */
+NDArray*
+NDArray_L1Norm(NDArray* target) {
+    return NDArray_Norm(target, 1, NDARRAY_MAX_DIMS);
+}
+
+/**
+ * Frobenius norm, the 2-norm of all elements
+ *
+ * @param target
+ * @return
+ */
+NDArray*
+NDArray_FrobeniusNorm(NDArray* target) {
+    NDArray *input = ndarray_norm_input(target), *rtn;
+    double value = ndarray_vector_norm(NDArray_DATA(input), NDArray_ELSIZE(input), NDArray_NUMELEMENTS(input),
+                                       NDArray_TypeFuncs(NDArray_TYPE(input)), 2);
+    rtn = ndarray_norm_scalar(target, value);
+    if (input != target) {
+        NDArray_FREE(input);
+    }
+    return rtn;
 }
 
 /**
  * Matrix or vector norm
  *
- * Types
- *  INT_MAX - Frobenius norm
- *  0 - sum(x!=0) Only Vectors
- *  1 - max(sum(abs(x), axis=0))
- * -1 - min(sum(abs(x), axis=0))
- *  2 - 2-norm
- * -2 - smallest singular value
+ * Without an axis, 1-D arrays get the vector norm of order `ord`
+ * (inf, -inf, 0 counts non-zeros, any other p is sum(|x|^p)^(1/p)) and
+ * 2-D arrays the matrix norm: 1 / -1 max / min absolute column sum,
+ * inf / -inf max / min absolute row sum, 2 / -2 largest / smallest
+ * singular value. With an axis, vector norms are taken along it.
+ *
  * @param target
+ * @param ord
+ * @param axis NDARRAY_MAX_DIMS for no axis
+ * @return float64 for float64 inputs, float32 otherwise
+ */
+NDArray*
+NDArray_Norm(NDArray* target, double ord, int axis) {
+    NDArray *input, *rtn = NULL;
+    int ndim = NDArray_NDIM(target), i, j;
+    double value;
+
+    if (NDArray_TypeFuncs(NDArray_TYPE(target)) == NULL) {
+        zend_throw_error(NULL, "norm not supported for dtype %s.", NDArray_TYPE(target));
+        return NULL;
+    }
+    if (axis != NDARRAY_MAX_DIMS && (axis < -ndim || axis >= ndim)) {
+        zend_throw_error(NULL, "Axis is out of bounds for array dimension");
+        return NULL;
+    }
+    if (axis == NDARRAY_MAX_DIMS && ndim > 2) {
+        zend_throw_error(NULL, "Improper number of dimensions to norm.");
+        return NULL;
+    }
+    input = ndarray_norm_input(target);
+    if (axis == NDARRAY_MAX_DIMS && ndim == 2) {
+        if (ndarray_matrix_norm(input, ord, &value) == 0) {
+            rtn = ndarray_norm_scalar(target, value);
+        }
+    } else if (axis == NDARRAY_MAX_DIMS || ndim <= 1) {
+        value = ndarray_vector_norm(NDArray_DATA(input), NDArray_ELSIZE(input), NDArray_NUMELEMENTS(input),
+                                    NDArray_TypeFuncs(NDArray_TYPE(input)), ord);
+        rtn = ndarray_norm_scalar(target, value);
+    } else {
+        int *shape = emalloc(sizeof(int) * (ndim - 1));
+        const char *type = is_type(NDArray_TYPE(target), NDARRAY_TYPE_DOUBLE64) ? NDARRAY_TYPE_DOUBLE64 : NDARRAY_TYPE_FLOAT32;
+        double *norms;
+        if (axis < 0) {
+            axis += ndim;
+        }
+        for (i = 0, j = 0; i < ndim; i++) {
+            if (i != axis) {
+                shape[j++] = NDArray_SHAPE(target)[i];
+            }
+        }
+        norms = ndarray_norm_along_axis(input, axis, ord);
+        rtn = NDArray_Empty(shape, ndim - 1, type, NDARRAY_DEVICE_CPU);
+        for (i = 0; i < NDArray_NUMELEMENTS(rtn); i++) {
+            NDArray_TypeFuncs(type)->setitem(NDArray_DATA(rtn) + i * NDArray_ELSIZE(rtn), norms[i]);
+        }
+        efree(norms);
+        if (NDArray_DEVICE(target) == NDARRAY_DEVICE_GPU) {
+            NDArray *gpu = NDArray_ToGPU(rtn);
+            NDArray_FREE(rtn);
+            rtn = gpu;
+        }
+    }
+    if (input != target) {
+        NDArray_FREE(input);
+    }
+    return rtn;
+}
+
+/**
+ * Nuclear norm, the sum of the singular values
+ *
+ * @param target 2-D NDArray
  * @return
  */
 NDArray*
-NDArray_Norm(NDArray* target, int type) {
-    if (type == 1) {
-        return NDArray_L1Norm(target);
+NDArray_NuclearNorm(NDArray* target) {
+    NDArray *input, *rtn;
+    double *values, sum = 0;
+    int i, k;
+
+    if (NDArray_NDIM(target) != 2) {
+        zend_throw_error(NULL, "Improper number of dimensions to norm.");
+        return NULL;
+    }
+    input = ndarray_norm_input(target);
+    values = ndarray_singular_values(input);
+    if (values == NULL) {
+        if (input != target) {
+            NDArray_FREE(input);
+        }
+        return NULL;
+    }
+    k = NDArray_SHAPE(target)[0] < NDArray_SHAPE(target)[1] ? NDArray_SHAPE(target)[0] : NDArray_SHAPE(target)[1];
+    for (i = 0; i < k; i++) {
+        sum += values[i];
     }
-    if (type == 2) {
-        return NDArray_L2Norm(target);
+    efree(values);
+    rtn = ndarray_norm_scalar(target, sum);
+    if (input != target) {
+        NDArray_FREE(input);
     }
+    return rtn;
+}
 
-    zend_throw_error(NULL, "NDArray_Norm: The provided norm `%d` is invalid", type);
-    return NULL;
+/**
+ * Singular values of a 2-D array without computing U and V
+ *
+ * @param target
+ * @return min(m, n) values in descending order, float64 for float64
+ *         inputs and float32 otherwise, on the device of `target`
+ */
+NDArray*
+NDArray_SingularValues(NDArray *target) {
+    NDArray *input, *rtn;
+    const char *type;
+    double *values;
+    int *shape, i;
+
+    if (NDArray_NDIM(target) != 2) {
+        zend_throw_error(NULL, "Array must be two-dimensional");
+        return NULL;
+    }
+    if (NDArray_TypeFuncs(NDArray_TYPE(target)) == NULL) {
+        zend_throw_error(NULL, "svd not supported for dtype %s.", NDArray_TYPE(target));
+        return NULL;
+    }
+    input = ndarray_norm_input(target);
+    values = ndarray_singular_values(input);
+    if (input != target) {
+        NDArray_FREE(input);
+    }
+    if (values == NULL) {
+        return NULL;
+    }
+    type = is_type(NDArray_TYPE(target), NDARRAY_TYPE_DOUBLE64) ? NDARRAY_TYPE_DOUBLE64 : NDARRAY_TYPE_FLOAT32;
+    shape = emalloc(sizeof(int));
+    shape[0] = NDArray_SHAPE(target)[0] < NDArray_SHAPE(target)[1] ? NDArray_SHAPE(target)[0] : NDArray_SHAPE(target)[1];
+    rtn = NDArray_Empty(shape, 1, type, NDARRAY_DEVICE_CPU);
+    for (i = 0; i < shape[0]; i++) {
+        NDArray_TypeFuncs(type)->setitem(NDArray_DATA(rtn) + (size_t)i * NDArray_ELSIZE(rtn), values[i]);
+    }
+    efree(values);
+    if (NDArray_DEVICE(target) == NDARRAY_DEVICE_GPU) {
+        NDArray *gpu = NDArray_ToGPU(rtn);
+        NDArray_FREE(rtn);
+        rtn = gpu;
+    }
+    return rtn;
+}
+
+/**
+ * Seed of the Gaussian test matrix, fixed so truncated SVDs are reproducible
+ */
+#define NDARRAY_RSVD_SEED 0x9E3779B97F4A7C15ULL
+
+/**
+ * @return uniform double in (0, 1)
+ */
+static double
+ndarray_rsvd_uniform(uint64_t *state) {
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    z ^= z >> 31;
+    return ((double)(z >> 11) + 0.5) / 9007199254740992.0;
 }
 
 /**
+ * Fill `count` elements of `out` with standard normal samples (Box-Muller)
+ */
+static void
+ndarray_rsvd_gaussian(void *out, long count, int is_double) {
+    uint64_t state = NDARRAY_RSVD_SEED;
+    double r, t;
+    long i;
+
+    for (i = 0; i < count; i += 2) {
+        r = sqrt(-2.0 * log(ndarray_rsvd_uniform(&state)));
+        t = 2.0 * M_PI * ndarray_rsvd_uniform(&state);
+        if (is_double) {
+            ((double *) out)[i] = r * cos(t);
+            if (i + 1 < count) {
+                ((double *) out)[i + 1] = r * sin(t);
+            }
+        } else {
+            ((float *) out)[i] = (float)(r * cos(t));
+            if (i + 1 < count) {
+                ((float *) out)[i + 1] = (float)(r * sin(t));
+            }
+        }
+    }
+}
+
+/**
+ * Row-major c (m x n) = op(a) * op(b), in float64 or float32
+ */
+static void
+ndarray_rsvd_gemm(int is_double, int trans_a, int trans_b, int m, int n, int k,
+                  const void *a, int lda, const void *b, int ldb, void *c, int ldc) {
+    if (is_double) {
+        cblas_dgemm(CblasRowMajor, trans_a ? CblasTrans : CblasNoTrans, trans_b ? CblasTrans : CblasNoTrans,
+                    m, n, k, 1.0, (const double *) a, lda, (const double *) b, ldb, 0.0, (double *) c, ldc);
+    } else {
+        cblas_sgemm(CblasRowMajor, trans_a ? CblasTrans : CblasNoTrans, trans_b ? CblasTrans : CblasNoTrans,
+                    m, n, k, 1.0f, (const float *) a, lda, (const float *) b, ldb, 0.0f, (float *) c, ldc);
+    }
+}
+
+/**
+ * Replace the row-major m x l matrix `y` (m >= l) by an orthonormal basis
+ * of its columns, the Q of its thin QR factorization
  *
- * @param matrix
- * @param n
- * @return 1 if succeeded, 0 if failed
+ * @return 0 on success
  */
-int
-matrixFloatInverse(float* matrix, int n) {
-    int* ipiv = (int*)emalloc(n * sizeof(int)); // Pivot indices
-    int info; // Status variable
+static int
+ndarray_rsvd_orthonormalize(int is_double, void *y, int m, int l) {
+    int info;
 
-    // Perform LU factorization
-    sgetrf_(&n, &n, matrix, &n, ipiv, &info);
-    if (info != 0) {
-        zend_throw_error(NULL, "LU factorization failed. Unable to compute the matrix inverse.\n");
-        efree(ipiv);
-        return 0;
+    if (is_double) {
+        double *tau = emalloc(sizeof(double) * l);
+        info = LAPACKE_dgeqrf(LAPACK_ROW_MAJOR, m, l, (double *) y, l, tau);
+        if (info == 0) {
+            info = LAPACKE_dorgqr(LAPACK_ROW_MAJOR, m, l, l, (double *) y, l, tau);
+        }
+        efree(tau);
+    } else {
+        float *tau = emalloc(sizeof(float) * l);
+        info = LAPACKE_sgeqrf(LAPACK_ROW_MAJOR, m, l, (float *) y, l, tau);
+        if (info == 0) {
+            info = LAPACKE_sorgqr(LAPACK_ROW_MAJOR, m, l, l, (float *) y, l, tau);
+        }
+        efree(tau);
     }
+    return info;
+}
+
+/**
+ * Truncated SVD of the m x n matrix `a` by randomized range finding
+ * (Halko, Martinsson and Tropp): the range of `a` is sampled with a
+ * Gaussian test matrix of k + oversamples columns, sharpened by power
+ * iterations, orthonormalized with QR and the small projected matrix
+ * Q^T a is decomposed with gesdd. Every product with `a` is a GEMM, so
+ * the cost is O(m n (k + oversamples)) instead of O(m n min(m, n)).
+ *
+ * @param target 2-D NDArray
+ * @param k number of singular triplets to return, 1 <= k <= min(m, n)
+ * @param oversamples extra sampled directions, improves accuracy
+ * @param power_iterations passes of a a^T over the sample, for slowly
+ *        decaying spectra
+ * @return [U (m x k), S (k), Vh (k x n)], float64 for float64 inputs and
+ *         float32 otherwise
+ */
+NDArray**
+NDArray_RandomizedSVD(NDArray *target, int k, int oversamples, int power_iterations) {
+    NDArray *input, *cast = NULL, **rtns = NULL;
+    const char *type;
+    int m, n, l, r, it, info = 0, is_double, *shape;
+    size_t elsize;
+    void *a, *omega, *y, *z, *b, *s, *ub, *vt;
 
-    // Calculate the inverse
-    int lwork = n * n;
-    float work_query[lwork];
-    sgetri_(&n, matrix, &n, ipiv, work_query, &lwork, &info);
+    if (NDArray_NDIM(target) != 2) {
+        zend_throw_error(NULL, "Array must be two-dimensional");
+        return NULL;
+    }
+    if (NDArray_TypeFuncs(NDArray_TYPE(target)) == NULL) {
+        zend_throw_error(NULL, "svd not supported for dtype %s.", NDArray_TYPE(target));
+        return NULL;
+    }
+    m = NDArray_SHAPE(target)[0];
+    n = NDArray_SHAPE(target)[1];
+    r = m < n ? m : n;
+    if (k < 1 || k > r) {
+        zend_throw_error(NULL, "k must be between 1 and min(M, N) = %d", r);
+        return NULL;
+    }
+    if (oversamples < 0 || power_iterations < 0) {
+        zend_throw_error(NULL, "oversamples and power iterations must be non-negative");
+        return NULL;
+    }
+    is_double = is_type(NDArray_TYPE(target), NDARRAY_TYPE_DOUBLE64);
+    type = is_double ? NDARRAY_TYPE_DOUBLE64 : NDARRAY_TYPE_FLOAT32;
+    elsize = is_double ? sizeof(double) : sizeof(float);
+    input = ndarray_norm_input(target);
+    if (!is_type(NDArray_TYPE(input), type)) {
+        cast = NDArray_AsType(input, type);
+        if (cast == NULL) {
+            if (input != target) {
+                NDArray_FREE(input);
+            }
+            return NULL;
+        }
+    }
+    a = NDArray_DATA(cast != NULL ? cast : input);
+    l = k + oversamples < r ? k + oversamples : r;
+
+    omega = emalloc(elsize * n * l);
+    y = emalloc(elsize * m * l);
+    z = emalloc(elsize * n * l);
+    ndarray_rsvd_gaussian(omega, (long)n * l, is_double);
+
+    // Y = A Omega, Q = qr(Y)
+    ndarray_rsvd_gemm(is_double, 0, 0, m, l, n, a, n, omega, l, y, l);
+    info = ndarray_rsvd_orthonormalize(is_double, y, m, l);
+    for (it = 0; it < power_iterations && info == 0; it++) {
+        // Z = qr(A^T Q), Q = qr(A Z)
+        ndarray_rsvd_gemm(is_double, 1, 0, n, l, m, a, n, y, l, z, l);
+        info = ndarray_rsvd_orthonormalize(is_double, z, n, l);
+        if (info == 0) {
+            ndarray_rsvd_gemm(is_double, 0, 0, m, l, n, a, n, z, l, y, l);
+            info = ndarray_rsvd_orthonormalize(is_double, y, m, l);
+        }
+    }
+    efree(omega);
+    efree(z);
+
+    b = emalloc(elsize * l * n);
+    s = emalloc(elsize * l);
+    ub = emalloc(elsize * l * l);
+    vt = emalloc(elsize * l * n);
+    if (info == 0) {
+        // B = Q^T A = Ub S Vt
+        ndarray_rsvd_gemm(is_double, 1, 0, l, n, m, y, l, a, n, b, n);
+        if (is_double) {
+            info = LAPACKE_dgesdd(LAPACK_ROW_MAJOR, 'S', l, n, (double *) b, n, (double *) s,
+                                  (double *) ub, l, (double *) vt, n);
+        } else {
+            info = LAPACKE_sgesdd(LAPACK_ROW_MAJOR, 'S', l, n, (float *) b, n, (float *) s,
+                                  (float *) ub, l, (float *) vt, n);
+        }
+    }
     if (info != 0) {
-        zend_throw_error(NULL, "Matrix inversion failed.\n");
+        zend_throw_error(NULL, "SVD computation did not converge.");
+    } else {
+        rtns = emalloc(sizeof(NDArray*) * 3);
+        shape = emalloc(sizeof(int) * 2);
+        shape[0] = m;
+        shape[1] = k;
+        rtns[0] = NDArray_Empty(shape, 2, type, NDARRAY_DEVICE_CPU);
+        // U = Q Ub, keeping the leading k columns of Ub
+        ndarray_rsvd_gemm(is_double, 0, 0, m, k, l, y, l, ub, l, NDArray_DATA(rtns[0]), k);
+        shape = emalloc(sizeof(int));
+        shape[0] = k;
+        rtns[1] = NDArray_Empty(shape, 1, type, NDARRAY_DEVICE_CPU);
+        memcpy(NDArray_DATA(rtns[1]), s, elsize * k);
+        shape = emalloc(sizeof(int) * 2);
+        shape[0] = k;
+        shape[1] = n;
+        rtns[2] = NDArray_Empty(shape, 2, type, NDARRAY_DEVICE_CPU);
+        memcpy(NDArray_DATA(rtns[2]), vt, elsize * k * n);
+        if (NDArray_DEVICE(target) == NDARRAY_DEVICE_GPU) {
+            for (it = 0; it < 3; it++) {
+                NDArray *gpu = NDArray_ToGPU(rtns[it]);
+                NDArray_FREE(rtns[it]);
+                rtns[it] = gpu;
+            }
+        }
+    }
+    efree(y);
+    efree(b);
+    efree(s);
+    efree(ub);
+    efree(vt);
+    if (cast != NULL) {
+        NDArray_FREE(cast);
+    }
+    if (input != target) {
+        NDArray_FREE(input);
+    }
+    return rtns;
+}
+
+/**
+ * Calculate the inverse of a square NDArray or of every matrix of a
+ * stack (..., n, n)
+ *
+ * @param target
+ * @return float64 for float64 inputs, float32 otherwise
+ */
+NDArray*
+NDArray_Inverse(NDArray* target) {
+    ndarray_batch batch;
+    int singular = 0, n, *ipiv;
+    long i, size, lwork;
+    char *work;
+
+    if (NDArray_DEVICE(target) == NDARRAY_DEVICE_GPU && NDArray_NDIM(target) == 2 &&
+            is_type(NDArray_TYPE(target), NDARRAY_TYPE_FLOAT32) &&
+            NDArray_SHAPE(target)[0] == NDArray_SHAPE(target)[1]) {
+#ifdef HAVE_CUBLAS
+        NDArray *rtn = NDArray_Copy(target, NDArray_DEVICE(target));
+        cuda_matrix_float_inverse(NDArray_FDATA(rtn), NDArray_SHAPE(rtn)[0]);
+        return rtn;
+#endif
+    }
+    if (ndarray_batch_init(&batch, target, is_type(NDArray_TYPE(target), NDARRAY_TYPE_DOUBLE64)) < 0) {
+        return NULL;
+    }
+    n = batch.n;
+    size = (long)n * n;
+
+    if (n <= NDARRAY_BATCH_CLOSED_MAX) {
+#pragma omp parallel for if (ndarray_batch_parallel(&batch)) reduction(|:singular)
+        for (i = 0; i < batch.count; i++) {
+            double m[16], inv[16], det;
+            char *matrix = ndarray_batch_at(&batch, NDArray_DATA(batch.work), i * size);
+            ndarray_batch_load(&batch, matrix, m, size);
+            det = ndarray_small_inverse(m, n, inv);
+            if (ndarray_small_singular(m, n, det, batch.is_double ? DBL_EPSILON : FLT_EPSILON)) {
+                singular |= 1;
+                continue;
+            }
+            ndarray_batch_store(&batch, matrix, inv, size);
+        }
+    } else {
+        // The workspace of every thread is allocated up front, the Zend
+        // allocator is not thread safe
+        lwork = (long)n * NDARRAY_BATCH_GETRI_BLOCK;
+        ipiv = emalloc(sizeof(int) * n * ndarray_batch_threads());
+        work = emalloc((batch.is_double ? sizeof(double) : sizeof(float)) * lwork * ndarray_batch_threads());
+#pragma omp parallel for if (ndarray_batch_parallel(&batch)) reduction(|:singular)
+        for (i = 0; i < batch.count; i++) {
+            int thread = ndarray_batch_thread_id(), info;
+            int *piv = ipiv + (long)n * thread;
+            char *matrix = ndarray_batch_at(&batch, NDArray_DATA(batch.work), i * size);
+            char *scratch = ndarray_batch_at(&batch, work, lwork * thread);
+
+            if (ndarray_batch_getrf(&batch, matrix, piv) != 0) {
+                singular |= 1;
+                continue;
+            }
+            if (batch.is_double) {
+                info = LAPACKE_dgetri_work(LAPACK_COL_MAJOR, n, (double *) matrix, n, piv, (double *) scratch, (int) lwork);
+            } else {
+                info = LAPACKE_sgetri_work(LAPACK_COL_MAJOR, n, (float *) matrix, n, piv, (float *) scratch, (int) lwork);
+            }
+            singular |= info != 0;
+        }
         efree(ipiv);
-        return 0;
+        efree(work);
     }
-    efree(ipiv);
-    return 1;
+    if (singular) {
+        zend_throw_error(NULL, "Singular matrix, unable to compute the matrix inverse.");
+        NDArray_FREE(batch.work);
+        return NULL;
+    }
+    return ndarray_batch_output(target, batch.work);
 }
 
 /**
+ * LU factorization with partial pivoting, P @ A = L @ U, computed by
+ * LAPACK's blocked getrf. float64 inputs are factored in double
+ * precision, every other dtype in float32.
  *
- * @param matrix
- * @param n
- * @return 1 if succeeded, 0 if failed
+ * @param a 2-D NDArray on CPU
+ * @return NULL with an exception thrown on failure
+ */
+NDArrayLUFactor*
+NDArray_LUFactor(NDArray *a) {
+    NDArrayLUFactor *f;
+    NDArray *matrix;
+    int m, n, i, j, info;
+    const char *type;
+
+    if (NDArray_NDIM(a) != 2) {
+        zend_throw_error(NULL, "Array must be two-dimensional");
+        return NULL;
+    }
+    if (NDArray_DEVICE(a) == NDARRAY_DEVICE_GPU) {
+        zend_throw_error(NULL, "LU factorization is only available for NDArrays on CPU RAM.");
+        return NULL;
+    }
+    type = is_type(NDArray_TYPE(a), NDARRAY_TYPE_DOUBLE64) ? NDARRAY_TYPE_DOUBLE64 : NDARRAY_TYPE_FLOAT32;
+    matrix = NDArray_AsType(a, type);
+    if (matrix == NULL) {
+        return NULL;
+    }
+    m = NDArray_SHAPE(a)[0];
+    n = NDArray_SHAPE(a)[1];
+
+    f = emalloc(sizeof(NDArrayLUFactor));
+    f->m = m;
+    f->n = n;
+    f->type = type;
+    f->singular = 0;
+    f->ipiv = emalloc(sizeof(int) * (m < n ? (m > 0 ? m : 1) : (n > 0 ? n : 1)));
+    f->lu = emalloc((size_t)get_type_size(type) * (m * n > 0 ? m * n : 1));
+    // getrf works on column-major storage
+    if (is_type(type, NDARRAY_TYPE_DOUBLE64)) {
+        for (i = 0; i < m; i++) {
+            for (j = 0; j < n; j++) {
+                ((double *) f->lu)[j * m + i] = NDArray_DDATA(matrix)[i * n + j];
+            }
+        }
+        if (m > 0 && n > 0) {
+            dgetrf_(&m, &n, (double *) f->lu, &m, f->ipiv, &info);
+        } else {
+            info = 0;
+        }
+    } else {
+        for (i = 0; i < m; i++) {
+            for (j = 0; j < n; j++) {
+                ((float *) f->lu)[j * m + i] = NDArray_FDATA(matrix)[i * n + j];
+            }
+        }
+        if (m > 0 && n > 0) {
+            sgetrf_(&m, &n, (float *) f->lu, &m, f->ipiv, &info);
+        } else {
+            info = 0;
+        }
+    }
+    NDArray_FREE(matrix);
+    if (info < 0) {
+        zend_throw_error(NULL, "Error in LU decomposition. Code: %d", info);
+        NDArray_LUFactorFree(f);
+        return NULL;
+    }
+    // U has an exact zero on its diagonal, solving is impossible
+    f->singular = info > 0;
+    return f;
+}
+
+void
+NDArray_LUFactorFree(NDArrayLUFactor *f) {
+    if (f == NULL) {
+        return;
+    }
+    efree(f->lu);
+    efree(f->ipiv);
+    efree(f);
+}
+
+/**
+ * Row permutation of the factorization as an int64 vector: row i of
+ * L @ U is row perm[i] of A
+ *
+ * @param f
+ * @return
  */
-int
-matrixFloatLU(float* matrix, int n, float *p, float *l, float *u) {
-    int i, j, k, maxIndex;
-    float maxVal, tempVal;
+NDArray*
+NDArray_LUFactorPermutation(NDArrayLUFactor *f) {
+    int *shape = emalloc(sizeof(int));
+    int i, k = f->m < f->n ? f->m : f->n;
+    NDArray *rtn;
+    int64_t *perm, t;
+
+    shape[0] = f->m;
+    rtn = NDArray_Empty(shape, 1, NDARRAY_TYPE_INT64, NDARRAY_DEVICE_CPU);
+    perm = (int64_t *) NDArray_DATA(rtn);
+    for (i = 0; i < f->m; i++) {
+        perm[i] = i;
+    }
+    // Replay the row interchanges recorded by getrf
+    for (i = 0; i < k; i++) {
+        t = perm[i];
+        perm[i] = perm[f->ipiv[i] - 1];
+        perm[f->ipiv[i] - 1] = t;
+    }
+    return rtn;
+}
+
+/**
+ * Explicit permutation matrix P with P @ A = L @ U
+ *
+ * @param f
+ * @return
+ */
+NDArray*
+NDArray_LUFactorPMatrix(NDArrayLUFactor *f) {
+    int *shape = emalloc(sizeof(int) * 2);
+    NDArray *perm = NDArray_LUFactorPermutation(f), *rtn;
+    const NDArrayTypeFuncs *funcs = NDArray_TypeFuncs(f->type);
+    int i;
+
+    shape[0] = f->m;
+    shape[1] = f->m;
+    rtn = NDArray_Zeros(shape, 2, f->type, NDARRAY_DEVICE_CPU);
+    for (i = 0; i < f->m; i++) {
+        funcs->setitem(NDArray_DATA(rtn) + ((long) i * f->m + ((int64_t *) NDArray_DATA(perm))[i]) * funcs->elsize, 1);
+    }
+    NDArray_FREE(perm);
+    return rtn;
+}
+
+/**
+ * Unit lower triangular factor L, m x min(m, n)
+ *
+ * @param f
+ * @return
+ */
+NDArray*
+NDArray_LUFactorLower(NDArrayLUFactor *f) {
+    int *shape = emalloc(sizeof(int) * 2);
+    int i, j, k = f->m < f->n ? f->m : f->n;
+    NDArray *rtn;
 
-    // Initialize L, U, and P matrices
-    for (i = 0; i < n; i++) {
-        for (j = 0; j < n; j++) {
-            if (i == j) {
-                l[i * n + j] = 1.0f;
-                u[i * n + j] = matrix[i * n + j];
+    shape[0] = f->m;
+    shape[1] = k;
+    rtn = NDArray_Zeros(shape, 2, f->type, NDARRAY_DEVICE_CPU);
+    for (i = 0; i < f->m; i++) {
+        for (j = 0; j < k && j <= i; j++) {
+            if (is_type(f->type, NDARRAY_TYPE_DOUBLE64)) {
+                NDArray_DDATA(rtn)[i * k + j] = i == j ? 1.0 : ((double *) f->lu)[j * f->m + i];
             } else {
-                l[i * n + j] = 0.0f;
-                u[i * n + j] = matrix[i * n + j];
+                NDArray_FDATA(rtn)[i * k + j] = i == j ? 1.0f : ((float *) f->lu)[j * f->m + i];
             }
-            p[i * n + j] = (i == j) ? 1.0f : 0.0f;
         }
     }
+    return rtn;
+}
 
-    // Perform LU decomposition with partial pivoting
-    for (k = 0; k < n - 1; k++) {
-        maxIndex = k;
-        maxVal = u[k * n + k];
-
-        // Find the row with the maximum value in the current column
-        for (i = k + 1; i < n; i++) {
-            if (u[i * n + k] > maxVal) {
-                maxIndex = i;
-                maxVal = u[i * n + k];
-            }
-        }
-
-        // Swap rows in U matrix
-        if (maxIndex != k) {
-            for (j = 0; j < n; j++) {
-                tempVal = u[k * n + j];
-                u[k * n + j] = u[maxIndex * n + j];
-                u[maxIndex * n + j] = tempVal;
-
-                tempVal = p[k * n + j];
-                p[k * n + j] = p[maxIndex * n + j];
-                p[maxIndex * n + j] = tempVal;
-            }
-        }
+/**
+ * Upper triangular factor U, min(m, n) x n
+ *
+ * @param f
+ * @return
+ */
+NDArray*
+NDArray_LUFactorUpper(NDArrayLUFactor *f) {
+    int *shape = emalloc(sizeof(int) * 2);
+    int i, j, k = f->m < f->n ? f->m : f->n;
+    NDArray *rtn;
 
-        // Perform elimination in U matrix and store multipliers in L matrix
-        for (i = k + 1; i < n; i++) {
-            l[i * n + k] = u[i * n + k] / u[k * n + k];
-            for (j = k; j < n; j++) {
-                u[i * n + j] -= l[i * n + k] * u[k * n + j];
+    shape[0] = k;
+    shape[1] = f->n;
+    rtn = NDArray_Zeros(shape, 2, f->type, NDARRAY_DEVICE_CPU);
+    for (i = 0; i < k; i++) {
+        for (j = i; j < f->n; j++) {
+            if (is_type(f->type, NDARRAY_TYPE_DOUBLE64)) {
+                NDArray_DDATA(rtn)[i * f->n + j] = ((double *) f->lu)[j * f->m + i];
+            } else {
+                NDArray_FDATA(rtn)[i * f->n + j] = ((float *) f->lu)[j * f->m + i];
             }
         }
     }
+    return rtn;
 }
 
 /**
- * Calculate the inverse of a square NDArray
+ * Solve A @ x = b reusing a factorization of a square A
  *
- * @param target
- * @return
+ * @param f
+ * @param b Vector of length n or n x k matrix
+ * @return x with the shape of b, NULL with an exception thrown on failure
  */
 NDArray*
-NDArray_Inverse(NDArray* target) {
-    int info;
-    NDArray *rtn = NDArray_Copy(target, NDArray_DEVICE(target));
-    if (NDArray_NDIM(target) != 2) {
-        zend_throw_error(NULL, "Array must be at least two-dimensional");
-        NDArray_FREE(rtn);
+NDArray_LUFactorSolve(NDArrayLUFactor *f, NDArray *b) {
+    NDArray *rhs, *rtn;
+    int *shape, n = f->n, nrhs, i, j, info;
+
+    if (f->m != f->n) {
+        zend_throw_error(NULL, "Solving requires the factorization of a square matrix");
         return NULL;
     }
-
-    if (NDArray_SHAPE(target)[0] != NDArray_SHAPE(target)[1]) {
-        zend_throw_error(NULL, "Array must be square");
-        NDArray_FREE(rtn);
+    if (f->singular) {
+        zend_throw_error(NULL, "Matrix is singular.");
         return NULL;
     }
-
-    if (NDArray_DEVICE(target) == NDARRAY_DEVICE_CPU) {
-        // CPU INVERSE CALL
-        info = matrixFloatInverse(NDArray_FDATA(rtn), NDArray_SHAPE(rtn)[0]);
-        if (!info) {
-            NDArray_FREE(rtn);
-            return NULL;
+    if (NDArray_DEVICE(b) == NDARRAY_DEVICE_GPU) {
+        zend_throw_error(NULL, "LU factorization is only available for NDArrays on CPU RAM.");
+        return NULL;
+    }
+    if ((NDArray_NDIM(b) != 1 && NDArray_NDIM(b) != 2) || NDArray_SHAPE(b)[0] != n) {
+        zend_throw_error(NULL, "Incompatible shapes");
+        return NULL;
+    }
+    nrhs = NDArray_NDIM(b) == 2 ? NDArray_SHAPE(b)[1] : 1;
+    rhs = NDArray_AsType(b, f->type);
+    if (rhs == NULL) {
+        return NULL;
+    }
+    shape = emalloc(sizeof(int) * NDArray_NDIM(b));
+    memcpy(shape, NDArray_SHAPE(b), sizeof(int) * NDArray_NDIM(b));
+    rtn = NDArray_Empty(shape, NDArray_NDIM(b), f->type, NDARRAY_DEVICE_CPU);
+    if (n == 0 || nrhs == 0) {
+        NDArray_FREE(rhs);
+        return rtn;
+    }
+    // getrs reads and writes column-major right hand sides
+    if (is_type(f->type, NDARRAY_TYPE_DOUBLE64)) {
+        double *x = emalloc(sizeof(double) * n * nrhs);
+        for (i = 0; i < n; i++) {
+            for (j = 0; j < nrhs; j++) {
+                x[j * n + i] = NDArray_DDATA(rhs)[i * nrhs + j];
+            }
         }
+        info = LAPACKE_dgetrs(LAPACK_COL_MAJOR, 'N', n, nrhs, (double *) f->lu, n, f->ipiv, x, n);
+        for (i = 0; i < n; i++) {
+            for (j = 0; j < nrhs; j++) {
+                NDArray_DDATA(rtn)[i * nrhs + j] = x[j * n + i];
+            }
+        }
+        efree(x);
     } else {
-        // GPU INVERSE CALL
-#ifdef HAVE_CUBLAS
-        cuda_matrix_float_inverse(NDArray_FDATA(rtn), NDArray_SHAPE(rtn)[0]);
-#endif
+        float *x = emalloc(sizeof(float) * n * nrhs);
+        for (i = 0; i < n; i++) {
+            for (j = 0; j < nrhs; j++) {
+                x[j * n + i] = NDArray_FDATA(rhs)[i * nrhs + j];
+            }
+        }
+        info = LAPACKE_sgetrs(LAPACK_COL_MAJOR, 'N', n, nrhs, (float *) f->lu, n, f->ipiv, x, n);
+        for (i = 0; i < n; i++) {
+            for (j = 0; j < nrhs; j++) {
+                NDArray_FDATA(rtn)[i * nrhs + j] = x[j * n + i];
+            }
+        }
+        efree(x);
+    }
+    NDArray_FREE(rhs);
+    if (info != 0) {
+        zend_throw_error(NULL, "Error in LU solve. Code: %d", info);
+        NDArray_FREE(rtn);
+        return NULL;
     }
-
     return rtn;
 }
 
 /**
- * Calculate the inverse of a square NDArray
+ * LU decomposition P @ A = L @ U
  *
  * @param target
- * @return
+ * @param explicit_p Return P as a matrix instead of the int64 row permutation vector
+ * @return [P or permutation, L, U]
  */
 NDArray**
-NDArray_LU(NDArray* target) {
+NDArray_LU(NDArray* target, int explicit_p) {
+    NDArrayLUFactor *f;
+    NDArray **rtns, *cpu = target;
+    int i;
+
     if (NDArray_NDIM(target) != 2) {
-        zend_throw_error(NULL, "Array must be at least two-dimensional");
+        zend_throw_error(NULL, "Array must be two-dimensional");
         return NULL;
     }
-    if (NDArray_SHAPE(target)[0] != NDArray_SHAPE(target)[1]) {
-        zend_throw_error(NULL, "Array must be square");
+    if (NDArray_DEVICE(target) == NDARRAY_DEVICE_GPU) {
+        cpu = NDArray_ToCPU(target);
+    }
+    f = NDArray_LUFactor(cpu);
+    if (cpu != target) {
+        NDArray_FREE(cpu);
+    }
+    if (f == NULL) {
         return NULL;
     }
-    NDArray **rtns = emalloc(sizeof(NDArray*) * 3);
-    int info;
-    int *new_shape_p = emalloc(sizeof(int) * NDArray_NDIM(target));
-    int *new_shape_l = emalloc(sizeof(int) * NDArray_NDIM(target));
-    int *new_shape_u = emalloc(sizeof(int) * NDArray_NDIM(target));
-    memcpy(new_shape_p, NDArray_SHAPE(target), sizeof(int) * (int)NDArray_NDIM(target));
-    memcpy(new_shape_l, NDArray_SHAPE(target), sizeof(int) * (int)NDArray_NDIM(target));
-    memcpy(new_shape_u, NDArray_SHAPE(target), sizeof(int) * (int)NDArray_NDIM(target));
-    NDArray *copied = NDArray_Copy(target, NDArray_DEVICE(target));
-    NDArray *p = NDArray_Empty(new_shape_p, NDArray_NDIM(target), NDARRAY_TYPE_FLOAT32, NDArray_DEVICE(target));
-    NDArray *l = NDArray_Empty(new_shape_l, NDArray_NDIM(target), NDARRAY_TYPE_FLOAT32, NDArray_DEVICE(target));
-    NDArray *u = NDArray_Empty(new_shape_u, NDArray_NDIM(target), NDARRAY_TYPE_FLOAT32, NDArray_DEVICE(target));
-
-    if (NDArray_DEVICE(target) == NDARRAY_DEVICE_CPU) {
-        // CPU INVERSE CALL
-        info = matrixFloatLU(NDArray_FDATA(copied),
-                             NDArray_SHAPE(copied)[0],
-                             NDArray_FDATA(p),
-                             NDArray_FDATA(l),
-                             NDArray_FDATA(u));
-        if (!info) {
-            NDArray_FREE(copied);
-            return NULL;
+    rtns = emalloc(sizeof(NDArray*) * 3);
+    rtns[0] = explicit_p ? NDArray_LUFactorPMatrix(f) : NDArray_LUFactorPermutation(f);
+    rtns[1] = NDArray_LUFactorLower(f);
+    rtns[2] = NDArray_LUFactorUpper(f);
+    NDArray_LUFactorFree(f);
+    if (NDArray_DEVICE(target) == NDARRAY_DEVICE_GPU) {
+        // Factors go back to the device of the input
+        for (i = 0; i < 3; i++) {
+            NDArray *gpu = NDArray_ToGPU(rtns[i]);
+            NDArray_FREE(rtns[i]);
+            rtns[i] = gpu;
         }
-    } else {
-        // GPU INVERSE CALL
-#ifdef HAVE_CUBLAS
-        cuda_float_lu(NDArray_FDATA(copied), NDArray_FDATA(l), NDArray_FDATA(u), NDArray_FDATA(p), NDArray_SHAPE(copied)[0]);
-#endif
     }
-    NDArray_FREE(copied);
-    rtns[0] = p;
-    rtns[1] = l;
-    rtns[2] = u;
     return rtns;
 }
 
@@ -666,52 +2015,42 @@ NDArray_LU(NDArray* target) {
  */
 NDArray*
 NDArray_MatrixRank(NDArray *target, float *tol) {
-    float mtol;
-    int rank = 0, i;
-    NDArray *rtn;
-    NDArray **svd = NDArray_SVD(target);
-    float *singular_values;
+    NDArray *input;
+    double *values, mtol;
+    int rank = 0, i, k, m, n;
 
-    if (NDArray_DEVICE(target) == NDARRAY_DEVICE_CPU) {
-        singular_values = NDArray_FDATA(svd[1]);
-    } else {
-#ifdef HAVE_CUBLAS
-        singular_values = emalloc(sizeof(float) * NDArray_NUMELEMENTS(target));
-        cudaMemcpy(singular_values, NDArray_FDATA(svd[1]), sizeof(float) * NDArray_NUMELEMENTS(svd[1]), cudaMemcpyDeviceToHost);
-#endif
+    if (NDArray_NDIM(target) != 2) {
+        zend_throw_error(NULL, "Array must be two-dimensional");
+        return NULL;
+    }
+    m = NDArray_SHAPE(target)[0];
+    n = NDArray_SHAPE(target)[1];
+    k = m < n ? m : n;
+    // Only the singular values are needed, U and V are never formed
+    input = ndarray_norm_input(target);
+    values = ndarray_singular_values(input);
+    if (input != target) {
+        NDArray_FREE(input);
+    }
+    if (values == NULL) {
+        return NULL;
     }
-    int minMN = (NDArray_SHAPE(target)[NDArray_NDIM(target) - 2] < (NDArray_SHAPE(target)[NDArray_NDIM(target) - 1])) ? (NDArray_SHAPE(target)[NDArray_NDIM(target) - 2]) : (NDArray_SHAPE(target)[NDArray_NDIM(target) - 1]);
 
     // Set the tolerance if not provided
     if (tol == NULL) {
-        float maxSingularValue = singular_values[0];
-        for (i = 1; i < minMN; i++) {
-            if (singular_values[i] > maxSingularValue) {
-                maxSingularValue = singular_values[i];
-            }
-        }
-        mtol = maxSingularValue * fmaxf((float)NDArray_SHAPE(target)[NDArray_NDIM(target) - 2], (float)NDArray_SHAPE(target)[NDArray_NDIM(target) - 1]) * FLT_EPSILON;
+        mtol = (k > 0 ? values[0] : 0) * (m > n ? m : n) *
+               (is_type(NDArray_TYPE(target), NDARRAY_TYPE_DOUBLE64) ? DBL_EPSILON : FLT_EPSILON);
     } else {
         mtol = *tol;
     }
 
-    for (i = 0; i < minMN; i++) {
-        if (singular_values[i] > mtol) {
+    for (i = 0; i < k; i++) {
+        if (values[i] > mtol) {
             rank++;
         }
     }
-
-    NDArray_FREE(svd[0]);
-    NDArray_FREE(svd[1]);
-    NDArray_FREE(svd[2]);
-    efree(svd);
-    rtn = NDArray_CreateFromLongScalar((int)rank);
-
-    if (NDArray_DEVICE(target) == NDARRAY_DEVICE_GPU) {
-        efree(singular_values);
-    }
-
-    return rtn;
+    efree(values);
+    return NDArray_CreateFromLongScalar(rank);
 }
 
 /**
@@ -732,21 +2071,42 @@ NDArray_Outer(NDArray *a, NDArray *b) {
         zend_throw_error(NULL, "NDArray::outer() requires both arrays to be on the same device (CPU or GPU).");
         return NULL;
     }
+    int is_double = ndarray_linalg_is_double(a, b);
     int *output_shape = emalloc(sizeof(int) * 2);
     output_shape[0] = NDArray_NUMELEMENTS(a);
     output_shape[1] = NDArray_NUMELEMENTS(b);
-    NDArray *rtn = NDArray_Zeros(output_shape, 2, NDArray_TYPE(a), NDArray_DEVICE(a));
     if (NDArray_DEVICE(a) == NDARRAY_DEVICE_CPU) {
+        NDArray *a_op = ndarray_linalg_operand(a, is_double), *b_op = ndarray_linalg_operand(b, is_double);
+        NDArray *rtn = NULL;
+        if (a_op != NULL && b_op != NULL) {
+            rtn = NDArray_Zeros(output_shape, 2, is_double ? NDARRAY_TYPE_DOUBLE64 : NDARRAY_TYPE_FLOAT32,
+                                NDARRAY_DEVICE_CPU);
 #ifdef HAVE_CBLAS
-        cblas_sger(CblasRowMajor, NDArray_NUMELEMENTS(a), NDArray_NUMELEMENTS(b), 1.0f, NDArray_FDATA(a), 1, NDArray_FDATA(b), 1,
-                   NDArray_FDATA(rtn), NDArray_NUMELEMENTS(b));
+            if (is_double) {
+                cblas_dger(CblasRowMajor, output_shape[0], output_shape[1], 1.0, NDArray_DDATA(a_op), 1,
+                           NDArray_DDATA(b_op), 1, NDArray_DDATA(rtn), output_shape[1] > 1 ? output_shape[1] : 1);
+            } else {
+                cblas_sger(CblasRowMajor, output_shape[0], output_shape[1], 1.0f, NDArray_FDATA(a_op), 1,
+                           NDArray_FDATA(b_op), 1, NDArray_FDATA(rtn), output_shape[1] > 1 ? output_shape[1] : 1);
+            }
 #endif
-    } else {
+        } else {
+            efree(output_shape);
+        }
+        ndarray_linalg_release(a_op, a);
+        ndarray_linalg_release(b_op, b);
+        return rtn;
+    }
+    if (!is_type(NDArray_TYPE(a), NDARRAY_TYPE_FLOAT32) || !is_type(NDArray_TYPE(b), NDARRAY_TYPE_FLOAT32)) {
+        efree(output_shape);
+        zend_throw_error(NULL, "outer is only available for float32 NDArrays on the GPU.");
+        return NULL;
+    }
+    NDArray *rtn = NDArray_Zeros(output_shape, 2, NDARRAY_TYPE_FLOAT32, NDArray_DEVICE(a));
 #ifdef HAVE_CUBLAS
-        cuda_calculate_outer_product(NDArray_NUMELEMENTS(a), NDArray_NUMELEMENTS(b), NDArray_FDATA(a), NDArray_FDATA(b),
-                                     NDArray_FDATA(rtn));
+    cuda_calculate_outer_product(NDArray_NUMELEMENTS(a), NDArray_NUMELEMENTS(b), NDArray_FDATA(a), NDArray_FDATA(b),
+                                 NDArray_FDATA(rtn));
 #endif
-    }
     return rtn;
 }
 
@@ -757,83 +2117,200 @@ NDArray_Outer(NDArray *a, NDArray *b) {
  */
 NDArray*
 NDArray_Trace(NDArray *a) {
-    NDArray* diagonal = NDArray_Diagonal(a, 0);
+    NDArray *diagonal = NDArray_Diagonal(a, 0), *rtn;
+    const NDArrayTypeFuncs *funcs;
     if (diagonal == NULL) {
         return NULL;
     }
-    float result = NDArray_Sum_Float(diagonal);
+    funcs = NDArray_TypeFuncs(NDArray_TYPE(diagonal));
+    if (is_type(NDArray_TYPE(diagonal), NDARRAY_TYPE_FLOAT32)) {
+        rtn = NDArray_CreateFromFloatScalar(NDArray_Sum_Float(diagonal));
+    } else if (is_type(NDArray_TYPE(diagonal), NDARRAY_TYPE_DOUBLE64)) {
+        rtn = NDArray_CreateFromDoubleScalar(NDArray_Sum(diagonal));
+    } else if (funcs->kind == NDARRAY_KIND_FLOAT) {
+        rtn = NDArray_CreateFromFloatScalar((float) NDArray_Sum(diagonal));
+    } else {
+        rtn = NDArray_CreateFromLongScalar((long) NDArray_Sum(diagonal));
+    }
     NDArray_FREE(diagonal);
-    return NDArray_CreateFromFloatScalar(result);
+    return rtn;
 }
 
-int
-computeEigenvaluesAndEigenvectorsFloat(NDArray* array, NDArray* rightEigenvectors,
-                                       NDArray* eigenvalues, NDArray *wivectors, NDArray *leftEigenvectors) {
-    // Assuming 'array' contains the input square matrix
-    int n = array->dimensions[0]; // Size of the square matrix
-
-    // Compute eigenvalues and right eigenvectors using LAPACK function
-    int info = LAPACKE_sgeev(LAPACK_ROW_MAJOR, 'N', 'V', n, NDArray_FDATA(array), n,
-                             NDArray_FDATA(rightEigenvectors), NDArray_FDATA(wivectors), NDArray_FDATA(leftEigenvectors),
-                             n, NDArray_FDATA(eigenvalues),n);
+/**
+ * Eigenvalues, in ascending order, of a symmetric matrix and optionally
+ * the matching eigenvectors as the columns of `vectors`. Only the lower
+ * triangle is read. The full spectrum uses the divide and conquer
+ * driver (syevd), a subset of indices [il, iu] uses the MRRR driver
+ * (syevr) and skips the unwanted eigenpairs.
+ *
+ * @param a
+ * @param il index of the smallest wanted eigenvalue, from 0
+ * @param iu index of the largest wanted eigenvalue
+ * @param vectors NULL to compute the eigenvalues only
+ * @return
+ */
+NDArray*
+NDArray_Eigh(NDArray *a, int il, int iu, NDArray **vectors) {
+    const NDArrayTypeFuncs *funcs = NDArray_TypeFuncs(NDArray_TYPE(a));
+    int n, k, found = 0, info = 0, is_double, *shape, *isuppz;
+    char jobz = vectors != NULL ? 'V' : 'N';
+    const char *type;
+    NDArray *input, *w, *v = NULL;
+    size_t elsize;
+    char *work, *values, *z = NULL;
 
-    // Check if the computation was successful (info == 0)
+    if (NDArray_NDIM(a) != 2 || NDArray_SHAPE(a)[0] != NDArray_SHAPE(a)[1]) {
+        zend_throw_error(NULL, "Array must be square");
+        return NULL;
+    }
+    if (funcs == NULL) {
+        zend_throw_error(NULL, "eigh not supported for dtype %s.", NDArray_TYPE(a));
+        return NULL;
+    }
+    n = NDArray_SHAPE(a)[0];
+    if (n > 0 && (il < 0 || iu >= n || il > iu)) {
+        zend_throw_error(NULL, "Eigenvalue subset [%d, %d] is out of bounds for a %dx%d matrix.", il, iu, n, n);
+        return NULL;
+    }
+    k = n > 0 ? iu - il + 1 : 0;
+    is_double = is_type(NDArray_TYPE(a), NDARRAY_TYPE_DOUBLE64);
+    type = is_double ? NDARRAY_TYPE_DOUBLE64 : NDARRAY_TYPE_FLOAT32;
+    elsize = is_double ? sizeof(double) : sizeof(float);
+    input = ndarray_norm_input(a);
+    work = emalloc(elsize * ((size_t)n * n > 0 ? (size_t)n * n : 1));
+    if (is_double) {
+        memcpy(work, NDArray_DDATA(input), sizeof(double) * n * n);
+    } else {
+        funcs->to_float32(NDArray_DATA(input), NDArray_ELSIZE(input), (float *) work, (long)n * n);
+    }
+    if (input != a) {
+        NDArray_FREE(input);
+    }
+    values = emalloc(elsize * (n > 0 ? n : 1));
+    if (n > 0 && k == n) {
+        info = is_double ? LAPACKE_dsyevd(LAPACK_ROW_MAJOR, jobz, 'L', n, (double *) work, n, (double *) values)
+                         : LAPACKE_ssyevd(LAPACK_ROW_MAJOR, jobz, 'L', n, (float *) work, n, (float *) values);
+    } else if (n > 0) {
+        isuppz = emalloc(sizeof(int) * 2 * k);
+        if (vectors != NULL) {
+            z = emalloc(elsize * n * k);
+        }
+        info = is_double
+               ? LAPACKE_dsyevr(LAPACK_ROW_MAJOR, jobz, 'I', 'L', n, (double *) work, n, 0, 0, il + 1, iu + 1,
+                                0, &found, (double *) values, (double *) z, k, isuppz)
+               : LAPACKE_ssyevr(LAPACK_ROW_MAJOR, jobz, 'I', 'L', n, (float *) work, n, 0, 0, il + 1, iu + 1,
+                                0, &found, (float *) values, (float *) z, k, isuppz);
+        efree(isuppz);
+    }
     if (info != 0) {
-        zend_throw_error(NULL, "Error computing eigenvalues and eigenvectors.\n");
-        return 0;
+        zend_throw_error(NULL, "Eigenvalue computation did not converge.");
+        efree(work);
+        efree(values);
+        if (z != NULL) {
+            efree(z);
+        }
+        return NULL;
     }
-    return 1;
+    shape = emalloc(sizeof(int));
+    shape[0] = k;
+    w = NDArray_Empty(shape, 1, type, NDARRAY_DEVICE_CPU);
+    memcpy(NDArray_DATA(w), values, elsize * k);
+    if (vectors != NULL) {
+        shape = emalloc(sizeof(int) * 2);
+        shape[0] = n;
+        shape[1] = k;
+        v = NDArray_Empty(shape, 2, type, NDARRAY_DEVICE_CPU);
+        memcpy(NDArray_DATA(v), z != NULL ? z : work, elsize * n * k);
+    }
+    efree(work);
+    efree(values);
+    if (z != NULL) {
+        efree(z);
+    }
+    if (NDArray_DEVICE(a) == NDARRAY_DEVICE_GPU) {
+        NDArray *gpu = NDArray_ToGPU(w);
+        NDArray_FREE(w);
+        w = gpu;
+        if (v != NULL) {
+            gpu = NDArray_ToGPU(v);
+            NDArray_FREE(v);
+            v = gpu;
+        }
+    }
+    if (vectors != NULL) {
+        *vectors = v;
+    }
+    return w;
 }
 
 /**
  * NDArray::eig
  *
+ * With `symmetric` set the matrix is handed to NDArray_Eigh, which only
+ * reads its lower triangle and returns the eigenvalues in ascending
+ * order instead of the order geev finds them in.
+ *
  * @param a
+ * @param symmetric
  * @return
  */
 NDArray**
-NDArray_Eig(NDArray *a) {
+NDArray_Eig(NDArray *a, int symmetric) {
     if (NDArray_NDIM(a) != 2 || NDArray_SHAPE(a)[0] != NDArray_SHAPE(a)[1]) {
         zend_throw_error(NULL, "Error: Input matrix is not square.\n");
         return NULL;
     }
     NDArray **rtn = emalloc(sizeof(NDArray*) * 2);
-    NDArray* eigenvalues, *rightEigenvectors, *wivectors, *leftEigenvectors;
-    int *eigenvalues_shape, *rightEigenvectors_shape, *wivectors_shape, *leftEigenvectors_shape;
-
-    rightEigenvectors_shape = emalloc(sizeof(int));
-    rightEigenvectors_shape[0] = NDArray_SHAPE(a)[0];
-
-    rightEigenvectors = NDArray_Zeros(rightEigenvectors_shape, 1, NDArray_TYPE(a), NDArray_DEVICE(a));
-    if (NDArray_DEVICE(a) == NDARRAY_DEVICE_CPU) {
-        wivectors_shape = emalloc(sizeof(int));
-        leftEigenvectors_shape = emalloc(sizeof(int));
-        eigenvalues_shape = emalloc(sizeof(int) * NDArray_NDIM(a));
-        wivectors_shape[0] = NDArray_SHAPE(a)[0];
-        eigenvalues_shape[0] = NDArray_SHAPE(a)[0];
-        eigenvalues_shape[1] = NDArray_SHAPE(a)[0];
-        leftEigenvectors_shape[0] = NDArray_SHAPE(a)[0];
-        eigenvalues = NDArray_Zeros(eigenvalues_shape, NDArray_NDIM(a), NDArray_TYPE(a), NDArray_DEVICE(a));
-        wivectors = NDArray_Zeros(wivectors_shape, 1, NDArray_TYPE(a), NDArray_DEVICE(a));
-        leftEigenvectors = NDArray_Zeros(leftEigenvectors_shape, 1, NDArray_TYPE(a), NDArray_DEVICE(a));
-        if (!computeEigenvaluesAndEigenvectorsFloat(a, rightEigenvectors, eigenvalues, wivectors, leftEigenvectors)) {
+    if (symmetric && NDArray_DEVICE(a) == NDARRAY_DEVICE_CPU && NDArray_SHAPE(a)[0] > 0) {
+        rtn[0] = NDArray_Eigh(a, 0, NDArray_SHAPE(a)[0] - 1, &rtn[1]);
+        if (rtn[0] == NULL) {
             efree(rtn);
             return NULL;
         }
-        NDArray_FREE(leftEigenvectors);
-        NDArray_FREE(wivectors);
-    } else {
-#ifdef HAVE_CUBLAS
+        return rtn;
+    }
+    if (NDArray_DEVICE(a) == NDARRAY_DEVICE_GPU) {
         efree(rtn);
-        NDArray_FREE(rightEigenvectors);
         zend_throw_error(NULL, "GPU eig currently unavailable");
         return NULL;
-        //eigenvalues = NDArray_Copy(a, NDArray_DEVICE(a));
-        //cuda_matrix_eig_float(NDArray_FDATA(eigenvalues), NDArray_SHAPE(a)[0], NDArray_FDATA(rightEigenvectors));
-#endif
     }
-    rtn[0] = rightEigenvectors;
-    rtn[1] = eigenvalues;
+
+    // Real parts of the eigenvalues and the right eigenvectors through geev
+    int n = NDArray_SHAPE(a)[0], info, is_double = ndarray_linalg_is_double(a, NULL);
+    const char *type = is_double ? NDARRAY_TYPE_DOUBLE64 : NDARRAY_TYPE_FLOAT32;
+    int *values_shape, *imaginary_shape, *vectors_shape;
+    NDArray *work, *imaginary;
+
+    // geev overwrites its input
+    work = NDArray_AsType(a, type);
+    if (work == NULL) {
+        efree(rtn);
+        return NULL;
+    }
+    values_shape = emalloc(sizeof(int));
+    imaginary_shape = emalloc(sizeof(int));
+    vectors_shape = emalloc(sizeof(int) * 2);
+    values_shape[0] = imaginary_shape[0] = n;
+    vectors_shape[0] = vectors_shape[1] = n;
+    rtn[0] = NDArray_Zeros(values_shape, 1, type, NDARRAY_DEVICE_CPU);
+    rtn[1] = NDArray_Zeros(vectors_shape, 2, type, NDARRAY_DEVICE_CPU);
+    imaginary = NDArray_Zeros(imaginary_shape, 1, type, NDARRAY_DEVICE_CPU);
+    if (is_double) {
+        info = LAPACKE_dgeev(LAPACK_ROW_MAJOR, 'N', 'V', n, NDArray_DDATA(work), n, NDArray_DDATA(rtn[0]),
+                             NDArray_DDATA(imaginary), NULL, n, NDArray_DDATA(rtn[1]), n);
+    } else {
+        info = LAPACKE_sgeev(LAPACK_ROW_MAJOR, 'N', 'V', n, NDArray_FDATA(work), n, NDArray_FDATA(rtn[0]),
+                             NDArray_FDATA(imaginary), NULL, n, NDArray_FDATA(rtn[1]), n);
+    }
+    NDArray_FREE(work);
+    NDArray_FREE(imaginary);
+    if (info != 0) {
+        NDArray_FREE(rtn[0]);
+        NDArray_FREE(rtn[1]);
+        efree(rtn);
+        zend_throw_error(NULL, "Error computing eigenvalues and eigenvectors.");
+        return NULL;
+    }
     return rtn;
 }
 
@@ -858,43 +2335,48 @@ NDArray_Lstsq(NDArray *a, NDArray *b) {
         return NULL;
     }
 
-    int m = a->dimensions[0]; // Number of rows of the coefficient matrix A
-    int n = a->dimensions[1]; // Number of columns of the coefficient matrix A
-    int nrhs = b->dimensions[1]; // Number of right-hand sides (columns of B)
+    int m = NDArray_SHAPE(a)[0], n = NDArray_SHAPE(a)[1], nrhs = NDArray_SHAPE(b)[1];
+    int rows = m > n ? m : n, info, is_double = ndarray_linalg_is_double(a, b);
+    const char *type = is_double ? NDARRAY_TYPE_DOUBLE64 : NDARRAY_TYPE_FLOAT32;
+    NDArray *a_work, *b_op, *b_work, *x;
+    int *b_shape, *out_shape;
 
-    int *out_shape = (int*)emalloc(2 * sizeof(int));
-    out_shape[0] = n;
-    out_shape[1] = nrhs;
-    NDArray *x = NDArray_Zeros(out_shape, 2, NDArray_TYPE(a), NDArray_DEVICE(a));
-    if (NDArray_DEVICE(a) == NDARRAY_DEVICE_CPU) {
-        // Allocate memory and copy data for the coefficient matrix A
-        float *a_data = (float *) emalloc(m * n * sizeof(float));
-        memcpy(a_data, a->data, m * n * sizeof(float));
-
-        // Allocate memory and copy data for the right-hand side matrix B
-        float *b_data = (float *) emalloc(m * nrhs * sizeof(float));
-        memcpy(b_data, b->data, m * nrhs * sizeof(float));
-
-        int info = LAPACKE_sgels(LAPACK_ROW_MAJOR, 'N', NDArray_SHAPE(a)[0], NDArray_SHAPE(a)[1], NDArray_SHAPE(b)[1],
-                                 a_data,
-                                 NDArray_SHAPE(a)[1], b_data, NDArray_SHAPE(b)[1]);
-
-        if (info > 0) {
-            zend_throw_error(NULL,
-                             "The diagonal element %i of the triangular factor of $a is zero, so that $a does not have full rank.",
-                             info);
-            return NULL;
-        }
-        // Copy the result data to the output NDArray
-        memcpy(NDArray_FDATA(x), b_data, n * nrhs * sizeof(float));
-        efree(a_data);
-        efree(b_data);
+    // gels overwrites A and returns the solution in the first n rows of B
+    a_work = NDArray_AsType(a, type);
+    b_op = ndarray_linalg_operand(b, is_double);
+    if (a_work == NULL || b_op == NULL) {
+        ndarray_linalg_release(a_work, NULL);
+        ndarray_linalg_release(b_op, b);
+        return NULL;
+    }
+    b_shape = emalloc(sizeof(int) * 2);
+    b_shape[0] = rows;
+    b_shape[1] = nrhs;
+    b_work = NDArray_Zeros(b_shape, 2, type, NDARRAY_DEVICE_CPU);
+    memcpy(NDArray_DATA(b_work), NDArray_DATA(b_op), (size_t)m * nrhs * NDArray_ELSIZE(b_work));
+    ndarray_linalg_release(b_op, b);
+
+    if (is_double) {
+        info = LAPACKE_dgels(LAPACK_ROW_MAJOR, 'N', m, n, nrhs, NDArray_DDATA(a_work), n > 1 ? n : 1,
+                             NDArray_DDATA(b_work), nrhs > 1 ? nrhs : 1);
     } else {
-#ifdef HAVE_CUBLAS
-        cuda_lstsq_float(NDArray_FDATA(a), NDArray_SHAPE(a)[0], NDArray_SHAPE(a)[1], NDArray_FDATA(b), NDArray_SHAPE(b)[0],
-                         NDArray_FDATA(x));
-#endif
+        info = LAPACKE_sgels(LAPACK_ROW_MAJOR, 'N', m, n, nrhs, NDArray_FDATA(a_work), n > 1 ? n : 1,
+                             NDArray_FDATA(b_work), nrhs > 1 ? nrhs : 1);
+    }
+    NDArray_FREE(a_work);
+    if (info > 0) {
+        NDArray_FREE(b_work);
+        zend_throw_error(NULL,
+                         "The diagonal element %i of the triangular factor of $a is zero, so that $a does not have full rank.",
+                         info);
+        return NULL;
     }
+    out_shape = emalloc(sizeof(int) * 2);
+    out_shape[0] = n;
+    out_shape[1] = nrhs;
+    x = NDArray_Empty(out_shape, 2, type, NDARRAY_DEVICE_CPU);
+    memcpy(NDArray_DATA(x), NDArray_DATA(b_work), (size_t)n * nrhs * NDArray_ELSIZE(x));
+    NDArray_FREE(b_work);
     return x;
 }
 
@@ -912,58 +2394,57 @@ NDArray_Qr(NDArray *a) {
         return NULL;
     }
 
-    // Check if the input matrix is 2D
-    if (a->ndim != 2) {
+    if (NDArray_NDIM(a) != 2) {
+        zend_throw_error(NULL, "Array must be two-dimensional");
         return NULL;
     }
 
-    int m = a->dimensions[0]; // Number of rows of the matrix A
-    int n = a->dimensions[1]; // Number of columns of the matrix A
+    int m = NDArray_SHAPE(a)[0], n = NDArray_SHAPE(a)[1], i, info;
+    int is_double = ndarray_linalg_is_double(a, NULL);
+    const char *type = is_double ? NDARRAY_TYPE_DOUBLE64 : NDARRAY_TYPE_FLOAT32;
+    NDArray *q, *r, **rtn;
+    int *r_shape;
+    size_t elsize;
+    char *tau;
 
-    // Ensure that m >= n for the QR factorization
     if (m < n) {
+        zend_throw_error(NULL, "qr requires at least as many rows as columns.");
         return NULL;
     }
 
-    // Allocate memory for the result matrices Q and R
-    int *q_dimensions = (int*)emalloc(2 * sizeof(int));
-    q_dimensions[0] = m;
-    q_dimensions[1] = n;
-    NDArray* q = NDArray_Zeros(q_dimensions, 2, NDArray_TYPE(a), NDArray_DEVICE(a));
-
-    int *r_dimensions = (int*)emalloc(2 * sizeof(int));
-    r_dimensions[0] = n;
-    r_dimensions[1] = n;
-    NDArray* r = NDArray_Zeros(r_dimensions, 2, NDArray_TYPE(a), NDArray_DEVICE(a));
-
-    // Allocate memory and copy data for the matrix A
-    float* a_data = (float*)emalloc(m * n * n * sizeof(float));
-    memcpy(a_data, NDArray_FDATA(a), m * n * sizeof(float));
-
-    // Allocate memory for the workspace
-    float* tau = (float*)emalloc(n * sizeof(float));
-    int info;
-
-    // Query the optimal workspace size
-    info = LAPACKE_sgeqrf(LAPACK_ROW_MAJOR, m, n, a_data, n, tau);
-
-    // Extract the upper triangular part of the matrix A to R
-    for (int i = 0; i < n; i++) {
-        for (int j = i; j < n; j++) {
-            ((float*)r->data)[i * (r->strides[0]/NDArray_ELSIZE(r)) + j * (r->strides[1]/NDArray_ELSIZE(r))] = ((float*)a_data)[i * m + j];
-        }
+    // Reduced factorization: geqrf leaves R in the upper triangle and the
+    // reflectors below it, orgqr then expands them into Q (m, n) in place
+    q = NDArray_AsType(a, type);
+    if (q == NULL) {
+        return NULL;
     }
+    elsize = NDArray_ELSIZE(q);
+    tau = emalloc(elsize * (n > 0 ? n : 1));
+    r_shape = emalloc(sizeof(int) * 2);
+    r_shape[0] = r_shape[1] = n;
+    r = NDArray_Zeros(r_shape, 2, type, NDARRAY_DEVICE_CPU);
 
-    for (int i = 0; i < n; i++) {
-        for (int j = i + 1; j < m; j++) {
-            ((float*)q->data)[i * (q->strides[0]/NDArray_ELSIZE(q)) + j * (q->strides[1]/NDArray_ELSIZE(q))] = ((float*)a_data)[i * m + j];
-        }
+    if (is_double) {
+        info = LAPACKE_dgeqrf(LAPACK_ROW_MAJOR, m, n, NDArray_DDATA(q), n > 1 ? n : 1, (double *) tau);
+    } else {
+        info = LAPACKE_sgeqrf(LAPACK_ROW_MAJOR, m, n, NDArray_FDATA(q), n > 1 ? n : 1, (float *) tau);
+    }
+    for (i = 0; info == 0 && i < n; i++) {
+        memcpy(r->data + ((size_t)i * n + i) * elsize, q->data + ((size_t)i * n + i) * elsize, (size_t)(n - i) * elsize);
+    }
+    if (info == 0 && is_double) {
+        info = LAPACKE_dorgqr(LAPACK_ROW_MAJOR, m, n, n, NDArray_DDATA(q), n > 1 ? n : 1, (double *) tau);
+    } else if (info == 0) {
+        info = LAPACKE_sorgqr(LAPACK_ROW_MAJOR, m, n, n, NDArray_FDATA(q), n > 1 ? n : 1, (float *) tau);
     }
-
-    memcpy(NDArray_FDATA(q), a_data, NDArray_NUMELEMENTS(a) * NDArray_ELSIZE(a));
     efree(tau);
-    efree(a_data);
-    NDArray **rtn = emalloc(sizeof(NDArray*) * 2);
+    if (info != 0) {
+        NDArray_FREE(q);
+        NDArray_FREE(r);
+        zend_throw_error(NULL, "QR factorization failed.");
+        return NULL;
+    }
+    rtn = emalloc(sizeof(NDArray*) * 2);
     rtn[0] = q;
     rtn[1] = r;
     return rtn;
@@ -971,7 +2452,10 @@ NDArray_Qr(NDArray *a) {
 
 /**
  * NDArray::solve
- * @todo Implement GPU
+ *
+ * Solves a @ x = b for a square matrix or a stack of them (..., n, n).
+ * `b` is a vector (n), a matrix (n, k) shared by the whole stack, or a
+ * stack (..., n, k) with the same leading dimensions as `a`.
  *
  * @param a
  * @param b
@@ -979,52 +2463,131 @@ NDArray_Qr(NDArray *a) {
  */
 NDArray*
 NDArray_Solve(NDArray *a, NDArray *b) {
+    ndarray_batch batch;
+    NDArray *rhs, *input, *x;
+    int ndim, b_ndim, n, k, shared, singular = 0, d, *shape, *ipiv;
+    long i, size;
+    char *scratch;
+
+    if (a == NULL || b == NULL) {
+        return NULL;
+    }
     if (NDArray_DEVICE(a) != NDArray_DEVICE(b)) {
         zend_throw_error(NULL, "Both NDArray must be in the same device.");
         return NULL;
     }
-    if (NDArray_DEVICE(a) == NDARRAY_DEVICE_GPU) {
-        zend_throw_error(NULL, "ndarray::solve not implemented for GPU");
+    ndim = NDArray_NDIM(a);
+    b_ndim = NDArray_NDIM(b);
+    if (ndim < 2 || b_ndim < 1 || (b_ndim > 2 && b_ndim != ndim)) {
+        zend_throw_error(NULL, "Incompatible shapes");
         return NULL;
     }
-    // Check if input matrices are valid
-    if (a == NULL || b == NULL) {
-        return NULL;
+    shared = b_ndim < ndim || ndim == 2;
+    for (d = 0; !shared && d < ndim - 2; d++) {
+        if (NDArray_SHAPE(a)[d] != NDArray_SHAPE(b)[d]) {
+            zend_throw_error(NULL, "Incompatible shapes");
+            return NULL;
+        }
     }
-
-    // Check if input matrices are 2D and have compatible dimensions
-    if (a->ndim != 2 || b->ndim != 2 || a->dimensions[0] != a->dimensions[1] || a->dimensions[0] != b->dimensions[0]) {
+    if (NDArray_SHAPE(b)[b_ndim == 1 ? 0 : b_ndim - 2] != NDArray_SHAPE(a)[ndim - 1]) {
         zend_throw_error(NULL, "Incompatible shapes");
         return NULL;
     }
-
-    int n = a->dimensions[0]; // Number of rows/columns of the square matrix A
-
-    int *x_dimensions = (int*)emalloc(2 * sizeof(int));
-    x_dimensions[0] = n;
-    x_dimensions[1] = b->dimensions[1];
-    NDArray *x = NDArray_Zeros(x_dimensions, 2, NDArray_TYPE(a), NDArray_DEVICE(a));
-
-    // Allocate memory and copy data for the square matrix A
-    float* a_data = (float*)emalloc(n * n * sizeof(float));
-    memcpy(a_data, a->data, n * n * sizeof(float));
-
-    // Allocate memory and copy data for the matrix B
-    float* b_data = (float*)emalloc(n * x->dimensions[1] * sizeof(float));
-    memcpy(b_data, b->data, n * x->dimensions[1] * sizeof(float));
-
-    // Allocate memory for the pivot indices
-    int* ipiv = (int*)emalloc(n * sizeof(int));
-
-    LAPACKE_sgesv(LAPACK_ROW_MAJOR, n, NDArray_SHAPE(b)[1], a_data, NDArray_SHAPE(a)[0], ipiv, b_data, NDArray_SHAPE(b)[0]);
-
-    // Copy the result data to the output NDArray
-    memcpy(x->data, b_data, NDArray_NUMELEMENTS(b) * sizeof(float));
-
-    efree(a_data);
-    efree(b_data);
-    efree(ipiv);
-    return x;
+    if (ndarray_batch_init(&batch, a, is_type(NDArray_TYPE(a), NDARRAY_TYPE_DOUBLE64) ||
+                                      is_type(NDArray_TYPE(b), NDARRAY_TYPE_DOUBLE64)) < 0) {
+        return NULL;
+    }
+    input = NDArray_DEVICE(b) == NDARRAY_DEVICE_GPU ? NDArray_ToCPU(b) : b;
+    rhs = NDArray_AsType(input, batch.is_double ? NDARRAY_TYPE_DOUBLE64 : NDARRAY_TYPE_FLOAT32);
+    if (input != b) {
+        NDArray_FREE(input);
+    }
+    if (rhs == NULL) {
+        NDArray_FREE(batch.work);
+        return NULL;
+    }
+    n = batch.n;
+    k = b_ndim == 1 ? 1 : NDArray_SHAPE(b)[b_ndim - 1];
+    size = (long)n * n;
+
+    // x has the leading dimensions of `a` and the trailing ones of `b`
+    shape = emalloc(sizeof(int) * (ndim - 2 + (b_ndim == 1 ? 1 : 2)));
+    memcpy(shape, NDArray_SHAPE(a), sizeof(int) * (ndim - 2));
+    shape[ndim - 2] = n;
+    if (b_ndim != 1) {
+        shape[ndim - 1] = k;
+    }
+    x = NDArray_Empty(shape, ndim - 2 + (b_ndim == 1 ? 1 : 2), NDArray_TYPE(rhs), NDARRAY_DEVICE_CPU);
+
+    if (n <= NDARRAY_BATCH_CLOSED_MAX) {
+#pragma omp parallel for if (ndarray_batch_parallel(&batch)) reduction(|:singular)
+        for (i = 0; i < batch.count; i++) {
+            double m[16], inv[16], col[4], out[4];
+            long offset = shared ? 0 : i * n * k;
+            int r, c, j;
+
+            ndarray_batch_load(&batch, ndarray_batch_at(&batch, NDArray_DATA(batch.work), i * size), m, size);
+            if (ndarray_small_inverse(m, n, inv) == 0) {
+                singular |= 1;
+                continue;
+            }
+            for (c = 0; c < k; c++) {
+                for (r = 0; r < n; r++) {
+                    ndarray_batch_load(&batch, ndarray_batch_at(&batch, NDArray_DATA(rhs), offset + (long)r * k + c), col + r, 1);
+                }
+                for (r = 0; r < n; r++) {
+                    out[r] = 0;
+                    for (j = 0; j < n; j++) {
+                        out[r] += inv[r * n + j] * col[j];
+                    }
+                    ndarray_batch_store(&batch, ndarray_batch_at(&batch, NDArray_DATA(x), i * n * k + (long)r * k + c), out + r, 1);
+                }
+            }
+        }
+    } else {
+        ipiv = emalloc(sizeof(int) * n * ndarray_batch_threads());
+        scratch = emalloc((batch.is_double ? sizeof(double) : sizeof(float)) * (size_t)n * k * ndarray_batch_threads());
+#pragma omp parallel for if (ndarray_batch_parallel(&batch)) reduction(|:singular)
+        for (i = 0; i < batch.count; i++) {
+            int thread = ndarray_batch_thread_id(), r, c;
+            int *piv = ipiv + (long)n * thread;
+            char *matrix = ndarray_batch_at(&batch, NDArray_DATA(batch.work), i * size);
+            char *cols = ndarray_batch_at(&batch, scratch, (long)n * k * thread);
+            long offset = shared ? 0 : i * n * k;
+            size_t elsize = batch.is_double ? sizeof(double) : sizeof(float);
+
+            if (ndarray_batch_getrf(&batch, matrix, piv) != 0) {
+                singular |= 1;
+                continue;
+            }
+            // getrs wants the right-hand sides column-major
+            for (r = 0; r < n; r++) {
+                for (c = 0; c < k; c++) {
+                    memcpy(cols + ((long)c * n + r) * elsize, NDArray_DATA(rhs) + (offset + (long)r * k + c) * elsize, elsize);
+                }
+            }
+            if (batch.is_double) {
+                LAPACKE_dgetrs_work(LAPACK_COL_MAJOR, 'T', n, k, (double *) matrix, n, piv, (double *) cols, n);
+            } else {
+                LAPACKE_sgetrs_work(LAPACK_COL_MAJOR, 'T', n, k, (float *) matrix, n, piv, (float *) cols, n);
+            }
+            for (r = 0; r < n; r++) {
+                for (c = 0; c < k; c++) {
+                    memcpy(NDArray_DATA(x) + (i * n * k + (long)r * k + c) * elsize, cols + ((long)c * n + r) * elsize, elsize);
+                }
+            }
+        }
+        efree(ipiv);
+        efree(scratch);
+    }
+    NDArray_FREE(batch.work);
+    NDArray_FREE(rhs);
+    if (singular) {
+        zend_throw_error(NULL, "Singular matrix, unable to solve the linear system.");
+        NDArray_FREE(x);
+        return NULL;
+    }
+    return ndarray_batch_output(a, x);
 }
 
 /**
@@ -1036,67 +2599,101 @@ NDArray_Solve(NDArray *a, NDArray *b) {
  */
 NDArray*
 NDArray_Cond(NDArray *a) {
-    NDArray *a_norm = NDArray_L2Norm(a);
-    NDArray *a_inv = NDArray_Inverse(a);
-    NDArray *a_inv_norm = NDArray_L2Norm(a_inv);
-    NDArray_FREE(a_inv);
-    NDArray *rtn = NDArray_Multiply_Float(a_norm, a_inv_norm);
-    NDArray_FREE(a_norm);
-    NDArray_FREE(a_inv_norm);
-    return rtn;
+    NDArray *input;
+    double *values, cond;
+    int k;
+
+    if (NDArray_NDIM(a) != 2) {
+        zend_throw_error(NULL, "Array must be two-dimensional");
+        return NULL;
+    }
+    // 2-norm condition number, the ratio of the extreme singular values
+    input = ndarray_norm_input(a);
+    values = ndarray_singular_values(input);
+    if (input != a) {
+        NDArray_FREE(input);
+    }
+    if (values == NULL) {
+        return NULL;
+    }
+    k = NDArray_SHAPE(a)[0] < NDArray_SHAPE(a)[1] ? NDArray_SHAPE(a)[0] : NDArray_SHAPE(a)[1];
+    cond = k == 0 ? 0 : (values[k - 1] == 0 ? INFINITY : values[0] / values[k - 1]);
+    efree(values);
+    return ndarray_norm_scalar(a, cond);
 }
 
 /**
  * NDArray::cholesky
  *
+ * Lower triangular L with a = L @ L^T for a symmetric positive definite
+ * matrix or for every matrix of a stack (..., n, n)
+ *
  * @todo Implement GPU
  * @param a
  * @return
  */
 NDArray*
 NDArray_Cholesky(NDArray *a) {
+    ndarray_batch batch;
+    int failed = 0, n;
+    long i, size;
+
     if (NDArray_DEVICE(a) == NDARRAY_DEVICE_GPU) {
         zend_throw_error(NULL, "ndarray::cholesky not implemented for GPU");
         return NULL;
     }
-    if (NDArray_NDIM(a) != 2 || NDArray_SHAPE(a)[0] != NDArray_SHAPE(a)[1]) {
-        zend_throw_error(NULL, "NDArray_Cholesky: $a must be a square matrix.");
-        return NULL;
-    }
-
-    NDArray *rtn = NDArray_Copy(a, NDArray_DEVICE(a));
-    int info = LAPACKE_spotrf(LAPACK_ROW_MAJOR, 'L', NDArray_SHAPE(a)[0], NDArray_FDATA(rtn), NDArray_SHAPE(a)[0]);
-
-    if (info > 0) {
-        NDArray_FREE(rtn);
-        zend_throw_error(NULL, "Error calculating the cholesky decomposition. (Is $a not positive definite?)");
+    if (ndarray_batch_init(&batch, a, is_type(NDArray_TYPE(a), NDARRAY_TYPE_DOUBLE64)) < 0) {
         return NULL;
     }
-#ifdef HAVE_AVX2
-    int blockSize = 8; // AVX2 can process 8 single-precision floats at a time
-    for (int i = 0; i < NDArray_SHAPE(a)[0]; i++) {
-        // Perform AVX2 loop for blocks of 8 elements
-        int j = i + 1;
-        for (; j < NDArray_SHAPE(a)[0] - blockSize + 1; j += blockSize) {
-            // Load 8 elements of the row (upper triangular elements) into an AVX register
-            __m256 row_avx = _mm256_loadu_ps(&NDArray_FDATA(rtn)[i * NDArray_SHAPE(a)[0] + j]);
-            // Set all elements of the AVX register to 0
-            __m256 zero_avx = _mm256_setzero_ps();
-            // Store the 0s back into the upper triangular elements of the row
-            _mm256_storeu_ps(&NDArray_FDATA(rtn)[i * NDArray_SHAPE(a)[0] + j], zero_avx);
-        }
-        // Handle the remaining elements
-        for (; j < NDArray_SHAPE(a)[0]; j++) {
-            NDArray_FDATA(rtn)[i * NDArray_SHAPE(a)[0] + j] = 0.0f;
+    n = batch.n;
+    size = (long)n * n;
+
+#pragma omp parallel for if (ndarray_batch_parallel(&batch)) reduction(|:failed)
+    for (i = 0; i < batch.count; i++) {
+        char *matrix = ndarray_batch_at(&batch, NDArray_DATA(batch.work), i * size);
+        double m[16], zero = 0, sum;
+        int r, c, j, info = 0;
+
+        if (n <= NDARRAY_BATCH_CLOSED_MAX) {
+            // Cholesky-Banachiewicz, row by row
+            ndarray_batch_load(&batch, matrix, m, size);
+            for (r = 0; r < n && !info; r++) {
+                for (c = 0; c <= r; c++) {
+                    sum = m[r * n + c];
+                    for (j = 0; j < c; j++) {
+                        sum -= m[r * n + j] * m[c * n + j];
+                    }
+                    if (r == c) {
+                        info = !(sum > 0);
+                        m[r * n + c] = sqrt(sum);
+                    } else {
+                        m[r * n + c] = sum / m[c * n + c];
+                    }
+                }
+                for (c = r + 1; c < n; c++) {
+                    m[r * n + c] = 0;
+                }
+            }
+            ndarray_batch_store(&batch, matrix, m, size);
+        } else {
+            // Upper factor of the column-major view is L in row-major order
+            if (batch.is_double) {
+                info = LAPACKE_dpotrf_work(LAPACK_COL_MAJOR, 'U', n, (double *) matrix, n);
+            } else {
+                info = LAPACKE_spotrf_work(LAPACK_COL_MAJOR, 'U', n, (float *) matrix, n);
+            }
+            for (r = 0; r < n; r++) {
+                for (c = r + 1; c < n; c++) {
+                    ndarray_batch_store(&batch, ndarray_batch_at(&batch, matrix, (long)r * n + c), &zero, 1);
+                }
+            }
         }
+        failed |= info != 0;
     }
-#else
-    for (int i = 0; i < NDArray_SHAPE(a)[0]; i++) {
-        for (int j = i + 1; j < NDArray_SHAPE(a)[1]; j++) {
-            NDArray_FDATA(rtn)[i * NDArray_SHAPE(a)[0] + j] = 0.0f;
-        }
+    if (failed) {
+        NDArray_FREE(batch.work);
+        zend_throw_error(NULL, "Error calculating the cholesky decomposition. (Is $a not positive definite?)");
+        return NULL;
     }
-#endif
-
-    return rtn;
-}
\ No newline at end of file
+    return batch.work;
+}
@@ -3,20 +3,46 @@
 
 #include "../ndarray.h"
 
+/**
+ * LU factorization kept in LAPACK layout so it can be reused for
+ * several solves. `lu` is column-major m x n, `ipiv` holds the 1-based
+ * row interchanges of getrf.
+ */
+typedef struct NDArrayLUFactor {
+    void *lu;
+    int *ipiv;
+    int m;
+    int n;
+    int singular;
+    const char *type;
+} NDArrayLUFactor;
+
 NDArray* NDArray_Matmul(NDArray *a, NDArray *b);
 NDArray** NDArray_SVD(NDArray *target);
+NDArray* NDArray_SingularValues(NDArray *target);
+NDArray** NDArray_RandomizedSVD(NDArray *target, int k, int oversamples, int power_iterations);
 NDArray* NDArray_Det(NDArray *a);
 NDArray* NDArray_Dot(NDArray *nda, NDArray *ndb);
 NDArray* NDArray_Inner(NDArray *nda, NDArray *ndb);
-NDArray* NDArray_Norm(NDArray* target, int type);
+NDArray* NDArray_Norm(NDArray* target, double ord, int axis);
+NDArray* NDArray_FrobeniusNorm(NDArray* target);
+NDArray* NDArray_NuclearNorm(NDArray* target);
 NDArray* NDArray_L1Norm(NDArray* target);
 NDArray* NDArray_L2Norm(NDArray* target);
 NDArray* NDArray_Inverse(NDArray* target);
-NDArray** NDArray_LU(NDArray* target);
+NDArray** NDArray_LU(NDArray* target, int explicit_p);
+NDArrayLUFactor* NDArray_LUFactor(NDArray *a);
+void NDArray_LUFactorFree(NDArrayLUFactor *f);
+NDArray* NDArray_LUFactorPermutation(NDArrayLUFactor *f);
+NDArray* NDArray_LUFactorPMatrix(NDArrayLUFactor *f);
+NDArray* NDArray_LUFactorLower(NDArrayLUFactor *f);
+NDArray* NDArray_LUFactorUpper(NDArrayLUFactor *f);
+NDArray* NDArray_LUFactorSolve(NDArrayLUFactor *f, NDArray *b);
 NDArray* NDArray_MatrixRank(NDArray *target, float *tol);
 NDArray* NDArray_Outer(NDArray *a, NDArray *b);
 NDArray* NDArray_Trace(NDArray *a);
-NDArray** NDArray_Eig(NDArray *a);
+NDArray** NDArray_Eig(NDArray *a, int symmetric);
+NDArray* NDArray_Eigh(NDArray *a, int il, int iu, NDArray **vectors);
 NDArray* NDArray_Lstsq(NDArray *a, NDArray *b);
 NDArray** NDArray_Qr(NDArray *a);
 NDArray* NDArray_Solve(NDArray *a, NDArray *b);
@@ -0,0 +1,368 @@
+#include <Zend/zend.h>
+#include <math.h>
+#include <string.h>
+#include <stdint.h>
+#include "quantization.h"
+#include "../initializers.h"
+#include "../manipulation.h"
+#include "../types.h"
+#include "../../config.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#if defined(HAVE_AVX2) && defined(__AVX2__)
+#include <immintrin.h>
+#define NDARRAY_QUANTIZE_AVX2 1
+#endif
+
+/**
+ * Read the quantization scales of `channels` channels
+ *
+ * @param scale a single scale, or one scale per channel
+ * @param channels
+ * @return emalloc'd array of `channels` scales, NULL on error
+ */
+static float*
+ndarray_channel_scales(NDArray *scale, int channels) {
+    const NDArrayTypeFuncs *funcs;
+    float *scales;
+    int i, n;
+
+    if (NDArray_DEVICE(scale) == NDARRAY_DEVICE_GPU) {
+        zend_throw_error(NULL, "Quantization scales must be on CPU RAM.");
+        return NULL;
+    }
+    n = NDArray_NUMELEMENTS(scale);
+    if (NDArray_NDIM(scale) > 1 || (n != 1 && n != channels)) {
+        zend_throw_error(NULL, "Expected a single scale or one scale per channel (%d).", channels);
+        return NULL;
+    }
+    funcs = NDArray_TypeFuncs(NDArray_TYPE(scale));
+    scales = emalloc(sizeof(float) * (channels > 0 ? channels : 1));
+    for (i = 0; i < channels; i++) {
+        long offset = (n == 1 || NDArray_NDIM(scale) == 0) ? 0 : (long)i * NDArray_STRIDES(scale)[0];
+        scales[i] = (float) funcs->getitem(NDArray_DATA(scale) + offset);
+        if (!(scales[i] > 0)) {
+            efree(scales);
+            zend_throw_error(NULL, "Quantization scales must be positive.");
+            return NULL;
+        }
+    }
+    return scales;
+}
+
+/**
+ * Round `value` to the nearest int8, saturating. NaN maps to the zero point.
+ */
+static inline int8_t
+ndarray_quantize_value(float value, float scale, int zero_point) {
+    float q = nearbyintf(value / scale) + (float) zero_point;
+    if (q != q) {
+        return (int8_t) zero_point;
+    }
+    if (q < -128.0f) {
+        return -128;
+    }
+    if (q > 127.0f) {
+        return 127;
+    }
+    return (int8_t) q;
+}
+
+/**
+ * Duplicate the shape of `a` for a new array
+ */
+static int*
+ndarray_copy_shape(NDArray *a) {
+    int *shape = emalloc(sizeof(int) * (NDArray_NDIM(a) > 0 ? NDArray_NDIM(a) : 1));
+    memcpy(shape, NDArray_SHAPE(a), sizeof(int) * NDArray_NDIM(a));
+    return shape;
+}
+
+/**
+ * Affine int8 quantization: q = clamp(round(a / scale) + zero_point)
+ *
+ * A scale with more than one element is applied per channel along the
+ * last axis.
+ *
+ * @param a
+ * @param scale
+ * @param zero_point
+ * @return int8 NDArray with the shape of `a`
+ */
+NDArray*
+NDArray_Quantize(NDArray *a, NDArray *scale, int zero_point) {
+    const NDArrayTypeFuncs *funcs;
+    NDArray *contiguous = a, *rtn;
+    float *scales, *row;
+    int8_t *out;
+    long r, rows;
+    int j, channels;
+
+    if (NDArray_DEVICE(a) == NDARRAY_DEVICE_GPU) {
+        zend_throw_error(NULL, "Quantization is only available for NDArrays on CPU RAM.");
+        return NULL;
+    }
+    if (zero_point < -128 || zero_point > 127) {
+        zend_throw_error(NULL, "Zero point must be within the int8 range.");
+        return NULL;
+    }
+    channels = NDArray_NDIM(a) > 0 ? NDArray_SHAPE(a)[NDArray_NDIM(a) - 1] : 1;
+    scales = ndarray_channel_scales(scale, channels);
+    if (scales == NULL) {
+        return NULL;
+    }
+    if (!NDArray_IsContiguous(a)) {
+        contiguous = NDArray_ToContiguous(a);
+    }
+    funcs = NDArray_TypeFuncs(NDArray_TYPE(contiguous));
+    rtn = NDArray_Empty(ndarray_copy_shape(a), NDArray_NDIM(a), NDARRAY_TYPE_INT8, NDARRAY_DEVICE_CPU);
+    out = (int8_t *) NDArray_DATA(rtn);
+    rows = channels > 0 ? NDArray_NUMELEMENTS(a) / channels : 0;
+    row = emalloc(sizeof(float) * (channels > 0 ? channels : 1));
+    for (r = 0; r < rows; r++) {
+        funcs->to_float32(NDArray_DATA(contiguous) + r * channels * funcs->elsize, funcs->elsize, row, channels);
+        for (j = 0; j < channels; j++) {
+            out[r * channels + j] = ndarray_quantize_value(row[j], scales[j], zero_point);
+        }
+    }
+    efree(row);
+    efree(scales);
+    if (contiguous != a) {
+        NDArray_FREE(contiguous);
+    }
+    return rtn;
+}
+
+/**
+ * Inverse of NDArray_Quantize: a = (q - zero_point) * scale
+ *
+ * @param q int8 NDArray
+ * @param scale
+ * @param zero_point
+ * @return float32 NDArray with the shape of `q`
+ */
+NDArray*
+NDArray_Dequantize(NDArray *q, NDArray *scale, int zero_point) {
+    NDArray *contiguous = q, *rtn;
+    const int8_t *in;
+    float *scales, *out;
+    long i, n;
+    int channels;
+
+    if (!is_type(NDArray_TYPE(q), NDARRAY_TYPE_INT8)) {
+        zend_throw_error(NULL, "Only int8 NDArrays can be dequantized.");
+        return NULL;
+    }
+    if (NDArray_DEVICE(q) == NDARRAY_DEVICE_GPU) {
+        zend_throw_error(NULL, "Quantization is only available for NDArrays on CPU RAM.");
+        return NULL;
+    }
+    channels = NDArray_NDIM(q) > 0 ? NDArray_SHAPE(q)[NDArray_NDIM(q) - 1] : 1;
+    scales = ndarray_channel_scales(scale, channels);
+    if (scales == NULL) {
+        return NULL;
+    }
+    if (!NDArray_IsContiguous(q)) {
+        contiguous = NDArray_ToContiguous(q);
+    }
+    rtn = NDArray_Empty(ndarray_copy_shape(q), NDArray_NDIM(q), NDARRAY_TYPE_FLOAT32, NDARRAY_DEVICE_CPU);
+    in = (const int8_t *) NDArray_DATA(contiguous);
+    out = NDArray_FDATA(rtn);
+    n = NDArray_NUMELEMENTS(q);
+    for (i = 0; i < n; i++) {
+        out[i] = (float) (in[i] - zero_point) * scales[channels > 0 ? i % channels : 0];
+    }
+    efree(scales);
+    if (contiguous != q) {
+        NDArray_FREE(contiguous);
+    }
+    return rtn;
+}
+
+/**
+ * Rows of `a` and columns of `b` accumulated together by ndarray_qmm_block
+ */
+#define NDARRAY_QMM_ROWS 4
+#define NDARRAY_QMM_COLS 16
+
+/**
+ * Multiply-adds above which NDArray_QuantizedMatmul runs on several threads
+ */
+#define NDARRAY_QMM_PARALLEL_MIN 65536L
+
+/**
+ * Exact int32 products of up to NDARRAY_QMM_ROWS rows of `a` (int8, row
+ * stride `lda`) and NDARRAY_QMM_COLS columns of `b` (int8, row stride `ldb`)
+ * over `k`, read in place from the row-major operands
+ *
+ * Full blocks keep all their sums in registers. Rows p and p + 1 of `b`
+ * are sign extended and interleaved into int16 pairs, so one vpmaddwd
+ * adds both products of a column into its int32 lane. vpmaddubsw would
+ * need one operand unsigned and saturates its int16 pair sums for full
+ * range int8 inputs.
+ */
+static void
+ndarray_qmm_block(const int8_t *a, int lda, const int8_t *b, int ldb, int k, int rows, int cols,
+                  int32_t acc[NDARRAY_QMM_ROWS][NDARRAY_QMM_COLS]) {
+    int r, c, p = 0;
+
+    memset(acc, 0, sizeof(int32_t) * NDARRAY_QMM_ROWS * NDARRAY_QMM_COLS);
+#ifdef NDARRAY_QUANTIZE_AVX2
+    if (rows == NDARRAY_QMM_ROWS && cols == NDARRAY_QMM_COLS) {
+        __m256i lo[NDARRAY_QMM_ROWS], hi[NDARRAY_QMM_ROWS];
+        for (r = 0; r < NDARRAY_QMM_ROWS; r++) {
+            lo[r] = _mm256_setzero_si256();
+            hi[r] = _mm256_setzero_si256();
+        }
+        for (; p + 2 <= k; p += 2) {
+            __m256i b0 = _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i *) (b + (size_t) p * ldb)));
+            __m256i b1 = _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i *) (b + (size_t) (p + 1) * ldb)));
+            __m256i b_lo = _mm256_unpacklo_epi16(b0, b1);
+            __m256i b_hi = _mm256_unpackhi_epi16(b0, b1);
+            for (r = 0; r < NDARRAY_QMM_ROWS; r++) {
+                const int8_t *a_rp = a + (size_t) r * lda + p;
+                __m256i pair = _mm256_set1_epi32((int32_t) (((uint32_t) (uint16_t) a_rp[1] << 16) |
+                                                            (uint16_t) a_rp[0]));
+                lo[r] = _mm256_add_epi32(lo[r], _mm256_madd_epi16(b_lo, pair));
+                hi[r] = _mm256_add_epi32(hi[r], _mm256_madd_epi16(b_hi, pair));
+            }
+        }
+        // Unpacking works per 128-bit lane: lo holds columns 0-3 and 8-11, hi 4-7 and 12-15
+        for (r = 0; r < NDARRAY_QMM_ROWS; r++) {
+            _mm256_storeu_si256((__m256i *) acc[r], _mm256_permute2x128_si256(lo[r], hi[r], 0x20));
+            _mm256_storeu_si256((__m256i *) (acc[r] + 8), _mm256_permute2x128_si256(lo[r], hi[r], 0x31));
+        }
+    }
+#endif
+    for (; p < k; p++) {
+        for (r = 0; r < rows; r++) {
+            int32_t a_rp = a[(size_t) r * lda + p];
+            for (c = 0; c < cols; c++) {
+                acc[r][c] += a_rp * b[(size_t) p * ldb + c];
+            }
+        }
+    }
+}
+
+/**
+ * Dense layer product with int8 weights
+ *
+ * `a` (m x k) is quantized per row with a symmetric int8 scale, unless it
+ * already is int8, in which case it is used with a scale of 1. `b` (k x n)
+ * must be int8 quantized with zero point 0, typically with one scale per
+ * output column. The weights are read in the row-major layout
+ * NDArray_Quantize produces, so nothing is repacked per call. Blocks of the
+ * output accumulate exactly in int32 registers and are dequantized by both
+ * scales as they are stored. Blocks of rows run in parallel.
+ *
+ * @param a
+ * @param b
+ * @param b_scale single scale or one per column of `b`
+ * @return float32 NDArray (m x n)
+ */
+NDArray*
+NDArray_QuantizedMatmul(NDArray *a, NDArray *b, NDArray *b_scale) {
+    NDArray *a_cont = a, *b_cont = b, *rtn;
+    const NDArrayTypeFuncs *a_funcs;
+    const int8_t *a_q, *b_q;
+    float *b_scales, *a_scales, *row, *out;
+    int8_t *a_quantized = NULL;
+    int m, n, k, i, p;
+
+    if (NDArray_DEVICE(a) == NDARRAY_DEVICE_GPU || NDArray_DEVICE(b) == NDARRAY_DEVICE_GPU) {
+        zend_throw_error(NULL, "Quantized matmul is only available for NDArrays on CPU RAM.");
+        return NULL;
+    }
+    if (!is_type(NDArray_TYPE(b), NDARRAY_TYPE_INT8)) {
+        zend_throw_error(NULL, "Quantized matmul weights must be an int8 NDArray.");
+        return NULL;
+    }
+    if (NDArray_NDIM(a) != 2 || NDArray_NDIM(b) != 2) {
+        zend_throw_error(NULL, "Quantized matmul expects two matrices.");
+        return NULL;
+    }
+    m = NDArray_SHAPE(a)[0];
+    k = NDArray_SHAPE(a)[1];
+    n = NDArray_SHAPE(b)[1];
+    if (NDArray_SHAPE(b)[0] != k) {
+        zend_throw_error(NULL, "Shape mismatch for matmul. cols(a) != rows(b)");
+        return NULL;
+    }
+    b_scales = ndarray_channel_scales(b_scale, n);
+    if (b_scales == NULL) {
+        return NULL;
+    }
+    if (!NDArray_IsContiguous(a)) {
+        a_cont = NDArray_ToContiguous(a);
+    }
+    if (!NDArray_IsContiguous(b)) {
+        b_cont = NDArray_ToContiguous(b);
+    }
+    b_q = (const int8_t *) NDArray_DATA(b_cont);
+
+    // Quantize every row of `a` up front, the threads only read it
+    a_scales = emalloc(sizeof(float) * (m > 0 ? m : 1));
+    if (is_type(NDArray_TYPE(a_cont), NDARRAY_TYPE_INT8)) {
+        a_q = (const int8_t *) NDArray_DATA(a_cont);
+        for (i = 0; i < m; i++) {
+            a_scales[i] = 1.0f;
+        }
+    } else {
+        a_funcs = NDArray_TypeFuncs(NDArray_TYPE(a_cont));
+        a_quantized = emalloc((size_t) m * k > 0 ? (size_t) m * k : 1);
+        row = emalloc(sizeof(float) * (k > 0 ? k : 1));
+        for (i = 0; i < m; i++) {
+            float amax = 0;
+            a_funcs->to_float32(NDArray_DATA(a_cont) + (size_t) i * k * a_funcs->elsize, a_funcs->elsize, row, k);
+            for (p = 0; p < k; p++) {
+                if (fabsf(row[p]) > amax) {
+                    amax = fabsf(row[p]);
+                }
+            }
+            a_scales[i] = amax > 0 ? amax / 127.0f : 1.0f;
+            for (p = 0; p < k; p++) {
+                a_quantized[(size_t) i * k + p] = ndarray_quantize_value(row[p], a_scales[i], 0);
+            }
+        }
+        efree(row);
+        a_q = a_quantized;
+    }
+
+    int *rtn_shape = emalloc(sizeof(int) * 2);
+    rtn_shape[0] = m;
+    rtn_shape[1] = n;
+    rtn = NDArray_Empty(rtn_shape, 2, NDARRAY_TYPE_FLOAT32, NDARRAY_DEVICE_CPU);
+    out = NDArray_FDATA(rtn);
+
+#pragma omp parallel for if (m > NDARRAY_QMM_ROWS && (long) m * n * k >= NDARRAY_QMM_PARALLEL_MIN)
+    for (i = 0; i < m; i += NDARRAY_QMM_ROWS) {
+        int32_t acc[NDARRAY_QMM_ROWS][NDARRAY_QMM_COLS];
+        int rows = m - i < NDARRAY_QMM_ROWS ? m - i : NDARRAY_QMM_ROWS;
+        int j, cols, r, c;
+        for (j = 0; j < n; j += NDARRAY_QMM_COLS) {
+            cols = n - j < NDARRAY_QMM_COLS ? n - j : NDARRAY_QMM_COLS;
+            ndarray_qmm_block(a_q + (size_t) i * k, k, b_q + j, n, k, rows, cols, acc);
+            for (r = 0; r < rows; r++) {
+                for (c = 0; c < cols; c++) {
+                    out[(size_t) (i + r) * n + j + c] = (float) acc[r][c] * a_scales[i + r] * b_scales[j + c];
+                }
+            }
+        }
+    }
+
+    if (a_quantized != NULL) {
+        efree(a_quantized);
+    }
+    efree(a_scales);
+    efree(b_scales);
+    if (a_cont != a) {
+        NDArray_FREE(a_cont);
+    }
+    if (b_cont != b) {
+        NDArray_FREE(b_cont);
+    }
+    return rtn;
+}
@@ -0,0 +1,10 @@
+#ifndef NUMPOWER_QUANTIZATION_H
+#define NUMPOWER_QUANTIZATION_H
+
+#include "../ndarray.h"
+
+NDArray* NDArray_Quantize(NDArray *a, NDArray *scale, int zero_point);
+NDArray* NDArray_Dequantize(NDArray *q, NDArray *scale, int zero_point);
+NDArray* NDArray_QuantizedMatmul(NDArray *a, NDArray *b, NDArray *b_scale);
+
+#endif //NUMPOWER_QUANTIZATION_H
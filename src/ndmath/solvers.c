@@ -0,0 +1,733 @@
+#include <Zend/zend.h>
+#include <string.h>
+#include <math.h>
+#include <float.h>
+#include <stdint.h>
+#include "solvers.h"
+#include "../../config.h"
+#include "../initializers.h"
+#include "../types.h"
+#include "../sparse.h"
+
+#ifdef HAVE_CBLAS
+#include <cblas.h>
+#endif
+
+#ifdef HAVE_LAPACKE
+#include <lapacke.h>
+#endif
+
+#ifdef HAVE_LAPACKE_MKL
+#include <mkl/mkl.h>
+#endif
+
+/* Default restart length of GMRES */
+#define NDARRAY_GMRES_RESTART 30
+
+/* Seed of the Lanczos start vector, fixed so results are reproducible */
+#define NDARRAY_LANCZOS_SEED 0x2545F4914F6CDD1DULL
+
+/**
+ * Dense matrix behind NDArray_DenseOperator. float32 matrices use sgemv
+ * through the float32 copies `xs` and `ys` of the vectors.
+ */
+typedef struct {
+    NDArray *matrix;
+    int owned;
+    float *xs;
+    float *ys;
+} ndarray_dense_operator;
+
+static int
+ndarray_dense_matvec(NDArrayOperator *op, const double *x, double *y) {
+    ndarray_dense_operator *dense = op->data;
+    int i, n = op->n;
+
+    if (op->is_double) {
+        cblas_dgemv(CblasRowMajor, CblasNoTrans, n, n, 1.0, NDArray_DDATA(dense->matrix), n, x, 1, 0.0, y, 1);
+        return 0;
+    }
+    for (i = 0; i < n; i++) {
+        dense->xs[i] = (float) x[i];
+    }
+    cblas_sgemv(CblasRowMajor, CblasNoTrans, n, n, 1.0f, NDArray_FDATA(dense->matrix), n, dense->xs, 1, 0.0f,
+                dense->ys, 1);
+    for (i = 0; i < n; i++) {
+        y[i] = dense->ys[i];
+    }
+    return 0;
+}
+
+static void
+ndarray_dense_release(NDArrayOperator *op) {
+    ndarray_dense_operator *dense = op->data;
+
+    if (dense->owned) {
+        NDArray_FREE(dense->matrix);
+    }
+    if (dense->xs != NULL) {
+        efree(dense->xs);
+        efree(dense->ys);
+    }
+    efree(dense);
+}
+
+/**
+ * Operator of a square dense matrix. float64 matrices are multiplied in
+ * double precision, every other dtype as float32.
+ *
+ * @param op
+ * @param a
+ * @return 0 on success, -1 with an exception thrown otherwise
+ */
+int
+NDArray_DenseOperator(NDArrayOperator *op, NDArray *a) {
+    ndarray_dense_operator *dense;
+    NDArray *matrix = a;
+    const char *type;
+    int i, n;
+
+    if (NDArray_NDIM(a) != 2 || NDArray_SHAPE(a)[0] != NDArray_SHAPE(a)[1]) {
+        zend_throw_error(NULL, "The operator must be a square matrix.");
+        return -1;
+    }
+    type = is_type(NDArray_TYPE(a), NDARRAY_TYPE_DOUBLE64) ? NDARRAY_TYPE_DOUBLE64 : NDARRAY_TYPE_FLOAT32;
+    if (NDArray_DEVICE(a) == NDARRAY_DEVICE_GPU) {
+        matrix = NDArray_ToCPU(a);
+    }
+    if (!is_type(NDArray_TYPE(matrix), type) || !NDArray_IsContiguous(matrix)) {
+        NDArray *cast = NDArray_AsType(matrix, type);
+        if (matrix != a) {
+            NDArray_FREE(matrix);
+        }
+        if (cast == NULL) {
+            return -1;
+        }
+        matrix = cast;
+    }
+    n = NDArray_SHAPE(a)[0];
+    dense = emalloc(sizeof(ndarray_dense_operator));
+    dense->matrix = matrix;
+    dense->owned = matrix != a;
+    dense->xs = NULL;
+    dense->ys = NULL;
+    op->n = n;
+    op->is_double = is_type(type, NDARRAY_TYPE_DOUBLE64);
+    op->diagonal = emalloc(sizeof(double) * (n > 0 ? n : 1));
+    for (i = 0; i < n; i++) {
+        op->diagonal[i] = op->is_double ? NDArray_DDATA(matrix)[(long)i * n + i]
+                                        : NDArray_FDATA(matrix)[(long)i * n + i];
+    }
+    if (!op->is_double) {
+        dense->xs = emalloc(sizeof(float) * (n > 0 ? n : 1));
+        dense->ys = emalloc(sizeof(float) * (n > 0 ? n : 1));
+    }
+    op->matvec = ndarray_dense_matvec;
+    op->release = ndarray_dense_release;
+    op->data = dense;
+    return 0;
+}
+
+static int
+ndarray_sparse_matvec(NDArrayOperator *op, const double *x, double *y) {
+    NDArray_SparseMatvec(op->data, x, y);
+    return 0;
+}
+
+static void
+ndarray_sparse_release(NDArrayOperator *op) {
+    NDArray_SparseFree(op->data);
+}
+
+/**
+ * Operator of a square sparse matrix, kept as a private CSR copy
+ *
+ * @param op
+ * @param a
+ * @return 0 on success, -1 with an exception thrown otherwise
+ */
+int
+NDArray_SparseOperator(NDArrayOperator *op, NDArraySparse *a) {
+    if (a->shape[0] != a->shape[1]) {
+        zend_throw_error(NULL, "The operator must be a square matrix.");
+        return -1;
+    }
+    op->n = a->shape[0];
+    op->is_double = a->is_double;
+    op->diagonal = emalloc(sizeof(double) * (op->n > 0 ? op->n : 1));
+    NDArray_SparseDiagonal(a, op->diagonal);
+    op->matvec = ndarray_sparse_matvec;
+    op->release = ndarray_sparse_release;
+    op->data = NDArray_SparseAsFormat(a, NDARRAY_SPARSE_CSR);
+    return 0;
+}
+
+void
+NDArray_OperatorFree(NDArrayOperator *op) {
+    if (op->release != NULL) {
+        op->release(op);
+    }
+    if (op->diagonal != NULL) {
+        efree(op->diagonal);
+    }
+    op->release = NULL;
+    op->diagonal = NULL;
+}
+
+/**
+ * float64 copy of a vector of `n` elements, NULL with an exception
+ * thrown when it does not match the operator
+ */
+static double*
+ndarray_solver_vector(NDArray *v, int n, const char *name) {
+    NDArray *cast;
+    double *rtn;
+
+    if (NDArray_NUMELEMENTS(v) != n || (NDArray_NDIM(v) > 1 && NDArray_SHAPE(v)[0] != n)) {
+        zend_throw_error(NULL, "%s must be a vector of %d elements.", name, n);
+        return NULL;
+    }
+    cast = NDArray_DEVICE(v) == NDARRAY_DEVICE_GPU ? NDArray_ToCPU(v) : v;
+    if (cast != v) {
+        NDArray *cpu = cast;
+        cast = NDArray_AsType(cpu, NDARRAY_TYPE_DOUBLE64);
+        NDArray_FREE(cpu);
+    } else {
+        cast = NDArray_AsType(v, NDARRAY_TYPE_DOUBLE64);
+    }
+    if (cast == NULL) {
+        return NULL;
+    }
+    rtn = emalloc(sizeof(double) * (n > 0 ? n : 1));
+    memcpy(rtn, NDArray_DDATA(cast), sizeof(double) * n);
+    NDArray_FREE(cast);
+    return rtn;
+}
+
+/**
+ * Solution array with the shape of `b`, float64 when the operator or `b`
+ * is float64 and float32 otherwise
+ */
+static NDArray*
+ndarray_solver_output(NDArrayOperator *op, NDArray *b, const double *x) {
+    const char *type = op->is_double || is_type(NDArray_TYPE(b), NDARRAY_TYPE_DOUBLE64)
+                       ? NDARRAY_TYPE_DOUBLE64 : NDARRAY_TYPE_FLOAT32;
+    int *shape = emalloc(sizeof(int) * NDArray_NDIM(b));
+    NDArray *rtn, *gpu;
+    int i;
+
+    memcpy(shape, NDArray_SHAPE(b), sizeof(int) * NDArray_NDIM(b));
+    rtn = NDArray_Empty(shape, NDArray_NDIM(b), type, NDARRAY_DEVICE_CPU);
+    for (i = 0; i < op->n; i++) {
+        NDArray_TypeFuncs(type)->setitem(NDArray_DATA(rtn) + (long)i * NDArray_ELSIZE(rtn), x[i]);
+    }
+    if (NDArray_DEVICE(b) == NDARRAY_DEVICE_GPU) {
+        gpu = NDArray_ToGPU(rtn);
+        NDArray_FREE(rtn);
+        rtn = gpu;
+    }
+    return rtn;
+}
+
+/**
+ * Start vector, right-hand side and inverse diagonal shared by the solvers
+ *
+ * @return 0 on success, -1 with an exception thrown otherwise
+ */
+static int
+ndarray_solver_init(NDArrayOperator *op, NDArray *b, NDArray *x0, int jacobi,
+                    double **bv, double **x, double **inv_diagonal) {
+    int i;
+
+    *bv = NULL;
+    *x = NULL;
+    *inv_diagonal = NULL;
+    if (jacobi == NDARRAY_JACOBI_ON && op->diagonal == NULL) {
+        zend_throw_error(NULL, "Jacobi preconditioning needs the diagonal of the operator.");
+        return -1;
+    }
+    if (jacobi != NDARRAY_JACOBI_OFF && op->diagonal != NULL) {
+        *inv_diagonal = emalloc(sizeof(double) * (op->n > 0 ? op->n : 1));
+        for (i = 0; i < op->n; i++) {
+            if (op->diagonal[i] == 0) {
+                efree(*inv_diagonal);
+                *inv_diagonal = NULL;
+                // By default an operator with zeros on its diagonal is solved unpreconditioned
+                if (jacobi == NDARRAY_JACOBI_AUTO) {
+                    break;
+                }
+                zend_throw_error(NULL, "Jacobi preconditioning needs a diagonal without zeros.");
+                return -1;
+            }
+            (*inv_diagonal)[i] = 1 / op->diagonal[i];
+        }
+    }
+    *bv = ndarray_solver_vector(b, op->n, "b");
+    if (*bv != NULL && x0 != NULL) {
+        *x = ndarray_solver_vector(x0, op->n, "x0");
+    } else if (*bv != NULL) {
+        *x = ecalloc(op->n > 0 ? op->n : 1, sizeof(double));
+    }
+    if (*x == NULL) {
+        if (*bv != NULL) {
+            efree(*bv);
+        }
+        if (*inv_diagonal != NULL) {
+            efree(*inv_diagonal);
+        }
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * z = M^-1 r, the identity without preconditioning
+ */
+static void
+ndarray_solver_precondition(const double *inv_diagonal, const double *r, double *z, int n) {
+    int i;
+
+    if (inv_diagonal == NULL) {
+        cblas_dcopy(n, r, 1, z, 1);
+        return;
+    }
+    for (i = 0; i < n; i++) {
+        z[i] = inv_diagonal[i] * r[i];
+    }
+}
+
+/**
+ * r = b - A x
+ *
+ * @return 0 on success, -1 when the operator failed
+ */
+static int
+ndarray_solver_residual(NDArrayOperator *op, const double *b, const double *x, double *r) {
+    if (op->matvec(op, x, r) != 0) {
+        return -1;
+    }
+    cblas_dscal(op->n, -1.0, r, 1);
+    cblas_daxpy(op->n, 1.0, b, 1, r, 1);
+    return 0;
+}
+
+/**
+ * Preconditioned conjugate gradient for symmetric positive definite
+ * operators. Iterates until the recurrence residual drops to tol * ||b||
+ * or after `max_iter` iterations; a non-positive curvature p^T A p also
+ * stops the iteration. Convergence is judged on the recomputed b - A x.
+ *
+ * @param op
+ * @param b right-hand side, any shape with n elements
+ * @param x0 initial guess, NULL for zeros
+ * @param tol relative residual tolerance
+ * @param max_iter
+ * @param jacobi NDARRAY_JACOBI_* preconditioning with the inverse diagonal of `op`
+ * @param info convergence report
+ * @return solution with the shape of `b`
+ */
+NDArray*
+NDArray_CG(NDArrayOperator *op, NDArray *b, NDArray *x0, double tol, int max_iter, int jacobi,
+           NDArraySolverInfo *info) {
+    double *bv, *x, *inv_diagonal, *r, *z, *p, *q;
+    double bnorm, rnorm, target, rz, rz_next, pq, alpha;
+    int n = op->n, it = 0, failed = 0;
+    NDArray *rtn = NULL;
+
+    if (ndarray_solver_init(op, b, x0, jacobi, &bv, &x, &inv_diagonal) != 0) {
+        return NULL;
+    }
+    r = emalloc(sizeof(double) * (n > 0 ? n : 1));
+    z = emalloc(sizeof(double) * (n > 0 ? n : 1));
+    p = emalloc(sizeof(double) * (n > 0 ? n : 1));
+    q = emalloc(sizeof(double) * (n > 0 ? n : 1));
+
+    bnorm = n > 0 ? cblas_dnrm2(n, bv, 1) : 0;
+    target = tol * bnorm;
+    if (x0 == NULL) {
+        cblas_dcopy(n, bv, 1, r, 1);
+    } else {
+        failed = ndarray_solver_residual(op, bv, x, r);
+    }
+    rnorm = n > 0 && !failed ? cblas_dnrm2(n, r, 1) : 0;
+    if (!failed && rnorm > target) {
+        ndarray_solver_precondition(inv_diagonal, r, z, n);
+        cblas_dcopy(n, z, 1, p, 1);
+        rz = cblas_ddot(n, r, 1, z, 1);
+        while (it < max_iter) {
+            if (op->matvec(op, p, q) != 0) {
+                failed = 1;
+                break;
+            }
+            pq = cblas_ddot(n, p, 1, q, 1);
+            if (!(pq > 0)) {
+                break;
+            }
+            alpha = rz / pq;
+            cblas_daxpy(n, alpha, p, 1, x, 1);
+            cblas_daxpy(n, -alpha, q, 1, r, 1);
+            it++;
+            rnorm = cblas_dnrm2(n, r, 1);
+            if (rnorm <= target) {
+                break;
+            }
+            ndarray_solver_precondition(inv_diagonal, r, z, n);
+            rz_next = cblas_ddot(n, r, 1, z, 1);
+            // p = z + beta p
+            cblas_dscal(n, rz_next / rz, p, 1);
+            cblas_daxpy(n, 1.0, z, 1, p, 1);
+            rz = rz_next;
+        }
+        // The recurrence drifts from b - A x in finite precision, report the true residual
+        if (!failed && it > 0) {
+            failed = ndarray_solver_residual(op, bv, x, r);
+            rnorm = cblas_dnrm2(n, r, 1);
+        }
+    }
+    if (!failed) {
+        info->iterations = it;
+        info->residual = bnorm > 0 ? rnorm / bnorm : rnorm;
+        info->converged = rnorm <= target;
+        rtn = ndarray_solver_output(op, b, x);
+    }
+    efree(r);
+    efree(z);
+    efree(p);
+    efree(q);
+    efree(bv);
+    efree(x);
+    if (inv_diagonal != NULL) {
+        efree(inv_diagonal);
+    }
+    return rtn;
+}
+
+/**
+ * Restarted GMRES for general square operators, with modified
+ * Gram-Schmidt Arnoldi and Givens rotations. Jacobi preconditioning is
+ * applied on the right so the tested residual is the true one.
+ *
+ * @param op
+ * @param b right-hand side, any shape with n elements
+ * @param x0 initial guess, NULL for zeros
+ * @param tol relative residual tolerance
+ * @param restart Krylov subspace size between restarts, 0 for the default
+ * @param max_iter total number of inner iterations
+ * @param jacobi NDARRAY_JACOBI_* preconditioning with the inverse diagonal of `op`
+ * @param info convergence report
+ * @return solution with the shape of `b`
+ */
+NDArray*
+NDArray_GMRES(NDArrayOperator *op, NDArray *b, NDArray *x0, double tol, int restart, int max_iter,
+              int jacobi, NDArraySolverInfo *info) {
+    double *bv, *x, *inv_diagonal, *r, *w, *z, *v, *h, *cs, *sn, *g, *y;
+    double bnorm, rnorm = 0, target, denom, sub, t;
+    int n = op->n, m, total = 0, failed = 0, i, j, k;
+    NDArray *rtn = NULL;
+
+    if (ndarray_solver_init(op, b, x0, jacobi, &bv, &x, &inv_diagonal) != 0) {
+        return NULL;
+    }
+    m = restart > 0 ? restart : NDARRAY_GMRES_RESTART;
+    if (m > n) {
+        m = n > 0 ? n : 1;
+    }
+    r = emalloc(sizeof(double) * (n > 0 ? n : 1));
+    w = emalloc(sizeof(double) * (n > 0 ? n : 1));
+    z = emalloc(sizeof(double) * (n > 0 ? n : 1));
+    v = emalloc(sizeof(double) * (size_t)(m + 1) * (n > 0 ? n : 1));
+    h = emalloc(sizeof(double) * (m + 1) * m);
+    cs = emalloc(sizeof(double) * m);
+    sn = emalloc(sizeof(double) * m);
+    g = emalloc(sizeof(double) * (m + 1));
+    y = emalloc(sizeof(double) * m);
+
+    bnorm = n > 0 ? cblas_dnrm2(n, bv, 1) : 0;
+    target = tol * bnorm;
+    for (;;) {
+        if (ndarray_solver_residual(op, bv, x, r) != 0) {
+            failed = 1;
+            break;
+        }
+        rnorm = n > 0 ? cblas_dnrm2(n, r, 1) : 0;
+        if (rnorm <= target || total >= max_iter) {
+            break;
+        }
+        // Arnoldi on A M^-1 from v0 = r / ||r||
+        cblas_dcopy(n, r, 1, v, 1);
+        cblas_dscal(n, 1 / rnorm, v, 1);
+        memset(g, 0, sizeof(double) * (m + 1));
+        g[0] = rnorm;
+        for (k = 0, j = 0; j < m && total < max_iter; j++) {
+            ndarray_solver_precondition(inv_diagonal, v + (size_t)j * n, z, n);
+            if (op->matvec(op, z, w) != 0) {
+                failed = 1;
+                break;
+            }
+            for (i = 0; i <= j; i++) {
+                h[i * m + j] = cblas_ddot(n, w, 1, v + (size_t)i * n, 1);
+                cblas_daxpy(n, -h[i * m + j], v + (size_t)i * n, 1, w, 1);
+            }
+            sub = cblas_dnrm2(n, w, 1);
+            h[(j + 1) * m + j] = sub;
+            if (sub != 0) {
+                cblas_dcopy(n, w, 1, v + (size_t)(j + 1) * n, 1);
+                cblas_dscal(n, 1 / sub, v + (size_t)(j + 1) * n, 1);
+            }
+            // Apply the previous rotations to the new column, then zero its subdiagonal
+            for (i = 0; i < j; i++) {
+                t = cs[i] * h[i * m + j] + sn[i] * h[(i + 1) * m + j];
+                h[(i + 1) * m + j] = -sn[i] * h[i * m + j] + cs[i] * h[(i + 1) * m + j];
+                h[i * m + j] = t;
+            }
+            denom = hypot(h[j * m + j], h[(j + 1) * m + j]);
+            if (denom == 0) {
+                break;
+            }
+            cs[j] = h[j * m + j] / denom;
+            sn[j] = h[(j + 1) * m + j] / denom;
+            h[j * m + j] = denom;
+            h[(j + 1) * m + j] = 0;
+            g[j + 1] = -sn[j] * g[j];
+            g[j] = cs[j] * g[j];
+            total++;
+            k = j + 1;
+            // A zero subdiagonal means the Krylov space is invariant and y is exact
+            if (fabs(g[j + 1]) <= target || sub == 0) {
+                break;
+            }
+        }
+        if (failed || k == 0) {
+            break;
+        }
+        // y = H^-1 g by back substitution, then x += M^-1 V y
+        for (i = k - 1; i >= 0; i--) {
+            t = g[i];
+            for (j = i + 1; j < k; j++) {
+                t -= h[i * m + j] * y[j];
+            }
+            y[i] = t / h[i * m + i];
+        }
+        memset(w, 0, sizeof(double) * n);
+        for (i = 0; i < k; i++) {
+            cblas_daxpy(n, y[i], v + (size_t)i * n, 1, w, 1);
+        }
+        ndarray_solver_precondition(inv_diagonal, w, z, n);
+        cblas_daxpy(n, 1.0, z, 1, x, 1);
+    }
+    if (!failed) {
+        info->iterations = total;
+        info->residual = bnorm > 0 ? rnorm / bnorm : rnorm;
+        info->converged = rnorm <= target;
+        rtn = ndarray_solver_output(op, b, x);
+    }
+    efree(r);
+    efree(w);
+    efree(z);
+    efree(v);
+    efree(h);
+    efree(cs);
+    efree(sn);
+    efree(g);
+    efree(y);
+    efree(bv);
+    efree(x);
+    if (inv_diagonal != NULL) {
+        efree(inv_diagonal);
+    }
+    return rtn;
+}
+
+/**
+ * Fill `q` with uniform values in [-1, 1)
+ */
+static void
+ndarray_lanczos_random(double *q, int n, uint64_t *state) {
+    uint64_t z;
+    int i;
+
+    for (i = 0; i < n; i++) {
+        z = (*state += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        z ^= z >> 31;
+        q[i] = (double)(z >> 11) / 4503599627370496.0 - 1.0;
+    }
+}
+
+/**
+ * Remove from `w` its components along the `j` orthonormal rows of `basis`.
+ * Two passes of classical Gram-Schmidt keep the basis orthogonal to
+ * working precision.
+ */
+static void
+ndarray_lanczos_orthogonalize(const double *basis, int j, int n, double *w, double *h) {
+    int pass;
+
+    for (pass = 0; pass < 2; pass++) {
+        cblas_dgemv(CblasRowMajor, CblasNoTrans, j, n, 1.0, basis, n, w, 1, 0.0, h, 1);
+        cblas_dgemv(CblasRowMajor, CblasTrans, j, n, -1.0, basis, n, h, 1, 1.0, w, 1);
+    }
+}
+
+/**
+ * Ritz pairs of the `steps` x `steps` Lanczos tridiagonal matrix. Returns
+ * the largest residual of the `k` wanted pairs relative to the spectral
+ * radius estimate, -1 with an exception thrown on failure.
+ */
+static double
+ndarray_lanczos_ritz(const double *alpha, const double *beta, int steps, int k, int largest,
+                     double *theta, double *z) {
+    double *e = emalloc(sizeof(double) * steps), scale, residual = 0, r;
+    int i, first = largest ? steps - k : 0, info;
+
+    memcpy(theta, alpha, sizeof(double) * steps);
+    memcpy(e, beta, sizeof(double) * steps);
+    info = LAPACKE_dstev(LAPACK_COL_MAJOR, 'V', steps, theta, e, z, steps);
+    efree(e);
+    if (info != 0) {
+        zend_throw_error(NULL, "Eigenvalue computation did not converge.");
+        return -1;
+    }
+    scale = fmax(fabs(theta[0]), fabs(theta[steps - 1]));
+    for (i = first; i < first + k; i++) {
+        // ||A y - theta y|| = |beta_last * (last component of the Ritz vector)|
+        r = fabs(beta[steps - 1] * z[(long)i * steps + steps - 1]);
+        residual = fmax(residual, scale > 0 ? r / scale : r);
+    }
+    return residual;
+}
+
+/**
+ * The `k` largest or smallest eigenvalues of a symmetric operator, with
+ * their eigenvectors, by Lanczos iteration with full reorthogonalization.
+ * The Krylov basis grows until every wanted Ritz pair has a residual
+ * below `tol` relative to the spectral radius, or reaches `max_dim`
+ * vectors. Only matrix-vector products with `op` are needed, so the
+ * operator can be sparse or matrix-free.
+ *
+ * @param op symmetric operator
+ * @param k number of eigenpairs
+ * @param largest 1 for the largest eigenvalues, 0 for the smallest
+ * @param tol
+ * @param max_dim largest Krylov basis, between k and n
+ * @param vectors receives the n x k eigenvectors as columns
+ * @param info
+ * @return the k eigenvalues in ascending order
+ */
+NDArray*
+NDArray_Lanczos(NDArrayOperator *op, int k, int largest, double tol, int max_dim, NDArray **vectors,
+                NDArraySolverInfo *info) {
+    int n = op->n, steps = 0, capacity, breakdown, i, j, first;
+    const char *type = op->is_double ? NDARRAY_TYPE_DOUBLE64 : NDARRAY_TYPE_FLOAT32;
+    double *basis, *alpha, *beta, *theta, *z = NULL, *h, *sub, *y, *w, residual = 1, anorm = 0;
+    uint64_t state = NDARRAY_LANCZOS_SEED;
+    int *shape;
+    NDArray *values, *vec;
+
+    *vectors = NULL;
+    if (k < 1 || k > n) {
+        zend_throw_error(NULL, "k must be between 1 and %d.", n);
+        return NULL;
+    }
+    if (max_dim < k || max_dim > n) {
+        zend_throw_error(NULL, "max_dim must be between k and %d.", n);
+        return NULL;
+    }
+    // The basis starts small and doubles while the wanted pairs have not
+    // converged, so well separated spectra never allocate max_dim vectors
+    capacity = 2 * k > 20 ? 2 * k : 20;
+    capacity = capacity < max_dim ? capacity : max_dim;
+    basis = emalloc(sizeof(double) * ((long)capacity + 1) * n);
+    alpha = emalloc(sizeof(double) * max_dim);
+    beta = emalloc(sizeof(double) * max_dim);
+    theta = emalloc(sizeof(double) * max_dim);
+    h = emalloc(sizeof(double) * (max_dim + 1));
+
+    ndarray_lanczos_random(basis, n, &state);
+    cblas_dscal(n, 1 / cblas_dnrm2(n, basis, 1), basis, 1);
+    for (j = 0; j < max_dim; j++) {
+        w = basis + (long)(j + 1) * n;
+        if (op->matvec(op, basis + (long)j * n, w) != 0) {
+            residual = -1;
+            break;
+        }
+        alpha[j] = cblas_ddot(n, basis + (long)j * n, 1, w, 1);
+        // Full reorthogonalization stands in for the three-term recurrence
+        ndarray_lanczos_orthogonalize(basis, j + 1, n, w, h);
+        beta[j] = cblas_dnrm2(n, w, 1);
+        anorm = fmax(anorm, fabs(alpha[j]) + beta[j] + (j > 0 ? beta[j - 1] : 0));
+        steps = j + 1;
+        breakdown = beta[j] <= 1e3 * DBL_EPSILON * anorm;
+        if (steps >= k && (steps == capacity || breakdown)) {
+            z = z == NULL ? emalloc(sizeof(double) * steps * steps) : erealloc(z, sizeof(double) * steps * steps);
+            residual = ndarray_lanczos_ritz(alpha, beta, steps, k, largest, theta, z);
+            if (residual < 0 || residual <= tol || steps == max_dim) {
+                break;
+            }
+        }
+        if (steps == capacity) {
+            capacity = 2 * capacity < max_dim ? 2 * capacity : max_dim;
+            basis = erealloc(basis, sizeof(double) * ((long)capacity + 1) * n);
+            w = basis + (long)(j + 1) * n;
+        }
+        if (breakdown) {
+            // Invariant subspace, continue from a fresh direction; the
+            // tridiagonal matrix splits into independent blocks
+            ndarray_lanczos_random(w, n, &state);
+            ndarray_lanczos_orthogonalize(basis, j + 1, n, w, h);
+            beta[j] = 0;
+            cblas_dscal(n, 1 / cblas_dnrm2(n, w, 1), w, 1);
+        } else {
+            cblas_dscal(n, 1 / beta[j], w, 1);
+        }
+    }
+    efree(h);
+    if (residual < 0) {
+        efree(basis);
+        efree(alpha);
+        efree(beta);
+        efree(theta);
+        if (z != NULL) {
+            efree(z);
+        }
+        return NULL;
+    }
+
+    // Ritz vectors y = basis^T z of the wanted pairs
+    first = largest ? steps - k : 0;
+    sub = emalloc(sizeof(double) * steps * k);
+    for (i = 0; i < steps; i++) {
+        for (j = 0; j < k; j++) {
+            sub[(long)i * k + j] = z[(long)(first + j) * steps + i];
+        }
+    }
+    y = emalloc(sizeof(double) * n * k);
+    cblas_dgemm(CblasRowMajor, CblasTrans, CblasNoTrans, n, k, steps, 1.0, basis, n, sub, k, 0.0, y, k);
+
+    shape = emalloc(sizeof(int));
+    shape[0] = k;
+    values = NDArray_Empty(shape, 1, type, NDARRAY_DEVICE_CPU);
+    shape = emalloc(sizeof(int) * 2);
+    shape[0] = n;
+    shape[1] = k;
+    vec = NDArray_Empty(shape, 2, type, NDARRAY_DEVICE_CPU);
+    for (j = 0; j < k; j++) {
+        NDArray_TypeFuncs(type)->setitem(NDArray_DATA(values) + (long)j * NDArray_ELSIZE(values), theta[first + j]);
+    }
+    for (i = 0; i < n * k; i++) {
+        NDArray_TypeFuncs(type)->setitem(NDArray_DATA(vec) + (long)i * NDArray_ELSIZE(vec), y[i]);
+    }
+    info->iterations = steps;
+    info->residual = residual;
+    info->converged = residual <= tol || steps == n;
+    efree(basis);
+    efree(alpha);
+    efree(beta);
+    efree(theta);
+    efree(z);
+    efree(sub);
+    efree(y);
+    *vectors = vec;
+    return values;
+}
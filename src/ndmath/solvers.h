@@ -0,0 +1,49 @@
+#ifndef NUMPOWER_SOLVERS_H
+#define NUMPOWER_SOLVERS_H
+
+#include "../ndarray.h"
+#include "../sparse.h"
+
+/**
+ * Square linear operator y = A x used by the iterative solvers. Vectors
+ * are always float64; `matvec` returns 0 on success and -1 with an
+ * exception thrown otherwise. `diagonal` holds the n diagonal entries
+ * used by Jacobi preconditioning, NULL when they are unknown.
+ */
+typedef struct NDArrayOperator {
+    int n;
+    int is_double;
+    double *diagonal;
+    int (*matvec)(struct NDArrayOperator *op, const double *x, double *y);
+    void (*release)(struct NDArrayOperator *op);
+    void *data;
+} NDArrayOperator;
+
+/**
+ * Convergence report of an iterative solve. `residual` is the final
+ * ||b - A x|| / ||b||.
+ */
+typedef struct NDArraySolverInfo {
+    int iterations;
+    double residual;
+    int converged;
+} NDArraySolverInfo;
+
+/* Jacobi preconditioning modes of NDArray_CG and NDArray_GMRES. AUTO
+ * preconditions when the diagonal is known and has no zeros, ON throws
+ * when it can't. */
+#define NDARRAY_JACOBI_OFF  0
+#define NDARRAY_JACOBI_ON   1
+#define NDARRAY_JACOBI_AUTO 2
+
+int NDArray_DenseOperator(NDArrayOperator *op, NDArray *a);
+int NDArray_SparseOperator(NDArrayOperator *op, NDArraySparse *a);
+void NDArray_OperatorFree(NDArrayOperator *op);
+NDArray* NDArray_CG(NDArrayOperator *op, NDArray *b, NDArray *x0, double tol, int max_iter, int jacobi,
+                    NDArraySolverInfo *info);
+NDArray* NDArray_GMRES(NDArrayOperator *op, NDArray *b, NDArray *x0, double tol, int restart, int max_iter,
+                       int jacobi, NDArraySolverInfo *info);
+NDArray* NDArray_Lanczos(NDArrayOperator *op, int k, int largest, double tol, int max_dim, NDArray **vectors,
+                         NDArraySolverInfo *info);
+
+#endif //NUMPOWER_SOLVERS_H
@@ -0,0 +1,639 @@
+#include <Zend/zend.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include "sorting.h"
+#include "../initializers.h"
+#include "../manipulation.h"
+#include "../types.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+/* Rows up to this length are sorted with a compare-exchange network */
+#define NDARRAY_SORT_NETWORK_MAX 16
+/* A single row from this length is sorted in parallel chunks and merged */
+#define NDARRAY_SORT_PARALLEL_MIN 65536
+/* Elements loaded at once while scanning a row for top-k */
+#define NDARRAY_TOPK_CHUNK 256
+/* Element count from which independent rows are spread over threads */
+#define NDARRAY_SORT_ROWS_PARALLEL_MIN 4096
+
+/**
+ * Sort key and position of one element. Keys are unsigned integers
+ * ordered like the element values, so every dtype sorts the same way.
+ */
+typedef struct {
+    uint64_t key;
+    long index;
+} ndarray_sort_item;
+
+/**
+ * Row layout shared by the sorting kernels. Rows run along `axis`;
+ * `offsets` holds the byte offset of the first element of every row.
+ */
+typedef struct {
+    NDArray *source;
+    long nrows;
+    long length;
+    long stride;
+    long *offsets;
+} ndarray_rows;
+
+static inline uint64_t
+ndarray_double_key(double value) {
+    uint64_t bits;
+    if (value != value) {
+        // NaN sorts after +inf
+        return UINT64_MAX;
+    }
+    if (value == 0) {
+        value = 0.0;
+    }
+    memcpy(&bits, &value, sizeof(bits));
+    return (bits & 0x8000000000000000ULL) ? ~bits : bits | 0x8000000000000000ULL;
+}
+
+/**
+ * Load the keys of one row
+ */
+static void
+ndarray_load_row(const char *row, long stride, long n, const NDArrayTypeFuncs *funcs, ndarray_sort_item *items) {
+    long i;
+    if (funcs->kind == NDARRAY_KIND_FLOAT && funcs->elsize == 4 && is_type(funcs->name, NDARRAY_TYPE_FLOAT32)) {
+        for (i = 0; i < n; i++) {
+            items[i].key = ndarray_double_key(*(const float *) (row + i * stride));
+            items[i].index = i;
+        }
+    } else if (funcs->kind == NDARRAY_KIND_FLOAT) {
+        for (i = 0; i < n; i++) {
+            items[i].key = ndarray_double_key(funcs->getitem(row + i * stride));
+            items[i].index = i;
+        }
+    } else if (funcs->kind == NDARRAY_KIND_INT) {
+        for (i = 0; i < n; i++) {
+            items[i].key = (uint64_t) funcs->getlong(row + i * stride) ^ 0x8000000000000000ULL;
+            items[i].index = i;
+        }
+    } else {
+        for (i = 0; i < n; i++) {
+            items[i].key = (uint64_t) funcs->getlong(row + i * stride);
+            items[i].index = i;
+        }
+    }
+}
+
+static inline int
+ndarray_item_less(const ndarray_sort_item *a, const ndarray_sort_item *b) {
+    return a->key < b->key || (a->key == b->key && a->index < b->index);
+}
+
+/**
+ * Batcher odd-even merge network. Every compare-exchange is branch
+ * free, ties are broken by position so the result is stable.
+ */
+static void
+ndarray_sort_network(ndarray_sort_item *v, long n) {
+    long p, k, j, i;
+    for (p = 1; p < n; p <<= 1) {
+        for (k = p; k >= 1; k >>= 1) {
+            for (j = k % p; j + k < n; j += 2 * k) {
+                for (i = 0; i < k && i + j + k < n; i++) {
+                    if ((i + j) / (2 * p) == (i + j + k) / (2 * p)) {
+                        ndarray_sort_item x = v[i + j], y = v[i + j + k];
+                        int swap = ndarray_item_less(&y, &x);
+                        v[i + j] = swap ? y : x;
+                        v[i + j + k] = swap ? x : y;
+                    }
+                }
+            }
+        }
+    }
+}
+
+/**
+ * Stable LSD radix sort on the 64-bit keys, one byte per pass. Passes
+ * where every key shares the same byte are skipped, which drops the
+ * low mantissa passes of float32 data and the high passes of small
+ * integers.
+ */
+static void
+ndarray_sort_radix(ndarray_sort_item *v, ndarray_sort_item *tmp, long n) {
+    long counts[8][256] = {{0}};
+    long i, pos, c;
+    int pass, b;
+    ndarray_sort_item *src = v, *dst = tmp, *swap;
+
+    for (i = 0; i < n; i++) {
+        for (pass = 0; pass < 8; pass++) {
+            counts[pass][(v[i].key >> (pass * 8)) & 0xff]++;
+        }
+    }
+    for (pass = 0; pass < 8; pass++) {
+        if (counts[pass][(v[0].key >> (pass * 8)) & 0xff] == n) {
+            continue;
+        }
+        for (b = 0, pos = 0; b < 256; b++) {
+            c = counts[pass][b];
+            counts[pass][b] = pos;
+            pos += c;
+        }
+        for (i = 0; i < n; i++) {
+            dst[counts[pass][(src[i].key >> (pass * 8)) & 0xff]++] = src[i];
+        }
+        swap = src;
+        src = dst;
+        dst = swap;
+    }
+    if (src != v) {
+        memcpy(v, src, sizeof(ndarray_sort_item) * n);
+    }
+}
+
+static void
+ndarray_sort_items(ndarray_sort_item *v, ndarray_sort_item *tmp, long n) {
+    if (n <= NDARRAY_SORT_NETWORK_MAX) {
+        ndarray_sort_network(v, n);
+    } else {
+        ndarray_sort_radix(v, tmp, n);
+    }
+}
+
+static void
+ndarray_merge_runs(const ndarray_sort_item *a, long na, const ndarray_sort_item *b, long nb, ndarray_sort_item *out) {
+    long i = 0, j = 0, o = 0;
+    while (i < na && j < nb) {
+        out[o++] = ndarray_item_less(&b[j], &a[i]) ? b[j++] : a[i++];
+    }
+    while (i < na) {
+        out[o++] = a[i++];
+    }
+    while (j < nb) {
+        out[o++] = b[j++];
+    }
+}
+
+/**
+ * Sort one long row with every thread: chunks are radix sorted in
+ * parallel, then merged pairwise in parallel rounds
+ */
+static void
+ndarray_sort_parallel(ndarray_sort_item *v, ndarray_sort_item *tmp, long n) {
+#ifdef _OPENMP
+    int nchunks = omp_get_max_threads();
+    long width, c;
+    ndarray_sort_item *src = v, *dst = tmp, *swap;
+
+    if (nchunks < 2) {
+        ndarray_sort_items(v, tmp, n);
+        return;
+    }
+    width = (n + nchunks - 1) / nchunks;
+#pragma omp parallel for
+    for (c = 0; c < nchunks; c++) {
+        long start = c * width, end = start + width < n ? start + width : n;
+        if (start < end) {
+            ndarray_sort_items(v + start, tmp + start, end - start);
+        }
+    }
+    for (; width < n; width *= 2) {
+#pragma omp parallel for
+        for (c = 0; c < (n + 2 * width - 1) / (2 * width); c++) {
+            long start = c * 2 * width;
+            long mid = start + width < n ? start + width : n;
+            long end = start + 2 * width < n ? start + 2 * width : n;
+            ndarray_merge_runs(src + start, mid - start, src + mid, end - mid, dst + start);
+        }
+        swap = src;
+        src = dst;
+        dst = swap;
+    }
+    if (src != v) {
+        memcpy(v, src, sizeof(ndarray_sort_item) * n);
+    }
+#else
+    ndarray_sort_items(v, tmp, n);
+#endif
+}
+
+/**
+ * Split `a` into rows along `axis`. NDARRAY_MAX_DIMS uses the
+ * flattened array as a single row.
+ *
+ * @return 0 on success, -1 with an exception thrown otherwise
+ */
+static int
+ndarray_rows_init(NDArray *a, int axis, ndarray_rows *rows) {
+    int d, coords[NDARRAY_MAX_DIMS] = {0}, ndim = NDArray_NDIM(a);
+    long r;
+
+    if (NDArray_DEVICE(a) == NDARRAY_DEVICE_GPU) {
+        zend_throw_error(NULL, "Sorting is only available for NDArrays on CPU RAM.");
+        return -1;
+    }
+    if (NDArray_TypeFuncs(NDArray_TYPE(a)) == NULL) {
+        zend_throw_error(NULL, "Sorting not supported for dtype %s.", NDArray_TYPE(a));
+        return -1;
+    }
+    rows->source = a;
+    if (axis == NDARRAY_MAX_DIMS || ndim == 0) {
+        if (!NDArray_IsContiguous(a)) {
+            rows->source = NDArray_ToContiguous(a);
+        }
+        rows->nrows = 1;
+        rows->length = NDArray_NUMELEMENTS(a);
+        rows->stride = NDArray_ELSIZE(a);
+        rows->offsets = emalloc(sizeof(long));
+        rows->offsets[0] = 0;
+        return 0;
+    }
+    if (axis < -ndim || axis >= ndim) {
+        zend_throw_error(NULL, "Axis is out of bounds for array dimension");
+        return -1;
+    }
+    if (axis < 0) {
+        axis += ndim;
+    }
+    rows->length = NDArray_SHAPE(a)[axis];
+    rows->stride = NDArray_STRIDES(a)[axis];
+    rows->nrows = rows->length > 0 ? NDArray_NUMELEMENTS(a) / rows->length : 0;
+    rows->offsets = emalloc(sizeof(long) * (rows->nrows > 0 ? rows->nrows : 1));
+    // Walk every position of the other dimensions in C order
+    for (r = 0; r < rows->nrows; r++) {
+        long offset = 0;
+        for (d = 0; d < ndim; d++) {
+            offset += (long) coords[d] * NDArray_STRIDES(a)[d];
+        }
+        rows->offsets[r] = offset;
+        for (d = ndim - 1; d >= 0; d--) {
+            if (d == axis) {
+                continue;
+            }
+            if (++coords[d] < NDArray_SHAPE(a)[d]) {
+                break;
+            }
+            coords[d] = 0;
+        }
+    }
+    return 0;
+}
+
+static void
+ndarray_rows_free(NDArray *a, ndarray_rows *rows) {
+    efree(rows->offsets);
+    if (rows->source != a) {
+        NDArray_FREE(rows->source);
+    }
+}
+
+/**
+ * Output array with the shape of `a`, or 1-D when sorting flattened
+ */
+static NDArray*
+ndarray_rows_output(NDArray *a, int axis, const char *type, long length) {
+    int *shape, ndim = NDArray_NDIM(a), i;
+    if (axis == NDARRAY_MAX_DIMS || ndim == 0) {
+        shape = emalloc(sizeof(int));
+        shape[0] = (int) length;
+        return NDArray_Empty(shape, 1, type, NDARRAY_DEVICE_CPU);
+    }
+    if (axis < 0) {
+        axis += ndim;
+    }
+    shape = emalloc(sizeof(int) * ndim);
+    for (i = 0; i < ndim; i++) {
+        shape[i] = i == axis ? (int) length : NDArray_SHAPE(a)[i];
+    }
+    return NDArray_Empty(shape, ndim, type, NDARRAY_DEVICE_CPU);
+}
+
+/**
+ * Byte offset of row `r`, element `i` in a C contiguous output whose
+ * rows run along `axis`
+ */
+static inline long
+ndarray_out_offset(NDArray *out, int axis, long r, long i) {
+    int ndim = NDArray_NDIM(out);
+    long inner, outer_stride;
+    if (axis == NDARRAY_MAX_DIMS || axis == ndim - 1 || axis == -1) {
+        return (r * NDArray_SHAPE(out)[ndim - 1] + i) * NDArray_ELSIZE(out);
+    }
+    if (axis < 0) {
+        axis += ndim;
+    }
+    inner = NDArray_STRIDES(out)[axis] / NDArray_ELSIZE(out);
+    outer_stride = inner * NDArray_SHAPE(out)[axis];
+    return ((r / inner) * outer_stride + i * inner + r % inner) * NDArray_ELSIZE(out);
+}
+
+/**
+ * Threads a row loop runs on, never more than there are rows
+ */
+static int
+ndarray_rows_threads(const ndarray_rows *rows) {
+    int nthreads = 1;
+#ifdef _OPENMP
+    if (rows->nrows > 1 && rows->nrows * rows->length > NDARRAY_SORT_ROWS_PARALLEL_MIN) {
+        nthreads = omp_get_max_threads();
+        if (nthreads > rows->nrows) {
+            nthreads = (int)rows->nrows;
+        }
+    }
+#endif
+    return nthreads;
+}
+
+/**
+ * Scratch item buffers for `nthreads` threads, allocated up front
+ * because the Zend allocator can't be used from worker threads
+ */
+static ndarray_sort_item*
+ndarray_thread_scratch(long per_thread, int nthreads) {
+    return emalloc(sizeof(ndarray_sort_item) * (per_thread > 0 ? per_thread : 1) * nthreads);
+}
+
+static inline int
+ndarray_thread_id(void) {
+#ifdef _OPENMP
+    return omp_get_thread_num();
+#else
+    return 0;
+#endif
+}
+
+/**
+ * Shared body of sort and argsort
+ */
+static NDArray*
+ndarray_sort_common(NDArray *a, int axis, int return_indices) {
+    ndarray_rows rows;
+    NDArray *rtn;
+    ndarray_sort_item *scratch;
+    const NDArrayTypeFuncs *funcs = NDArray_TypeFuncs(NDArray_TYPE(a));
+    long r;
+    int nthreads;
+    int elsize = NDArray_ELSIZE(a);
+
+    if (ndarray_rows_init(a, axis, &rows) < 0) {
+        return NULL;
+    }
+    rtn = ndarray_rows_output(a, axis, return_indices ? NDARRAY_TYPE_INT64 : NDArray_TYPE(a), rows.length);
+
+    nthreads = ndarray_rows_threads(&rows);
+    scratch = ndarray_thread_scratch(2 * rows.length, nthreads);
+#pragma omp parallel for num_threads(nthreads) if (nthreads > 1)
+    for (r = 0; r < rows.nrows; r++) {
+        ndarray_sort_item *items = scratch + 2 * rows.length * ndarray_thread_id();
+        ndarray_sort_item *tmp = items + rows.length;
+        const char *row = NDArray_DATA(rows.source) + rows.offsets[r];
+        long i;
+
+        ndarray_load_row(row, rows.stride, rows.length, funcs, items);
+        if (rows.nrows == 1 && rows.length >= NDARRAY_SORT_PARALLEL_MIN) {
+            ndarray_sort_parallel(items, tmp, rows.length);
+        } else {
+            ndarray_sort_items(items, tmp, rows.length);
+        }
+        for (i = 0; i < rows.length; i++) {
+            char *out = NDArray_DATA(rtn) + ndarray_out_offset(rtn, axis, r, i);
+            if (return_indices) {
+                *(int64_t *) out = items[i].index;
+            } else {
+                memcpy(out, row + items[i].index * rows.stride, elsize);
+            }
+        }
+    }
+
+    efree(scratch);
+    ndarray_rows_free(a, &rows);
+    return rtn;
+}
+
+/**
+ * Sorted copy of `a` along `axis`. NaN values sort last.
+ *
+ * @param a
+ * @param axis NDARRAY_MAX_DIMS sorts the flattened array
+ * @return
+ */
+NDArray*
+NDArray_Sort(NDArray *a, int axis) {
+    return ndarray_sort_common(a, axis, 0);
+}
+
+/**
+ * Indices that stably sort `a` along `axis`
+ *
+ * @param a
+ * @param axis NDARRAY_MAX_DIMS sorts the flattened array
+ * @return int64 array
+ */
+NDArray*
+NDArray_ArgSort(NDArray *a, int axis) {
+    return ndarray_sort_common(a, axis, 1);
+}
+
+/**
+ * Reorder v so that v[kth] holds the element a full sort would put
+ * there, with smaller elements before it and larger ones after
+ */
+static void
+ndarray_select(ndarray_sort_item *v, ndarray_sort_item *tmp, long n, long kth) {
+    long lo = 0, hi = n - 1, budget = 64;
+    while (hi - lo > NDARRAY_SORT_NETWORK_MAX) {
+        if (budget-- == 0) {
+            // Bad pivots, finish with a full sort of the remaining range
+            ndarray_sort_radix(v + lo, tmp, hi - lo + 1);
+            return;
+        }
+        long mid = lo + (hi - lo) / 2, i = lo, j = hi;
+        ndarray_sort_item a = v[lo], b = v[mid], c = v[hi], pivot;
+        // Median of three
+        if (ndarray_item_less(&b, &a)) { pivot = a; a = b; b = pivot; }
+        if (ndarray_item_less(&c, &b)) { b = c; }
+        if (ndarray_item_less(&b, &a)) { b = a; }
+        pivot = b;
+        while (i <= j) {
+            while (ndarray_item_less(&v[i], &pivot)) {
+                i++;
+            }
+            while (ndarray_item_less(&pivot, &v[j])) {
+                j--;
+            }
+            if (i <= j) {
+                ndarray_sort_item t = v[i];
+                v[i++] = v[j];
+                v[j--] = t;
+            }
+        }
+        if (kth <= j) {
+            hi = j;
+        } else if (kth >= i) {
+            lo = i;
+        } else {
+            return;
+        }
+    }
+    ndarray_sort_network(v + lo, hi - lo + 1);
+}
+
+/**
+ * Copy of `a` partially sorted along `axis` so the element at `kth` is
+ * in its sorted position, smaller elements come before it and larger
+ * ones after
+ *
+ * @param a
+ * @param kth Negative values count from the end
+ * @param axis NDARRAY_MAX_DIMS partitions the flattened array
+ * @return
+ */
+NDArray*
+NDArray_Partition(NDArray *a, long kth, int axis) {
+    ndarray_rows rows;
+    NDArray *rtn;
+    ndarray_sort_item *scratch;
+    const NDArrayTypeFuncs *funcs = NDArray_TypeFuncs(NDArray_TYPE(a));
+    long r;
+    int nthreads;
+    int elsize = NDArray_ELSIZE(a);
+
+    if (ndarray_rows_init(a, axis, &rows) < 0) {
+        return NULL;
+    }
+    if (kth < 0) {
+        kth += rows.length;
+    }
+    if (kth < 0 || kth >= rows.length) {
+        zend_throw_error(NULL, "kth out of bounds for axis of size %ld.", rows.length);
+        ndarray_rows_free(a, &rows);
+        return NULL;
+    }
+    rtn = ndarray_rows_output(a, axis, NDArray_TYPE(a), rows.length);
+
+    nthreads = ndarray_rows_threads(&rows);
+    scratch = ndarray_thread_scratch(2 * rows.length, nthreads);
+#pragma omp parallel for num_threads(nthreads) if (nthreads > 1)
+    for (r = 0; r < rows.nrows; r++) {
+        ndarray_sort_item *items = scratch + 2 * rows.length * ndarray_thread_id();
+        ndarray_sort_item *tmp = items + rows.length;
+        const char *row = NDArray_DATA(rows.source) + rows.offsets[r];
+        long i;
+
+        ndarray_load_row(row, rows.stride, rows.length, funcs, items);
+        ndarray_select(items, tmp, rows.length, kth);
+        for (i = 0; i < rows.length; i++) {
+            memcpy(NDArray_DATA(rtn) + ndarray_out_offset(rtn, axis, r, i), row + items[i].index * rows.stride, elsize);
+        }
+    }
+
+    efree(scratch);
+    ndarray_rows_free(a, &rows);
+    return rtn;
+}
+
+/**
+ * Max-heap sift down, the root is the worst of the kept elements
+ */
+static void
+ndarray_heap_sift(ndarray_sort_item *heap, long size, long i) {
+    for (;;) {
+        long l = 2 * i + 1, r = l + 1, m = i;
+        if (l < size && ndarray_item_less(&heap[m], &heap[l])) {
+            m = l;
+        }
+        if (r < size && ndarray_item_less(&heap[m], &heap[r])) {
+            m = r;
+        }
+        if (m == i) {
+            return;
+        }
+        ndarray_sort_item t = heap[i];
+        heap[i] = heap[m];
+        heap[m] = t;
+        i = m;
+    }
+}
+
+/**
+ * The `k` largest elements of `a` along `axis` and their indices, in
+ * descending order. Equal values keep their original order. Rows are
+ * scanned once against a k-element heap, so wide rows with a small k
+ * never get fully sorted.
+ *
+ * @param a
+ * @param k
+ * @param axis
+ * @return Values with the dtype of `a` and int64 indices, NULL on error
+ */
+NDArray**
+NDArray_TopK(NDArray *a, long k, int axis) {
+    ndarray_rows rows;
+    NDArray **rtn;
+    ndarray_sort_item *scratch;
+    const NDArrayTypeFuncs *funcs = NDArray_TypeFuncs(NDArray_TYPE(a));
+    long r;
+    int nthreads;
+    int elsize = NDArray_ELSIZE(a);
+
+    if (ndarray_rows_init(a, axis, &rows) < 0) {
+        return NULL;
+    }
+    if (k < 0 || k > rows.length) {
+        zend_throw_error(NULL, "k must be between 0 and %ld.", rows.length);
+        ndarray_rows_free(a, &rows);
+        return NULL;
+    }
+    rtn = emalloc(sizeof(NDArray*) * 2);
+    rtn[0] = ndarray_rows_output(a, axis, NDArray_TYPE(a), k);
+    rtn[1] = ndarray_rows_output(a, axis, NDARRAY_TYPE_INT64, k);
+
+    nthreads = ndarray_rows_threads(&rows);
+    scratch = ndarray_thread_scratch(k + NDARRAY_TOPK_CHUNK, nthreads);
+#pragma omp parallel for num_threads(nthreads) if (nthreads > 1)
+    for (r = 0; r < rows.nrows; r++) {
+        ndarray_sort_item *heap = scratch + (k + NDARRAY_TOPK_CHUNK) * ndarray_thread_id();
+        ndarray_sort_item *chunk = heap + k;
+        const char *row = NDArray_DATA(rows.source) + rows.offsets[r];
+        long i, j, m, size = 0;
+
+        for (i = 0; i < rows.length && k > 0; i += NDARRAY_TOPK_CHUNK) {
+            m = rows.length - i < NDARRAY_TOPK_CHUNK ? rows.length - i : NDARRAY_TOPK_CHUNK;
+            ndarray_load_row(row + i * rows.stride, rows.stride, m, funcs, chunk);
+            for (j = 0; j < m; j++) {
+                ndarray_sort_item item = chunk[j];
+                // Larger keys win, equal keys prefer the earlier position
+                item.key = ~item.key;
+                item.index = i + j;
+                if (size < k) {
+                    long c = size++;
+                    heap[c] = item;
+                    while (c > 0 && ndarray_item_less(&heap[(c - 1) / 2], &heap[c])) {
+                        ndarray_sort_item t = heap[c];
+                        heap[c] = heap[(c - 1) / 2];
+                        heap[(c - 1) / 2] = t;
+                        c = (c - 1) / 2;
+                    }
+                } else if (ndarray_item_less(&item, &heap[0])) {
+                    heap[0] = item;
+                    ndarray_heap_sift(heap, size, 0);
+                }
+            }
+        }
+        // Pop the worst kept element to the back until the heap is empty
+        for (i = size - 1; i > 0; i--) {
+            ndarray_sort_item t = heap[0];
+            heap[0] = heap[i];
+            heap[i] = t;
+            ndarray_heap_sift(heap, i, 0);
+        }
+        for (i = 0; i < size; i++) {
+            memcpy(NDArray_DATA(rtn[0]) + ndarray_out_offset(rtn[0], axis, r, i), row + heap[i].index * rows.stride, elsize);
+            *(int64_t *) (NDArray_DATA(rtn[1]) + ndarray_out_offset(rtn[1], axis, r, i)) = heap[i].index;
+        }
+    }
+
+    efree(scratch);
+    ndarray_rows_free(a, &rows);
+    return rtn;
+}
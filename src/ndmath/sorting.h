@@ -0,0 +1,11 @@
+#ifndef NUMPOWER_SORTING_H
+#define NUMPOWER_SORTING_H
+
+#include "../ndarray.h"
+
+NDArray* NDArray_Sort(NDArray *a, int axis);
+NDArray* NDArray_ArgSort(NDArray *a, int axis);
+NDArray* NDArray_Partition(NDArray *a, long kth, int axis);
+NDArray** NDArray_TopK(NDArray *a, long k, int axis);
+
+#endif //NUMPOWER_SORTING_H
@@ -0,0 +1,221 @@
+#include <php.h>
+#include <stdlib.h>
+#include <string.h>
+#include "Zend/zend_alloc.h"
+#include "Zend/zend_hash.h"
+#include "persistent.h"
+#include "ndarray.h"
+#include "initializers.h"
+#include "manipulation.h"
+#include "types.h"
+#include "../config.h"
+
+/**
+ * Arrays persisted by name. The table and its buffers live in pemalloc
+ * memory owned by the module, so they survive the end of the request.
+ * Threads of a ZTS build share them behind PERSISTENT_LOCK.
+ */
+static HashTable PERSISTENT_ARRAYS;
+static NDArrayPersistentStats PERSISTENT_STATS;
+#ifdef ZTS
+static MUTEX_T PERSISTENT_LOCK;
+#define PERSISTENT_LOCK_ACQUIRE() tsrm_mutex_lock(PERSISTENT_LOCK)
+#define PERSISTENT_LOCK_RELEASE() tsrm_mutex_unlock(PERSISTENT_LOCK)
+#else
+#define PERSISTENT_LOCK_ACQUIRE()
+#define PERSISTENT_LOCK_RELEASE()
+#endif
+
+static void
+persistent_header_release(NDArrayPersistentHeader *header)
+{
+    if (__atomic_sub_fetch(&header->refcount, 1, __ATOMIC_ACQ_REL) == 0) {
+        pefree(header, 1);
+    }
+}
+
+static void
+persistent_entry_dtor(zval *zv)
+{
+    NDArrayPersistentHeader *header = Z_PTR_P(zv);
+    PERSISTENT_STATS.count--;
+    PERSISTENT_STATS.bytes -= header->size;
+    persistent_header_release(header);
+}
+
+/**
+ * Initialize the registry, called on MINIT. The limit is read
+ * from the NDARRAY_PERSISTENT_LIMIT environment variable (bytes).
+ */
+void
+persistent_init()
+{
+    char *limit = getenv("NDARRAY_PERSISTENT_LIMIT");
+#ifdef ZTS
+    PERSISTENT_LOCK = tsrm_mutex_alloc();
+#endif
+    zend_hash_init(&PERSISTENT_ARRAYS, 8, NULL, persistent_entry_dtor, 1);
+    memset(&PERSISTENT_STATS, 0, sizeof(PERSISTENT_STATS));
+    PERSISTENT_STATS.limit = NDARRAY_PERSISTENT_DEFAULT_LIMIT;
+    if (limit != NULL) {
+        PERSISTENT_STATS.limit = (size_t)strtoull(limit, NULL, 10);
+    }
+}
+
+/**
+ * Free every persisted array, called on MSHUTDOWN
+ */
+void
+persistent_shutdown()
+{
+    zend_hash_destroy(&PERSISTENT_ARRAYS);
+#ifdef ZTS
+    tsrm_mutex_free(PERSISTENT_LOCK);
+#endif
+}
+
+/**
+ * Copy `a` into persistent memory under `name`, replacing any
+ * array previously stored with the same name.
+ *
+ * @param a
+ * @param name
+ * @param name_len
+ * @return
+ */
+int
+NDArray_Persist(NDArray *a, const char *name, size_t name_len)
+{
+    NDArrayPersistentHeader *header, *previous;
+    NDArray *contiguous = a;
+    size_t size, current;
+
+    if (NDArray_DEVICE(a) == NDARRAY_DEVICE_GPU) {
+        zend_throw_error(NULL, "NDArray must be on CPU RAM before it can be persisted.");
+        return -1;
+    }
+    if (NDArray_NDIM(a) == 0) {
+        zend_throw_error(NULL, "Scalars can't be persisted.");
+        return -1;
+    }
+
+    size = (size_t)NDArray_NUMELEMENTS(a) * NDArray_ELSIZE(a);
+    header = pemalloc(NDARRAY_PERSISTENT_HEADER_SIZE + size, 1);
+    header->refcount = 1;
+    header->ndim = NDArray_NDIM(a);
+    header->size = size;
+    memset(header->type, 0, sizeof(header->type));
+    strncpy(header->type, NDArray_TYPE(a), sizeof(header->type) - 1);
+    memcpy(header->shape, NDArray_SHAPE(a), sizeof(int) * NDArray_NDIM(a));
+
+    if (!NDArray_IsContiguous(a)) {
+        contiguous = NDArray_ToContiguous(a);
+    }
+    memcpy((char*)header + NDARRAY_PERSISTENT_HEADER_SIZE, NDArray_DATA(contiguous), size);
+    if (contiguous != a) {
+        NDArray_FREE(contiguous);
+    }
+
+    PERSISTENT_LOCK_ACQUIRE();
+    current = PERSISTENT_STATS.bytes;
+    previous = zend_hash_str_find_ptr(&PERSISTENT_ARRAYS, name, name_len);
+    if (previous != NULL) {
+        current -= previous->size;
+    }
+    if (PERSISTENT_STATS.limit > 0 && current + size > PERSISTENT_STATS.limit) {
+        PERSISTENT_LOCK_RELEASE();
+        pefree(header, 1);
+        zend_throw_error(NULL, "Persisting \"%s\" would exceed the persistent memory limit of %zu bytes.",
+                         name, PERSISTENT_STATS.limit);
+        return -1;
+    }
+
+    // The destructor of the replaced entry updates the stats
+    zend_hash_str_update_ptr(&PERSISTENT_ARRAYS, name, name_len, header);
+    PERSISTENT_STATS.count++;
+    PERSISTENT_STATS.bytes += size;
+    PERSISTENT_LOCK_RELEASE();
+    return 0;
+}
+
+/**
+ * Return an array that reads the persisted buffer `name` in place,
+ * or NULL if nothing was persisted under that name. The array is
+ * copy-on-write: NDArray_EnsureWritable gives it a private copy before
+ * anything writes to it.
+ *
+ * @param name
+ * @param name_len
+ * @return
+ */
+NDArray*
+NDArray_PersistentFetch(const char *name, size_t name_len)
+{
+    NDArray *rtn;
+    int *shape;
+    NDArrayPersistentHeader *header;
+
+    PERSISTENT_LOCK_ACQUIRE();
+    header = zend_hash_str_find_ptr(&PERSISTENT_ARRAYS, name, name_len);
+    if (header == NULL) {
+        PERSISTENT_STATS.misses++;
+        PERSISTENT_LOCK_RELEASE();
+        return NULL;
+    }
+    PERSISTENT_STATS.hits++;
+    __atomic_add_fetch(&header->refcount, 1, __ATOMIC_ACQ_REL);
+    PERSISTENT_LOCK_RELEASE();
+
+    shape = emalloc(sizeof(int) * header->ndim);
+    memcpy(shape, header->shape, sizeof(int) * header->ndim);
+    rtn = Create_NDArray(shape, header->ndim, NDArray_ParseType(header->type), NDARRAY_DEVICE_CPU);
+    rtn->data = (char*)header + NDARRAY_PERSISTENT_HEADER_SIZE;
+    // The holder owns the registry reference, views of rtn borrow it
+    NDArray_ENABLEFLAGS(NDArray_CopyOnWriteHolder(rtn), NDARRAY_ARRAY_PERSISTENT);
+    return rtn;
+}
+
+/**
+ * Remove `name` from the registry. Arrays fetched earlier keep the
+ * buffer alive until they are freed.
+ *
+ * @param name
+ * @param name_len
+ * @return
+ */
+int
+NDArray_PersistentRemove(const char *name, size_t name_len)
+{
+    int status;
+
+    PERSISTENT_LOCK_ACQUIRE();
+    status = zend_hash_str_del(&PERSISTENT_ARRAYS, name, name_len) == FAILURE ? -1 : 0;
+    PERSISTENT_LOCK_RELEASE();
+    return status;
+}
+
+/**
+ * Drop the registry reference held by the buffer holder of a fetched
+ * array. Called by NDArray_FREE.
+ *
+ * @param a
+ */
+void
+NDArray_PersistentRelease(NDArray *a)
+{
+    persistent_header_release((NDArrayPersistentHeader*)((char*)NDArray_DATA(a) - NDARRAY_PERSISTENT_HEADER_SIZE));
+}
+
+/**
+ * @return
+ */
+NDArrayPersistentStats
+NDArray_PersistentStats()
+{
+    NDArrayPersistentStats stats;
+
+    PERSISTENT_LOCK_ACQUIRE();
+    stats = PERSISTENT_STATS;
+    PERSISTENT_LOCK_RELEASE();
+    return stats;
+}
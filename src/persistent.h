@@ -0,0 +1,38 @@
+#ifndef NUMPOWER_PERSISTENT_H
+#define NUMPOWER_PERSISTENT_H
+
+#include <stddef.h>
+#include "ndarray.h"
+
+#define NDARRAY_PERSISTENT_DEFAULT_LIMIT (256L * 1024L * 1024L)
+
+/**
+ * Header stored in front of every persistent data buffer
+ */
+typedef struct NDArrayPersistentHeader {
+    int refcount;           // Registry reference + live request arrays
+    int ndim;
+    size_t size;            // Data size in bytes
+    char type[16];
+    int shape[NDARRAY_MAX_DIMS];
+} NDArrayPersistentHeader;
+
+#define NDARRAY_PERSISTENT_HEADER_SIZE (((sizeof(NDArrayPersistentHeader) + 63) / 64) * 64)
+
+typedef struct NDArrayPersistentStats {
+    long count;
+    size_t bytes;
+    size_t limit;
+    long hits;
+    long misses;
+} NDArrayPersistentStats;
+
+void persistent_init();
+void persistent_shutdown();
+int NDArray_Persist(NDArray *a, const char *name, size_t name_len);
+NDArray* NDArray_PersistentFetch(const char *name, size_t name_len);
+int NDArray_PersistentRemove(const char *name, size_t name_len);
+void NDArray_PersistentRelease(NDArray *a);
+NDArrayPersistentStats NDArray_PersistentStats();
+
+#endif //NUMPOWER_PERSISTENT_H
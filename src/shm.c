@@ -0,0 +1,212 @@
+#include <Zend/zend.h>
+#include <stdio.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include "shm.h"
+#include "ndarray.h"
+#include "initializers.h"
+#include "types.h"
+#include "../config.h"
+
+/**
+ * Build the POSIX shared memory object name for `name`
+ *
+ * @param name
+ * @param path
+ * @return 0 on success, -1 if the name is invalid
+ */
+static int
+shm_path(const char *name, char *path, size_t path_size)
+{
+    size_t length = strlen(name);
+    if (length == 0 || length > NDARRAY_SHM_MAX_NAME || strchr(name, '/') != NULL) {
+        zend_throw_error(NULL, "Invalid shared array name \"%s\".", name);
+        return -1;
+    }
+    snprintf(path, path_size, "%s%s", NDARRAY_SHM_PREFIX, name);
+    return 0;
+}
+
+/**
+ * Wrap a mapped segment into an NDArray that does not own its buffer
+ *
+ * @param header
+ * @return
+ */
+static NDArray*
+shm_wrap(NDArraySharedHeader *header)
+{
+    NDArray *rtn;
+    int *shape = emalloc(sizeof(int) * (header->ndim > 0 ? header->ndim : 1));
+    memcpy(shape, header->shape, sizeof(int) * header->ndim);
+    rtn = Create_NDArray(shape, header->ndim, NDArray_ParseType(header->type), NDARRAY_DEVICE_CPU);
+    rtn->data = (char*)header + NDARRAY_SHM_HEADER_SIZE;
+    NDArray_ENABLEFLAGS(rtn, NDARRAY_ARRAY_SHARED);
+    return rtn;
+}
+
+/**
+ * Create a named array backed by POSIX shared memory.
+ *
+ * The segment outlives the request and the creating process, it is only
+ * removed by NDArray_SharedUnlink. Releasing the last mapping keeps it,
+ * so a worker can attach to it again later.
+ *
+ * @param name
+ * @param shape
+ * @param ndim
+ * @param type
+ * @return
+ */
+NDArray*
+NDArray_SharedCreate(const char *name, int *shape, int ndim, const char *type)
+{
+    char path[NDARRAY_SHM_MAX_NAME + sizeof(NDARRAY_SHM_PREFIX)];
+    NDArraySharedHeader *header;
+    uint64_t num_elements = 1, size;
+    void *addr;
+    int fd, i;
+
+    if (shm_path(name, path, sizeof(path)) < 0) {
+        return NULL;
+    }
+    if (ndim < 1 || ndim > NDARRAY_MAX_DIMS) {
+        zend_throw_error(NULL, "Shared arrays must have between 1 and %d dimensions.", NDARRAY_MAX_DIMS);
+        return NULL;
+    }
+    for (i = 0; i < ndim; i++) {
+        if (shape[i] <= 0) {
+            zend_throw_error(NULL, "Shared arrays can't have empty dimensions.");
+            return NULL;
+        }
+        num_elements *= (uint64_t)shape[i];
+    }
+    size = NDARRAY_SHM_HEADER_SIZE + num_elements * get_type_size(type);
+
+    fd = shm_open(path, O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0) {
+        if (errno == EEXIST) {
+            zend_throw_error(NULL, "Shared array \"%s\" already exists.", name);
+        } else {
+            zend_throw_error(NULL, "Could not create shared array \"%s\": %s", name, strerror(errno));
+        }
+        return NULL;
+    }
+    if (ftruncate(fd, (off_t)size) < 0) {
+        close(fd);
+        shm_unlink(path);
+        zend_throw_error(NULL, "Could not allocate shared array \"%s\": %s", name, strerror(errno));
+        return NULL;
+    }
+    addr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED) {
+        shm_unlink(path);
+        zend_throw_error(NULL, "Could not map shared array \"%s\": %s", name, strerror(errno));
+        return NULL;
+    }
+
+    header = (NDArraySharedHeader*)addr;
+    header->ndim = ndim;
+    header->size = size;
+    header->refcount = 1;
+    header->elsize = get_type_size(type);
+    strncpy(header->type, type, sizeof(header->type) - 1);
+    for (i = 0; i < ndim; i++) {
+        header->shape[i] = shape[i];
+    }
+    // Published last, attach() rejects segments that are not initialized yet
+    __atomic_store_n(&header->magic, NDARRAY_SHM_MAGIC, __ATOMIC_RELEASE);
+    return shm_wrap(header);
+}
+
+/**
+ * Map an existing named shared array into this process
+ *
+ * @param name
+ * @return
+ */
+NDArray*
+NDArray_SharedAttach(const char *name)
+{
+    char path[NDARRAY_SHM_MAX_NAME + sizeof(NDARRAY_SHM_PREFIX)];
+    NDArraySharedHeader *header;
+    const char *type;
+    struct stat st;
+    void *addr;
+    int fd;
+
+    if (shm_path(name, path, sizeof(path)) < 0) {
+        return NULL;
+    }
+    fd = shm_open(path, O_RDWR, 0600);
+    if (fd < 0) {
+        zend_throw_error(NULL, "Shared array \"%s\" does not exist.", name);
+        return NULL;
+    }
+    if (fstat(fd, &st) < 0 || (size_t)st.st_size < NDARRAY_SHM_HEADER_SIZE) {
+        close(fd);
+        zend_throw_error(NULL, "Shared array \"%s\" is not initialized.", name);
+        return NULL;
+    }
+    addr = mmap(NULL, (size_t)st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED) {
+        zend_throw_error(NULL, "Could not map shared array \"%s\": %s", name, strerror(errno));
+        return NULL;
+    }
+
+    header = (NDArraySharedHeader*)addr;
+    type = __atomic_load_n(&header->magic, __ATOMIC_ACQUIRE) == NDARRAY_SHM_MAGIC ?
+           NDArray_ParseType(header->type) : NULL;
+    if (type == NULL || header->size != (uint64_t)st.st_size || header->elsize != get_type_size(type)) {
+        munmap(addr, (size_t)st.st_size);
+        zend_throw_error(NULL, "Shared array \"%s\" is not initialized.", name);
+        return NULL;
+    }
+    __atomic_add_fetch(&header->refcount, 1, __ATOMIC_ACQ_REL);
+    return shm_wrap(header);
+}
+
+/**
+ * Remove the name of a shared array. Processes that already attached
+ * keep their mapping until they release it.
+ *
+ * @param name
+ * @return
+ */
+int
+NDArray_SharedUnlink(const char *name)
+{
+    char path[NDARRAY_SHM_MAX_NAME + sizeof(NDARRAY_SHM_PREFIX)];
+
+    if (shm_path(name, path, sizeof(path)) < 0) {
+        return -1;
+    }
+    if (shm_unlink(path) < 0) {
+        zend_throw_error(NULL, "Shared array \"%s\" does not exist.", name);
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * Unmap the segment backing `a`. Called by NDArray_FREE instead of
+ * efree. The segment itself stays until NDArray_SharedUnlink removes
+ * its name, whatever the number of mappings left.
+ *
+ * @param a
+ */
+void
+NDArray_SharedRelease(NDArray *a)
+{
+    NDArraySharedHeader *header = (NDArraySharedHeader*)((char*)NDArray_DATA(a) - NDARRAY_SHM_HEADER_SIZE);
+    size_t size = header->size;
+
+    __atomic_sub_fetch(&header->refcount, 1, __ATOMIC_ACQ_REL);
+    munmap(header, size);
+}
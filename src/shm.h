@@ -0,0 +1,31 @@
+#ifndef NUMPOWER_SHM_H
+#define NUMPOWER_SHM_H
+
+#include <stdint.h>
+#include "ndarray.h"
+
+#define NDARRAY_SHM_MAGIC 0x4e505348
+#define NDARRAY_SHM_PREFIX "/numpower."
+#define NDARRAY_SHM_MAX_NAME 200
+
+/**
+ * Header stored at the start of every shared memory segment
+ */
+typedef struct NDArraySharedHeader {
+    uint32_t magic;
+    int32_t ndim;
+    uint64_t size;           // Total mapped size in bytes (header included)
+    int32_t refcount;        // Live mappings of this segment across processes
+    int32_t elsize;
+    char type[16];
+    int32_t shape[NDARRAY_MAX_DIMS];
+} NDArraySharedHeader;
+
+#define NDARRAY_SHM_HEADER_SIZE (((sizeof(NDArraySharedHeader) + 63) / 64) * 64)
+
+NDArray* NDArray_SharedCreate(const char *name, int *shape, int ndim, const char *type);
+NDArray* NDArray_SharedAttach(const char *name);
+int NDArray_SharedUnlink(const char *name);
+void NDArray_SharedRelease(NDArray *a);
+
+#endif //NUMPOWER_SHM_H
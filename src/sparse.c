@@ -0,0 +1,692 @@
+#include <Zend/zend.h>
+#include <string.h>
+#include <math.h>
+#include "sparse.h"
+#include "ndarray.h"
+#include "initializers.h"
+#include "types.h"
+#include "../config.h"
+
+/* Multiply-adds below which sparse products stay on one thread */
+#define NDARRAY_SPARSE_PARALLEL_MIN 65536
+
+#define NDARRAY_SPARSE_ELSIZE(sp) ((sp)->is_double ? sizeof(double) : sizeof(float))
+
+static NDArraySparse*
+ndarray_sparse_alloc(int format, int m, int n, long nnz, int is_double) {
+    NDArraySparse *sp = emalloc(sizeof(NDArraySparse));
+    long count = nnz > 0 ? nnz : 1;
+
+    sp->format = format;
+    sp->shape[0] = m;
+    sp->shape[1] = n;
+    sp->is_double = is_double;
+    sp->nnz = nnz;
+    sp->indptr = format == NDARRAY_SPARSE_CSR ? emalloc(sizeof(long) * ((long)m + 1)) : NULL;
+    sp->rows = format == NDARRAY_SPARSE_COO ? emalloc(sizeof(int) * count) : NULL;
+    sp->indices = emalloc(sizeof(int) * count);
+    sp->values = emalloc(NDARRAY_SPARSE_ELSIZE(sp) * count);
+    return sp;
+}
+
+void
+NDArray_SparseFree(NDArraySparse *sp) {
+    if (sp == NULL) {
+        return;
+    }
+    if (sp->indptr != NULL) {
+        efree(sp->indptr);
+    }
+    if (sp->rows != NULL) {
+        efree(sp->rows);
+    }
+    efree(sp->indices);
+    efree(sp->values);
+    efree(sp);
+}
+
+/**
+ * Row offsets of `sp`, built from the row indices of a COO matrix. The
+ * caller frees the result when `sp` is COO.
+ */
+static long*
+ndarray_sparse_indptr(NDArraySparse *sp) {
+    long *indptr, k;
+    int i;
+
+    if (sp->format == NDARRAY_SPARSE_CSR) {
+        return sp->indptr;
+    }
+    indptr = ecalloc((long)sp->shape[0] + 1, sizeof(long));
+    for (k = 0; k < sp->nnz; k++) {
+        indptr[sp->rows[k] + 1]++;
+    }
+    for (i = 0; i < sp->shape[0]; i++) {
+        indptr[i + 1] += indptr[i];
+    }
+    return indptr;
+}
+
+/**
+ * Switch `sp` to `format` in place
+ */
+static NDArraySparse*
+ndarray_sparse_set_format(NDArraySparse *sp, int format) {
+    long k;
+    int i;
+
+    if (format == NDARRAY_SPARSE_CSR && sp->format == NDARRAY_SPARSE_COO) {
+        sp->indptr = ndarray_sparse_indptr(sp);
+        efree(sp->rows);
+        sp->rows = NULL;
+        sp->format = NDARRAY_SPARSE_CSR;
+    } else if (format == NDARRAY_SPARSE_COO && sp->format == NDARRAY_SPARSE_CSR) {
+        sp->rows = emalloc(sizeof(int) * (sp->nnz > 0 ? sp->nnz : 1));
+        for (i = 0; i < sp->shape[0]; i++) {
+            for (k = sp->indptr[i]; k < sp->indptr[i + 1]; k++) {
+                sp->rows[k] = i;
+            }
+        }
+        efree(sp->indptr);
+        sp->indptr = NULL;
+        sp->format = NDARRAY_SPARSE_COO;
+    }
+    return sp;
+}
+
+/**
+ * Contiguous CPU copy of `a` with the given type
+ */
+static NDArray*
+ndarray_sparse_cast(NDArray *a, const char *type) {
+    NDArray *cpu, *rtn;
+
+    if (NDArray_DEVICE(a) == NDARRAY_DEVICE_GPU) {
+        cpu = NDArray_ToCPU(a);
+        if (cpu == NULL) {
+            return NULL;
+        }
+        rtn = NDArray_AsType(cpu, type);
+        NDArray_FREE(cpu);
+        return rtn;
+    }
+    return NDArray_AsType(a, type);
+}
+
+/**
+ * Validated integer indices of a triplet component
+ */
+static int*
+ndarray_sparse_index_list(NDArray *a, int bound, const char *name) {
+    NDArray *cast = ndarray_sparse_cast(a, NDARRAY_TYPE_DOUBLE64);
+    long k, count;
+    int *rtn;
+    double v;
+
+    if (cast == NULL) {
+        return NULL;
+    }
+    count = NDArray_NUMELEMENTS(cast);
+    rtn = emalloc(sizeof(int) * (count > 0 ? count : 1));
+    for (k = 0; k < count; k++) {
+        v = NDArray_DDATA(cast)[k];
+        if (v != floor(v) || v < 0 || v >= bound) {
+            zend_throw_error(NULL, "%s index %g is out of bounds for size %d.", name, v, bound);
+            efree(rtn);
+            NDArray_FREE(cast);
+            return NULL;
+        }
+        rtn[k] = (int)v;
+    }
+    NDArray_FREE(cast);
+    return rtn;
+}
+
+/**
+ * Build a sparse matrix from (row, column, value) triplets. Duplicated
+ * coordinates are summed. Values keep float64 precision, any other
+ * type is stored as float32.
+ *
+ * @param rows
+ * @param cols
+ * @param values
+ * @param m number of rows
+ * @param n number of columns
+ * @param format NDARRAY_SPARSE_CSR or NDARRAY_SPARSE_COO
+ * @return
+ */
+NDArraySparse*
+NDArray_SparseFromTriplets(NDArray *rows, NDArray *cols, NDArray *values, int m, int n, int format) {
+    int is_double = is_type(NDArray_TYPE(values), NDARRAY_TYPE_DOUBLE64);
+    long nnz = NDArray_NUMELEMENTS(values), k, pos, out, *offsets;
+    int *r, *c, *tr = NULL, *tc = NULL, i;
+    double *tv = NULL, *v = NULL;
+    NDArraySparse *sp;
+    NDArray *cast;
+
+    if (m < 0 || n < 0) {
+        zend_throw_error(NULL, "Sparse array shape must be non-negative.");
+        return NULL;
+    }
+    if (NDArray_NUMELEMENTS(rows) != nnz || NDArray_NUMELEMENTS(cols) != nnz) {
+        zend_throw_error(NULL, "rows, cols and values must have the same number of elements.");
+        return NULL;
+    }
+    r = ndarray_sparse_index_list(rows, m, "Row");
+    if (r == NULL) {
+        return NULL;
+    }
+    c = ndarray_sparse_index_list(cols, n, "Column");
+    cast = c != NULL ? ndarray_sparse_cast(values, NDARRAY_TYPE_DOUBLE64) : NULL;
+    if (cast == NULL) {
+        efree(r);
+        if (c != NULL) {
+            efree(c);
+        }
+        return NULL;
+    }
+    v = NDArray_DDATA(cast);
+
+    // Two stable counting sorts, by column then by row, order the entries
+    // by (row, column) in O(nnz + m + n)
+    tr = emalloc(sizeof(int) * (nnz > 0 ? nnz : 1));
+    tc = emalloc(sizeof(int) * (nnz > 0 ? nnz : 1));
+    tv = emalloc(sizeof(double) * (nnz > 0 ? nnz : 1));
+    offsets = ecalloc((long)(m > n ? m : n) + 1, sizeof(long));
+    for (k = 0; k < nnz; k++) {
+        offsets[c[k] + 1]++;
+    }
+    for (i = 0; i < n; i++) {
+        offsets[i + 1] += offsets[i];
+    }
+    for (k = 0; k < nnz; k++) {
+        pos = offsets[c[k]]++;
+        tr[pos] = r[k];
+        tc[pos] = c[k];
+        tv[pos] = v[k];
+    }
+    sp = ndarray_sparse_alloc(NDARRAY_SPARSE_CSR, m, n, nnz, is_double);
+    memset(offsets, 0, sizeof(long) * ((long)m + 1));
+    for (k = 0; k < nnz; k++) {
+        offsets[tr[k] + 1]++;
+    }
+    for (i = 0; i < m; i++) {
+        offsets[i + 1] += offsets[i];
+    }
+    memcpy(sp->indptr, offsets, sizeof(long) * ((long)m + 1));
+    for (k = 0; k < nnz; k++) {
+        pos = offsets[tr[k]]++;
+        c[pos] = tc[k];
+        v[pos] = tv[k];
+    }
+
+    // Merge duplicated coordinates, now adjacent
+    out = 0;
+    pos = 0;
+    for (i = 0; i < m; i++) {
+        long end = sp->indptr[i + 1];
+        sp->indptr[i] = out;
+        for (k = pos, pos = end; k < end; k++) {
+            if (out > sp->indptr[i] && sp->indices[out - 1] == c[k]) {
+                tv[out - 1] += v[k];
+                continue;
+            }
+            sp->indices[out] = c[k];
+            tv[out] = v[k];
+            out++;
+        }
+    }
+    sp->indptr[m] = out;
+    sp->nnz = out;
+    for (k = 0; k < out; k++) {
+        if (is_double) {
+            ((double *)sp->values)[k] = tv[k];
+        } else {
+            ((float *)sp->values)[k] = (float)tv[k];
+        }
+    }
+    efree(offsets);
+    efree(tr);
+    efree(tc);
+    efree(tv);
+    efree(r);
+    efree(c);
+    NDArray_FREE(cast);
+    return ndarray_sparse_set_format(sp, format);
+}
+
+/**
+ * Sparse copy of the non-zero entries of a two-dimensional array
+ *
+ * @param a
+ * @param format NDARRAY_SPARSE_CSR or NDARRAY_SPARSE_COO
+ * @return
+ */
+NDArraySparse*
+NDArray_SparseFromDense(NDArray *a, int format) {
+    int is_double = is_type(NDArray_TYPE(a), NDARRAY_TYPE_DOUBLE64);
+    NDArraySparse *sp;
+    NDArray *cast;
+    long k, nnz = 0, count;
+    int i, j, m, n;
+
+    if (NDArray_NDIM(a) != 2) {
+        zend_throw_error(NULL, "Sparse arrays must be two-dimensional.");
+        return NULL;
+    }
+    cast = ndarray_sparse_cast(a, is_double ? NDARRAY_TYPE_DOUBLE64 : NDARRAY_TYPE_FLOAT32);
+    if (cast == NULL) {
+        return NULL;
+    }
+    m = NDArray_SHAPE(a)[0];
+    n = NDArray_SHAPE(a)[1];
+    count = (long)m * n;
+    for (k = 0; k < count; k++) {
+        nnz += is_double ? NDArray_DDATA(cast)[k] != 0 : NDArray_FDATA(cast)[k] != 0;
+    }
+    sp = ndarray_sparse_alloc(NDARRAY_SPARSE_CSR, m, n, nnz, is_double);
+    k = 0;
+    for (i = 0; i < m; i++) {
+        sp->indptr[i] = k;
+        for (j = 0; j < n; j++) {
+            if (is_double && NDArray_DDATA(cast)[(long)i * n + j] != 0) {
+                ((double *)sp->values)[k] = NDArray_DDATA(cast)[(long)i * n + j];
+                sp->indices[k++] = j;
+            } else if (!is_double && NDArray_FDATA(cast)[(long)i * n + j] != 0) {
+                ((float *)sp->values)[k] = NDArray_FDATA(cast)[(long)i * n + j];
+                sp->indices[k++] = j;
+            }
+        }
+    }
+    sp->indptr[m] = k;
+    NDArray_FREE(cast);
+    return ndarray_sparse_set_format(sp, format);
+}
+
+/**
+ * Dense copy of a sparse matrix
+ *
+ * @param sp
+ * @return
+ */
+NDArray*
+NDArray_SparseToDense(NDArraySparse *sp) {
+    int *shape = emalloc(sizeof(int) * 2);
+    size_t elsize = NDARRAY_SPARSE_ELSIZE(sp);
+    long *indptr = ndarray_sparse_indptr(sp), k;
+    NDArray *rtn;
+    int i;
+
+    shape[0] = sp->shape[0];
+    shape[1] = sp->shape[1];
+    rtn = NDArray_Zeros(shape, 2, sp->is_double ? NDARRAY_TYPE_DOUBLE64 : NDARRAY_TYPE_FLOAT32, NDARRAY_DEVICE_CPU);
+    for (i = 0; i < sp->shape[0]; i++) {
+        for (k = indptr[i]; k < indptr[i + 1]; k++) {
+            memcpy(NDArray_DATA(rtn) + ((long)i * sp->shape[1] + sp->indices[k]) * elsize,
+                   sp->values + k * elsize, elsize);
+        }
+    }
+    if (indptr != sp->indptr) {
+        efree(indptr);
+    }
+    return rtn;
+}
+
+/**
+ * Copy of `sp` stored in `format`
+ *
+ * @param sp
+ * @param format NDARRAY_SPARSE_CSR or NDARRAY_SPARSE_COO
+ * @return
+ */
+NDArraySparse*
+NDArray_SparseAsFormat(NDArraySparse *sp, int format) {
+    return ndarray_sparse_set_format(NDArray_SparseRows(sp, 0, sp->shape[0]), format);
+}
+
+/**
+ * Sparse transpose, computed with a counting sort over the columns
+ *
+ * @param sp
+ * @return transpose in the format of `sp`
+ */
+NDArraySparse*
+NDArray_SparseTranspose(NDArraySparse *sp) {
+    size_t elsize = NDARRAY_SPARSE_ELSIZE(sp);
+    long *indptr = ndarray_sparse_indptr(sp), *next, k, pos;
+    NDArraySparse *t;
+    int i;
+
+    t = ndarray_sparse_alloc(NDARRAY_SPARSE_CSR, sp->shape[1], sp->shape[0], sp->nnz, sp->is_double);
+    memset(t->indptr, 0, sizeof(long) * ((long)t->shape[0] + 1));
+    for (k = 0; k < sp->nnz; k++) {
+        t->indptr[sp->indices[k] + 1]++;
+    }
+    for (i = 0; i < t->shape[0]; i++) {
+        t->indptr[i + 1] += t->indptr[i];
+    }
+    next = emalloc(sizeof(long) * ((long)t->shape[0] + 1));
+    memcpy(next, t->indptr, sizeof(long) * ((long)t->shape[0] + 1));
+    for (i = 0; i < sp->shape[0]; i++) {
+        for (k = indptr[i]; k < indptr[i + 1]; k++) {
+            pos = next[sp->indices[k]]++;
+            t->indices[pos] = i;
+            memcpy(t->values + pos * elsize, sp->values + k * elsize, elsize);
+        }
+    }
+    efree(next);
+    if (indptr != sp->indptr) {
+        efree(indptr);
+    }
+    return ndarray_sparse_set_format(t, sp->format);
+}
+
+/**
+ * Rows [start, stop) of a sparse matrix. Negative bounds count from the
+ * last row.
+ *
+ * @param sp
+ * @param start
+ * @param stop
+ * @return rows in the format of `sp`
+ */
+NDArraySparse*
+NDArray_SparseRows(NDArraySparse *sp, int start, int stop) {
+    size_t elsize = NDARRAY_SPARSE_ELSIZE(sp);
+    long *indptr, first;
+    NDArraySparse *rtn;
+    int i;
+
+    if (start < 0) {
+        start += sp->shape[0];
+    }
+    if (stop < 0) {
+        stop += sp->shape[0];
+    }
+    if (start < 0 || stop > sp->shape[0] || start > stop) {
+        zend_throw_error(NULL, "Row slice is out of bounds for %d rows.", sp->shape[0]);
+        return NULL;
+    }
+    indptr = ndarray_sparse_indptr(sp);
+    first = indptr[start];
+    rtn = ndarray_sparse_alloc(NDARRAY_SPARSE_CSR, stop - start, sp->shape[1], indptr[stop] - first, sp->is_double);
+    for (i = 0; i <= stop - start; i++) {
+        rtn->indptr[i] = indptr[start + i] - first;
+    }
+    memcpy(rtn->indices, sp->indices + first, sizeof(int) * rtn->nnz);
+    memcpy(rtn->values, sp->values + first * elsize, elsize * rtn->nnz);
+    if (indptr != sp->indptr) {
+        efree(indptr);
+    }
+    return ndarray_sparse_set_format(rtn, sp->format);
+}
+
+/**
+ * Sparse @ dense and dense @ sparse kernels. Rows are split across
+ * threads; inner loops run over contiguous dense rows, or over the
+ * unique columns of a canonical sparse row, so they vectorize safely.
+ */
+#define NDARRAY_SPARSE_KERNELS(T, tname)                                                           \
+static void                                                                                        \
+tname##_sparse_dense(const long *indptr, const int *indices, const T *values, int m,              \
+                     const T *b, int p, T *out) {                                                  \
+    int parallel = indptr[m] * (long)p >= NDARRAY_SPARSE_PARALLEL_MIN;                             \
+    int i;                                                                                         \
+    _Pragma("omp parallel for schedule(dynamic, 64) if (parallel)")                                \
+    for (i = 0; i < m; i++) {                                                                      \
+        T *row = out + (long)i * p;                                                                \
+        long k;                                                                                    \
+        int j;                                                                                     \
+        if (p == 1) {                                                                              \
+            T acc = 0;                                                                             \
+            _Pragma("omp simd reduction(+:acc)")                                                   \
+            for (k = indptr[i]; k < indptr[i + 1]; k++) {                                          \
+                acc += values[k] * b[indices[k]];                                                  \
+            }                                                                                      \
+            row[0] = acc;                                                                          \
+            continue;                                                                              \
+        }                                                                                          \
+        memset(row, 0, sizeof(T) * p);                                                             \
+        for (k = indptr[i]; k < indptr[i + 1]; k++) {                                              \
+            const T v = values[k];                                                                 \
+            const T *brow = b + (long)indices[k] * p;                                              \
+            _Pragma("omp simd")                                                                    \
+            for (j = 0; j < p; j++) {                                                              \
+                row[j] += v * brow[j];                                                             \
+            }                                                                                      \
+        }                                                                                          \
+    }                                                                                              \
+}                                                                                                  \
+                                                                                                   \
+static void                                                                                        \
+tname##_dense_sparse(const T *a, int m, int k, const long *indptr, const int *indices,            \
+                     const T *values, int n, T *out) {                                             \
+    int parallel = (long)m * indptr[k] >= NDARRAY_SPARSE_PARALLEL_MIN;                             \
+    int i;                                                                                         \
+    _Pragma("omp parallel for if (parallel)")                                                      \
+    for (i = 0; i < m; i++) {                                                                      \
+        T *row = out + (long)i * n;                                                                \
+        long t;                                                                                    \
+        int q;                                                                                     \
+        memset(row, 0, sizeof(T) * n);                                                             \
+        for (q = 0; q < k; q++) {                                                                  \
+            const T aq = a[(long)i * k + q];                                                       \
+            if (aq == 0) {                                                                         \
+                continue;                                                                          \
+            }                                                                                      \
+            _Pragma("omp simd")                                                                    \
+            for (t = indptr[q]; t < indptr[q + 1]; t++) {                                          \
+                row[indices[t]] += aq * values[t];                                                 \
+            }                                                                                      \
+        }                                                                                          \
+    }                                                                                              \
+}
+
+NDARRAY_SPARSE_KERNELS(float, float32)
+NDARRAY_SPARSE_KERNELS(double, float64)
+
+/**
+ * Values of `sp` as float64 when `is_double`, borrowed when they already are
+ */
+static char*
+ndarray_sparse_values(NDArraySparse *sp, int is_double) {
+    double *rtn;
+    long k;
+
+    if (sp->is_double || !is_double) {
+        return sp->values;
+    }
+    rtn = emalloc(sizeof(double) * (sp->nnz > 0 ? sp->nnz : 1));
+    for (k = 0; k < sp->nnz; k++) {
+        rtn[k] = ((float *)sp->values)[k];
+    }
+    return (char *)rtn;
+}
+
+/**
+ * Dense operand of a sparse product, cast to the result type, and the
+ * shape of the result
+ */
+static NDArray*
+ndarray_sparse_operand(NDArray *a, int is_double, int **shape) {
+    if (NDArray_NDIM(a) != 1 && NDArray_NDIM(a) != 2) {
+        zend_throw_error(NULL, "Sparse products need a vector or a matrix operand.");
+        return NULL;
+    }
+    *shape = emalloc(sizeof(int) * 2);
+    return ndarray_sparse_cast(a, is_double ? NDARRAY_TYPE_DOUBLE64 : NDARRAY_TYPE_FLOAT32);
+}
+
+/**
+ * Move a product back to the device of its dense operand
+ */
+static NDArray*
+ndarray_sparse_result(NDArray *rtn, NDArray *operand) {
+    NDArray *gpu;
+
+    if (NDArray_DEVICE(operand) != NDARRAY_DEVICE_GPU) {
+        return rtn;
+    }
+    gpu = NDArray_ToGPU(rtn);
+    NDArray_FREE(rtn);
+    return gpu;
+}
+
+/**
+ * Sparse @ dense product. `b` is a vector of sp.shape[1] elements or a
+ * matrix with sp.shape[1] rows; the result is float64 when either
+ * operand is float64.
+ *
+ * @param sp
+ * @param b
+ * @return
+ */
+NDArray*
+NDArray_SparseMatmul(NDArraySparse *sp, NDArray *b) {
+    int is_double = sp->is_double || is_type(NDArray_TYPE(b), NDARRAY_TYPE_DOUBLE64);
+    int p = NDArray_NDIM(b) == 2 ? NDArray_SHAPE(b)[1] : 1, *shape = NULL;
+    long *indptr;
+    char *values;
+    NDArray *cast, *rtn;
+
+    if (NDArray_NDIM(b) >= 1 && NDArray_SHAPE(b)[0] != sp->shape[1]) {
+        zend_throw_error(NULL, "Shape mismatch for matmul. cols(a) != rows(b)");
+        return NULL;
+    }
+    cast = ndarray_sparse_operand(b, is_double, &shape);
+    if (cast == NULL) {
+        if (shape != NULL) {
+            efree(shape);
+        }
+        return NULL;
+    }
+    shape[0] = sp->shape[0];
+    shape[1] = p;
+    rtn = NDArray_Empty(shape, NDArray_NDIM(b), is_double ? NDARRAY_TYPE_DOUBLE64 : NDARRAY_TYPE_FLOAT32,
+                        NDARRAY_DEVICE_CPU);
+    indptr = ndarray_sparse_indptr(sp);
+    values = ndarray_sparse_values(sp, is_double);
+    if (is_double) {
+        float64_sparse_dense(indptr, sp->indices, (double *)values, sp->shape[0], NDArray_DDATA(cast), p,
+                             NDArray_DDATA(rtn));
+    } else {
+        float32_sparse_dense(indptr, sp->indices, (float *)values, sp->shape[0], NDArray_FDATA(cast), p,
+                             NDArray_FDATA(rtn));
+    }
+    if (values != sp->values) {
+        efree(values);
+    }
+    if (indptr != sp->indptr) {
+        efree(indptr);
+    }
+    NDArray_FREE(cast);
+    return ndarray_sparse_result(rtn, b);
+}
+
+/**
+ * Dense @ sparse product. `a` is a vector of sp.shape[0] elements or a
+ * matrix with sp.shape[0] columns.
+ *
+ * @param a
+ * @param sp
+ * @return
+ */
+NDArray*
+NDArray_DenseSparseMatmul(NDArray *a, NDArraySparse *sp) {
+    int is_double = sp->is_double || is_type(NDArray_TYPE(a), NDARRAY_TYPE_DOUBLE64);
+    int m = NDArray_NDIM(a) == 2 ? NDArray_SHAPE(a)[0] : 1, *shape = NULL;
+    long *indptr;
+    char *values;
+    NDArray *cast, *rtn;
+
+    if (NDArray_NDIM(a) >= 1 && NDArray_SHAPE(a)[NDArray_NDIM(a) - 1] != sp->shape[0]) {
+        zend_throw_error(NULL, "Shape mismatch for matmul. cols(a) != rows(b)");
+        return NULL;
+    }
+    cast = ndarray_sparse_operand(a, is_double, &shape);
+    if (cast == NULL) {
+        if (shape != NULL) {
+            efree(shape);
+        }
+        return NULL;
+    }
+    if (NDArray_NDIM(a) == 2) {
+        shape[0] = m;
+        shape[1] = sp->shape[1];
+    } else {
+        shape[0] = sp->shape[1];
+    }
+    rtn = NDArray_Empty(shape, NDArray_NDIM(a), is_double ? NDARRAY_TYPE_DOUBLE64 : NDARRAY_TYPE_FLOAT32,
+                        NDARRAY_DEVICE_CPU);
+    indptr = ndarray_sparse_indptr(sp);
+    values = ndarray_sparse_values(sp, is_double);
+    if (is_double) {
+        float64_dense_sparse(NDArray_DDATA(cast), m, sp->shape[0], indptr, sp->indices, (double *)values,
+                             sp->shape[1], NDArray_DDATA(rtn));
+    } else {
+        float32_dense_sparse(NDArray_FDATA(cast), m, sp->shape[0], indptr, sp->indices, (float *)values,
+                             sp->shape[1], NDArray_FDATA(rtn));
+    }
+    if (values != sp->values) {
+        efree(values);
+    }
+    if (indptr != sp->indptr) {
+        efree(indptr);
+    }
+    NDArray_FREE(cast);
+    return ndarray_sparse_result(rtn, a);
+}
+
+/**
+ * y = A x in float64 for a CSR matrix, used by the iterative solvers
+ *
+ * @param csr
+ * @param x
+ * @param y
+ */
+void
+NDArray_SparseMatvec(NDArraySparse *csr, const double *x, double *y) {
+    int parallel = csr->nnz >= NDARRAY_SPARSE_PARALLEL_MIN;
+    int i;
+
+#pragma omp parallel for schedule(dynamic, 64) if (parallel)
+    for (i = 0; i < csr->shape[0]; i++) {
+        double acc = 0;
+        long k;
+        if (csr->is_double) {
+            for (k = csr->indptr[i]; k < csr->indptr[i + 1]; k++) {
+                acc += ((double *)csr->values)[k] * x[csr->indices[k]];
+            }
+        } else {
+            for (k = csr->indptr[i]; k < csr->indptr[i + 1]; k++) {
+                acc += ((float *)csr->values)[k] * x[csr->indices[k]];
+            }
+        }
+        y[i] = acc;
+    }
+}
+
+/**
+ * Main diagonal of a square sparse matrix, zeros where no entry is stored
+ *
+ * @param sp
+ * @param diagonal sp.shape[0] doubles
+ */
+void
+NDArray_SparseDiagonal(NDArraySparse *sp, double *diagonal) {
+    long *indptr = ndarray_sparse_indptr(sp), k;
+    int i;
+
+    for (i = 0; i < sp->shape[0]; i++) {
+        diagonal[i] = 0;
+        for (k = indptr[i]; k < indptr[i + 1]; k++) {
+            if (sp->indices[k] == i) {
+                diagonal[i] = sp->is_double ? ((double *)sp->values)[k] : ((float *)sp->values)[k];
+                break;
+            }
+        }
+    }
+    if (indptr != sp->indptr) {
+        efree(indptr);
+    }
+}
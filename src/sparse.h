@@ -0,0 +1,38 @@
+#ifndef PHPSCI_NDARRAY_SPARSE_H
+#define PHPSCI_NDARRAY_SPARSE_H
+
+#include "ndarray.h"
+
+#define NDARRAY_SPARSE_CSR 0
+#define NDARRAY_SPARSE_COO 1
+
+/**
+ * Two-dimensional sparse matrix with float32 or float64 values.
+ *
+ * Entries are always canonical: sorted by row then column, without
+ * duplicates. CSR keeps the `shape[0] + 1` row offsets in `indptr`, COO
+ * keeps the row of every entry in `rows`; the other pointer is NULL.
+ */
+typedef struct NDArraySparse {
+    int format;
+    int shape[2];
+    int is_double;
+    long nnz;
+    long *indptr;
+    int *rows;
+    int *indices;
+    char *values;
+} NDArraySparse;
+
+void NDArray_SparseFree(NDArraySparse *sp);
+NDArraySparse* NDArray_SparseFromTriplets(NDArray *rows, NDArray *cols, NDArray *values, int m, int n, int format);
+NDArraySparse* NDArray_SparseFromDense(NDArray *a, int format);
+NDArray* NDArray_SparseToDense(NDArraySparse *sp);
+NDArraySparse* NDArray_SparseAsFormat(NDArraySparse *sp, int format);
+NDArraySparse* NDArray_SparseTranspose(NDArraySparse *sp);
+NDArraySparse* NDArray_SparseRows(NDArraySparse *sp, int start, int stop);
+NDArray* NDArray_SparseMatmul(NDArraySparse *sp, NDArray *b);
+NDArray* NDArray_DenseSparseMatmul(NDArray *a, NDArraySparse *sp);
+void NDArray_SparseMatvec(NDArraySparse *csr, const double *x, double *y);
+void NDArray_SparseDiagonal(NDArraySparse *sp, double *diagonal);
+#endif //PHPSCI_NDARRAY_SPARSE_H
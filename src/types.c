@@ -1,5 +1,18 @@
 #include "types.h"
 #include "string.h"
+#include <stdint.h>
+#include "../config.h"
+
+#if defined(HAVE_AVX2) && defined(__AVX2__)
+#include <immintrin.h>
+#define NDARRAY_HAVE_AVX2_CONVERT 1
+#if defined(__F16C__)
+#define NDARRAY_HAVE_F16C 1
+#endif
+#endif
+
+/* Number of half precision elements converted to float32 at a time */
+#define NDARRAY_HALF_TILE 256
 
 /**
  * Get size of a specific NDArray type
@@ -14,6 +27,21 @@ int get_type_size(const char *type) {
     if (!strcmp(type, NDARRAY_TYPE_FLOAT32)) {
         return sizeof(float);
     }
+    if (!strcmp(type, NDARRAY_TYPE_INT32)) {
+        return sizeof(int32_t);
+    }
+    if (!strcmp(type, NDARRAY_TYPE_INT64)) {
+        return sizeof(int64_t);
+    }
+    if (!strcmp(type, NDARRAY_TYPE_UINT8) || !strcmp(type, NDARRAY_TYPE_BOOL)) {
+        return sizeof(uint8_t);
+    }
+    if (!strcmp(type, NDARRAY_TYPE_INT8)) {
+        return sizeof(int8_t);
+    }
+    if (!strcmp(type, NDARRAY_TYPE_FLOAT16) || !strcmp(type, NDARRAY_TYPE_BFLOAT16)) {
+        return sizeof(uint16_t);
+    }
     return 0;
 }
 
@@ -27,4 +55,714 @@ int is_type(const char *type_a, const char *type_b) {
         return 1;
     }
     return 0;
-}
\ No newline at end of file
+}
+
+/**
+ * Convert an IEEE 754 half precision value to float32
+ *
+ * @param h
+ * @return
+ */
+float
+NDArray_HalfToFloat(uint16_t h) {
+    uint32_t sign = (uint32_t) (h & 0x8000) << 16;
+    uint32_t exp = (h >> 10) & 0x1F;
+    uint32_t mant = h & 0x3FF;
+    uint32_t bits;
+    float f;
+
+    if (exp == 0) {
+        if (mant == 0) {
+            bits = sign;
+        } else {
+            // Subnormal, renormalize into a float32 exponent
+            exp = 127 - 15 + 1;
+            while (!(mant & 0x400)) {
+                mant <<= 1;
+                exp--;
+            }
+            bits = sign | (exp << 23) | ((mant & 0x3FF) << 13);
+        }
+    } else if (exp == 0x1F) {
+        bits = sign | 0x7F800000 | (mant << 13);
+    } else {
+        bits = sign | ((exp + 127 - 15) << 23) | (mant << 13);
+    }
+    memcpy(&f, &bits, sizeof(f));
+    return f;
+}
+
+/**
+ * Convert a float32 value to IEEE 754 half precision, rounding to nearest even
+ *
+ * @param f
+ * @return
+ */
+uint16_t
+NDArray_FloatToHalf(float f) {
+    uint32_t bits, sign, mant, rem, halfway, half;
+    int exp, shift;
+
+    memcpy(&bits, &f, sizeof(bits));
+    sign = (bits >> 16) & 0x8000;
+    exp = (int) ((bits >> 23) & 0xFF);
+    mant = bits & 0x7FFFFF;
+
+    if (exp == 0xFF) {
+        return (uint16_t) (sign | 0x7C00 | (mant ? 0x200 | (mant >> 13) : 0));
+    }
+    exp = exp - 127 + 15;
+    if (exp >= 0x1F) {
+        return (uint16_t) (sign | 0x7C00);
+    }
+    if (exp <= 0) {
+        if (exp < -10) {
+            return (uint16_t) sign;
+        }
+        mant |= 0x800000;
+        shift = 14 - exp;
+        half = mant >> shift;
+        rem = mant & ((1u << shift) - 1);
+        halfway = 1u << (shift - 1);
+        if (rem > halfway || (rem == halfway && (half & 1))) {
+            half++;
+        }
+        return (uint16_t) (sign | half);
+    }
+    half = sign | ((uint32_t) exp << 10) | (mant >> 13);
+    rem = mant & 0x1FFF;
+    // A carry out of the mantissa correctly rounds up into the exponent
+    if (rem > 0x1000 || (rem == 0x1000 && (half & 1))) {
+        half++;
+    }
+    return (uint16_t) half;
+}
+
+/**
+ * Convert a bfloat16 value to float32
+ *
+ * @param h
+ * @return
+ */
+float
+NDArray_BFloat16ToFloat(uint16_t h) {
+    uint32_t bits = (uint32_t) h << 16;
+    float f;
+    memcpy(&f, &bits, sizeof(f));
+    return f;
+}
+
+/**
+ * Convert a float32 value to bfloat16, rounding to nearest even
+ *
+ * @param f
+ * @return
+ */
+uint16_t
+NDArray_FloatToBFloat16(float f) {
+    uint32_t bits;
+    memcpy(&bits, &f, sizeof(bits));
+    if (f != f) {
+        // Keep NaNs quiet, rounding could turn them into infinities
+        return (uint16_t) ((bits >> 16) | 0x40);
+    }
+    bits += 0x7FFF + ((bits >> 16) & 1);
+    return (uint16_t) (bits >> 16);
+}
+
+#define NDARRAY_ISNAN(x) ((x) != (x))
+
+#define NDARRAY_BINARY_LOOP(tname, ctype, opname, op)                                   \
+static void                                                                             \
+tname##_##opname(const char *a, long a_stride, const char *b, long b_stride,           \
+                 char *out, long out_stride, long n) {                                  \
+    long i;                                                                             \
+    if (a_stride == sizeof(ctype) && b_stride == sizeof(ctype) &&                       \
+        out_stride == sizeof(ctype)) {                                                  \
+        const ctype *pa = (const ctype *) a;                                            \
+        const ctype *pb = (const ctype *) b;                                            \
+        ctype *po = (ctype *) out;                                                      \
+        for (i = 0; i < n; i++) {                                                       \
+            po[i] = pa[i] op pb[i];                                                     \
+        }                                                                               \
+        return;                                                                         \
+    }                                                                                   \
+    for (i = 0; i < n; i++) {                                                           \
+        *(ctype *) out = *(const ctype *) a op *(const ctype *) b;                      \
+        a += a_stride;                                                                  \
+        b += b_stride;                                                                  \
+        out += out_stride;                                                              \
+    }                                                                                   \
+}
+
+#define NDARRAY_COMPARE_LOOP(tname, ctype, opname, op)                                  \
+static void                                                                             \
+tname##_##opname(const char *a, long a_stride, const char *b, long b_stride,           \
+                 char *out, long out_stride, long n) {                                  \
+    long i;                                                                             \
+    if (a_stride == sizeof(ctype) && b_stride == sizeof(ctype) && out_stride == 1) {    \
+        const ctype *pa = (const ctype *) a;                                            \
+        const ctype *pb = (const ctype *) b;                                            \
+        unsigned char *po = (unsigned char *) out;                                      \
+        for (i = 0; i < n; i++) {                                                       \
+            po[i] = pa[i] op pb[i];                                                     \
+        }                                                                               \
+        return;                                                                         \
+    }                                                                                   \
+    for (i = 0; i < n; i++) {                                                           \
+        *(unsigned char *) out = *(const ctype *) a op *(const ctype *) b;              \
+        a += a_stride;                                                                  \
+        b += b_stride;                                                                  \
+        out += out_stride;                                                              \
+    }                                                                                   \
+}
+
+#define NDARRAY_TYPE_KERNELS(tname, ctype, acctype)                                     \
+static double                                                                           \
+tname##_getitem(const char *ptr) {                                                      \
+    return (double) *(const ctype *) ptr;                                               \
+}                                                                                       \
+static long                                                                             \
+tname##_getlong(const char *ptr) {                                                      \
+    return (long) *(const ctype *) ptr;                                                 \
+}                                                                                       \
+static void                                                                             \
+tname##_to_float32(const char *src, long src_stride, float *dst, long n) {             \
+    long i;                                                                             \
+    for (i = 0; i < n; i++) {                                                           \
+        dst[i] = (float) *(const ctype *) (src + i * src_stride);                       \
+    }                                                                                   \
+}                                                                                       \
+NDARRAY_COMPARE_LOOP(tname, ctype, greater, >)                                          \
+NDARRAY_COMPARE_LOOP(tname, ctype, greater_equal, >=)                                   \
+NDARRAY_COMPARE_LOOP(tname, ctype, less, <)                                             \
+NDARRAY_COMPARE_LOOP(tname, ctype, less_equal, <=)                                      \
+NDARRAY_COMPARE_LOOP(tname, ctype, equal, ==)                                           \
+NDARRAY_COMPARE_LOOP(tname, ctype, not_equal, !=)                                       \
+static double                                                                           \
+tname##_sum(const char *data, long n) {                                                 \
+    const ctype *p = (const ctype *) data;                                              \
+    acctype value = 0;                                                                  \
+    long i;                                                                             \
+    for (i = 0; i < n; i++) {                                                           \
+        value += p[i];                                                                  \
+    }                                                                                   \
+    return (double) value;                                                              \
+}                                                                                       \
+static double                                                                           \
+tname##_prod(const char *data, long n) {                                                \
+    const ctype *p = (const ctype *) data;                                              \
+    acctype value = 1;                                                                  \
+    long i;                                                                             \
+    for (i = 0; i < n; i++) {                                                           \
+        value *= p[i];                                                                  \
+    }                                                                                   \
+    return (double) value;                                                              \
+}                                                                                       \
+static double                                                                           \
+tname##_min(const char *data, long n) {                                                 \
+    const ctype *p = (const ctype *) data;                                              \
+    ctype value = p[0];                                                                 \
+    long i;                                                                             \
+    for (i = 1; i < n; i++) {                                                           \
+        if (p[i] < value) value = p[i];                                                 \
+    }                                                                                   \
+    return (double) value;                                                              \
+}                                                                                       \
+static double                                                                           \
+tname##_max(const char *data, long n) {                                                 \
+    const ctype *p = (const ctype *) data;                                              \
+    ctype value = p[0];                                                                 \
+    long i;                                                                             \
+    for (i = 1; i < n; i++) {                                                           \
+        if (p[i] > value) value = p[i];                                                 \
+    }                                                                                   \
+    return (double) value;                                                              \
+}                                                                                       \
+static long                                                                             \
+tname##_argmax(const char *data, long n) {                                              \
+    const ctype *p = (const ctype *) data;                                              \
+    ctype mp = p[0];                                                                    \
+    long i, index = 0;                                                                  \
+    if (NDARRAY_ISNAN(mp)) {                                                            \
+        return 0;                                                                       \
+    }                                                                                   \
+    for (i = 1; i < n; i++) {                                                           \
+        if (p[i] > mp || NDARRAY_ISNAN(p[i])) {                                         \
+            mp = p[i];                                                                  \
+            index = i;                                                                  \
+            if (NDARRAY_ISNAN(mp)) break;                                               \
+        }                                                                               \
+    }                                                                                   \
+    return index;                                                                       \
+}                                                                                       \
+static long                                                                             \
+tname##_argmin(const char *data, long n) {                                              \
+    const ctype *p = (const ctype *) data;                                              \
+    ctype mp = p[0];                                                                    \
+    long i, index = 0;                                                                  \
+    if (NDARRAY_ISNAN(mp)) {                                                            \
+        return 0;                                                                       \
+    }                                                                                   \
+    for (i = 1; i < n; i++) {                                                           \
+        if (p[i] < mp || NDARRAY_ISNAN(p[i])) {                                         \
+            mp = p[i];                                                                  \
+            index = i;                                                                  \
+            if (NDARRAY_ISNAN(mp)) break;                                               \
+        }                                                                               \
+    }                                                                                   \
+    return index;                                                                       \
+}                                                                                       \
+static long                                                                             \
+tname##_count_nonzero(const char *data, long n) {                                       \
+    const ctype *p = (const ctype *) data;                                              \
+    long i, count = 0;                                                                  \
+    for (i = 0; i < n; i++) {                                                           \
+        count += (p[i] != 0);                                                           \
+    }                                                                                   \
+    return count;                                                                       \
+}
+
+#define NDARRAY_TYPE_SETITEM(tname, ctype)                                              \
+static void                                                                             \
+tname##_setitem(char *ptr, double value) {                                              \
+    *(ctype *) ptr = (ctype) value;                                                     \
+}                                                                                       \
+static void                                                                             \
+tname##_from_float32(const float *src, char *dst, long dst_stride, long n) {           \
+    long i;                                                                             \
+    for (i = 0; i < n; i++) {                                                           \
+        *(ctype *) (dst + i * dst_stride) = (ctype) src[i];                             \
+    }                                                                                   \
+}
+
+#define NDARRAY_ARITHMETIC_LOOPS(tname, ctype)                                          \
+NDARRAY_BINARY_LOOP(tname, ctype, add, +)                                               \
+NDARRAY_BINARY_LOOP(tname, ctype, subtract, -)                                          \
+NDARRAY_BINARY_LOOP(tname, ctype, multiply, *)
+
+/*
+ * Integer and bool types have no true-division loop; NDArray_BinaryOp
+ * promotes them to float64 first. Bool arithmetic promotes to int64.
+ */
+#define NDARRAY_TYPE_FUNCS_ENTRY(tname, type_const, ctype, kind, add, subtract, multiply, divide) \
+    {type_const, sizeof(ctype), kind, tname##_getitem, tname##_setitem, tname##_getlong, \
+     add, subtract, multiply, divide,                                                   \
+     tname##_greater, tname##_greater_equal, tname##_less, tname##_less_equal,         \
+     tname##_equal, tname##_not_equal,                                                  \
+     tname##_sum, tname##_prod, tname##_min, tname##_max,                               \
+     tname##_argmax, tname##_argmin, tname##_count_nonzero,                             \
+     tname##_to_float32, tname##_from_float32}
+
+NDARRAY_TYPE_KERNELS(float32, float, float)
+NDARRAY_TYPE_KERNELS(float64, double, double)
+NDARRAY_TYPE_KERNELS(int32, int32_t, int64_t)
+NDARRAY_TYPE_KERNELS(int64, int64_t, int64_t)
+NDARRAY_TYPE_KERNELS(uint8, uint8_t, int64_t)
+NDARRAY_TYPE_KERNELS(int8, int8_t, int64_t)
+NDARRAY_TYPE_KERNELS(bool, uint8_t, int64_t)
+NDARRAY_ARITHMETIC_LOOPS(float32, float)
+NDARRAY_ARITHMETIC_LOOPS(float64, double)
+NDARRAY_ARITHMETIC_LOOPS(int32, int32_t)
+NDARRAY_ARITHMETIC_LOOPS(int64, int64_t)
+NDARRAY_ARITHMETIC_LOOPS(uint8, uint8_t)
+NDARRAY_ARITHMETIC_LOOPS(int8, int8_t)
+NDARRAY_BINARY_LOOP(float32, float, divide, /)
+NDARRAY_BINARY_LOOP(float64, double, divide, /)
+NDARRAY_TYPE_SETITEM(float32, float)
+NDARRAY_TYPE_SETITEM(float64, double)
+NDARRAY_TYPE_SETITEM(int32, int32_t)
+NDARRAY_TYPE_SETITEM(int64, int64_t)
+NDARRAY_TYPE_SETITEM(uint8, uint8_t)
+NDARRAY_TYPE_SETITEM(int8, int8_t)
+
+static void
+bool_setitem(char *ptr, double value) {
+    *(uint8_t *) ptr = value != 0;
+}
+
+static void
+bool_from_float32(const float *src, char *dst, long dst_stride, long n) {
+    long i;
+    for (i = 0; i < n; i++) {
+        *(uint8_t *) (dst + i * dst_stride) = src[i] != 0;
+    }
+}
+
+static void
+float16_to_float32(const char *src, long src_stride, float *dst, long n) {
+    long i = 0;
+    if (src_stride == sizeof(uint16_t)) {
+        const uint16_t *p = (const uint16_t *) src;
+#ifdef NDARRAY_HAVE_F16C
+        for (; i + 8 <= n; i += 8) {
+            __m128i h = _mm_loadu_si128((const __m128i *) (p + i));
+            _mm256_storeu_ps(dst + i, _mm256_cvtph_ps(h));
+        }
+#endif
+        for (; i < n; i++) {
+            dst[i] = NDArray_HalfToFloat(p[i]);
+        }
+        return;
+    }
+    for (; i < n; i++) {
+        dst[i] = NDArray_HalfToFloat(*(const uint16_t *) (src + i * src_stride));
+    }
+}
+
+static void
+float16_from_float32(const float *src, char *dst, long dst_stride, long n) {
+    long i = 0;
+    if (dst_stride == sizeof(uint16_t)) {
+        uint16_t *p = (uint16_t *) dst;
+#ifdef NDARRAY_HAVE_F16C
+        for (; i + 8 <= n; i += 8) {
+            __m128i h = _mm256_cvtps_ph(_mm256_loadu_ps(src + i), _MM_FROUND_TO_NEAREST_INT);
+            _mm_storeu_si128((__m128i *) (p + i), h);
+        }
+#endif
+        for (; i < n; i++) {
+            p[i] = NDArray_FloatToHalf(src[i]);
+        }
+        return;
+    }
+    for (; i < n; i++) {
+        *(uint16_t *) (dst + i * dst_stride) = NDArray_FloatToHalf(src[i]);
+    }
+}
+
+static void
+bfloat16_to_float32(const char *src, long src_stride, float *dst, long n) {
+    long i = 0;
+    if (src_stride == sizeof(uint16_t)) {
+        const uint16_t *p = (const uint16_t *) src;
+#ifdef NDARRAY_HAVE_AVX2_CONVERT
+        for (; i + 8 <= n; i += 8) {
+            __m256i w = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i *) (p + i)));
+            _mm256_storeu_ps(dst + i, _mm256_castsi256_ps(_mm256_slli_epi32(w, 16)));
+        }
+#endif
+        for (; i < n; i++) {
+            dst[i] = NDArray_BFloat16ToFloat(p[i]);
+        }
+        return;
+    }
+    for (; i < n; i++) {
+        dst[i] = NDArray_BFloat16ToFloat(*(const uint16_t *) (src + i * src_stride));
+    }
+}
+
+static void
+bfloat16_from_float32(const float *src, char *dst, long dst_stride, long n) {
+    long i = 0;
+    if (dst_stride == sizeof(uint16_t)) {
+        uint16_t *p = (uint16_t *) dst;
+#ifdef NDARRAY_HAVE_AVX2_CONVERT
+        const __m256i bias = _mm256_set1_epi32(0x7FFF);
+        const __m256i one = _mm256_set1_epi32(1);
+        const __m256i quiet = _mm256_set1_epi32(0x40);
+        for (; i + 8 <= n; i += 8) {
+            __m256 v = _mm256_loadu_ps(src + i);
+            __m256i bits = _mm256_castps_si256(v);
+            __m256i high = _mm256_srli_epi32(bits, 16);
+            __m256i rounded = _mm256_add_epi32(bits, _mm256_add_epi32(bias, _mm256_and_si256(high, one)));
+            __m256i nan = _mm256_castps_si256(_mm256_cmp_ps(v, v, _CMP_UNORD_Q));
+            rounded = _mm256_blendv_epi8(_mm256_srli_epi32(rounded, 16), _mm256_or_si256(high, quiet), nan);
+            // Pack the eight 32-bit lanes into 16 bits, then undo the per-lane interleave
+            rounded = _mm256_permute4x64_epi64(_mm256_packus_epi32(rounded, rounded), 0xD8);
+            _mm_storeu_si128((__m128i *) (p + i), _mm256_castsi256_si128(rounded));
+        }
+#endif
+        for (; i < n; i++) {
+            p[i] = NDArray_FloatToBFloat16(src[i]);
+        }
+        return;
+    }
+    for (; i < n; i++) {
+        *(uint16_t *) (dst + i * dst_stride) = NDArray_FloatToBFloat16(src[i]);
+    }
+}
+
+/*
+ * Half precision types are storage only: every kernel converts
+ * NDARRAY_HALF_TILE elements at a time into float32 buffers, computes in
+ * float32 and converts the results back.
+ */
+#define NDARRAY_HALF_TILE_LEN(i, n) ((n) - (i) < NDARRAY_HALF_TILE ? (n) - (i) : NDARRAY_HALF_TILE)
+
+#define NDARRAY_HALF_BINARY_LOOP(tname, opname, op)                                     \
+static void                                                                             \
+tname##_##opname(const char *a, long a_stride, const char *b, long b_stride,           \
+                 char *out, long out_stride, long n) {                                  \
+    float ta[NDARRAY_HALF_TILE], tb[NDARRAY_HALF_TILE];                                 \
+    long i, j, len;                                                                     \
+    for (i = 0; i < n; i += len) {                                                      \
+        len = NDARRAY_HALF_TILE_LEN(i, n);                                              \
+        tname##_to_float32(a + i * a_stride, a_stride, ta, len);                        \
+        tname##_to_float32(b + i * b_stride, b_stride, tb, len);                        \
+        for (j = 0; j < len; j++) {                                                     \
+            ta[j] = ta[j] op tb[j];                                                     \
+        }                                                                               \
+        tname##_from_float32(ta, out + i * out_stride, out_stride, len);                \
+    }                                                                                   \
+}
+
+#define NDARRAY_HALF_COMPARE_LOOP(tname, opname, op)                                    \
+static void                                                                             \
+tname##_##opname(const char *a, long a_stride, const char *b, long b_stride,           \
+                 char *out, long out_stride, long n) {                                  \
+    float ta[NDARRAY_HALF_TILE], tb[NDARRAY_HALF_TILE];                                 \
+    long i, j, len;                                                                     \
+    for (i = 0; i < n; i += len) {                                                      \
+        len = NDARRAY_HALF_TILE_LEN(i, n);                                              \
+        tname##_to_float32(a + i * a_stride, a_stride, ta, len);                        \
+        tname##_to_float32(b + i * b_stride, b_stride, tb, len);                        \
+        for (j = 0; j < len; j++) {                                                     \
+            *(unsigned char *) (out + (i + j) * out_stride) = ta[j] op tb[j];           \
+        }                                                                               \
+    }                                                                                   \
+}
+
+#define NDARRAY_HALF_FOREACH_TILE(tname, data, n, t, i, len)                            \
+    for (i = 0; i < (n) && ((len = NDARRAY_HALF_TILE_LEN(i, n)),                        \
+         tname##_to_float32((data) + i * sizeof(uint16_t), sizeof(uint16_t), t, len), 1); \
+         i += len)
+
+#define NDARRAY_HALF_ARG_REDUCE(tname, fname, load, cmp)                                \
+static long                                                                             \
+tname##_##fname(const char *data, long n) {                                             \
+    float t[NDARRAY_HALF_TILE], mp = load(*(const uint16_t *) data);                    \
+    long i, j, len, index = 0;                                                          \
+    if (NDARRAY_ISNAN(mp)) {                                                            \
+        return 0;                                                                       \
+    }                                                                                   \
+    NDARRAY_HALF_FOREACH_TILE(tname, data, n, t, i, len) {                              \
+        for (j = 0; j < len; j++) {                                                     \
+            if (t[j] cmp mp || NDARRAY_ISNAN(t[j])) {                                   \
+                mp = t[j];                                                              \
+                index = i + j;                                                          \
+                if (NDARRAY_ISNAN(mp)) return index;                                    \
+            }                                                                           \
+        }                                                                               \
+    }                                                                                   \
+    return index;                                                                       \
+}
+
+#define NDARRAY_HALF_MINMAX(tname, fname, load, cmp)                                    \
+static double                                                                           \
+tname##_##fname(const char *data, long n) {                                             \
+    float t[NDARRAY_HALF_TILE], value = load(*(const uint16_t *) data);                 \
+    long i, j, len;                                                                     \
+    NDARRAY_HALF_FOREACH_TILE(tname, data, n, t, i, len) {                              \
+        for (j = 0; j < len; j++) {                                                     \
+            if (t[j] cmp value) value = t[j];                                           \
+        }                                                                               \
+    }                                                                                   \
+    return (double) value;                                                              \
+}
+
+#define NDARRAY_HALF_KERNELS(tname, load, store)                                        \
+static double                                                                           \
+tname##_getitem(const char *ptr) {                                                      \
+    return (double) load(*(const uint16_t *) ptr);                                      \
+}                                                                                       \
+static long                                                                             \
+tname##_getlong(const char *ptr) {                                                      \
+    return (long) load(*(const uint16_t *) ptr);                                        \
+}                                                                                       \
+static void                                                                             \
+tname##_setitem(char *ptr, double value) {                                              \
+    *(uint16_t *) ptr = store((float) value);                                           \
+}                                                                                       \
+NDARRAY_HALF_BINARY_LOOP(tname, add, +)                                                 \
+NDARRAY_HALF_BINARY_LOOP(tname, subtract, -)                                            \
+NDARRAY_HALF_BINARY_LOOP(tname, multiply, *)                                            \
+NDARRAY_HALF_BINARY_LOOP(tname, divide, /)                                              \
+NDARRAY_HALF_COMPARE_LOOP(tname, greater, >)                                            \
+NDARRAY_HALF_COMPARE_LOOP(tname, greater_equal, >=)                                     \
+NDARRAY_HALF_COMPARE_LOOP(tname, less, <)                                               \
+NDARRAY_HALF_COMPARE_LOOP(tname, less_equal, <=)                                        \
+NDARRAY_HALF_COMPARE_LOOP(tname, equal, ==)                                             \
+NDARRAY_HALF_COMPARE_LOOP(tname, not_equal, !=)                                         \
+static double                                                                           \
+tname##_sum(const char *data, long n) {                                                 \
+    float t[NDARRAY_HALF_TILE], acc;                                                    \
+    double value = 0;                                                                   \
+    long i, j, len;                                                                     \
+    NDARRAY_HALF_FOREACH_TILE(tname, data, n, t, i, len) {                              \
+        for (acc = 0, j = 0; j < len; j++) {                                            \
+            acc += t[j];                                                                \
+        }                                                                               \
+        value += acc;                                                                   \
+    }                                                                                   \
+    return value;                                                                       \
+}                                                                                       \
+static double                                                                           \
+tname##_prod(const char *data, long n) {                                                \
+    float t[NDARRAY_HALF_TILE];                                                         \
+    double value = 1;                                                                   \
+    long i, j, len;                                                                     \
+    NDARRAY_HALF_FOREACH_TILE(tname, data, n, t, i, len) {                              \
+        for (j = 0; j < len; j++) {                                                     \
+            value *= t[j];                                                              \
+        }                                                                               \
+    }                                                                                   \
+    return value;                                                                       \
+}                                                                                       \
+NDARRAY_HALF_MINMAX(tname, min, load, <)                                                \
+NDARRAY_HALF_MINMAX(tname, max, load, >)                                                \
+NDARRAY_HALF_ARG_REDUCE(tname, argmax, load, >)                                         \
+NDARRAY_HALF_ARG_REDUCE(tname, argmin, load, <)                                         \
+static long                                                                             \
+tname##_count_nonzero(const char *data, long n) {                                       \
+    const uint16_t *p = (const uint16_t *) data;                                        \
+    long i, count = 0;                                                                  \
+    for (i = 0; i < n; i++) {                                                           \
+        count += (p[i] & 0x7FFF) != 0;                                                  \
+    }                                                                                   \
+    return count;                                                                       \
+}
+
+NDARRAY_HALF_KERNELS(float16, NDArray_HalfToFloat, NDArray_FloatToHalf)
+NDARRAY_HALF_KERNELS(bfloat16, NDArray_BFloat16ToFloat, NDArray_FloatToBFloat16)
+
+static const NDArrayTypeFuncs ndarray_type_funcs[] = {
+    NDARRAY_TYPE_FUNCS_ENTRY(float32, "float32", float, NDARRAY_KIND_FLOAT,
+                             float32_add, float32_subtract, float32_multiply, float32_divide),
+    NDARRAY_TYPE_FUNCS_ENTRY(float64, "float64", double, NDARRAY_KIND_FLOAT,
+                             float64_add, float64_subtract, float64_multiply, float64_divide),
+    NDARRAY_TYPE_FUNCS_ENTRY(int32, "int32", int32_t, NDARRAY_KIND_INT,
+                             int32_add, int32_subtract, int32_multiply, NULL),
+    NDARRAY_TYPE_FUNCS_ENTRY(int64, "int64", int64_t, NDARRAY_KIND_INT,
+                             int64_add, int64_subtract, int64_multiply, NULL),
+    NDARRAY_TYPE_FUNCS_ENTRY(uint8, "uint8", uint8_t, NDARRAY_KIND_UINT,
+                             uint8_add, uint8_subtract, uint8_multiply, NULL),
+    NDARRAY_TYPE_FUNCS_ENTRY(int8, "int8", int8_t, NDARRAY_KIND_INT,
+                             int8_add, int8_subtract, int8_multiply, NULL),
+    NDARRAY_TYPE_FUNCS_ENTRY(bool, "bool", uint8_t, NDARRAY_KIND_BOOL, NULL, NULL, NULL, NULL),
+    NDARRAY_TYPE_FUNCS_ENTRY(float16, "float16", uint16_t, NDARRAY_KIND_FLOAT,
+                             float16_add, float16_subtract, float16_multiply, float16_divide),
+    NDARRAY_TYPE_FUNCS_ENTRY(bfloat16, "bfloat16", uint16_t, NDARRAY_KIND_FLOAT,
+                             bfloat16_add, bfloat16_subtract, bfloat16_multiply, bfloat16_divide),
+};
+
+/**
+ * Resolve a user supplied dtype name to the internal type string
+ *
+ * @param name
+ * @return NULL if the name is not a known dtype
+ */
+const char*
+NDArray_ParseType(const char *name) {
+    if (!strcmp(name, "float32") || !strcmp(name, "float")) {
+        return NDARRAY_TYPE_FLOAT32;
+    }
+    if (!strcmp(name, "float64") || !strcmp(name, "double") || !strcmp(name, "double64")) {
+        return NDARRAY_TYPE_DOUBLE64;
+    }
+    if (!strcmp(name, "int32")) {
+        return NDARRAY_TYPE_INT32;
+    }
+    if (!strcmp(name, "int64") || !strcmp(name, "int")) {
+        return NDARRAY_TYPE_INT64;
+    }
+    if (!strcmp(name, "uint8")) {
+        return NDARRAY_TYPE_UINT8;
+    }
+    if (!strcmp(name, "int8")) {
+        return NDARRAY_TYPE_INT8;
+    }
+    if (!strcmp(name, "bool") || !strcmp(name, "boolean")) {
+        return NDARRAY_TYPE_BOOL;
+    }
+    if (!strcmp(name, "float16") || !strcmp(name, "half")) {
+        return NDARRAY_TYPE_FLOAT16;
+    }
+    if (!strcmp(name, "bfloat16")) {
+        return NDARRAY_TYPE_BFLOAT16;
+    }
+    return NULL;
+}
+
+/**
+ * Kernel table for a type
+ *
+ * @param type
+ * @return NULL if the type has no kernels registered
+ */
+const NDArrayTypeFuncs*
+NDArray_TypeFuncs(const char *type) {
+    size_t i;
+    for (i = 0; i < sizeof(ndarray_type_funcs) / sizeof(ndarray_type_funcs[0]); i++) {
+        if (!strcmp(ndarray_type_funcs[i].name, type)) {
+            return &ndarray_type_funcs[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Position of a type in the promotion order
+ * bool < int8/uint8 < int32 < int64 < float16/bfloat16 < float32 < float64
+ */
+static int
+type_rank(const char *type) {
+    static const char *order[] = {"bool", "uint8", "int32", "int64", "float16", "float32", "float64"};
+    int i;
+    if (!strcmp(type, "int8")) {
+        return 1;
+    }
+    if (!strcmp(type, "bfloat16")) {
+        return 4;
+    }
+    for (i = 0; i < 7; i++) {
+        if (!strcmp(order[i], type)) {
+            return i;
+        }
+    }
+    return 5;
+}
+
+/**
+ * Result type of a binary operation between two types
+ *
+ * float32 only holds integers exactly up to 2^24, so int32 and int64
+ * combined with float32 or a half precision type promote to float64.
+ * Types of the same rank but different range (int8 and uint8, float16
+ * and bfloat16) meet at the next type that holds both.
+ *
+ * @param type_a
+ * @param type_b
+ * @return
+ */
+const char*
+NDArray_PromoteTypes(const char *type_a, const char *type_b) {
+    int rank_a = type_rank(type_a), rank_b = type_rank(type_b);
+    int hi = rank_a > rank_b ? rank_a : rank_b;
+    int lo = rank_a > rank_b ? rank_b : rank_a;
+    if ((hi == 4 || hi == 5) && (lo == 2 || lo == 3)) {
+        return NDARRAY_TYPE_DOUBLE64;
+    }
+    switch (hi) {
+        case 0:
+            return NDARRAY_TYPE_BOOL;
+        case 1:
+            if (lo == 1 && strcmp(type_a, type_b)) {
+                return NDARRAY_TYPE_INT32;
+            }
+            return rank_a == 1 ? type_a : type_b;
+        case 2:
+            return NDARRAY_TYPE_INT32;
+        case 3:
+            return NDARRAY_TYPE_INT64;
+        case 4:
+            if (lo == 4 && strcmp(type_a, type_b)) {
+                return NDARRAY_TYPE_FLOAT32;
+            }
+            return rank_a == 4 ? type_a : type_b;
+        case 6:
+            return NDARRAY_TYPE_DOUBLE64;
+        default:
+            return NDARRAY_TYPE_FLOAT32;
+    }
+}
@@ -1,10 +1,71 @@
 #ifndef PHPSCI_NDARRAY_TYPES_H
 #define PHPSCI_NDARRAY_TYPES_H
 
-static const char* NDARRAY_TYPE_DOUBLE64 = "double64";
+#include <stdint.h>
+
+static const char* NDARRAY_TYPE_DOUBLE64 = "float64";
 static const char* NDARRAY_TYPE_FLOAT32 = "float32";
+static const char* NDARRAY_TYPE_INT32 = "int32";
+static const char* NDARRAY_TYPE_INT64 = "int64";
+static const char* NDARRAY_TYPE_INT8 = "int8";
+static const char* NDARRAY_TYPE_UINT8 = "uint8";
+static const char* NDARRAY_TYPE_BOOL = "bool";
+static const char* NDARRAY_TYPE_FLOAT16 = "float16";
+static const char* NDARRAY_TYPE_BFLOAT16 = "bfloat16";
+
+#define NDARRAY_KIND_BOOL  'b'
+#define NDARRAY_KIND_UINT  'u'
+#define NDARRAY_KIND_INT   'i'
+#define NDARRAY_KIND_FLOAT 'f'
+
+/**
+ * Strided inner loop of a binary element-wise kernel. Strides are in bytes.
+ */
+typedef void (*NDArray_BinaryLoop)(const char *a, long a_stride, const char *b, long b_stride,
+                                   char *out, long out_stride, long n);
+
+/**
+ * Per-dtype kernel table. Every dtype registers one of these so generic
+ * code can dispatch on the descriptor type instead of branching on it.
+ */
+typedef struct NDArrayTypeFuncs {
+    const char *name;
+    int elsize;
+    char kind;
+    double (*getitem)(const char *ptr);
+    void (*setitem)(char *ptr, double value);
+    long (*getlong)(const char *ptr);
+    NDArray_BinaryLoop add;
+    NDArray_BinaryLoop subtract;
+    NDArray_BinaryLoop multiply;
+    NDArray_BinaryLoop divide;
+    /* Comparison loops write one bool byte per element */
+    NDArray_BinaryLoop greater;
+    NDArray_BinaryLoop greater_equal;
+    NDArray_BinaryLoop less;
+    NDArray_BinaryLoop less_equal;
+    NDArray_BinaryLoop equal;
+    NDArray_BinaryLoop not_equal;
+    double (*sum)(const char *data, long n);
+    double (*prod)(const char *data, long n);
+    double (*min)(const char *data, long n);
+    double (*max)(const char *data, long n);
+    long (*argmax)(const char *data, long n);
+    long (*argmin)(const char *data, long n);
+    long (*count_nonzero)(const char *data, long n);
+    /* Strided bulk conversion from and to float32 compute buffers */
+    void (*to_float32)(const char *src, long src_stride, float *dst, long n);
+    void (*from_float32)(const float *src, char *dst, long dst_stride, long n);
+} NDArrayTypeFuncs;
 
 int get_type_size(const char *type);
 int is_type(const char *type_a, const char *type_b);
+const char* NDArray_ParseType(const char *name);
+const NDArrayTypeFuncs* NDArray_TypeFuncs(const char *type);
+const char* NDArray_PromoteTypes(const char *type_a, const char *type_b);
+float NDArray_HalfToFloat(uint16_t h);
+uint16_t NDArray_FloatToHalf(float f);
+float NDArray_BFloat16ToFloat(uint16_t h);
+uint16_t NDArray_FloatToBFloat16(float f);
 
 #endif //PHPSCI_NDARRAY_TYPES_H
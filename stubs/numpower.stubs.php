@@ -41,9 +41,10 @@ final class NumPower {
      *
      * @param NumPower|array|float|int $a The array to be added
      * @param NumPower|array|float|int $b The array to be added
+     * @param NumPower|null $out Contiguous array with the result dtype and shape to write into, may be $a or $b
      * @return NumPower|float|int The sum of $a and $b
      */
-    public static function add(NumPower|array|float|int $a, NumPower|array|float|int $b): NumPower|float|int {}
+    public static function add(NumPower|array|float|int $a, NumPower|array|float|int $b, ?NumPower $out = null): NumPower|float|int {}
 
     /**
      * Return the division between two arrays element-wise
@@ -52,9 +53,10 @@ final class NumPower {
      *
      * @param NumPower|array|float|int $a Dividend
      * @param NumPower|array|float|int $b Divisor
+     * @param NumPower|null $out Contiguous array with the result dtype and shape to write into, may be $a or $b
      * @return NumPower|float|int Array with the division between $a and $b element-wise
      */
-    public static function divide(NumPower|array|float|int $a, NumPower|array|float|int $b): NumPower|float|int {}
+    public static function divide(NumPower|array|float|int $a, NumPower|array|float|int $b, ?NumPower $out = null): NumPower|float|int {}
 
 
     /**
@@ -69,6 +71,21 @@ final class NumPower {
      */
     public static function mod(NumPower|array|float|int $a, NumPower|array|float|int $b): NumPower|float|int {}
 
+    /**
+     * Start a lazy element-wise expression.
+     *
+     * +, -, *, / and ** on the returned expression record the operation instead
+     * of computing it. `eval()` then runs the whole expression as a single fused
+     * loop, reading each input and writing the output once. Integer and bool
+     * results are computed as float64.
+     *
+     * Ex: $y = ((NumPower::lazy($x) - $mean) / $std * $gamma + $beta)->eval();
+     *
+     * @param NumPower|array|float|int $a
+     * @return NDArrayExpression
+     */
+    public static function lazy(NumPower|array|float|int $a): NDArrayExpression {}
+
     /**
      * Multiply arrays element-wise
      *
@@ -76,9 +93,10 @@ final class NumPower {
      *
      * @param NumPower|array|float|int $a The arrays to be multiplied.
      * @param NumPower|array|float|int $b The arrays to be multiplied.
+     * @param NumPower|null $out Contiguous array with the result dtype and shape to write into, may be $a or $b
      * @return NumPower|float|int The multiplication of $a and $b element-wise
      */
-    public static function multiply(NumPower|array|float|int $a, NumPower|array|float|int $b): NumPower|float|int {}
+    public static function multiply(NumPower|array|float|int $a, NumPower|array|float|int $b, ?NumPower $out = null): NumPower|float|int {}
 
     /**
      * Computes the element-wise negation (unary minus) of an array, returning a new array with the negation of each element.
@@ -86,17 +104,19 @@ final class NumPower {
      * Same as -$a
      *
      * @param NumPower|array|float|int $a Input array
+     * @param NumPower|null $out float32 array the result is written into, returned instead of a new array
      * @return NumPower|float|int The multiplication of $a * -1
      */
-    public static function negative(NumPower|array|float|int $a): NumPower|float|int {}
+    public static function negative(NumPower|array|float|int $a, ?NumPower $out = null): NumPower|float|int {}
 
     /**
      * Numerical positive, element-wise.
      *
      * @param NumPower|array|float|int $a Input array
+     * @param NumPower|null $out float32 array the result is written into, returned instead of a new array
      * @return NumPower|float|int
      */
-    public static function positive(NumPower|array|float|int $a): NumPower|float|int {}
+    public static function positive(NumPower|array|float|int $a, ?NumPower $out = null): NumPower|float|int {}
 
     /**
      * Return the reciprocal of the argument, element-wise.
@@ -104,18 +124,20 @@ final class NumPower {
      * Calculates `1 / $a`
      *
      * @param NumPower|array|float|int $a Input array
+     * @param NumPower|null $out float32 array the result is written into, returned instead of a new array
      * @return NumPower|float|int
      */
-    public static function reciprocal(NumPower|array|float|int $a): NumPower|float|int {}
+    public static function reciprocal(NumPower|array|float|int $a, ?NumPower $out = null): NumPower|float|int {}
 
     /**
      * Subtract two arrays element-wise
      *
      * @param NumPower|array|float|int $a Input array
      * @param NumPower|array|float|int $b Input array
+     * @param NumPower|null $out Contiguous array with the result dtype and shape to write into, may be $a or $b
      * @return NumPower|float|int $a - $b
      */
-    public static function subtract(NumPower|array|float|int $a, NumPower|array|float|int $b): NumPower|float|int {}
+    public static function subtract(NumPower|array|float|int $a, NumPower|array|float|int $b, ?NumPower $out = null): NumPower|float|int {}
 
     /**
      * Raises each element of an array $a to a specified power $b and returns a new array containing the result.
@@ -133,72 +155,80 @@ final class NumPower {
      * a new array with each element raised to the power of $array.
      *
      * @param NumPower|array|float|int $array Input array
+     * @param NumPower|null $out float32 array the result is written into, returned instead of a new array
      * @return NumPower|float|int
      */
-    public static function exp(NumPower|array|float|int $array): NumPower|float|int {}
+    public static function exp(NumPower|array|float|int $array, ?NumPower $out = null): NumPower|float|int {}
 
     /**
      * Computes the element-wise 2 raised to the power of an array,
      * returning a new array with each element raised to the power of 2.
      *
      * @param NumPower|array|float|int $array Input array
+     * @param NumPower|null $out float32 array the result is written into, returned instead of a new array
      * @return NumPower|float|int
      */
-    public static function exp2(NumPower|array|float|int $array): NumPower|float|int {}
+    public static function exp2(NumPower|array|float|int $array, ?NumPower $out = null): NumPower|float|int {}
 
     /**
      * Calculates the element-wise exponential minus one function, returning
      * a new array with each element raised to the power of `$array` - 1.
      *
      * @param NumPower|array|float|int $array Input array
+     * @param NumPower|null $out float32 array the result is written into, returned instead of a new array
      * @return NumPower|float|int
      */
-    public static function expm1(NumPower|array|float|int $array): NumPower|float|int {}
+    public static function expm1(NumPower|array|float|int $array, ?NumPower $out = null): NumPower|float|int {}
 
     /**
      * Calculates the element-wise natural logarithm of an array, returning
      * a new array with the natural logarithm of each element.
      *
      * @param NumPower|array|float|int $array Input array
+     * @param NumPower|null $out float32 array the result is written into, returned instead of a new array
      * @return NumPower|float|int
      */
-    public static function log(NumPower|array|float|int $array): NumPower|float|int {}
+    public static function log(NumPower|array|float|int $array, ?NumPower $out = null): NumPower|float|int {}
 
     /**
      * Computes the element-wise logarithm of one plus an array, returning a new array with
      * the natural logarithm of each element plus one.
      *
      * @param NumPower|array|float|int $array Input array
+     * @param NumPower|null $out float32 array the result is written into, returned instead of a new array
      * @return NumPower|float|int
      */
-    public static function log1p(NumPower|array|float|int $array): NumPower|float|int {}
+    public static function log1p(NumPower|array|float|int $array, ?NumPower $out = null): NumPower|float|int {}
 
     /**
      * Computes the element-wise base-2 logarithm of an array,
      * returning a new array with the base-2 logarithm of each element
      *
      * @param NumPower|array|float|int $array Input array
+     * @param NumPower|null $out float32 array the result is written into, returned instead of a new array
      * @return NumPower|float|int
      */
-    public static function log2(NumPower|array|float|int $array): NumPower|float|int {}
+    public static function log2(NumPower|array|float|int $array, ?NumPower $out = null): NumPower|float|int {}
 
     /**
      * Calculates the element-wise base-10 logarithm of an array,
      * returning a new array with the base-10 logarithm of each element.
      *
      * @param NumPower|array|float|int $array Input array
+     * @param NumPower|null $out float32 array the result is written into, returned instead of a new array
      * @return NumPower|float|int
      */
-    public static function log10(NumPower|array|float|int $array): NumPower|float|int {}
+    public static function log10(NumPower|array|float|int $array, ?NumPower $out = null): NumPower|float|int {}
 
     /**
      * Computes the element-wise logarithm base b of an array, returning
      * a new array with the logarithm base b of each element.
      *
      * @param NumPower|array|float|int $array Input array
+     * @param NumPower|null $out float32 array the result is written into, returned instead of a new array
      * @return NumPower|float|int
      */
-    public static function logb(NumPower|array|float|int $array): NumPower|float|int {}
+    public static function logb(NumPower|array|float|int $array, ?NumPower $out = null): NumPower|float|int {}
 
     /**
      * Finds the maximum value in the array.
@@ -221,54 +251,60 @@ final class NumPower {
      * returning a new array with the inverse hyperbolic cosine of each element.
      *
      * @param NumPower|array|float|int $array Input array
+     * @param NumPower|null $out float32 array the result is written into, returned instead of a new array
      * @return NumPower|float|int
      */
-    public static function arccosh(NumPower|array|float|int $array): NumPower|float|int {}
+    public static function arccosh(NumPower|array|float|int $array, ?NumPower $out = null): NumPower|float|int {}
 
     /**
      * Computes the element-wise inverse hyperbolic sine (arcsineh) of an array, returning a new
      * array with the inverse hyperbolic sine of each element.
      *
      * @param NumPower|array|float|int $array Input array
+     * @param NumPower|null $out float32 array the result is written into, returned instead of a new array
      * @return NumPower|float|int
      */
-    public static function arcsinh(NumPower|array|float|int $array): NumPower|float|int {}
+    public static function arcsinh(NumPower|array|float|int $array, ?NumPower $out = null): NumPower|float|int {}
 
     /**
      * Computes the element-wise inverse hyperbolic tangent (arctangenth) of an array,
      * returning a new array with the inverse hyperbolic tangent of each element.
      *
      * @param NumPower|array|float|int $array Input array
+     * @param NumPower|null $out float32 array the result is written into, returned instead of a new array
      * @return NumPower|float|int
      */
-    public static function arctanh(NumPower|array|float|int $array): NumPower|float|int {}
+    public static function arctanh(NumPower|array|float|int $array, ?NumPower $out = null): NumPower|float|int {}
 
     /**
      * Computes the element-wise hyperbolic cosine of an array,
      * returning a new array with the hyperbolic cosine of each element.
      *
      * @param NumPower|array|float|int $array Input array
+     * @param NumPower|null $out float32 array the result is written into, returned instead of a new array
      * @return NumPower|float|int
      */
-    public static function cosh(NumPower|array|float|int $array): NumPower|float|int {}
+    public static function cosh(NumPower|array|float|int $array, ?NumPower $out = null): NumPower|float|int {}
 
     /**
      * Calculates the element-wise inverse hyperbolic cosine (arccosineh) of an array,
      * returning a new array with the inverse hyperbolic cosine of each element.
      *
      * @param NumPower|array|float|int $array Input array
+     * @param NumPower|null $out float32 array the result is written into, returned instead of a new array
      * @return NumPower|float|int
      */
-    public static function sinh(NumPower|array|float|int $array): NumPower|float|int {}
+    public static function sinh(NumPower|array|float|int $array, ?NumPower $out = null): NumPower|float|int {}
 
     /**
      * Calculates the element-wise hyperbolic tangent of an array,
      * returning a new array with the hyperbolic tangent of each element.
      *
      * @param NumPower|array|float|int $array Input array
+     * @param NumPower|null $out float32 array the result is written into, returned instead of a new array
      * @return NumPower|float|int
      */
-    public static function tanh(NumPower|array|float|int $array): NumPower|float|int {}
+    public static function tanh(NumPower|array|float|int $array, ?NumPower $out = null): NumPower|float|int {}
 
     /**
      * Computes the element-wise absolute value of an array, returning a new array with non-negative elements.
@@ -294,27 +330,30 @@ final class NumPower {
      * with the sign of each element (1 for positive, -1 for negative, 0 for zero).
      *
      * @param NumPower|array|float|int $array Input array
+     * @param NumPower|null $out float32 array the result is written into, returned instead of a new array
      * @return NumPower|float|int
      */
-    public static function sign(NumPower|array|float|int $array): NumPower|float|int {}
+    public static function sign(NumPower|array|float|int $array, ?NumPower $out = null): NumPower|float|int {}
 
     /**
      * Calculates the element-wise sinc function of an array,
      * returning a new array with the sinc function evaluated for each element.
      *
      * @param NumPower|array|float|int $array Input array
+     * @param NumPower|null $out float32 array the result is written into, returned instead of a new array
      * @return NumPower|float|int
      */
-    public static function sinc(NumPower|array|float|int $array): NumPower|float|int {}
+    public static function sinc(NumPower|array|float|int $array, ?NumPower $out = null): NumPower|float|int {}
 
     /**
      * Calculates the element-wise square root of an array, returning a new array
      * with the positive square root of each element.
      *
      * @param NumPower|array|float|int $array Input array
+     * @param NumPower|null $out float32 array the result is written into, returned instead of a new array
      * @return NumPower|float|int
      */
-    public static function sqrt(NumPower|array|float|int $array): NumPower|float|int {}
+    public static function sqrt(NumPower|array|float|int $array, ?NumPower $out = null): NumPower|float|int {}
 
     /**
      * Computes the element-wise square of an array, returning a new array with each element squared.
@@ -329,35 +368,39 @@ final class NumPower {
      * returning a new array with the elements rounded upwards.
      *
      * @param NumPower|array|float|int $array Input array
+     * @param NumPower|null $out float32 array the result is written into, returned instead of a new array
      * @return NumPower|float|int
      */
-    public static function ceil(NumPower|array|float|int $array): NumPower|float|int {}
+    public static function ceil(NumPower|array|float|int $array, ?NumPower $out = null): NumPower|float|int {}
 
     /**
      * Rounds the elements of an array towards zero, returning a new array with the elements rounded towards zero.
      *
      * @param NumPower|array|float|int $array Input array
+     * @param NumPower|null $out float32 array the result is written into, returned instead of a new array
      * @return NumPower|float|int
      */
-    public static function fix(NumPower|array|float|int $array): NumPower|float|int {}
+    public static function fix(NumPower|array|float|int $array, ?NumPower $out = null): NumPower|float|int {}
 
     /**
      * Rounds the elements of an array to the nearest integer less than or equal to the element,
      * returning a new array with the elements rounded downwards.
      *
      * @param NumPower|array|float|int $array Input array
+     * @param NumPower|null $out float32 array the result is written into, returned instead of a new array
      * @return NumPower|float|int
      */
-    public static function floor(NumPower|array|float|int $array): NumPower|float|int {}
+    public static function floor(NumPower|array|float|int $array, ?NumPower $out = null): NumPower|float|int {}
 
     /**
      * Rounds the elements of an array to the nearest integer,
      * returning a new array with the elements rounded to the nearest integer.
      *
      * @param NumPower|array|float|int $array Input array
+     * @param NumPower|null $out float32 array the result is written into, returned instead of a new array
      * @return NumPower|float|int
      */
-    public static function rint(NumPower|array|float|int $array): NumPower|float|int {}
+    public static function rint(NumPower|array|float|int $array, ?NumPower $out = null): NumPower|float|int {}
 
     /**
      * Rounds the elements of an array to the nearest integer,
@@ -373,9 +416,10 @@ final class NumPower {
      * new array with the elements truncated towards zero.
      *
      * @param NumPower|array|float|int $array Input array
+     * @param NumPower|null $out float32 array the result is written into, returned instead of a new array
      * @return NumPower|float|int
      */
-    public static function trunc(NumPower|array|float|int $array): NumPower|float|int {}
+    public static function trunc(NumPower|array|float|int $array, ?NumPower $out = null): NumPower|float|int {}
 
     /**
      * Calculates the product of all elements in the array over a given axis
@@ -408,63 +452,70 @@ final class NumPower {
      * returning a new array with the arccosine of each element.
      *
      * @param NumPower|array|float|int $array Input array
+     * @param NumPower|null $out float32 array the result is written into, returned instead of a new array
      * @return NumPower|float|int
      */
-    public static function arccos(NumPower|array|float|int $array): NumPower|float|int {}
+    public static function arccos(NumPower|array|float|int $array, ?NumPower $out = null): NumPower|float|int {}
 
     /**
      * Computes the element-wise inverse sine (arcsine) of an array,
      * returning a new array with the arcsine of each element.
      *
      * @param NumPower|array|float|int $array Input array
+     * @param NumPower|null $out float32 array the result is written into, returned instead of a new array
      * @return NumPower|float|int
      */
-    public static function arcsin(NumPower|array|float|int $array): NumPower|float|int {}
+    public static function arcsin(NumPower|array|float|int $array, ?NumPower $out = null): NumPower|float|int {}
 
     /**
      * Computes the element-wise inverse tangent (arctangent) of an array,
      * returning a new array with the arctangent of each element.
      *
      * @param NumPower|array|float|int $array Input array
+     * @param NumPower|null $out float32 array the result is written into, returned instead of a new array
      * @return NumPower|float|int
      */
-    public static function arctan(NumPower|array|float|int $array): NumPower|float|int {}
+    public static function arctan(NumPower|array|float|int $array, ?NumPower $out = null): NumPower|float|int {}
 
     /**
      * Computes the element-wise cosine of an array, returning
      * a new array with the cosine of each element.
      *
      * @param NumPower|array|float|int $array Input array
+     * @param NumPower|null $out float32 array the result is written into, returned instead of a new array
      * @return NumPower|float|int
      */
-    public static function cos(NumPower|array|float|int $array): NumPower|float|int {}
+    public static function cos(NumPower|array|float|int $array, ?NumPower $out = null): NumPower|float|int {}
 
     /**
      * Converts the element-wise angle from radians to degrees,
      * returning a new array with the angles converted to degrees.
      *
      * @param NumPower|array|float|int $array Input array
+     * @param NumPower|null $out float32 array the result is written into, returned instead of a new array
      * @return NumPower|float|int
      */
-    public static function degrees(NumPower|array|float|int $array): NumPower|float|int {}
+    public static function degrees(NumPower|array|float|int $array, ?NumPower $out = null): NumPower|float|int {}
 
     /**
      * Converts the element-wise angle from degrees to radians,
      * returning a new array with the angles converted to radians.
      *
      * @param NumPower|array|float|int $array Input array
+     * @param NumPower|null $out float32 array the result is written into, returned instead of a new array
      * @return NumPower|float|int
      */
-    public static function radians(NumPower|array|float|int $array): NumPower|float|int {}
+    public static function radians(NumPower|array|float|int $array, ?NumPower $out = null): NumPower|float|int {}
 
     /**
      * Calculates the element-wise sine of an array,
      * returning a new array with the sine of each element.
      *
      * @param NumPower|array|float|int $array Input array
+     * @param NumPower|null $out float32 array the result is written into, returned instead of a new array
      * @return NumPower|float|int
      */
-    public static function sin(NumPower|array|float|int $array): NumPower|float|int {}
+    public static function sin(NumPower|array|float|int $array, ?NumPower $out = null): NumPower|float|int {}
 
     /**
      * Generates an array of random numbers from a normal distribution. The normal distribution, also
@@ -591,6 +642,46 @@ final class NumPower {
      */
     public static function quantile(NumPower|array|float|int $a, float|int $q): float|int {}
 
+    /**
+     * Returns a sorted copy of the array. NaN values sort last.
+     *
+     * @param NumPower|array $a
+     * @param int|null $axis Axis to sort along, null sorts the flattened array
+     * @return NumPower
+     */
+    public static function sort(NumPower|array $a, ?int $axis = -1): NumPower {}
+
+    /**
+     * Returns the int64 indices that would stably sort the array.
+     *
+     * @param NumPower|array $a
+     * @param int|null $axis Axis to sort along, null sorts the flattened array
+     * @return NumPower
+     */
+    public static function argsort(NumPower|array $a, ?int $axis = -1): NumPower {}
+
+    /**
+     * Returns a copy where the element at `kth` is in its sorted position,
+     * smaller elements are before it and larger ones after it.
+     *
+     * @param NumPower|array $a
+     * @param int $kth
+     * @param int|null $axis Axis to partition along, null uses the flattened array
+     * @return NumPower
+     */
+    public static function partition(NumPower|array $a, int $kth, ?int $axis = -1): NumPower {}
+
+    /**
+     * Returns the `k` largest values along an axis in descending order,
+     * together with their int64 indices.
+     *
+     * @param NumPower|array $a
+     * @param int $k
+     * @param int|null $axis Axis to search along, null uses the flattened array
+     * @return NumPower[] [values, indices]
+     */
+    public static function topk(NumPower|array $a, int $k, ?int $axis = -1): array {}
+
     /**
      * Calculates the standard deviation of the elements in the array. It is the
      * square root of the variance and provides a measure of the amount of variation
@@ -698,6 +789,26 @@ final class NumPower {
      */
     public function toArray(): array {}
 
+    /**
+     * Name of the element type of the array, e.g. `float32`, `float64`, `int32`,
+     * `int64`, `uint8`, `bool`, `float16` or `bfloat16`.
+     *
+     * @return string
+     */
+    public function dtype(): string {}
+
+    /**
+     * Return a contiguous copy of the array converted to `$dtype`.
+     *
+     * Arithmetic between arrays of different dtypes promotes to the wider type.
+     * Integer division promotes to `float64`, comparisons return `bool` arrays.
+     * `float16` and `bfloat16` are storage types, they are computed in float32.
+     *
+     * @param string $dtype `float32`, `float64`, `int8`, `int32`, `int64`, `uint8`, `bool`, `float16` or `bfloat16`
+     * @return NumPower
+     */
+    public function astype(string $dtype): NumPower {}
+
     /**
      * Return the transpose of matrix `$a`
      *
@@ -794,9 +905,10 @@ final class NumPower {
      * It is the equivalent of `new NumPower($array);`
      *
      * @param array|float|int $array
+     * @param string $dtype `float32` (default), `float64`, `int8`, `int32`, `int64`, `uint8`, `bool`, `float16` or `bfloat16`
      * @return NumPower
      */
-    public static function array(array|float|int $array): NumPower {}
+    public static function array(array|float|int $array, string $dtype = "float32"): NumPower {}
 
     /**
      * This function returns a square array, where the main diagonal consists of ones and all other
@@ -812,17 +924,19 @@ final class NumPower {
      * The function creates a new NumPower with the specified shape, filled with ones.
      *
      * @param int[] $shape
+     * @param string $dtype `float32` (default), `float64`, `int8`, `int32`, `int64`, `uint8`, `bool`, `float16` or `bfloat16`
      * @return NumPower
      */
-    public static function ones(array $shape): NumPower {}
+    public static function ones(array $shape, string $dtype = "float32"): NumPower {}
 
     /**
      * The function creates a new NumPower with the specified shape, filled with zeros.
      *
      * @param int[] $shape
+     * @param string $dtype `float32` (default), `float64`, `int8`, `int32`, `int64`, `uint8`, `bool`, `float16` or `bfloat16`
      * @return NumPower
      */
-    public static function zeros(array $shape): NumPower {}
+    public static function zeros(array $shape, string $dtype = "float32"): NumPower {}
 
     /**
      * Dumps the internal information of the NumPower.
@@ -844,6 +958,14 @@ final class NumPower {
      */
     public static function all(NumPower|array|float|int $a): bool {}
 
+    /**
+     * Number of non-zero elements of `$a`
+     *
+     * @param NumPower|array|float|int $a
+     * @return int
+     */
+    public static function countNonzero(NumPower|array|float|int $a): int {}
+
     /**
      * Checks if all elements in two arrays are approximately equal within a specified tolerance element-wise.
      *
@@ -932,14 +1054,24 @@ final class NumPower {
      * Calculates the Singular Value Decomposition (SVD) of an array, which decomposes the array
      * into three separate arrays: U, Sigma, and V^T.
      *
+     * With `$k`, only the `$k` largest singular triplets are computed by a randomized
+     * range finder, which is much cheaper than a full SVD for tall or wide matrices.
+     *
      * @param NumPower|array $a
-     * @return array PHP array containing the Unitary Arrays (U) `[0]`, the vector(s) with the singular values (S) `[1]` and the unitary arrays (Vh) `[2]`
+     * @param bool $compute_uv If false, only the singular values are computed and returned
+     * @param int|null $k Number of singular triplets of the truncated SVD
+     * @param int $oversamples Extra directions sampled by the truncated SVD
+     * @param int $power_iterations Power iterations of the truncated SVD
+     * @return array|NumPower PHP array containing the Unitary Arrays (U) `[0]`, the vector(s) with the singular values (S) `[1]` and the unitary arrays (Vh) `[2]`, or S alone when `$compute_uv` is false
      */
-    public static function svd(NumPower|array $a): array {}
+    public static function svd(NumPower|array $a, bool $compute_uv = true, ?int $k = null, int $oversamples = 10, int $power_iterations = 2): array|NumPower {}
 
     /**
      * Solves a linear system of equations for `x`, where `Ax = b`, and `A` and `b` are given arrays.
      *
+     * `$a` may be a stack of square matrices `(..., n, n)`. `$b` is then a vector `(n)` or a
+     * matrix `(n, k)` shared by every system, or a stack `(..., n, k)` of the same batch shape.
+     *
      * @param NumPower|array $a
      * @param NumPower|array $b
      * @return NumPower
@@ -966,19 +1098,31 @@ final class NumPower {
     public static function outer(NumPower|array $a, NumPower|array $b): NumPower {}
 
     /**
-     * Calculates different norms (e.g., L1 norm, L2 norm) of an array,
-     * providing various measures of its magnitude.
+     * Calculates different norms of an array, providing various measures
+     * of its magnitude.
      *
      * #### $order options
      *
-     * - **1** - L1-Norm
-     * - **2** - L2-Norm
+     * | order | matrix norm                 | vector norm                 |
+     * |-------|-----------------------------|-----------------------------|
+     * | 'fro' | Frobenius norm              | -                           |
+     * | 'nuc' | sum of singular values      | -                           |
+     * | INF   | max(sum(abs(x), axis=1))    | max(abs(x))                 |
+     * | -INF  | min(sum(abs(x), axis=1))    | min(abs(x))                 |
+     * | 0     | -                           | number of non-zero elements |
+     * | 1     | max(sum(abs(x), axis=0))    | sum(abs(x))                 |
+     * | -1    | min(sum(abs(x), axis=0))    | as below                    |
+     * | 2     | largest singular value      | sqrt(sum(x ** 2))           |
+     * | -2    | smallest singular value     | as below                    |
+     * | other | -                           | sum(abs(x) ** p) ** (1 / p) |
      *
      * @param NumPower|array $a
-     * @param int $order (1) L1-Norm, (2) L2-Norm
-     * @return float
+     * @param int|float|string $order
+     * @param int|null $axis If set, vector norms are computed along this axis,
+     *                       e.g. `-1` gives the norm of every row
+     * @return NumPower|float
      */
-    public static function norm(NumPower|array $a, int $order = 2): float {}
+    public static function norm(NumPower|array $a, int|float|string $order = 2, ?int $axis = null): NumPower|float {}
 
     /**
      * Calculates the numerical rank of a matrix, number of singular
@@ -993,19 +1137,265 @@ final class NumPower {
     /**
      * Performs matrix multiplication between two arrays and returns the result as a new array.
      *
-     * @param NumPower|array $a Input array
-     * @param NumPower|array $b Input array
+     * One operand may be a SparseNDArray, the product is then computed without densifying it.
+     *
+     * @param NumPower|SparseNDArray|array $a Input array
+     * @param NumPower|SparseNDArray|array $b Input array
      * @return NumPower The matrix product of the inputs. This is a scalar only when both x1, x2 are 1-d vectors.
      */
-    public static function matmul(NumPower|array $a, NumPower|array $b): NumPower {}
+    public static function matmul(NumPower|SparseNDArray|array $a, NumPower|SparseNDArray|array $b): NumPower {}
+
+    /**
+     * Dense layer `activation($x @ $w + $b)`. The bias and activation are applied to each
+     * output tile right after it is computed, without intermediate arrays.
+     *
+     * The result is float64 when `$x` or `$w` is float64 and float32 otherwise.
+     *
+     * @param NumPower|array $x Input, `(m, k)` or `(k)`
+     * @param NumPower|array $w Weights, `(k, n)`
+     * @param NumPower|array|null $b Bias of `n` elements
+     * @param string|null $activation `relu`, `tanh`, `sigmoid`, `gelu` or null for none
+     * @return NumPower `(m, n)`, or `(n)` for a 1-D input
+     */
+    public static function linear(NumPower|array $x, NumPower|array $w, NumPower|array|null $b = null, ?string $activation = null): NumPower {}
 
     /**
-     * Computes the LU factorization of a matrix
+     * Gradients of <a href="#">NumPower::linear</a> with respect to `$x`, `$w` and `$b`.
+     *
+     * `relu`, `tanh` and `sigmoid` need the forward output `$y`; `gelu` recomputes the
+     * pre-activation from `$x`, `$w` and `$b` instead.
+     *
+     * @param NumPower|array $grad Gradient of the loss with respect to the layer output
+     * @param NumPower|array $x
+     * @param NumPower|array $w
+     * @param NumPower|array|null $b
+     * @param NumPower|array|null $y Forward output
+     * @param string|null $activation
+     * @return array `[dx, dw, db]`
+     */
+    public static function linearBackward(NumPower|array $grad, NumPower|array $x, NumPower|array $w, NumPower|array|null $b = null, NumPower|array|null $y = null, ?string $activation = null): array {}
+
+    /**
+     * Softmax over the last axis of `$a`, shifted by the row maximum so large inputs do not overflow.
      *
      * @param NumPower|array $a
+     * @return NumPower float64 for float64 input, float32 otherwise
+     */
+    public static function softmax(NumPower|array $a): NumPower {}
+
+    /**
+     * Logarithm of the softmax over the last axis of `$a`, computed as `$a - logsumexp($a)`.
+     *
+     * @param NumPower|array $a
+     * @return NumPower
+     */
+    public static function logSoftmax(NumPower|array $a): NumPower {}
+
+    /**
+     * Layer normalization over the last axis of `$x`: `($x - mean) / sqrt(var + $eps) * $gamma + $beta`.
+     *
+     * @param NumPower|array $x
+     * @param NumPower|array|null $gamma Scale, one per element of the last axis
+     * @param NumPower|array|null $beta Shift, one per element of the last axis
+     * @param float $eps
      * @return NumPower
      */
-    public static function lu(NumPower|array $a): NumPower {}
+    public static function layerNorm(NumPower|array $x, NumPower|array|null $gamma = null, NumPower|array|null $beta = null, float $eps = 1e-5): NumPower {}
+
+    /**
+     * Gradients of <a href="#">NumPower::layerNorm</a>, the statistics are recomputed from `$x`.
+     *
+     * @param NumPower|array $grad Gradient of the loss with respect to the output
+     * @param NumPower|array $x
+     * @param NumPower|array|null $gamma
+     * @param float $eps
+     * @return array `[dx, dgamma, dbeta]`
+     */
+    public static function layerNormBackward(NumPower|array $grad, NumPower|array $x, NumPower|array|null $gamma = null, float $eps = 1e-5): array {}
+
+    /**
+     * Batch normalization per channel of `$x`, shaped `(batch, channels, ...)`. The statistics of a
+     * channel are taken over the batch and all trailing axes, e.g. `(N, C)` or `(N, C, H, W)`.
+     *
+     * Without `$mean` and `$var` the (biased) batch statistics are used; with them, as in inference,
+     * they are applied as given.
+     *
+     * @param NumPower|array $x
+     * @param NumPower|array|null $gamma Scale per channel
+     * @param NumPower|array|null $beta Shift per channel
+     * @param float $eps
+     * @param NumPower|array|null $mean Running mean per channel
+     * @param NumPower|array|null $var Running variance per channel
+     * @return array `[y, mean, var]`
+     */
+    public static function batchNorm(NumPower|array $x, NumPower|array|null $gamma = null, NumPower|array|null $beta = null, float $eps = 1e-5, NumPower|array|null $mean = null, NumPower|array|null $var = null): array {}
+
+    /**
+     * Gradients of <a href="#">NumPower::batchNorm</a> with batch statistics.
+     *
+     * @param NumPower|array $grad Gradient of the loss with respect to the output
+     * @param NumPower|array $x
+     * @param NumPower|array|null $gamma
+     * @param float $eps
+     * @return array `[dx, dgamma, dbeta]`
+     */
+    public static function batchNormBackward(NumPower|array $grad, NumPower|array $x, NumPower|array|null $gamma = null, float $eps = 1e-5): array {}
+
+    /**
+     * Softmax cross-entropy of each row of `$logits`, without forming the softmax explicitly.
+     *
+     * @param NumPower|array $logits `(rows, classes)`
+     * @param NumPower|array $labels Class index per row, or target distributions shaped like `$logits`
+     * @return NumPower Loss per row
+     */
+    public static function crossEntropyWithLogits(NumPower|array $logits, NumPower|array $labels): NumPower {}
+
+    /**
+     * Gradient of the summed <a href="#">NumPower::crossEntropyWithLogits</a> with respect to the
+     * logits, `softmax($logits) - targets`.
+     *
+     * @param NumPower|array $logits
+     * @param NumPower|array $labels
+     * @return NumPower
+     */
+    public static function crossEntropyWithLogitsBackward(NumPower|array $logits, NumPower|array $labels): NumPower {}
+
+    /**
+     * 1-D max pooling. Windows are clipped to the input, so padding never wins the max.
+     *
+     * @param NumPower|array $x `(batch, channels, width)`, or `(batch, width, channels)` for NWC
+     * @param int $kernel
+     * @param int|null $stride Defaults to `$kernel`
+     * @param int|null $padding Defaults to 0
+     * @param string|null $layout `NCW` or `NWC`
+     * @return array `[y, argmax]`, argmax holds the flat int64 index of each max in `$x`
+     */
+    public static function maxPool1d(NumPower|array $x, int $kernel, ?int $stride = null, ?int $padding = null, ?string $layout = 'NCW'): array {}
+
+    /**
+     * 2-D max pooling. Windows are clipped to the input, so padding never wins the max.
+     *
+     * @param NumPower|array $x `(batch, channels, height, width)`, or `(batch, height, width, channels)` for NHWC
+     * @param int|array $kernel `k` or `[kh, kw]`
+     * @param int|array|null $stride Defaults to `$kernel`
+     * @param int|array|null $padding Defaults to 0
+     * @param string|null $layout `NCHW` or `NHWC`
+     * @return array `[y, argmax]`, argmax holds the flat int64 index of each max in `$x`
+     */
+    public static function maxPool2d(NumPower|array $x, int|array $kernel, int|array|null $stride = null, int|array|null $padding = null, ?string $layout = 'NCHW'): array {}
+
+    /**
+     * 1-D average pooling, padding is excluded from the averages.
+     *
+     * @param NumPower|array $x
+     * @param int $kernel
+     * @param int|null $stride Defaults to `$kernel`
+     * @param int|null $padding Defaults to 0
+     * @param string|null $layout `NCW` or `NWC`
+     * @return NumPower
+     */
+    public static function avgPool1d(NumPower|array $x, int $kernel, ?int $stride = null, ?int $padding = null, ?string $layout = 'NCW'): NumPower {}
+
+    /**
+     * 2-D average pooling, padding is excluded from the averages.
+     *
+     * @param NumPower|array $x
+     * @param int|array $kernel
+     * @param int|array|null $stride Defaults to `$kernel`
+     * @param int|array|null $padding Defaults to 0
+     * @param string|null $layout `NCHW` or `NHWC`
+     * @return NumPower
+     */
+    public static function avgPool2d(NumPower|array $x, int|array $kernel, int|array|null $stride = null, int|array|null $padding = null, ?string $layout = 'NCHW'): NumPower {}
+
+    /**
+     * Gradient of <a href="#">NumPower::maxPool1d</a> or <a href="#">NumPower::maxPool2d</a>, scattered
+     * through the cached argmax.
+     *
+     * @param NumPower|array $grad Gradient of the loss with respect to the pooled output
+     * @param NumPower $argmax int64 argmax returned by the forward pass, other integer dtypes are accepted too
+     * @param array $shape Shape of the pooled input
+     * @return NumPower
+     */
+    public static function maxPoolBackward(NumPower|array $grad, NumPower $argmax, array $shape): NumPower {}
+
+    /**
+     * Gradient of <a href="#">NumPower::avgPool1d</a>.
+     *
+     * @param NumPower|array $grad
+     * @param array $shape Shape of the pooled input
+     * @param int $kernel
+     * @param int|null $stride
+     * @param int|null $padding Defaults to 0
+     * @param string|null $layout
+     * @return NumPower
+     */
+    public static function avgPool1dBackward(NumPower|array $grad, array $shape, int $kernel, ?int $stride = null, ?int $padding = null, ?string $layout = 'NCW'): NumPower {}
+
+    /**
+     * Gradient of <a href="#">NumPower::avgPool2d</a>.
+     *
+     * @param NumPower|array $grad
+     * @param array $shape Shape of the pooled input
+     * @param int|array $kernel
+     * @param int|array|null $stride
+     * @param int|array|null $padding Defaults to 0
+     * @param string|null $layout
+     * @return NumPower
+     */
+    public static function avgPool2dBackward(NumPower|array $grad, array $shape, int|array $kernel, int|array|null $stride = null, int|array|null $padding = null, ?string $layout = 'NCHW'): NumPower {}
+
+    /**
+     * Quantize `$a` to int8: round($a / $scale) + $zeroPoint, saturated to [-128, 127].
+     *
+     * @param NumPower|array $a Input array
+     * @param NumPower|array|float $scale A single scale, or one scale per element of the last axis
+     * @param int $zeroPoint
+     * @return NumPower int8 array
+     */
+    public static function quantize(NumPower|array $a, NumPower|array|float $scale, int $zeroPoint = 0): NumPower {}
+
+    /**
+     * Convert an int8 array back to float32: ($q - $zeroPoint) * $scale.
+     *
+     * @param NumPower $q int8 array
+     * @param NumPower|array|float $scale A single scale, or one scale per element of the last axis
+     * @param int $zeroPoint
+     * @return NumPower
+     */
+    public static function dequantize(NumPower $q, NumPower|array|float $scale, int $zeroPoint = 0): NumPower {}
+
+    /**
+     * Matrix product of `$a` and int8 `$weights` quantized with zero point 0.
+     *
+     * Rows of `$a` are quantized to int8 on the fly (int8 inputs are used as is),
+     * the product is accumulated in int32 and scaled back to float32.
+     *
+     * @param NumPower|array $a Input matrix
+     * @param NumPower $weights int8 matrix
+     * @param NumPower|array|float $scale Scale of `$weights`, single or one per column
+     * @return NumPower float32 matrix
+     */
+    public static function quantizedMatmul(NumPower|array $a, NumPower $weights, NumPower|array|float $scale): NumPower {}
+
+    /**
+     * Computes the LU factorization with partial pivoting, P @ A = L @ U
+     *
+     * @param NumPower|array $a
+     * @param bool $permutation_matrix Return P as a matrix instead of the
+     *                                 int64 row permutation, where row i of
+     *                                 L @ U is row $p[i] of A
+     * @return NumPower[] [p, L, U]
+     */
+    public static function lu(NumPower|array $a, bool $permutation_matrix = false): array {}
+
+    /**
+     * Factorizes a matrix once so several systems can be solved with it
+     *
+     * @param NumPower|array $a
+     * @return LUFactorization
+     */
+    public static function luFactor(NumPower|array $a): LUFactorization {}
 
     /**
      * Performs the least-squares solution to a linear matrix equation `Ax = b`,
@@ -1017,8 +1407,56 @@ final class NumPower {
      */
     public static function lstsq(NumPower|array $a, NumPower|array $b): NumPower {}
 
+    /**
+     * Solve `Ax = b` for a symmetric positive-definite `$a` with the conjugate
+     * gradient method. `$a` is a square dense or sparse matrix, or a callable
+     * that receives a float64 vector `$x` and returns `A @ $x`, so the matrix
+     * never has to be formed.
+     *
+     * @param NumPower|SparseNDArray|array|callable $a
+     * @param NumPower|array $b
+     * @param float $tol Relative residual `||b - Ax|| / ||b||` to stop at
+     * @param int|null $max_iter Defaults to `10 * n`
+     * @param NumPower|array|null $x0 Starting guess, zeros by default
+     * @param bool|null $jacobi Precondition with the diagonal of `$a` (or `$diagonal`). By default only when that diagonal is known and has no zeros; `true` requires it
+     * @param NumPower|array|null $diagonal Diagonal of the operator
+     * @return array{x: NumPower, iterations: int, residual: float, converged: bool}
+     */
+    public static function cg(NumPower|SparseNDArray|array|callable $a, NumPower|array $b, float $tol = 1e-5, ?int $max_iter = null, NumPower|array|null $x0 = null, ?bool $jacobi = null, NumPower|array|null $diagonal = null): array {}
+
+    /**
+     * Solve `Ax = b` for a general square `$a` with restarted GMRES. `$a` is a
+     * square dense or sparse matrix, or a callable that returns `A @ $x`.
+     *
+     * @param NumPower|SparseNDArray|array|callable $a
+     * @param NumPower|array $b
+     * @param float $tol Relative residual `||b - Ax|| / ||b||` to stop at
+     * @param int|null $max_iter Total number of inner iterations, defaults to `10 * n`
+     * @param int $restart Krylov subspace size between restarts
+     * @param NumPower|array|null $x0 Starting guess, zeros by default
+     * @param bool|null $jacobi Precondition with the diagonal of `$a` (or `$diagonal`). By default only when that diagonal is known and has no zeros; `true` requires it
+     * @param NumPower|array|null $diagonal Diagonal of the operator
+     * @return array{x: NumPower, iterations: int, residual: float, converged: bool}
+     */
+    public static function gmres(NumPower|SparseNDArray|array|callable $a, NumPower|array $b, float $tol = 1e-5, ?int $max_iter = null, int $restart = 30, NumPower|array|null $x0 = null, ?bool $jacobi = null, NumPower|array|null $diagonal = null): array {}
+
+    /**
+     * The `$k` largest or smallest eigenpairs of a large symmetric operator with the Lanczos
+     * iteration. `$a` is a dense or sparse symmetric matrix, or a callable that returns `A @ $x`.
+     *
+     * @param NumPower|SparseNDArray|array|callable $a
+     * @param int $k Number of eigenpairs
+     * @param string $which `largest` or `smallest`
+     * @param float $tol Largest Ritz residual, relative to the spectral scale, to stop at
+     * @param int|null $max_dim Largest Krylov basis, defaults to `min(n, max(8 * k, 256))`
+     * @param int|null $n Size of the operator, required when `$a` is a callable
+     * @return array{values: NumPower, vectors: NumPower, iterations: int, residual: float, converged: bool}
+     */
+    public static function lanczos(NumPower|SparseNDArray|array|callable $a, int $k = 6, string $which = 'largest', float $tol = 1e-8, ?int $max_dim = null, ?int $n = null): array {}
+
     /**
      * Compute the inverse of a matrix, such that `$a * nd::inv($a) = np::identity($a->shape())`.
+     * A stack of matrices `(..., n, n)` is inverted matrix by matrix.
      *
      * @param NumPower|array $a
      * @return NumPower
@@ -1042,9 +1480,30 @@ final class NumPower {
      * Computes the eigenvalues and eigenvectors of a square array.
      *
      * @param NumPower|array $a
+     * @param bool $symmetric Use the symmetric solver of eigh(): only the lower triangle of $a is read
+     *                        and the eigenvalues are returned in ascending order
      * @return array
      */
-    public static function eig(NumPower|array $a): array {}
+    public static function eig(NumPower|array $a, bool $symmetric = false): array {}
+
+    /**
+     * Eigenvalues and eigenvectors of a real symmetric matrix, with the eigenvalues in
+     * ascending order and the eigenvectors as columns. Only the lower triangle of `$a` is read.
+     *
+     * @param NumPower|array $a
+     * @param array|null $subset `[first, last]` indices of the wanted eigenvalues, all by default
+     * @return array `[eigenvalues, eigenvectors]`
+     */
+    public static function eigh(NumPower|array $a, ?array $subset = null): array {}
+
+    /**
+     * Eigenvalues of a real symmetric matrix in ascending order, see <a href="#">NumPower::eigh</a>.
+     *
+     * @param NumPower|array $a
+     * @param array|null $subset `[first, last]` indices of the wanted eigenvalues, all by default
+     * @return NumPower
+     */
+    public static function eigvalsh(NumPower|array $a, ?array $subset = null): NumPower {}
 
     /**
      * The `dot` function performs the dot product of two arrays. The behaviour of the function
@@ -1058,20 +1517,23 @@ final class NumPower {
      * - If `$a` is an N-D array and `$b` is a 1-D array, the dot product is computed as the
      * sum product over the last axis of `$a` and `$b`.
      *
-     * @param NumPower|array|float|int $a Input array
-     * @param NumPower|array|float|int $b Input array
+     * - If `$a` or `$b` is a SparseNDArray, it is the sparse matrix product (see <a href="#">NumPower::matmul</a>).
+     *
+     * @param NumPower|SparseNDArray|array|float|int $a Input array
+     * @param NumPower|SparseNDArray|array|float|int $b Input array
      * @return NumPower
      */
-    public static function dot(NumPower|array|float|int $a, NumPower|array|float|int $b): NumPower {}
+    public static function dot(NumPower|SparseNDArray|array|float|int $a, NumPower|SparseNDArray|array|float|int $b): NumPower {}
 
     /**
      * Computes the determinant of a square array, which represents the scaling factor of the volume
-     * of the array transformation.
+     * of the array transformation. A stack of matrices `(..., n, n)` gives an array of
+     * determinants of shape `(...)`.
      *
      * @param NumPower|array $a
-     * @return float
+     * @return NumPower|float
      */
-    public static function det(NumPower|array $a): float {}
+    public static function det(NumPower|array $a): NumPower|float {}
 
     /**
      * Computes the condition number of an array.
@@ -1083,7 +1545,8 @@ final class NumPower {
 
     /**
      * Calculates the Cholesky decomposition of a positive-definite array, decomposing
-     * it into a lower triangular matrix and its conjugate transpose.
+     * it into a lower triangular matrix and its conjugate transpose. A stack of matrices
+     * `(..., n, n)` is decomposed matrix by matrix.
      *
      * @param NumPower|array $a
      * @return NumPower
@@ -1120,6 +1583,60 @@ final class NumPower {
      */
     public static function diag(NumPower|array $a): NumPower {}
 
+    /**
+     * Take elements from an array along an axis.
+     *
+     * @param NumPower|array $a Input array
+     * @param NumPower|array $indices Integer indices, negative values count from the end
+     * @param int|null $axis Axis to take from, null takes from the flattened array
+     * @return NumPower Array of shape a.shape[:axis] + indices.shape + a.shape[axis+1:]
+     */
+    public static function take(NumPower|array $a, NumPower|array $indices, ?int $axis = null): NumPower {}
+
+    /**
+     * Replace elements of the flattened array at the given indices, in place.
+     * $values is repeated when it has fewer elements than $indices.
+     *
+     * @param NumPower $a Contiguous array written in place
+     * @param NumPower|array $indices Integer indices into the flattened array
+     * @param NumPower|array|float|int $values Values to write
+     * @return void
+     */
+    public static function put(NumPower $a, NumPower|array $indices, NumPower|array|float|int $values): void {}
+
+    /**
+     * Return elements chosen from $x where $condition is true and from $y elsewhere.
+     * The three inputs are broadcast together.
+     *
+     * @param NumPower|array $condition Non-bool conditions are tested for non-zero
+     * @param NumPower|array|float|int $x
+     * @param NumPower|array|float|int $y
+     * @return NumPower
+     */
+    public static function where(NumPower|array $condition, NumPower|array|float|int $x, NumPower|array|float|int $y): NumPower {}
+
+    /**
+     * Gather values along an axis: out[i][j] = a[indices[i][j]][j] for axis 0.
+     *
+     * @param NumPower|array $a Input array
+     * @param int $axis Axis to index along
+     * @param NumPower|array $indices Integer array with the same number of dimensions as $a
+     * @return NumPower Array with the shape of $indices
+     */
+    public static function gather(NumPower|array $a, int $axis, NumPower|array $indices): NumPower {}
+
+    /**
+     * Return a copy of $a with out[indices[i][j]][j] += src[i][j] for axis 0.
+     * Repeated indices accumulate.
+     *
+     * @param NumPower|array $a Input array
+     * @param int $axis Axis to index along
+     * @param NumPower|array $indices Integer array with the same number of dimensions as $a
+     * @param NumPower|array $src Values to add, at least as large as $indices
+     * @return NumPower
+     */
+    public static function scatterAdd(NumPower|array $a, int $axis, NumPower|array $indices, NumPower|array $src): NumPower {}
+
     /**
      * Return a new array of given shape and type, filled with $fill_value.
      *
@@ -1129,6 +1646,94 @@ final class NumPower {
      */
     public static function full(array $shape, float|int $fill_value): NumPower {}
 
+    /**
+     * Load data from a delimited text file into a 2-D array.
+     *
+     * The file is streamed in chunks of $chunk_size bytes and parsed directly into the
+     * output buffer. Empty lines and lines starting with # are ignored.
+     *
+     * @param string $filename File to read
+     * @param string $delimiter Single character used to separate values
+     * @param int $skiprows Skip the first $skiprows lines
+     * @param int|int[]|null $usecols Which columns to read, negative values count from the last column
+     * @param int $chunk_size Number of bytes read per chunk
+     * @return NumPower
+     */
+    public static function loadtxt(string $filename, string $delimiter = ",", int $skiprows = 0, int|array|null $usecols = null, int $chunk_size = 1048576): NumPower {}
+
+    /**
+     * Load raw float32 values from a binary file into a 1-D array.
+     *
+     * @param string $filename File to read
+     * @param int $count Number of items to read, -1 reads the entire file
+     * @param int $offset Offset in bytes from the start of the file
+     * @param int $chunk_size Number of bytes read per chunk
+     * @return NumPower
+     */
+    public static function fromfile(string $filename, int $count = -1, int $offset = 0, int $chunk_size = 1048576): NumPower {}
+
+    /**
+     * Create a named array backed by shared memory. Other processes map it with attach() without
+     * copying its data; the segment stays until unlinkShared() removes it.
+     *
+     * @param string $name Name of the shared array
+     * @param int[] $shape Shape of the new array
+     * @param string $dtype
+     * @return NumPower
+     */
+    public static function shared(string $name, array $shape, string $dtype = 'float32'): NumPower {}
+
+    /**
+     * Map an existing shared array created with shared().
+     *
+     * @param string $name Name of the shared array
+     * @return NumPower
+     */
+    public static function attach(string $name): NumPower {}
+
+    /**
+     * Remove the name of a shared array. Arrays already attached remain valid.
+     *
+     * @param string $name Name of the shared array
+     * @return void
+     */
+    public static function unlinkShared(string $name): void {}
+
+    /**
+     * Copy the array into persistent memory under $name. Persisted arrays survive the end
+     * of the request and can be fetched by later requests served by the same process.
+     *
+     * The total size is capped by the NDARRAY_PERSISTENT_LIMIT environment variable (bytes, 256MB by default).
+     *
+     * @param string $name
+     * @return void
+     */
+    public function persist(string $name): void {}
+
+    /**
+     * Fetch an array stored with persist(). The returned array reads the persistent buffer
+     * in place, without copying.
+     *
+     * @param string $name
+     * @return NumPower|null NULL if nothing was persisted under $name
+     */
+    public static function persisted(string $name): ?NumPower {}
+
+    /**
+     * Remove a persisted array.
+     *
+     * @param string $name
+     * @return bool FALSE if nothing was persisted under $name
+     */
+    public static function unpersist(string $name): bool {}
+
+    /**
+     * Persistent memory usage: count, bytes, limit, hits and misses.
+     *
+     * @return array
+     */
+    public static function persistentStats(): array {}
+
     /**
      * Fill the array with a scalar value.
      *
@@ -1137,6 +1742,41 @@ final class NumPower {
      */
     public function fill(float|int $fill_value): NumPower {}
 
+    /**
+     * Add $b to this array element-wise, writing into this array.
+     *
+     * `$a += $b` does the same without a new allocation when $a is not
+     * referenced anywhere else.
+     *
+     * @param NumPower|array|float|int $b
+     * @return NumPower $this
+     */
+    public function addInPlace(NumPower|array|float|int $b): NumPower {}
+
+    /**
+     * Subtract $b from this array element-wise, writing into this array.
+     *
+     * @param NumPower|array|float|int $b
+     * @return NumPower $this
+     */
+    public function subInPlace(NumPower|array|float|int $b): NumPower {}
+
+    /**
+     * Multiply this array by $b element-wise, writing into this array.
+     *
+     * @param NumPower|array|float|int $b
+     * @return NumPower $this
+     */
+    public function mulInPlace(NumPower|array|float|int $b): NumPower {}
+
+    /**
+     * Divide this array by $b element-wise, writing into this array.
+     *
+     * @param NumPower|array|float|int $b
+     * @return NumPower $this
+     */
+    public function divInPlace(NumPower|array|float|int $b): NumPower {}
+
     /**
      * Returns the indices of the minimum values along an axis.
      *
@@ -1157,6 +1797,46 @@ final class NumPower {
      */
     public static function argmax(NumPower|array $a, ?int $axis, bool $keepdims = false): NumPower {}
 
+    /**
+     * Cumulative sum of the elements along an axis. Integer and bool
+     * inputs produce int64.
+     *
+     * @param NumPower|array $a
+     * @param int|null $axis If NULL, the flattened array is summed
+     * @return NumPower
+     */
+    public static function cumsum(NumPower|array $a, ?int $axis = null): NumPower {}
+
+    /**
+     * Cumulative product of the elements along an axis. Integer and bool
+     * inputs produce int64.
+     *
+     * @param NumPower|array $a
+     * @param int|null $axis If NULL, the flattened array is multiplied
+     * @return NumPower
+     */
+    public static function cumprod(NumPower|array $a, ?int $axis = null): NumPower {}
+
+    /**
+     * Running maximum of the elements along an axis. NaN propagates.
+     *
+     * @param NumPower|array $a
+     * @param int|null $axis If NULL, the flattened array is scanned
+     * @return NumPower
+     */
+    public static function cummax(NumPower|array $a, ?int $axis = null): NumPower {}
+
+    /**
+     * n-th discrete difference along an axis, `a[i + 1] - a[i]` applied `n`
+     * times. Bool arrays return where neighbours differ.
+     *
+     * @param NumPower|array $a
+     * @param int $n Number of times values are differenced
+     * @param int|null $axis If NULL, the flattened array is used
+     * @return NumPower
+     */
+    public static function diff(NumPower|array $a, int $n = 1, ?int $axis = -1): NumPower {}
+
     /**
      * Array slicing, each argument represents a slice of a dimension.
      *
@@ -1180,4 +1860,124 @@ final class NumPower {
      * @return NumPower|float
      */
     public function slice(...$indices): NumPower|float {}
-}
\ No newline at end of file
+}
+
+final class NDArrayExpression {
+    /**
+     * Evaluate the expression with broadcasting, returning a new array.
+     *
+     * An expression can be evaluated any number of times, it always reads
+     * the current values of its inputs.
+     *
+     * @return NumPower|float
+     */
+    public function eval(): NumPower|float {}
+}
+
+final class LUFactorization {
+    /**
+     * Solve A @ x = b with the stored factorization of a square A.
+     *
+     * @param NumPower|array $b Vector or matrix of right hand sides
+     * @return NumPower
+     */
+    public function solve(NumPower|array $b): NumPower {}
+
+    /**
+     * Row permutation, row i of L @ U is row $p[i] of A.
+     *
+     * @return NumPower int64 vector
+     */
+    public function permutation(): NumPower {}
+
+    /**
+     * Unit lower triangular factor.
+     *
+     * @return NumPower
+     */
+    public function lower(): NumPower {}
+
+    /**
+     * Upper triangular factor.
+     *
+     * @return NumPower
+     */
+    public function upper(): NumPower {}
+}
+
+final class SparseNDArray {
+    /**
+     * Build a sparse matrix from (row, column, value) triplets. Entries with
+     * the same coordinates are summed. float64 values are kept in double
+     * precision, any other type is stored as float32.
+     *
+     * @param NumPower|array $rows Row index of every entry
+     * @param NumPower|array $cols Column index of every entry
+     * @param NumPower|array $values
+     * @param array $shape [rows, cols]
+     * @param string $format 'csr' or 'coo'
+     * @return SparseNDArray
+     */
+    public static function fromTriplets(NumPower|array $rows, NumPower|array $cols, NumPower|array $values, array $shape, string $format = 'csr'): SparseNDArray {}
+
+    /**
+     * Sparse copy of the non-zero entries of a 2-D array.
+     *
+     * @param NumPower|array $a
+     * @param string $format 'csr' or 'coo'
+     * @return SparseNDArray
+     */
+    public static function fromDense(NumPower|array $a, string $format = 'csr'): SparseNDArray {}
+
+    /**
+     * @return NumPower Dense copy
+     */
+    public function toDense(): NumPower {}
+
+    /**
+     * @return SparseNDArray Copy in compressed sparse row format
+     */
+    public function toCSR(): SparseNDArray {}
+
+    /**
+     * @return SparseNDArray Copy in coordinate format
+     */
+    public function toCOO(): SparseNDArray {}
+
+    /**
+     * @return SparseNDArray Sparse transpose in the same format
+     */
+    public function transpose(): SparseNDArray {}
+
+    /**
+     * Rows [$start, $stop) as a new sparse matrix. Negative bounds count from the end.
+     *
+     * @param int $start
+     * @param int|null $stop Defaults to the number of rows
+     * @return SparseNDArray
+     */
+    public function rows(int $start, ?int $stop = null): SparseNDArray {}
+
+    /**
+     * Product with a dense vector or matrix, same as `NumPower::matmul($this, $b)`.
+     *
+     * @param NumPower|array $b
+     * @return NumPower
+     */
+    public function matmul(NumPower|array $b): NumPower {}
+
+    /**
+     * @return int[] [rows, cols]
+     */
+    public function shape(): array {}
+
+    /**
+     * @return int Number of stored entries
+     */
+    public function nnz(): int {}
+
+    /**
+     * @return string 'csr' or 'coo'
+     */
+    public function format(): string {}
+}
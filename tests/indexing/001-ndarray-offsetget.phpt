@@ -0,0 +1,51 @@
+--TEST--
+NDArray::offsetGet
+--FILE--
+<?php
+$a = \NumPower::array([[1, 2], [3, 4], [5, 6]]);
+print_r($a[1]->toArray());
+print_r($a[-1]->toArray());
+echo $a[2][1], "\n";
+$b = \NumPower::array([1, 2, 3]);
+echo $b[0], " ", $b[-1], "\n";
+$b[-1] = 10;
+$a[0] = [7, 8];
+print_r($b->toArray());
+print_r($a[0]->toArray());
+foreach ($b as $value) {
+    echo $value, "\n";
+}
+try {
+    $b[3];
+} catch (\Error $e) {
+    echo $e->getMessage(), "\n";
+}
+?>
+--EXPECT--
+Array
+(
+    [0] => 3
+    [1] => 4
+)
+Array
+(
+    [0] => 5
+    [1] => 6
+)
+6
+1 3
+Array
+(
+    [0] => 1
+    [1] => 2
+    [2] => 10
+)
+Array
+(
+    [0] => 7
+    [1] => 8
+)
+1
+2
+10
+Index out of bounds
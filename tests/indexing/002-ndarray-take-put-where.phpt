@@ -0,0 +1,35 @@
+--TEST--
+NumPower::take, put, where, gather, scatterAdd and boolean mask assignment
+--FILE--
+<?php
+require __DIR__ . '/../helpers.inc';
+$a = \NumPower::array([[0, 1, 2, 3], [4, 5, 6, 7], [8, 9, 10, 11]]);
+flat(\NumPower::take($a, [2, 0, -1]));
+flat(\NumPower::take($a, [2, 0], 0));
+flat(\NumPower::take($a, [3, 1], 1));
+flat(\NumPower::gather($a, 0, [[0, 1, 2, 0], [2, 0, 0, 1]]));
+flat(\NumPower::scatterAdd(\NumPower::zeros([3, 4]), 0, [[0, 1, 2, 0], [2, 0, 0, 1]], \NumPower::ones([2, 4])));
+flat(\NumPower::where(\NumPower::greater($a, 5), $a, 0));
+$mask = \NumPower::greater($a, 8);
+flat($a[$mask]);
+$a[$mask] = -1;
+flat($a);
+\NumPower::put($a, [0, 1], [100, 200]);
+flat($a);
+try {
+    \NumPower::take($a, [5], 0);
+} catch (\Error $e) {
+    echo $e->getMessage(), "\n";
+}
+?>
+--EXPECT--
+2 0 11
+8 9 10 11 0 1 2 3
+3 1 7 5 11 9
+0 5 10 3 8 1 2 7
+1 1 1 1 0 1 0 1 1 0 1 0
+0 0 0 0 0 0 6 7 8 9 10 11
+9 10 11
+0 1 2 3 4 5 6 7 8 -1 -1 -1
+100 200 2 3 4 5 6 7 8 -1 -1 -1
+Index 5 is out of bounds for axis 0 with size 3.
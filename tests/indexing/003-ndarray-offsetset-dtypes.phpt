@@ -0,0 +1,36 @@
+--TEST--
+NDArray::offsetSet on non-float32 rows
+--FILE--
+<?php
+$u = \NumPower::array([[0, 0, 0], [0, 0, 0]], 'uint8');
+$u[1] = [200, 7, 255];
+$u[0] = \NumPower::array([1, 2, 3], 'int64');
+echo $u->dtype(), "\n";
+print_r($u->toArray());
+$d = \NumPower::array([[0, 0], [0, 0]], 'float64');
+$d[0] = \NumPower::array([16777217, 0.1], 'float64');
+$d[1] = [1.5, -2];
+echo $d->dtype(), "\n";
+printf("%.1f %.17g %.1f %.1f\n", $d[0][0], $d[0][1], $d[1][0], $d[1][1]);
+?>
+--EXPECT--
+uint8
+Array
+(
+    [0] => Array
+        (
+            [0] => 1
+            [1] => 2
+            [2] => 3
+        )
+
+    [1] => Array
+        (
+            [0] => 200
+            [1] => 7
+            [2] => 255
+        )
+
+)
+float64
+16777217.0 0.10000000000000001 1.5 -2.0
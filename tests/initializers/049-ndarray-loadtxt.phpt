@@ -0,0 +1,50 @@
+--TEST--
+NumPower::loadtxt
+--FILE--
+<?php
+$file = tempnam(sys_get_temp_dir(), 'np');
+file_put_contents($file, "# x,y,z\n1,2,3\n4, 5.5, -6\n\n7,8e1,9\n");
+print_r(\NumPower::loadtxt($file)->toArray());
+print_r(\NumPower::loadtxt($file, ",", 2, [-1, 0], 4)->toArray());
+unlink($file);
+?>
+--EXPECT--
+Array
+(
+    [0] => Array
+        (
+            [0] => 1
+            [1] => 2
+            [2] => 3
+        )
+
+    [1] => Array
+        (
+            [0] => 4
+            [1] => 5.5
+            [2] => -6
+        )
+
+    [2] => Array
+        (
+            [0] => 7
+            [1] => 80
+            [2] => 9
+        )
+
+)
+Array
+(
+    [0] => Array
+        (
+            [0] => -6
+            [1] => 4
+        )
+
+    [1] => Array
+        (
+            [0] => 9
+            [1] => 7
+        )
+
+)
@@ -0,0 +1,23 @@
+--TEST--
+NumPower::fromfile
+--FILE--
+<?php
+$file = tempnam(sys_get_temp_dir(), 'np');
+file_put_contents($file, pack('g*', 1.5, 2, 3, 4));
+print_r(\NumPower::fromfile($file)->toArray());
+print_r(\NumPower::fromfile($file, 2, 4)->toArray());
+unlink($file);
+?>
+--EXPECT--
+Array
+(
+    [0] => 1.5
+    [1] => 2
+    [2] => 3
+    [3] => 4
+)
+Array
+(
+    [0] => 2
+    [1] => 3
+)
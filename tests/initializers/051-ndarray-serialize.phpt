@@ -0,0 +1,52 @@
+--TEST--
+NDArray::__serialize
+--FILE--
+<?php
+$a = \NumPower::array([[1, 2.5], [3, 4]]);
+$s = serialize($a);
+print_r(unserialize($s)->toArray());
+print_r(unserialize($s)->shape());
+$legacy = 'O:7:"NDArray":2:{i:0;d:1;i:1;d:2;}';
+print_r(unserialize($legacy)->toArray());
+function payload($fields) {
+    return 'O:7:"NDArray":3:' . substr(serialize($fields), 4);
+}
+$b = unserialize(payload(['dtype' => 'bool', 'shape' => [3], 'data' => "\x00\x05\x01"]));
+echo implode(' ', array_map('intval', $b->toArray())), "\n";
+foreach ([[-1], [65536, 65536]] as $shape) {
+    try {
+        unserialize(payload(['dtype' => 'float32', 'shape' => $shape, 'data' => '']));
+    } catch (\Error $e) {
+        echo $e->getMessage(), "\n";
+    }
+}
+?>
+--EXPECT--
+Array
+(
+    [0] => Array
+        (
+            [0] => 1
+            [1] => 2.5
+        )
+
+    [1] => Array
+        (
+            [0] => 3
+            [1] => 4
+        )
+
+)
+Array
+(
+    [0] => 2
+    [1] => 2
+)
+Array
+(
+    [0] => 1
+    [1] => 2
+)
+0 1 1
+Invalid serialized NDArray.
+Serialized NDArray shape is too large.
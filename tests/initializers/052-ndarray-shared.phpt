@@ -0,0 +1,59 @@
+--TEST--
+NDArray::shared
+--FILE--
+<?php
+$name = 'numpower_test_' . getmypid();
+$a = \NDArray::shared($name, [2, 2]);
+$a->fill(3);
+$b = \NDArray::attach($name);
+print_r($b->toArray());
+\NDArray::unlinkShared($name);
+try {
+    \NDArray::attach($name);
+} catch (\Error $e) {
+    echo $e->getMessage() . "\n";
+}
+print_r($b->toArray());
+
+$c = \NDArray::shared($name . '_int', [2], 'int64');
+$c->fill(7);
+$d = \NDArray::attach($name . '_int');
+echo $d->dtype(), ' ', implode(' ', $d->toArray()), "\n";
+unset($c, $d);
+echo implode(' ', \NDArray::attach($name . '_int')->toArray()), "\n";
+\NDArray::unlinkShared($name . '_int');
+?>
+--EXPECTF--
+Array
+(
+    [0] => Array
+        (
+            [0] => 3
+            [1] => 3
+        )
+
+    [1] => Array
+        (
+            [0] => 3
+            [1] => 3
+        )
+
+)
+Shared array "numpower_test_%d" does not exist.
+Array
+(
+    [0] => Array
+        (
+            [0] => 3
+            [1] => 3
+        )
+
+    [1] => Array
+        (
+            [0] => 3
+            [1] => 3
+        )
+
+)
+int64 7 7
+7 7
@@ -0,0 +1,51 @@
+--TEST--
+NDArray::persist
+--FILE--
+<?php
+var_dump(\NDArray::persisted('weights'));
+$a = \NumPower::array([[1, 2], [3, 4]]);
+$a->persist('weights');
+print_r(\NDArray::persisted('weights')->toArray());
+$stats = \NDArray::persistentStats();
+echo $stats['count'], ' ', $stats['bytes'], ' ', $stats['hits'], ' ', $stats['misses'], "\n";
+var_dump(\NDArray::unpersist('weights'));
+var_dump(\NDArray::unpersist('weights'));
+echo \NDArray::persistentStats()['bytes'], "\n";
+
+\NumPower::array([1, 2, 3], 'int64')->persist('ids');
+$ids = \NDArray::persisted('ids');
+$ids->fill(0);
+$again = \NDArray::persisted('ids');
+echo $again->dtype(), ' ', implode(' ', $again->toArray()), ' ', implode(' ', $ids->toArray()), "\n";
+\NDArray::unpersist('ids');
+
+\NumPower::array([[1, 2], [3, 4]])->persist('rows');
+$rows = \NDArray::persisted('rows');
+$first = $rows[0];
+$first[1] = 5;
+echo implode(' ', $first->toArray()), ' ', implode(' ', \NDArray::persisted('rows')[0]->toArray()), "\n";
+\NDArray::unpersist('rows');
+?>
+--EXPECT--
+NULL
+Array
+(
+    [0] => Array
+        (
+            [0] => 1
+            [1] => 2
+        )
+
+    [1] => Array
+        (
+            [0] => 3
+            [1] => 4
+        )
+
+)
+1 16 1 1
+bool(true)
+bool(false)
+0
+int64 1 2 3 0 0 0
+1 5 1 2
@@ -0,0 +1,42 @@
+--TEST--
+NDArray float64 dtype
+--FILE--
+<?php
+$a = \NumPower::array([0.1, 16777217], 'float64');
+echo $a->dtype(), "\n";
+$b = $a + 0.1;
+echo $b->dtype(), "\n";
+printf("%.17g %.17g\n", $b[0], $b[1]);
+printf("%.17g\n", \NumPower::sum(\NumPower::array([0.1, 0.2, 16777217], 'float64')));
+$c = \NumPower::array([1, 2]) * $a;
+echo $c->dtype(), "\n";
+$m = \NumPower::array([[1, 2], [3, 4]], 'float64');
+print_r(\NumPower::matmul($m, $m)->toArray());
+printf("%.6f\n", \NumPower::det($m));
+echo \NumPower::zeros([2], 'float64')->dtype(), "\n";
+echo $m->astype('float32')->dtype(), "\n";
+?>
+--EXPECT--
+float64
+float64
+0.20000000000000001 16777217.100000001
+16777217.300000001
+float64
+Array
+(
+    [0] => Array
+        (
+            [0] => 7
+            [1] => 10
+        )
+
+    [1] => Array
+        (
+            [0] => 15
+            [1] => 22
+        )
+
+)
+-2.000000
+float64
+float32
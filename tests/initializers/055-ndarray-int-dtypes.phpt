@@ -0,0 +1,49 @@
+--TEST--
+NDArray integer and boolean dtypes
+--FILE--
+<?php
+$a = \NumPower::array([1, 5, 3, 8], 'int32');
+echo $a->dtype(), "\n";
+var_dump($a[1]);
+$mask = \NumPower::greater($a, 2);
+echo $mask->dtype(), "\n";
+print_r($mask->toArray());
+echo \NumPower::countNonzero($mask), "\n";
+print_r($a[$mask]->toArray());
+$b = $a + \NumPower::array([1, 1, 1, 1], 'int64');
+echo $b->dtype(), "\n";
+$c = $a / 2;
+echo $c->dtype(), "\n";
+print_r($c->toArray());
+var_dump(\NumPower::argmax($a));
+echo \NumPower::array([255, 1], 'uint8')->astype('int64')[0], "\n";
+?>
+--EXPECT--
+int32
+int(5)
+bool
+Array
+(
+    [0] => 0
+    [1] => 1
+    [2] => 1
+    [3] => 1
+)
+3
+Array
+(
+    [0] => 5
+    [1] => 3
+    [2] => 8
+)
+int64
+float64
+Array
+(
+    [0] => 0.5
+    [1] => 2.5
+    [2] => 1.5
+    [3] => 4
+)
+int(3)
+255
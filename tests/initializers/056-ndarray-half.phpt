@@ -0,0 +1,42 @@
+--TEST--
+NDArray float16 and bfloat16 storage dtypes
+--FILE--
+<?php
+$a = \NumPower::array([[1, 2], [3, 4]], 'float16');
+echo $a->dtype(), "\n";
+var_dump($a[1][0]);
+printf("%.6f\n", \NumPower::array([0.1], 'float16')[0]);
+printf("%.6f\n", \NumPower::array([3.14159], 'bfloat16')[0]);
+$b = $a + 1;
+echo $b->dtype(), "\n";
+print_r(\NumPower::matmul($a, $a)->toArray());
+echo \NumPower::matmul($a, $a)->dtype(), "\n";
+echo ($a + \NumPower::array([[1, 1], [1, 1]], 'bfloat16'))->dtype(), "\n";
+echo \NumPower::sum($a), "\n";
+echo \NumPower::array([65504, 70000], 'float16')->astype('float32')[1], "\n";
+?>
+--EXPECT--
+float16
+float(3)
+0.099976
+3.140625
+float16
+Array
+(
+    [0] => Array
+        (
+            [0] => 7
+            [1] => 10
+        )
+
+    [1] => Array
+        (
+            [0] => 15
+            [1] => 22
+        )
+
+)
+float16
+float32
+10
+INF
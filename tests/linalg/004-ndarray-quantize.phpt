@@ -0,0 +1,52 @@
+--TEST--
+NumPower::quantize, NumPower::dequantize and NumPower::quantizedMatmul
+--FILE--
+<?php
+$w = \NumPower::array([[0.6, -2.2], [-1, 4], [0.3, 1.1]]);
+$scale = [1 / 127, 4 / 127];
+$q = \NumPower::quantize($w, $scale);
+echo $q->dtype(), "\n";
+print_r($q->toArray());
+print_r(\NumPower::quantize([1.5, -300, 2.5], 1.0)->toArray());
+$d = \NumPower::dequantize($q, $scale);
+echo $d->dtype(), "\n";
+printf("%.4f %.4f\n", $d[1][1], $d[2][0]);
+$x = \NumPower::array([[1, 2, 3], [-4, 0, 1]]);
+$y = \NumPower::quantizedMatmul($x, $q, $scale);
+foreach ($y->toArray() as $row) {
+    printf("%.2f %.2f\n", $row[0], $row[1]);
+}
+?>
+--EXPECT--
+int8
+Array
+(
+    [0] => Array
+        (
+            [0] => 76
+            [1] => -70
+        )
+
+    [1] => Array
+        (
+            [0] => -127
+            [1] => 127
+        )
+
+    [2] => Array
+        (
+            [0] => 38
+            [1] => 35
+        )
+
+)
+Array
+(
+    [0] => 2
+    [1] => -128
+    [2] => 2
+)
+float32
+4.0000 0.2992
+-0.52 9.15
+-2.09 9.93
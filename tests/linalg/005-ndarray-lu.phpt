@@ -0,0 +1,31 @@
+--TEST--
+NumPower::lu and NumPower::luFactor
+--FILE--
+<?php
+require __DIR__ . '/../helpers.inc';
+$a = [[1, 2, 3], [4, 5, 6], [7, 8, 10]];
+[$p, $l, $u] = \NumPower::lu($a);
+flat($p);
+flat($l);
+flat($u);
+[$p, $l, $u] = \NumPower::lu($a, true);
+flat($p);
+$lu = \NumPower::luFactor($a);
+flat($lu->permutation());
+flat($lu->solve([1, 2, 3]));
+flat($lu->solve([[1, 0], [2, 1], [3, 0]]));
+try {
+    \NumPower::luFactor([[1, 2], [2, 4]])->solve([1, 1]);
+} catch (\Error $e) {
+    echo $e->getMessage(), "\n";
+}
+?>
+--EXPECT--
+2 0 1
+1 0 0 0.1429 1 0 0.5714 0.5 1
+7 8 10 0 0.8571 1.5714 0 0 -0.5
+0 0 1 1 0 0 0 1 0
+2 0 1
+-0.3333 0.6667 0
+-0.3333 -1.3333 0.6667 3.6667 0 -2
+Matrix is singular.
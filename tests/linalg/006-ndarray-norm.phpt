@@ -0,0 +1,36 @@
+--TEST--
+NumPower::norm orders and axis
+--FILE--
+<?php
+require __DIR__ . '/../helpers.inc';
+$a = [[1, -2, 3], [-4, 5, -6]];
+flat(\NumPower::norm($a));
+flat(\NumPower::norm($a, -2));
+flat(\NumPower::norm($a, 'fro'));
+flat(\NumPower::norm($a, 1));
+flat(\NumPower::norm($a, INF));
+flat(\NumPower::norm($a, -INF));
+flat(\NumPower::norm($a, 2, 1));
+flat(\NumPower::norm($a, 1, 0));
+flat(\NumPower::norm([3, 4, 0]));
+flat(\NumPower::norm([3, 4, 0], 0));
+flat(\NumPower::norm([3, 4, 0], INF));
+try {
+    \NumPower::norm($a, 3);
+} catch (\Error $e) {
+    echo $e->getMessage(), "\n";
+}
+?>
+--EXPECT--
+9.508
+0.7729
+9.5394
+9
+15
+6
+3.7417 8.775
+5 7 9
+5
+2
+4
+Invalid norm order for matrices.
@@ -0,0 +1,36 @@
+--TEST--
+NumPower::svd values only and truncated
+--FILE--
+<?php
+require __DIR__ . '/../helpers.inc';
+$a = [[1, -2, 3], [-4, 5, -6]];
+flat(\NumPower::svd($a, false));
+flat(\NumPower::norm($a, 'nuc'));
+flat(\NumPower::matrixRank($a));
+flat(\NumPower::cond($a));
+
+$b = [[1, 2, 3], [2, 4, 6], [3, 6, 9], [4, 8, 12]];
+flat(\NumPower::matrixRank($b));
+[$u, $s, $vh] = \NumPower::svd($b, k: 1);
+echo implode(' ', $u->shape()), ' | ', implode(' ', $s->shape()), ' | ', implode(' ', $vh->shape()), "\n";
+flat($s);
+$r = \NumPower::matmul(\NumPower::multiply($u, $s), $vh)->toArray();
+echo implode(' ', array_map(fn($x) => round($x, 3) + 0, array_merge(...$r))), "\n";
+flat(\NumPower::svd($a, false, 1));
+try {
+    \NumPower::svd($a, k: 3);
+} catch (\Error $e) {
+    echo $e->getMessage(), "\n";
+}
+?>
+--EXPECT--
+9.508 0.7729
+10.2809
+2
+12.3022
+1
+4 1 | 1 | 1 3
+20.4939
+1 2 3 2 4 6 3 6 9 4 8 12
+9.508
+k must be between 1 and min(M, N) = 2
@@ -0,0 +1,49 @@
+--TEST--
+NumPower::det, inv, solve and cholesky over stacks of matrices
+--FILE--
+<?php
+require __DIR__ . '/../helpers.inc';
+$a = [[[1, 2], [3, 4]], [[2, 0], [0, 2]], [[4, 7], [2, 6]]];
+flat(\NumPower::det($a));
+flat(\NumPower::inv($a));
+flat(\NumPower::solve($a, [5, 6]));
+echo implode(' ', \NumPower::solve($a, [[[1], [2]], [[1], [2]], [[1], [2]]])->shape()), "\n";
+
+$m = [[[2, -1, 0], [-1, 2, -1], [0, -1, 2]], [[4, 12, -16], [12, 37, -43], [-16, -43, 98]]];
+flat(\NumPower::det($m));
+flat(\NumPower::cholesky($m));
+flat(\NumPower::matmul(\NumPower::inv([[2, -1, 0, 0, 0], [-1, 2, -1, 0, 0], [0, -1, 2, -1, 0], [0, 0, -1, 2, -1], [0, 0, 0, -1, 2]]), [[1], [1], [1], [1], [1]]));
+flat(\NumPower::det([[1, 2], [3, 4]]));
+try {
+    \NumPower::inv([[[1, 2], [2, 4]]]);
+} catch (\Error $e) {
+    echo $e->getMessage(), "\n";
+}
+$q = [[[4, 7, 2, 3], [0, 5, 0, 1], [1, 0, 3, 0], [2, 1, 0, 6]], [[2, 0, 0, 0], [0, 4, 0, 0], [0, 0, 5, 0], [0, 0, 0, 8]]];
+flat(\NumPower::det($q));
+flat(\NumPower::inv($q));
+flat(\NumPower::inv(\NumPower::array($q, 'float64')));
+$near = [[0.1, 0.2, 0.3], [0.4, 0.5, 0.6], [0.7, 0.8, 0.9]];
+foreach (['float32', 'float64'] as $dtype) {
+    try {
+        \NumPower::inv(\NumPower::array([$near], $dtype));
+    } catch (\Error $e) {
+        echo $e->getMessage(), "\n";
+    }
+}
+?>
+--EXPECT--
+-2 4 10
+-2 1 1.5 -0.5 0.5 0 0 0.5 0.6 -0.7 -0.2 0.4
+-4 4.5 2.5 3 -1.2 1.4
+3 2 1
+4 36
+1.4142 0 0 -0.7071 1.2247 0 0 -0.8165 1.1547 2 0 0 6 1 0 -8 5 3
+2.5 4 4.5 4 2.5
+-2
+Singular matrix, unable to compute the matrix inverse.
+242 320
+0.3595 -0.4835 -0.2397 -0.0992 0.0248 0.1736 -0.0165 -0.0413 -0.1198 0.1612 0.4132 0.0331 -0.124 0.1322 0.0826 0.2066 0.5 0 0 0 0 0.25 0 0 0 0 0.2 0 0 0 0 0.125
+0.3595 -0.4835 -0.2397 -0.0992 0.0248 0.1736 -0.0165 -0.0413 -0.1198 0.1612 0.4132 0.0331 -0.124 0.1322 0.0826 0.2066 0.5 0 0 0 0 0.25 0 0 0 0 0.2 0 0 0 0 0.125
+Singular matrix, unable to compute the matrix inverse.
+Singular matrix, unable to compute the matrix inverse.
@@ -0,0 +1,58 @@
+--TEST--
+NumPower::cg and NumPower::gmres
+--FILE--
+<?php
+require __DIR__ . '/../helpers.inc';
+$a = [[4, 1, 0], [1, 3, 1], [0, 1, 2]];
+$b = [1, 2, 3];
+
+$r = \NumPower::cg(\NumPower::array($a, 'float64'), $b, 1e-10);
+flat($r['x']->toArray());
+var_dump($r['converged'], $r['residual'] < 1e-10);
+
+$r = \NumPower::gmres([[3, 1, 0], [-1, 2, 1], [2, 0, 4]], $b, 1e-10);
+flat($r['x']->toArray());
+var_dump($r['converged']);
+
+$laplacian = function ($x) {
+    $x = $x->toArray();
+    $n = count($x);
+    $y = [];
+    for ($i = 0; $i < $n; $i++) {
+        $y[] = 2 * $x[$i] - ($i > 0 ? $x[$i - 1] : 0) - ($i < $n - 1 ? $x[$i + 1] : 0);
+    }
+    return $y;
+};
+$r = \NumPower::cg($laplacian, [1, 0, 0, 1], 1e-10);
+flat($r['x']->toArray());
+$r = \NumPower::gmres($laplacian, [1, 0, 0, 1], 1e-10, diagonal: [2, 2, 2, 2]);
+flat($r['x']->toArray());
+
+$r = \NumPower::cg($a, $b, 1e-10, 1, jacobi: false);
+var_dump($r['iterations'], $r['converged']);
+$r = \NumPower::gmres([[0, 1], [1, 0]], [1, 2], 1e-10);
+flat($r['x']->toArray());
+try {
+    \NumPower::gmres([[0, 1], [1, 0]], [1, 2], jacobi: true);
+} catch (\Error $e) {
+    echo $e->getMessage(), "\n";
+}
+try {
+    \NumPower::cg($a, [1, 2]);
+} catch (\Error $e) {
+    echo $e->getMessage(), "\n";
+}
+?>
+--EXPECT--
+0.2222 0.1111 1.4444
+bool(true)
+bool(true)
+0.1 0.7 0.7
+bool(true)
+1 1 1 1
+1 1 1 1
+int(1)
+bool(false)
+2 1
+Jacobi preconditioning needs a diagonal without zeros.
+b must be a vector of 3 elements.
@@ -0,0 +1,53 @@
+--TEST--
+SparseNDArray construction, conversion, slicing and products
+--FILE--
+<?php
+require __DIR__ . '/../helpers.inc';
+$s = SparseNDArray::fromTriplets([2, 0, 1, 2, 0, 1, 3], [1, 0, 3, 1, 2, 3, 0], [5, 1, 2, 3, 4, -1, 7], [4, 4]);
+echo $s->format(), ' ', $s->nnz(), ' ', implode('x', $s->shape()), "\n";
+flat($s->toDense()->toArray());
+flat($s->transpose()->toDense()->toArray());
+$rows = $s->rows(1, 3);
+echo implode('x', $rows->shape()), "\n";
+flat($rows->toDense()->toArray());
+
+$c = $s->toCOO();
+echo $c->format(), ' ', $c->toCSR()->format(), "\n";
+flat(\NumPower::matmul($c, [1, 2, 3, 4])->toArray());
+flat(\NumPower::matmul([1, 2, 3, 4], $s)->toArray());
+flat(\NumPower::dot($s, [[1, 0], [0, 1], [1, 1], [2, 0]])->toArray());
+flat($s->matmul([1, 1, 1, 1])->toArray());
+
+$d = SparseNDArray::fromDense([[0, 0, 3], [4, 0, 0]], 'coo');
+echo $d->format(), ' ', $d->nnz(), "\n";
+flat($d->toDense()->toArray());
+
+$r = \NumPower::cg(SparseNDArray::fromDense([[4, 1, 0], [1, 3, 1], [0, 1, 2]]), [1, 2, 3], 1e-10);
+flat($r['x']->toArray());
+try {
+    SparseNDArray::fromTriplets([0, 5], [0, 0], [1, 1], [4, 4]);
+} catch (\Error $e) {
+    echo $e->getMessage(), "\n";
+}
+try {
+    \NumPower::matmul($s, [1, 2, 3]);
+} catch (\Error $e) {
+    echo $e->getMessage(), "\n";
+}
+?>
+--EXPECT--
+csr 5 4x4
+1 0 4 0 0 0 0 1 0 8 0 0 7 0 0 0
+1 0 0 7 0 0 8 0 4 0 0 0 0 1 0 0
+2x4
+0 0 0 1 0 8 0 0
+coo csr
+13 4 16 7
+29 24 4 2
+5 4 2 0 0 8 7 0
+5 1 8 7
+coo 2
+0 0 3 4 0 0
+0.2222 0.1111 1.4444
+Row index 5 is out of bounds for size 4.
+Shape mismatch for matmul. cols(a) != rows(b)
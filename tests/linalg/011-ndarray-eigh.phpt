@@ -0,0 +1,60 @@
+--TEST--
+NumPower::eigh, NumPower::eigvalsh and NumPower::lanczos
+--FILE--
+<?php
+require __DIR__ . '/../helpers.inc';
+$a = [[2, 1, 0], [1, 2, 0], [0, 0, 5]];
+
+[$w, $v] = \NumPower::eigh($a);
+flat($w->toArray());
+flat(\NumPower::abs($v));
+flat(\NumPower::eigvalsh($a, [1, 2])->toArray());
+[$w, $v] = \NumPower::eigh($a, [2, 2]);
+flat($w->toArray());
+flat(\NumPower::abs($v));
+[$w, $v] = \NumPower::eig($a, symmetric: true);
+flat($w->toArray());
+
+$laplacian = function ($x) {
+    $x = $x->toArray();
+    $n = count($x);
+    $y = [];
+    for ($i = 0; $i < $n; $i++) {
+        $y[] = 2 * $x[$i] - ($i > 0 ? $x[$i - 1] : 0) - ($i < $n - 1 ? $x[$i + 1] : 0);
+    }
+    return $y;
+};
+$r = \NumPower::lanczos($laplacian, 2, n: 4);
+flat($r['values']->toArray());
+var_dump($r['converged'], $r['vectors']->shape());
+$r = \NumPower::lanczos(\SparseNDArray::fromDense($a), 1, 'smallest');
+flat($r['values']->toArray());
+try {
+    \NumPower::eigh($a, [1, 3]);
+} catch (\Error $e) {
+    echo $e->getMessage(), "\n";
+}
+try {
+    \NumPower::lanczos($a, 4);
+} catch (\Error $e) {
+    echo $e->getMessage(), "\n";
+}
+?>
+--EXPECT--
+1 3 5
+0.7071 0.7071 0 0.7071 0.7071 0 0 0 1
+3 5
+5
+0 0 1
+1 3 5
+2.618 3.618
+bool(true)
+array(2) {
+  [0]=>
+  int(4)
+  [1]=>
+  int(2)
+}
+1
+Eigenvalue subset [1, 3] is out of bounds for a 3x3 matrix.
+k must be between 1 and 3.
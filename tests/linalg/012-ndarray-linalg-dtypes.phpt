@@ -0,0 +1,43 @@
+--TEST--
+NumPower linalg kernels with float64 and integer inputs
+--FILE--
+<?php
+function show($a) {
+    $v = is_object($a) ? $a->toArray() : $a;
+    $values = [];
+    array_walk_recursive($v, function ($x) use (&$values) { $values[] = round($x, 4) + 0; });
+    echo (is_object($a) ? $a->dtype() . ': ' : ''), implode(' ', $values), "\n";
+}
+$a = \NumPower::array([[1, -2, 3], [-4, 5, -6]], 'float64');
+[$u, $s, $vh] = \NumPower::svd($a);
+show($s);
+echo implode(' ', $u->shape()), ' | ', implode(' ', $vh->shape()), "\n";
+
+show(\NumPower::dot(\NumPower::array([[1, 2], [3, 4]], 'int64'), \NumPower::array([1, 1], 'int64')));
+show(\NumPower::dot(\NumPower::array([[1, 2], [3, 4]], 'float64'), [1, 1]));
+show(\NumPower::outer(\NumPower::array([1, 2], 'float64'), \NumPower::array([3, 4, 5], 'float64')));
+show(\NumPower::trace(\NumPower::array([[1, 2], [3, 4]], 'int64')));
+show(\NumPower::trace(\NumPower::array([[1.5, 2], [3, 4]], 'float64')));
+
+[$values, $vectors] = \NumPower::eig(\NumPower::array([[4, 1, 2], [0, 3, 1], [1, 0, 2]], 'float64'));
+show($values);
+
+$x = \NumPower::array([[1, 1], [1, 2], [1, 3]], 'float64');
+show(\NumPower::lstsq($x, \NumPower::array([[1], [2], [2]], 'float64')));
+[$q, $r] = \NumPower::qr($x);
+show($r);
+[$q, $r] = \NumPower::qr(\NumPower::array([[1, 1], [1, 2], [1, 3]], 'int64'));
+show($r);
+?>
+--EXPECT--
+float64: 9.508 0.7729
+2 2 | 3 3
+float32: 3 7
+float64: 3 7
+float64: 3 4 5 6 8 10
+5
+5.5
+float64: 4.8794 1.4679 2.6527
+float64: 0.6667 0.5
+float64: -1.7321 -3.4641 0 -1.4142
+float32: -1.7321 -3.4641 0 -1.4142
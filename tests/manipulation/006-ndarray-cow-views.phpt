@@ -0,0 +1,69 @@
+--TEST--
+Copy-on-write views from reshape, flatten and slice
+--FILE--
+<?php
+$a = \NumPower::array([[1, 2], [3, 4]]);
+$b = $a->reshape($a, [4]);
+$a[0] = [9, 9];
+print_r($b->toArray());
+$b[3] = 7;
+print_r($a->toArray());
+$c = \NumPower::flatten($a);
+$c->fill(0);
+print_r($a->toArray());
+$d = $a->slice([0, 1], [0, 2]);
+$a += 1;
+print_r($d->toArray());
+$e = $a->reshape($a, [2, 2]);
+$row = $e[1];
+$row[0] = 8;
+echo implode(' ', $row->toArray()), ' ', implode(' ', $e[1]->toArray()), "\n";
+?>
+--EXPECT--
+Array
+(
+    [0] => 1
+    [1] => 2
+    [2] => 3
+    [3] => 4
+)
+Array
+(
+    [0] => Array
+        (
+            [0] => 9
+            [1] => 9
+        )
+
+    [1] => Array
+        (
+            [0] => 3
+            [1] => 4
+        )
+
+)
+Array
+(
+    [0] => Array
+        (
+            [0] => 9
+            [1] => 9
+        )
+
+    [1] => Array
+        (
+            [0] => 3
+            [1] => 4
+        )
+
+)
+Array
+(
+    [0] => Array
+        (
+            [0] => 9
+            [1] => 9
+        )
+
+)
+8 5 4 5
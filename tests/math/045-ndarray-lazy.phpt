@@ -0,0 +1,63 @@
+--TEST--
+NumPower::lazy
+--FILE--
+<?php
+$x = \NumPower::array([[1, 2], [3, 4]]);
+$mean = [1, 2];
+$gamma = \NumPower::array([2, 4]);
+$y = (\NumPower::lazy($x) - $mean) / 2 * $gamma + 1;
+echo get_class($y), "\n";
+$r = $y->eval();
+echo $r->dtype(), "\n";
+print_r($r->toArray());
+var_dump(\NumPower::allClose($r, ($x - $mean) / 2 * $gamma + 1));
+$y += $x;
+print_r(($y * 0.5)->eval()->toArray());
+print_r((\NumPower::lazy(\NumPower::array([1, 2, 3], 'int32')) ** 2)->eval()->toArray());
+try {
+    (\NumPower::lazy($x) + [1, 2, 3])->eval();
+} catch (\Error $e) {
+    echo $e->getMessage(), "\n";
+}
+?>
+--EXPECT--
+NDArrayExpression
+float32
+Array
+(
+    [0] => Array
+        (
+            [0] => 1
+            [1] => 1
+        )
+
+    [1] => Array
+        (
+            [0] => 3
+            [1] => 5
+        )
+
+)
+bool(true)
+Array
+(
+    [0] => Array
+        (
+            [0] => 1
+            [1] => 1.5
+        )
+
+    [1] => Array
+        (
+            [0] => 3
+            [1] => 4.5
+        )
+
+)
+Array
+(
+    [0] => 1
+    [1] => 4
+    [2] => 9
+)
+Broadcast shape mismatch.
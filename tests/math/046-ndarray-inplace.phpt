@@ -0,0 +1,53 @@
+--TEST--
+NumPower out arguments and in-place arithmetic
+--FILE--
+<?php
+require __DIR__ . '/../helpers.inc';
+$w = \NumPower::array([[1, 2], [3, 4]]);
+$g = \NumPower::array([[10, 20], [30, 40]]);
+$r = \NumPower::add($w, $g, out: $w);
+var_dump($r === $w);
+flat($w);
+$w->subInPlace($g);
+flat($w);
+$w->mulInPlace(2)->divInPlace([1, 2]);
+flat($w);
+$alias = $w;
+$w -= 1;
+flat($alias);
+flat($w);
+$w *= $g;
+flat($w);
+$o = \NumPower::zeros([2, 2]);
+\NumPower::sqrt([[4, 9], [16, 25]], out: $o);
+flat($o);
+try {
+    \NumPower::add($w, [1, 2], out: \NumPower::zeros([3]));
+} catch (\Error $e) {
+    echo $e->getMessage(), "\n";
+}
+$v = \NumPower::array([1, 4, 9, 16]);
+$o = \NumPower::zeros([2]);
+\NumPower::sqrt($v->slice([0, 4, 2]), out: $o);
+echo implode(' ', $o->toArray()), "\n";
+$v->persist('inplace');
+$p = \NDArray::persisted('inplace');
+\NumPower::sqrt($v, out: $p);
+echo implode(' ', $p->toArray()), "\n";
+$p->addInPlace(1);
+echo implode(' ', $p->toArray()), ' ', implode(' ', \NDArray::persisted('inplace')->toArray()), "\n";
+\NDArray::unpersist('inplace');
+?>
+--EXPECT--
+bool(true)
+11 22 33 44
+1 2 3 4
+2 2 6 4
+2 2 6 4
+1 1 5 3
+10 20 150 120
+2 3 4 5
+Output array shape doesn't match the broadcast shape.
+1 3
+1 2 3 4
+2 3 4 5 1 4 9 16
@@ -0,0 +1,38 @@
+--TEST--
+NumPower::sort, argsort, partition and topk
+--FILE--
+<?php
+require __DIR__ . '/../helpers.inc';
+$a = \NumPower::array([[3, -1, 2, 8], [0, -0.5, 7, 1], [5, 5, -3, 2]]);
+flat(\NumPower::sort($a));
+flat(\NumPower::sort($a, 0));
+flat(\NumPower::sort($a, null));
+flat(\NumPower::argsort($a, 1));
+flat(\NumPower::argsort([3, 1, 2, 1]));
+$p = \NumPower::partition([7, 2, 9, 1, 5], 2)->toArray();
+echo $p[2], ' ', max(array_slice($p, 0, 2)) <= 5 ? 'ok' : 'fail', ' ', min(array_slice($p, 3)) >= 5 ? 'ok' : 'fail', "\n";
+[$values, $indices] = \NumPower::topk($a, 2);
+flat($values);
+flat($indices);
+try {
+    \NumPower::sort($a, 2);
+} catch (\Error $e) {
+    echo $e->getMessage(), "\n";
+}
+try {
+    \NumPower::topk($a, 5);
+} catch (\Error $e) {
+    echo $e->getMessage(), "\n";
+}
+?>
+--EXPECT--
+-1 2 3 8 -0.5 0 1 7 -3 2 5 5
+0 -1 -3 1 3 -0.5 2 2 5 5 7 8
+-3 -1 -0.5 0 1 2 2 3 5 5 7 8
+1 2 0 3 1 0 3 2 2 3 0 1
+1 3 2 0
+5 ok ok
+8 3 7 1 5 5
+3 0 2 3 0 1
+Axis is out of bounds for array dimension
+k must be between 0 and 4.
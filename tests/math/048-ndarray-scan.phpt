@@ -0,0 +1,30 @@
+--TEST--
+NumPower::cumsum, cumprod, cummax and diff
+--FILE--
+<?php
+require __DIR__ . '/../helpers.inc';
+$a = \NumPower::array([[1, 2, 3, 4], [5, 6, 7, 8], [9, 10, 11, 12]]);
+flat(\NumPower::cumsum($a));
+flat(\NumPower::cumsum($a, 1));
+flat(\NumPower::cumsum($a, 0));
+flat(\NumPower::cumprod($a, 0));
+flat(\NumPower::cummax([[3, 1, 5], [2, 8, 0]], 1));
+flat(\NumPower::diff($a));
+flat(\NumPower::diff($a, 1, 0));
+flat(\NumPower::diff([1, 4, 9, 16], 2));
+try {
+    \NumPower::cumsum($a, 2);
+} catch (\Error $e) {
+    echo $e->getMessage(), "\n";
+}
+?>
+--EXPECT--
+1 3 6 10 15 21 28 36 45 55 66 78
+1 3 6 10 5 11 18 26 9 19 30 42
+1 2 3 4 6 8 10 12 15 18 21 24
+1 2 3 4 5 12 21 32 45 120 231 384
+3 3 5 2 8 8
+1 1 1 1 1 1 1 1 1
+4 4 4 4 4 4 4 4
+2 2
+Axis is out of bounds for array dimension
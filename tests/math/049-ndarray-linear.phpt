@@ -0,0 +1,49 @@
+--TEST--
+NumPower::linear and NumPower::linearBackward
+--FILE--
+<?php
+require __DIR__ . '/../helpers.inc';
+$x = [[1, 2], [3, -4]];
+$w = [[1, 0, 1], [0, 1, -1]];
+$b = [0.5, -1, 0];
+
+flat(\NumPower::linear($x, $w, $b));
+$y = \NumPower::linear($x, $w, $b, 'relu');
+flat($y);
+flat(\NumPower::linear([0, 0], $w, activation: 'sigmoid'));
+flat(\NumPower::linear([1, 0], $w, activation: 'tanh'));
+
+[$dx, $dw, $db] = \NumPower::linearBackward([[1, 1, 1], [1, 1, 1]], $x, $w, $b, $y, 'relu');
+flat($dx);
+flat($dw);
+flat($db);
+[$dx, $dw, $db] = \NumPower::linearBackward([1, 1, 1], [0, 0], $w, activation: 'gelu');
+flat($db);
+try {
+    \NumPower::linear($x, $w, activation: 'swish');
+} catch (\Error $e) {
+    echo $e->getMessage(), "\n";
+}
+try {
+    \NumPower::linearBackward([[1, 1, 1], [1, 1, 1]], $x, $w, activation: 'relu');
+} catch (\Error $e) {
+    echo $e->getMessage(), "\n";
+}
+try {
+    \NumPower::linear($x, [[1, 2]]);
+} catch (\Error $e) {
+    echo $e->getMessage(), "\n";
+}
+?>
+--EXPECT--
+1.5 1 -1 3.5 -5 7
+1.5 1 0 3.5 0 7
+0.5 0.5 0.5
+0.7616 0 0.7616
+1 1 2 -1
+4 1 3 -2 2 -4
+2 1 1
+0.5 0.5 0.5
+Unknown activation 'swish', expected 'relu', 'tanh', 'sigmoid' or 'gelu'.
+The forward output is required for the backward of this activation.
+Shape mismatch for linear. cols(x) != rows(w)
@@ -0,0 +1,60 @@
+--TEST--
+NumPower::softmax, layerNorm, batchNorm and crossEntropyWithLogits
+--FILE--
+<?php
+require __DIR__ . '/../helpers.inc';
+flat(\NumPower::softmax([[1, 2, 3], [1000, 1000, 1000]]));
+flat(\NumPower::logSoftmax([0, 0]));
+
+flat(\NumPower::layerNorm([[1, 2, 3]]));
+flat(\NumPower::layerNorm([[1, 2, 3]], [2, 2, 2], [1, 1, 1]));
+flat(\NumPower::layerNorm([[1, 2, 3]], beta: [1, 1, 1]));
+[$dx, $dgamma, $dbeta] = \NumPower::layerNormBackward([[1, 1, 1]], [[1, 2, 3]]);
+flat($dx);
+flat($dgamma);
+flat($dbeta);
+
+[$y, $mean, $var] = \NumPower::batchNorm([[1, 2], [3, 6]]);
+flat($y);
+flat($mean);
+flat($var);
+[$y] = \NumPower::batchNorm([[3, 6]], mean: [2, 4], var: [1, 4]);
+flat($y);
+[$dx, $dgamma, $dbeta] = \NumPower::batchNormBackward([[1, 1], [1, 1]], [[1, 2], [3, 6]]);
+flat($dx);
+flat($dbeta);
+
+flat(\NumPower::crossEntropyWithLogits([[0, 0], [0, 0]], [0, 1]));
+flat(\NumPower::crossEntropyWithLogits([[0, 0]], [[0.5, 0.5]]));
+flat(\NumPower::crossEntropyWithLogitsBackward([[0, 0], [0, 0]], [0, 1]));
+try {
+    \NumPower::crossEntropyWithLogits([[0, 0]], [2]);
+} catch (\Error $e) {
+    echo $e->getMessage(), "\n";
+}
+try {
+    \NumPower::layerNorm([[1, 2, 3]], [1, 1]);
+} catch (\Error $e) {
+    echo $e->getMessage(), "\n";
+}
+?>
+--EXPECT--
+0.09 0.2447 0.6652 0.3333 0.3333 0.3333
+-0.6931 -0.6931
+-1.2247 0 1.2247
+-1.4495 1 3.4495
+-0.2247 1 2.2247
+0 0 0
+-1.2247 0 1.2247
+1 1 1
+-1 -1 1 1
+2 4
+1 4
+1 1
+0 0 0 0
+2 2
+0.6931 0.6931
+0.6931
+-0.5 0.5 0.5 -0.5
+The label of row 0 is not a class index below 2.
+Normalization parameters must have 3 elements.
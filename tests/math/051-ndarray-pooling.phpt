@@ -0,0 +1,51 @@
+--TEST--
+NumPower::maxPool1d, maxPool2d, avgPool1d, avgPool2d and their backward passes
+--FILE--
+<?php
+require __DIR__ . '/../helpers.inc';
+$x = [[[[1, 2, 3, 4], [5, 6, 7, 8], [9, 10, 11, 12], [13, 14, 15, 16]]]];
+[$y, $argmax] = \NumPower::maxPool2d($x, 2);
+flat($y);
+flat($argmax);
+flat(\NumPower::maxPoolBackward([[[[1, 1], [1, 1]]]], $argmax, [1, 1, 4, 4]));
+flat(\NumPower::avgPool2d($x, 2));
+flat(\NumPower::avgPool2dBackward([[[[1, 1], [1, 1]]]], [1, 1, 4, 4], 2));
+
+[$y, $argmax] = \NumPower::maxPool2d([[[[1, 8], [2, 7]], [[3, 6], [4, 5]]]], [2, 2], layout: 'NHWC');
+flat($y);
+flat($argmax);
+
+[$y, $argmax] = \NumPower::maxPool1d([[[1, 3, 2, 5]]], 2, 1, 1);
+flat($y);
+flat($argmax);
+flat(\NumPower::avgPool1d([[[1, 3, 2, 5]]], 2, 1, 1));
+try {
+    \NumPower::maxPool2d($x, 2, layout: 'NCW');
+} catch (\Error $e) {
+    echo $e->getMessage(), "\n";
+}
+try {
+    \NumPower::maxPoolBackward([[[[1, 1], [1, 1]]]], [[[[5, 7], [13, 15]]]], [1, 1, 4, 4]);
+} catch (\Error $e) {
+    echo $e->getMessage(), "\n";
+}
+try {
+    \NumPower::avgPool2d($x, 5);
+} catch (\Error $e) {
+    echo $e->getMessage(), "\n";
+}
+?>
+--EXPECT--
+6 8 14 16
+5 7 13 15
+0 0 0 0 0 1 0 1 0 0 0 0 0 1 0 1
+3.5 5.5 11.5 13.5
+0.25 0.25 0.25 0.25 0.25 0.25 0.25 0.25 0.25 0.25 0.25 0.25 0.25 0.25 0.25 0.25
+4 8
+6 1
+1 3 3 5 5
+0 1 1 3 3
+1 2 2.5 3.5 5
+Unknown layout 'NCW', expected 'NCHW' or 'NHWC'.
+argmax must be an integer NDArray, like the int64 one returned by the forward pass.
+Pooling window does not fit the input.